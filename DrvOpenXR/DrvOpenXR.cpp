@@ -185,6 +185,32 @@ IBackend* DrvOpenXR::CreateOpenXRBackend()
 	if (availableExtensions.contains(XR_EXT_HP_MIXED_REALITY_CONTROLLER_EXTENSION_NAME))
 		extensions.push_back(XR_EXT_HP_MIXED_REALITY_CONTROLLER_EXTENSION_NAME);
 
+	// Used for curved overlays, which are drawn as flat quads otherwise
+	if (availableExtensions.contains(XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME))
+		extensions.push_back(XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME);
+
+	// Used for cubemap skyboxes, which otherwise can't be shown
+	if (availableExtensions.contains(XR_KHR_COMPOSITION_LAYER_CUBE_EXTENSION_NAME))
+		extensions.push_back(XR_KHR_COMPOSITION_LAYER_CUBE_EXTENSION_NAME);
+
+	// Used to pass the app's depth buffers on, so the runtime can do positional reprojection
+	if (availableExtensions.contains(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME))
+		extensions.push_back(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+
+	// Only enabled on request, since it changes how the frames are paced
+	if (oovr_global_configuration->SpaceWarp() && availableExtensions.contains(XR_FB_SPACE_WARP_EXTENSION_NAME))
+		extensions.push_back(XR_FB_SPACE_WARP_EXTENSION_NAME);
+
+	// Used for body trackers, which are exposed as generic tracker devices
+	if (availableExtensions.contains(XR_HTCX_VIVE_TRACKER_INTERACTION_EXTENSION_NAME))
+		extensions.push_back(XR_HTCX_VIVE_TRACKER_INTERACTION_EXTENSION_NAME);
+
+#ifdef XR_KHR_locate_spaces
+	// Lets us locate all the devices in a single call each frame
+	if (availableExtensions.contains(XR_KHR_LOCATE_SPACES_EXTENSION_NAME))
+		extensions.push_back(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+#endif
+
 	const char* const layers[] = {
 #ifdef XR_VALIDATION_LAYER_PATH
 		"XR_APILAYER_LUNARG_core_validation",
@@ -246,7 +272,7 @@ IBackend* DrvOpenXR::CreateOpenXRBackend()
 	// Create a session - this tells the runtime that sooner or later we'd like to submit frames
 	// This is when we have to choose what graphics API to use
 
-	bool useVulkanTmpGfx = (apiFlags & XR_SUPPORTED_GRAPHICS_API_VK) && oovr_global_configuration.InitUsingVulkan();
+	bool useVulkanTmpGfx = (apiFlags & XR_SUPPORTED_GRAPHICS_API_VK) && oovr_global_configuration->InitUsingVulkan();
 	bool useD3D11TmpGfx = (apiFlags & XR_SUPPORTED_GRAPHICS_API_D3D11);
 
 #if !defined(SUPPORT_VK) && !defined(SUPPORT_DX) && !defined(SUPPORT_DX11)
@@ -271,8 +297,10 @@ void DrvOpenXR::SetupSession()
 		ShutdownSession();
 	}
 
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
 	XrGraphicsRequirementsD3D11KHR graphicsRequirements{ XR_TYPE_GRAPHICS_REQUIREMENTS_D3D11_KHR };
 	OOVR_FAILED_XR_ABORT(xr_ext->xrGetD3D11GraphicsRequirementsKHR(xr_instance, xr_system, &graphicsRequirements));
+#endif
 
 	XrSessionCreateInfo sessionInfo{};
 	sessionInfo.type = XR_TYPE_SESSION_CREATE_INFO;
@@ -25,6 +25,8 @@
 #include "../OpenOVR/Reimpl/BaseInput.h"
 #include "../OpenOVR/Reimpl/BaseOverlay.h"
 #include "../OpenOVR/Reimpl/BaseSystem.h"
+#include "../OpenOVR/Misc/Config.h"
+#include "../OpenOVR/Misc/xrmoreutils.h"
 #include "../OpenOVR/convert.h"
 #include "generated/static_bases.gen.h"
 
@@ -41,6 +43,7 @@
 #endif
 
 #include <chrono>
+#include <limits>
 #include <ranges>
 #include <type_traits>
 
@@ -76,6 +79,7 @@ XrBackend::XrBackend(bool useVulkanTmpGfx, bool useD3D11TmpGfx)
 	OOVR_FALSE_ABORT(temporaryGraphics);
 
 	// setup the device indexes
+	devices[vr::k_unTrackedDeviceIndex_Hmd] = hmd.get();
 	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
 		ITrackedDevice* dev = GetDevice(i);
 
@@ -112,15 +116,34 @@ IHMD* XrBackend::GetPrimaryHMD()
 ITrackedDevice* XrBackend::GetDevice(
     vr::TrackedDeviceIndex_t index)
 {
-	switch (index) {
-	case vr::k_unTrackedDeviceIndex_Hmd:
-		return GetPrimaryHMD();
-	case 1:
-		return hand_left.get();
-	case 2:
-		return hand_right.get();
-	default:
+	if (index >= vr::k_unMaxTrackedDeviceCount)
 		return nullptr;
+
+	return devices[index];
+}
+
+uint32_t XrBackend::GetDeviceGeneration()
+{
+	return deviceGeneration;
+}
+
+void XrBackend::SetDevice(vr::TrackedDeviceIndex_t index, ITrackedDevice* device)
+{
+	bool wasConnected = devices[index] != nullptr;
+	devices[index] = device;
+	deviceGeneration++;
+
+	if (device)
+		device->InitialiseDevice(index);
+
+	// Replacing a device (such as a controller switching interaction profile) counts as activating it again
+	BaseSystem* system = GetUnsafeBaseSystem();
+	if (system && (device || wasConnected)) {
+		VREvent_t event = {
+			.eventType = device ? VREvent_TrackedDeviceActivated : VREvent_TrackedDeviceDeactivated,
+			.trackedDeviceIndex = index
+		};
+		system->_EnqueueEvent(event);
 	}
 }
 
@@ -144,6 +167,8 @@ void XrBackend::GetDeviceToAbsoluteTrackingPose(
     vr::TrackedDevicePose_t* poseArray,
     uint32_t poseArrayCount)
 {
+	PrepareDevicePoses(toOrigin);
+
 	for (uint32_t i = 0; i < poseArrayCount; ++i) {
 		ITrackedDevice* dev = GetDevice(i);
 		if (dev) {
@@ -154,6 +179,38 @@ void XrBackend::GetDeviceToAbsoluteTrackingPose(
 	}
 }
 
+void XrBackend::PrepareDevicePoses(vr::ETrackingUniverseOrigin origin)
+{
+	if (!xr_gbl)
+		return;
+
+	// These are the spaces the devices' GetPose functions locate. The aim spaces are included so the
+	// 'tip' render model component can be found from the batch too.
+	XrSpace spaces[5 + XrTracker::ROLE_COUNT];
+	uint32_t count = 0;
+	spaces[count++] = xr_gbl->viewSpace;
+
+	BaseInput* input = GetUnsafeBaseInput();
+	if (input && input->AreActionsLoaded()) {
+		for (ITrackedDevice::HandType hand : { ITrackedDevice::HAND_LEFT, ITrackedDevice::HAND_RIGHT }) {
+			for (bool aim : { false, true }) {
+				XrSpace space = XR_NULL_HANDLE;
+				input->GetHandSpace(hand, space, aim);
+				if (space)
+					spaces[count++] = space;
+			}
+		}
+
+		for (int role = 0; role < XrTracker::ROLE_COUNT; role++) {
+			XrSpace space = trackers[role] ? input->GetTrackerSpace(role) : XR_NULL_HANDLE;
+			if (space)
+				spaces[count++] = space;
+		}
+	}
+
+	xr_utils::LocateSpaces(xr_space_from_tracking_origin(origin), spaces, count);
+}
+
 static void find_queue_family_and_queue_idx(VkDevice dev, VkPhysicalDevice pdev, VkQueue desired_queue, uint32_t& out_queueFamilyIndex, uint32_t& out_queueIndex)
 {
 	uint32_t queue_family_count;
@@ -368,11 +425,20 @@ void XrBackend::CheckOrInitCompositors(const vr::Texture_t* tex)
 			continue;
 
 		compositor.reset(BaseCompositor::CreateCompositorAPI(tex));
+
+		if (mirrorRequested && compositor->SupportsMirror(tex->eType))
+			compositor->EnableMirror();
 	}
 }
 
 void XrBackend::WaitForTrackingData()
 {
+	// Don't start a frame while the skybox thread is in the middle of one
+	appFrameWaiting = true;
+	std::lock_guard<std::mutex> frameGuard(frameLock);
+	appFrameWaiting = false;
+	lastAppFrame = std::chrono::steady_clock::now();
+
 	// Make sure the OpenXR session is active before doing anything else, and if not then skip
 	if (!sessionActive) {
 		renderingFrame = false;
@@ -382,11 +448,25 @@ void XrBackend::WaitForTrackingData()
 	XrFrameWaitInfo waitInfo{ XR_TYPE_FRAME_WAIT_INFO };
 	XrFrameState state{ XR_TYPE_FRAME_STATE };
 
+	// With space warp, the runtime synthesises every other frame. Let a display period pass since the last frame
+	// started, so xrWaitFrame waits for the one after and the app runs at half rate. If the runtime is already
+	// throttling the app itself (or the app is slow anyway), that time has already passed and this does nothing.
+	if (spaceWarpActive && displayPeriod > 0)
+		std::this_thread::sleep_until(lastFrameWaitEnd + std::chrono::nanoseconds(displayPeriod));
+
 	{
 		auto lock = xr_session.lock_shared();
 		OOVR_FAILED_XR_ABORT(xrWaitFrame(xr_session.get(), &waitInfo, &state));
 		xr_gbl->nextPredictedFrameTime = state.predictedDisplayTime;
 
+		auto now = std::chrono::steady_clock::now();
+		if (lastFrameWaitEnd.time_since_epoch().count() != 0) {
+			double intervalMs = std::chrono::duration<double, std::milli>(now - lastFrameWaitEnd).count();
+			appFrameIntervalMs = appFrameIntervalMs == 0 ? intervalMs : appFrameIntervalMs * 0.95 + intervalMs * 0.05;
+		}
+		lastFrameWaitEnd = now;
+		displayPeriod = state.predictedDisplayPeriod;
+
 		// FIXME loop until this returns true?
 		// OOVR_FALSE_ABORT(state.shouldRender);
 
@@ -447,9 +527,31 @@ void XrBackend::StoreEyeTexture(
 	Compositor& comp = *compPtr;
 
 	// If the session is inactive, we may be unable to write to the surface
-	if (sessionActive && renderingFrame)
+	if (sessionActive && renderingFrame) {
 		comp.Invoke((XruEye)eye, texture, bounds, submitFlags, layer);
 
+		// Pass on the depth buffer if there is one, so the runtime can use it for reprojection (and space warp)
+		bool hasDepth = (submitFlags & vr::Submit_TextureWithDepth) && StoreEyeDepth(eye, texture, bounds, submitFlags);
+		layer.next = hasDepth ? &depthInfos[eye] : nullptr;
+
+		XrCompositionLayerDepthInfoKHR& depthInfo = depthInfos[eye];
+		XrCompositionLayerSpaceWarpInfoFB& spaceWarp = spaceWarpInfos[eye];
+		spaceWarp = { XR_TYPE_COMPOSITION_LAYER_SPACE_WARP_INFO_FB };
+		if (hasDepth && oovr_global_configuration->SpaceWarp() && xr_ext->SpaceWarp_Available() && comp.InvokeSpaceWarp(spaceWarp)) {
+			spaceWarp.motionVectorSubImage.imageRect = depthInfo.subImage.imageRect;
+			spaceWarp.depthSubImage = depthInfo.subImage;
+			spaceWarp.minDepth = depthInfo.minDepth;
+			spaceWarp.maxDepth = depthInfo.maxDepth;
+			spaceWarp.nearZ = depthInfo.nearZ;
+			spaceWarp.farZ = depthInfo.farZ;
+
+			// The layers are in a world-fixed space, so the app space doesn't move between frames
+			spaceWarp.appSpaceDeltaPose = { { 0, 0, 0, 1 }, { 0, 0, 0 } };
+
+			depthInfo.next = &spaceWarp;
+		}
+	}
+
 	submittedEyeTextures = true;
 
 	// TODO store view somewhere and use it for submitting our frame
@@ -466,6 +568,48 @@ void XrBackend::StoreEyeTexture(
 	}
 }
 
+bool XrBackend::StoreEyeDepth(vr::EVREye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds, vr::EVRSubmitFlags submitFlags)
+{
+	if (!xr_ext->CompositionLayerDepth_Available())
+		return false;
+
+	// The depth info comes after the pose, if there is one
+	const vr::VRTextureDepthInfo_t& depth = (submitFlags & vr::Submit_TextureWithPose)
+	    ? ((const vr::VRTextureWithPoseAndDepth_t*)texture)->depth
+	    : ((const vr::VRTextureWithDepth_t*)texture)->depth;
+
+	XrCompositionLayerDepthInfoKHR& info = depthInfos[eye];
+	info = { XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR };
+	if (!compositors[eye]->InvokeDepth(depth, bounds, info))
+		return false;
+
+	// Apps that don't care about the range leave it zeroed, which means they use the whole thing
+	info.minDepth = depth.vRange.v[0];
+	info.maxDepth = depth.vRange.v[1];
+	if (info.minDepth == 0 && info.maxDepth == 0)
+		info.maxDepth = 1;
+
+	// Work out the distances at the ends of the depth range from the projection matrix, which is in the same form as
+	// GetProjectionMatrix returns. A depth d comes from a distance z where d = (m22 * -z + m23) / z, so
+	// z = m23 / (m22 + d). This works for both normal and reversed depth, and gives infinity for an infinite far plane.
+	const vr::HmdMatrix44_t& proj = depth.mProjection;
+	float m22 = proj.m[2][2];
+	float m23 = proj.m[2][3];
+	auto distanceAt = [m22, m23](float d) {
+		float divisor = m22 + d;
+		return divisor == 0 ? std::numeric_limits<float>::infinity() : m23 / divisor;
+	};
+	info.nearZ = distanceAt(info.minDepth);
+	info.farZ = distanceAt(info.maxDepth);
+
+	if (!(info.nearZ > 0) || !(info.farZ > 0)) {
+		OOVR_LOG_ONCEF("Invalid depth projection matrix (near %f far %f), submitting without depth", info.nearZ, info.farZ);
+		return false;
+	}
+
+	return true;
+}
+
 void XrBackend::SubmitFrames(bool showSkybox, bool postPresent)
 {
 	// Always pump events, even if the session isn't active - this is what makes the session active
@@ -477,6 +621,8 @@ void XrBackend::SubmitFrames(bool showSkybox, bool postPresent)
 	bool skipRender = postPresentStatus && !postPresent;
 	postPresentStatus = postPresent;
 
+	std::unique_lock<std::mutex> frameGuard(frameLock);
+
 	if (!renderingFrame || skipRender)
 		return;
 
@@ -533,6 +679,25 @@ void XrBackend::SubmitFrames(bool showSkybox, bool postPresent)
 
 	OOVR_FAILED_XR_SOFT_ABORT(xrEndFrame(xr_session.get(), &info));
 
+	// Only pace the app for space warp while it's actually being used, so menus without depth run at full rate
+	bool usedSpaceWarp = app_layer && projectionViews[0].next && depthInfos[0].next;
+	if (usedSpaceWarp != spaceWarpActive)
+		OOVR_LOGF("Space warp %s", usedSpaceWarp ? "started, running the game at half rate" : "stopped");
+	spaceWarpActive = usedSpaceWarp;
+
+	if (spaceWarpActive && displayPeriod > 0) {
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastSpaceWarpLog > std::chrono::seconds(10)) {
+			lastSpaceWarpLog = now;
+			OOVR_LOGF("Space warp: game at %.1f fps, headset at %.1f fps", 1000.0 / appFrameIntervalMs, 1e9 / (double)displayPeriod);
+		}
+	}
+
+	frameGuard.unlock();
+
+	if (screenshotCallback)
+		PollScreenshot();
+
 	BaseSystem* sys = GetUnsafeBaseSystem();
 	if (sys) {
 		sys->_OnPostFrame();
@@ -546,80 +711,210 @@ void XrBackend::SubmitFrames(bool showSkybox, bool postPresent)
 
 IBackend::openvr_enum_t XrBackend::SetSkyboxOverride(const vr::Texture_t* pTextures, uint32_t unTextureCount)
 {
-	// Needed for rFactor2 loading screens
-	if (unTextureCount && pTextures) {
-		CheckOrInitCompositors(pTextures);
+	// Needed for rFactor2 loading screens. Two textures are a stereo pair, of which we only show the first.
+	if (!pTextures || (unTextureCount != 1 && unTextureCount != 2 && unTextureCount != 6)) {
+		OOVR_SOFT_ABORTF("Unsupported skybox texture count %d", unTextureCount);
+		return 0;
+	}
 
-		if (!sessionActive || !usingApplicationGraphicsAPI)
-			return 0;
+	// This may restart the session, which stops the skybox thread - so it can't be done while holding frameLock
+	CheckOrInitCompositors(pTextures);
 
-		// Make sure any unfinished frames don't call xrEndFrame after this call
-		renderingFrame = false;
+	if (!usingApplicationGraphicsAPI)
+		return 0;
 
-		XrFrameWaitInfo waitInfo{ XR_TYPE_FRAME_WAIT_INFO };
-		XrFrameState state{ XR_TYPE_FRAME_STATE };
+	std::lock_guard<std::mutex> frameGuard(frameLock);
 
-		OOVR_FAILED_XR_ABORT(xrWaitFrame(xr_session.get(), &waitInfo, &state));
-		xr_gbl->nextPredictedFrameTime = state.predictedDisplayTime;
+	if (!sessionActive)
+		return 0;
 
-		// This submits a frame when a skybox override is set. This is designed around rFactor2 where the skybox is used as
-		// a loading screen and is frequently updated, and most other games probably behave in a similar manner. It'd be
-		// ideal to run a separate thread while the skybox override is set to submit frames if IVRCompositor->Submit is not
-		// being called frequently enough, and that'd need to be carefully synchronised with the main submit thread. That's
-		// not yet implemented since it's not currently worth the hassle, but if someone in the future wants to do it:
-		// TODO submit skybox frames in their own thread.
-		XrFrameBeginInfo beginInfo{ XR_TYPE_FRAME_BEGIN_INFO };
-		OOVR_FAILED_XR_ABORT(xrBeginFrame(xr_session.get(), &beginInfo));
+	if (!skyboxCompositor)
+		skyboxCompositor.reset(BaseCompositor::CreateCompositorAPI(pTextures));
 
-		static std::unique_ptr<Compositor> compositor = nullptr;
+	bool cube = unTextureCount == 6 && skyboxCompositor->SupportsCubemap() && xr_ext->CompositionLayerCube_Available();
+	if (unTextureCount == 6 && !cube)
+		OOVR_LOG_ONCE("Cubemap skyboxes aren't supported with this runtime or graphics API, only showing the front face");
 
-		if (compositor == nullptr)
-			compositor.reset(BaseCompositor::CreateCompositorAPI(pTextures));
+	// Cubemaps use a swapchain with six faces, so don't reuse the swapchain when switching to or from one
+	if (cube != skyboxIsCube) {
+		skyboxCompositor.reset(BaseCompositor::CreateCompositorAPI(pTextures));
+		skyboxIsCube = cube;
+	}
+
+	XrSpace space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
+
+	if (cube) {
+		skyboxCompositor->InvokeCubemap(pTextures);
 
+		skyboxCube = { XR_TYPE_COMPOSITION_LAYER_CUBE_KHR };
+		skyboxCube.space = space;
+		skyboxCube.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+		skyboxCube.swapchain = skyboxCompositor->GetSwapChain();
+		skyboxCube.imageArrayIndex = 0;
+		skyboxCube.orientation = { 0.f, 0.f, 0.f, 1.f };
+		skyboxLayer = (XrCompositionLayerBaseHeader*)&skyboxCube;
+	} else {
 		vr::VRTextureBounds_t bounds;
 		bounds.uMin = 0.0;
 		bounds.uMax = 1.0;
 		bounds.vMin = 1.0;
 		bounds.vMax = 0.0;
 
-		compositor->Invoke(pTextures, &bounds);
-		XrCompositionLayerQuad layerQuad = { XR_TYPE_COMPOSITION_LAYER_QUAD };
-		layerQuad.type = XR_TYPE_COMPOSITION_LAYER_QUAD;
-		layerQuad.next = NULL;
-		layerQuad.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
-		layerQuad.space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
-		layerQuad.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
-		layerQuad.pose = { { 0.f, 0.f, 0.f, 1.f },
+		skyboxCompositor->Invoke(pTextures, &bounds);
+
+		skyboxQuad = { XR_TYPE_COMPOSITION_LAYER_QUAD };
+		skyboxQuad.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+		skyboxQuad.space = space;
+		skyboxQuad.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+		skyboxQuad.pose = { { 0.f, 0.f, 0.f, 1.f },
 			{ 0.0f, 0.0f, -0.65f } };
-		layerQuad.size = { 1.0f, 1.0f / 1.333f };
-		layerQuad.subImage = {
-			compositor->GetSwapChain(),
+		skyboxQuad.size = { 1.0f, 1.0f / 1.333f };
+		skyboxQuad.subImage = {
+			skyboxCompositor->GetSwapChain(),
 			{ { 0, 0 },
-			    { (int32_t)compositor->GetSrcSize().width,
-			        (int32_t)compositor->GetSrcSize().height } },
+			    { (int32_t)skyboxCompositor->GetSrcSize().width,
+			        (int32_t)skyboxCompositor->GetSrcSize().height } },
 			0
 		};
+		skyboxLayer = (XrCompositionLayerBaseHeader*)&skyboxQuad;
+	}
 
-		XrCompositionLayerBaseHeader* layers[1];
-		layers[0] = (XrCompositionLayerBaseHeader*)&layerQuad;
-		XrFrameEndInfo info{ XR_TYPE_FRAME_END_INFO };
-		info.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
-		info.displayTime = xr_gbl->nextPredictedFrameTime;
-		info.layers = layers;
-		info.layerCount = 1;
-
-		OOVR_FAILED_XR_SOFT_ABORT(xrEndFrame(xr_session.get(), &info));
+	// Show the new image straight away. This is designed around rFactor2, where the skybox is used as a loading
+	// screen and is frequently updated, and most other games probably behave in a similar manner. Any frame the
+	// app had started is abandoned, so it doesn't call xrEndFrame after this.
+	renderingFrame = false;
+	SubmitSkyboxFrame();
+	lastAppFrame = std::chrono::steady_clock::now();
 
-	} else {
-		OOVR_SOFT_ABORT("Unsupported texture count");
-	}
+	// Games that only set the skybox once and then stop submitting frames rely on the thread to keep showing it
+	if (oovr_global_configuration->SkyboxSubmitThread() && !skyboxThread.joinable())
+		skyboxThread = std::thread(&XrBackend::RunSkyboxThread, this);
 
 	return 0;
 }
 
 void XrBackend::ClearSkyboxOverride()
 {
-	OOVR_SOFT_ABORT("No implementation");
+	StopSkyboxThread();
+
+	std::lock_guard<std::mutex> frameGuard(frameLock);
+	skyboxLayer = nullptr;
+	skyboxCompositor.reset();
+	skyboxIsCube = false;
+}
+
+void XrBackend::SubmitSkyboxFrame()
+{
+	auto sessionLock = xr_session.lock_shared();
+
+	XrFrameWaitInfo waitInfo{ XR_TYPE_FRAME_WAIT_INFO };
+	XrFrameState state{ XR_TYPE_FRAME_STATE };
+	OOVR_FAILED_XR_ABORT(xrWaitFrame(xr_session.get(), &waitInfo, &state));
+
+	XrFrameBeginInfo beginInfo{ XR_TYPE_FRAME_BEGIN_INFO };
+	OOVR_FAILED_XR_ABORT(xrBeginFrame(xr_session.get(), &beginInfo));
+
+	XrFrameEndInfo info{ XR_TYPE_FRAME_END_INFO };
+	info.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+	info.displayTime = state.predictedDisplayTime;
+	info.layers = &skyboxLayer;
+	info.layerCount = 1;
+
+	OOVR_FAILED_XR_SOFT_ABORT(xrEndFrame(xr_session.get(), &info));
+}
+
+void XrBackend::RunSkyboxThread()
+{
+	// How long the app has to go without starting a frame before we take over. This is long enough that a game
+	// running at a low frame rate isn't interrupted, and short enough that a loading screen doesn't visibly stall.
+	const auto idleTimeout = std::chrono::milliseconds(50);
+
+	std::unique_lock<std::mutex> frameGuard(frameLock);
+	while (!skyboxThreadStop) {
+		bool appIdle = !renderingFrame && !appFrameWaiting && std::chrono::steady_clock::now() - lastAppFrame > idleTimeout;
+
+		if (!skyboxLayer || !sessionActive || !appIdle) {
+			skyboxThreadWake.wait_for(frameGuard, std::chrono::milliseconds(5));
+			continue;
+		}
+
+		// xrWaitFrame blocks until the runtime wants the next frame, which paces this loop to the display
+		SubmitSkyboxFrame();
+
+		// Give the app's thread a chance to take the lock, if it's started submitting frames again
+		frameGuard.unlock();
+		std::this_thread::yield();
+		frameGuard.lock();
+	}
+}
+
+void XrBackend::StopSkyboxThread()
+{
+	if (!skyboxThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> frameGuard(frameLock);
+		skyboxThreadStop = true;
+	}
+	skyboxThreadWake.notify_all();
+	skyboxThread.join();
+	skyboxThreadStop = false;
+}
+
+bool XrBackend::CaptureScreenshot(std::function<void(CompositorReadback* eyes)> onCaptured)
+{
+	if (screenshotCallback) {
+		OOVR_LOG("Screenshot requested while another is still being captured");
+		return false;
+	}
+
+	// The compositors are only created once the app submits its first frame
+	for (const std::unique_ptr<Compositor>& compositor : compositors) {
+		if (!compositor || !compositor->SupportsReadback()) {
+			OOVR_LOG_ONCE("Screenshots are not supported with the app's graphics API");
+			return false;
+		}
+	}
+
+	for (int eye = 0; eye < XruEyeCount; eye++) {
+		compositors[eye]->RequestReadback();
+		screenshotEyes[eye] = {};
+		screenshotEyeDone[eye] = false;
+	}
+
+	screenshotCallback = std::move(onCaptured);
+	return true;
+}
+
+void XrBackend::PollScreenshot()
+{
+	for (int eye = 0; eye < XruEyeCount; eye++) {
+		if (!screenshotEyeDone[eye])
+			screenshotEyeDone[eye] = compositors[eye]->PollReadback(screenshotEyes[eye]);
+
+		if (!screenshotEyeDone[eye])
+			return;
+	}
+
+	// Clear the callback first, in case it takes another screenshot
+	std::function<void(CompositorReadback * eyes)> callback = std::move(screenshotCallback);
+	screenshotCallback = nullptr;
+	callback(screenshotEyes);
+}
+
+void XrBackend::CancelScreenshot()
+{
+	if (!screenshotCallback)
+		return;
+
+	OOVR_LOG("Session restarting, abandoning pending screenshot");
+	for (int eye = 0; eye < XruEyeCount; eye++) {
+		if (screenshotEyeDone[eye] && screenshotEyes[eye].release)
+			screenshotEyes[eye].release();
+		screenshotEyes[eye] = {};
+	}
+	screenshotCallback = nullptr;
 }
 
 /* Misc compositor */
@@ -644,6 +939,16 @@ bool XrBackend::GetFrameTiming(OOVR_Compositor_FrameTiming* pTiming, uint32_t un
 		pTiming->m_nNumDroppedFrames = 0; // number of additional times previous frame was scanned out
 		pTiming->m_nReprojectionFlags = 0;
 
+		// With space warp, each frame is shown twice, the second time synthesised by the runtime. Report this
+		// the same way SteamVR reports motion smoothing, so apps that show it in their stats can compare the rates.
+		if (spaceWarpActive) {
+			// The throttled frame count is stored in the bits covered by the mask, so one frame is its lowest bit
+			const uint32_t oneThrottledFrame = vr::VRCompositor_ThrottleMask & (~vr::VRCompositor_ThrottleMask + 1);
+
+			pTiming->m_nNumFramePresents = 2;
+			pTiming->m_nReprojectionFlags = vr::VRCompositor_ReprojectionMotion | oneThrottledFrame;
+		}
+
 		// Just use sensible values until GPU timers implemented
 		pTiming->m_flPreSubmitGpuMs = 8.0f;
 		pTiming->m_flPostSubmitGpuMs = 1.0f;
@@ -657,7 +962,7 @@ bool XrBackend::GetFrameTiming(OOVR_Compositor_FrameTiming* pTiming, uint32_t un
 		pTiming->m_flCompositorIdleCpuMs = 0.1f;
 
 		/** Miscellaneous measured intervals. */
-		pTiming->m_flClientFrameIntervalMs = 11.1f; // time between calls to WaitGetPoses
+		pTiming->m_flClientFrameIntervalMs = appFrameIntervalMs > 0 ? (float)appFrameIntervalMs : 11.1f; // time between calls to WaitGetPoses
 		pTiming->m_flPresentCallCpuMs = 0.0f; // time blocked on call to present (usually 0.0, but can go long)
 		pTiming->m_flWaitForPresentCpuMs = 0.0f; // time spent spin-waiting for frame index to change (not near-zero indicates wait object failure)
 		pTiming->m_flSubmitFrameMs = 0.0f; // time spent in IVRCompositor::Submit (not near-zero indicates driver issue)
@@ -690,33 +995,62 @@ void XrBackend::ReleaseMirrorTextureD3D11(void* pD3D11ShaderResourceView)
 	OOVR_SOFT_ABORT("No implementation");
 }
 /* #endif */
-/** Returns the points of the Play Area. */
-bool XrBackend::GetPlayAreaPoints(vr::HmdVector3_t* points, int* count)
+IBackend::openvr_enum_t XrBackend::GetMirrorTexture(vr::ETextureType api, vr::EVREye eEye, uint64_t* pImage)
 {
-	if (count)
-		*count = 0;
+	if (eEye != vr::Eye_Left && eEye != vr::Eye_Right)
+		return vr::VRCompositorError_IndexOutOfRange;
+
+	// Remember this for when the compositors are created, or recreated along with the session
+	mirrorRequested = true;
+
+	// Nothing can be mirrored until the app has submitted a frame
+	Compositor* compositor = compositors[eEye].get();
+	if (!compositor)
+		return vr::VRCompositorError_RequestFailed;
+
+	if (!compositor->SupportsMirror(api))
+		return vr::VRCompositorError_SharedTexturesNotSupported;
+
+	// The mirror isn't kept until it's asked for, so the first request has to wait for the next frame
+	compositor->EnableMirror();
+	uint64_t image = compositor->GetMirrorImage();
+	if (!image)
+		return vr::VRCompositorError_RequestFailed;
+
+	if (pImage)
+		*pImage = image;
+
+	return vr::VRCompositorError_None;
+}
+/** Returns the shape of the Play Area. */
+const PlayAreaGeometry* XrBackend::GetPlayAreaGeometry()
+{
+	if (playAreaCached)
+		return playArea.get();
 
 	XrExtent2Df bounds;
 	XrResult res = xrGetReferenceSpaceBoundsRect(xr_session.get(), XR_REFERENCE_SPACE_TYPE_STAGE, &bounds);
 
+	// Remember that there isn't a play area too, so we don't keep asking until the runtime says it's changed
+	playAreaCached = true;
+	playArea.reset();
+
 	if (res == XR_SPACE_BOUNDS_UNAVAILABLE)
-		return false;
+		return nullptr;
 
 	OOVR_FAILED_XR_ABORT(res);
 
-	if (count)
-		*count = 4;
-
-	// The origin of the free space is centred around the player
-	// TODO if we're using the Oculus runtime, grab it's native handle and get the full polygon
-	if (points) {
-		points[0] = vr::HmdVector3_t{ -bounds.width / 2, 0, -bounds.height / 2 };
-		points[1] = vr::HmdVector3_t{ bounds.width / 2, 0, -bounds.height / 2 };
-		points[2] = vr::HmdVector3_t{ bounds.width / 2, 0, bounds.height / 2 };
-		points[3] = vr::HmdVector3_t{ -bounds.width / 2, 0, bounds.height / 2 };
-	}
+	// The origin of the free space is centred around the player. OpenXR only gives us the largest rectangle
+	// that fits inside the boundary, even if the runtime knows the full polygon.
+	std::vector<vr::HmdVector3_t> points = {
+		vr::HmdVector3_t{ -bounds.width / 2, 0, -bounds.height / 2 },
+		vr::HmdVector3_t{ bounds.width / 2, 0, -bounds.height / 2 },
+		vr::HmdVector3_t{ bounds.width / 2, 0, bounds.height / 2 },
+		vr::HmdVector3_t{ -bounds.width / 2, 0, bounds.height / 2 },
+	};
+	playArea = std::make_unique<PlayAreaGeometry>(std::move(points));
 
-	return true;
+	return playArea.get();
 }
 /** Determine whether the bounds are showing right now **/
 bool XrBackend::AreBoundsVisible()
@@ -773,6 +1107,7 @@ void XrBackend::PumpEvents()
 				XrSessionBeginInfo beginInfo{ XR_TYPE_SESSION_BEGIN_INFO };
 				beginInfo.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
 				OOVR_FAILED_XR_ABORT(xrBeginSession(xr_session.get(), &beginInfo));
+				std::lock_guard<std::mutex> frameGuard(frameLock);
 				sessionActive = true;
 				break;
 			}
@@ -780,6 +1115,7 @@ void XrBackend::PumpEvents()
 				// End the session. The session is still valid and we can still query some information
 				// from it, but we're not allowed to submit frames anymore. This is done when the engagement
 				// sensor detects the user has taken off the headset, for example.
+				std::lock_guard<std::mutex> frameGuard(frameLock);
 				OOVR_FAILED_XR_ABORT(xrEndSession(xr_session.get()));
 				sessionActive = false;
 				renderingFrame = false;
@@ -802,8 +1138,23 @@ void XrBackend::PumpEvents()
 				// suppress clion warning about missing branches
 				break;
 			}
+		} else if (ev.type == XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING) {
+			// The user may have redrawn their boundary or moved the stage origin
+			auto* changed = (XrEventDataReferenceSpaceChangePending*)&ev;
+			if (changed->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_STAGE)
+				playAreaCached = false;
+
+			// Recentring or a new IPD setting can move the eyes, so don't keep serving the old views this frame
+			hmd->InvalidateViewSnapshot();
+		} else if (ev.type == XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX) {
+			// The tracker may not have a role yet, in which case it'll show up once it's given one
+			UpdateTrackers();
 		} else if (ev.type == XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED) {
+			if (input)
+				input->OnInteractionProfileChanged();
+
 			UpdateInteractionProfile();
+			UpdateTrackers();
 			break;
 		}
 
@@ -831,6 +1182,7 @@ void XrBackend::PumpEvents()
 
 void XrBackend::OnSessionCreated()
 {
+	playAreaCached = false;
 	sessionState = XR_SESSION_STATE_UNKNOWN;
 	sessionActive = false;
 	renderingFrame = false;
@@ -857,6 +1209,12 @@ void XrBackend::OnSessionCreated()
 
 void XrBackend::PrepareForSessionShutdown()
 {
+	// The skybox's swapchain belongs to the session, so the app has to set it again on the new one
+	ClearSkyboxOverride();
+
+	// Any readback in progress is destroyed along with the compositors
+	CancelScreenshot();
+
 	for (std::unique_ptr<Compositor>& c : compositors) {
 		c.reset();
 	}
@@ -914,16 +1272,15 @@ void XrBackend::UpdateInteractionProfile()
 			for (const std::unique_ptr<InteractionProfile>& profile : InteractionProfile::GetProfileList()) {
 				if (profile->GetPath() == path_name) {
 					OOVR_LOGF("%s - Using interaction profile: %s", info.pathstr, path_name);
-					info.controller = std::make_unique<XrController>(info.hand, *profile);
+					// Publish the new controller before destroying the old one, so other threads looking up the
+					// device never see one that's been freed.
+					std::unique_ptr<XrController> controller = std::make_unique<XrController>(info.hand, *profile);
+					SetDevice((TrackedDeviceIndex_t)info.hand + 1, controller.get());
+					info.controller = std::move(controller);
 					hmd->SetInteractionProfile(profile.get());
 					BaseSystem* system = GetUnsafeBaseSystem();
 					if (system) {
 						VREvent_t event = {
-							.eventType = VREvent_TrackedDeviceActivated,
-							.trackedDeviceIndex = (TrackedDeviceIndex_t)info.hand + 1
-						};
-						system->_EnqueueEvent(event);
-						event = {
 							.eventType = VREvent_TrackedDeviceUpdated,
 							.trackedDeviceIndex = 0
 						};
@@ -940,20 +1297,55 @@ void XrBackend::UpdateInteractionProfile()
 			// interaction profile lost/not detected
 			OOVR_LOGF("%s - No interaction profile detected", info.pathstr);
 			if (info.controller) {
+				SetDevice((TrackedDeviceIndex_t)info.hand + 1, nullptr);
 				info.controller.reset();
-				BaseSystem* system = GetUnsafeBaseSystem();
-				if (system) {
-					VREvent_t event = {
-						.eventType = VREvent_TrackedDeviceDeactivated,
-						.trackedDeviceIndex = (TrackedDeviceIndex_t)info.hand + 1
-					};
-					system->_EnqueueEvent(event);
-				}
 			}
 		}
 	}
 }
 
+void XrBackend::UpdateTrackers()
+{
+	BaseInput* input = GetUnsafeBaseInput();
+	if (!xr_ext->ViveTrackers_Available() || !input || !input->AreActionsLoaded())
+		return;
+
+	for (int role = 0; role < XrTracker::ROLE_COUNT; role++) {
+		XrPath path;
+		OOVR_FAILED_XR_ABORT(xrStringToPath(xr_instance, XrTracker::GetRolePath(role).c_str(), &path));
+
+		XrInteractionProfileState state{ XR_TYPE_INTERACTION_PROFILE_STATE };
+		XrResult res = xrGetCurrentInteractionProfile(xr_session.get(), path, &state);
+		if (XR_FAILED(res)) {
+			OOVR_LOG_ONCEF("Failed to get the interaction profile for tracker roles: %d", res);
+			return;
+		}
+
+		bool connected = state.interactionProfile != XR_NULL_PATH;
+		if (connected == (trackers[role] != nullptr))
+			continue;
+
+		if (!connected) {
+			OOVR_LOGF("Tracker disconnected: %s", XrTracker::roles[role].name);
+			SetDevice(trackerIndices[role], nullptr);
+			trackers[role].reset();
+			continue;
+		}
+
+		if (trackerIndices[role] == 0) {
+			if (nextTrackerIndex >= vr::k_unMaxTrackedDeviceCount) {
+				OOVR_LOG_ONCE("Out of tracked device indices for trackers");
+				continue;
+			}
+			trackerIndices[role] = nextTrackerIndex++;
+		}
+
+		OOVR_LOGF("Tracker connected: %s, using device index %d", XrTracker::roles[role].name, trackerIndices[role]);
+		trackers[role] = std::make_unique<XrTracker>(role);
+		SetDevice(trackerIndices[role], trackers[role].get());
+	}
+}
+
 void XrBackend::MaybeRestartForInputs()
 {
 	// if we haven't attached any actions to the session (infoSet or game actions), no need to restart
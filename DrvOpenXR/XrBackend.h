@@ -8,8 +8,17 @@
 
 #include "XrController.h"
 #include "XrHMD.h"
+#include "XrTracker.h"
 
+#include "../OpenOVR/Misc/PlayAreaGeometry.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 class XrBackend : public IBackend {
 public:
@@ -57,6 +66,20 @@ private:
 	std::unique_ptr<XrHMD> hmd = std::make_unique<XrHMD>();
 	std::unique_ptr<XrController> hand_left;
 	std::unique_ptr<XrController> hand_right;
+	std::unique_ptr<XrTracker> trackers[XrTracker::ROLE_COUNT];
+
+	// Every connected device by its OpenVR index, so looking one up doesn't depend on how many kinds of device
+	// there are. The HMD and hands always use indices 0-2. Each tracker role gets the next free index the first
+	// time a tracker appears in it, and keeps it if that tracker disconnects and comes back.
+	ITrackedDevice* devices[vr::k_unMaxTrackedDeviceCount] = {};
+	vr::TrackedDeviceIndex_t trackerIndices[XrTracker::ROLE_COUNT] = {};
+	vr::TrackedDeviceIndex_t nextTrackerIndex = 3;
+
+	// See GetDeviceGeneration
+	std::atomic<uint32_t> deviceGeneration = 0;
+
+	// Put a device into the table (or remove it, if device is null) and send the matching activated/deactivated event
+	void SetDevice(vr::TrackedDeviceIndex_t index, ITrackedDevice* device);
 
 	void CheckOrInitCompositors(const vr::Texture_t* tex);
 	std::unique_ptr<Compositor> compositors[XruEyeCount];
@@ -70,6 +93,13 @@ private:
 	 */
 	void UpdateInteractionProfile();
 
+	/**
+	 * Check which tracker roles have a tracker in them, adding and removing the XrTrackers to match. This uses
+	 * the current interaction profile of each role's path, which the runtime sets when a tracker is assigned to it.
+	 * Called from PumpEvents whenever the interaction profiles change or a tracker connects.
+	 */
+	void UpdateTrackers();
+
 	/**
 	 * Attempts to force the runtime to expose an interaction profile
 	 * (i.e., send an INTERACTION_PROFILE_CHANGED event).
@@ -87,6 +117,27 @@ private:
 	// The views for the two main eye layers
 	XrCompositionLayerProjectionView projectionViews[XruEyeCount];
 
+	// The depth buffers for each eye, chained onto projectionViews when the app submits them
+	XrCompositionLayerDepthInfoKHR depthInfos[XruEyeCount];
+
+	// Copy the depth from a texture submitted with Submit_TextureWithDepth, and fill out depthInfos for it.
+	// Returns false if the depth couldn't be used.
+	bool StoreEyeDepth(vr::EVREye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds, vr::EVRSubmitFlags submitFlags);
+
+	// The space warp info for each eye, chained onto depthInfos when the spaceWarp option is enabled
+	XrCompositionLayerSpaceWarpInfoFB spaceWarpInfos[XruEyeCount];
+
+	// Whether the last frame was submitted with space warp, in which case the app is run at half rate
+	bool spaceWarpActive = false;
+
+	// When xrWaitFrame last returned, and the display period it predicted. Used to pace the app with space warp.
+	std::chrono::steady_clock::time_point lastFrameWaitEnd;
+	XrDuration displayPeriod = 0;
+
+	// Smoothed time between the app's frames, to compare against the display rate
+	double appFrameIntervalMs = 0;
+	std::chrono::steady_clock::time_point lastSpaceWarpLog;
+
 	// Have we started rendering a frame yet? If not, calling xrEndFrame would result in an error
 	bool renderingFrame = false;
 
@@ -102,6 +153,54 @@ private:
 	// might miss overlay elements for GUI or HUDs
 	bool postPresentStatus = false;
 
+	// Held while a frame is waited on, begun or ended, and while the skybox is updated. This stops the app's thread
+	// and the skybox thread from interleaving their frames. Also guards renderingFrame, sessionActive
+	// and the skybox fields below.
+	std::mutex frameLock;
+
+	// Set while the app's thread is waiting for frameLock to start a frame, so the skybox thread backs off
+	std::atomic<bool> appFrameWaiting = false;
+
+	// When the app (or SetSkyboxOverride) last started a frame
+	std::chrono::steady_clock::time_point lastAppFrame;
+
+	// The skybox override set by the app, or null in skyboxLayer if there isn't one
+	std::unique_ptr<Compositor> skyboxCompositor;
+	bool skyboxIsCube = false;
+	XrCompositionLayerQuad skyboxQuad{ XR_TYPE_COMPOSITION_LAYER_QUAD };
+	XrCompositionLayerCubeKHR skyboxCube{ XR_TYPE_COMPOSITION_LAYER_CUBE_KHR };
+	XrCompositionLayerBaseHeader* skyboxLayer = nullptr;
+
+	// Keeps the skybox on screen while the app isn't submitting frames, see the skyboxSubmitThread option
+	std::thread skyboxThread;
+	std::condition_variable skyboxThreadWake;
+	bool skyboxThreadStop = false;
+	void RunSkyboxThread();
+	void StopSkyboxThread();
+
+	// Submit a frame containing only the skybox. frameLock must be held.
+	void SubmitSkyboxFrame();
+
+	// Set once the app asks for a mirror texture, so the compositors keep a copy of each eye from then on
+	bool mirrorRequested = false;
+
+	// The screenshot requested through CaptureScreenshot, which is waiting for the eye compositors to read back
+	// the frame. Only accessed from the app's render thread.
+	std::function<void(CompositorReadback* eyes)> screenshotCallback;
+	CompositorReadback screenshotEyes[XruEyeCount];
+	bool screenshotEyeDone[XruEyeCount] = {};
+
+	// Check if the eyes for a pending screenshot have been read back, and pass them on if so
+	void PollScreenshot();
+
+	// Abandon a pending screenshot, since the compositors it was requested from are going away
+	void CancelScreenshot();
+
+	// The play area, worked out when it's first requested. This is kept until the stage space changes, or a new
+	// session is created. playArea is null if the runtime doesn't have a play area.
+	bool playAreaCached = false;
+	std::unique_ptr<PlayAreaGeometry> playArea;
+
 	// Number of frames rendered for use in frame timing data
 	uint32_t nFrameIndex = 0;
 
@@ -13,41 +13,88 @@
 
 void XrHMD::GetRecommendedRenderTargetSize(uint32_t* width, uint32_t* height)
 {
-	*width = (uint32_t)((float)xr_main_view(XruEyeLeft).recommendedImageRectWidth * oovr_global_configuration.SupersampleRatio());
-	*height = (uint32_t)((float)xr_main_view(XruEyeLeft).recommendedImageRectHeight * oovr_global_configuration.SupersampleRatio());
+	*width = (uint32_t)((float)xr_main_view(XruEyeLeft).recommendedImageRectWidth * oovr_global_configuration->SupersampleRatio());
+	*height = (uint32_t)((float)xr_main_view(XruEyeLeft).recommendedImageRectHeight * oovr_global_configuration->SupersampleRatio());
 }
 
 // from BaseSystem
 
-vr::HmdMatrix44_t XrHMD::GetProjectionMatrix(vr::EVREye eEye, float fNearZ, float fFarZ, EGraphicsAPIConvention convention)
+const XrHMD::ViewSnapshot& XrHMD::GetViewSnapshot()
 {
-	if (eEye < 0 || (int)eEye >= 2)
-		eEye = vr::Eye_Left;
-
-	XrViewConfigurationView& eye = xr_main_view((XruEye)eEye);
+	XrTime time = xr_gbl->GetBestTime();
+	if (viewSnapshot.time == time) {
+		viewLocatesSaved++;
+		return viewSnapshot;
+	}
 
 	XrViewLocateInfo locateInfo = { XR_TYPE_VIEW_LOCATE_INFO };
 	locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-	locateInfo.displayTime = xr_gbl->GetBestTime();
-
-	// Seated space is available first when starting up, depending on the runtime implementation. We quickly get accurate
-	// values from xrLocateViews, but that doesn't help if the app only calls GetProjectionMatrix once and stores the
-	// bad values.
-	// TODO A better way to solve this would be to submit a few blank frames when we're using the temporary device to
-	// let this value settle, along with any other similar data.
-	locateInfo.space = xr_gbl->seatedSpace; // Should make no difference to the FOV
+	locateInfo.displayTime = time;
+	locateInfo.space = xr_gbl->viewSpace; // The FOV is the same in any space, and this gives us the eye-to-head poses
 
 	XrViewState state = { XR_TYPE_VIEW_STATE };
 	uint32_t viewCount = 0;
 	XrView views[XruEyeCount] = { { XR_TYPE_VIEW }, { XR_TYPE_VIEW } };
-	OOVR_FAILED_XR_ABORT(xrLocateViews(xr_session.get(), &locateInfo, &state, XruEyeCount, &viewCount, views));
-	OOVR_FALSE_ABORT(viewCount == XruEyeCount);
+	OOVR_FAILED_XR_SOFT_ABORT(xrLocateViews(xr_session.get(), &locateInfo, &state, XruEyeCount, &viewCount, views));
+
+	// If that failed, keep using whatever we had before
+	if (viewCount != XruEyeCount) {
+		OOVR_LOG_ONCEF("Eye count is incorrect: %d", viewCount);
+		return viewSnapshot;
+	}
+
+	for (int eye = 0; eye < XruEyeCount; eye++)
+		viewSnapshot.fov[eye] = views[eye].fov;
+
+	// Until the runtime knows where the eyes are, locate them again on every call rather than once per frame, so
+	// the real values are picked up as soon as possible.
+	if (state.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT && state.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) {
+		viewSnapshot.time = time;
+		viewSnapshot.posesValid = true;
+		for (int eye = 0; eye < XruEyeCount; eye++)
+			viewSnapshot.eyePoses[eye] = views[eye].pose;
+	}
+
+	viewLocatesMade++;
+	auto now = std::chrono::steady_clock::now();
+	std::chrono::duration<float> elapsed = now - viewStatsStart;
+	if (elapsed.count() >= 10.0f) {
+		if (viewLocatesSaved != 0) {
+			OOVR_LOGF("View snapshot: saved %.1f xrLocateViews calls per frame", (float)viewLocatesSaved / (float)viewLocatesMade);
+		}
+		viewLocatesMade = 0;
+		viewLocatesSaved = 0;
+		viewStatsStart = now;
+	}
+
+	return viewSnapshot;
+}
+
+void XrHMD::InvalidateViewSnapshot()
+{
+	std::lock_guard<std::mutex> guard(viewLock);
+	viewSnapshot.time = 0;
+}
+
+vr::HmdMatrix44_t XrHMD::GetProjectionMatrix(vr::EVREye eEye, float fNearZ, float fFarZ, EGraphicsAPIConvention convention)
+{
+	if (eEye < 0 || (int)eEye >= 2)
+		eEye = vr::Eye_Left;
+
+	// The runtime may give us inaccurate values while it's starting up. We quickly get accurate values from
+	// xrLocateViews, but that doesn't help if the app only calls GetProjectionMatrix once and stores the bad values.
+	// TODO A better way to solve this would be to submit a few blank frames when we're using the temporary device to
+	// let this value settle, along with any other similar data.
+	XrFovf fov;
+	{
+		std::lock_guard<std::mutex> guard(viewLock);
+		fov = GetViewSnapshot().fov[eEye];
+	}
 
 	// Build the projection matrix
 	// It looks like there aren't any functions in glm that can take different l/r/t/b FOV values, so do it ourselves
 	// Also calculate the projection matrix as row major (so one column determines one value when multiplied with a
 	// vector) and then transpose it back to being a column-major vector.
-	XrFovf& fov = views[eEye].fov;
 
 	float twoNear = fNearZ * 2;
 	float tanL = tanf(fov.angleLeft);
@@ -93,27 +140,12 @@ void XrHMD::GetProjectionRaw(vr::EVREye eEye, float* pfLeft, float* pfRight, flo
 	if (eEye < 0 || (int)eEye >= 2)
 		eEye = vr::Eye_Left;
 
-	// TODO deduplicate with GetProjectionMatrix
-	XrViewConfigurationView& eye = xr_main_view((XruEye)eEye);
-
-	XrViewLocateInfo locateInfo = { XR_TYPE_VIEW_LOCATE_INFO };
-	locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-	locateInfo.displayTime = xr_gbl->GetBestTime();
-
-	// Seated space is available first when starting up
-	locateInfo.space = xr_gbl->seatedSpace; // Should make no difference to the FOV
-
-	XrViewState state = { XR_TYPE_VIEW_STATE };
-	uint32_t viewCount = 0;
-	XrView views[XruEyeCount] = { { XR_TYPE_VIEW }, { XR_TYPE_VIEW } };
-	OOVR_FAILED_XR_SOFT_ABORT(xrLocateViews(xr_session.get(), &locateInfo, &state, XruEyeCount, &viewCount, views));
-	if (viewCount != XruEyeCount) {
-		OOVR_LOG_ONCEF("Eye count is incorrect: %d", viewCount);
-		return;
+	XrFovf fov;
+	{
+		std::lock_guard<std::mutex> guard(viewLock);
+		fov = GetViewSnapshot().fov[eEye];
 	}
 
-	XrFovf& fov = views[eEye].fov;
-
 	/**
 	 * With a straight passthrough:
 	 *
@@ -153,9 +185,6 @@ bool XrHMD::ComputeDistortion(vr::EVREye eEye, float fU, float fV, vr::Distortio
 
 vr::HmdMatrix34_t XrHMD::GetEyeToHeadTransform(vr::EVREye eEye)
 {
-	static XrTime time = ~0; // Don't set to zero by default, otherwise we'll return an identity matrix before the first frame
-	static XrView views[XruEyeCount] = { { XR_TYPE_VIEW }, { XR_TYPE_VIEW } };
-
 	while (!xr_gbl) {
 		using namespace std::chrono_literals;
 		std::this_thread::sleep_for(20ms);
@@ -165,26 +194,16 @@ vr::HmdMatrix34_t XrHMD::GetEyeToHeadTransform(vr::EVREye eEye)
 	if (eEye < 0 || (int)eEye >= 2)
 		eEye = vr::Eye_Left;
 
-	if (time != xr_gbl->GetBestTime()) {
-		XrViewLocateInfo locateInfo = { XR_TYPE_VIEW_LOCATE_INFO };
-		locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-		locateInfo.displayTime = xr_gbl->GetBestTime();
-		locateInfo.space = xr_gbl->viewSpace;
-
-		uint32_t viewCount = 0;
-		XrViewState viewState = { XR_TYPE_VIEW_STATE };
-		XrView _views[XruEyeCount] = { { XR_TYPE_VIEW }, { XR_TYPE_VIEW } };
-		OOVR_FAILED_XR_SOFT_ABORT(xrLocateViews(xr_session.get(), &locateInfo, &viewState, XruEyeCount, &viewCount, _views));
-
-		if (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT && viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) {
-			OOVR_FALSE_ABORT(viewCount == XruEyeCount);
-			views[0] = _views[0];
-			views[1] = _views[1];
-			time = xr_gbl->GetBestTime();
-		}
+	// Don't return an identity matrix before the runtime knows where the eyes are
+	XrPosef pose = { { 0, 0, 0, 0 }, { 0, 0, 0 } };
+	{
+		std::lock_guard<std::mutex> guard(viewLock);
+		const ViewSnapshot& snapshot = GetViewSnapshot();
+		if (snapshot.posesValid)
+			pose = snapshot.eyePoses[eEye];
 	}
 
-	return G2S_m34(X2G_om34_pose(views[eEye].pose));
+	return G2S_m34(X2G_om34_pose(pose));
 }
 
 bool XrHMD::GetTimeSinceLastVsync(float* pfSecondsSinceLastVsync, uint64_t* pulFrameCounter)
@@ -253,9 +272,9 @@ vr::HiddenAreaMesh_t XrHMD::GetHiddenAreaMesh(vr::EVREye eEye, vr::EHiddenAreaMe
 		int index = mask.indices[i];
 		XrVector2f v = mask.vertices[index];
 
-		if (oovr_global_configuration.EnableHiddenMeshFix()) {
+		if (oovr_global_configuration->EnableHiddenMeshFix()) {
 			if (fabs(v.y - ftop) > 0.001 && fabs(v.y - fbottom) > 0.001) {
-				arr[i] = vr::HmdVector2_t{ (v.x - fleft) / (fright - fleft), (v.y * oovr_global_configuration.HiddenMeshVerticalScale() - ftop) / (fbottom - ftop) };
+				arr[i] = vr::HmdVector2_t{ (v.x - fleft) / (fright - fleft), (v.y * oovr_global_configuration->HiddenMeshVerticalScale() - ftop) / (fbottom - ftop) };
 			} else {
 				arr[i] = vr::HmdVector2_t{ (v.x - fleft) / (fright - fleft), (v.y - ftop) / (fbottom - ftop) };
 			}
@@ -306,22 +325,12 @@ void XrHMD::GetPose(vr::ETrackingUniverseOrigin origin, vr::TrackedDevicePose_t*
 
 float XrHMD::GetIPD()
 {
-	XrViewLocateInfo locateInfo = { XR_TYPE_VIEW_LOCATE_INFO };
-	locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-	locateInfo.displayTime = xr_gbl->GetBestTime();
-	locateInfo.space = xr_gbl->viewSpace;
-
-	XrViewState state = { XR_TYPE_VIEW_STATE };
-	uint32_t viewCount = 0;
-	XrView views[XruEyeCount] = { { XR_TYPE_VIEW }, { XR_TYPE_VIEW } };
-
-	OOVR_FAILED_XR_SOFT_ABORT(xrLocateViews(xr_session.get(), &locateInfo, &state, XruEyeCount, &viewCount, views));
-	OOVR_FALSE_ABORT(viewCount == XruEyeCount);
-
 	static float ipd = 0.0064;
 
-	if (state.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT && state.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT)
-		ipd = views[vr::Eye_Right].pose.position.x - views[vr::Eye_Left].pose.position.x;
+	std::lock_guard<std::mutex> guard(viewLock);
+	const ViewSnapshot& snapshot = GetViewSnapshot();
+	if (snapshot.posesValid)
+		ipd = snapshot.eyePoses[vr::Eye_Right].position.x - snapshot.eyePoses[vr::Eye_Left].position.x;
 
 	return ipd;
 }
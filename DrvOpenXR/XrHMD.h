@@ -9,6 +9,9 @@
 #include "Misc/Input/InteractionProfile.h"
 #include "XrTrackedDevice.h"
 
+#include <chrono>
+#include <mutex>
+
 // This warning tells us that a method (GetPose) was overridden by one of our parent classes
 // Totally fine, that's the reason why we include XrTrackedDevice in the first place
 #pragma warning(push)
@@ -17,6 +20,31 @@
 class XrHMD : public XrTrackedDevice, public IHMD {
 	const InteractionProfile* profile = nullptr;
 
+	/**
+	 * The views located in view space at one predicted display time, shared by the projection, FOV, IPD and
+	 * eye-to-head queries. Engines often call these several times per eye per frame, and otherwise each call
+	 * would locate the views again.
+	 */
+	struct ViewSnapshot {
+		XrTime time = 0; // Zero if the snapshot needs updating, or if the views weren't valid last time
+		XrFovf fov[XruEyeCount] = {};
+
+		// The eye poses from the last time the runtime said they were valid, since they may not be very early on
+		bool posesValid = false;
+		XrPosef eyePoses[XruEyeCount] = {};
+	};
+
+	std::mutex viewLock;
+	ViewSnapshot viewSnapshot;
+
+	// For logging how many xrLocateViews calls the snapshot saves
+	uint32_t viewLocatesMade = 0;
+	uint32_t viewLocatesSaved = 0;
+	std::chrono::steady_clock::time_point viewStatsStart = std::chrono::steady_clock::now();
+
+	// Make sure the snapshot is for the current time, locating the views if it isn't. viewLock must be held.
+	const ViewSnapshot& GetViewSnapshot();
+
 public:
 	// Override the GetPose implementation to use the difference between spaces, in the hope it'll make the
 	// head positioning possibly more accurate.
@@ -75,6 +103,9 @@ public:
 	int32_t GetInt32TrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL) override;
 
 	void SetInteractionProfile(const InteractionProfile* profile);
+
+	// Throw away the view snapshot, for when the runtime says a reference space is changing
+	void InvalidateViewSnapshot();
 };
 
 #pragma warning(pop)
@@ -0,0 +1,97 @@
+#include "XrTracker.h"
+
+#include "../OpenOVR/Misc/xrmoreutils.h"
+#include "../OpenOVR/Reimpl/BaseInput.h"
+#include "generated/static_bases.gen.h"
+
+const XrTracker::Role XrTracker::roles[XrTracker::ROLE_COUNT] = {
+	{ "handheld_object", "vive_tracker_handed" },
+	{ "left_foot", "vive_tracker_left_foot" },
+	{ "right_foot", "vive_tracker_right_foot" },
+	{ "left_shoulder", "vive_tracker_left_shoulder" },
+	{ "right_shoulder", "vive_tracker_right_shoulder" },
+	{ "left_elbow", "vive_tracker_left_elbow" },
+	{ "right_elbow", "vive_tracker_right_elbow" },
+	{ "left_knee", "vive_tracker_left_knee" },
+	{ "right_knee", "vive_tracker_right_knee" },
+	{ "waist", "vive_tracker_waist" },
+	{ "chest", "vive_tracker_chest" },
+	{ "camera", "vive_tracker_camera" },
+	{ "keyboard", "vive_tracker_keyboard" },
+};
+
+std::string XrTracker::GetRolePath(int role)
+{
+	return std::string("/user/vive_tracker_htcx/role/") + roles[role].name;
+}
+
+XrTracker::XrTracker(int role)
+    : role(role)
+{
+}
+
+void XrTracker::GetPose(vr::ETrackingUniverseOrigin origin, vr::TrackedDevicePose_t* pose, ETrackingStateType trackingState)
+{
+	// Default to an invalid pose
+	ZeroMemory(pose, sizeof(*pose));
+	pose->bDeviceIsConnected = true;
+	pose->bPoseIsValid = false;
+	pose->eTrackingResult = vr::TrackingResult_Running_OutOfRange;
+
+	BaseInput* input = GetUnsafeBaseInput();
+	if (input == nullptr)
+		return;
+
+	XrSpace space = input->GetTrackerSpace(role);
+	if (!space)
+		return;
+
+	xr_utils::PoseFromSpace(pose, space, origin);
+}
+
+vr::ETrackedDeviceClass XrTracker::GetTrackedDeviceClass()
+{
+	return vr::TrackedDeviceClass_GenericTracker;
+}
+
+// properties
+bool XrTracker::GetBoolTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
+{
+	if (pErrorL)
+		*pErrorL = vr::TrackedProp_Success;
+
+	switch (prop) {
+	case vr::Prop_DeviceProvidesBatteryStatus_Bool:
+		return false;
+	default:
+		return XrTrackedDevice::GetBoolTrackedDeviceProperty(prop, pErrorL);
+	}
+}
+
+uint32_t XrTracker::GetStringTrackedDeviceProperty(vr::ETrackedDeviceProperty prop,
+    char* value, uint32_t bufferSize, vr::ETrackedPropertyError* pErrorL)
+{
+	if (pErrorL)
+		*pErrorL = vr::TrackedProp_Success;
+
+#define PROP(in, out)                          \
+	if (prop == in) {                          \
+		if (value != NULL && bufferSize > 0) { \
+			strcpy_s(value, bufferSize, out);  \
+		}                                      \
+		return (uint32_t)strlen(out) + 1;      \
+	}
+
+	// Apps like VRChat tell trackers apart by their serial numbers, so make sure each role has its own
+	std::string serial = std::string("OC-Tracker-") + roles[role].name;
+
+	PROP(vr::Prop_SerialNumber_String, serial.c_str());
+	PROP(vr::Prop_ControllerType_String, roles[role].controllerType);
+	PROP(vr::Prop_RenderModelName_String, "{htc}vr_tracker_vive_1_0");
+	PROP(vr::Prop_ModelNumber_String, "VIVE Tracker");
+	PROP(vr::Prop_RegisteredDeviceType_String, ("htc/vive_tracker" + serial).c_str());
+
+#undef PROP
+
+	return XrTrackedDevice::GetStringTrackedDeviceProperty(prop, value, bufferSize, pErrorL);
+}
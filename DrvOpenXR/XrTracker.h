@@ -0,0 +1,38 @@
+#pragma once
+
+#include "XrTrackedDevice.h"
+
+/**
+ * A body tracker (such as a Vive tracker), exposed through XR_HTCX_vive_tracker_interaction. That extension only lets
+ * trackers be bound by the role the user assigned them, so there's one of these for each role with a tracker in it.
+ */
+class XrTracker : public XrTrackedDevice {
+public:
+	struct Role {
+		const char* name; // The last part of the OpenXR role path, eg waist
+		const char* controllerType; // What SteamVR calls a tracker with this role
+	};
+
+	// All the roles defined by XR_HTCX_vive_tracker_interaction
+	static constexpr int ROLE_COUNT = 13;
+	static const Role roles[ROLE_COUNT];
+
+	// Get the OpenXR path for a role, eg /user/vive_tracker_htcx/role/waist
+	static std::string GetRolePath(int role);
+
+	explicit XrTracker(int role);
+
+	int GetRole() const { return role; }
+
+	void GetPose(vr::ETrackingUniverseOrigin origin, vr::TrackedDevicePose_t* pose, ETrackingStateType trackingState) override;
+
+	vr::ETrackedDeviceClass GetTrackedDeviceClass() override;
+
+	// properties
+	bool GetBoolTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL) override;
+	uint32_t GetStringTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, char* pchValue,
+	    uint32_t unBufferSize, vr::ETrackedPropertyError* pErrorL) override;
+
+private:
+	int role;
+};
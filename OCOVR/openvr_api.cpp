@@ -8,9 +8,11 @@
 // Needed for the system-wide usage of this DLL (when renamed to vrclient[_x64].dll)
 #include "generated/GVRClientCore.gen.h"
 
+#include "Misc/CallProfiler.h"
 #include "Misc/Config.h"
 #include "Misc/debug_helper.h"
 #include "steamvr_abi.h"
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -49,6 +51,19 @@ using correct_layout_unique = std::unique_ptr<CVRCorrectLayout, std::function<vo
 
 static std::map<std::string, correct_layout_unique> interfaces;
 
+// The interfaces that have already been created, by GetInterfaceIndexByName. Some apps look their interfaces up every
+// frame, so this lets them skip the map (and the FnTable handling) after the first time.
+struct CachedInterface {
+	std::atomic<void*> instance = nullptr;
+	std::atomic<void*> fnTable = nullptr;
+};
+
+static CachedInterface* GetCachedInterfaces()
+{
+	static std::unique_ptr<CachedInterface[]> cache(new CachedInterface[GetInterfaceCount()]);
+	return cache.get();
+}
+
 VR_INTERFACE void* VR_CALLTYPE VR_GetGenericInterface(const char* interfaceVersion, EVRInitError* error)
 {
 	if (!running) {
@@ -63,6 +78,15 @@ VR_INTERFACE void* VR_CALLTYPE VR_GetGenericInterface(const char* interfaceVersi
 	if (error)
 		*error = VRInitError_None;
 
+	bool fnTable = false;
+	int cacheIndex = GetInterfaceIndexByName(interfaceVersion, &fnTable);
+	CachedInterface* cached = cacheIndex == -1 ? nullptr : &GetCachedInterfaces()[cacheIndex];
+	if (cached) {
+		void* ptr = (fnTable ? cached->fnTable : cached->instance).load(std::memory_order_acquire);
+		if (ptr)
+			return ptr;
+	}
+
 	// First check if they're getting the 'FnTable' version of this interface.
 	// This is a table of methods, but critically they *don't* take a 'this' pointer,
 	//  so we can't cheat and return the vtable.
@@ -80,7 +104,10 @@ VR_INTERFACE void* VR_CALLTYPE VR_GetGenericInterface(const char* interfaceVersi
 			return NULL;
 		}
 
-		return interfaceClass->_GetStatFuncList();
+		void** fnTableList = interfaceClass->_GetStatFuncList();
+		if (cached)
+			cached->fnTable.store(fnTableList, std::memory_order_release);
+		return fnTableList;
 	}
 
 	if (interfaces.count(interfaceVersion)) {
@@ -127,6 +154,8 @@ VR_INTERFACE void* VR_CALLTYPE VR_GetGenericInterface(const char* interfaceVersi
 			cl->Delete();
 		});
 		interfaces[interfaceVersion] = std::move(ptr);
+		if (cached)
+			cached->instance.store(impl, std::memory_order_release);
 		return impl;
 	}
 
@@ -270,6 +299,12 @@ success:
 	// TODO seperate this from the rest of dllmain
 	BackendManager::Create(DrvOpenXR::CreateOpenXRBackend());
 
+	// Pick up edits to the config file while the game is running
+	oovr_global_configuration.StartWatching();
+
+	// Start timing the OpenVR calls, if enabled
+	CallProfiler::Init();
+
 	return current_init_token;
 }
 
@@ -341,8 +376,14 @@ VR_INTERFACE void VR_CALLTYPE VR_ShutdownInternal()
 	// Reset interfaces
 	// Do this first, while the OVR session is still available in case they
 	//  need to use it for cleanup.
+	for (int i = 0; i < GetInterfaceCount(); i++) {
+		GetCachedInterfaces()[i].instance = nullptr;
+		GetCachedInterfaces()[i].fnTable = nullptr;
+	}
 	interfaces.clear();
 
+	oovr_global_configuration.StopWatching();
+
 	// Shut down OpenXR
 	BackendManager::Reset();
 
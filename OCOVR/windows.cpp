@@ -98,13 +98,13 @@ alternativeCoreFactory_t PlatformGetAlternativeCoreFactory()
 //  as listed in the Windows audio settings.
 void init_audio()
 {
-	if (!oovr_global_configuration.EnableAudioSwitch())
+	if (!oovr_global_configuration->EnableAudioSwitch())
 		return;
 
 	OOVR_LOGF("Attempting to switch Audio.");
 
 	std::wstring dev;
-	HRESULT hr = find_output_device(dev, oovr_global_configuration.AudioDeviceName());
+	HRESULT hr = find_output_device(dev, oovr_global_configuration->AudioDeviceName());
 
 	if (SUCCEEDED(hr)) {
 		OOVR_LOGF("Succeeded in getting audio device output: %s.  Setting app default audio output to device.", dev.c_str());
@@ -2,10 +2,180 @@
 
 #include "compositor.h"
 
+#include <algorithm>
+
 Compositor::~Compositor()
 {
 	if (chain) {
 		OOVR_FAILED_XR_SOFT_ABORT(xrDestroySwapchain(chain));
 		chain = XR_NULL_HANDLE;
 	}
+
+	if (depthChain) {
+		OOVR_FAILED_XR_SOFT_ABORT(xrDestroySwapchain(depthChain));
+		depthChain = XR_NULL_HANDLE;
+	}
+
+	if (motionVectorChain) {
+		OOVR_FAILED_XR_SOFT_ABORT(xrDestroySwapchain(motionVectorChain));
+		motionVectorChain = XR_NULL_HANDLE;
+	}
+}
+
+bool Compositor::CreateDepthSwapChain(uint32_t width, uint32_t height, int64_t format)
+{
+	uint32_t formatCount;
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainFormats(xr_session.get(), 0, &formatCount, nullptr));
+	std::vector<int64_t> formats(formatCount);
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainFormats(xr_session.get(), formatCount, &formatCount, formats.data()));
+
+	// Depth is only a hint for reprojection, so carry on without it rather than aborting
+	if (std::count(formats.begin(), formats.end(), format) == 0) {
+		OOVR_LOG_ONCEF("The runtime does not support the depth format %d, submitting without depth", (int)format);
+		return false;
+	}
+
+	OOVR_LOGF("Creating new depth swapchain: %dx%d with format %d", width, height, (int)format);
+
+	if (depthChain) {
+		OOVR_FAILED_XR_ABORT(xrDestroySwapchain(depthChain));
+		depthChain = XR_NULL_HANDLE;
+	}
+
+	depthCreateInfo = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+	depthCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	depthCreateInfo.format = format;
+	depthCreateInfo.sampleCount = 1;
+	depthCreateInfo.width = width;
+	depthCreateInfo.height = height;
+	depthCreateInfo.faceCount = 1;
+	depthCreateInfo.arraySize = 1;
+	depthCreateInfo.mipCount = 1;
+	OOVR_FAILED_XR_ABORT(xrCreateSwapchain(xr_session.get(), &depthCreateInfo, &depthChain));
+
+	return true;
+}
+
+bool Compositor::InvokeSpaceWarp(XrCompositionLayerSpaceWarpInfoFB& info)
+{
+	int64_t format = GetMotionVectorFormat();
+	if (!depthChain || !format)
+		return false;
+
+	if (!motionVectorChain || motionVectorCreateInfo.width != depthCreateInfo.width || motionVectorCreateInfo.height != depthCreateInfo.height) {
+		if (motionVectorChain) {
+			OOVR_FAILED_XR_ABORT(xrDestroySwapchain(motionVectorChain));
+			motionVectorChain = XR_NULL_HANDLE;
+		}
+
+		OOVR_LOGF("Creating motion vector swapchain: %dx%d", depthCreateInfo.width, depthCreateInfo.height);
+
+		// The contents never change, so let the runtime skip buffering it
+		motionVectorCreateInfo = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+		motionVectorCreateInfo.createFlags = XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT;
+		motionVectorCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+		motionVectorCreateInfo.format = format;
+		motionVectorCreateInfo.sampleCount = 1;
+		motionVectorCreateInfo.width = depthCreateInfo.width;
+		motionVectorCreateInfo.height = depthCreateInfo.height;
+		motionVectorCreateInfo.faceCount = 1;
+		motionVectorCreateInfo.arraySize = 1;
+		motionVectorCreateInfo.mipCount = 1;
+		OOVR_FAILED_XR_ABORT(xrCreateSwapchain(xr_session.get(), &motionVectorCreateInfo, &motionVectorChain));
+
+		ClearMotionVectors();
+	}
+
+	info.motionVectorSubImage.swapchain = motionVectorChain;
+	info.motionVectorSubImage.imageArrayIndex = 0;
+	info.motionVectorSubImage.imageRect.offset = { 0, 0 };
+	info.motionVectorSubImage.imageRect.extent = { (int32_t)motionVectorCreateInfo.width, (int32_t)motionVectorCreateInfo.height };
+
+	return true;
+}
+
+bool CompositorRect::Touches(const CompositorRect& other) const
+{
+	return x <= other.x + other.width && other.x <= x + width && y <= other.y + other.height && other.y <= y + height;
+}
+
+void CompositorRect::Add(const CompositorRect& other)
+{
+	if (other.IsEmpty())
+		return;
+
+	if (IsEmpty()) {
+		*this = other;
+		return;
+	}
+
+	uint32_t right = std::max(x + width, other.x + other.width);
+	uint32_t bottom = std::max(y + height, other.y + other.height);
+	x = std::min(x, other.x);
+	y = std::min(y, other.y);
+	width = right - x;
+	height = bottom - y;
+}
+
+CompositorRect CompositorRect::ClampedTo(uint32_t imageWidth, uint32_t imageHeight) const
+{
+	CompositorRect result;
+	result.x = std::min(x, imageWidth);
+	result.y = std::min(y, imageHeight);
+	result.width = std::min(width, imageWidth - result.x);
+	result.height = std::min(height, imageHeight - result.y);
+	return result;
+}
+
+void CompositorRect::AddToList(std::vector<CompositorRect>& rects, CompositorRect rect, size_t maxRects)
+{
+	if (rect.IsEmpty())
+		return;
+
+	// Merging two rectangles can make the result touch ones it didn't before, so start over after each merge
+	for (size_t i = 0; i < rects.size();) {
+		if (rects[i].Touches(rect)) {
+			rect.Add(rects[i]);
+			rects.erase(rects.begin() + (ptrdiff_t)i);
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+	rects.push_back(rect);
+
+	if (rects.size() > maxRects) {
+		CompositorRect all;
+		for (const CompositorRect& other : rects)
+			all.Add(other);
+		rects = { all };
+	}
+}
+
+std::vector<CompositorRect> Compositor::TakeRawUploadRects(uint32_t imageIndex, uint32_t imageCount, const CompositorRect* changed, uint32_t changedCount)
+{
+	CompositorRect whole = { 0, 0, createInfo.width, createInfo.height };
+
+	// A new swapchain's images haven't been written to at all. Static swapchains are new every time, and checking the
+	// size as well as the handle catches a resized swapchain that the runtime gave the old one's handle.
+	if (IsStaticImage() || chain != rawTrackedChain || rawStaleRects.size() != imageCount || rawTrackedSize.width != whole.width
+	    || rawTrackedSize.height != whole.height) {
+		rawTrackedChain = chain;
+		rawTrackedSize = whole;
+		rawStaleRects.assign(imageCount, { whole });
+	}
+
+	for (std::vector<CompositorRect>& stale : rawStaleRects) {
+		if (!changed) {
+			stale = { whole };
+			continue;
+		}
+
+		for (uint32_t i = 0; i < changedCount; i++)
+			CompositorRect::AddToList(stale, changed[i].ClampedTo(whole.width, whole.height));
+	}
+
+	std::vector<CompositorRect> result = std::move(rawStaleRects.at(imageIndex));
+	rawStaleRects.at(imageIndex).clear();
+	return result;
 }
@@ -10,6 +10,7 @@
 #include "../Misc/xr_ext.h"
 #include "../Misc/xrutil.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -19,6 +20,47 @@ using Microsoft::WRL::ComPtr;
 
 typedef unsigned int GLuint;
 
+/**
+ * An image copied back from the GPU for a screenshot. The pixels are 8-bit RGBA or BGRA, and stay valid until
+ * release is called, which may be done from any thread.
+ */
+struct CompositorReadback {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowPitch = 0;
+	bool bgra = false;
+	bool bottomUp = false; // The rows are stored bottom-to-top, as OpenGL does
+	const uint8_t* pixels = nullptr;
+	std::function<void()> release;
+};
+
+/**
+ * A rectangle of pixels in an image, measured from its top-left corner.
+ */
+struct CompositorRect {
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	bool IsEmpty() const { return width == 0 || height == 0; }
+
+	// Whether other overlaps this rectangle, or shares an edge with it
+	bool Touches(const CompositorRect& other) const;
+
+	// Grow this rectangle to also cover other
+	void Add(const CompositorRect& other);
+
+	// The part of this rectangle that's inside an image of the given size
+	CompositorRect ClampedTo(uint32_t imageWidth, uint32_t imageHeight) const;
+
+	/**
+	 * Add a rectangle to a list of them, merging it with any that it touches. Each rectangle costs a separate copy,
+	 * so if the list grows past maxRects it's collapsed into one rectangle covering all of them.
+	 */
+	static void AddToList(std::vector<CompositorRect>& rects, CompositorRect rect, size_t maxRects = 8);
+};
+
 class Compositor {
 public:
 	virtual ~Compositor();
@@ -31,8 +73,65 @@ public:
 	    = 0;
 
 	virtual void InvokeCubemap(const vr::Texture_t* textures) = 0;
+
+	/**
+	 * The swapchain face each of the six skybox textures passed to InvokeCubemap is copied into. OpenVR passes
+	 * them in the order front, back, left, right, top, bottom, while the swapchain faces are +X, -X, +Y, -Y, +Z, -Z.
+	 */
+	static constexpr uint32_t CUBEMAP_FACE_INDICES[6] = { 5, 4, 0, 1, 2, 3 };
+
+	/**
+	 * Copy an 8-bit RGBA image from system memory into the swapchain, for SetOverlayRaw and SetOverlayFromFile.
+	 * If only parts of the image changed since the last call, pass them in as the changedCount rectangles in
+	 * changed, and only those (plus whatever the swapchain image being written has missed since it was last used)
+	 * are uploaded. pixels must still point to the whole image. Returns false if this isn't supported with the
+	 * current graphics API.
+	 */
+	virtual bool InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed = nullptr, uint32_t changedCount = 0) { return false; }
 	virtual bool SupportsCubemap() { return false; }
 
+	/**
+	 * Copy the image from the next call to Invoke back to system memory, for screenshots. The copy is recorded
+	 * alongside the usual one, so this never makes the app wait for the GPU.
+	 */
+	virtual bool SupportsReadback() { return false; }
+	virtual void RequestReadback() {}
+
+	/**
+	 * Check if the copy started by RequestReadback has finished, without waiting for it. Once it has, this
+	 * fills out readback and returns true.
+	 */
+	virtual bool PollReadback(CompositorReadback& readback) { return false; }
+
+	/**
+	 * Keep a copy of the most recently submitted image for apps that draw a mirror window, in the app's own graphics
+	 * API. This costs an extra GPU copy per frame, so it's only done once the app has asked for the mirror.
+	 * SupportsMirror returns whether a mirror can be made for the given texture type.
+	 */
+	virtual bool SupportsMirror(vr::ETextureType api) { return false; }
+	virtual void EnableMirror() {}
+
+	/**
+	 * The mirror image, as a texture name for OpenGL. This is zero until the first image has been submitted with the
+	 * mirror enabled, and changes if the submitted images change size or format.
+	 */
+	virtual uint64_t GetMirrorImage() { return 0; }
+
+	/**
+	 * Copy the depth buffer submitted alongside an eye's colour image into a depth swapchain, and point
+	 * depthInfo's subImage at it. This must be called after the colour image is copied with Invoke. Returns
+	 * false if the depth can't be used, in which case the eye should be submitted without depth.
+	 */
+	virtual bool InvokeDepth(const vr::VRTextureDepthInfo_t& depth, const vr::VRTextureBounds_t* bounds, XrCompositionLayerDepthInfoKHR& depthInfo) { return false; }
+
+	/**
+	 * Fill out the motion vectors for space warp, for the depth copied by the last InvokeDepth. OpenVR apps
+	 * can't give us motion vectors, so these are all zero and the runtime works from the head motion and
+	 * depth alone. The motion vector swapchain is static, so this costs nothing per frame once it's set up.
+	 * Returns false if this isn't supported with the current graphics API.
+	 */
+	bool InvokeSpaceWarp(XrCompositionLayerSpaceWarpInfoFB& info);
+
 	virtual XrSwapchain GetSwapChain() { return chain; };
 
 	virtual XrExtent2Df GetSrcSize() { return { (float)createInfo.width, (float)createInfo.height }; }
@@ -44,12 +143,59 @@ public:
 	virtual void LoadSubmitContext(){};
 	virtual void ResetSubmitContext(){};
 
+	/**
+	 * Create the swapchain with XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT, which lets the runtime skip buffering it.
+	 * Such a swapchain can only be acquired once, so this must be set before the first call to Invoke, and
+	 * if the image needs to change later on then the compositor has to be replaced.
+	 */
+	void SetStaticImage(bool isStatic) { swapchainCreateFlags = isStatic ? XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT : 0; }
+	bool IsStaticImage() const { return (swapchainCreateFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) != 0; }
+
 protected:
 	XrSwapchain chain = XR_NULL_HANDLE;
 
+	// Flags to pass in when creating a swapchain
+	XrSwapchainCreateFlags swapchainCreateFlags = 0;
+
 	// The request used to create the current swapchain. This can be used to check if the swapchain needs recreating.
 	XrSwapchainCreateInfo createInfo{};
 
+	// The swapchain that depth buffers are copied into by InvokeDepth, and the request used to create it
+	XrSwapchain depthChain = XR_NULL_HANDLE;
+	XrSwapchainCreateInfo depthCreateInfo{};
+
+	/**
+	 * (Re)create depthChain with the given size and format. Returns false if the runtime doesn't support
+	 * the format, in which case depthChain is left unchanged.
+	 */
+	bool CreateDepthSwapChain(uint32_t width, uint32_t height, int64_t format);
+
+	// The zeroed motion vector swapchain used by InvokeSpaceWarp, which is the same size as depthChain
+	XrSwapchain motionVectorChain = XR_NULL_HANDLE;
+	XrSwapchainCreateInfo motionVectorCreateInfo{};
+
+	/**
+	 * The format to use for motion vectors, or zero if they're not supported. This must have a signed
+	 * 16-bit float component for at least red and green.
+	 */
+	virtual int64_t GetMotionVectorFormat() { return 0; }
+
+	// Fill the newly-created, static motionVectorChain with zeros
+	virtual void ClearMotionVectors() {}
+
+	/**
+	 * Work out which parts of a swapchain image InvokeRaw has to upload, after it's been acquired. Each image in
+	 * the swapchain is written in turn, so an image needs everything that changed since it was last written, not
+	 * just what changed in this call. changed is null if the whole image changed, and a new swapchain starts out
+	 * with all its images out of date.
+	 */
+	std::vector<CompositorRect> TakeRawUploadRects(uint32_t imageIndex, uint32_t imageCount, const CompositorRect* changed, uint32_t changedCount);
+
+	// The swapchain TakeRawUploadRects is tracking (and its size), and the parts of each of its images that are out of date
+	XrSwapchain rawTrackedChain = XR_NULL_HANDLE;
+	CompositorRect rawTrackedSize;
+	std::vector<std::vector<CompositorRect>> rawStaleRects;
+
 	// The format specified by the game when creating the swapchain. This is used for verifying the format hasn't changed, since
 	// we do fiddle with it a bit to get the SRGB stuff done correctly.
 	int64_t createInfoFormat;
@@ -103,6 +103,18 @@ ID3D11RenderTargetView* d3d_make_rtv(ID3D11Device* d3d_device, XrBaseInStructure
 DX11Compositor::DX11Compositor(ID3D11Texture2D* initial)
 {
 	initial->GetDevice(&device);
+	Init();
+}
+
+DX11Compositor::DX11Compositor(ID3D11Device* device)
+    : device(device)
+{
+	device->AddRef();
+	Init();
+}
+
+void DX11Compositor::Init()
+{
 	device->GetImmediateContext(&context);
 
 	// Shaders for inverting copy
@@ -143,6 +155,9 @@ DX11Compositor::~DX11Compositor()
 
 	resolvedMSAATextures.clear();
 
+	if (rawUploadTexture)
+		rawUploadTexture->Release();
+
 	context->Release();
 	device->Release();
 }
@@ -231,6 +246,7 @@ void DX11Compositor::CheckCreateSwapChain(const vr::Texture_t* texture, const vr
 		// Make eye render buffer
 		desc = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
 		// TODO desc.Type = cube ? ovrTexture_Cube : ovrTexture_2D;
+		desc.createFlags = swapchainCreateFlags;
 		desc.faceCount = cube ? 6 : 1;
 		desc.width = srcDesc.Width;
 		desc.height = srcDesc.Height;
@@ -255,10 +271,13 @@ void DX11Compositor::CheckCreateSwapChain(const vr::Texture_t* texture, const vr
 
 		OOVR_FALSE_ABORT(imageCount == imagesHandles.size());
 
-		swapchain_rtvs.resize(imageCount, nullptr);
+		// The render targets are only used to draw flipped 2D images, which cubemaps never are
+		if (!cube) {
+			swapchain_rtvs.resize(imageCount, nullptr);
 
-		for (uint32_t i = 0; i < imageCount; i++) {
-			swapchain_rtvs[i] = d3d_make_rtv(device, (XrBaseInStructure&)imagesHandles[i], type);
+			for (uint32_t i = 0; i < imageCount; i++) {
+				swapchain_rtvs[i] = d3d_make_rtv(device, (XrBaseInStructure&)imagesHandles[i], type);
+			}
 		}
 
 		if (srcDesc.SampleDesc.Count > 1) {
@@ -326,7 +345,7 @@ void DX11Compositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBou
 	sourceRegion.back = 1;
 
 	// Bounds describe an inverted image so copy texture using pixel shader inverting on copy
-	if (bounds && bounds->vMin > bounds->vMax && oovr_global_configuration.InvertUsingShaders() && !swapchain_rtvs.empty()) {
+	if (bounds && bounds->vMin > bounds->vMax && oovr_global_configuration->InvertUsingShaders() && !swapchain_rtvs.empty()) {
 		auto* src = (ID3D11Texture2D*)texture->handle;
 
 		OOVR_FAILED_DX_ABORT(device->CreateShaderResourceView(src, nullptr, &quad_texture_view));
@@ -400,47 +419,92 @@ void DX11Compositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBou
 	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
 }
 
-void DX11Compositor::InvokeCubemap(const vr::Texture_t* textures)
+bool DX11Compositor::InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed, uint32_t changedCount)
 {
-	CheckCreateSwapChain(&textures[0], nullptr, true);
+	// Static swapchains can only be written once, so every new image needs a new swapchain
+	if (IsStaticImage() && chain) {
+		OOVR_FAILED_XR_ABORT(xrDestroySwapchain(chain));
+		chain = XR_NULL_HANDLE;
+	}
 
-#ifdef OC_XR_PORT
-	ID3D11Texture2D* tex = nullptr;
-	ERR("TODO cubemap");
-#else
-	int currentIndex = 0;
-	OOVR_FAILED_OVR_ABORT(ovr_GetTextureSwapChainCurrentIndex(OVSS, chain, &currentIndex));
+	// Keep the upload texture around between images, since raw overlays are usually updated at the same size
+	if (rawUploadTexture) {
+		D3D11_TEXTURE2D_DESC oldDesc;
+		rawUploadTexture->GetDesc(&oldDesc);
+		if (oldDesc.Width != width || oldDesc.Height != height) {
+			rawUploadTexture->Release();
+			rawUploadTexture = nullptr;
+		}
+	}
 
-	OOVR_FAILED_OVR_ABORT(ovr_GetTextureSwapChainBufferDX(OVSS, chain, currentIndex, IID_PPV_ARGS(&tex)));
-#endif
+	// A new upload texture has nothing in it yet, so the whole image has to go in
+	if (!rawUploadTexture) {
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		OOVR_FAILED_DX_ABORT(device->CreateTexture2D(&desc, nullptr, &rawUploadTexture));
+		changed = nullptr;
+	}
+
+	// The upload texture always holds the whole image, so only what changed has to come from system memory. The GPU
+	// then copies all of it into the swapchain, which keeps every swapchain image current.
+	CompositorRect whole = { 0, 0, width, height };
+	if (!changed) {
+		changed = &whole;
+		changedCount = 1;
+	}
+
+	for (uint32_t i = 0; i < changedCount; i++) {
+		CompositorRect rect = changed[i].ClampedTo(width, height);
+		if (rect.IsEmpty())
+			continue;
 
-	ID3D11Texture2D* faceSrc;
+		D3D11_BOX box = { rect.x, rect.y, 0, rect.x + rect.width, rect.y + rect.height, 1 };
+		const uint8_t* start = (const uint8_t*)pixels + ((size_t)rect.y * width + rect.x) * 4;
+		context->UpdateSubresource(rawUploadTexture, 0, &box, start, width * 4, 0);
+	}
+
+	vr::Texture_t texture = { rawUploadTexture, vr::TextureType_DirectX, vr::ColorSpace_Gamma };
+	Invoke(&texture, nullptr);
+
+	return true;
+}
+
+void DX11Compositor::InvokeCubemap(const vr::Texture_t* textures)
+{
+	CheckCreateSwapChain(&textures[0], nullptr, true);
 
-	// Front
-	faceSrc = (ID3D11Texture2D*)textures[0].handle;
-	context->CopySubresourceRegion(tex, 5, 0, 0, 0, faceSrc, 0, nullptr);
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex = 0;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(chain, &acquireInfo, &currentIndex));
 
-	// Back
-	faceSrc = (ID3D11Texture2D*)textures[1].handle;
-	context->CopySubresourceRegion(tex, 4, 0, 0, 0, faceSrc, 0, nullptr);
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	waitInfo.timeout = 500000000; // time out in nano seconds - 500ms
+	XrResult res;
+	OOVR_FAILED_XR_ABORT(res = xrWaitSwapchainImage(chain, &waitInfo));
 
-	// Left
-	faceSrc = (ID3D11Texture2D*)textures[2].handle;
-	context->CopySubresourceRegion(tex, 0, 0, 0, 0, faceSrc, 0, nullptr);
+	if (res == XR_TIMEOUT_EXPIRED)
+		OOVR_ABORTF("xrWaitSwapchainImage timeout");
 
-	// Right
-	faceSrc = (ID3D11Texture2D*)textures[3].handle;
-	context->CopySubresourceRegion(tex, 1, 0, 0, 0, faceSrc, 0, nullptr);
+	ID3D11Texture2D* tex = imagesHandles[currentIndex].texture;
 
-	// Top
-	faceSrc = (ID3D11Texture2D*)textures[4].handle;
-	context->CopySubresourceRegion(tex, 2, 0, 0, 0, faceSrc, 0, nullptr);
+	// The swapchain is square, so only copy the top-left corner of non-square faces
+	D3D11_BOX sourceRegion = { 0, 0, 0, createInfo.width, createInfo.height, 1 };
 
-	// Bottom
-	faceSrc = (ID3D11Texture2D*)textures[5].handle;
-	context->CopySubresourceRegion(tex, 3, 0, 0, 0, faceSrc, 0, nullptr);
+	for (int i = 0; i < 6; i++) {
+		auto* faceSrc = (ID3D11Texture2D*)textures[i].handle;
+		UINT dstSubresource = D3D11CalcSubresource(0, CUBEMAP_FACE_INDICES[i], createInfo.mipCount);
+		context->CopySubresourceRegion(tex, dstSubresource, 0, 0, 0, faceSrc, 0, &sourceRegion);
+	}
 
-	tex->Release();
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
 }
 
 void DX11Compositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* ptrBounds,
@@ -459,7 +523,7 @@ void DX11Compositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::
 	if (ptrBounds) {
 		vr::VRTextureBounds_t bounds = *ptrBounds;
 
-		if (bounds.vMin > bounds.vMax && !oovr_global_configuration.InvertUsingShaders()) {
+		if (bounds.vMin > bounds.vMax && !oovr_global_configuration->InvertUsingShaders()) {
 			std::swap(layer.fov.angleUp, layer.fov.angleDown);
 			std::swap(bounds.vMin, bounds.vMax);
 		}
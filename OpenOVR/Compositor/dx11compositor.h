@@ -6,6 +6,9 @@ class DX11Compositor : public Compositor {
 public:
 	DX11Compositor(ID3D11Texture2D* td);
 
+	// Used for compositors that only ever upload images from system memory, where there's no texture to start with
+	explicit DX11Compositor(ID3D11Device* device);
+
 	virtual ~DX11Compositor() override;
 
 	// Override
@@ -14,12 +17,16 @@ public:
 	virtual void InvokeCubemap(const vr::Texture_t* textures) override;
 	virtual bool SupportsCubemap() override { return true; }
 
+	virtual bool InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed = nullptr, uint32_t changedCount = 0) override;
+
 	virtual void Invoke(XruEye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds,
 	    vr::EVRSubmitFlags submitFlags, XrCompositionLayerProjectionView& viewport) override;
 
 	ID3D11Device* GetDevice() { return device; }
 
 protected:
+	void Init();
+
 	void CheckCreateSwapChain(const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds, bool cube);
 
 	void ThrowIfFailed(HRESULT test);
@@ -38,6 +45,9 @@ protected:
 	std::vector<ID3D11RenderTargetView*> swapchain_rtvs;
 	std::vector<ID3D11Texture2D*> resolvedMSAATextures;
 
+	// Texture that InvokeRaw keeps the whole image in, and copies into the swapchain from
+	ID3D11Texture2D* rawUploadTexture = nullptr;
+
 	struct DxgiFormatInfo {
 		/// The different versions of this format, set to DXGI_FORMAT_UNKNOWN if absent.
 		/// Both the SRGB and linear formats should be UNORM.
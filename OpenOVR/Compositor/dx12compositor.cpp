@@ -120,6 +120,7 @@ void DX12Compositor::CheckCreateSwapChain(const vr::Texture_t* texture, const vr
 		// Make eye render buffer
 		desc = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
 		// TODO desc.Type = cube ? ovrTexture_Cube : ovrTexture_2D;
+		desc.createFlags = swapchainCreateFlags;
 		desc.faceCount = cube ? 6 : 1;
 		desc.width = srcDesc.Width;
 		desc.height = srcDesc.Height;
@@ -264,7 +265,7 @@ void DX12Compositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::
 	if (ptrBounds) {
 		vr::VRTextureBounds_t bounds = *ptrBounds;
 
-		if (bounds.vMin > bounds.vMax && !oovr_global_configuration.InvertUsingShaders()) {
+		if (bounds.vMin > bounds.vMax && !oovr_global_configuration->InvertUsingShaders()) {
 			std::swap(layer.fov.angleUp, layer.fov.angleDown);
 			std::swap(bounds.vMin, bounds.vMax);
 		}
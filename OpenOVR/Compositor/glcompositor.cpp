@@ -16,18 +16,72 @@
 #ifdef SUPPORT_GL
 
 #include <algorithm>
+#include <chrono>
 #include <string>
+#include <thread>
 
 // On Linux these seem to already be defined
 #ifdef _WIN32
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_FRAMEBUFFER_SRGB 0x8DB9
+
 typedef void(APIENTRY* PFNGLGETTEXTURELEVELPARAMETERIVPROC)(GLuint texture, GLint level, GLenum pname, GLint* params);
 typedef void(APIENTRY* PFNGLCOPYIMAGESUBDATAPROC)(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
     GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth);
+typedef void(APIENTRY* PFNGLGENBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void(APIENTRY* PFNGLDELETEBUFFERSPROC)(GLsizei n, const GLuint* buffers);
+typedef void(APIENTRY* PFNGLBINDBUFFERPROC)(GLenum target, GLuint buffer);
+typedef void(APIENTRY* PFNGLBUFFERDATAPROC)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void*(APIENTRY* PFNGLMAPBUFFERRANGEPROC)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean(APIENTRY* PFNGLUNMAPBUFFERPROC)(GLenum target);
+typedef GLsync(APIENTRY* PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef GLenum(APIENTRY* PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void(APIENTRY* PFNGLDELETESYNCPROC)(GLsync sync);
+typedef void(APIENTRY* PFNGLGENFRAMEBUFFERSPROC)(GLsizei n, GLuint* framebuffers);
+typedef void(APIENTRY* PFNGLDELETEFRAMEBUFFERSPROC)(GLsizei n, const GLuint* framebuffers);
+typedef void(APIENTRY* PFNGLBINDFRAMEBUFFERPROC)(GLenum target, GLuint framebuffer);
+typedef void(APIENTRY* PFNGLFRAMEBUFFERTEXTURE2DPROC)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef void(APIENTRY* PFNGLBLITFRAMEBUFFERPROC)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+    GLbitfield mask, GLenum filter);
 #endif
 
 static PFNGLGETTEXTURELEVELPARAMETERIVPROC glGetTextureLevelParameteriv = nullptr;
 static PFNGLCOPYIMAGESUBDATAPROC glCopyImageSubData = nullptr;
 
+// Only used for screenshots, so these are optional
+static PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
+static PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
+static PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
+static PFNGLBUFFERDATAPROC glBufferData = nullptr;
+static PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+static PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+static PFNGLFENCESYNCPROC glFenceSync = nullptr;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+static PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+
+// Only used for flipped or converted submits, so these are optional too
+static PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
+static PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = nullptr;
+static PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
+static PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = nullptr;
+static PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer = nullptr;
+
 static void* getGlProcAddr(const char* name)
 {
 #ifdef _WIN32
@@ -47,20 +101,219 @@ GLCompositor::GLCompositor(GLuint initialTexture)
 
 		if (!glCopyImageSubData)
 			OOVR_ABORT("Could not get function glCopyImageSubData");
+
+		glGenBuffers = (PFNGLGENBUFFERSPROC)getGlProcAddr("glGenBuffers");
+		glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)getGlProcAddr("glDeleteBuffers");
+		glBindBuffer = (PFNGLBINDBUFFERPROC)getGlProcAddr("glBindBuffer");
+		glBufferData = (PFNGLBUFFERDATAPROC)getGlProcAddr("glBufferData");
+		glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)getGlProcAddr("glMapBufferRange");
+		glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)getGlProcAddr("glUnmapBuffer");
+		glFenceSync = (PFNGLFENCESYNCPROC)getGlProcAddr("glFenceSync");
+		glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)getGlProcAddr("glClientWaitSync");
+		glDeleteSync = (PFNGLDELETESYNCPROC)getGlProcAddr("glDeleteSync");
+
+		glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)getGlProcAddr("glGenFramebuffers");
+		glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)getGlProcAddr("glDeleteFramebuffers");
+		glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)getGlProcAddr("glBindFramebuffer");
+		glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)getGlProcAddr("glFramebufferTexture2D");
+		glBlitFramebuffer = (PFNGLBLITFRAMEBUFFERPROC)getGlProcAddr("glBlitFramebuffer");
+	}
+}
+
+GLCompositor::~GLCompositor()
+{
+	// A readback that was never polled won't be released by anyone else
+	if (readbackInFlight)
+		readbackInFlight->inUse = false;
+
+	for (const std::unique_ptr<ReadbackSlot>& slot : readbackSlots) {
+		// The screenshot writer should be done with the slot shortly
+		while (slot->inUse)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		if (slot->fence)
+			glDeleteSync((GLsync)slot->fence);
+
+		if (slot->mapped) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		glDeleteBuffers(1, &slot->buffer);
+	}
+
+	if (blitFramebuffers[0])
+		glDeleteFramebuffers(2, blitFramebuffers);
+}
+
+bool GLCompositor::SupportsBlit()
+{
+	return glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer && glFramebufferTexture2D && glBlitFramebuffer;
+}
+
+bool GLCompositor::BlitImage(GLuint src, GLuint dst, const XrRect2Di& srcRect, bool flipY, bool srgbEncode, bool depth)
+{
+	if (!SupportsBlit())
+		return false;
+
+	if (!blitFramebuffers[0])
+		glGenFramebuffers(2, blitFramebuffers);
+
+	// This runs in the middle of the app's frame, so put back anything we change
+	GLint oldReadFramebuffer, oldDrawFramebuffer;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &oldReadFramebuffer);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldDrawFramebuffer);
+	GLboolean oldSrgb = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+	GLboolean oldScissor = glIsEnabled(GL_SCISSOR_TEST);
+
+	// A framebuffer with only a depth attachment also needs its colour buffers turning off to be complete. These
+	// are our own framebuffers, so that doesn't affect the app.
+	GLenum attachment = depth ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0;
+	GLenum colourBuffer = depth ? GL_NONE : GL_COLOR_ATTACHMENT0;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, blitFramebuffers[0]);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, src, 0);
+	glReadBuffer(colourBuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, blitFramebuffers[1]);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, dst, 0);
+	glDrawBuffer(colourBuffer);
+
+	// The scissor test is the only bit of the app's state (other than sRGB encoding) that affects blits
+	if (srgbEncode)
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	else
+		glDisable(GL_FRAMEBUFFER_SRGB);
+	glDisable(GL_SCISSOR_TEST);
+
+	// Swapping the destination's Y coordinates flips the image
+	GLint width = srcRect.extent.width;
+	GLint height = srcRect.extent.height;
+	glBlitFramebuffer(
+	    srcRect.offset.x, srcRect.offset.y, srcRect.offset.x + width, srcRect.offset.y + height,
+	    0, flipY ? height : 0, width, flipY ? 0 : height,
+	    depth ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	// Detach the textures, so we don't keep the app's texture referenced after it's deleted
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, oldReadFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, oldDrawFramebuffer);
+	if (oldSrgb)
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	else
+		glDisable(GL_FRAMEBUFFER_SRGB);
+	if (oldScissor)
+		glEnable(GL_SCISSOR_TEST);
+
+	return true;
+}
+
+bool GLCompositor::SupportsReadback()
+{
+	return glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData && glMapBufferRange && glUnmapBuffer
+	    && glFenceSync && glClientWaitSync && glDeleteSync;
+}
+
+void GLCompositor::RecordReadback(GLuint image)
+{
+	ReadbackSlot* slot = nullptr;
+	for (const std::unique_ptr<ReadbackSlot>& candidate : readbackSlots) {
+		if (!candidate->inUse) {
+			slot = candidate.get();
+			break;
+		}
+	}
+
+	if (!slot) {
+		readbackSlots.push_back(std::make_unique<ReadbackSlot>());
+		slot = readbackSlots.back().get();
+		glGenBuffers(1, &slot->buffer);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+
+	// The screenshot writer is done with the old contents, so the buffer can be unmapped for the GPU to use
+	if (slot->mapped) {
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		slot->mapped = false;
+	}
+
+	uint32_t size = createInfo.width * createInfo.height * 4;
+	if (size > slot->size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot->size = size;
+	}
+
+	slot->width = createInfo.width;
+	slot->height = createInfo.height;
+	slot->inUse = true;
+
+	// The driver converts whatever format the swapchain uses to RGBA8 for us. Since a pack buffer is bound, this
+	// only schedules the copy rather than waiting for it.
+	GLint oldAlignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D, image);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, oldAlignment);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackInFlight = slot;
+}
+
+bool GLCompositor::PollReadback(CompositorReadback& readback)
+{
+	if (!readbackInFlight)
+		return false;
+
+	ReadbackSlot* slot = readbackInFlight;
+	GLenum status = glClientWaitSync((GLsync)slot->fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return false;
+
+	glDeleteSync((GLsync)slot->fence);
+	slot->fence = nullptr;
+	readbackInFlight = nullptr;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+	void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot->width * slot->height * 4, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback = {};
+	if (!pixels) {
+		OOVR_LOG("Failed to map OpenGL screenshot buffer");
+		slot->inUse = false;
+		return true;
 	}
+	slot->mapped = true;
+
+	readback.width = slot->width;
+	readback.height = slot->height;
+	readback.rowPitch = slot->width * 4;
+	readback.bottomUp = true;
+	readback.pixels = (const uint8_t*)pixels;
+	readback.release = [slot]() { slot->inUse = false; };
+
+	return true;
 }
 
-void GLCompositor::ReadSwapchainImages()
+void GLCompositor::ReadSwapchainImages(XrSwapchain swapchain, std::vector<GLuint>& out)
 {
 	// Enumerate all the swapchain images
 	uint32_t imageCount;
-	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, 0, &imageCount, nullptr));
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
 	auto handles = std::vector<XrSwapchainImageOpenGLKHR>(imageCount, { XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR });
-	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, imageCount, &imageCount, (XrSwapchainImageBaseHeader*)handles.data()));
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(swapchain, imageCount, &imageCount, (XrSwapchainImageBaseHeader*)handles.data()));
 
-	images.clear();
+	out.clear();
 	for (const XrSwapchainImageOpenGLKHR& img : handles) {
-		images.push_back(img.image);
+		out.push_back(img.image);
 	}
 }
 
@@ -70,6 +323,12 @@ void GLCompositor::ReadSwapchainImages()
 
 #if defined(SUPPORT_GL) || defined(SUPPORT_GLES)
 
+GLBaseCompositor::~GLBaseCompositor()
+{
+	if (mirrorImage)
+		glDeleteTextures(1, &mirrorImage);
+}
+
 void GLBaseCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds)
 {
 	// Clear any pre-existing OpenGL errors
@@ -88,17 +347,14 @@ void GLBaseCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureB
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	XrRect2Di viewport;
+	bool flipped = false;
 	if (bounds) {
 		vr::VRTextureBounds_t newBounds = *bounds;
 		if (newBounds.vMin > newBounds.vMax) {
 			float newMax = newBounds.vMin;
 			newBounds.vMin = newBounds.vMax;
 			newBounds.vMax = newMax;
-
-			// Vertical flip not yet implemented!
-			XR_STUBBED(); // submitVerticallyFlipped = true;
-		} else {
-			// submitVerticallyFlipped = false;
+			flipped = true;
 		}
 
 		viewport.offset.x = (int)(newBounds.uMin * (float)inputWidth);
@@ -109,8 +365,6 @@ void GLBaseCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureB
 		viewport.offset.x = viewport.offset.y = 0;
 		viewport.extent.width = inputWidth;
 		viewport.extent.height = inputHeight;
-
-		// submitVerticallyFlipped = false;
 	}
 
 	CheckCreateSwapChain(viewport.extent.width, viewport.extent.height, texture->eColorSpace, rawFormat);
@@ -133,13 +387,56 @@ void GLBaseCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureB
 		OOVR_FAILED_XR_ABORT(res = xrWaitSwapchainImage(chain, &waitInfo));
 	} while (res == XR_TIMEOUT_EXPIRED);
 
-	// Actually copy the image across
+	// Actually copy the image across. Flipped images, and ones the runtime doesn't support the format of, need to be
+	// blitted instead. That normally converts the image between linear and sRGB, but RGBA8 images with gamma-encoded
+	// data are put in an sRGB swapchain as-is (see NormaliseFormat), so they mustn't be encoded again.
 	GLuint dst = images.at(currentIndex);
-	glCopyImageSubData(
-	    src, GL_TEXTURE_2D, 0, viewport.offset.x, viewport.offset.y, 0, // 0 == no mipmapping, next three are xyz
-	    dst, GL_TEXTURE_2D, 0, 0, 0, 0, // Same as above but for the destination
-	    (int)createInfo.width, (int)createInfo.height, 1 // Region of the output texture to copy into (in this case, everything)
-	);
+	bool converted = createInfo.format != NormaliseFormat(texture->eColorSpace, rawFormat);
+	bool srgbEncode = !(texture->eColorSpace == vr::ColorSpace_Gamma && (rawFormat == GL_RGBA8 || rawFormat == GL_RGBA));
+
+	if (!(flipped || converted) || !BlitImage(src, dst, viewport, flipped, srgbEncode, false)) {
+		if (flipped)
+			OOVR_LOG_ONCE("Can't flip OpenGL images on this platform, submitting them upside-down");
+
+		glCopyImageSubData(
+		    src, GL_TEXTURE_2D, 0, viewport.offset.x, viewport.offset.y, 0, // 0 == no mipmapping, next three are xyz
+		    dst, GL_TEXTURE_2D, 0, 0, 0, 0, // Same as above but for the destination
+		    (int)createInfo.width, (int)createInfo.height, 1 // Region of the output texture to copy into (in this case, everything)
+		);
+	}
+
+	if (readbackRequested) {
+		readbackRequested = false;
+		RecordReadback(dst);
+	}
+
+	if (mirrorEnabled) {
+		if (!mirrorImage || mirrorWidth != createInfo.width || mirrorHeight != createInfo.height || mirrorFormat != createInfo.format) {
+			if (mirrorImage)
+				glDeleteTextures(1, &mirrorImage);
+
+			// Use the swapchain's format, so the copy is always allowed and the colours match what's on the headset
+			glGenTextures(1, &mirrorImage);
+			glBindTexture(GL_TEXTURE_2D, mirrorImage);
+#ifdef SUPPORT_GLES
+			glTexStorage2D(GL_TEXTURE_2D, 1, (GLenum)createInfo.format, (GLsizei)createInfo.width, (GLsizei)createInfo.height);
+#else
+			glTexImage2D(GL_TEXTURE_2D, 0, (GLint)createInfo.format, (GLsizei)createInfo.width, (GLsizei)createInfo.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+#endif
+			// There's only one mip level, so the default mipmapped filter would leave the texture incomplete
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			mirrorWidth = createInfo.width;
+			mirrorHeight = createInfo.height;
+			mirrorFormat = createInfo.format;
+		}
+
+		glCopyImageSubData(
+		    dst, GL_TEXTURE_2D, 0, 0, 0, 0,
+		    mirrorImage, GL_TEXTURE_2D, 0, 0, 0, 0,
+		    (int)createInfo.width, (int)createInfo.height, 1);
+	}
 
 	// Abort if there was an OpenGL error
 	GLenum err = glGetError();
@@ -160,8 +457,6 @@ void GLBaseCompositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr
 	// Copy the texture over
 	Invoke(texture, ptrBounds);
 
-	// TODO the image is vertically flipped; fix it
-
 	// Set the viewport up
 	// TODO deduplicate with dx11compositor, and use for all compositors
 	XrSwapchainSubImage& subImage = layer.subImage;
@@ -176,11 +471,164 @@ void GLBaseCompositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr
 	viewport.extent.height = createInfo.height;
 }
 
+bool GLBaseCompositor::InvokeDepth(const vr::VRTextureDepthInfo_t& depth, const vr::VRTextureBounds_t* bounds, XrCompositionLayerDepthInfoKHR& depthInfo)
+{
+	auto src = (GLuint)(intptr_t)depth.handle;
+	if (!src || !chain)
+		return false;
+
+	GLsizei inputWidth, inputHeight, rawFormat;
+	glBindTexture(GL_TEXTURE_2D, src);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &inputWidth);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &inputHeight);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &rawFormat);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Crop and flip the depth the same way as the colour image, so they line up in the swapchains
+	XrRect2Di srcRect = { { 0, 0 }, { (int32_t)createInfo.width, (int32_t)createInfo.height } };
+	bool flipped = false;
+	if (bounds) {
+		srcRect.offset.x = (int)(std::min(bounds->uMin, bounds->uMax) * (float)inputWidth);
+		srcRect.offset.y = (int)(std::min(bounds->vMin, bounds->vMax) * (float)inputHeight);
+		flipped = bounds->vMin > bounds->vMax;
+	}
+
+	if (srcRect.offset.x + (int)createInfo.width > inputWidth || srcRect.offset.y + (int)createInfo.height > inputHeight) {
+		OOVR_LOG_ONCE("Depth texture is smaller than the colour texture, submitting without depth");
+		return false;
+	}
+
+	// A copied depth image that wasn't flipped with the colour image would be worse than no depth at all
+	if (flipped && !SupportsBlit()) {
+		OOVR_LOG_ONCE("Can't flip the depth texture on this driver, submitting without depth");
+		return false;
+	}
+
+	if (!depthChain || depthCreateInfo.width != createInfo.width || depthCreateInfo.height != createInfo.height || depthCreateInfo.format != rawFormat) {
+		if (!CreateDepthSwapChain(createInfo.width, createInfo.height, rawFormat))
+			return false;
+		ReadSwapchainImages(depthChain, depthImages);
+	}
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex = 0;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(depthChain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	XrResult res;
+	do {
+		OOVR_FAILED_XR_ABORT(res = xrWaitSwapchainImage(depthChain, &waitInfo));
+	} while (res == XR_TIMEOUT_EXPIRED);
+
+	GLuint dst = depthImages.at(currentIndex);
+	if (flipped) {
+		BlitImage(src, dst, srcRect, true, false, true);
+	} else {
+		glCopyImageSubData(
+		    src, GL_TEXTURE_2D, 0, srcRect.offset.x, srcRect.offset.y, 0,
+		    dst, GL_TEXTURE_2D, 0, 0, 0, 0,
+		    (int)createInfo.width, (int)createInfo.height, 1);
+	}
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(depthChain, &releaseInfo));
+
+	depthInfo.subImage.swapchain = depthChain;
+	depthInfo.subImage.imageArrayIndex = 0;
+	depthInfo.subImage.imageRect.offset = { 0, 0 };
+	depthInfo.subImage.imageRect.extent = { (int32_t)createInfo.width, (int32_t)createInfo.height };
+
+	return true;
+}
+
+int64_t GLBaseCompositor::GetMotionVectorFormat()
+{
+	return 0x881A; // GL_RGBA16F
+}
+
+void GLBaseCompositor::ClearMotionVectors()
+{
+	std::vector<GLuint> motionVectorImages;
+	ReadSwapchainImages(motionVectorChain, motionVectorImages);
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex = 0;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(motionVectorChain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	XrResult res;
+	do {
+		OOVR_FAILED_XR_ABORT(res = xrWaitSwapchainImage(motionVectorChain, &waitInfo));
+	} while (res == XR_TIMEOUT_EXPIRED);
+
+	// This only happens once per swapchain, so just upload the zeros rather than setting up a framebuffer to clear it
+	std::vector<float> zeros((size_t)motionVectorCreateInfo.width * motionVectorCreateInfo.height * 4);
+	glBindTexture(GL_TEXTURE_2D, motionVectorImages.at(currentIndex));
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)motionVectorCreateInfo.width, (GLsizei)motionVectorCreateInfo.height, GL_RGBA, GL_FLOAT, zeros.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(motionVectorChain, &releaseInfo));
+}
+
 void GLBaseCompositor::InvokeCubemap(const vr::Texture_t* textures)
 {
 	OOVR_ABORT("GLCompositor::InvokeCubemap: Not yet supported!");
 }
 
+bool GLBaseCompositor::InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed, uint32_t changedCount)
+{
+	// Static swapchains can only be written once, so every new image needs a new swapchain
+	if (IsStaticImage() && chain) {
+		OOVR_FAILED_XR_ABORT(xrDestroySwapchain(chain));
+		chain = XR_NULL_HANDLE;
+		createInfo = {};
+	}
+
+	// Clear any pre-existing OpenGL errors
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	CheckCreateSwapChain((int)width, (int)height, vr::ColorSpace_Gamma, GL_RGBA8);
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex = 0;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(chain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	XrResult res;
+	do {
+		OOVR_FAILED_XR_ABORT(res = xrWaitSwapchainImage(chain, &waitInfo));
+	} while (res == XR_TIMEOUT_EXPIRED);
+
+	// The driver does the staging for us here. Note this assumes the app doesn't leave a pixel unpack
+	// buffer bound, though the alignment and row length are restored in case it's changed those.
+	GLint oldAlignment, oldRowLength;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+	glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldRowLength);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)width);
+
+	// The row length lets the driver pick the out-of-date rectangles straight out of the whole image
+	glBindTexture(GL_TEXTURE_2D, images.at(currentIndex));
+	for (const CompositorRect& rect : TakeRawUploadRects(currentIndex, (uint32_t)images.size(), changed, changedCount)) {
+		const uint8_t* start = (const uint8_t*)pixels + ((size_t)rect.y * width + rect.x) * 4;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)rect.x, (GLint)rect.y, (GLsizei)rect.width, (GLsizei)rect.height, GL_RGBA, GL_UNSIGNED_BYTE, start);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, oldRowLength);
+
+	if (glGetError() != GL_NO_ERROR)
+		OOVR_LOG_ONCE("WARNING: OpenGL raw overlay upload failed!");
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
+
+	return true;
+}
+
 void GLBaseCompositor::CheckCreateSwapChain(int width, int height, vr::EColorSpace c_space, GLsizei rawformat)
 {
 	// See the comment for NormaliseFormat as to why we're doing this
@@ -188,6 +636,7 @@ void GLBaseCompositor::CheckCreateSwapChain(int width, int height, vr::EColorSpa
 
 	// Build out the info describing the swapchain we need
 	XrSwapchainCreateInfo desc = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+	desc.createFlags = swapchainCreateFlags;
 	desc.faceCount = 1;
 	desc.width = width;
 	desc.height = height;
@@ -195,12 +644,17 @@ void GLBaseCompositor::CheckCreateSwapChain(int width, int height, vr::EColorSpa
 	desc.mipCount = 1; // TODO srcDesc.MipLevels;
 	desc.sampleCount = 1;
 	desc.arraySize = 1;
-	desc.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+	desc.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT; // Colour attachment for BlitImage
+
+	// If the swapchain had to use a different format (see below), compare against that instead
+	if (chain && format == chainWantedFormat)
+		desc.format = createInfo.format;
 
 	// If the format has changed (or this is the first call), continue on to create the swapchain
 	if (memcmp(&desc, &createInfo, sizeof(desc)) == 0) {
 		return;
 	}
+	desc.format = format;
 
 	OOVR_LOGF("Creating new OpenGL swapchain: %dx%d with format %d", width, height, format);
 
@@ -211,12 +665,29 @@ void GLBaseCompositor::CheckCreateSwapChain(int width, int height, vr::EColorSpa
 	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainFormats(xr_session.get(), formatCount, &formatCount, formats.data()));
 
 	if (std::count(formats.begin(), formats.end(), format) == 0) {
-		OOVR_LOG("Missing format for swapchain creation. Valid formats:");
-		for (int64_t f : formats) {
-			OOVR_LOGF("Valid format: %d", f);
+		// If we can, blit the image into a format the runtime does support instead
+		int64_t fallback = 0;
+		if (SupportsBlit()) {
+			for (int64_t candidate : { (int64_t)0x8C43 /* GL_SRGB8_ALPHA8 */, (int64_t)GL_RGBA8 }) {
+				if (std::count(formats.begin(), formats.end(), candidate) != 0) {
+					fallback = candidate;
+					break;
+				}
+			}
+		}
+
+		if (!fallback) {
+			OOVR_LOG("Missing format for swapchain creation. Valid formats:");
+			for (int64_t f : formats) {
+				OOVR_LOGF("Valid format: %d", f);
+			}
+			OOVR_ABORTF("The runtime does not support the OpenGL format %d", format);
 		}
-		OOVR_ABORTF("The runtime does not support the OpenGL format %d", format);
+
+		OOVR_LOGF("The runtime does not support the OpenGL format %d, converting to format %d", format, (int)fallback);
+		desc.format = fallback;
 	}
+	chainWantedFormat = format;
 
 	// Delete the old swapchain, if applicable
 	if (chain) {
@@ -229,7 +700,7 @@ void GLBaseCompositor::CheckCreateSwapChain(int width, int height, vr::EColorSpa
 	OOVR_FAILED_XR_ABORT(xrCreateSwapchain(xr_session.get(), &desc, &chain));
 
 	// Enumerate all the swapchain images
-	ReadSwapchainImages();
+	ReadSwapchainImages(chain, images);
 }
 
 GLuint GLBaseCompositor::NormaliseFormat(vr::EColorSpace c_space, GLsizei rawFormat)
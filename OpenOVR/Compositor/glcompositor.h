@@ -2,9 +2,12 @@
 
 #include "compositor.h"
 
+#include <atomic>
+
 class GLBaseCompositor : public Compositor {
 public:
 	explicit GLBaseCompositor() = default;
+	~GLBaseCompositor() override;
 
 	// Override
 	void Invoke(const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds) override;
@@ -14,11 +17,19 @@ public:
 
 	void InvokeCubemap(const vr::Texture_t* textures) override;
 
+	bool InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed = nullptr, uint32_t changedCount = 0) override;
+
+	bool SupportsMirror(vr::ETextureType api) override { return api == vr::TextureType_OpenGL; }
+	void EnableMirror() override { mirrorEnabled = true; }
+	uint64_t GetMirrorImage() override { return mirrorImage; }
+
+	bool InvokeDepth(const vr::VRTextureDepthInfo_t& depth, const vr::VRTextureBounds_t* bounds, XrCompositionLayerDepthInfoKHR& depthInfo) override;
+
 protected:
 	/**
-	 * Read the runtime-created swapchain names to [images] using the GL or GLES OpenXR structs.
+	 * Read the runtime-created texture names for a swapchain using the GL or GLES OpenXR structs.
 	 */
-	virtual void ReadSwapchainImages() = 0;
+	virtual void ReadSwapchainImages(XrSwapchain swapchain, std::vector<GLuint>& out) = 0;
 
 	void CheckCreateSwapChain(int width, int height, vr::EColorSpace c_space, GLsizei format);
 
@@ -29,17 +40,78 @@ protected:
 	 */
 	static GLuint NormaliseFormat(vr::EColorSpace c_space, GLsizei rawFormat);
 
-	GLuint fboId = 0;
+	/**
+	 * Start copying a swapchain image back to system memory for a screenshot, if readbackRequested is set. This is
+	 * called after the image is copied in Invoke, while it's still acquired.
+	 */
+	virtual void RecordReadback(GLuint image) {}
+
+	/**
+	 * Blit a region of the app's texture into a swapchain image, for the cases a plain copy can't handle: flipping
+	 * the image vertically, or converting it to a format the runtime supports. If srgbEncode is false the values are
+	 * written as-is, even into an sRGB image. With depth set, the textures' depth is blitted instead of their colour,
+	 * which needs both to have the same format. Returns false if blitting isn't supported, in which case the image
+	 * should be copied instead.
+	 */
+	virtual bool SupportsBlit() { return false; }
+	virtual bool BlitImage(GLuint src, GLuint dst, const XrRect2Di& srcRect, bool flipY, bool srgbEncode, bool depth) { return false; }
+
+	int64_t GetMotionVectorFormat() override;
+	void ClearMotionVectors() override;
+
+	bool readbackRequested = false;
+
+	// The texture the last submitted image is copied into for GetMirrorTextureGL, and the size and format it
+	// was created with
+	bool mirrorEnabled = false;
+	GLuint mirrorImage = 0;
+	uint32_t mirrorWidth = 0;
+	uint32_t mirrorHeight = 0;
+	int64_t mirrorFormat = 0;
+
+	// The normalised format the swapchain was last created for, which createInfo.format may differ from if the runtime
+	// doesn't support it
+	int64_t chainWantedFormat = 0;
 
 	std::vector<GLuint> images;
+	std::vector<GLuint> depthImages;
 };
 
 #ifdef SUPPORT_GL
 class GLCompositor : public GLBaseCompositor {
 public:
 	explicit GLCompositor(GLuint initialTexture);
+	~GLCompositor() override;
+
+	bool SupportsReadback() override;
+	void RequestReadback() override { readbackRequested = true; }
+	bool PollReadback(CompositorReadback& readback) override;
 
 protected:
-	void ReadSwapchainImages() override;
+	void ReadSwapchainImages(XrSwapchain swapchain, std::vector<GLuint>& out) override;
+	void RecordReadback(GLuint image) override;
+	bool SupportsBlit() override;
+	bool BlitImage(GLuint src, GLuint dst, const XrRect2Di& srcRect, bool flipY, bool srgbEncode, bool depth) override;
+
+private:
+	// A pixel pack buffer that an eye image is copied into for a screenshot. The buffer stays mapped while the
+	// screenshot writer is using it, and is unmapped when the slot is next reused.
+	struct ReadbackSlot {
+		GLuint buffer = 0;
+		uint32_t size = 0;
+		void* fence = nullptr; // A GLsync
+		bool mapped = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+
+		// Set from when the copy is recorded until the readback is released, possibly on another thread
+		std::atomic<bool> inUse = false;
+	};
+
+	std::vector<std::unique_ptr<ReadbackSlot>> readbackSlots;
+	ReadbackSlot* readbackInFlight = nullptr;
+
+	// The framebuffers the app's texture and the swapchain image are attached to for BlitImage
+	GLuint blitFramebuffers[2] = {};
 };
 #endif
@@ -11,17 +11,17 @@
 
 GLESCompositor::GLESCompositor() = default;
 
-void GLESCompositor::ReadSwapchainImages()
+void GLESCompositor::ReadSwapchainImages(XrSwapchain swapchain, std::vector<GLuint>& out)
 {
 	// Enumerate all the swapchain images
 	uint32_t imageCount;
-	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, 0, &imageCount, nullptr));
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
 	auto handles = std::vector<XrSwapchainImageOpenGLESKHR>(imageCount, { XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR });
-	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, imageCount, &imageCount, (XrSwapchainImageBaseHeader*)handles.data()));
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(swapchain, imageCount, &imageCount, (XrSwapchainImageBaseHeader*)handles.data()));
 
-	images.clear();
+	out.clear();
 	for (const XrSwapchainImageOpenGLESKHR& img : handles) {
-		images.push_back(img.image);
+		out.push_back(img.image);
 	}
 }
 
@@ -14,6 +14,11 @@
 
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
 #define ERR(msg)                                                                                                                                         \
 	do {                                                                                                                                                 \
 		std::string str = "Hit Vulkan-related error " + string(msg) + " at " __FILE__ ":" + std::to_string(__LINE__) + " func " + std::string(__func__); \
@@ -38,7 +43,8 @@ static enum VkFormat handle_colorspace_auto(enum VkFormat ovrFormat)
 		// Todo what games actually use these? and is color space always linear for these?
 		return ovrFormat;
 	default:
-		OOVR_ABORTF("Unsupported texture format used: %d", ovrFormat);
+		// If the runtime doesn't support this, it's converted when it's copied into the swapchain
+		return ovrFormat;
 	}
 }
 
@@ -59,7 +65,8 @@ static enum VkFormat handle_colorspace_gamma(enum VkFormat ovrFormat)
 		// Todo what games actually use these? and is color space always linear for these?
 		return ovrFormat;
 	default:
-		OOVR_ABORTF("Unsupported texture format used: %d", ovrFormat);
+		// If the runtime doesn't support this, it's converted when it's copied into the swapchain
+		return ovrFormat;
 	}
 }
 
@@ -80,7 +87,8 @@ static enum VkFormat handle_colorspace_linear(enum VkFormat ovrFormat)
 		// Todo what games actually use these? and is color space always linear for these?
 		return ovrFormat;
 	default:
-		OOVR_ABORTF("Unsupported texture format used: %d", ovrFormat);
+		// If the runtime doesn't support this, it's converted when it's copied into the swapchain
+		return ovrFormat;
 	}
 }
 
@@ -89,6 +97,7 @@ VkCompositor::VkCompositor(const vr::Texture_t* initialTexture)
 	auto* tex = (vr::VRVulkanTextureData_t*)initialTexture->handle;
 
 	appDevice = tex->m_pDevice;
+	appPhysicalDevice = tex->m_pPhysicalDevice;
 	appQueue = tex->m_pQueue;
 
 	VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
@@ -98,6 +107,40 @@ VkCompositor::VkCompositor(const vr::Texture_t* initialTexture)
 
 VkCompositor::~VkCompositor()
 {
+	// A readback that was never polled won't be released by anyone else
+	if (readbackInFlight)
+		readbackInFlight->inUse = false;
+
+	for (const std::unique_ptr<ReadbackSlot>& slot : readbackSlots) {
+		// The screenshot writer should be done with the slot shortly
+		while (slot->inUse)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		vkWaitForFences(appDevice, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(appDevice, slot->fence, nullptr);
+		vkUnmapMemory(appDevice, slot->memory);
+		vkDestroyBuffer(appDevice, slot->buffer, nullptr);
+		vkFreeMemory(appDevice, slot->memory, nullptr);
+	}
+
+	if (scratchImage) {
+		// The scratch image may still be in use by the last frame's copy
+		vkQueueWaitIdle(appQueue);
+		vkDestroyImage(appDevice, scratchImage, nullptr);
+		vkFreeMemory(appDevice, scratchMemory, nullptr);
+	}
+
+	if (rawUploadFence) {
+		vkWaitForFences(appDevice, 1, &rawUploadFence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(appDevice, rawUploadFence, nullptr);
+	}
+
+	if (rawStagingBuffer) {
+		vkUnmapMemory(appDevice, rawStagingMemory);
+		vkDestroyBuffer(appDevice, rawStagingBuffer, nullptr);
+		vkFreeMemory(appDevice, rawStagingMemory, nullptr);
+	}
+
 	// destroying command pool also frees command buffers
 	vkDestroyCommandPool(appDevice, appCommandPool, nullptr);
 }
@@ -115,23 +158,14 @@ void VkCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBound
 	// but it's simpler (and likely more performant) to just assume our app is sane.
 	OOVR_FALSE_ABORT(appQueue == tex->m_pQueue);
 
-	bool usable = chain != XR_NULL_HANDLE && CheckChainCompatible(*tex, createInfo, texture->eColorSpace);
+	bool usable = chain != XR_NULL_HANDLE && createInfo.faceCount == 1 && CheckChainCompatible(*tex, texture->eColorSpace);
 
 	if (!usable) {
 		OOVR_LOG("Generating new swap chain");
 
-		// First, delete the old chain if necessary
-		if (chain)
-			xrDestroySwapchain(chain);
-
-		// Free old command buffers if necessary
-		if (!appCommandBuffers.empty()) {
-			vkFreeCommandBuffers(appDevice, appCommandPool, appCommandBuffers.size(), appCommandBuffers.data());
-		}
-
 		// Make eye render buffer
 		createInfo = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
-		createInfo.createFlags = 0;
+		createInfo.createFlags = swapchainCreateFlags;
 		createInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
 		createInfo.faceCount = 1;
 		createInfo.width = tex->m_nWidth;
@@ -155,21 +189,15 @@ void VkCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBound
 		}
 		}
 
-		OOVR_FAILED_XR_ABORT(xrCreateSwapchain(xr_session.get(), &createInfo, &chain));
+		int64_t wantedFormat = createInfo.format;
+		createInfo.format = ChooseChainFormat((VkFormat)tex->m_nFormat, (VkFormat)wantedFormat, tex->m_nSampleCount);
 
-		uint32_t chainLength = 0;
-		OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, 0, &chainLength, nullptr));
-		swapchainImages.resize(chainLength);
-		for (XrSwapchainImageVulkanKHR& swapchainImage : swapchainImages)
-			swapchainImage.type = XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR;
-		OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, swapchainImages.size(), &chainLength, (XrSwapchainImageBaseHeader*)swapchainImages.data()));
+		CreateSwapChain();
 
-		appCommandBuffers.resize(chainLength);
-		VkCommandBufferAllocateInfo bufInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-		bufInfo.commandPool = appCommandPool;
-		bufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		bufInfo.commandBufferCount = chainLength;
-		OOVR_FAILED_VK_ABORT(vkAllocateCommandBuffers(appDevice, &bufInfo, appCommandBuffers.data()));
+		chainSourceFormat = (VkFormat)tex->m_nFormat;
+		chainColourSpace = texture->eColorSpace;
+		chainConverted = createInfo.format != wantedFormat;
+		chainFlippable = SupportsBlit((VkFormat)tex->m_nFormat);
 	}
 
 	// First find the relevant image to render to
@@ -227,34 +255,64 @@ void VkCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBound
 
 	bool image_is_multisampled = xr_main_view(XruEyeLeft).maxSwapchainSampleCount < tex->m_nSampleCount;
 
-	if (image_is_multisampled) {
-		// HACK: As of July 2022 Monado does not support multisampling, so we can't just copy the image.
-		// Instead, we do vkCmdResolveImage into the swapchain image. (note, this doesn't support depth textures)
-		// Todo - how do we tell which runtimes support multisampling?
-
-		vkCmdResolveImage( //
-		    currentCommandBuffer, // commandbuffer
-		    (VkImage)tex->m_nImage, // srcImage
-		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
-		    swapchainImages.at(currentIndex).image, // dstImage
-		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
-		    1, // regionCount
-		    (VkImageResolve*)&region // pRegions
-		);
+	// Vertically flipped images (common for games ported from OpenGL) have to be flipped back, since OpenXR
+	// doesn't allow an imageRect with a negative height.
+	bool flipped = bounds && bounds->vMin > bounds->vMax;
+
+	// A blit can flip the image and convert it to the swapchain's format in a single operation. It can't be used
+	// for multisampled images though, or to reinterpret a UNORM image as sRGB (see handle_colorspace_gamma) since
+	// it would gamma-encode the image a second time.
+	bool reinterpreted = !chainConverted && (int64_t)tex->m_nFormat != createInfo.format;
+	VkImage dstImage = swapchainImages.at(currentIndex).image;
+
+	// A multisampled image can only be flipped after it's resolved, which needs a single-sampled swapchain
+	bool canFlip = chainFlippable && (tex->m_nSampleCount == 1 || image_is_multisampled);
+	if (flipped && !canFlip)
+		OOVR_LOG_ONCE("Can't flip this Vulkan image, submitting it upside-down");
+
+	if (chainConverted || (flipped && canFlip && tex->m_nSampleCount == 1 && !reinterpreted)) {
+		RecordBlit(currentCommandBuffer, (VkImage)tex->m_nImage, dstImage, 0, VK_IMAGE_ASPECT_COLOR_BIT, tex->m_nWidth, tex->m_nHeight, flipped);
+	} else if (flipped && canFlip) {
+		RecordFlipThroughScratch(currentCommandBuffer, *tex, dstImage, reinterpreted);
 	} else {
-		vkCmdCopyImage( //
-		    currentCommandBuffer, // commandbuffer
-		    (VkImage)tex->m_nImage, // srcImage
-		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
-		    swapchainImages.at(currentIndex).image, // dstImage
-		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
-		    1, // regionCount
-		    &region // pRegions
-		);
+		if (image_is_multisampled) {
+			// HACK: As of July 2022 Monado does not support multisampling, so we can't just copy the image.
+			// Instead, we do vkCmdResolveImage into the swapchain image. (note, this doesn't support depth textures)
+			// Todo - how do we tell which runtimes support multisampling?
+
+			vkCmdResolveImage( //
+			    currentCommandBuffer, // commandbuffer
+			    (VkImage)tex->m_nImage, // srcImage
+			    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
+			    dstImage, // dstImage
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+			    1, // regionCount
+			    (const VkImageResolve*)&region // pRegions
+			);
+		} else {
+			vkCmdCopyImage( //
+			    currentCommandBuffer, // commandbuffer
+			    (VkImage)tex->m_nImage, // srcImage
+			    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
+			    dstImage, // dstImage
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+			    1, // regionCount
+			    &region // pRegions
+			);
+		}
+	}
+
+	// For screenshots, also copy the image back to the host. The slot's fence tells PollReadback when it's done.
+	ReadbackSlot* readback = nullptr;
+	if (readbackRequested) {
+		readbackRequested = false;
+		readback = RecordReadback(currentCommandBuffer, swapchainImages.at(currentIndex).image);
+		readbackFailed = readback == nullptr;
+		readbackInFlight = readback;
 	}
 
 	// transition swapchain image back to COLOR_ATTACHMENT_OPTIMAL for runtime
-	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.oldLayout = readback ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	vkCmdPipelineBarrier(
 	    currentCommandBuffer, //
@@ -271,13 +329,46 @@ void VkCompositor::Invoke(const vr::Texture_t* texture, const vr::VRTextureBound
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &currentCommandBuffer;
 
-	OOVR_FAILED_VK_ABORT(vkQueueSubmit(tex->m_pQueue, 1, &submitInfo, VK_NULL_HANDLE));
+	OOVR_FAILED_VK_ABORT(vkQueueSubmit(tex->m_pQueue, 1, &submitInfo, readback ? readback->fence : VK_NULL_HANDLE));
 
 	// Release the swapchain - OpenXR will use the last-released image in a swapchain
 	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
 	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
 }
 
+void VkCompositor::CreateSwapChain()
+{
+	// First, delete the old chain if necessary
+	if (chain)
+		xrDestroySwapchain(chain);
+
+	// Free old command buffers if necessary
+	if (!appCommandBuffers.empty()) {
+		vkFreeCommandBuffers(appDevice, appCommandPool, appCommandBuffers.size(), appCommandBuffers.data());
+	}
+
+	OOVR_FAILED_XR_ABORT(xrCreateSwapchain(xr_session.get(), &createInfo, &chain));
+
+	// Set by Invoke if this is an eye swapchain
+	chainSourceFormat = VK_FORMAT_UNDEFINED;
+	chainConverted = false;
+	chainFlippable = false;
+
+	uint32_t chainLength = 0;
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, 0, &chainLength, nullptr));
+	swapchainImages.resize(chainLength);
+	for (XrSwapchainImageVulkanKHR& swapchainImage : swapchainImages)
+		swapchainImage.type = XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR;
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(chain, swapchainImages.size(), &chainLength, (XrSwapchainImageBaseHeader*)swapchainImages.data()));
+
+	appCommandBuffers.resize(chainLength);
+	VkCommandBufferAllocateInfo bufInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	bufInfo.commandPool = appCommandPool;
+	bufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	bufInfo.commandBufferCount = chainLength;
+	OOVR_FAILED_VK_ABORT(vkAllocateCommandBuffers(appDevice, &bufInfo, appCommandBuffers.data()));
+}
+
 void VkCompositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* ptrBounds, vr::EVRSubmitFlags submitFlags, XrCompositionLayerProjectionView& layer)
 {
 
@@ -297,10 +388,13 @@ void VkCompositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::VR
 		vr::VRTextureBounds_t bounds = *ptrBounds;
 
 		// We may have bounds.vMin > bounds.vMax representing a vertically flipped
-		// image. Virtually all Vulkan implementations handle this (those supporting
-		// VK_KHR_Maintenance1 and those supporting Vulkan 1.1) so this will
-		// normally just work by default. TODO: detect version and either manually
-		// flip or error out if not supported.
+		// image. The image was flipped back when it was copied into the swapchain,
+		// so mirror the bounds to match.
+		if (bounds.vMin > bounds.vMax) {
+			float vMin = 1.0f - bounds.vMin;
+			bounds.vMax = 1.0f - bounds.vMax;
+			bounds.vMin = vMin;
+		}
 
 		viewport.offset.x = (int)(bounds.uMin * tex.m_nWidth);
 		viewport.offset.y = (int)(bounds.vMin * tex.m_nHeight);
@@ -315,12 +409,778 @@ void VkCompositor::Invoke(XruEye eye, const vr::Texture_t* texture, const vr::VR
 	}
 }
 
+bool VkCompositor::InvokeDepth(const vr::VRTextureDepthInfo_t& depth, const vr::VRTextureBounds_t* bounds, XrCompositionLayerDepthInfoKHR& depthInfo)
+{
+	const auto* tex = (const vr::VRVulkanTextureData_t*)depth.handle;
+	if (!tex || !chain)
+		return false;
+
+	OOVR_FALSE_ABORT(appQueue == tex->m_pQueue);
+
+	// Multisampled depth can't be resolved with a copy, and the runtime wouldn't accept it anyway
+	if (tex->m_nSampleCount > 1) {
+		OOVR_LOG_ONCE("Multisampled depth textures are not supported, submitting without depth");
+		return false;
+	}
+
+	VkImageAspectFlags aspects;
+	switch ((VkFormat)tex->m_nFormat) {
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		aspects = VK_IMAGE_ASPECT_DEPTH_BIT;
+		break;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		aspects = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		break;
+	default:
+		OOVR_LOG_ONCEF("Unsupported depth texture format %d, submitting without depth", tex->m_nFormat);
+		return false;
+	}
+
+	// Flip the depth back along with the colour image, so the two line up
+	bool flipped = bounds && bounds->vMin > bounds->vMax;
+	if (flipped && !SupportsBlit((VkFormat)tex->m_nFormat)) {
+		OOVR_LOG_ONCEF("Can't flip depth textures of format %d, submitting without depth", tex->m_nFormat);
+		return false;
+	}
+
+	if (!depthChain || depthCreateInfo.width != tex->m_nWidth || depthCreateInfo.height != tex->m_nHeight || depthCreateInfo.format != tex->m_nFormat) {
+		if (!CreateDepthSwapChain(tex->m_nWidth, tex->m_nHeight, tex->m_nFormat))
+			return false;
+
+		if (!depthCommandBuffers.empty())
+			vkFreeCommandBuffers(appDevice, appCommandPool, depthCommandBuffers.size(), depthCommandBuffers.data());
+
+		uint32_t chainLength = 0;
+		OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(depthChain, 0, &chainLength, nullptr));
+		depthSwapchainImages.assign(chainLength, { XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR });
+		OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(depthChain, chainLength, &chainLength, (XrSwapchainImageBaseHeader*)depthSwapchainImages.data()));
+
+		depthCommandBuffers.resize(chainLength);
+		VkCommandBufferAllocateInfo bufInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		bufInfo.commandPool = appCommandPool;
+		bufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		bufInfo.commandBufferCount = chainLength;
+		OOVR_FAILED_VK_ABORT(vkAllocateCommandBuffers(appDevice, &bufInfo, depthCommandBuffers.data()));
+	}
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(depthChain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	OOVR_FAILED_XR_ABORT(xrWaitSwapchainImage(depthChain, &waitInfo));
+
+	const VkCommandBuffer commandBuffer = depthCommandBuffers.at(currentIndex);
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	OOVR_FAILED_VK_ABORT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = depthSwapchainImages.at(currentIndex).image;
+	barrier.subresourceRange = { aspects, 0, 1, 0, 1 };
+
+	vkCmdPipelineBarrier(
+	    commandBuffer,
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    0,
+	    0, nullptr,
+	    0, nullptr,
+	    1, &barrier);
+
+	// Only the depth is useful for reprojection, so don't bother copying the stencil
+	VkImage dstImage = depthSwapchainImages.at(currentIndex).image;
+	if (flipped) {
+		RecordBlit(commandBuffer, (VkImage)tex->m_nImage, dstImage, 0, VK_IMAGE_ASPECT_DEPTH_BIT, tex->m_nWidth, tex->m_nHeight, true);
+	} else {
+		VkImageCopy region = {};
+		region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.extent = { tex->m_nWidth, tex->m_nHeight, 1 };
+
+		vkCmdCopyImage(
+		    commandBuffer,
+		    (VkImage)tex->m_nImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		    dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		    1, &region);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(
+	    commandBuffer,
+	    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+	    0,
+	    0, nullptr,
+	    0, nullptr,
+	    1, &barrier);
+
+	OOVR_FAILED_VK_ABORT(vkEndCommandBuffer(commandBuffer));
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	OOVR_FAILED_VK_ABORT(vkQueueSubmit(appQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(depthChain, &releaseInfo));
+
+	// Use the same area as the colour image, which isn't cropped when it's copied either. Since the depth was
+	// flipped back, the bounds are mirrored to match.
+	depthInfo.subImage.swapchain = depthChain;
+	depthInfo.subImage.imageArrayIndex = 0;
+	XrRect2Di& viewport = depthInfo.subImage.imageRect;
+	if (bounds) {
+		vr::VRTextureBounds_t depthBounds = *bounds;
+		if (flipped) {
+			depthBounds.vMin = 1.0f - bounds->vMin;
+			depthBounds.vMax = 1.0f - bounds->vMax;
+		}
+
+		viewport.offset.x = (int)(std::min(depthBounds.uMin, depthBounds.uMax) * tex->m_nWidth);
+		viewport.offset.y = (int)(std::min(depthBounds.vMin, depthBounds.vMax) * tex->m_nHeight);
+		viewport.extent.width = (int)(fabsf(depthBounds.uMax - depthBounds.uMin) * tex->m_nWidth);
+		viewport.extent.height = (int)(fabsf(depthBounds.vMax - depthBounds.vMin) * tex->m_nHeight);
+	} else {
+		viewport.offset = { 0, 0 };
+		viewport.extent = { (int32_t)tex->m_nWidth, (int32_t)tex->m_nHeight };
+	}
+
+	return true;
+}
+
+void VkCompositor::ClearMotionVectors()
+{
+	uint32_t chainLength = 0;
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(motionVectorChain, 0, &chainLength, nullptr));
+	std::vector<XrSwapchainImageVulkanKHR> images(chainLength, { XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR });
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainImages(motionVectorChain, chainLength, &chainLength, (XrSwapchainImageBaseHeader*)images.data()));
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(motionVectorChain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	OOVR_FAILED_XR_ABORT(xrWaitSwapchainImage(motionVectorChain, &waitInfo));
+
+	VkCommandBuffer commandBuffer;
+	VkCommandBufferAllocateInfo bufInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	bufInfo.commandPool = appCommandPool;
+	bufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	bufInfo.commandBufferCount = 1;
+	OOVR_FAILED_VK_ABORT(vkAllocateCommandBuffers(appDevice, &bufInfo, &commandBuffer));
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	OOVR_FAILED_VK_ABORT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = images.at(currentIndex).image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkClearColorValue zero = {};
+	vkCmdClearColorImage(commandBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &zero, 1, &barrier.subresourceRange);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	OOVR_FAILED_VK_ABORT(vkEndCommandBuffer(commandBuffer));
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	OOVR_FAILED_VK_ABORT(vkQueueSubmit(appQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+	// This only happens once per swapchain, so it's simplest to just wait for it
+	OOVR_FAILED_VK_ABORT(vkQueueWaitIdle(appQueue));
+	vkFreeCommandBuffers(appDevice, appCommandPool, 1, &commandBuffer);
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(motionVectorChain, &releaseInfo));
+}
+
 void VkCompositor::InvokeCubemap(const vr::Texture_t* textures)
 {
-	OOVR_ABORT("VkCompositor::InvokeCubemap: Not yet supported!");
+	const vr::VRVulkanTextureData_t* faces[6];
+	for (int i = 0; i < 6; i++) {
+		faces[i] = (vr::VRVulkanTextureData_t*)textures[i].handle;
+		if (!faces[i])
+			ERR("Cannot use NULL Vulkan image data (VRVulkanTextureData_t) for a cubemap face");
+		OOVR_FALSE_ABORT(appQueue == faces[i]->m_pQueue);
+	}
+
+	// Cube faces have to be square, so crop any non-square skybox down to the smallest side
+	const vr::VRVulkanTextureData_t& first = *faces[0];
+	uint32_t size = std::min(first.m_nWidth, first.m_nHeight);
+
+	VkFormat format;
+	switch (textures[0].eColorSpace) {
+	case vr::ColorSpace_Gamma:
+		format = handle_colorspace_gamma((VkFormat)first.m_nFormat);
+		break;
+	case vr::ColorSpace_Linear:
+		format = handle_colorspace_linear((VkFormat)first.m_nFormat);
+		break;
+	default:
+		format = handle_colorspace_auto((VkFormat)first.m_nFormat);
+		break;
+	}
+
+	bool usable = chain != XR_NULL_HANDLE && createInfo.faceCount == 6 && createInfo.width == size && createInfo.format == format;
+
+	if (!usable) {
+		OOVR_LOG("Generating new cubemap swap chain");
+
+		createInfo = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+		createInfo.createFlags = swapchainCreateFlags;
+		createInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+		createInfo.format = format;
+		createInfo.faceCount = 6;
+		createInfo.width = size;
+		createInfo.height = size;
+		createInfo.mipCount = 1;
+		createInfo.sampleCount = 1;
+		createInfo.arraySize = 1;
+
+		CreateSwapChain();
+	}
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(chain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	OOVR_FAILED_XR_ABORT(xrWaitSwapchainImage(chain, &waitInfo));
+
+	const VkCommandBuffer currentCommandBuffer = appCommandBuffers.at(currentIndex);
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	OOVR_FAILED_VK_ABORT(vkBeginCommandBuffer(currentCommandBuffer, &beginInfo));
+
+	// The six faces are the array layers of the swapchain image, so transition them all at once
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = swapchainImages.at(currentIndex).image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 6;
+	vkCmdPipelineBarrier(currentCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	for (int i = 0; i < 6; i++) {
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.dstSubresource.baseArrayLayer = CUBEMAP_FACE_INDICES[i];
+		region.dstSubresource.layerCount = 1;
+		region.extent = { size, size, 1 };
+
+		vkCmdCopyImage(currentCommandBuffer, (VkImage)faces[i]->m_nImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		    barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+
+	// transition swapchain image back to COLOR_ATTACHMENT_OPTIMAL for runtime
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(currentCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	OOVR_FAILED_VK_ABORT(vkEndCommandBuffer(currentCommandBuffer));
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &currentCommandBuffer;
+	OOVR_FAILED_VK_ABORT(vkQueueSubmit(appQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
+}
+
+bool VkCompositor::InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed, uint32_t changedCount)
+{
+	VkDeviceSize size = (VkDeviceSize)width * height * 4;
+
+	// Wait for the last upload to finish with the staging buffer before overwriting it. The fence starts out
+	// signalled, and is only reset when there's something to upload.
+	if (rawUploadFence) {
+		OOVR_FAILED_VK_ABORT(vkWaitForFences(appDevice, 1, &rawUploadFence, VK_TRUE, UINT64_MAX));
+	} else {
+		VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		OOVR_FAILED_VK_ABORT(vkCreateFence(appDevice, &fenceInfo, nullptr, &rawUploadFence));
+	}
+
+	// The staging buffer is only ever grown, and stays mapped for the lifetime of the compositor
+	if (size > rawStagingSize) {
+		if (rawStagingBuffer) {
+			vkUnmapMemory(appDevice, rawStagingMemory);
+			vkDestroyBuffer(appDevice, rawStagingBuffer, nullptr);
+			vkFreeMemory(appDevice, rawStagingMemory, nullptr);
+		}
+
+		CreateHostBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, rawStagingBuffer, rawStagingMemory, rawStagingMapped);
+
+		rawStagingSize = size;
+	}
+
+	// Static swapchains can only be written once, so every new image needs a new swapchain. The colour attachment
+	// usage means the runtime hands the images back in COLOR_ATTACHMENT_OPTIMAL, so a partial upload can keep the
+	// rest of the image.
+	if (chain == XR_NULL_HANDLE || IsStaticImage() || createInfo.width != width || createInfo.height != height
+	    || createInfo.format != VK_FORMAT_R8G8B8A8_SRGB) {
+		createInfo = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+		createInfo.createFlags = swapchainCreateFlags;
+		createInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+		createInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+		createInfo.faceCount = 1;
+		createInfo.width = width;
+		createInfo.height = height;
+		createInfo.mipCount = 1;
+		createInfo.sampleCount = 1;
+		createInfo.arraySize = 1;
+		CreateSwapChain();
+	}
+
+	XrSwapchainImageAcquireInfo acquireInfo{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+	uint32_t currentIndex;
+	OOVR_FAILED_XR_ABORT(xrAcquireSwapchainImage(chain, &acquireInfo, &currentIndex));
+
+	XrSwapchainImageWaitInfo waitInfo{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	OOVR_FAILED_XR_ABORT(xrWaitSwapchainImage(chain, &waitInfo));
+
+	// If this image is already up to date, releasing it again is all that's needed
+	std::vector<CompositorRect> rects = TakeRawUploadRects(currentIndex, (uint32_t)swapchainImages.size(), changed, changedCount);
+	if (rects.empty()) {
+		XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+		OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
+		return true;
+	}
+
+	// Only the out-of-date rectangles go through the staging buffer, packed tightly one after the other. They
+	// don't overlap, so they always fit in a buffer the size of the whole image.
+	std::vector<VkBufferImageCopy> regions;
+	VkDeviceSize offset = 0;
+	for (const CompositorRect& rect : rects) {
+		for (uint32_t y = 0; y < rect.height; y++) {
+			memcpy((uint8_t*)rawStagingMapped + offset + (size_t)y * rect.width * 4,
+			    (const uint8_t*)pixels + ((size_t)(rect.y + y) * width + rect.x) * 4, (size_t)rect.width * 4);
+		}
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { (int32_t)rect.x, (int32_t)rect.y, 0 };
+		region.imageExtent = { rect.width, rect.height, 1 };
+		regions.push_back(region);
+
+		offset += (VkDeviceSize)rect.width * rect.height * 4;
+	}
+	OOVR_FAILED_VK_ABORT(vkResetFences(appDevice, 1, &rawUploadFence));
+
+	const VkCommandBuffer currentCommandBuffer = appCommandBuffers.at(currentIndex);
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	OOVR_FAILED_VK_ABORT(vkBeginCommandBuffer(currentCommandBuffer, &beginInfo));
+
+	// The old contents can be thrown away if they're all being replaced
+	bool wholeImage = rects.size() == 1 && rects[0].width == width && rects[0].height == height;
+
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.oldLayout = wholeImage ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = swapchainImages.at(currentIndex).image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(currentCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	vkCmdCopyBufferToImage(currentCommandBuffer, rawStagingBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(),
+	    regions.data());
+
+	// transition swapchain image back to COLOR_ATTACHMENT_OPTIMAL for runtime
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(currentCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	OOVR_FAILED_VK_ABORT(vkEndCommandBuffer(currentCommandBuffer));
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &currentCommandBuffer;
+	OOVR_FAILED_VK_ABORT(vkQueueSubmit(appQueue, 1, &submitInfo, rawUploadFence));
+
+	XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	OOVR_FAILED_XR_ABORT(xrReleaseSwapchainImage(chain, &releaseInfo));
+
+	return true;
+}
+
+VkCompositor::ReadbackSlot* VkCompositor::RecordReadback(VkCommandBuffer commandBuffer, VkImage image)
+{
+	bool bgra;
+	switch (createInfo.format) {
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		bgra = false;
+		break;
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		bgra = true;
+		break;
+	default:
+		OOVR_LOGF("Can't read back Vulkan images with format %d for screenshots", (int)createInfo.format);
+		return nullptr;
+	}
+
+	if (createInfo.sampleCount != 1) {
+		OOVR_LOG("Can't read back multisampled Vulkan images for screenshots");
+		return nullptr;
+	}
+
+	ReadbackSlot* slot = nullptr;
+	for (const std::unique_ptr<ReadbackSlot>& candidate : readbackSlots) {
+		if (!candidate->inUse) {
+			slot = candidate.get();
+			break;
+		}
+	}
+
+	if (!slot) {
+		readbackSlots.push_back(std::make_unique<ReadbackSlot>());
+		slot = readbackSlots.back().get();
+
+		VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		OOVR_FAILED_VK_ABORT(vkCreateFence(appDevice, &fenceInfo, nullptr, &slot->fence));
+	} else {
+		OOVR_FAILED_VK_ABORT(vkResetFences(appDevice, 1, &slot->fence));
+	}
+
+	VkDeviceSize size = (VkDeviceSize)createInfo.width * createInfo.height * 4;
+	if (size > slot->size) {
+		if (slot->buffer) {
+			vkUnmapMemory(appDevice, slot->memory);
+			vkDestroyBuffer(appDevice, slot->buffer, nullptr);
+			vkFreeMemory(appDevice, slot->memory, nullptr);
+		}
+
+		// The CPU reads these back, which is very slow from uncached memory
+		slot->coherent = CreateHostBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true, slot->buffer, slot->memory, slot->mapped);
+		slot->size = size;
+	}
+
+	slot->width = createInfo.width;
+	slot->height = createInfo.height;
+	slot->bgra = bgra;
+	slot->inUse = true;
+
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { createInfo.width, createInfo.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer, 1, &region);
+
+	// Make the copy visible to the host once the fence is signalled
+	VkBufferMemoryBarrier bufferBarrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = slot->buffer;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+	    0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	return slot;
+}
+
+bool VkCompositor::PollReadback(CompositorReadback& readback)
+{
+	if (readbackFailed) {
+		readbackFailed = false;
+		readback = {};
+		return true;
+	}
+
+	if (!readbackInFlight)
+		return false;
+
+	ReadbackSlot* slot = readbackInFlight;
+	VkResult status = vkGetFenceStatus(appDevice, slot->fence);
+	if (status == VK_NOT_READY)
+		return false;
+	OOVR_FAILED_VK_ABORT(status);
+
+	if (!slot->coherent) {
+		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+		range.memory = slot->memory;
+		range.size = VK_WHOLE_SIZE;
+		OOVR_FAILED_VK_ABORT(vkInvalidateMappedMemoryRanges(appDevice, 1, &range));
+	}
+
+	readback = {};
+	readback.width = slot->width;
+	readback.height = slot->height;
+	readback.rowPitch = slot->width * 4;
+	readback.bgra = slot->bgra;
+	readback.pixels = (const uint8_t*)slot->mapped;
+	readback.release = [slot]() { slot->inUse = false; };
+
+	readbackInFlight = nullptr;
+	return true;
+}
+
+bool VkCompositor::SupportsBlit(VkFormat format) const
+{
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(appPhysicalDevice, format, &props);
+
+	VkFormatFeatureFlags wanted = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+	return (props.optimalTilingFeatures & wanted) == wanted;
+}
+
+void VkCompositor::RecordBlit(VkCommandBuffer commandBuffer, VkImage src, VkImage dst, uint32_t dstLayer, VkImageAspectFlags aspect,
+    uint32_t width, uint32_t height, bool flipY)
+{
+	// Swapping the source's Y offsets flips the image
+	VkImageBlit blit = {};
+	blit.srcSubresource = { aspect, 0, 0, 1 };
+	blit.srcOffsets[0] = { 0, flipY ? (int32_t)height : 0, 0 };
+	blit.srcOffsets[1] = { (int32_t)width, flipY ? 0 : (int32_t)height, 1 };
+	blit.dstSubresource = { aspect, 0, dstLayer, 1 };
+	blit.dstOffsets[0] = { 0, 0, 0 };
+	blit.dstOffsets[1] = { (int32_t)width, (int32_t)height, 1 };
+
+	vkCmdBlitImage(
+	    commandBuffer,
+	    src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	    dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	    1, &blit,
+	    VK_FILTER_NEAREST);
+}
+
+void VkCompositor::RecordFlipThroughScratch(VkCommandBuffer commandBuffer, const vr::VRVulkanTextureData_t& tex, VkImage dst, bool reinterpreted)
+{
+	if (!scratchImage || scratchWidth != tex.m_nWidth || scratchHeight != tex.m_nHeight || scratchFormat != (VkFormat)tex.m_nFormat) {
+		if (scratchImage) {
+			// This only happens when the app changes its render resolution, so it's fine to stall for it
+			vkQueueWaitIdle(appQueue);
+			vkDestroyImage(appDevice, scratchImage, nullptr);
+			vkFreeMemory(appDevice, scratchMemory, nullptr);
+			scratchImage = VK_NULL_HANDLE;
+		}
+
+		VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = (VkFormat)tex.m_nFormat;
+		imageInfo.extent = { tex.m_nWidth, tex.m_nHeight, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 2;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		OOVR_FAILED_VK_ABORT(vkCreateImage(appDevice, &imageInfo, nullptr, &scratchImage));
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(appDevice, scratchImage, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (allocInfo.memoryTypeIndex == UINT32_MAX)
+			ERR("No device-local memory type for the flip scratch image");
+		OOVR_FAILED_VK_ABORT(vkAllocateMemory(appDevice, &allocInfo, nullptr, &scratchMemory));
+		OOVR_FAILED_VK_ABORT(vkBindImageMemory(appDevice, scratchImage, scratchMemory, 0));
+
+		scratchWidth = tex.m_nWidth;
+		scratchHeight = tex.m_nHeight;
+		scratchFormat = (VkFormat)tex.m_nFormat;
+	}
+
+	auto transition = [&](uint32_t layer, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+		VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = scratchImage;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, layer, layerCount };
+
+		vkCmdPipelineBarrier(
+		    commandBuffer,
+		    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		    0,
+		    0, nullptr,
+		    0, nullptr,
+		    1, &barrier);
+	};
+
+	// Nothing is kept from the last frame, but that frame's copies must finish before this one overwrites them
+	transition(0, 2, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	// Layer 0 holds the resolved image, if the app's image is multisampled
+	VkImage src = (VkImage)tex.m_nImage;
+	if (tex.m_nSampleCount > 1) {
+		VkImageResolve resolve = {};
+		resolve.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		resolve.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		resolve.extent = { tex.m_nWidth, tex.m_nHeight, 1 };
+		vkCmdResolveImage(commandBuffer, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		    scratchImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &resolve);
+
+		transition(0, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		src = scratchImage;
+	}
+
+	if (!reinterpreted) {
+		RecordBlit(commandBuffer, src, dst, 0, VK_IMAGE_ASPECT_COLOR_BIT, tex.m_nWidth, tex.m_nHeight, true);
+		return;
+	}
+
+	// Layer 1 holds the flipped image, which is then copied as-is into the swapchain
+	RecordBlit(commandBuffer, src, scratchImage, 1, VK_IMAGE_ASPECT_COLOR_BIT, tex.m_nWidth, tex.m_nHeight, true);
+	transition(1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+	VkImageCopy copy = {};
+	copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 1 };
+	copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copy.extent = { tex.m_nWidth, tex.m_nHeight, 1 };
+	vkCmdCopyImage(commandBuffer, scratchImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	    dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
 }
 
-bool VkCompositor::CheckChainCompatible(const vr::VRVulkanTextureData_t& tex, const XrSwapchainCreateInfo& chainDesc, vr::EColorSpace colourSpace)
+uint32_t VkCompositor::FindMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags wanted)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(appPhysicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((allowedTypes & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & wanted) == wanted)
+			return i;
+	}
+
+	return UINT32_MAX;
+}
+
+bool VkCompositor::CreateHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, bool preferCached, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped)
+{
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	OOVR_FAILED_VK_ABORT(vkCreateBuffer(appDevice, &bufferInfo, nullptr, &buffer));
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(appDevice, buffer, &requirements);
+
+	const VkMemoryPropertyFlags coherentFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	const VkMemoryPropertyFlags cachedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+	uint32_t memoryType = UINT32_MAX;
+	bool coherent = true;
+	if (preferCached) {
+		memoryType = FindMemoryType(requirements.memoryTypeBits, cachedFlags | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (memoryType == UINT32_MAX) {
+			memoryType = FindMemoryType(requirements.memoryTypeBits, cachedFlags);
+			coherent = false;
+		}
+	}
+	if (memoryType == UINT32_MAX) {
+		memoryType = FindMemoryType(requirements.memoryTypeBits, coherentFlags);
+		coherent = true;
+	}
+	if (memoryType == UINT32_MAX)
+		ERR("No host-visible memory type available for the staging buffer");
+
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType;
+	OOVR_FAILED_VK_ABORT(vkAllocateMemory(appDevice, &allocInfo, nullptr, &memory));
+	OOVR_FAILED_VK_ABORT(vkBindBufferMemory(appDevice, buffer, memory, 0));
+	OOVR_FAILED_VK_ABORT(vkMapMemory(appDevice, memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+
+	return coherent;
+}
+
+VkFormat VkCompositor::ChooseChainFormat(VkFormat appFormat, VkFormat wanted, uint32_t sampleCount)
+{
+	uint32_t formatCount;
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainFormats(xr_session.get(), 0, &formatCount, nullptr));
+	std::vector<int64_t> formats(formatCount);
+	OOVR_FAILED_XR_ABORT(xrEnumerateSwapchainFormats(xr_session.get(), formatCount, &formatCount, formats.data()));
+
+	if (std::count(formats.begin(), formats.end(), wanted) != 0)
+		return wanted;
+
+	// The runtime can't take the app's format, so blit the image into one it can take instead. Blits can't
+	// handle multisampled images, and need both formats to support them.
+	VkFormatProperties appProps;
+	vkGetPhysicalDeviceFormatProperties(appPhysicalDevice, appFormat, &appProps);
+
+	if (sampleCount == 1 && (appProps.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT)) {
+		for (VkFormat candidate : { VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_SRGB }) {
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(appPhysicalDevice, candidate, &props);
+
+			if (std::count(formats.begin(), formats.end(), candidate) != 0 && (props.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+				OOVR_LOGF("The runtime does not support the Vulkan format %d, converting to format %d", wanted, candidate);
+				return candidate;
+			}
+		}
+	}
+
+	for (int64_t f : formats) {
+		OOVR_LOGF("Valid format: %d", (int)f);
+	}
+	OOVR_ABORTF("The runtime does not support the Vulkan format %d, and it can't be converted", wanted);
+}
+
+bool VkCompositor::CheckChainCompatible(const vr::VRVulkanTextureData_t& tex, vr::EColorSpace colourSpace) const
 {
 	bool usable = true;
 #define FAIL(name)                             \
@@ -328,33 +1188,18 @@ bool VkCompositor::CheckChainCompatible(const vr::VRVulkanTextureData_t& tex, co
 		usable = false;                        \
 		OOVR_LOG("Resource mismatch: " #name); \
 	} while (0)
-#define CHECK(name, chainName)           \
-	if (tex.name != chainDesc.chainName) \
+#define CHECK(name, chainName)            \
+	if (tex.name != createInfo.chainName) \
 	FAIL(name)
 
 	CHECK(m_nWidth, width);
 	CHECK(m_nHeight, height);
 	CHECK(m_nSampleCount, sampleCount);
-	switch (colourSpace) {
-	case vr::ColorSpace_Auto: {
-		if (handle_colorspace_auto((VkFormat)tex.m_nFormat) != chainDesc.format)
-			FAIL(m_nFormat);
-		break;
-	}
-	case vr::ColorSpace_Gamma: {
-		if (handle_colorspace_gamma((VkFormat)tex.m_nFormat) != chainDesc.format)
-			FAIL(m_nFormat);
-		break;
-	}
-	case vr::ColorSpace_Linear: {
-		if (handle_colorspace_linear((VkFormat)tex.m_nFormat) != chainDesc.format)
-			FAIL(m_nFormat);
-		break;
-	}
-	default:
-		OOVR_ABORTF("Invalid colorspace given: %d", colourSpace);
-		break;
-	}
+
+	// The swapchain's format may have been substituted for one the runtime supports, so compare against what
+	// it was created for rather than the format itself
+	if ((VkFormat)tex.m_nFormat != chainSourceFormat || colourSpace != chainColourSpace)
+		FAIL(m_nFormat);
 
 #undef CHECK
 #undef FAIL
@@ -2,6 +2,8 @@
 
 #include "compositor.h"
 
+#include <atomic>
+
 class VkCompositor : public Compositor {
 public:
 	VkCompositor(const vr::Texture_t* initialTexture);
@@ -15,16 +17,116 @@ public:
 	    vr::EVRSubmitFlags submitFlags, XrCompositionLayerProjectionView& viewport) override;
 
 	void InvokeCubemap(const vr::Texture_t* textures) override;
+	bool SupportsCubemap() override { return true; }
+
+	bool InvokeRaw(const void* pixels, uint32_t width, uint32_t height, const CompositorRect* changed = nullptr, uint32_t changedCount = 0) override;
+
+	bool SupportsReadback() override { return true; }
+	void RequestReadback() override { readbackRequested = true; }
+	bool PollReadback(CompositorReadback& readback) override;
+
+	bool InvokeDepth(const vr::VRTextureDepthInfo_t& depth, const vr::VRTextureBounds_t* bounds, XrCompositionLayerDepthInfoKHR& depthInfo) override;
 
 private:
-	static bool CheckChainCompatible(const vr::VRVulkanTextureData_t& tex, const XrSwapchainCreateInfo& chainDesc, vr::EColorSpace colourSpace);
+	// A host buffer that an eye image is copied into for a screenshot. Slots are reused once the screenshot
+	// writer releases them, so there's normally only one or two.
+	struct ReadbackSlot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		bool coherent = false;
+		VkFence fence = VK_NULL_HANDLE;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		bool bgra = false;
+
+		// Set from when the copy is recorded until the readback is released, possibly on another thread
+		std::atomic<bool> inUse = false;
+	};
+
+	// (Re)create the swapchain from createInfo, along with the command buffers used to copy into it
+	void CreateSwapChain();
+
+	int64_t GetMotionVectorFormat() override { return VK_FORMAT_R16G16B16A16_SFLOAT; }
+	void ClearMotionVectors() override;
+
+	/**
+	 * Record copying the given swapchain image (which must be in TRANSFER_DST_OPTIMAL) into a readback slot, leaving
+	 * it in TRANSFER_SRC_OPTIMAL. Returns null if the image can't be read back, in which case nothing is recorded.
+	 */
+	ReadbackSlot* RecordReadback(VkCommandBuffer commandBuffer, VkImage image);
+
+	// Whether images of this format can be blitted from and into, which is how they're flipped
+	bool SupportsBlit(VkFormat format) const;
+
+	/**
+	 * Record blitting the whole of src (layer 0, in TRANSFER_SRC_OPTIMAL) into a layer of dst (in
+	 * TRANSFER_DST_OPTIMAL), flipping it vertically if flipY is set. Depth images must have the same format.
+	 */
+	void RecordBlit(VkCommandBuffer commandBuffer, VkImage src, VkImage dst, uint32_t dstLayer, VkImageAspectFlags aspect,
+	    uint32_t width, uint32_t height, bool flipY);
+
+	/**
+	 * Record flipping the app's image into the swapchain for the cases a single blit can't handle: resolving a
+	 * multisampled image first, or copying into a swapchain that reinterprets the image's format (which a blit
+	 * would convert). This goes through the scratch image.
+	 */
+	void RecordFlipThroughScratch(VkCommandBuffer commandBuffer, const vr::VRVulkanTextureData_t& tex, VkImage dst, bool reinterpreted);
+
+	// Find a memory type with all the given flags, or return UINT32_MAX
+	uint32_t FindMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags wanted);
+
+	// Create a buffer in host-visible memory and map it. Returns whether the memory is host-coherent.
+	bool CreateHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, bool preferCached, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped);
+
+	/**
+	 * Returns the wanted swapchain format if the runtime supports it. Otherwise, returns a format the app's image
+	 * can be blitted into, or aborts if there isn't one.
+	 */
+	VkFormat ChooseChainFormat(VkFormat appFormat, VkFormat wanted, uint32_t sampleCount);
+
+	bool CheckChainCompatible(const vr::VRVulkanTextureData_t& tex, vr::EColorSpace colourSpace) const;
 
 	// These resources live in the runtime's VkDevice
 	std::vector<XrSwapchainImageVulkanKHR> swapchainImages;
 
 	// These resources live in the app's VkDevice
 	VkDevice appDevice = VK_NULL_HANDLE;
+	VkPhysicalDevice appPhysicalDevice = VK_NULL_HANDLE;
 	VkQueue appQueue = VK_NULL_HANDLE;
 	VkCommandPool appCommandPool = VK_NULL_HANDLE;
 	std::vector<VkCommandBuffer> appCommandBuffers{};
+
+	// The app's format and colour space that the eye swapchain was created for, and whether the swapchain uses a
+	// different format that the image has to be converted into
+	VkFormat chainSourceFormat = VK_FORMAT_UNDEFINED;
+	vr::EColorSpace chainColourSpace = vr::ColorSpace_Auto;
+	bool chainConverted = false;
+	bool chainFlippable = false; // If the app's format supports blits, so flipped images can be flipped back
+
+	// An image in the app's format for RecordFlipThroughScratch: layer 0 holds a resolved multisampled image, and
+	// layer 1 the flipped image.
+	VkImage scratchImage = VK_NULL_HANDLE;
+	VkDeviceMemory scratchMemory = VK_NULL_HANDLE;
+	uint32_t scratchWidth = 0;
+	uint32_t scratchHeight = 0;
+	VkFormat scratchFormat = VK_FORMAT_UNDEFINED;
+
+	// The depth swapchain's images, and the command buffers used to copy into each of them
+	std::vector<XrSwapchainImageVulkanKHR> depthSwapchainImages;
+	std::vector<VkCommandBuffer> depthCommandBuffers{};
+
+	// Persistently-mapped host buffer used by InvokeRaw, and a fence to stop us overwriting it while
+	// the last upload is still in progress.
+	VkBuffer rawStagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory rawStagingMemory = VK_NULL_HANDLE;
+	VkDeviceSize rawStagingSize = 0;
+	void* rawStagingMapped = nullptr;
+	VkFence rawUploadFence = VK_NULL_HANDLE;
+
+	std::vector<std::unique_ptr<ReadbackSlot>> readbackSlots;
+	bool readbackRequested = false;
+	bool readbackFailed = false;
+	ReadbackSlot* readbackInFlight = nullptr;
 };
@@ -67,6 +67,11 @@ ITrackedDevice* BackendManager::GetDeviceByHand(ITrackedDevice::HandType hand)
 	return backend->GetDeviceByHand(hand);
 }
 
+uint32_t BackendManager::GetDeviceGeneration()
+{
+	return backend->GetDeviceGeneration();
+}
+
 IHMD* BackendManager::GetPrimaryHMD()
 {
 	return backend->GetPrimaryHMD();
@@ -99,6 +104,11 @@ void BackendManager::GetDeviceToAbsoluteTrackingPose(
 }
 
 // Submitting Frames
+void BackendManager::PrepareDevicePoses(vr::ETrackingUniverseOrigin origin)
+{
+	backend->PrepareDevicePoses(origin);
+}
+
 void BackendManager::WaitForTrackingData()
 {
 	return backend->WaitForTrackingData();
@@ -130,6 +140,11 @@ void BackendManager::ClearSkyboxOverride()
 	return backend->ClearSkyboxOverride();
 }
 
+bool BackendManager::CaptureScreenshot(std::function<void(CompositorReadback* eyes)> onCaptured)
+{
+	return backend->CaptureScreenshot(std::move(onCaptured));
+}
+
 bool BackendManager::GetFrameTiming(OOVR_Compositor_FrameTiming* pTiming, uint32_t unFramesAgo)
 {
 	return backend->GetFrameTiming(pTiming, unFramesAgo);
@@ -147,9 +162,14 @@ void BackendManager::ReleaseMirrorTextureD3D11(void* pD3D11ShaderResourceView)
 }
 #endif
 
-bool BackendManager::GetPlayAreaPoints(vr::HmdVector3_t* points, int* count)
+IBackend::openvr_enum_t BackendManager::GetMirrorTexture(vr::ETextureType api, vr::EVREye eEye, uint64_t* pImage)
+{
+	return backend->GetMirrorTexture(api, eEye, pImage);
+}
+
+const PlayAreaGeometry* BackendManager::GetPlayAreaGeometry()
 {
-	return backend->GetPlayAreaPoints(points, count);
+	return backend->GetPlayAreaGeometry();
 }
 
 bool BackendManager::AreBoundsVisible()
@@ -254,7 +274,7 @@ vr::ETrackedDeviceClass IHMD::GetTrackedDeviceClass()
 
 bool ITrackedDevice::GetBoolTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown bool property - dev: %d, prop: %d", DeviceIndex(), prop);
 	if (pErrorL)
 		*pErrorL = vr::TrackedProp_UnknownProperty;
@@ -263,7 +283,7 @@ bool ITrackedDevice::GetBoolTrackedDeviceProperty(vr::ETrackedDeviceProperty pro
 
 float ITrackedDevice::GetFloatTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown float property - dev: %d, prop: %d", DeviceIndex(), prop);
 
 	if (pErrorL)
@@ -273,7 +293,7 @@ float ITrackedDevice::GetFloatTrackedDeviceProperty(vr::ETrackedDeviceProperty p
 
 int32_t ITrackedDevice::GetInt32TrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown int32 property - dev: %d, prop: %d", DeviceIndex(), prop);
 
 	if (pErrorL)
@@ -283,7 +303,7 @@ int32_t ITrackedDevice::GetInt32TrackedDeviceProperty(vr::ETrackedDeviceProperty
 
 uint64_t ITrackedDevice::GetUint64TrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown uint64 property - dev: %d, prop: %d", DeviceIndex(), prop);
 
 	if (pErrorL)
@@ -293,7 +313,7 @@ uint64_t ITrackedDevice::GetUint64TrackedDeviceProperty(vr::ETrackedDeviceProper
 
 vr::HmdMatrix34_t ITrackedDevice::GetMatrix34TrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError* pErrorL)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown matrix34 property - dev: %d, prop: %d", DeviceIndex(), prop);
 
 	if (pErrorL)
@@ -308,7 +328,7 @@ vr::HmdMatrix34_t ITrackedDevice::GetMatrix34TrackedDeviceProperty(vr::ETrackedD
 
 uint32_t ITrackedDevice::GetArrayTrackedDeviceProperty(vr::ETrackedDeviceProperty prop, vr::PropertyTypeTag_t propType, void* pBuffer, uint32_t unBufferSize, vr::ETrackedPropertyError* pError)
 {
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown array property - dev: %d, prop: %d", -1, prop); // TODO use device index
 	if (pError)
 		*pError = vr::TrackedProp_UnknownProperty;
@@ -326,7 +346,7 @@ uint32_t ITrackedDevice::GetStringTrackedDeviceProperty(vr::ETrackedDeviceProper
 		return GetStringTrackedDeviceProperty(vr::Prop_TrackingSystemName_String, value, bufferSize, pErrorL);
 	}
 
-	if (!oovr_global_configuration.AdmitUnknownProps())
+	if (!oovr_global_configuration->AdmitUnknownProps())
 		OOVR_SOFT_ABORTF("unknown string property - dev: %d, prop: %d", DeviceIndex(), prop);
 
 	if (pErrorL)
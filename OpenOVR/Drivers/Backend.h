@@ -1,6 +1,7 @@
 #pragma once
 #include "../OpenOVR/custom_types.h" // TODO move this into the OpenVR tree
 #include "generated/interfaces/vrtypes.h"
+#include <functional>
 #include <memory>
 
 // for OOVR_Compositor_FrameTiming
@@ -8,6 +9,7 @@
 
 // Avoid including InteractionProfile for a single use
 class InteractionProfile;
+struct PlayAreaGeometry;
 
 enum ETrackingStateType {
 	/**
@@ -170,12 +172,20 @@ public:
 	PREPEND ITrackedDevice* GetDeviceByHand(                                                                                                       \
 	    ITrackedDevice::HandType hand) APPEND;                                                                                                     \
                                                                                                                                                    \
+	/* Incremented whenever a device connects or disconnects, so anything cached about the set of devices */                                       \
+	/* (such as which indices hold which classes of device) can be rebuilt. */                                                                     \
+	PREPEND uint32_t GetDeviceGeneration() APPEND;                                                                                                 \
+                                                                                                                                                   \
 	PREPEND void GetDeviceToAbsoluteTrackingPose(                                                                                                  \
 	    vr::ETrackingUniverseOrigin toOrigin,                                                                                                      \
 	    float predictedSecondsToPhotonsFromNow,                                                                                                    \
 	    vr::TrackedDevicePose_t* poseArray,                                                                                                        \
 	    uint32_t poseArrayCount) APPEND;                                                                                                           \
                                                                                                                                                    \
+	/* Locate all the devices relative to origin at once, so the following GetPose calls with the same origin */                                   \
+	/* can use the results rather than each querying the runtime. This is just an optimisation. */                                                 \
+	PREPEND void PrepareDevicePoses(vr::ETrackingUniverseOrigin origin) APPEND;                                                                    \
+                                                                                                                                                   \
 	/* Submitting Frames */                                                                                                                        \
 	PREPEND void WaitForTrackingData() APPEND;                                                                                                     \
                                                                                                                                                    \
@@ -192,6 +202,11 @@ public:
                                                                                                                                                    \
 	PREPEND void ClearSkyboxOverride() APPEND;                                                                                                     \
                                                                                                                                                    \
+	/* Copy the next submitted frame back to system memory for a screenshot, without stalling the render thread. */                                \
+	/* onCaptured is called on the render thread with an array of both eyes, which must each be released after use; */                             \
+	/* an eye's pixels are null if it couldn't be read. Returns false if the compositors can't do this. */                                         \
+	PREPEND bool CaptureScreenshot(std::function<void(CompositorReadback* eyes)> onCaptured) APPEND;                                               \
+                                                                                                                                                   \
 	/* Misc compositor */                                                                                                                          \
                                                                                                                                                    \
 	/**                                                                                                                                            \
@@ -206,8 +221,11 @@ public:
 	PREPEND IBackend::openvr_enum_t GetMirrorTextureD3D11(vr::EVREye eEye, void* pD3D11DeviceOrResource, void** ppD3D11ShaderResourceView) APPEND; \
 	PREPEND void ReleaseMirrorTextureD3D11(void* pD3D11ShaderResourceView) APPEND;                                                                 \
 	/* #endif */                                                                                                                                   \
-	/** Returns the points of the Play Area. */                                                                                                    \
-	PREPEND bool GetPlayAreaPoints(vr::HmdVector3_t* points, int* count) APPEND;                                                                   \
+	/* Mirror textures in the app's own graphics API, currently only OpenGL. The image is a GL texture name, and */                                \
+	/* belongs to the backend - it stays valid until the app's submitted images change. */                                                         \
+	PREPEND IBackend::openvr_enum_t GetMirrorTexture(vr::ETextureType api, vr::EVREye eEye, uint64_t* pImage) APPEND;                              \
+	/** Returns the shape of the Play Area, or null if it isn't set up. This stays valid until the next call. */                                   \
+	PREPEND const PlayAreaGeometry* GetPlayAreaGeometry() APPEND;                                                                                  \
 	/** Determine whether the bounds are showing right now **/                                                                                     \
 	PREPEND bool AreBoundsVisible() APPEND;                                                                                                        \
 	/** Set the boundaries to be visible or not (although setting this to false shouldn't affect                                                   \
@@ -0,0 +1,379 @@
+#include "stdafx.h"
+
+#include "CallProfiler.h"
+
+#include "Misc/Config.h"
+
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+#include <d3d11.h>
+#endif
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX12)
+#include <d3d12.h>
+#endif
+#ifdef SUPPORT_GL
+#include <GL/gl.h>
+#endif
+#ifdef SUPPORT_GLES
+#include <GLES3/gl32.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+using namespace CallProfiler;
+
+#ifdef OC_CALL_PROFILER
+constinit std::atomic<bool> CallProfiler::active = false;
+constinit std::atomic<bool> CallProfiler::capturing = false;
+#endif
+
+// The configuration Init last read, so NewFrame can tell when it's been reloaded
+static uint32_t configGeneration = 0;
+
+static std::atomic<Function*> functions = nullptr;
+static std::atomic<uint16_t> nextFunctionId = 0;
+
+static uint64_t frames = 0;
+static std::chrono::steady_clock::time_point statsStart = std::chrono::steady_clock::now();
+
+// The capture file's records. Every record starts with its type as a byte, and everything is little-endian.
+// Calls are written out a frame at a time from each thread's buffer, so they're not in order - readers should
+// sort them by their start time, and shouldn't expect a function's record to come before its calls.
+enum CaptureRecord : uint8_t {
+	// u16 function ID, then the function's name, argument types and out-parameters (see Function) as strings
+	// (u16 length then the characters)
+	CAPTURE_FUNCTION = 1,
+
+	// u16 function ID, u32 thread ID, u64 start time, u32 duration, u32 payload length, then the payload (the
+	// arguments, the return value and then the out-parameters, see Scope::Write and Scope::Output). Times are in
+	// nanoseconds since the capture started.
+	CAPTURE_CALL = 2,
+
+	// u64 time, written when WaitGetPoses is called
+	CAPTURE_FRAME = 3,
+};
+
+static const char CAPTURE_MAGIC[8] = { 'O', 'C', 'C', 'A', 'P', 'T', '0', '3' };
+
+// Only held while writing records out, which is once a frame (or when a thread's buffer fills up)
+static std::mutex captureFileLock;
+static std::ofstream captureFile;
+static std::chrono::steady_clock::time_point captureStart;
+
+// A thread's buffer is written out once its records get this big, in case WaitGetPoses isn't being called
+static const size_t THREAD_BUFFER_FLUSH_SIZE = 1024 * 1024;
+
+// The most that's kept of any one out-parameter, anything after that is cut off
+static const uint64_t MAX_OUTPUT_SIZE = 64 * 1024;
+
+struct ThreadBuffer {
+	// Only contended when NewFrame takes the records to write them out
+	std::mutex lock;
+	std::vector<uint8_t> records;
+
+	// Threads are numbered in the order they first make a call, which is much easier to read than their real IDs
+	uint32_t threadId;
+
+	ThreadBuffer* next;
+};
+
+// These are never freed, since NewFrame might be writing one out while its thread exits. A game only has a
+// handful of threads that make OpenVR calls, so that's nothing to worry about.
+static std::atomic<ThreadBuffer*> threadBuffers = nullptr;
+static std::atomic<uint32_t> nextThreadId = 0;
+
+static ThreadBuffer& GetThreadBuffer()
+{
+	static thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer) {
+		buffer = new ThreadBuffer();
+		buffer->threadId = nextThreadId++;
+		buffer->next = threadBuffers.load(std::memory_order_relaxed);
+		while (!threadBuffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+	}
+	return *buffer;
+}
+
+template <typename T>
+static void BufferWrite(std::vector<uint8_t>& out, const T& value)
+{
+	const uint8_t* bytes = (const uint8_t*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+static void BufferWriteString(std::vector<uint8_t>& out, const char* str)
+{
+	uint16_t length = (uint16_t)std::min<size_t>(strlen(str), UINT16_MAX - 1);
+	BufferWrite(out, length);
+	out.insert(out.end(), (const uint8_t*)str, (const uint8_t*)str + length);
+}
+
+// Must be called with captureFileLock held
+static void CaptureWriteRecords(const std::vector<uint8_t>& records)
+{
+	captureFile.write((const char*)records.data(), (std::streamsize)records.size());
+}
+
+// Finds a submitted texture's size and format. This only looks at the texture's description, so it's cheap
+// enough to do on every Submit while capturing.
+static void GetTextureInfo(const vr::Texture_t* texture, uint32_t* width, uint32_t* height, uint32_t* format)
+{
+	switch (texture->eType) {
+#ifdef SUPPORT_VK
+	case vr::TextureType_Vulkan: {
+		const auto* vk = (const vr::VRVulkanTextureData_t*)texture->handle;
+		*width = vk->m_nWidth;
+		*height = vk->m_nHeight;
+		*format = vk->m_nFormat;
+		break;
+	}
+#endif
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+	case vr::TextureType_DirectX: {
+		D3D11_TEXTURE2D_DESC desc;
+		((ID3D11Texture2D*)texture->handle)->GetDesc(&desc);
+		*width = desc.Width;
+		*height = desc.Height;
+		*format = desc.Format;
+		break;
+	}
+#endif
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX12)
+	case vr::TextureType_DirectX12: {
+		D3D12_RESOURCE_DESC desc = ((const vr::D3D12TextureData_t*)texture->handle)->m_pResource->GetDesc();
+		*width = (uint32_t)desc.Width;
+		*height = desc.Height;
+		*format = desc.Format;
+		break;
+	}
+#endif
+#if defined(SUPPORT_GL) || defined(SUPPORT_GLES)
+	case vr::TextureType_OpenGL: {
+		// The game's context is current while it's submitting, but put its binding back the way it was
+		GLint previous = 0, value = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture->handle);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &value);
+		*width = value;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &value);
+		*height = value;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &value);
+		*format = value;
+		glBindTexture(GL_TEXTURE_2D, previous);
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+}
+
+Function::Function(const char* name, const char* args, const char* outputs)
+    : name(name), args(args), outputs(outputs), id(nextFunctionId++)
+{
+	next = functions.load(std::memory_order_relaxed);
+	while (!functions.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {
+	}
+}
+
+static bool OpenCapture()
+{
+	std::string path = oovr_global_configuration->CaptureOpenVRCalls();
+	if (path.empty())
+		return false;
+
+	captureFile.open(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+	if (!captureFile) {
+		OOVR_LOGF("Failed to open '%s' to capture OpenVR calls into", path.c_str());
+		return false;
+	}
+
+	captureFile.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+	captureStart = std::chrono::steady_clock::now();
+
+	OOVR_LOGF("Capturing OpenVR calls into '%s'", path.c_str());
+	return true;
+}
+
+void CallProfiler::Init()
+{
+#ifdef OC_CALL_PROFILER
+	configGeneration = oovr_global_configuration.Generation();
+
+	// captureOpenVRCalls is startup-only, so the file is only ever opened once
+	static bool captureOpened = false;
+	if (!captureOpened) {
+		captureOpened = true;
+		capturing.store(OpenCapture(), std::memory_order_relaxed);
+	}
+
+	active.store(IsCapturing() || oovr_global_configuration->ProfileOpenVRCalls(), std::memory_order_release);
+#endif
+}
+
+Scope::~Scope()
+{
+	auto end = std::chrono::steady_clock::now();
+	uint64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	function->calls.fetch_add(1, std::memory_order_relaxed);
+	function->totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+
+	if (!capturing)
+		return;
+
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::unique_lock<std::mutex> guard(buffer.lock);
+	std::vector<uint8_t>& out = buffer.records;
+
+	if (!function->captureNamed.exchange(true)) {
+		BufferWrite(out, CAPTURE_FUNCTION);
+		BufferWrite(out, function->id);
+		BufferWriteString(out, function->name);
+		BufferWriteString(out, function->args);
+		BufferWriteString(out, function->outputs);
+	}
+
+	BufferWrite(out, CAPTURE_CALL);
+	BufferWrite(out, function->id);
+	BufferWrite(out, buffer.threadId);
+	BufferWrite(out, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start - captureStart).count());
+	BufferWrite(out, (uint32_t)std::min<uint64_t>(durationNs, UINT32_MAX));
+	BufferWrite(out, (uint32_t)payload.size());
+	out.insert(out.end(), payload.begin(), payload.end());
+
+	if (out.size() < THREAD_BUFFER_FLUSH_SIZE)
+		return;
+
+	// Take the records so this thread can carry on adding to its buffer while they're written out
+	std::vector<uint8_t> records;
+	records.swap(out);
+	guard.unlock();
+
+	std::lock_guard<std::mutex> fileGuard(captureFileLock);
+	CaptureWriteRecords(records);
+}
+
+void Scope::WriteString(const char* str)
+{
+	if (!str) {
+		uint16_t length = UINT16_MAX; // Distinguishes null from an empty string
+		WriteBytes(&length, sizeof(length));
+		return;
+	}
+
+	uint16_t length = (uint16_t)std::min<size_t>(strlen(str), UINT16_MAX - 1);
+	WriteBytes(&length, sizeof(length));
+	WriteBytes(str, length);
+}
+
+void Scope::WriteTexture(const vr::Texture_t* texture)
+{
+	// The handle's value is still useful, as it shows when a game switches between textures
+	uint64_t handle = texture ? (uint64_t)(uintptr_t)texture->handle : 0;
+	int32_t type = texture ? (int32_t)texture->eType : -1;
+	int32_t colourSpace = texture ? (int32_t)texture->eColorSpace : -1;
+
+	// The size and format are in the API's own terms (a DXGI_FORMAT, VkFormat or GL internal format), or zero where
+	// they can't be found.
+	uint32_t width = 0, height = 0, format = 0;
+	if (texture && texture->handle)
+		GetTextureInfo(texture, &width, &height, &format);
+
+	WriteBytes(&handle, sizeof(handle));
+	WriteBytes(&type, sizeof(type));
+	WriteBytes(&colourSpace, sizeof(colourSpace));
+	WriteBytes(&width, sizeof(width));
+	WriteBytes(&height, sizeof(height));
+	WriteBytes(&format, sizeof(format));
+}
+
+void Scope::WriteOutput(const void* data, uint64_t size)
+{
+	if (!data) {
+		uint32_t length = UINT32_MAX; // Distinguishes null from an empty buffer
+		WriteBytes(&length, sizeof(length));
+		return;
+	}
+
+	// Don't let a game with a huge buffer (for image data, for example) bloat the capture
+	uint32_t length = (uint32_t)std::min<uint64_t>(size, MAX_OUTPUT_SIZE);
+	WriteBytes(&length, sizeof(length));
+	WriteBytes(data, length);
+}
+
+void Scope::WriteInput(const void* data, uint64_t size)
+{
+	// The address still tells apart the objects a game passes in, as it does for other pointers. The contents are
+	// then written the same way as an out-parameter's.
+	uint64_t address = (uint64_t)(uintptr_t)data;
+	WriteBytes(&address, sizeof(address));
+	WriteOutput(data, size);
+}
+
+void CallProfiler::NewFrame()
+{
+	// Pick up profileOpenVRCalls being switched on or off
+	if (oovr_global_configuration.Generation() != configGeneration)
+		Init();
+
+	if (IsCapturing()) {
+		std::lock_guard<std::mutex> fileGuard(captureFileLock);
+
+		// Swap each thread's records out, so its lock is only held for a moment. The swapped-in vector is the
+		// previous thread's, already cleared, so the buffers keep their capacity rather than growing every frame.
+		std::vector<uint8_t> records;
+		for (ThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+			{
+				std::lock_guard<std::mutex> guard(buffer->lock);
+				records.swap(buffer->records);
+			}
+			CaptureWriteRecords(records);
+			records.clear();
+		}
+
+		uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - captureStart).count();
+		captureFile.put((char)CAPTURE_FRAME);
+		captureFile.write((const char*)&now, sizeof(now));
+
+		// Keep the file up to date, so as little as possible is lost if the game crashes
+		captureFile.flush();
+	}
+
+	if (!oovr_global_configuration->ProfileOpenVRCalls())
+		return;
+
+	frames++;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - statsStart < std::chrono::seconds(10))
+		return;
+
+	struct Total {
+		const char* name;
+		uint64_t calls;
+		uint64_t totalNs;
+	};
+	std::vector<Total> totals;
+	for (Function* func = functions.load(std::memory_order_acquire); func; func = func->next) {
+		Total total = { func->name, func->calls.exchange(0, std::memory_order_relaxed), func->totalNs.exchange(0, std::memory_order_relaxed) };
+		if (total.calls)
+			totals.push_back(total);
+	}
+
+	// Show the functions that took the most time first
+	std::sort(totals.begin(), totals.end(), [](const Total& a, const Total& b) { return a.totalNs > b.totalNs; });
+
+	float seconds = std::chrono::duration<float>(now - statsStart).count();
+	OOVR_LOGF("OpenVR call profile: %d frames in %.1fs, %d functions called", (int)frames, seconds, (int)totals.size());
+	for (const Total& total : totals) {
+		OOVR_LOGF("  %s: %.2f calls/frame, %d ns/call, %.3f ms/frame", total.name, (float)total.calls / frames,
+		    (int)(total.totalNs / total.calls), total.totalNs / 1e6 / frames);
+	}
+
+	frames = 0;
+	statsStart = now;
+}
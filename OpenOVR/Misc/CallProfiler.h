@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Measures how long each OpenVR function takes, when the profileOpenVRCalls option is enabled. The generated
+ * interface stubs put a Scope around every call while IsActive is set, and every few seconds the totals are written to the log along with
+ * how many times each function was called per frame. This makes it easy to see which calls a game's frames are
+ * spending their time in, and to compare that before and after changing a hot path.
+ *
+ * The same scopes also write every call to a file when captureOpenVRCalls is set, with its arguments, return value,
+ * whatever it wrote to its out-parameters and how long it took. That's a compact binary format (see
+ * scripts/call_capture.py, which reads it) so a stuttering game can be captured on someone else's machine and the
+ * slow frames picked apart afterwards. Each thread collects its calls in its own buffer, which are written out
+ * together once per frame, so capturing doesn't make the game's threads wait on each other.
+ */
+namespace CallProfiler {
+
+struct Function {
+	// This adds the function to the list that's logged, so these are static (and live forever)
+	Function(const char* name, const char* args, const char* outputs);
+
+	const char* name;
+	const char* args; // The argument types, written to the capture so the arguments can be decoded
+	const char* outputs; // The indices of the arguments that are out-parameters, separated by commas
+	uint16_t id;
+
+	std::atomic<uint64_t> calls = 0;
+	std::atomic<uint64_t> totalNs = 0;
+	std::atomic<bool> captureNamed = false; // Set once the name has been written to the capture
+
+	Function* next = nullptr;
+};
+
+// Reads the profiling options, and opens the capture file if captureOpenVRCalls is set. Called from VR_Init, and
+// again whenever the configuration is reloaded (see NewFrame).
+void Init();
+
+#ifdef OC_CALL_PROFILER
+// Set if either profiling or capturing is enabled. This is constant-initialised, so checking it costs the stubs one
+// relaxed load, and they don't touch anything else (including their static Function) while it's clear.
+extern constinit std::atomic<bool> active;
+extern constinit std::atomic<bool> capturing;
+
+inline bool IsActive() { return active.load(std::memory_order_relaxed); }
+inline bool IsCapturing() { return capturing.load(std::memory_order_relaxed); }
+#else
+// Built without the profiler, so the stubs' profiling code is compiled out entirely
+constexpr bool IsActive() { return false; }
+constexpr bool IsCapturing() { return false; }
+#endif
+
+/**
+ * An array passed in through a const pointer, so Scope::Arguments knows how much of it to record. The stubs wrap
+ * such arguments with InputArray, using the count from the OpenVR headers' annotations, and the struct size where
+ * the function is given one (as with Output). A count of zero records just the address.
+ */
+template <typename T>
+struct InputArrayArg {
+	const T* value;
+	uint64_t count;
+	uint64_t elementSize;
+};
+
+template <typename T>
+InputArrayArg<T> InputArray(const T* value, uint64_t count, uint64_t elementSize = sizeof(T))
+{
+	return InputArrayArg<T>{ value, count, elementSize };
+}
+
+template <typename T>
+constexpr bool IsInputArray = false;
+template <typename T>
+constexpr bool IsInputArray<InputArrayArg<T>> = true;
+
+class Scope {
+public:
+	// Only created once IsActive has been checked
+	explicit Scope(Function& function)
+	    : function(&function), capturing(IsCapturing()), start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~Scope();
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+	template <typename... Args>
+	void Arguments(const Args&... args)
+	{
+		if (capturing)
+			(Write(args), ...);
+	}
+
+	// Records the return value, and passes it through so the stubs can return it
+	template <typename T>
+	T Returned(T value)
+	{
+		if (capturing)
+			Write(value);
+		return value;
+	}
+
+	/**
+	 * Records what the function wrote into one of its out-parameters, after it's returned. The stubs call this once
+	 * for each out-parameter (in the order listed in the Function), after the return value. It's written as a u32
+	 * byte count (or UINT32_MAX for a null pointer) followed by the contents.
+	 *
+	 * Where a function is given the size of the struct it's filling in, that's passed as elementSize - the game
+	 * might have been built against an older, smaller version of it.
+	 */
+	template <typename T>
+	void Output(const T* value, uint64_t count = 1, uint64_t elementSize = sizeof(T))
+	{
+		if (capturing)
+			WriteOutput(value, value ? count * std::min<uint64_t>(elementSize, sizeof(T)) : 0);
+	}
+
+	// For buffers that aren't typed, such as compressed skeletal data
+	void OutputBuffer(const void* buffer, uint64_t size)
+	{
+		if (capturing)
+			WriteOutput(buffer, size);
+	}
+
+	// For strings, where the buffer size is the most that might have been written
+	void OutputString(const char* str, uint32_t bufferSize)
+	{
+		if (capturing)
+			WriteOutput(str, str ? strnlen(str, bufferSize) : 0);
+	}
+
+private:
+	Function* function;
+	bool capturing;
+	std::chrono::steady_clock::time_point start;
+
+	// The arguments and return value, in the order they were written
+	std::vector<uint8_t> payload;
+
+	void WriteBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		payload.insert(payload.end(), bytes, bytes + size);
+	}
+
+	void WriteString(const char* str);
+	void WriteTexture(const vr::Texture_t* texture);
+	void WriteOutput(const void* data, uint64_t size);
+	void WriteInput(const void* data, uint64_t size);
+
+	/**
+	 * Strings and textures are written out in full, and everything else that's passed by value is written as-is.
+	 * Structs passed in through const pointers (such as an overlay's transform) are written with their address,
+	 * so replaying them can feed the same values back in - see WriteInput.
+	 *
+	 * Other pointers are usually buffers the function fills in, so only their address is kept here - their
+	 * contents are written after the call by Output. The address is still enough to tell apart the objects (such
+	 * as overlay textures) that a game passes in.
+	 */
+	template <typename T>
+	void Write(const T& value)
+	{
+		if constexpr (std::is_same_v<T, const char*>) {
+			WriteString(value);
+		} else if constexpr (std::is_same_v<T, const vr::Texture_t*>) {
+			WriteTexture(value);
+		} else if constexpr (std::is_same_v<T, const vr::VRTextureBounds_t*>) {
+			vr::VRTextureBounds_t bounds = value ? *value : vr::VRTextureBounds_t{ -1, -1, -1, -1 };
+			WriteBytes(&bounds, sizeof(bounds));
+		} else if constexpr (IsInputArray<T>) {
+			uint64_t elementSize = std::min<uint64_t>(value.elementSize, sizeof(*value.value));
+			WriteInput(value.value, value.value ? value.count * elementSize : 0);
+		} else if constexpr (std::is_pointer_v<T> && std::is_class_v<std::remove_pointer_t<T>> && std::is_const_v<std::remove_pointer_t<T>>) {
+			WriteInput(value, value ? sizeof(*value) : 0);
+		} else if constexpr (std::is_pointer_v<T>) {
+			uint64_t address = (uint64_t)(uintptr_t)value;
+			WriteBytes(&address, sizeof(address));
+		} else if constexpr (std::is_trivially_copyable_v<T>) {
+			WriteBytes(&value, sizeof(value));
+		}
+	}
+};
+
+// Called once per frame from WaitGetPoses, to count the frames and write out the stats
+void NewFrame();
+
+} // namespace CallProfiler
@@ -4,21 +4,29 @@
 #include "ini.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <codecvt>
+#include <filesystem>
 #include <locale>
+#include <stdexcept>
 #include <string>
+#include <thread>
 
 #ifdef WIN32
 #include <direct.h>
 #define GetCurrentDir _getcwd
 #else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <unistd.h>
 #define GetCurrentDir getcwd
 #endif
 
 using vr::HmdColor_t;
 
-Config oovr_global_configuration;
+constinit GlobalConfig oovr_global_configuration;
 
 // OOVR_ABORT doesn't work here for some reason
 // TODO Turtle1331 use OOVR_ABORT from logging.h
@@ -35,6 +43,33 @@ Config oovr_global_configuration;
 	}
 #endif
 
+// Thrown by the parse_ functions, and caught in ini_handler before it returns to inih (which is
+// C code, so we can't let exceptions unwind through it).
+class config_parse_error : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// Options which are only read while starting up. Editing them while the game is running has no
+// effect until it's restarted, so reloading keeps the values the game started with.
+#define OC_STARTUP_ONLY_OPTIONS(X) \
+	X(threePartSubmit)             \
+	X(useViewportStencil)          \
+	X(enableLayers)                \
+	X(dx10Mode)                    \
+	X(initUsingVulkan)             \
+	X(enableAudioSwitch)           \
+	X(audioDeviceName)             \
+	X(inputWindowSize)             \
+	X(captureOpenVRCalls)          \
+	X(enableConfigReload)
+
+struct Config::ParseContext {
+	Config* cfg;
+	bool abortOnError;
+	std::string error; // The first error encountered, if abortOnError is false
+};
+
 static string str_tolower(std::string val)
 {
 	transform(val.begin(), val.end(), val.begin(), ::tolower);
@@ -66,7 +101,7 @@ static bool parse_bool(string orig, string name, int line)
 
 	string err = "Value " + orig + " for in config file for " + name + " on line "
 	    + to_string(line) + " is not a boolean - true/on/enabled/false/off/disabled";
-	ABORT(err);
+	throw config_parse_error(err);
 }
 
 static HmdColor_t parse_HmdColor_t(string orig, string name, int line)
@@ -97,7 +132,7 @@ invalid:
 
 	string err = "Value " + orig + " for in config file for " + name + " on line "
 	    + to_string(line) + " is not a hex (CSS) colour code";
-	ABORT(err);
+	throw config_parse_error(err);
 }
 
 static float parse_float(string orig, string name, int line)
@@ -111,7 +146,7 @@ static float parse_float(string orig, string name, int line)
 	if (end != str + orig.length()) {
 		string err = "Value " + orig + " for in config file for " + name + " on line "
 		    + to_string(line) + " is not a decimal number (eg 12.34)";
-		ABORT(err);
+		throw config_parse_error(err);
 	}
 
 	OOVR_LOGF("Setting config param %s to %f", name.c_str(), result);
@@ -127,7 +162,7 @@ static int parse_int(string orig, string name, int line)
 	if (end != str + orig.length()) {
 		string err = "Value " + orig + " for in config file for " + name + " on line "
 		    + to_string(line) + " is not an integer (eg 5)";
-		ABORT(err);
+		throw config_parse_error(err);
 	}
 
 	OOVR_LOGF("Setting config param %s to %d", name.c_str(), result);
@@ -154,12 +189,21 @@ int Config::ini_handler(void* user, const char* pSection,
 	string name = pName;
 	string value = pValue;
 
-	Config* cfg = (Config*)user;
-
-#define CFGOPT(type, vname)                             \
-	if (name == #vname) {                               \
-		cfg->vname = parse_##type(value, name, lineno); \
-		return true;                                    \
+	ParseContext* ctx = (ParseContext*)user;
+	Config* cfg = ctx->cfg;
+
+#define CFGOPT(type, vname)                                 \
+	if (name == #vname) {                                   \
+		try {                                               \
+			cfg->vname = parse_##type(value, name, lineno); \
+		} catch (const config_parse_error& ex) {            \
+			if (ctx->abortOnError)                          \
+				ABORT(ex.what());                           \
+			if (ctx->error.empty())                         \
+				ctx->error = ex.what();                     \
+			return false;                                   \
+		}                                                   \
+		return true;                                        \
 	}
 
 	if (section == "" || section == "default") {
@@ -174,6 +218,9 @@ int Config::ini_handler(void* user, const char* pSection,
 		CFGOPT(bool, logGetTrackedProperty);
 		CFGOPT(bool, stopOnSoftAbort);
 		CFGOPT(bool, enableLayers);
+		CFGOPT(bool, staticOverlays);
+		CFGOPT(bool, skyboxSubmitThread);
+		CFGOPT(bool, spaceWarp);
 		CFGOPT(bool, dx10Mode);
 		CFGOPT(bool, enableAppRequestedCubemap);
 		CFGOPT(bool, enableHiddenMeshFix);
@@ -181,6 +228,8 @@ int Config::ini_handler(void* user, const char* pSection,
 		CFGOPT(bool, initUsingVulkan);
 		CFGOPT(float, hiddenMeshVerticalScale);
 		CFGOPT(bool, logAllOpenVRCalls);
+		CFGOPT(bool, profileOpenVRCalls);
+		CFGOPT(string, captureOpenVRCalls);
 		CFGOPT(bool, enableAudioSwitch);
 		CFGOPT(string, audioDeviceName);
 		CFGOPT(bool, enableInputSmoothing);
@@ -219,12 +268,17 @@ int Config::ini_handler(void* user, const char* pSection,
 		CFGOPT(float, rotSmoothMinCutoff);
 		CFGOPT(float, posSmoothBeta);
 		CFGOPT(float, rotSmoothBeta);
+		CFGOPT(bool, enableConfigReload);
 	}
 
 #undef CFGOPT
 
 	string err = "Unknown config option " + name + " on line " + to_string(lineno);
-	ABORT(err);
+	if (ctx->abortOnError)
+		ABORT(err);
+	if (ctx->error.empty())
+		ctx->error = err;
+	return false;
 }
 
 static int wini_parse(const wchar_t* filename, ini_handler handler, void* user)
@@ -251,16 +305,10 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 #define HINST_THISCOMPONENT ((HINSTANCE) & __ImageBase)
 #endif
 
-Config::Config()
-{
-	// Initialise using Vulkan if D3D11 is unavailable
-#if !defined(SUPPORT_DX11)
-	initUsingVulkan = true;
-#endif
-
-	// If we're on Windows, look for a config file next to the DLL
-	// If we're on Linux, skip that and just check the working directory.
 #ifdef _WIN32
+// The directory containing our DLL, with a trailing slash
+static wstring module_dir()
+{
 	wchar_t buffer[MAX_PATH];
 	DWORD len = GetModuleFileNameW(HINST_THISCOMPONENT, buffer, sizeof(buffer));
 
@@ -273,11 +321,58 @@ Config::Config()
 			dir = fname.substr(0, slash_index + 1);
 		}
 	}
+	return dir;
+}
+#endif
+
+static wstring working_dir_file(const wchar_t* name)
+{
+	char buff[FILENAME_MAX];
+	GetCurrentDir(buff, FILENAME_MAX);
+	wstring file = wstring(&buff[0], &buff[strlen(buff)]);
+#ifdef _WIN32
+	file += L"\\";
+#else
+	file += L"/";
+#endif
+	return file + name;
+}
+
+// All the files the configuration can be read from, in the order they're read
+static std::vector<wstring> config_file_paths()
+{
+	std::vector<wstring> paths;
+#ifdef _WIN32
+	paths.push_back(module_dir() + L"opencomposite.ini");
+#endif
+	paths.push_back(working_dir_file(L"opencomposite.ini"));
+	paths.push_back(working_dir_file(L"opencomposite_ext.ini"));
+	return paths;
+}
+
+Config::Config()
+{
+	// Initialise using Vulkan if D3D11 is unavailable
+#if !defined(SUPPORT_DX11)
+	initUsingVulkan = true;
+#endif
+}
 
+Config::~Config()
+{
+}
+
+std::string Config::Load(bool abortOnError)
+{
+	ParseContext ctx = { this, abortOnError, {} };
+
+	// If we're on Windows, look for a config file next to the DLL
+	// If we're on Linux, skip that and just check the working directory.
+#ifdef _WIN32
 	OOVR_LOG("Checking for global config file...");
 	OOVR_LOG("Version 1.9");
-	wstring file = dir + L"opencomposite.ini";
-	int err = wini_parse(file.c_str(), ini_handler, this);
+	wstring file = module_dir() + L"opencomposite.ini";
+	int err = wini_parse(file.c_str(), ini_handler, &ctx);
 #else
 	int err = -1;
 	wstring file;
@@ -286,56 +381,287 @@ Config::Config()
 	if (err == -1 || err == 0) {
 		// No such file or it was parsed successfully, check the working directory
 		// for a file that overrides some properties
-		char buff[FILENAME_MAX];
-		GetCurrentDir(buff, FILENAME_MAX);
-		file = wstring(&buff[0], &buff[strlen(buff)]);
-#ifdef _WIN32
-		file += L"\\opencomposite.ini";
-#else
-		file += L"/opencomposite.ini";
-#endif
+		file = working_dir_file(L"opencomposite.ini");
 		OOVR_LOG("Checking for app specific config file...");
-		err = wini_parse(file.c_str(), ini_handler, this);
+		err = wini_parse(file.c_str(), ini_handler, &ctx);
 	}
 
 	if (err == -1) {
 		// Couldn't open file, no problem since the config file is optional and
 		//  the defaults are set up as the default values for the variables
-		return;
+		return "";
 	} else if (err) {
 		// err is the line number
 		string str = "Config error on line " + to_string(err);
-		ABORT(str);
+		if (abortOnError)
+			ABORT(str);
+		return ctx.error.empty() ? str : ctx.error;
 	}
 
 	if (err == -1 || err == 0) {
 		// No such file or it was parsed successfully, check the working directory
 		// for a file that overrides some properties
-		char buff[FILENAME_MAX];
-		GetCurrentDir(buff, FILENAME_MAX);
-		file = wstring(&buff[0], &buff[strlen(buff)]);
-#ifdef _WIN32
-		file += L"\\opencomposite_ext.ini";
-#else
-		file += L"/opencomposite_ext.ini";
-#endif
+		file = working_dir_file(L"opencomposite_ext.ini");
 		OOVR_LOG("Checking for app specific extended config file...");
-		err = wini_parse(file.c_str(), ini_handler, this);
+		err = wini_parse(file.c_str(), ini_handler, &ctx);
 	}
 
 	if (err == -1) {
 		// Couldn't open file, no problem since the config file is optional and
 		//  the defaults are set up as the default values for the variables
-		return;
+		return "";
 	} else if (err) {
 		// err is the line number
 		string str = "Config error on line " + to_string(err);
-		ABORT(str);
+		if (abortOnError)
+			ABORT(str);
+		return ctx.error.empty() ? str : ctx.error;
 	}
 
 	// Everything should have been set up by ini_handler
+	return "";
 }
 
-Config::~Config()
+void Config::KeepStartupOnlyOptions(const Config& running)
 {
+#define KEEP_OPTION(vname)                                                                                  \
+	if (vname != running.vname) {                                                                           \
+		OOVR_LOG("Config option " #vname " can only be set at startup - restart the game for it to apply"); \
+	}                                                                                                       \
+	vname = running.vname;
+
+	OC_STARTUP_ONLY_OPTIONS(KEEP_OPTION)
+
+#undef KEEP_OPTION
 }
+
+// Hot reloading
+
+// The modification time of each config file, or the minimum value if it doesn't exist
+static std::vector<std::filesystem::file_time_type> config_file_stamps(const std::vector<wstring>& paths)
+{
+	std::vector<std::filesystem::file_time_type> stamps;
+	for (const wstring& path : paths) {
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(std::filesystem::path(path), ec);
+		stamps.push_back(ec ? std::filesystem::file_time_type::min() : time);
+	}
+	return stamps;
+}
+
+struct GlobalConfig::Watcher {
+	std::vector<wstring> paths;
+	std::vector<std::filesystem::file_time_type> stamps;
+	std::thread thread;
+
+#ifdef _WIN32
+	HANDLE stopEvent = nullptr;
+#else
+	int stopFd = -1;
+#endif
+
+	void Run(GlobalConfig* owner);
+
+	// Returns true if any of the config files was created, deleted or modified since the last call
+	bool CheckChanged()
+	{
+		auto newStamps = config_file_stamps(paths);
+		if (newStamps == stamps)
+			return false;
+		stamps = std::move(newStamps);
+		return true;
+	}
+};
+
+GlobalConfig::~GlobalConfig()
+{
+	// If we're being unloaded without VR_Shutdown being called, don't try joining the
+	// thread - on Windows that can deadlock on the loader lock. Just let it die with the process.
+	if (watcher && watcher->thread.joinable()) {
+		watcher->thread.detach();
+		(void)watcher.release(); // Leaked, since the thread is still using it
+	}
+
+	delete current.load();
+}
+
+const Config* GlobalConfig::LoadInitial() const
+{
+	std::call_once(initialLoad, [this]() {
+		Config* cfg = new Config();
+		cfg->Load(true);
+		current.store(cfg, std::memory_order_release);
+	});
+	return current.load(std::memory_order_acquire);
+}
+
+void GlobalConfig::Reload()
+{
+	const Config* running = &Get();
+
+	std::unique_ptr<Config> cfg = std::make_unique<Config>();
+	std::string error = cfg->Load(false);
+	if (!error.empty()) {
+		OOVR_LOGF("Ignoring edited config file, keeping the previous settings: %s", error.c_str());
+		return;
+	}
+
+	cfg->KeepStartupOnlyOptions(*running);
+
+	// The new snapshot owns the old one so it stays valid for anyone still reading it
+	cfg->previous.reset(running);
+	current.store(cfg.release(), std::memory_order_release);
+	generation.fetch_add(1, std::memory_order_acq_rel);
+
+	OOVR_LOG("Reloaded configuration");
+}
+
+void GlobalConfig::StartWatching()
+{
+	if (watcher || !Get().EnableConfigReload())
+		return;
+
+	watcher = std::make_unique<Watcher>();
+	watcher->paths = config_file_paths();
+	watcher->stamps = config_file_stamps(watcher->paths);
+
+#ifdef _WIN32
+	watcher->stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!watcher->stopEvent) {
+		OOVR_LOGF("Failed to create config watcher stop event, error %d - config reloading disabled", GetLastError());
+		watcher.reset();
+		return;
+	}
+#else
+	watcher->stopFd = eventfd(0, EFD_CLOEXEC);
+	if (watcher->stopFd == -1) {
+		OOVR_LOGF("Failed to create config watcher eventfd, errno %d - config reloading disabled", errno);
+		watcher.reset();
+		return;
+	}
+#endif
+
+	watcher->thread = std::thread(&Watcher::Run, watcher.get(), this);
+}
+
+void GlobalConfig::StopWatching()
+{
+	if (!watcher)
+		return;
+
+#ifdef _WIN32
+	SetEvent(watcher->stopEvent);
+	watcher->thread.join();
+	CloseHandle(watcher->stopEvent);
+#else
+	uint64_t one = 1;
+	if (write(watcher->stopFd, &one, sizeof(one)) != sizeof(one))
+		OOVR_ABORTF("Failed to signal config watcher to stop, errno %d", errno);
+	watcher->thread.join();
+	close(watcher->stopFd);
+#endif
+
+	watcher.reset();
+}
+
+// Editors often write a file in several steps (truncate then write, or write a temporary file and
+// rename it over the original), so wait for things to settle before reading it.
+static constexpr std::chrono::milliseconds RELOAD_SETTLE_TIME{ 250 };
+
+#ifdef _WIN32
+void GlobalConfig::Watcher::Run(GlobalConfig* owner)
+{
+	std::vector<HANDLE> handles = { stopEvent };
+
+	// Watch each directory a config file might be in. This includes changes to every other file
+	// in those directories too, so CheckChanged filters out the ones we don't care about.
+	std::vector<wstring> dirs;
+	for (const wstring& path : paths) {
+		wstring dir = std::filesystem::path(path).parent_path().wstring();
+		if (std::find(dirs.begin(), dirs.end(), dir) != dirs.end())
+			continue;
+		dirs.push_back(dir);
+
+		HANDLE handle = FindFirstChangeNotificationW(dir.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+		if (handle == INVALID_HANDLE_VALUE) {
+			OOVR_LOGF("Failed to watch directory for config changes, error %d", GetLastError());
+			continue;
+		}
+		handles.push_back(handle);
+	}
+
+	while (true) {
+		DWORD result = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, INFINITE);
+		if (result == WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + handles.size())
+			break;
+
+		FindNextChangeNotification(handles.at(result - WAIT_OBJECT_0));
+
+		if (WaitForSingleObject(stopEvent, (DWORD)RELOAD_SETTLE_TIME.count()) == WAIT_OBJECT_0)
+			break;
+
+		if (CheckChanged())
+			owner->Reload();
+	}
+
+	for (size_t i = 1; i < handles.size(); i++)
+		FindCloseChangeNotification(handles.at(i));
+}
+#else
+void GlobalConfig::Watcher::Run(GlobalConfig* owner)
+{
+	int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd == -1) {
+		OOVR_LOGF("Failed to set up inotify, errno %d - config reloading disabled", errno);
+		return;
+	}
+
+	// Watch the directory rather than the files themselves, as they might not exist yet and
+	// editors that save by renaming a new file over the old one would leave us watching a dead inode.
+	for (const wstring& path : paths) {
+		std::string dir = std::filesystem::path(path).parent_path().string();
+		uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM;
+		if (inotify_add_watch(inotifyFd, dir.c_str(), mask) == -1) {
+			OOVR_LOGF("Failed to watch directory %s for config changes, errno %d", dir.c_str(), errno);
+		}
+	}
+
+	pollfd fds[2] = {
+		{ stopFd, POLLIN, 0 },
+		{ inotifyFd, POLLIN, 0 },
+	};
+
+	// Throw away all the pending events. We only use them as a wakeup, and check what actually
+	// changed with CheckChanged - that also filters out all the other files in the directory.
+	auto drain = [inotifyFd]() {
+		alignas(inotify_event) char buffer[4096];
+		while (read(inotifyFd, buffer, sizeof(buffer)) > 0) {
+		}
+	};
+
+	while (true) {
+		if (poll(fds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			OOVR_LOGF("Config watcher poll failed, errno %d", errno);
+			break;
+		}
+
+		if (fds[0].revents)
+			break;
+
+		drain();
+
+		// Wait for the editor to finish, but still wake up promptly if we're being stopped
+		if (poll(fds, 1, (int)RELOAD_SETTLE_TIME.count()) > 0)
+			break;
+
+		drain();
+
+		if (CheckChanged())
+			owner->Reload();
+	}
+
+	close(inotifyFd);
+}
+#endif
@@ -1,5 +1,16 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * An immutable snapshot of the settings in opencomposite.ini.
+ *
+ * Fetch the current snapshot through oovr_global_configuration each time it's needed rather than
+ * holding onto one, as they're replaced when the config file is edited while the game is running.
+ */
 class Config {
 public:
 	Config();
@@ -16,6 +27,9 @@ public:
 	inline bool LogGetTrackedProperty() const { return logGetTrackedProperty; }
 	inline bool StopOnSoftAbort() const { return stopOnSoftAbort; }
 	inline bool EnableLayers() const { return enableLayers; }
+	inline bool StaticOverlays() const { return staticOverlays; }
+	inline bool SkyboxSubmitThread() const { return skyboxSubmitThread; }
+	inline bool SpaceWarp() const { return spaceWarp; }
 	inline bool DX10Mode() const { return dx10Mode; }
 	inline bool EnableAppRequestedCubemap() const { return enableAppRequestedCubemap; }
 	inline bool EnableHiddenMeshFix() const { return enableHiddenMeshFix; }
@@ -23,15 +37,17 @@ public:
 	inline bool InitUsingVulkan() const { return initUsingVulkan; }
 	float HiddenMeshVerticalScale() const { return hiddenMeshVerticalScale; }
 	inline bool LogAllOpenVRCalls() const { return logAllOpenVRCalls; }
+	inline bool ProfileOpenVRCalls() const { return profileOpenVRCalls; }
+	std::string CaptureOpenVRCalls() const { return captureOpenVRCalls; }
 	inline bool EnableAudioSwitch() const { return enableAudioSwitch; }
 	std::string AudioDeviceName() const { return audioDeviceName; }
-	inline bool EnableInputSmoothing() { return enableInputSmoothing; }
+	inline bool EnableInputSmoothing() const { return enableInputSmoothing; }
 	int InputWindowSize() const { return inputWindowSize; }
-	inline bool AdjustTilt() { return adjustTilt; }
-	inline bool AdjustLeftRotation() { return adjustLeftRotation; }
-	inline bool AdjustRightRotation() { return adjustRightRotation; }
-	inline bool AdjustLeftPosition() { return adjustLeftPosition; }
-	inline bool AdjustRightPosition() { return adjustRightPosition; }
+	inline bool AdjustTilt() const { return adjustTilt; }
+	inline bool AdjustLeftRotation() const { return adjustLeftRotation; }
+	inline bool AdjustRightRotation() const { return adjustRightRotation; }
+	inline bool AdjustLeftPosition() const { return adjustLeftPosition; }
+	inline bool AdjustRightPosition() const { return adjustRightPosition; }
 	float Tilt() const { return tilt; }
 	float LeftXRotation() const { return leftXRotation; }
 	float LeftYRotation() const { return leftYRotation; }
@@ -51,18 +67,30 @@ public:
 	float RightDeadZoneSize() const { return rightDeadZoneSize; }
 	float RightDeadZoneXSize() const { return rightDeadZoneXSize; }
 	float RightDeadZoneYSize() const { return rightDeadZoneYSize; }
-	inline bool DisableTriggerTouch() { return disableTriggerTouch; }
-	float HapticStrength() { return hapticStrength; }
-	inline bool DisableTrackPad() { return disableTrackPad; }
-	inline bool EnableControllerSmoothing() { return enableControllerSmoothing; }
-	inline bool EnableVRIKKnucklesTrackPadSupport() { return enableVRIKKnucklesTrackPadSupport; }
-	std::string KeyboardText() { return keyboardText; }
-	float PosSmoothMinCutoff() { return posSmoothMinCutoff; }
-	float RotSmoothMinCutoff() { return rotSmoothMinCutoff; }
-	float PosSmoothBeta() { return posSmoothBeta; }
-	float RotSmoothBeta() { return rotSmoothBeta; }
+	inline bool DisableTriggerTouch() const { return disableTriggerTouch; }
+	float HapticStrength() const { return hapticStrength; }
+	inline bool DisableTrackPad() const { return disableTrackPad; }
+	inline bool EnableControllerSmoothing() const { return enableControllerSmoothing; }
+	inline bool EnableVRIKKnucklesTrackPadSupport() const { return enableVRIKKnucklesTrackPadSupport; }
+	std::string KeyboardText() const { return keyboardText; }
+	float PosSmoothMinCutoff() const { return posSmoothMinCutoff; }
+	float RotSmoothMinCutoff() const { return rotSmoothMinCutoff; }
+	float PosSmoothBeta() const { return posSmoothBeta; }
+	float RotSmoothBeta() const { return rotSmoothBeta; }
+	inline bool EnableConfigReload() const { return enableConfigReload; }
 
 private:
+	friend class GlobalConfig;
+	struct ParseContext;
+
+	// Read the config files on top of the current values. Returns an empty string on success, or
+	// a description of the error if abortOnError is false and something went wrong.
+	std::string Load(bool abortOnError);
+
+	// Copy over the options that are only read at startup from the configuration the game started with,
+	// since changing them while running would have no effect (or worse, leave things half-applied).
+	void KeepStartupOnlyOptions(const Config& running);
+
 	static int ini_handler(
 	    void* user, const char* section,
 	    const char* name, const char* value,
@@ -83,6 +111,15 @@ private:
 	//  if this is game-specific, or if it's a problem with the layer system
 	bool enableLayers = true;
 
+	// Off by default, since an app could legitimately redraw into the same texture without telling us
+	bool staticOverlays = false;
+
+	// Off by default, since the runtime may touch the app's graphics queue from our thread while the app is using it
+	bool skyboxSubmitThread = false;
+
+	// Off by default, since it halves the game's frame rate and relies on the runtime to fill in the gaps
+	bool spaceWarp = false;
+
 	bool dx10Mode = false;
 	bool enableAppRequestedCubemap = true;
 	bool enableHiddenMeshFix = true;
@@ -90,6 +127,8 @@ private:
 	bool initUsingVulkan = false;
 	float hiddenMeshVerticalScale = 1.0f;
 	bool logAllOpenVRCalls = false;
+	bool profileOpenVRCalls = false;
+	std::string captureOpenVRCalls = "";
 	bool enableAudioSwitch = false;
 	std::string audioDeviceName = "";
 	bool enableInputSmoothing = false;
@@ -133,6 +172,63 @@ private:
 	float rotSmoothMinCutoff = 1.5;
 	float rotSmoothBeta = 0.2;
 	std::string keyboardText = "Adventurer";
+	bool enableConfigReload = true;
+
+	// The snapshot this one replaced, which is kept alive since other threads may still be using it.
+	std::unique_ptr<const Config> previous;
+};
+
+/**
+ * Holds the current configuration snapshot, and optionally watches the config files so they can be
+ * edited without restarting the game.
+ *
+ * Reading the configuration is lock-free: reloading parses the file into a new Config on a background
+ * thread, and swaps it in with a single atomic store. Old snapshots are kept alive until the process
+ * exits, since another thread may still be reading one. Reloads only happen when someone edits a file,
+ * so that's not going to add up to anything.
+ */
+class GlobalConfig {
+public:
+	constexpr GlobalConfig() = default;
+	~GlobalConfig();
+
+	GlobalConfig(const GlobalConfig&) = delete;
+	GlobalConfig& operator=(const GlobalConfig&) = delete;
+
+	inline const Config* operator->() const
+	{
+		const Config* cfg = current.load(std::memory_order_acquire);
+		if (cfg)
+			return cfg;
+		return LoadInitial();
+	}
+
+	inline const Config& Get() const { return *operator->(); }
+
+	/**
+	 * Incremented every time a new configuration is swapped in. Code that derives state from the
+	 * configuration (for example, filter parameters) can compare this to see if it's out of date.
+	 */
+	inline uint32_t Generation() const { return generation.load(std::memory_order_acquire); }
+
+	// Start or stop the background thread that reloads the configuration when the files change.
+	// These must only be called from the thread initialising or shutting down OpenComposite.
+	void StartWatching();
+	void StopWatching();
+
+private:
+	struct Watcher;
+
+	const Config* LoadInitial() const;
+	void Reload();
+
+	// These are mutable so the first snapshot can be lazily loaded from the const accessors. Some
+	// of our static initialisers read the configuration, and we can't control what order they run in.
+	mutable std::atomic<const Config*> current{ nullptr };
+	mutable std::once_flag initialLoad;
+	std::atomic<uint32_t> generation{ 0 };
+
+	std::unique_ptr<Watcher> watcher;
 };
 
-extern Config oovr_global_configuration;
+extern constinit GlobalConfig oovr_global_configuration;
@@ -159,38 +159,41 @@ glm::mat4 InteractionProfile::CreateRotationMatrix(float xDegrees, float yDegree
 
 glm::mat4 InteractionProfile::GetGripToSteamVRTransform(ITrackedDevice::HandType hand) const
 {
-	bool adjustLeftRotation = oovr_global_configuration.AdjustLeftRotation();
-	bool adjustRightRotation = oovr_global_configuration.AdjustRightRotation();
-	bool adjustLeftPosition = oovr_global_configuration.AdjustLeftPosition();
-	bool adjustRightPosition = oovr_global_configuration.AdjustRightPosition();
-	bool adjustTilt = oovr_global_configuration.AdjustTilt();
-	float tiltDegrees = oovr_global_configuration.Tilt();
+	// Read everything from the same snapshot, in case the config is reloaded while we're running
+	const Config& cfg = oovr_global_configuration.Get();
+
+	bool adjustLeftRotation = cfg.AdjustLeftRotation();
+	bool adjustRightRotation = cfg.AdjustRightRotation();
+	bool adjustLeftPosition = cfg.AdjustLeftPosition();
+	bool adjustRightPosition = cfg.AdjustRightPosition();
+	bool adjustTilt = cfg.AdjustTilt();
+	float tiltDegrees = cfg.Tilt();
 
 	float positionLeft[3] = { 0.0, 0.0, 0.0 };
 	float rotationLeft[3] = { 0.0, 0.0, 0.0 };
 	if (adjustLeftPosition) {
-		positionLeft[0] = oovr_global_configuration.LeftXPosition();
-		positionLeft[1] = oovr_global_configuration.LeftYPosition();
-		positionLeft[2] = oovr_global_configuration.LeftZPosition();
+		positionLeft[0] = cfg.LeftXPosition();
+		positionLeft[1] = cfg.LeftYPosition();
+		positionLeft[2] = cfg.LeftZPosition();
 	}
 	if (adjustLeftRotation) {
-		rotationLeft[0] = oovr_global_configuration.LeftXRotation();
-		rotationLeft[1] = oovr_global_configuration.LeftYRotation();
-		rotationLeft[2] = oovr_global_configuration.LeftZRotation();
+		rotationLeft[0] = cfg.LeftXRotation();
+		rotationLeft[1] = cfg.LeftYRotation();
+		rotationLeft[2] = cfg.LeftZRotation();
 	}
 	CustomObject ctrlTransformLeft("adjust_left", positionLeft, rotationLeft);
 
 	float positionRight[3] = { 0.0, 0.0, 0.0 };
 	float rotationRight[3] = { 0.0, 0.0, 0.0 };
 	if (adjustRightPosition) {
-		positionRight[0] = oovr_global_configuration.RightXPosition();
-		positionRight[1] = oovr_global_configuration.RightYPosition();
-		positionRight[2] = oovr_global_configuration.RightZPosition();
+		positionRight[0] = cfg.RightXPosition();
+		positionRight[1] = cfg.RightYPosition();
+		positionRight[2] = cfg.RightZPosition();
 	}
 	if (adjustRightRotation) {
-		rotationRight[0] = oovr_global_configuration.RightXRotation();
-		rotationRight[1] = oovr_global_configuration.RightYRotation();
-		rotationRight[2] = oovr_global_configuration.RightZRotation();
+		rotationRight[0] = cfg.RightXRotation();
+		rotationRight[1] = cfg.RightYRotation();
+		rotationRight[2] = cfg.RightZRotation();
 	}
 	CustomObject ctrlTransformRight("adjust_right", positionRight, rotationRight);
 
@@ -38,6 +38,11 @@ public:
 	 */
 	void Blit(wchar_t ch, int x, int y, int img_width, pix_t targetColour, pix_t* rawPixels, bool hpad = true);
 
+	bool HasChar(wchar_t ch) { return chars.count(ch) != 0; }
+
+	// Where a character is in the font image and where it goes when drawn, for working out what Blit will touch
+	const CharInfo& GetCharInfo(wchar_t ch) const { return chars.at(ch); }
+
 	int Width(wchar_t ch);
 	int Width(std::wstring str);
 
@@ -2,11 +2,10 @@
 
 #include "VRKeyboard.h"
 
-#ifndef OC_XR_PORT
-#include <d3d11.h>
-#endif
-
+#include "Compositor/compositor.h"
+#include "Drivers/Backend.h"
 #include "Reimpl/BaseCompositor.h"
+#include "Reimpl/BaseInput.h"
 #include "Reimpl/BaseSystem.h"
 #include "generated/static_bases.gen.h"
 
@@ -15,17 +14,18 @@
 
 #include "resources.h"
 
+#include <algorithm>
 #include <vector>
 
-#ifdef _WIN32
-#pragma comment(lib, "d3d11.lib")
+#include <glm/gtc/quaternion.hpp>
 
-// for debugging only for now
-#include <comdef.h>
-#endif
+// The size of the keyboard's swapchain, and of the quad it's shown on
+static const int CANVAS_WIDTH = 1024;
+static const int CANVAS_HEIGHT = 512;
+static const float QUAD_WIDTH = 0.6f;
+static const float QUAD_HEIGHT = QUAD_WIDTH * CANVAS_HEIGHT / CANVAS_WIDTH;
 
-// If you're working on the keyboard, it may be useful to have it headlocked so you can easily see it in the Oculus mirror
-static const bool DBG_STUCK_TO_FACE = false;
+static const int PADDING = 8;
 
 static std::vector<char> loadResource(int rid, int type)
 {
@@ -53,132 +53,130 @@ static std::vector<char> loadResource(int rid, int type)
 
 	return std::vector<char>(cstr, cstr + len);
 #else
-#ifdef OC_XR_PORT
-	XR_STUBBED();
-#else
-#error TODO implement keyboard font loading on Linux
-#endif
+	// Resources don't have types on Linux, they all have their own IDs
+	const char *start = nullptr, *end = nullptr;
+	FindResourceLinux(rid, &start, &end);
+	return std::vector<char>(start, end);
 #endif
 }
 
 std::wstring_convert<std::codecvt_utf8<wchar_t>> VRKeyboard::CHAR_CONV;
 
-#ifndef OC_XR_PORT
+bool VRKeyboard::KeyState::operator==(const KeyState& other) const
+{
+	return hovered[0] == other.hovered[0] && hovered[1] == other.hovered[1] && pressed == other.pressed
+	    && highlighted == other.highlighted && shifted == other.shifted;
+}
+
+bool VRKeyboard::CanCreate()
+{
+	// We need to know which graphics API the app is using before we can create a swapchain, and the keyboard is
+	// drawn in system memory so that API has to support uploading from there (D3D12 and dx10Mode don't). The system
+	// interface is where the keyboard gets the tracking space it's placed in.
+	return GetUnsafeBaseCompositor() && GetUnsafeBaseSystem() && BackendManager::Instance().IsGraphicsConfigured() && BaseCompositor::SupportsRawUpload();
+}
 
-VRKeyboard::VRKeyboard(ID3D11Device* dev, uint64_t userValue, uint32_t maxLength, bool minimal, eventDispatch_t eventDispatch,
+VRKeyboard::VRKeyboard(uint64_t userValue, uint32_t maxLength, bool minimal, eventDispatch_t eventDispatch,
     EGamepadTextInputMode inputMode)
-    : dev(dev), userValue(userValue), maxLength(maxLength), minimal(minimal), eventDispatch(eventDispatch), inputMode(inputMode)
+    : userValue(userValue), maxLength(maxLength), minimal(minimal), eventDispatch(eventDispatch), inputMode(inputMode)
 {
+	compositor.reset(BaseCompositor::CreateRawCompositorAPI());
+	if (!compositor)
+		OOVR_ABORT("Keyboard: drawing from system memory is not supported with this graphics API");
+
+	// The glyph atlas only has to be decoded once, rather than every time the keyboard is opened
+	static std::shared_ptr<SudoFontMeta> sharedFont;
+	if (!sharedFont)
+		sharedFont = std::make_shared<SudoFontMeta>(loadResource(RES_O_FNT_UBUNTU, RES_T_FNTMETA), loadResource(RES_O_FNT_UBUNTU_TEXTURE, RES_T_PNG));
+	font = sharedFont;
 
-	std::shared_ptr<BaseCompositor> cmp = GetBaseCompositor();
-	if (!cmp)
-		OOVR_ABORT("Keyboard: Compositor must be active!");
-
-	if (!dev)
-		OOVR_ABORT("Keyboard currently only works on DX11, and game must have submitted at least a single frame");
-
-	if (inputMode == EGamepadTextInputMode::k_EGamepadTextInputModePassword)
-		OOVR_ABORT("Password input mode not yet supported!");
-
-	// zero stuff out
-	memset(lastInputTime, 0, sizeof(lastInputTime));
-	memset(repeatCount, 0, sizeof(repeatCount));
-	memset(selected, 0, sizeof(selected));
-	memset(lastButtonState, 0, sizeof(lastButtonState));
-
-	// D3D setup
-	dev->GetImmediateContext(&ctx);
-
-	Sizei bufferSize(1024, 512);
-
-	ovrTextureSwapChainDesc& desc = chainDesc;
-	desc = {};
-	desc.Type = ovrTexture_2D;
-	desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
-	desc.ArraySize = 1;
-	desc.Width = bufferSize.w;
-	desc.Height = bufferSize.h;
-	desc.MipLevels = 1;
-	desc.SampleCount = 1;
-	desc.StaticImage = ovrFalse;
-	desc.MiscFlags = ovrTextureMisc_None;
-	desc.BindFlags = ovrTextureBind_None;
-
-	OOVR_FAILED_OVR_ABORT(ovr_CreateTextureSwapChainDX(*ovr::session, dev, &desc, &chain));
-
-	// Create HUD layer, fixed to the player's torso
-	memset(&layer, 0, sizeof(layer));
-	layer.Header.Type = ovrLayerType_Quad;
-	layer.Header.Flags = DBG_STUCK_TO_FACE ? ovrLayerFlag_HeadLocked : 0; // | ovrLayerFlag_HighQuality;;
-	layer.ColorTexture = chain;
-	// 50cm in front and 20cm down from the player's nose,
-	// fixed relative to their torso.
-	layer.QuadPoseCenter.Position.x = 0.00f;
-	layer.QuadPoseCenter.Position.y = 0.00f; // -0.20f;
-	layer.QuadPoseCenter.Position.z = -0.50f;
-	layer.QuadPoseCenter.Orientation.x = 0;
-	layer.QuadPoseCenter.Orientation.y = 0;
-	layer.QuadPoseCenter.Orientation.z = 0;
-	layer.QuadPoseCenter.Orientation.w = 1;
-	// HUD is 50cm wide, 30cm tall.
-	layer.QuadSize.x = 0.50f;
-	layer.QuadSize.y = 0.30f;
-
-	// Display all of the HUD texture.
-	layer.Viewport.Pos.x = 0;
-	layer.Viewport.Pos.y = 0;
-	layer.Viewport.Size.w = desc.Width;
-	layer.Viewport.Size.h = desc.Height;
-
-	font = make_unique<SudoFontMeta>(loadResource(RES_O_FNT_UBUNTU, RES_T_FNTMETA), loadResource(RES_O_FNT_UBUNTU, RES_T_PNG));
 	layout = make_unique<KeyboardLayout>(loadResource(RES_O_KB_EN_GB, RES_T_KBLAYOUT));
 
-	if (!DBG_STUCK_TO_FACE) {
-		BaseCompositor* comp = GetUnsafeBaseCompositor();
-		vr::TrackedDevicePose_t spose = { 0 };
-		comp->GetLastPoses(&spose, 1, nullptr, 0);
+	// Work out where all the keys go up-front, since they never move
+	int kbWidth = layout->GetWidth();
+	int keySize = ((CANVAS_WIDTH - PADDING) / kbWidth) - PADDING;
+
+	int keyAreaBaseY = minimal ? PADDING : PADDING + keySize + PADDING;
+	for (const KeyboardLayout::Key& key : layout->GetKeymap()) {
+		KeyRect rect;
+		rect.x = PADDING + (int)((keySize + PADDING) * key.x);
+		rect.y = keyAreaBaseY + (int)((keySize + PADDING) * key.y);
+		rect.width = (int)(keySize * key.w);
+		rect.height = (int)(keySize * key.h);
 
-		OVR::Posef offset(OVR::Quatf::Identity(), OVR::Vector3f(0.0f, 0.0f, -1.0f));
-		OVR::Posef headPose = S2O_om34_pose(spose.mDeviceToAbsoluteTracking);
-		layer.QuadPoseCenter = headPose * offset;
+		if (key.spansToRight) {
+			rect.width = CANVAS_WIDTH - PADDING - rect.x;
+		}
+
+		keyRects.push_back(rect);
 	}
-}
 
-VRKeyboard::~VRKeyboard()
-{
-	if (ctx)
-		ctx->Release();
-}
+	textRect = { PADDING, PADDING, CANVAS_WIDTH - PADDING * 2, keySize };
 
-#else
-VRKeyboard::~VRKeyboard()
-{
-	XR_STUBBED();
+	// Draw everything once up-front, after which Refresh only redraws what changes
+	canvas.assign((size_t)CANVAS_WIDTH * CANVAS_HEIGHT, { 125, 125, 125, 255 });
+	drawnKeys.resize(keyRects.size());
+	for (int i = 0; i < (int)keyRects.size(); i++) {
+		DrawKey(i, GetKeyState(i));
+	}
+
+	// Place the keyboard in front of and below the user's head, tilted up to face them
+	XrSpace space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
+
+	layer.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+	layer.space = space;
+	layer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+	layer.size = { QUAD_WIDTH, QUAD_HEIGHT };
+	layer.pose = { { 0.f, 0.f, 0.f, 1.f }, { 0.f, 1.f, -1.f } };
+
+	vr::TrackedDevicePose_t headPose;
+	BackendManager::Instance().GetSinglePose(GetUnsafeBaseCompositor()->GetTrackingSpace(), vr::k_unTrackedDeviceIndex_Hmd, &headPose,
+	    ETrackingStateType::TrackingStateType_Now);
+
+	if (headPose.bPoseIsValid) {
+		const vr::HmdMatrix34_t& mat = headPose.mDeviceToAbsoluteTracking;
+
+		// Only follow the direction the user is facing horizontally, so the keyboard doesn't end up on the floor
+		glm::vec3 forward(-mat.m[0][2], 0, -mat.m[2][2]);
+		if (glm::length(forward) > 0.01f) {
+			forward = glm::normalize(forward);
+			float yaw = atan2f(-forward.x, -forward.z);
+			glm::quat rotation = glm::angleAxis(yaw, glm::vec3(0, 1, 0)) * glm::angleAxis(-math_pi / 8, glm::vec3(1, 0, 0));
+
+			layer.pose.position = { mat.m[0][3] + forward.x * 0.6f, mat.m[1][3] - 0.3f, mat.m[2][3] + forward.z * 0.6f };
+			layer.pose.orientation = { rotation.x, rotation.y, rotation.z, rotation.w };
+		}
+	}
 }
-#endif
+
+VRKeyboard::~VRKeyboard() = default;
+
 wstring VRKeyboard::contents()
 {
 	return text;
 }
-#ifndef OC_XR_PORT
 
 void VRKeyboard::contents(wstring str)
 {
 	text = str;
-	dirty = true;
+	textDirty = true;
 }
 
-ovrLayerHeader* VRKeyboard::Update()
+XrCompositionLayerBaseHeader* VRKeyboard::Update()
 {
-	if (dirty) {
-		dirty = false;
-		Refresh();
-	}
+	HandleInput(vr::Eye_Left, BaseSystem::leftHandIndex);
+	HandleInput(vr::Eye_Right, BaseSystem::rightHandIndex);
 
-	return &layer.Header;
+	Refresh();
+
+	// If the image couldn't be uploaded, there's nothing to show
+	if (!layer.subImage.swapchain)
+		return nullptr;
+
+	return (XrCompositionLayerBaseHeader*)&layer;
 }
 
-void VRKeyboard::HandleOverlayInput(vr::EVREye side, vr::VRControllerState_t state, float time)
+void VRKeyboard::HandleInput(vr::EVREye side, vr::TrackedDeviceIndex_t device)
 {
 	using namespace vr;
 
@@ -186,265 +184,295 @@ void VRKeyboard::HandleOverlayInput(vr::EVREye side, vr::VRControllerState_t sta
 	if (IsClosed())
 		return;
 
-	uint64_t lastButtons = lastButtonState[side];
-	lastButtonState[side] = state.ulButtonPressed;
-
-#define GET_BTTN(var, key) bool var = state.ulButtonPressed & ButtonMaskFromId(key)
-#define GET_BTTN_LAST(var, key) \
-	GET_BTTN(var, key);         \
-	bool var##_last = lastButtons & ButtonMaskFromId(key)
-	GET_BTTN(left, k_EButton_DPad_Left);
-	GET_BTTN(right, k_EButton_DPad_Right);
-	GET_BTTN(up, k_EButton_DPad_Up);
-	GET_BTTN(down, k_EButton_DPad_Down);
-	GET_BTTN_LAST(trigger, k_EButton_SteamVR_Trigger);
-	GET_BTTN_LAST(grip, k_EButton_Grip);
-#undef GET_BTTN
-#undef GET_BTTN_LAST
-
-	if (grip && !grip_last) {
+	BaseInput* input = GetUnsafeBaseInput();
+	if (!input)
+		return;
+
+	// This uses the poses that were already located for this frame
+	TrackedDevicePose_t pose;
+	BackendManager::Instance().GetSinglePose(GetUnsafeBaseCompositor()->GetTrackingSpace(), device, &pose, ETrackingStateType::TrackingStateType_Rendering);
+	hovered[side] = pose.bPoseIsValid ? RaycastKey(pose.mDeviceToAbsoluteTracking) : -1;
+
+	VRControllerState_t state;
+	if (!input->GetRawLegacyControllerState(device, &state))
+		return;
+
+	bool trigger = state.ulButtonPressed & ButtonMaskFromId(k_EButton_SteamVR_Trigger);
+	bool grip = state.ulButtonPressed & ButtonMaskFromId(k_EButton_Grip);
+	bool triggerPressed = trigger && !lastTrigger[side];
+	bool gripPressed = grip && !lastGrip[side];
+	lastTrigger[side] = trigger;
+	lastGrip[side] = grip;
+
+	if (gripPressed) {
 		closed = true;
 		SubmitEvent(VREvent_KeyboardClosed, 0);
 		return;
 	}
 
-	const KeyboardLayout::Key& key = layout->GetKeymap()[selected[side]];
+	// Keys are typed when the trigger is pressed, and stay lit up until it's released
+	if (triggerPressed && hovered[side] != -1) {
+		pressed[side] = hovered[side];
+		PressKey(layout->GetKeymap()[hovered[side]]);
+	} else if (!trigger) {
+		pressed[side] = -1;
+	}
+}
 
-	if (trigger && !trigger_last) {
-		wchar_t ch = caseMode == ECaseMode::LOWER ? key.ch : key.shift;
+int VRKeyboard::RaycastKey(const vr::HmdMatrix34_t& controller)
+{
+	// Controllers point down their -Z axis
+	glm::vec3 origin(controller.m[0][3], controller.m[1][3], controller.m[2][3]);
+	glm::vec3 direction(-controller.m[0][2], -controller.m[1][2], -controller.m[2][2]);
+
+	// Move the ray into the quad's space, where the quad is on the XY plane facing +Z
+	const XrPosef& pose = layer.pose;
+	glm::quat inverseRotation = glm::inverse(glm::quat(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z));
+	origin = inverseRotation * (origin - glm::vec3(pose.position.x, pose.position.y, pose.position.z));
+	direction = inverseRotation * direction;
+
+	// Ignore rays from behind the keyboard or running parallel to it
+	if (origin.z <= 0 || direction.z >= -0.0001f)
+		return -1;
+
+	float distance = -origin.z / direction.z;
+	glm::vec3 hit = origin + direction * distance;
+
+	// Convert to canvas pixels, which run top-to-bottom
+	int x = (int)((hit.x / QUAD_WIDTH + 0.5f) * CANVAS_WIDTH);
+	int y = (int)((0.5f - hit.y / QUAD_HEIGHT) * CANVAS_HEIGHT);
+
+	for (int i = 0; i < (int)keyRects.size(); i++) {
+		const KeyRect& rect = keyRects[i];
+		if (x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height)
+			return i;
+	}
 
-		bool submitKeyEvent = false;
+	return -1;
+}
 
-		if (ch == '\x01' || ch == '\x02') {
-			// Shift
-			ECaseMode target = ch == '\x02' ? ECaseMode::LOCK : ECaseMode::SHIFT;
-			caseMode = caseMode == target ? ECaseMode::LOWER : target;
-		} else if (ch == '\b') {
-			// Backspace
-			if (!text.empty()) {
-				text.erase(text.end() - 1);
-			}
+void VRKeyboard::PressKey(const KeyboardLayout::Key& key)
+{
+	using namespace vr;
 
-			submitKeyEvent = true;
-		} else if (ch == '\x03') {
-			// done
+	wchar_t ch = caseMode == ECaseMode::LOWER ? key.ch : key.shift;
 
-			// Submit mode is for stuff like chat, where the keyboard stays open
-			if (inputMode != EGamepadTextInputMode::k_EGamepadTextInputModeSubmit)
-				closed = true;
+	bool submitKeyEvent = false;
 
-			if (!minimal)
-				SubmitEvent(VREvent_KeyboardCharInput, 0);
+	if (ch == '\x01' || ch == '\x02') {
+		// Shift
+		ECaseMode target = ch == '\x02' ? ECaseMode::LOCK : ECaseMode::SHIFT;
+		caseMode = caseMode == target ? ECaseMode::LOWER : target;
+	} else if (ch == '\b') {
+		// Backspace
+		if (!text.empty()) {
+			text.erase(text.end() - 1);
+			textDirty = true;
+		}
 
-			SubmitEvent(VREvent_KeyboardDone, 0);
-		} else if (!minimal && ch == '\t') {
-			// Silently soak up tabs for now
-		} else if (!minimal && ch == '\n') {
-			// Silently soak up newlines for now
-		} else {
-			text += ch;
+		submitKeyEvent = true;
+	} else if (ch == '\x03') {
+		// done
 
-			submitKeyEvent = true;
+		// Submit mode is for stuff like chat, where the keyboard stays open
+		if (inputMode != EGamepadTextInputMode::k_EGamepadTextInputModeSubmit)
+			closed = true;
 
-			if (caseMode == ECaseMode::SHIFT)
-				caseMode = ECaseMode::LOWER;
-		}
+		if (!minimal)
+			SubmitEvent(VREvent_KeyboardCharInput, 0);
 
-		if (submitKeyEvent) {
-			SubmitEvent(VREvent_KeyboardCharInput, minimal ? ch : 0);
-		}
+		SubmitEvent(VREvent_KeyboardDone, 0);
+	} else if (!minimal && ch == '\t') {
+		// Silently soak up tabs for now
+	} else if (!minimal && ch == '\n') {
+		// Silently soak up newlines for now
+	} else if (maxLength == 0 || text.length() < maxLength) {
+		text += ch;
+		textDirty = true;
 
-		dirty = true;
-	}
+		submitKeyEvent = true;
 
-	// Movement:
-	bool any = left || right || up || down;
-	if (!any) {
-	cancel:
-		repeatCount[side] = 0;
-		lastInputTime[side] = 0;
-		return;
+		if (caseMode == ECaseMode::SHIFT)
+			caseMode = ECaseMode::LOWER;
 	}
 
-	if (time - lastInputTime[side] < (repeatCount[side] <= 1 ? 0.3 : 0.1))
-		return;
-
-	lastInputTime[side] = time;
-	repeatCount[side]++;
-
-	int target = -1;
-	if (left)
-		target = key.toLeft;
-	else if (right)
-		target = key.toRight;
-	else if (up)
-		target = key.toUp;
-	else if (down)
-		target = key.toDown;
-
-	if (target == -1) {
-		goto cancel;
+	if (submitKeyEvent) {
+		SubmitEvent(VREvent_KeyboardCharInput, minimal ? ch : 0);
 	}
+}
 
-	selected[side] = target;
-	dirty = true;
+void VRKeyboard::SetTransform(vr::HmdMatrix34_t transform)
+{
+	layer.pose = S2O_om34_pose(transform);
 }
 
-void VRKeyboard::SetTransform(HmdMatrix34_t transform)
+VRKeyboard::KeyState VRKeyboard::GetKeyState(int id)
 {
-	ovrPosef pose = S2O_om34_pose(transform);
+	const KeyboardLayout::Key& key = layout->GetKeymap()[id];
+
+	KeyState state;
+	state.hovered[vr::Eye_Left] = hovered[vr::Eye_Left] == id;
+	state.hovered[vr::Eye_Right] = hovered[vr::Eye_Right] == id;
+	state.pressed = pressed[vr::Eye_Left] == id || pressed[vr::Eye_Right] == id;
+	state.highlighted = (key.ch == '\x01' && caseMode == ECaseMode::SHIFT) || (key.ch == '\x02' && caseMode == ECaseMode::LOCK);
+	state.shifted = caseMode != ECaseMode::LOWER;
+	return state;
+}
 
-	layer.QuadPoseCenter = pose;
+void VRKeyboard::FillArea(int x, int y, int w, int h, pix_t colour)
+{
+	for (int iy = y; iy < y + h; iy++) {
+		std::fill_n(canvas.begin() + ((size_t)iy * CANVAS_WIDTH + x), w, colour);
+	}
+	MarkDirty(x, y, w, h);
 }
 
-struct pix_t {
-	uint8_t r, g, b, a;
-};
+void VRKeyboard::MarkDirty(int x, int y, int w, int h)
+{
+	int left = std::max(x, 0);
+	int top = std::max(y, 0);
+	int right = std::min(x + w, CANVAS_WIDTH);
+	int bottom = std::min(y + h, CANVAS_HEIGHT);
+	if (right <= left || bottom <= top)
+		return;
 
-static_assert(sizeof(pix_t) == 4, "padded pix_t");
+	CompositorRect::AddToList(dirtyRects, { (uint32_t)left, (uint32_t)top, (uint32_t)(right - left), (uint32_t)(bottom - top) });
+}
 
-void VRKeyboard::Refresh()
+void VRKeyboard::Print(int x, int y, pix_t colour, const wstring& str, bool hpad)
 {
-	D3D11_TEXTURE2D_DESC desc;
-	desc.Width = chainDesc.Width;
-	desc.Height = chainDesc.Height;
-	desc.MipLevels = 1;
-	desc.ArraySize = 1;
-	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-	desc.SampleDesc = { 1, 0 };
-	desc.Usage = D3D11_USAGE_DEFAULT; // D3D11_USAGE_IMMUTABLE;
-	desc.BindFlags = 0;
-	desc.CPUAccessFlags = 0;
-	desc.MiscFlags = 0;
-
-	pix_t* pixels = new pix_t[desc.Width * desc.Height];
-
-	for (UINT y = 0; y < desc.Height; y++) {
-		for (UINT x = 0; x < desc.Width; x++) {
-			int col = 125;
-
-			pix_t& pix = pixels[x + y * desc.Width];
-			pix.a = 255;
-			pix.r = col;
-			pix.g = col;
-			pix.b = col;
-		}
-	}
+	for (wchar_t ch : str) {
+		font->Blit(ch, x, y, CANVAS_WIDTH, colour, canvas.data(), hpad);
 
-	int padding = 8;
+		// Labels can hang over the edge of their key, so mark where the glyph actually went
+		const SudoFontMeta::CharInfo& info = font->GetCharInfo(ch);
+		MarkDirty(x + (hpad ? info.XOffset : 0), y + info.YOffset, info.PackedWidth, info.PackedHeight);
 
-	auto fillArea = [pixels, &desc](int x, int y, int w, int h, int r, int g, int b) {
-		for (int ix = 0; ix < w; ix++) {
-			for (int iy = 0; iy < h; iy++) {
-				size_t idx = (x + ix) + (y + iy) * desc.Width;
-				pix_t& p = pixels[idx];
+		x += font->Width(ch);
+	}
+}
 
-				p.r = r;
-				p.g = g;
-				p.b = b;
-				p.a = 255;
-			}
-		}
-	};
+void VRKeyboard::DrawKey(int id, const KeyState& state)
+{
+	const KeyboardLayout::Key& key = layout->GetKeymap()[id];
+	const KeyRect& rect = keyRects[id];
 
-	auto print = [&](int x, int y, pix_t colour, wstring text, bool hpad = true) {
-		SudoFontMeta::pix_t c = { colour.r, colour.g, colour.b, colour.a };
-		for (size_t i = 0; i < text.length(); i++) {
-			font->Blit(text[i], x, y, desc.Width, c, (SudoFontMeta::pix_t*)pixels, hpad);
-			x += font->Width(text[i]);
-		}
-	};
+	uint8_t bkg_c = state.highlighted || state.pressed ? 255 : 80;
+	FillArea(rect.x, rect.y, rect.width, rect.height, { bkg_c, bkg_c, bkg_c, 255 });
 
-	int kbWidth = layout->GetWidth();
-	int keySize = ((desc.Width - padding) / kbWidth) - padding;
-	auto drawKey = [&](int x, int y, const KeyboardLayout::Key& key) {
-		int width = (int)(keySize * key.w);
-		int height = (int)(keySize * key.h);
+	// Show which hand is pointing at the key with a coloured half
+	if (state.hovered[vr::Eye_Left]) {
+		FillArea(rect.x, rect.y, rect.width / 2, rect.height, { 0, 100, 255, 255 });
+	}
 
-		if (key.spansToRight) {
-			width = desc.Width - padding - x;
-		}
+	if (state.hovered[vr::Eye_Right]) {
+		FillArea(rect.x + rect.width / 2, rect.y, rect.width / 2, rect.height, { 0, 255, 100, 255 });
+	}
 
-		bool highlighted = (key.ch == '\x01' && caseMode == ECaseMode::SHIFT)
-		    || (key.ch == '\x02' && caseMode == ECaseMode::LOCK);
-		int bkg_c = highlighted ? 255 : 80;
+	pix_t targetColour = { 255, 255, 255, 255 };
 
-		fillArea(
-		    x, y,
-		    width, height,
-		    bkg_c, bkg_c, bkg_c);
+	if (state.highlighted || state.pressed) {
+		targetColour = { 0, 0, 0, 255 };
+	}
 
-		if (selected[vr::Eye_Left] == key.id) {
-			fillArea(
-			    x, y,
-			    width / 2, height,
-			    0, 100, 255);
-		}
+	const wstring& label = state.shifted ? key.labelShift : key.label;
+	int textWidth = font->Width(label);
 
-		if (selected[vr::Eye_Right] == key.id) {
-			fillArea(
-			    x + width / 2, y,
-			    width / 2, height,
-			    0, 255, 100);
-		}
+	Print(rect.x + (rect.width - textWidth) / 2, rect.y + PADDING, targetColour, label, false);
 
-		pix_t targetColour = { 255, 255, 255, 255 };
+	drawnKeys[id] = state;
+	keysRedrawn++;
+}
 
-		if (highlighted) {
-			targetColour = { 0, 0, 0, 255 };
-		}
+void VRKeyboard::DrawText()
+{
+	textDirty = false;
 
-		wstring label = caseMode == ECaseMode::LOWER ? key.label : key.labelShift;
-		int textWidth = font->Width(label);
+	if (minimal)
+		return;
 
-		print(x + (width - textWidth) / 2, y + padding, targetColour, label, false);
-	};
+	FillArea(textRect.x, textRect.y, textRect.width, textRect.height, { 255, 255, 255, 255 });
 
-	int keyAreaBaseY = minimal ? padding : padding + keySize + padding;
-	for (const KeyboardLayout::Key& key : layout->GetKeymap()) {
-		int x = padding + (int)((keySize + padding) * key.x);
-		int y = keyAreaBaseY + (int)((keySize + padding) * key.y);
+	wstring shown = inputMode == k_EGamepadTextInputModePassword ? wstring(text.length(), L'*') : text;
 
-		drawKey(x, y, key);
+	// The app can set any text, which might include characters the font doesn't have
+	for (wchar_t& ch : shown) {
+		if (!font->HasChar(ch))
+			ch = L'?';
 	}
 
-	if (!minimal) {
-		fillArea(
-		    padding, padding,
-		    desc.Width - padding * 2, keySize,
-		    255, 255, 255);
-
-		pix_t targetColour = { 0, 0, 0, 255 };
-
-		print(padding * 2, padding * 2, targetColour, text);
+	// If the text doesn't fit, show the end of it since that's where the user is typing
+	int maxWidth = textRect.width - PADDING * 2;
+	int width = font->Width(shown);
+	size_t start = 0;
+	while (start < shown.length() && width > maxWidth) {
+		width -= font->Width(shown[start]);
+		start++;
 	}
 
-	D3D11_SUBRESOURCE_DATA init[] = {
-		{ pixels, sizeof(pix_t) * desc.Width, sizeof(pix_t) * desc.Width * desc.Height }
-	};
+	Print(textRect.x + PADDING, textRect.y + PADDING, { 0, 0, 0, 255 }, shown.substr(start));
+}
 
-	CComPtr<ID3D11Texture2D> tex;
-	HRESULT rres = dev->CreateTexture2D(&desc, init, &tex);
-	// HRESULT hrr = dev->GetDeviceRemovedReason();
-	OOVR_FAILED_DX_ABORT(rres);
-	delete[] pixels;
+void VRKeyboard::Refresh()
+{
+	auto start = std::chrono::steady_clock::now();
 
-	////
+	for (int i = 0; i < (int)drawnKeys.size(); i++) {
+		KeyState state = GetKeyState(i);
+		if (state != drawnKeys[i]) {
+			DrawKey(i, state);
+		}
+	}
 
-	int index;
-	OOVR_FAILED_OVR_ABORT(ovr_GetTextureSwapChainCurrentIndex(*ovr::session, chain, &index));
+	if (textDirty) {
+		DrawText();
+	}
 
-	CComPtr<ID3D11Texture2D> dst;
-	OOVR_FAILED_OVR_ABORT(ovr_GetTextureSwapChainBufferDX(*ovr::session, chain, index, IID_PPV_ARGS(&dst)));
+	// If nothing changed since the last upload, the swapchain still has the right image in it
+	if (!canvasDirty && dirtyRects.empty())
+		return;
 
-	ctx->CopyResource(dst, tex);
+	compositor->LoadSubmitContext();
+	auto revertToCallerContext = MakeScopeGuard([&]() {
+		compositor->ResetSubmitContext();
+	});
 
-	// Commit the texture to LibOVR
-	OOVR_FAILED_OVR_ABORT(ovr_CommitTextureSwapChain(*ovr::session, chain));
+	// The first upload has to fill the swapchain, after that it's just what was drawn on since the last one
+	const CompositorRect* changed = canvasDirty ? nullptr : dirtyRects.data();
+	if (!compositor->InvokeRaw(canvas.data(), CANVAS_WIDTH, CANVAS_HEIGHT, changed, (uint32_t)dirtyRects.size())) {
+		OOVR_LOG_ONCE("Keyboard: failed to upload the keyboard image");
+		return;
+	}
+	canvasDirty = false;
+
+	for (const CompositorRect& rect : dirtyRects)
+		pixelsChanged += rect.width * rect.height;
+	dirtyRects.clear();
+
+	layer.subImage.swapchain = compositor->GetSwapChain();
+	layer.subImage.imageRect = { { 0, 0 }, { CANVAS_WIDTH, CANVAS_HEIGHT } };
+	layer.subImage.imageArrayIndex = 0;
+
+	auto now = std::chrono::steady_clock::now();
+	redrawTime += now - start;
+	redraws++;
+
+	std::chrono::duration<float> elapsed = now - redrawStatsStart;
+	if (elapsed.count() >= 10.0f) {
+		OOVR_LOGF("Keyboard: %u redraws, %.1f keys, %u pixels changed and %.2fms each", redraws, (float)keysRedrawn / redraws, (uint32_t)(pixelsChanged / redraws),
+		    redrawTime.count() / redraws);
+		keysRedrawn = 0;
+		redraws = 0;
+		pixelsChanged = 0;
+		redrawTime = {};
+		redrawStatsStart = now;
+	}
 }
 
 void VRKeyboard::SubmitEvent(vr::EVREventType ev, wchar_t ch)
 {
+	using namespace vr;
+
 	// Here's how (from some basic experimentation) the SteamVR keyboard appears to submit events:
 	// In minimal mode:
 	// * Pressing a key submits a KeyboardCharInput event, with the character stored in cNewInput
@@ -480,5 +508,3 @@ void VRKeyboard::SubmitEvent(vr::EVREventType ev, wchar_t ch)
 
 	eventDispatch(evt);
 }
-
-#endif
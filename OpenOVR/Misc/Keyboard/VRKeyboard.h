@@ -1,9 +1,6 @@
 #pragma once
 
-#ifndef OC_XR_PORT
-#include <d3d11.h>
-#endif
-
+#include <chrono>
 #include <codecvt>
 #include <functional>
 #include <locale>
@@ -11,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "../../Compositor/compositor.h"
 #include "KeyboardLayout.h"
 #include "SudoFontMeta.h"
 
@@ -26,19 +24,23 @@ public:
 		k_EGamepadTextInputModeSubmit = 2,
 	};
 
-#ifndef OC_XR_PORT
-	VRKeyboard(ID3D11Device* dev, uint64_t userValue, uint32_t maxLength, bool minimal, eventDispatch_t dispatch, EGamepadTextInputMode inputMode);
-#endif
+	/**
+	 * Create the keyboard, placed in front of the user. This needs the graphics API to be known, since the keyboard
+	 * is drawn into its own swapchain - check CanCreate first.
+	 */
+	VRKeyboard(uint64_t userValue, uint32_t maxLength, bool minimal, eventDispatch_t dispatch, EGamepadTextInputMode inputMode);
 	~VRKeyboard();
 
+	static bool CanCreate();
+
 	std::wstring contents();
 	void contents(std::wstring);
 
-#ifndef OC_XR_PORT
-	ovrLayerHeader* Update();
-#endif
-
-	void HandleOverlayInput(vr::EVREye controllerDeviceIndex, vr::VRControllerState_t state, float time);
+	/**
+	 * Handle the controllers pointing at the keyboard, redraw anything that changed, and return the keyboard's
+	 * layer (or null if it can't be shown). This is called once per frame, when the frame's layers are built.
+	 */
+	XrCompositionLayerBaseHeader* Update();
 
 	enum ECaseMode {
 		LOWER,
@@ -53,12 +55,24 @@ public:
 	void SetTransform(vr::HmdMatrix34_t transform);
 
 private:
-#ifndef OC_XR_PORT
-	ID3D11Device* const dev;
-	ID3D11DeviceContext* ctx;
-#endif
+	typedef SudoFontMeta::pix_t pix_t;
+
+	// Everything that affects how a key looks. Keys are only redrawn when this changes.
+	struct KeyState {
+		bool hovered[2] = { false, false }; // Uses the OpenVR eye constants for the hands, like the rest of the input
+		bool pressed = false;
+		bool highlighted = false; // Shift or caps lock, while they're active
+		bool shifted = false;
+
+		bool operator==(const KeyState& other) const;
+		bool operator!=(const KeyState& other) const { return !(*this == other); }
+	};
+
+	// Where a key is on the canvas, which is worked out once when the keyboard is created
+	struct KeyRect {
+		int x, y, width, height;
+	};
 
-	bool dirty = true;
 	bool closed = false;
 
 	std::wstring text;
@@ -70,20 +84,48 @@ private:
 	eventDispatch_t eventDispatch;
 	EGamepadTextInputMode inputMode;
 
-#ifndef OC_XR_PORT
-	ovrTextureSwapChain chain;
-	ovrTextureSwapChainDesc chainDesc;
-	ovrLayerQuad layer;
-#endif
+	std::unique_ptr<Compositor> compositor;
+	XrCompositionLayerQuad layer = { XR_TYPE_COMPOSITION_LAYER_QUAD };
 
-	std::unique_ptr<SudoFontMeta> font;
+	std::shared_ptr<SudoFontMeta> font;
 	std::unique_ptr<KeyboardLayout> layout;
 
-	// These use the OpenVR eye constants
-	float lastInputTime[2];
-	int repeatCount[2];
-	int selected[2];
-	uint64_t lastButtonState[2];
+	// The keyboard is drawn into this, and only the keys (and text box) that changed are drawn again. Everything
+	// that's drawn is added to dirtyRects, and just those parts of the canvas are uploaded to the swapchain.
+	std::vector<pix_t> canvas;
+	std::vector<KeyRect> keyRects;
+	std::vector<KeyState> drawnKeys;
+	KeyRect textRect = {};
+	std::vector<CompositorRect> dirtyRects;
+	bool textDirty = true;
+	bool canvasDirty = true;
+
+	// The key each hand is pointing at (or -1), and the key the trigger was pressed on
+	int hovered[2] = { -1, -1 };
+	int pressed[2] = { -1, -1 };
+	bool lastTrigger[2] = { false, false };
+	bool lastGrip[2] = { false, false };
+
+	// For logging how long redrawing takes
+	uint32_t keysRedrawn = 0;
+	uint32_t redraws = 0;
+	uint64_t pixelsChanged = 0;
+	std::chrono::duration<float, std::milli> redrawTime{};
+	std::chrono::steady_clock::time_point redrawStatsStart = std::chrono::steady_clock::now();
+
+	void HandleInput(vr::EVREye side, vr::TrackedDeviceIndex_t device);
+
+	// Find the key a controller is pointing at, or -1 if it's not pointing at one
+	int RaycastKey(const vr::HmdMatrix34_t& controller);
+
+	void PressKey(const KeyboardLayout::Key& key);
+
+	KeyState GetKeyState(int id);
+	void DrawKey(int id, const KeyState& state);
+	void DrawText();
+	void FillArea(int x, int y, int w, int h, pix_t colour);
+	void MarkDirty(int x, int y, int w, int h);
+	void Print(int x, int y, pix_t colour, const std::wstring& str, bool hpad = true);
 
 	void Refresh();
 
@@ -0,0 +1,457 @@
+#include "stdafx.h"
+
+#include "MailboxRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <string.h>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+// The slots' sequence numbers are shared between processes, which only works if they don't need a lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Mailbox rings need lock-free 64-bit atomics");
+
+// The reader sleeps on the message counter with a futex, which is a plain 32-bit word as far as the kernel knows
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Mailbox rings need plain 32-bit atomics");
+
+// Changed whenever the layout changes, so an old build of OpenComposite won't misread the ring
+static const uint32_t RING_MAGIC = 0x4f434d34; // OCM4
+
+// Put in a slot's owner in place of a process ID once the reader has given up on the slot's sender
+static const uint32_t OWNER_ABANDONED = UINT32_MAX;
+
+struct MailboxRing::Header {
+	// Set (last) by whichever process created the ring, once the rest of it is set up
+	std::atomic<uint32_t> magic;
+	uint32_t slotCount;
+
+	// The ID of the process reading from the ring, or zero if no-one has registered the mailbox
+	std::atomic<uint32_t> readerProcess;
+
+	// The next position to send to, and to read from. These only ever go up, and are wrapped into the slot array.
+	alignas(64) std::atomic<uint64_t> sendPos;
+	alignas(64) std::atomic<uint64_t> readPos;
+
+	// Bumped for every message sent, so the reader can sleep until it changes. Senders only wake the reader up if
+	// it's said it's waiting.
+	alignas(64) std::atomic<uint32_t> messageCount;
+	std::atomic<uint32_t> readerWaiting;
+};
+
+struct MailboxRing::Slot {
+	// If this equals the position being sent to, the slot is free. If it's one more than the position being read
+	// from, it holds a message. Readers and senders each move it on once they're done with the slot.
+	std::atomic<uint64_t> sequence;
+
+	// The position the slot is being used for (in the top half), and the ID of the process writing to it (in the
+	// bottom half), which is zero until the sender that claimed the slot records itself. Both halves are set at
+	// once, so a sender that's fallen a lap behind can't mistake the slot for its own.
+	std::atomic<uint64_t> owner;
+
+	uint32_t length;
+	char message[MAX_MESSAGE_LENGTH + 1];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) * 2 + sizeof(uint32_t) + MailboxRing::MAX_MESSAGE_LENGTH + 1 <= 4096,
+    "Mailbox ring slots should fit in a page");
+
+static uint64_t OwnerFor(uint64_t pos, uint32_t process)
+{
+	return (uint64_t)(uint32_t)pos << 32 | process;
+}
+
+// Mailbox names are picked by the app, so only keep the characters that are certainly safe in a shared memory name
+static std::string SharedNameFor(const std::string& mailboxName)
+{
+	std::string name;
+#ifdef _WIN32
+	name = "Local\\OpenComposite-mailbox-";
+#else
+	// Put the user in the name, since /dev/shm is shared by everyone
+	name = "/opencomposite-" + std::to_string(getuid()) + "-mailbox-";
+#endif
+
+	for (char c : mailboxName) {
+		bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-';
+		name += safe ? c : '_';
+	}
+
+	return name;
+}
+
+static uint32_t CurrentProcessId()
+{
+#ifdef _WIN32
+	return (uint32_t)GetCurrentProcessId();
+#else
+	return (uint32_t)getpid();
+#endif
+}
+
+static bool IsProcessAlive(uint32_t pid)
+{
+#ifdef _WIN32
+	HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+	if (!process)
+		return GetLastError() == ERROR_ACCESS_DENIED;
+	bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+	CloseHandle(process);
+	return alive;
+#else
+	return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+std::unique_ptr<MailboxRing> MailboxRing::Open(const std::string& mailboxName)
+{
+	std::unique_ptr<MailboxRing> ring(new MailboxRing());
+	ring->sharedName = SharedNameFor(mailboxName);
+	ring->processId = CurrentProcessId();
+	ring->mappedSize = sizeof(Header) + sizeof(Slot) * SLOT_COUNT;
+
+	void* memory = nullptr;
+	bool created = false;
+
+#if defined(_WIN32)
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)ring->mappedSize, ring->sharedName.c_str());
+	if (!mapping) {
+		OOVR_LOGF("Failed to create mailbox shared memory '%s', error %d", ring->sharedName.c_str(), (int)GetLastError());
+		return nullptr;
+	}
+	created = GetLastError() != ERROR_ALREADY_EXISTS;
+	ring->mapping = mapping;
+
+	memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, ring->mappedSize);
+	if (!memory) {
+		OOVR_LOGF("Failed to map mailbox shared memory '%s', error %d", ring->sharedName.c_str(), (int)GetLastError());
+		return nullptr;
+	}
+
+	// Futexes don't work between processes on Windows, so the reader sleeps on a named event instead
+	ring->wakeEvent = CreateEventA(nullptr, FALSE, FALSE, (ring->sharedName + "-wake").c_str());
+	if (!ring->wakeEvent) {
+		OOVR_LOGF("Failed to create mailbox wake event for '%s', error %d", ring->sharedName.c_str(), (int)GetLastError());
+		return nullptr;
+	}
+#elif defined(__ANDROID__)
+	// There's no shm_open on Android, and nothing else to talk to there anyway
+	return nullptr;
+#else
+	// Only the process that actually creates the memory sets it up, everyone else waits for it to be ready
+	int fd = shm_open(ring->sharedName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd != -1) {
+		created = true;
+		if (ftruncate(fd, (off_t)ring->mappedSize) != 0) {
+			OOVR_LOGF("Failed to size mailbox shared memory '%s': %s", ring->sharedName.c_str(), strerror(errno));
+			close(fd);
+			shm_unlink(ring->sharedName.c_str());
+			return nullptr;
+		}
+	} else if (errno == EEXIST) {
+		fd = shm_open(ring->sharedName.c_str(), O_RDWR, 0600);
+	}
+
+	if (fd == -1) {
+		OOVR_LOGF("Failed to open mailbox shared memory '%s': %s", ring->sharedName.c_str(), strerror(errno));
+		return nullptr;
+	}
+
+	// The creator might not have sized it yet, and mapping past the end of the file would crash on first access
+	struct stat info = {};
+	for (int i = 0; i < 100 && fstat(fd, &info) == 0 && (size_t)info.st_size < ring->mappedSize; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if ((size_t)info.st_size < ring->mappedSize) {
+		OOVR_LOGF("Mailbox shared memory '%s' is the wrong size (%d bytes)", ring->sharedName.c_str(), (int)info.st_size);
+		close(fd);
+		return nullptr;
+	}
+
+	// Keep the file open to check whether it's been unlinked - the mapping alone would keep the memory alive
+	ring->fd = fd;
+
+	memory = mmap(nullptr, ring->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED) {
+		OOVR_LOGF("Failed to map mailbox shared memory '%s': %s", ring->sharedName.c_str(), strerror(errno));
+		return nullptr;
+	}
+#endif
+
+	ring->header = (Header*)memory;
+	ring->slots = (Slot*)((char*)memory + sizeof(Header));
+
+	// New shared memory is zero-filled, which is a valid state for all the atomics
+	if (created) {
+		ring->header->slotCount = SLOT_COUNT;
+		ring->header->readerProcess.store(0, std::memory_order_relaxed);
+		ring->header->sendPos.store(0, std::memory_order_relaxed);
+		ring->header->readPos.store(0, std::memory_order_relaxed);
+		ring->header->messageCount.store(0, std::memory_order_relaxed);
+		ring->header->readerWaiting.store(0, std::memory_order_relaxed);
+		for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+			ring->slots[i].sequence.store(i, std::memory_order_relaxed);
+			ring->slots[i].owner.store(OwnerFor(i, 0), std::memory_order_relaxed);
+		}
+
+		ring->header->magic.store(RING_MAGIC, std::memory_order_release);
+	} else {
+		for (int i = 0; i < 100 && ring->header->magic.load(std::memory_order_acquire) == 0; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		if (ring->header->magic.load(std::memory_order_acquire) != RING_MAGIC || ring->header->slotCount != SLOT_COUNT) {
+			OOVR_LOGF("Mailbox shared memory '%s' wasn't set up, or is from an incompatible version", ring->sharedName.c_str());
+			return nullptr;
+		}
+	}
+
+	return ring;
+}
+
+MailboxRing::~MailboxRing()
+{
+	if (header)
+		ReleaseReader();
+
+#if defined(_WIN32)
+	if (header)
+		UnmapViewOfFile(header);
+	if (mapping)
+		CloseHandle((HANDLE)mapping);
+	if (wakeEvent)
+		CloseHandle((HANDLE)wakeEvent);
+#elif !defined(__ANDROID__)
+	if (header)
+		munmap(header, mappedSize);
+	if (fd != -1)
+		close(fd);
+#endif
+}
+
+bool MailboxRing::Push(const char* message, uint32_t length)
+{
+	if (length > MAX_MESSAGE_LENGTH)
+		return false;
+
+	// Claim a slot by moving the send position past it. Another sender might get there first, in which case try
+	// again with the slot after it.
+	uint64_t pos = header->sendPos.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+		slot = &slots[pos % SLOT_COUNT];
+		uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		int64_t diff = (int64_t)(sequence - pos);
+
+		if (diff == 0) {
+			if (header->sendPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			// The reader hasn't got to this slot since last time round, so the ring is full
+			return false;
+		} else {
+			pos = header->sendPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Record who's writing to the slot before touching it. If the reader has already given up on the slot (see
+	// AbandonSlot) it may have been handed to another sender, so the message is dropped rather than written.
+	uint64_t unowned = OwnerFor(pos, 0);
+	if (!slot->owner.compare_exchange_strong(unowned, OwnerFor(pos, processId), std::memory_order_acq_rel))
+		return false;
+
+	memcpy(slot->message, message, length);
+	slot->message[length] = 0;
+	slot->length = length;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	// The reader checks for messages after saying it's waiting, so one of the two of us always sees the other
+	header->messageCount.fetch_add(1, std::memory_order_seq_cst);
+	if (header->readerWaiting.load(std::memory_order_seq_cst))
+		WakeReader();
+
+	return true;
+}
+
+bool MailboxRing::Peek(const char** message, uint32_t* length)
+{
+	uint64_t pos = header->readPos.load(std::memory_order_relaxed);
+	Slot* slot = &slots[pos % SLOT_COUNT];
+
+	uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+	if (sequence != pos + 1) {
+		// Either nothing's been sent, or a sender has claimed this slot but not finished writing it yet
+		if (header->sendPos.load(std::memory_order_relaxed) == pos)
+			return false;
+
+		auto now = std::chrono::steady_clock::now();
+		if (stalledPos != pos) {
+			stalledPos = pos;
+			stalledSince = now;
+			return false;
+		}
+		if (now - stalledSince < STALE_SLOT_TIMEOUT)
+			return false;
+
+		// If the sender is still around, it's probably just slow - check on it again later
+		if (!AbandonSlot(pos)) {
+			stalledSince = now;
+			return false;
+		}
+
+		// Either the slot was skipped, or the message was finished after all
+		stalledPos = UINT64_MAX;
+		return Peek(message, length);
+	}
+	stalledPos = UINT64_MAX;
+
+	// Don't trust the length too much, since any process can write to the ring
+	*message = slot->message;
+	*length = std::min(slot->length, MAX_MESSAGE_LENGTH);
+	return true;
+}
+
+void MailboxRing::Pop()
+{
+	uint64_t pos = header->readPos.load(std::memory_order_relaxed);
+	Slot* slot = &slots[pos % SLOT_COUNT];
+
+	header->readPos.store(pos + 1, std::memory_order_relaxed);
+
+	// Hand the slot back to the senders, for when they come round to it again
+	slot->owner.store(OwnerFor(pos + SLOT_COUNT, 0), std::memory_order_relaxed);
+	slot->sequence.store(pos + SLOT_COUNT, std::memory_order_release);
+}
+
+bool MailboxRing::AbandonSlot(uint64_t pos)
+{
+	Slot* slot = &slots[pos % SLOT_COUNT];
+	uint64_t owner = slot->owner.load(std::memory_order_acquire);
+	uint32_t sender = (uint32_t)owner;
+
+	if (sender == 0) {
+		// The sender claimed the slot but never said who it is, so it likely died straight away. Mark the slot so
+		// that if it didn't, it finds out before writing anything.
+		if (!slot->owner.compare_exchange_strong(owner, OwnerFor(pos, OWNER_ABANDONED), std::memory_order_acq_rel))
+			return false;
+	} else if (IsProcessAlive(sender)) {
+		// It could still be writing to the slot, so the slot can't be skipped without another sender being handed it
+		// while it does. If the sender is suspended, so is this mailbox until it carries on.
+		return false;
+	} else if (slot->sequence.load(std::memory_order_acquire) == pos + 1) {
+		// It finished the message just before it died
+		return true;
+	}
+
+	// Nothing can write to the slot any more, so it's safe to move past it
+	OOVR_LOGF("Skipping mailbox message in '%s' that was never finished", sharedName.c_str());
+	Pop();
+	return true;
+}
+
+bool MailboxRing::Wait(std::chrono::milliseconds timeout)
+{
+	const char* message;
+	uint32_t length;
+
+	header->readerWaiting.store(1, std::memory_order_seq_cst);
+	uint32_t messageCount = header->messageCount.load(std::memory_order_seq_cst);
+
+	bool ready = Peek(&message, &length);
+	if (!ready) {
+		SleepUntilSent(messageCount, timeout);
+		ready = Peek(&message, &length);
+	}
+
+	header->readerWaiting.store(0, std::memory_order_relaxed);
+	return ready;
+}
+
+void MailboxRing::SleepUntilSent(uint32_t messageCount, std::chrono::milliseconds timeout)
+{
+#if defined(_WIN32)
+	// The event might have been left set by a message that was read without sleeping, in which case this returns
+	// straight away, which is harmless
+	(void)messageCount;
+	WaitForSingleObject((HANDLE)wakeEvent, (DWORD)timeout.count());
+#elif defined(__linux__)
+	// This returns straight away if a message was sent since messageCount was read
+	struct timespec time = {};
+	time.tv_sec = (time_t)(timeout.count() / 1000);
+	time.tv_nsec = (long)(timeout.count() % 1000) * 1000000;
+	syscall(SYS_futex, (uint32_t*)&header->messageCount, FUTEX_WAIT, messageCount, &time, nullptr, 0);
+#else
+	(void)messageCount;
+	std::this_thread::sleep_for(std::min(timeout, std::chrono::milliseconds(1)));
+#endif
+}
+
+void MailboxRing::WakeReader()
+{
+#if defined(_WIN32)
+	SetEvent((HANDLE)wakeEvent);
+#elif defined(__linux__)
+	// Not FUTEX_PRIVATE_FLAG, since the reader is usually in another process
+	syscall(SYS_futex, (uint32_t*)&header->messageCount, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+}
+
+bool MailboxRing::ClaimReader()
+{
+	uint32_t self = processId;
+	uint32_t current = header->readerProcess.load(std::memory_order_acquire);
+	while (true) {
+		if (current != 0 && (current == self || IsProcessAlive(current)))
+			return false;
+
+		if (header->readerProcess.compare_exchange_weak(current, self, std::memory_order_acq_rel))
+			break;
+	}
+
+	reading = true;
+	return true;
+}
+
+void MailboxRing::ReleaseReader()
+{
+	if (!reading)
+		return;
+
+	uint32_t self = processId;
+	header->readerProcess.compare_exchange_strong(self, 0, std::memory_order_acq_rel);
+	reading = false;
+}
+
+void MailboxRing::Unlink()
+{
+#if !defined(_WIN32) && !defined(__ANDROID__)
+	shm_unlink(sharedName.c_str());
+#endif
+	// On Windows, the mapping goes away by itself once every process has closed it
+}
+
+bool MailboxRing::IsUnlinked()
+{
+#if !defined(_WIN32) && !defined(__ANDROID__)
+	struct stat info = {};
+	return fstat(fd, &info) != 0 || info.st_nlink == 0;
+#else
+	// Anyone registering the mailbox again opens the same mapping, since we're still holding it open
+	return false;
+#endif
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+/**
+ * A queue of mailbox messages in shared memory, named after the mailbox it delivers to. Any number of processes
+ * (and threads) can send messages into it, while the process that registered the mailbox reads them out.
+ *
+ * This is a fixed-size ring of fixed-size slots, each with a sequence number that says whether it's free or holds
+ * a message, so sending never takes a lock. A sender that dies between claiming a slot and filling it in would
+ * otherwise block everything behind it, so each slot also records which process is writing it, and the reader
+ * skips a slot that's been claimed for too long by a process that's gone. A slot is never handed back to the
+ * senders while a live process might still be writing to it.
+ *
+ * A reader that has nothing else to do can sleep in Wait until a message arrives, rather than polling. Senders
+ * only make a system call to wake it when it's actually asleep.
+ */
+class MailboxRing {
+public:
+	static constexpr uint32_t SLOT_COUNT = 64;
+
+	// The longest message that can be sent, not including the null terminator. The slots are a page in size.
+	static constexpr uint32_t MAX_MESSAGE_LENGTH = 4096 - 24;
+
+	~MailboxRing();
+
+	MailboxRing(const MailboxRing&) = delete;
+	MailboxRing& operator=(const MailboxRing&) = delete;
+
+	/**
+	 * Open the ring for the named mailbox, creating it if no other process has yet. Returns null if the shared
+	 * memory couldn't be set up, in which case the mailbox only works inside this process.
+	 */
+	static std::unique_ptr<MailboxRing> Open(const std::string& mailboxName);
+
+	// Add a message to the ring. Returns false if it's too long, or if the ring is full.
+	bool Push(const char* message, uint32_t length);
+
+	/**
+	 * Look at the oldest message without removing it, so a message that doesn't fit in the reader's buffer isn't
+	 * lost. Returns false if there aren't any messages. Only one thread may read from a ring.
+	 */
+	bool Peek(const char** message, uint32_t* length);
+
+	// Remove the message returned by Peek
+	void Pop();
+
+	/**
+	 * Sleep until there's a message to read, or the timeout passes. Returns true if there's a message, which can
+	 * then be read with Peek. Only the ring's reader may call this.
+	 */
+	bool Wait(std::chrono::milliseconds timeout);
+
+	/**
+	 * Become the ring's only reader. Returns false if another process (or another mailbox in this one) is already
+	 * reading it, in which case this process can still send to it. A reader that exited without releasing the ring
+	 * doesn't count.
+	 */
+	bool ClaimReader();
+
+	// Let another process read from the ring, once the mailbox is unregistered
+	void ReleaseReader();
+
+	/**
+	 * Remove the ring's name once its mailbox is unregistered, so it doesn't outlive everyone using it. Processes
+	 * which still have it open can keep using it, but anything sent afterwards goes to a new ring.
+	 */
+	void Unlink();
+
+	/**
+	 * Check if the mailbox was unregistered since this was opened. Senders keep rings open between messages, and
+	 * need to open the ring again if the mailbox is registered again later.
+	 */
+	bool IsUnlinked();
+
+private:
+	struct Header;
+	struct Slot;
+
+	MailboxRing() = default;
+
+	// How long a claimed slot can stay unfilled before the reader checks whether its sender is still there
+	static constexpr std::chrono::milliseconds STALE_SLOT_TIMEOUT{ 1000 };
+
+	// Stop waiting for the sender of the slot at pos, if it's safe to. Returns false if it might still write to it.
+	bool AbandonSlot(uint64_t pos);
+
+	// Sleep until a sender bumps the message counter from the given value
+	void SleepUntilSent(uint32_t messageCount, std::chrono::milliseconds timeout);
+	void WakeReader();
+
+	Header* header = nullptr;
+	Slot* slots = nullptr;
+	size_t mappedSize = 0;
+	std::string sharedName;
+	bool reading = false;
+
+	// Looked up once, since it's a system call on Linux and every message needs it. Rings can't be used across a fork.
+	uint32_t processId = 0;
+
+	// The read position that Peek last found waiting for its sender, and when it first did
+	uint64_t stalledPos = UINT64_MAX;
+	std::chrono::steady_clock::time_point stalledSince;
+
+#ifdef _WIN32
+	void* mapping = nullptr;
+	void* wakeEvent = nullptr;
+#else
+	int fd = -1;
+#endif
+};
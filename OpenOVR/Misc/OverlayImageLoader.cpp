@@ -0,0 +1,99 @@
+#include "stdafx.h"
+
+#include "OverlayImageLoader.h"
+
+#include "Misc/lodepng.h"
+
+#include <fstream>
+#include <iterator>
+
+OverlayImageLoader::~OverlayImageLoader()
+{
+	if (!worker.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	jobAdded.notify_all();
+	worker.join();
+}
+
+OverlayImageLoader::Result OverlayImageLoader::Load(const std::string& path)
+{
+	std::error_code err;
+	std::filesystem::file_time_type modified = std::filesystem::last_write_time(std::filesystem::u8path(path), err);
+	if (err) {
+		// Let the worker report the error, so this behaves the same as any other unreadable file
+		modified = std::filesystem::file_time_type::min();
+	}
+
+	auto iter = cache.find(path);
+	if (iter != cache.end() && iter->second.modified == modified) {
+		iter->second.lastUsed = ++useCounter;
+		return iter->second.result;
+	}
+
+	if (iter == cache.end() && cache.size() >= MAX_CACHED_IMAGES) {
+		auto oldest = cache.begin();
+		for (auto i = cache.begin(); i != cache.end(); ++i) {
+			if (i->second.lastUsed < oldest->second.lastUsed)
+				oldest = i;
+		}
+		cache.erase(oldest);
+	}
+
+	Job job;
+	job.path = path;
+	Result result = job.promise.get_future().share();
+	cache[path] = CacheEntry{ modified, result, ++useCounter };
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(std::move(job));
+
+		if (!worker.joinable())
+			worker = std::thread(&OverlayImageLoader::Run, this);
+	}
+	jobAdded.notify_one();
+
+	return result;
+}
+
+void OverlayImageLoader::Run()
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			jobAdded.wait(guard, [this]() { return stopping || !jobs.empty(); });
+			if (stopping)
+				break;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		// lodepng is built without its file functions, so read the file ourselves
+		std::ifstream in(std::filesystem::u8path(job.path), std::ios::binary);
+		std::vector<unsigned char> file;
+		if (in.is_open())
+			file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		auto image = std::make_shared<OverlayImage>();
+		if (!in.is_open()) {
+			OOVR_LOGF("Failed to open overlay image '%s'", job.path.c_str());
+			image.reset();
+		} else if (unsigned int error = lodepng::decode(image->pixels, image->width, image->height, file, LCT_RGBA, 8)) {
+			OOVR_LOGF("Failed to decode overlay image '%s': %s", job.path.c_str(), lodepng_error_text(error));
+			image.reset();
+		}
+
+		job.promise.set_value(std::move(image));
+	}
+
+	// Anything still waiting won't be used, since the overlays are being destroyed
+	for (Job& job : jobs)
+		job.promise.set_value(nullptr);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * An 8-bit RGBA image in system memory, as used by SetOverlayRaw and SetOverlayFromFile.
+ */
+struct OverlayImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/**
+ * Decodes images for SetOverlayFromFile on a background thread, so the app isn't stalled while large PNGs
+ * are decompressed.
+ *
+ * Decoded images are cached by path and modification time. Apps often set the same handful of icons over and
+ * over again (for example when switching between tabs of a menu), and those are then returned immediately.
+ */
+class OverlayImageLoader {
+public:
+	typedef std::shared_future<std::shared_ptr<const OverlayImage>> Result;
+
+	OverlayImageLoader() = default;
+	~OverlayImageLoader();
+
+	OverlayImageLoader(const OverlayImageLoader&) = delete;
+	OverlayImageLoader& operator=(const OverlayImageLoader&) = delete;
+
+	/**
+	 * Start loading the image at the given path, or find it in the cache. If the file couldn't be decoded,
+	 * the result is null.
+	 */
+	Result Load(const std::string& path);
+
+private:
+	struct CacheEntry {
+		std::filesystem::file_time_type modified;
+		Result result;
+		uint64_t lastUsed;
+	};
+
+	struct Job {
+		std::string path;
+		std::promise<std::shared_ptr<const OverlayImage>> promise;
+	};
+
+	// Keep enough images around for a typical overlay menu, without holding onto a lot of memory
+	static constexpr size_t MAX_CACHED_IMAGES = 16;
+
+	void Run();
+
+	std::mutex lock;
+	std::condition_variable jobAdded;
+	std::deque<Job> jobs;
+	bool stopping = false;
+
+	// Started on the first call to Load, since most apps never use SetOverlayFromFile
+	std::thread worker;
+
+	// Only accessed from Load, which is only called from the app's thread
+	std::map<std::string, CacheEntry> cache;
+	uint64_t useCounter = 0;
+};
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+
+#include "PlayAreaGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PlayAreaGeometry::PlayAreaGeometry(std::vector<vr::HmdVector3_t> polygon)
+    : points(std::move(polygon))
+{
+	if (points.empty())
+		return;
+
+	minPoint = points[0];
+	maxPoint = points[0];
+
+	for (const vr::HmdVector3_t& point : points) {
+		for (int i = 0; i < 3; i++) {
+			minPoint.v[i] = std::min(minPoint.v[i], point.v[i]);
+			maxPoint.v[i] = std::max(maxPoint.v[i], point.v[i]);
+		}
+	}
+
+	edges.reserve(points.size());
+	for (size_t i = 0; i < points.size(); i++) {
+		const vr::HmdVector3_t& start = points[i];
+		const vr::HmdVector3_t& end = points[(i + 1) % points.size()];
+
+		Edge edge;
+		edge.startX = start.v[0];
+		edge.startZ = start.v[2];
+		edge.deltaX = end.v[0] - start.v[0];
+		edge.deltaZ = end.v[2] - start.v[2];
+
+		float lengthSq = edge.deltaX * edge.deltaX + edge.deltaZ * edge.deltaZ;
+		edge.invLengthSq = lengthSq > 0 ? 1.0f / lengthSq : 0;
+
+		edges.push_back(edge);
+	}
+}
+
+float PlayAreaGeometry::DistanceToBoundary(float x, float z) const
+{
+	if (edges.empty())
+		return 0;
+
+	float closestSq = std::numeric_limits<float>::max();
+	bool inside = false;
+
+	for (const Edge& edge : edges) {
+		float relX = x - edge.startX;
+		float relZ = z - edge.startZ;
+
+		// Find the closest point on the edge, clamped to its ends
+		float t = std::clamp((relX * edge.deltaX + relZ * edge.deltaZ) * edge.invLengthSq, 0.0f, 1.0f);
+		float offX = relX - edge.deltaX * t;
+		float offZ = relZ - edge.deltaZ * t;
+		closestSq = std::min(closestSq, offX * offX + offZ * offZ);
+
+		// Even-odd rule: count how many edges a ray running along +X from the point crosses
+		float endZ = edge.startZ + edge.deltaZ;
+		if ((edge.startZ > z) != (endZ > z)) {
+			float crossX = edge.startX + edge.deltaX * (z - edge.startZ) / edge.deltaZ;
+			if (x < crossX)
+				inside = !inside;
+		}
+	}
+
+	float distance = std::sqrt(closestSq);
+	return inside ? distance : -distance;
+}
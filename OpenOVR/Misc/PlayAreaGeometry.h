@@ -0,0 +1,42 @@
+#pragma once
+
+#include "generated/interfaces/vrtypes.h"
+
+#include <vector>
+
+/**
+ * The shape of the play area, as a polygon on the floor. This is worked out once when the play area is first
+ * queried, and then reused until the runtime tells us it has changed - some apps query the chaperone every frame
+ * to fade their own boundary in and out, and asking the runtime each time is surprisingly slow on some of them.
+ */
+struct PlayAreaGeometry {
+	/**
+	 * Build the geometry from a polygon, with all the points on the floor (Y=0). The points can go round either
+	 * way, as DistanceToBoundary doesn't depend on the winding.
+	 */
+	explicit PlayAreaGeometry(std::vector<vr::HmdVector3_t> polygon);
+
+	std::vector<vr::HmdVector3_t> points;
+
+	// The axis-aligned bounding box of the points
+	vr::HmdVector3_t minPoint = {};
+	vr::HmdVector3_t maxPoint = {};
+
+	/**
+	 * The edge from points[i] to points[i+1] (wrapping around at the end), with the values needed to find the
+	 * closest point on it already calculated.
+	 */
+	struct Edge {
+		float startX, startZ;
+		float deltaX, deltaZ;
+		float invLengthSq; // Zero for degenerate edges
+	};
+	std::vector<Edge> edges;
+
+	/**
+	 * Returns the horizontal distance from a point to the nearest edge of the play area. This is positive if the
+	 * point is inside the play area and negative if it's outside, and the height of the point is ignored. This is
+	 * what GetBoundsColor fades the bounds in with, which some apps call every frame.
+	 */
+	float DistanceToBoundary(float x, float z) const;
+};
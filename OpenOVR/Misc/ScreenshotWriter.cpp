@@ -0,0 +1,136 @@
+#include "stdafx.h"
+
+#include "ScreenshotWriter.h"
+
+#include "Misc/lodepng.h"
+
+#include <filesystem>
+#include <fstream>
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+	if (!worker.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	jobAdded.notify_all();
+	worker.join();
+}
+
+void ScreenshotWriter::Write(CompositorReadback eyes[2], std::string previewPath, std::string vrPath)
+{
+	Job job;
+	job.eyes[0] = std::move(eyes[0]);
+	job.eyes[1] = std::move(eyes[1]);
+	job.previewPath = std::move(previewPath);
+	job.vrPath = std::move(vrPath);
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(std::move(job));
+
+		if (!worker.joinable())
+			worker = std::thread(&ScreenshotWriter::Run, this);
+	}
+	jobAdded.notify_one();
+}
+
+void ScreenshotWriter::Run()
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			jobAdded.wait(guard, [this]() { return stopping || !jobs.empty(); });
+
+			// Finish any screenshots that were already taken before stopping, since the user is expecting them
+			if (jobs.empty())
+				break;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		Save(job);
+	}
+}
+
+static bool WritePng(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+{
+	// lodepng is built without its file functions, so write the file ourselves
+	std::vector<unsigned char> png;
+	if (unsigned int error = lodepng::encode(png, pixels.data(), width, height, LCT_RGB, 8)) {
+		OOVR_LOGF("Failed to encode screenshot '%s': %s", path.c_str(), lodepng_error_text(error));
+		return false;
+	}
+
+	std::ofstream out(std::filesystem::u8path(path), std::ios::binary);
+	out.write((const char*)png.data(), (std::streamsize)png.size());
+	if (!out) {
+		OOVR_LOGF("Failed to write screenshot '%s'", path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void ScreenshotWriter::Save(Job& job)
+{
+	const CompositorReadback& left = job.eyes[0];
+	const CompositorReadback& right = job.eyes[1];
+
+	bool valid = left.pixels && right.pixels && left.width == right.width && left.height == right.height;
+	uint32_t width = left.width;
+	uint32_t height = left.height;
+
+	// Copy both eyes side-by-side as tightly-packed, top-to-bottom RGB, which is what the images are saved as.
+	// The readbacks can then be released as soon as possible, so the compositors can reuse their buffers.
+	std::vector<uint8_t> combined;
+	if (valid) {
+		combined.resize((size_t)width * 2 * height * 3);
+
+		for (int eye = 0; eye < 2; eye++) {
+			const CompositorReadback& src = job.eyes[eye];
+			int red = src.bgra ? 2 : 0;
+			int blue = src.bgra ? 0 : 2;
+
+			for (uint32_t y = 0; y < height; y++) {
+				uint32_t srcY = src.bottomUp ? height - 1 - y : y;
+				const uint8_t* in = src.pixels + (size_t)srcY * src.rowPitch;
+				uint8_t* out = combined.data() + ((size_t)y * width * 2 + (size_t)eye * width) * 3;
+
+				for (uint32_t x = 0; x < width; x++) {
+					out[0] = in[red];
+					out[1] = in[1];
+					out[2] = in[blue];
+					in += 4;
+					out += 3;
+				}
+			}
+		}
+	}
+
+	for (CompositorReadback& eye : job.eyes) {
+		if (eye.release)
+			eye.release();
+		eye = {};
+	}
+
+	if (!valid) {
+		OOVR_LOGF("Could not read back the eye images for screenshot '%s'", job.vrPath.c_str());
+		return;
+	}
+
+	// The preview is just the left eye, which is the left half of each row of the combined image
+	std::vector<uint8_t> preview((size_t)width * height * 3);
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t* row = combined.data() + (size_t)y * width * 2 * 3;
+		std::copy(row, row + width * 3, preview.data() + (size_t)y * width * 3);
+	}
+
+	if (WritePng(job.previewPath, preview, width, height) && WritePng(job.vrPath, combined, width * 2, height))
+		OOVR_LOGF("Saved screenshot '%s'", job.vrPath.c_str());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Compositor/compositor.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Encodes and saves screenshots on a background thread. Encoding a pair of full-resolution eye images as PNGs
+ * takes far longer than a frame, so this keeps the render thread free to carry on submitting frames.
+ */
+class ScreenshotWriter {
+public:
+	ScreenshotWriter() = default;
+	~ScreenshotWriter();
+
+	ScreenshotWriter(const ScreenshotWriter&) = delete;
+	ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+
+	/**
+	 * Save the left eye to the preview path, and both eyes side-by-side to the VR path. This takes ownership
+	 * of the readbacks, and releases them once their pixels have been copied.
+	 */
+	void Write(CompositorReadback eyes[2], std::string previewPath, std::string vrPath);
+
+private:
+	struct Job {
+		CompositorReadback eyes[2];
+		std::string previewPath;
+		std::string vrPath;
+	};
+
+	void Run();
+	static void Save(Job& job);
+
+	std::mutex lock;
+	std::condition_variable jobAdded;
+	std::deque<Job> jobs;
+	bool stopping = false;
+
+	// Started with the first screenshot, since most sessions never take one
+	std::thread worker;
+};
@@ -0,0 +1,705 @@
+#include "stdafx.h"
+
+#include "SkeletonCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// Format (all multi-byte values are little-endian):
+//   u8  version
+//   u8  flags - see FLAG_*
+//   u32 mask of which bones are present, only if FLAG_ALL_PRESENT isn't set
+//   i8  hand scale - the finger bones' positions are predicted as their reference position times 1 + scale/256
+// Followed by a bitstream (filled from the least significant bit of each byte) with each present bone:
+//   Finger bones (the metacarpals through to the tips):
+//     3x signed  the x/y/z of the rotation relative to the reference pose (see writeFingerBone), in DELTA_STEPs
+//     1 bit      set if the position exactly matches the prediction
+//     3x signed  if it doesn't, the position's offset from the prediction in OFFSET_STEPs
+//   The root, wrist and aux bones:
+//     1 bit      set if the rotation matches the reference rotation (once quantised)
+//     32 bits    if it doesn't, the index of the largest quaternion component in w/x/y/z order (2 bits), then
+//                the remaining three components (10 bits each)
+//     1 bit      set if the position matches the reference position (once quantised)
+//     3x16 bits  if it doesn't, the position in WIDE_STEPs
+// Signed values are stored as Exp-Golomb codes, so the small values most bones have only take a few bits. The aux
+// bones are left out if FLAG_AUX_DERIVED is set, and the last byte is padded with zeros.
+
+namespace skeleton_codec {
+
+static constexpr uint8_t FORMAT_VERSION = 2;
+
+static constexpr uint8_t FLAG_RIGHT = 1;
+static constexpr uint8_t FLAG_MODEL_SPACE = 2; // The application asked for model space, see Encode
+static constexpr uint8_t FLAG_ALL_PRESENT = 4; // Every bone is present, so the mask is left out
+static constexpr uint8_t FLAG_AUX_DERIVED = 8; // The aux bones are the model-space distal bones, see auxMatchesDistal
+
+static constexpr uint32_t ALL_BONES = (1u << BONE_COUNT) - 1;
+static constexpr uint32_t FIRST_FINGER_BONE = 2;
+static constexpr uint32_t FIRST_AUX_BONE = 26;
+
+// Finger rotations, relative to the reference: up to 0.4 degrees out
+static constexpr float DELTA_STEP = 1.0f / 256;
+static constexpr int32_t DELTA_LIMIT = 256;
+
+// Finger positions, relative to the prediction: up to 0.5mm out
+static constexpr float OFFSET_STEP = 1.0f / 1024;
+static constexpr int32_t OFFSET_LIMIT = 4095;
+
+static constexpr float SCALE_STEP = 1.0f / 256;
+
+// The smallest-three rotations of the other bones, which can point anywhere
+static constexpr int ROTATION_BITS = 10;
+static constexpr uint32_t ROTATION_MAX = (1 << ROTATION_BITS) - 1;
+
+// The three smaller components of a normalised quaternion are always in the range [-1/sqrt(2), 1/sqrt(2)]
+static constexpr float ROTATION_RANGE = 0.70710678f;
+static constexpr float ROTATION_STEP = (ROTATION_RANGE * 2) / (float)ROTATION_MAX;
+
+// The positions of the root, wrist and aux bones: +-2m in 61um steps
+static constexpr int WIDE_BITS = 16;
+static constexpr float WIDE_STEP = 1.0f / 16384;
+
+// The size of an Exp-Golomb code for a value up to +-limit
+static constexpr uint32_t signedCodeBits(int32_t limit)
+{
+	uint32_t n = (uint32_t)limit * 2 + 1;
+	uint32_t length = 0;
+	while (n >> (length + 1))
+		length++;
+	return length * 2 + 1;
+}
+
+static constexpr uint32_t MAX_FINGER_BITS = 3 * signedCodeBits(DELTA_LIMIT) + 1 + 3 * signedCodeBits(OFFSET_LIMIT);
+static constexpr uint32_t MAX_WIDE_BITS = 1 + 2 + 3 * ROTATION_BITS + 1 + 3 * WIDE_BITS;
+static constexpr uint32_t FINGER_BONE_COUNT = FIRST_AUX_BONE - FIRST_FINGER_BONE;
+static_assert(7 + (FINGER_BONE_COUNT * MAX_FINGER_BITS + (BONE_COUNT - FINGER_BONE_COUNT) * MAX_WIDE_BITS + 7) / 8 <= MAX_ENCODED_SIZE,
+    "MAX_ENCODED_SIZE is too small for the worst case");
+
+// The parent of each bone. Note the aux bones are always in model space, so they're treated as children of the root.
+// clang-format off
+static constexpr int boneParents[BONE_COUNT] = {
+	-1, // Root
+	0, // Wrist
+	1, 2, 3, 4, // Thumb
+	1, 6, 7, 8, 9, // Index
+	1, 11, 12, 13, 14, // Middle
+	1, 16, 17, 18, 19, // Ring
+	1, 21, 22, 23, 24, // Pinky
+	0, 0, 0, 0, 0, // Aux
+};
+
+// The bone each aux bone is a copy of, in model space (see BaseInput::WriteAuxBones)
+static constexpr int auxSourceBones[BONE_COUNT - FIRST_AUX_BONE] = { 4, 9, 14, 19, 24 };
+
+struct ReferenceBone {
+	float position[3];
+	vr::HmdQuaternionf_t orientation;
+};
+
+// The bind pose from GetSkeletalReferenceTransforms, in parent space and indexed by isRight. This is part of the
+// format, so it's written out here rather than calculated - changing it would need a new FORMAT_VERSION. The aux
+// bones don't have a reference, they're either derived from the distal bones or sent in full.
+static constexpr ReferenceBone referencePose[2][FIRST_AUX_BONE] = {
+	// Left hand
+	{
+		{ { 0.000000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // Root
+		{ { 0.000000f, -0.025000f, 0.130000f }, { 0.000000f, 0.000000f, 1.000000f, 0.000000f } }, // Wrist
+		{ { -0.010000f, 0.025000f, 0.025000f }, { 0.391161f, 0.539614f, -0.047210f, 0.744030f } }, // Thumb0
+		{ { 0.040000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // Thumb1
+		{ { 0.032000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // Thumb2
+		{ { 0.030000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // Thumb3
+		{ { 0.000000f, 0.020000f, 0.010000f }, { 0.512917f, 0.486740f, -0.486740f, 0.512917f } }, // IndexFinger0
+		{ { 0.065000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // IndexFinger1
+		{ { 0.040000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // IndexFinger2
+		{ { 0.025000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // IndexFinger3
+		{ { 0.022000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // IndexFinger4
+		{ { 0.000000f, 0.005000f, 0.010000f }, { 0.500000f, 0.500000f, -0.500000f, 0.500000f } }, // MiddleFinger0
+		{ { 0.063000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // MiddleFinger1
+		{ { 0.045000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // MiddleFinger2
+		{ { 0.028000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // MiddleFinger3
+		{ { 0.024000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // MiddleFinger4
+		{ { 0.000000f, -0.009000f, 0.008000f }, { 0.482246f, 0.517145f, -0.517145f, 0.482246f } }, // RingFinger0
+		{ { 0.058000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // RingFinger1
+		{ { 0.042000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // RingFinger2
+		{ { 0.027000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // RingFinger3
+		{ { 0.023000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // RingFinger4
+		{ { -0.002000f, -0.020000f, 0.006000f }, { 0.459229f, 0.537688f, -0.537688f, 0.459229f } }, // PinkyFinger0
+		{ { 0.054000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // PinkyFinger1
+		{ { 0.034000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // PinkyFinger2
+		{ { 0.020000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // PinkyFinger3
+		{ { 0.021000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // PinkyFinger4
+	},
+	// Right hand
+	{
+		{ { 0.000000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // Root
+		{ { 0.000000f, -0.025000f, 0.130000f }, { 0.000000f, 0.000000f, 1.000000f, 0.000000f } }, // Wrist
+		{ { 0.010000f, 0.025000f, 0.025000f }, { 0.539614f, -0.391161f, 0.744030f, 0.047210f } }, // Thumb0
+		{ { -0.040000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // Thumb1
+		{ { -0.032000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // Thumb2
+		{ { -0.030000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // Thumb3
+		{ { 0.000000f, 0.020000f, 0.010000f }, { 0.486740f, -0.512917f, 0.512917f, 0.486740f } }, // IndexFinger0
+		{ { -0.065000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // IndexFinger1
+		{ { -0.040000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // IndexFinger2
+		{ { -0.025000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // IndexFinger3
+		{ { -0.022000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // IndexFinger4
+		{ { 0.000000f, 0.005000f, 0.010000f }, { 0.500000f, -0.500000f, 0.500000f, 0.500000f } }, // MiddleFinger0
+		{ { -0.063000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // MiddleFinger1
+		{ { -0.045000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // MiddleFinger2
+		{ { -0.028000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // MiddleFinger3
+		{ { -0.024000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // MiddleFinger4
+		{ { 0.000000f, -0.009000f, 0.008000f }, { 0.517145f, -0.482246f, 0.482246f, 0.517145f } }, // RingFinger0
+		{ { -0.058000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // RingFinger1
+		{ { -0.042000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // RingFinger2
+		{ { -0.027000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // RingFinger3
+		{ { -0.023000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // RingFinger4
+		{ { 0.002000f, -0.020000f, 0.006000f }, { 0.537688f, -0.459229f, 0.459229f, 0.537688f } }, // PinkyFinger0
+		{ { -0.054000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // PinkyFinger1
+		{ { -0.034000f, 0.000000f, 0.000000f }, { 0.996195f, 0.000000f, 0.000000f, 0.087156f } }, // PinkyFinger2
+		{ { -0.020000f, 0.000000f, 0.000000f }, { 0.999048f, 0.000000f, 0.000000f, 0.043619f } }, // PinkyFinger3
+		{ { -0.021000f, 0.000000f, 0.000000f }, { 1.000000f, 0.000000f, 0.000000f, 0.000000f } }, // PinkyFinger4
+	},
+};
+// clang-format on
+
+static constexpr ReferenceBone noReference = { { 0, 0, 0 }, { 1, 0, 0, 0 } };
+
+static bool isBonePresent(const vr::VRBoneTransform_t& bone)
+{
+	const vr::HmdQuaternionf_t& q = bone.orientation;
+	return q.w != 0 || q.x != 0 || q.y != 0 || q.z != 0;
+}
+
+static bool isFingerBone(uint32_t bone)
+{
+	return bone >= FIRST_FINGER_BONE && bone < FIRST_AUX_BONE;
+}
+
+static vr::HmdQuaternionf_t multiply(const vr::HmdQuaternionf_t& a, const vr::HmdQuaternionf_t& b)
+{
+	vr::HmdQuaternionf_t out;
+	out.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+	out.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+	out.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+	out.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+	return out;
+}
+
+class BitWriter {
+public:
+	explicit BitWriter(uint8_t* data)
+	    : data(data)
+	{
+	}
+
+	void Write(uint32_t value, int bits)
+	{
+		accumulator |= (uint64_t)value << accumulatorBits;
+		accumulatorBits += bits;
+		while (accumulatorBits >= 8) {
+			data[pos++] = (uint8_t)accumulator;
+			accumulator >>= 8;
+			accumulatorBits -= 8;
+		}
+	}
+
+	// Exp-Golomb code of the value zigzagged to be positive (0, -1, 1, -2, ...), so zero only takes one bit
+	void WriteSigned(int32_t value)
+	{
+		uint32_t n = (value >= 0 ? (uint32_t)value * 2 : (uint32_t)-value * 2 - 1) + 1;
+		int length = 0;
+		while (n >> (length + 1))
+			length++;
+
+		// The length in unary as zeros then a one, followed by the bits below n's leading one
+		Write(1u << length, length + 1);
+		Write(n & ((1u << length) - 1), length);
+	}
+
+	uint32_t Finish()
+	{
+		if (accumulatorBits > 0)
+			data[pos++] = (uint8_t)accumulator;
+		accumulator = 0;
+		accumulatorBits = 0;
+		return pos;
+	}
+
+private:
+	uint8_t* data;
+	uint32_t pos = 0;
+	uint64_t accumulator = 0;
+	int accumulatorBits = 0;
+};
+
+class BitReader {
+public:
+	BitReader(const uint8_t* data, uint32_t size)
+	    : data(data), size(size)
+	{
+	}
+
+	// Returns false if we ran off the end of the buffer
+	bool Read(int bits, uint32_t* value)
+	{
+		while (accumulatorBits < bits) {
+			if (pos >= size)
+				return false;
+			accumulator |= (uint64_t)data[pos++] << accumulatorBits;
+			accumulatorBits += 8;
+		}
+		*value = (uint32_t)(accumulator & ((1ull << bits) - 1));
+		accumulator >>= bits;
+		accumulatorBits -= bits;
+		return true;
+	}
+
+	// Also returns false for codes longer than any the writer produces
+	bool ReadSigned(int32_t* value)
+	{
+		int length = 0;
+		uint32_t bit = 0;
+		while (true) {
+			if (!Read(1, &bit))
+				return false;
+			if (bit)
+				break;
+			if (++length > 16)
+				return false;
+		}
+
+		uint32_t low;
+		if (!Read(length, &low))
+			return false;
+
+		uint32_t zigzag = ((1u << length) | low) - 1;
+		*value = (zigzag & 1) ? -(int32_t)((zigzag + 1) / 2) : (int32_t)(zigzag / 2);
+		return true;
+	}
+
+private:
+	const uint8_t* data;
+	uint32_t size;
+	uint32_t pos = 0;
+	uint64_t accumulator = 0;
+	int accumulatorBits = 0;
+};
+
+// A rotation in smallest-three form
+struct PackedRotation {
+	uint32_t largest;
+	uint32_t values[3];
+
+	bool operator==(const PackedRotation& other) const
+	{
+		return largest == other.largest && values[0] == other.values[0] && values[1] == other.values[1] && values[2] == other.values[2];
+	}
+};
+
+static PackedRotation packRotation(const vr::HmdQuaternionf_t& q)
+{
+	float c[4] = { q.w, q.x, q.y, q.z };
+
+	float length = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+	int largest = 0;
+	for (int i = 0; i < 4; i++) {
+		c[i] /= length;
+		if (std::abs(c[i]) > std::abs(c[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, so flip it to make the largest component positive - that way
+	// we don't need to store it's sign.
+	float sign = c[largest] < 0 ? -1.f : 1.f;
+
+	PackedRotation packed = { (uint32_t)largest, {} };
+	int out = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+
+		float normalised = (c[i] * sign + ROTATION_RANGE) / ROTATION_STEP;
+		long quantised = std::lround(normalised);
+		packed.values[out++] = (uint32_t)std::clamp(quantised, 0l, (long)ROTATION_MAX);
+	}
+	return packed;
+}
+
+static vr::HmdQuaternionf_t unpackRotation(const PackedRotation& packed)
+{
+	float c[4];
+	float sumSquares = 0;
+	int in = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == (int)packed.largest)
+			continue;
+
+		float value = (float)packed.values[in++] * ROTATION_STEP;
+		value = value - ROTATION_RANGE;
+		c[i] = value;
+
+		float square = value * value;
+		sumSquares = sumSquares + square;
+	}
+
+	float remaining = 1.f - sumSquares;
+	c[packed.largest] = remaining > 0 ? std::sqrt(remaining) : 0.f;
+
+	return vr::HmdQuaternionf_t{ c[0], c[1], c[2], c[3] };
+}
+
+static void packPosition(const float position[3], int32_t out[3])
+{
+	const int32_t limit = 1 << (WIDE_BITS - 1);
+	for (int axis = 0; axis < 3; axis++)
+		out[axis] = (int32_t)std::clamp(std::lround(position[axis] / WIDE_STEP), -(long)limit, (long)limit - 1);
+}
+
+static void writeWideBone(BitWriter& writer, const vr::VRBoneTransform_t& bone, const ReferenceBone& reference)
+{
+	PackedRotation rotation = packRotation(bone.orientation);
+	bool rotationMatches = rotation == packRotation(reference.orientation);
+	writer.Write(rotationMatches ? 1 : 0, 1);
+	if (!rotationMatches) {
+		writer.Write(rotation.largest, 2);
+		for (uint32_t value : rotation.values)
+			writer.Write(value, ROTATION_BITS);
+	}
+
+	int32_t position[3], referencePosition[3];
+	packPosition(bone.position.v, position);
+	packPosition(reference.position, referencePosition);
+	bool positionMatches = memcmp(position, referencePosition, sizeof(position)) == 0;
+	writer.Write(positionMatches ? 1 : 0, 1);
+	if (!positionMatches) {
+		for (int32_t value : position)
+			writer.Write((uint32_t)value & ((1u << WIDE_BITS) - 1), WIDE_BITS);
+	}
+}
+
+static bool readWideBone(BitReader& reader, vr::VRBoneTransform_t& bone, const ReferenceBone& reference)
+{
+	uint32_t matches;
+	PackedRotation rotation;
+	if (!reader.Read(1, &matches))
+		return false;
+	if (matches) {
+		rotation = packRotation(reference.orientation);
+	} else {
+		if (!reader.Read(2, &rotation.largest))
+			return false;
+		for (uint32_t& value : rotation.values) {
+			if (!reader.Read(ROTATION_BITS, &value))
+				return false;
+		}
+	}
+	bone.orientation = unpackRotation(rotation);
+
+	int32_t position[3];
+	if (!reader.Read(1, &matches))
+		return false;
+	if (matches) {
+		packPosition(reference.position, position);
+	} else {
+		for (int32_t& value : position) {
+			uint32_t raw;
+			if (!reader.Read(WIDE_BITS, &raw))
+				return false;
+			value = (int32_t)(raw << (32 - WIDE_BITS)) >> (32 - WIDE_BITS); // Sign-extend
+		}
+	}
+
+	// These are exactly representable, since the step is a power of two
+	for (int axis = 0; axis < 3; axis++)
+		bone.position.v[axis] = (float)position[axis] * WIDE_STEP;
+	bone.position.v[3] = 1;
+	return true;
+}
+
+static void writeFingerBone(BitWriter& writer, const vr::VRBoneTransform_t& bone, const ReferenceBone& reference, float scale)
+{
+	// Fingers mostly bend around a single axis, so relative to the reference pose one of these is usually the only
+	// one that's far from zero. The rotation is delta = conjugate(reference) * rotation, with w made positive so it
+	// can be left out.
+	const vr::HmdQuaternionf_t& q = bone.orientation;
+	float length = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	vr::HmdQuaternionf_t normalised = { q.w / length, q.x / length, q.y / length, q.z / length };
+
+	const vr::HmdQuaternionf_t& r = reference.orientation;
+	vr::HmdQuaternionf_t delta = multiply(vr::HmdQuaternionf_t{ r.w, -r.x, -r.y, -r.z }, normalised);
+	float sign = delta.w < 0 ? -1.f : 1.f;
+
+	for (float component : { delta.x, delta.y, delta.z }) {
+		long quantised = std::lround(component * sign / DELTA_STEP);
+		writer.WriteSigned((int32_t)std::clamp(quantised, (long)-DELTA_LIMIT, (long)DELTA_LIMIT));
+	}
+
+	int32_t offsets[3];
+	bool matchesPrediction = true;
+	for (int axis = 0; axis < 3; axis++) {
+		float predicted = reference.position[axis] * scale;
+		long offset = std::lround((bone.position.v[axis] - predicted) / OFFSET_STEP);
+		offsets[axis] = (int32_t)std::clamp(offset, (long)-OFFSET_LIMIT, (long)OFFSET_LIMIT);
+		matchesPrediction = matchesPrediction && offsets[axis] == 0;
+	}
+
+	writer.Write(matchesPrediction ? 1 : 0, 1);
+	if (!matchesPrediction) {
+		for (int32_t offset : offsets)
+			writer.WriteSigned(offset);
+	}
+}
+
+static bool readFingerBone(BitReader& reader, vr::VRBoneTransform_t& bone, const ReferenceBone& reference, float scale)
+{
+	int32_t quantised[3];
+	for (int32_t& value : quantised) {
+		if (!reader.ReadSigned(&value) || value < -DELTA_LIMIT || value > DELTA_LIMIT)
+			return false;
+	}
+
+	// The steps are powers of two, so these are exact
+	vr::HmdQuaternionf_t delta;
+	delta.x = (float)quantised[0] * DELTA_STEP;
+	delta.y = (float)quantised[1] * DELTA_STEP;
+	delta.z = (float)quantised[2] * DELTA_STEP;
+
+	float sumSquares = delta.x * delta.x;
+	sumSquares = sumSquares + delta.y * delta.y;
+	sumSquares = sumSquares + delta.z * delta.z;
+	if (sumSquares <= 1.f) {
+		delta.w = std::sqrt(1.f - sumSquares);
+	} else {
+		// Rounding took this just past a half-turn
+		float length = std::sqrt(sumSquares);
+		delta.w = 0;
+		delta.x = delta.x / length;
+		delta.y = delta.y / length;
+		delta.z = delta.z / length;
+	}
+
+	bone.orientation = multiply(reference.orientation, delta);
+
+	uint32_t matchesPrediction;
+	if (!reader.Read(1, &matchesPrediction))
+		return false;
+
+	for (int axis = 0; axis < 3; axis++) {
+		int32_t offset = 0;
+		if (!matchesPrediction && !reader.ReadSigned(&offset))
+			return false;
+
+		float predicted = reference.position[axis] * scale;
+		bone.position.v[axis] = predicted + (float)offset * OFFSET_STEP;
+	}
+	bone.position.v[3] = 1;
+	return true;
+}
+
+// How much bigger the player's hand is than the reference, found by fitting the finger bones' positions to the
+// reference positions. Most of the difference between hands is their size, so this gets the positions much closer.
+static int32_t fitHandScale(const vr::VRBoneTransform_t* bones, uint32_t mask, const ReferenceBone* reference)
+{
+	float dot = 0;
+	float lengthSquared = 0;
+	for (uint32_t i = FIRST_FINGER_BONE; i < FIRST_AUX_BONE; i++) {
+		if ((mask & (1u << i)) == 0)
+			continue;
+
+		for (int axis = 0; axis < 3; axis++) {
+			dot += bones[i].position.v[axis] * reference[i].position[axis];
+			lengthSquared += reference[i].position[axis] * reference[i].position[axis];
+		}
+	}
+
+	if (lengthSquared == 0)
+		return 0;
+
+	long scale = std::lround((dot / lengthSquared - 1.f) / SCALE_STEP);
+	return (int32_t)std::clamp(scale, (long)INT8_MIN, (long)INT8_MAX);
+}
+
+// The aux bones are normally the same as the distal bones, but in model space (see BaseInput::WriteAuxBones). In
+// that case they can be rebuilt from the other bones rather than sent.
+static bool auxMatchesDistal(const vr::VRBoneTransform_t* bones)
+{
+	vr::VRBoneTransform_t modelSpace[BONE_COUNT];
+	ParentToModelSpace(bones, modelSpace);
+
+	for (uint32_t i = FIRST_AUX_BONE; i < BONE_COUNT; i++) {
+		const vr::VRBoneTransform_t& aux = bones[i];
+		const vr::VRBoneTransform_t& distal = modelSpace[auxSourceBones[i - FIRST_AUX_BONE]];
+
+		for (int axis = 0; axis < 3; axis++) {
+			if (std::abs(aux.position.v[axis] - distal.position.v[axis]) > 0.0001f)
+				return false;
+		}
+
+		// Allow for a little rounding error, but nothing that would be visible. q and -q are the same rotation.
+		const vr::HmdQuaternionf_t& a = aux.orientation;
+		const vr::HmdQuaternionf_t& b = distal.orientation;
+		float dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+		float lengths = std::sqrt((a.w * a.w + a.x * a.x + a.y * a.y + a.z * a.z) * (b.w * b.w + b.x * b.x + b.y * b.y + b.z * b.z));
+		if (std::abs(dot) < lengths * 0.99999f)
+			return false;
+	}
+
+	return true;
+}
+
+void GetReferencePose(bool isRight, vr::VRBoneTransform_t* parentSpaceBones)
+{
+	vr::VRBoneTransform_t modelSpace[BONE_COUNT];
+
+	for (uint32_t i = 0; i < FIRST_AUX_BONE; i++) {
+		const ReferenceBone& reference = referencePose[isRight][i];
+		vr::VRBoneTransform_t& bone = parentSpaceBones[i];
+		bone.position = vr::HmdVector4_t{ reference.position[0], reference.position[1], reference.position[2], 1 };
+		bone.orientation = reference.orientation;
+	}
+
+	ParentToModelSpace(parentSpaceBones, modelSpace);
+	for (uint32_t i = FIRST_AUX_BONE; i < BONE_COUNT; i++)
+		parentSpaceBones[i] = modelSpace[auxSourceBones[i - FIRST_AUX_BONE]];
+}
+
+uint32_t Encode(const vr::VRBoneTransform_t* bones, bool isRight, bool modelSpace, uint8_t* buffer)
+{
+	const ReferenceBone* reference = referencePose[isRight];
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < BONE_COUNT; i++) {
+		if (isBonePresent(bones[i]))
+			mask |= 1u << i;
+	}
+
+	bool auxDerived = mask == ALL_BONES && auxMatchesDistal(bones);
+
+	uint32_t pos = 0;
+	buffer[pos++] = FORMAT_VERSION;
+	buffer[pos++] = (isRight ? FLAG_RIGHT : 0) | (modelSpace ? FLAG_MODEL_SPACE : 0) | (mask == ALL_BONES ? FLAG_ALL_PRESENT : 0)
+	    | (auxDerived ? FLAG_AUX_DERIVED : 0);
+
+	if (mask != ALL_BONES) {
+		for (int i = 0; i < 4; i++)
+			buffer[pos++] = (uint8_t)(mask >> (i * 8));
+	}
+
+	int32_t scale = fitHandScale(bones, mask, reference);
+	buffer[pos++] = (uint8_t)(int8_t)scale;
+	float scaleFactor = 1.f + (float)scale * SCALE_STEP;
+
+	BitWriter writer(buffer + pos);
+
+	for (uint32_t i = 0; i < BONE_COUNT; i++) {
+		if ((mask & (1u << i)) == 0 || (auxDerived && i >= FIRST_AUX_BONE))
+			continue;
+
+		if (isFingerBone(i))
+			writeFingerBone(writer, bones[i], reference[i], scaleFactor);
+		else
+			writeWideBone(writer, bones[i], i < FIRST_AUX_BONE ? reference[i] : noReference);
+	}
+
+	return pos + writer.Finish();
+}
+
+bool Decode(const void* data, uint32_t size, vr::VRBoneTransform_t* bones, bool* modelSpace)
+{
+	const uint8_t* buffer = (const uint8_t*)data;
+	uint32_t pos = 0;
+	if (size < 3 || buffer[pos++] != FORMAT_VERSION)
+		return false;
+
+	uint8_t flags = buffer[pos++];
+	bool isRight = (flags & FLAG_RIGHT) != 0;
+	bool auxDerived = (flags & FLAG_AUX_DERIVED) != 0;
+	if (modelSpace)
+		*modelSpace = (flags & FLAG_MODEL_SPACE) != 0;
+
+	uint32_t mask = ALL_BONES;
+	if ((flags & FLAG_ALL_PRESENT) == 0) {
+		if (size < pos + 5)
+			return false;
+		mask = 0;
+		for (int i = 0; i < 4; i++)
+			mask |= (uint32_t)buffer[pos++] << (i * 8);
+	}
+
+	// The aux bones can only be rebuilt if everything they're built from is there
+	if (auxDerived && mask != ALL_BONES)
+		return false;
+
+	// Exact, since the scale is at most 128 steps of a power of two
+	float scaleFactor = 1.f + (float)(int8_t)buffer[pos++] * SCALE_STEP;
+
+	const ReferenceBone* reference = referencePose[isRight];
+	memset(bones, 0, sizeof(vr::VRBoneTransform_t) * BONE_COUNT);
+
+	BitReader reader(buffer + pos, size - pos);
+
+	for (uint32_t i = 0; i < BONE_COUNT; i++) {
+		if ((mask & (1u << i)) == 0 || (auxDerived && i >= FIRST_AUX_BONE))
+			continue;
+
+		bool ok;
+		if (isFingerBone(i))
+			ok = readFingerBone(reader, bones[i], reference[i], scaleFactor);
+		else
+			ok = readWideBone(reader, bones[i], i < FIRST_AUX_BONE ? reference[i] : noReference);
+
+		if (!ok)
+			return false;
+	}
+
+	if (auxDerived) {
+		vr::VRBoneTransform_t modelSpaceBones[BONE_COUNT];
+		ParentToModelSpace(bones, modelSpaceBones);
+		for (uint32_t i = FIRST_AUX_BONE; i < BONE_COUNT; i++)
+			bones[i] = modelSpaceBones[auxSourceBones[i - FIRST_AUX_BONE]];
+	}
+
+	return true;
+}
+
+void ParentToModelSpace(const vr::VRBoneTransform_t* parentSpace, vr::VRBoneTransform_t* modelSpace)
+{
+	// Written out by hand rather than using glm, so the operations happen in a fixed order
+	// regardless of what SIMD options glm was built with.
+	for (uint32_t i = 0; i < BONE_COUNT; i++) {
+		const vr::VRBoneTransform_t& local = parentSpace[i];
+		vr::VRBoneTransform_t& out = modelSpace[i];
+
+		int parentId = boneParents[i];
+		if (parentId == -1 || !isBonePresent(local)) {
+			out = local;
+			continue;
+		}
+
+		// Bones always come after their parents, so this has already been converted
+		const vr::HmdQuaternionf_t& pq = modelSpace[parentId].orientation;
+		const float* pp = modelSpace[parentId].position.v;
+		const vr::HmdQuaternionf_t& q = local.orientation;
+		const float* v = local.position.v;
+
+		// Rotate the position by the parent's rotation: v' = v + 2w(u x v) + 2(u x (u x v)), where u is the vector part
+		float tx = 2.f * (pq.y * v[2] - pq.z * v[1]);
+		float ty = 2.f * (pq.z * v[0] - pq.x * v[2]);
+		float tz = 2.f * (pq.x * v[1] - pq.y * v[0]);
+		float rx = v[0] + pq.w * tx + (pq.y * tz - pq.z * ty);
+		float ry = v[1] + pq.w * ty + (pq.z * tx - pq.x * tz);
+		float rz = v[2] + pq.w * tz + (pq.x * ty - pq.y * tx);
+
+		out.position.v[0] = pp[0] + rx;
+		out.position.v[1] = pp[1] + ry;
+		out.position.v[2] = pp[2] + rz;
+		out.position.v[3] = 1;
+
+		out.orientation.w = pq.w * q.w - pq.x * q.x - pq.y * q.y - pq.z * q.z;
+		out.orientation.x = pq.w * q.x + pq.x * q.w + pq.y * q.z - pq.z * q.y;
+		out.orientation.y = pq.w * q.y - pq.x * q.z + pq.y * q.w + pq.z * q.x;
+		out.orientation.z = pq.w * q.z + pq.x * q.y - pq.y * q.x + pq.z * q.w;
+	}
+}
+
+} // namespace skeleton_codec
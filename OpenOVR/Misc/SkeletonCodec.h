@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * The encoding used for GetSkeletalBoneDataCompressed. Social VR apps send this to other players every
+ * network tick, so it's designed to be small and cheap to encode rather than perfectly accurate.
+ *
+ * Everything is stored relative to the reference (bind) pose: finger rotations as a small delta from it, and
+ * positions as an offset from the reference hand scaled to the player's hand size, both as variable-length codes
+ * so bones that barely move take a few bits. The aux bones are normally copies of the distal bones, in which
+ * case they're left out and rebuilt when decoding. The result is 20-50 bytes for a typical hand, and around
+ * 100 for noisy hand tracking, compared to 992 for the raw transforms.
+ *
+ * Decoding only uses basic IEEE float operations and sqrt, in a fixed order, so it produces identical bits
+ * on every platform - apps can rely on all the players seeing exactly the same hand.
+ */
+namespace skeleton_codec {
+
+static constexpr uint32_t BONE_COUNT = 31;
+
+// The largest possible encoded size, which is well within the limit of sizeof(VRBoneTransform_t)*boneCount + 2
+// that OpenVR guarantees to applications.
+static constexpr uint32_t MAX_ENCODED_SIZE = 480;
+
+/**
+ * Encode a set of parent-space bones into buffer, which must be at least MAX_ENCODED_SIZE bytes long.
+ *
+ * modelSpace is stored in the output so the legacy version of DecompressSkeletalBoneData can report which space
+ * the application asked for. The bones must still be in parent space.
+ *
+ * Returns the number of bytes used.
+ */
+uint32_t Encode(const vr::VRBoneTransform_t* parentSpaceBones, bool isRight, bool modelSpace, uint8_t* buffer);
+
+/**
+ * Decode a buffer produced by Encode. Any bones that were zeroed out (which we use to indicate missing bones)
+ * are zeroed out again.
+ *
+ * Returns false if the buffer isn't valid.
+ */
+bool Decode(const void* buffer, uint32_t size, vr::VRBoneTransform_t* parentSpaceBones, bool* modelSpace);
+
+/**
+ * Convert a set of parent-space bones to model space, with the same floating-point guarantees as Decode.
+ */
+void ParentToModelSpace(const vr::VRBoneTransform_t* parentSpaceBones, vr::VRBoneTransform_t* modelSpaceBones);
+
+/**
+ * Get the reference pose everything is encoded relative to, in parent space. This encodes to the smallest size.
+ */
+void GetReferencePose(bool isRight, vr::VRBoneTransform_t* parentSpaceBones);
+
+} // namespace skeleton_codec
@@ -6,8 +6,8 @@
 #define FILENAME_RES_O_HAND_LEFT "assets/LeftHand.obj"
 #define FILENAME_RES_O_HAND_RIGHT "assets/RightHand.obj"
 #define FILENAME_RES_O_FNT_UBUNTU "assets/Ubuntu-30.sfn"
+#define FILENAME_RES_O_FNT_UBUNTU_TEXTURE "assets/Ubuntu-30-texture.png"
 #define FILENAME_RES_O_KB_EN_GB "assets/en_gb.kb"
-// RES_O_FNT_UBUNTU	RES_T_PNG	"assets/Ubuntu-30-texture.png"
 
 // TODO do we need an alignment directive?
 
@@ -76,6 +76,11 @@ public:
 	XrExt(XrGraphicsApiSupportedFlags apis, const std::vector<const char*>& extensions);
 
 	bool G2Controller_Available() { return supportsG2Controller; }
+	bool CompositionLayerCylinder_Available() { return supportsCompositionLayerCylinder; }
+	bool CompositionLayerCube_Available() { return supportsCompositionLayerCube; }
+	bool CompositionLayerDepth_Available() { return supportsCompositionLayerDepth; }
+	bool SpaceWarp_Available() { return supportsSpaceWarp; }
+	bool ViveTrackers_Available() { return supportsViveTrackers; }
 	bool xrGetVisibilityMaskKHR_Available() { return pfnXrGetVisibilityMaskKHR != nullptr; }
 	XrResult xrGetVisibilityMaskKHR(
 	    XrSession session,
@@ -105,6 +110,16 @@ public:
 		return pfnXrLocateHandJointsExt(handTracker, locateInfo, locations);
 	}
 
+	// Provided by either XR_KHR_locate_spaces or OpenXR 1.1, where it was promoted to core as xrLocateSpaces
+	bool xrLocateSpacesKHR_Available() { return pfnXrLocateSpacesKHR != nullptr; }
+#ifdef XR_KHR_locate_spaces
+	XrResult xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR* locateInfo, XrSpaceLocationsKHR* spaceLocations)
+	{
+		OOVR_FALSE_ABORT(pfnXrLocateSpacesKHR);
+		return ((PFN_xrLocateSpacesKHR)pfnXrLocateSpacesKHR)(session, locateInfo, spaceLocations);
+	}
+#endif
+
 #if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
 	bool xrGetD3D11GraphicsRequirementsKHR_Available()
 	{
@@ -184,7 +199,13 @@ private:
 	PFN_xrCreateHandTrackerEXT pfnXrCreateHandTrackerExt = nullptr;
 	PFN_xrDestroyHandTrackerEXT pfnXrDestroyHandTrackerExt = nullptr;
 	PFN_xrLocateHandJointsEXT pfnXrLocateHandJointsExt = nullptr;
+	PFN_xrVoidFunction pfnXrLocateSpacesKHR = nullptr; // Stored untyped as older SDKs don't have the extension
 	bool supportsG2Controller = false;
+	bool supportsCompositionLayerCylinder = false;
+	bool supportsCompositionLayerCube = false;
+	bool supportsCompositionLayerDepth = false;
+	bool supportsSpaceWarp = false;
+	bool supportsViveTrackers = false;
 
 #if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
 	PFN_xrGetD3D11GraphicsRequirementsKHR pfnXrGetD3D11GraphicsRequirementsKHR = nullptr;
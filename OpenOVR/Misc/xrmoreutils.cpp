@@ -8,9 +8,12 @@
 #include "OneEuroFilterPosition.cpp"
 #include "OneEuroFilterRotation.cpp"
 #include "xrmoreutils.h"
+#include "xr_ext.h"
+#include <algorithm>
 #include <chrono>
 #include <convert.h>
 #include <map>
+#include <mutex>
 
 bool isInitialized = false;
 
@@ -64,14 +67,22 @@ void xr_utils::PoseFromSpace(vr::TrackedDevicePose_t* pose, XrSpace space, vr::E
 	XrSpaceVelocity velocity{ XR_TYPE_SPACE_VELOCITY };
 	XrSpaceLocation info{ XR_TYPE_SPACE_LOCATION, &velocity, 0, {} };
 
-	OOVR_FAILED_XR_SOFT_ABORT(xrLocateSpace(space, baseSpace, xr_gbl->GetBestTime(), &info));
+	OOVR_FAILED_XR_SOFT_ABORT(xr_utils::LocateSpace(space, baseSpace, &info));
 
 	glm::mat4 mat = X2G_om34_pose(info.pose);
 
 	if (extraTransform) {
 		mat = mat * extraTransform.value();
 
-		if (oovr_global_configuration.EnableControllerSmoothing()) {
+		if (oovr_global_configuration->EnableControllerSmoothing()) {
+			// The filters are built with the smoothing parameters from the config, so rebuild them if it's reloaded
+			static uint32_t filterConfigGeneration = 0;
+			if (filterConfigGeneration != oovr_global_configuration.Generation()) {
+				filterConfigGeneration = oovr_global_configuration.Generation();
+				posFilters.clear();
+				rotationFilters.clear();
+			}
+
 			// Initialization and time computations
 			static std::map<int, long long> previousTimes;
 			long long currentTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -96,7 +107,7 @@ void xr_utils::PoseFromSpace(vr::TrackedDevicePose_t* pose, XrSpace space, vr::E
 				glm::quat currentRotation = glm::quat_cast(mat);
 
 				if (posFilters.find(device) == posFilters.end()) {
-					posFilters[device] = OneEuroFilterPosition(rate, oovr_global_configuration.PosSmoothMinCutoff(), oovr_global_configuration.PosSmoothBeta(), 1);
+					posFilters[device] = OneEuroFilterPosition(rate, oovr_global_configuration->PosSmoothMinCutoff(), oovr_global_configuration->PosSmoothBeta(), 1);
 				} else {
 					posFilters[device].setFreq(rate);
 				}
@@ -104,7 +115,7 @@ void xr_utils::PoseFromSpace(vr::TrackedDevicePose_t* pose, XrSpace space, vr::E
 				position = posFilters[device].filter(position, velocityVec);
 
 				if (rotationFilters.find(device) == rotationFilters.end()) {
-					rotationFilters[device] = OneEuroFilterRotation(rate, oovr_global_configuration.RotSmoothMinCutoff(), oovr_global_configuration.RotSmoothBeta(), 1);
+					rotationFilters[device] = OneEuroFilterRotation(rate, oovr_global_configuration->RotSmoothMinCutoff(), oovr_global_configuration->RotSmoothBeta(), 1);
 				} else {
 					rotationFilters[device].setFreq(rate);
 				}
@@ -136,3 +147,211 @@ void xr_utils::PoseFromSpace(vr::TrackedDevicePose_t* pose, XrSpace space, vr::E
 	pose->vVelocity = X2S_v3f(velocity.linearVelocity); // No offsetting transform - this is in world-space
 	pose->vAngularVelocity = X2S_v3f(velocity.angularVelocity); // TODO find out if this needs a transform
 }
+
+// The results of the last LocateSpaces call. This is only ever a handful of spaces (the HMD, the
+// grip and aim poses of each hand, and any body trackers), so it's searched linearly.
+static constexpr uint32_t maxBatchedSpaces = 32;
+
+struct SpaceLocationBatch {
+	XrTime time = 0;
+	XrSpace baseSpace = XR_NULL_HANDLE;
+	uint32_t count = 0;
+	XrSpace spaces[maxBatchedSpaces];
+	XrSpaceLocation locations[maxBatchedSpaces];
+	XrSpaceVelocity velocities[maxBatchedSpaces];
+};
+
+static std::mutex locateMutex;
+static SpaceLocationBatch locateBatch;
+
+// Set if xrLocateSpaces ever fails, after which every space is located individually
+static bool batchingFailed = false;
+
+static XrTime statsFrameTime = 0;
+static xr_utils::SpaceLocateStats currentFrameStats;
+static xr_utils::SpaceLocateStats lastFrameStats;
+
+// The totals since the stats were last written to the log, which happens every few seconds
+static xr_utils::SpaceLocateStats intervalStats;
+static uint32_t intervalFrames = 0;
+static std::chrono::steady_clock::time_point intervalStart = std::chrono::steady_clock::now();
+
+// Must be called with locateMutex held
+static void updateLocateStatsFrame(XrTime time)
+{
+	if (time == statsFrameTime)
+		return;
+
+	if (statsFrameTime != 0 && currentFrameStats.runtimeCalls != 0) {
+		lastFrameStats = currentFrameStats;
+		intervalStats.runtimeCalls += currentFrameStats.runtimeCalls;
+		intervalStats.spacesLocated += currentFrameStats.spacesLocated;
+		intervalStats.cacheHits += currentFrameStats.cacheHits;
+		intervalFrames++;
+	}
+
+	statsFrameTime = time;
+	currentFrameStats = {};
+
+	auto now = std::chrono::steady_clock::now();
+	std::chrono::duration<float> elapsed = now - intervalStart;
+	if (elapsed.count() < 10.0f)
+		return;
+
+	if (intervalFrames != 0) {
+		const char* mode = batchingFailed ? "failed" : (xr_ext->xrLocateSpacesKHR_Available() ? "available" : "unavailable");
+		OOVR_LOGF("Space locate stats: %.1f runtime calls for %.1f spaces per frame, %.1f served from batch (xrLocateSpaces %s)",
+		    (float)intervalStats.runtimeCalls / intervalFrames, (float)intervalStats.spacesLocated / intervalFrames,
+		    (float)intervalStats.cacheHits / intervalFrames, mode);
+	}
+
+	intervalStats = {};
+	intervalFrames = 0;
+	intervalStart = now;
+}
+
+// Must be called with locateMutex held
+static int findBatchedSpace(XrTime time, XrSpace space)
+{
+	if (locateBatch.time != time)
+		return -1;
+
+	for (uint32_t i = 0; i < locateBatch.count; i++) {
+		if (locateBatch.spaces[i] == space)
+			return (int)i;
+	}
+	return -1;
+}
+
+void xr_utils::LocateSpaces(XrSpace baseSpace, const XrSpace* spaces, uint32_t count)
+{
+#ifdef XR_KHR_locate_spaces
+	if (!xr_ext->xrLocateSpacesKHR_Available() || count == 0)
+		return;
+
+	OOVR_FALSE_ABORT(count <= maxBatchedSpaces);
+
+	XrTime time = xr_gbl->GetBestTime();
+
+	std::lock_guard<std::mutex> lock(locateMutex);
+	updateLocateStatsFrame(time);
+
+	if (batchingFailed)
+		return;
+
+	// Skip this if we've already located the same spaces this frame, eg if both GetLastPoses and GetDeviceToAbsoluteTrackingPose are called
+	if (locateBatch.time == time && locateBatch.baseSpace == baseSpace && locateBatch.count == count
+	    && std::equal(spaces, spaces + count, locateBatch.spaces)) {
+		return;
+	}
+
+	XrSpacesLocateInfoKHR locateInfo = { XR_TYPE_SPACES_LOCATE_INFO_KHR };
+	locateInfo.baseSpace = baseSpace;
+	locateInfo.time = time;
+	locateInfo.spaceCount = count;
+	locateInfo.spaces = spaces;
+
+	XrSpaceLocationDataKHR locationData[maxBatchedSpaces] = {};
+	XrSpaceVelocityDataKHR velocityData[maxBatchedSpaces] = {};
+
+	XrSpaceVelocitiesKHR velocities = { XR_TYPE_SPACE_VELOCITIES_KHR };
+	velocities.velocityCount = count;
+	velocities.velocities = velocityData;
+
+	XrSpaceLocationsKHR locations = { XR_TYPE_SPACE_LOCATIONS_KHR, &velocities };
+	locations.locationCount = count;
+	locations.locations = locationData;
+
+	currentFrameStats.runtimeCalls++;
+	XrResult res = xr_ext->xrLocateSpacesKHR(xr_session.get(), &locateInfo, &locations);
+	if (XR_FAILED(res)) {
+		// Fall back to locating the spaces one at a time from now on, rather than trying (and failing) every frame
+		OOVR_LOGF("xrLocateSpaces failed with %d, locating spaces individually from now on", res);
+		batchingFailed = true;
+		locateBatch.count = 0;
+		locateBatch.time = 0;
+		return;
+	}
+	currentFrameStats.spacesLocated += count;
+
+	locateBatch.time = time;
+	locateBatch.baseSpace = baseSpace;
+	locateBatch.count = count;
+	for (uint32_t i = 0; i < count; i++) {
+		locateBatch.spaces[i] = spaces[i];
+
+		XrSpaceLocation& location = locateBatch.locations[i];
+		location = { XR_TYPE_SPACE_LOCATION };
+		location.locationFlags = locationData[i].locationFlags;
+		location.pose = locationData[i].pose;
+
+		XrSpaceVelocity& velocity = locateBatch.velocities[i];
+		velocity = { XR_TYPE_SPACE_VELOCITY };
+		velocity.velocityFlags = velocityData[i].velocityFlags;
+		velocity.linearVelocity = velocityData[i].linearVelocity;
+		velocity.angularVelocity = velocityData[i].angularVelocity;
+	}
+#endif
+}
+
+XrResult xr_utils::LocateSpace(XrSpace space, XrSpace baseSpace, XrSpaceLocation* location)
+{
+	XrTime time = xr_gbl->GetBestTime();
+
+	XrSpaceVelocity* velocity = nullptr;
+	if (location->next && ((XrBaseOutStructure*)location->next)->type == XR_TYPE_SPACE_VELOCITY)
+		velocity = (XrSpaceVelocity*)location->next;
+
+	{
+		std::lock_guard<std::mutex> lock(locateMutex);
+		updateLocateStatsFrame(time);
+
+		int spaceIdx = findBatchedSpace(time, space);
+		if (spaceIdx != -1 && locateBatch.baseSpace == baseSpace) {
+			const XrSpaceLocation& cached = locateBatch.locations[spaceIdx];
+			location->locationFlags = cached.locationFlags;
+			location->pose = cached.pose;
+
+			if (velocity) {
+				const XrSpaceVelocity& cachedVelocity = locateBatch.velocities[spaceIdx];
+				velocity->velocityFlags = cachedVelocity.velocityFlags;
+				velocity->linearVelocity = cachedVelocity.linearVelocity;
+				velocity->angularVelocity = cachedVelocity.angularVelocity;
+			}
+
+			currentFrameStats.cacheHits++;
+			return XR_SUCCESS;
+		}
+
+		// If both spaces were located against a common base space, we can find one relative to the other. This
+		// is used to get the aim pose relative to the grip pose. The velocities would need transforming too, so
+		// don't bother if they're requested.
+		int baseIdx = findBatchedSpace(time, baseSpace);
+		if (spaceIdx != -1 && baseIdx != -1 && !velocity) {
+			const XrSpaceLocation& a = locateBatch.locations[spaceIdx];
+			const XrSpaceLocation& b = locateBatch.locations[baseIdx];
+
+			glm::quat baseInverse = glm::conjugate(X2G_quat(b.pose.orientation));
+			glm::quat rotation = baseInverse * X2G_quat(a.pose.orientation);
+			glm::vec3 position = baseInverse * (X2G_v3f(a.pose.position) - X2G_v3f(b.pose.position));
+
+			location->locationFlags = a.locationFlags & b.locationFlags;
+			location->pose.orientation = G2X_quat(rotation);
+			location->pose.position = G2X_v3f(position);
+
+			currentFrameStats.cacheHits++;
+			return XR_SUCCESS;
+		}
+
+		currentFrameStats.runtimeCalls++;
+		currentFrameStats.spacesLocated++;
+	}
+
+	return xrLocateSpace(space, baseSpace, time, location);
+}
+
+xr_utils::SpaceLocateStats xr_utils::GetLastFrameLocateStats()
+{
+	std::lock_guard<std::mutex> lock(locateMutex);
+	return lastFrameStats;
+}
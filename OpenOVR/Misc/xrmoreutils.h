@@ -17,4 +17,31 @@ namespace xr_utils {
 void PoseFromSpace(vr::TrackedDevicePose_t* pose, XrSpace space, vr::ETrackingUniverseOrigin origin,
     std::optional<glm::mat4> extraTransform = {}, int device = 2);
 
+/**
+ * Locate several spaces relative to the same base space at the current predicted frame time. When the runtime
+ * supports xrLocateSpaces (XR_KHR_locate_spaces or OpenXR 1.1) this is done in a single call, and the results are
+ * kept until the frame time changes so LocateSpace and PoseFromSpace don't have to call the runtime.
+ *
+ * Without xrLocateSpaces this does nothing, and each space is located individually as it's used. The same goes
+ * for every later frame if xrLocateSpaces fails once.
+ */
+void LocateSpaces(XrSpace baseSpace, const XrSpace* spaces, uint32_t count);
+
+/**
+ * Equivalent to xrLocateSpace at the current predicted frame time, but using the results from LocateSpaces if they're
+ * available. An XrSpaceVelocity may be chained onto location as normal.
+ */
+XrResult LocateSpace(XrSpace space, XrSpace baseSpace, XrSpaceLocation* location);
+
+struct SpaceLocateStats {
+	uint32_t runtimeCalls = 0; // Calls to xrLocateSpace or xrLocateSpaces
+	uint32_t spacesLocated = 0; // Total number of spaces the runtime located
+	uint32_t cacheHits = 0; // Locations served from a LocateSpaces batch
+};
+
+/**
+ * Get the statistics for the last full frame, for checking how many runtime calls the batching saves.
+ */
+SpaceLocateStats GetLastFrameLocateStats();
+
 }
@@ -29,6 +29,7 @@ XrExt::XrExt(XrGraphicsApiSupportedFlags apis, const std::vector<const char*>& e
 	// Check the extensions we have selected, and don't fetch functions if we're not allowed to use them
 	bool hasVisMask = false;
 	bool hasHandTracking = false;
+	bool hasLocateSpaces = false;
 	for (const char* ext : extensions) {
 		if (strcmp(ext, XR_KHR_VISIBILITY_MASK_EXTENSION_NAME) == 0)
 			hasVisMask = true;
@@ -36,6 +37,20 @@ XrExt::XrExt(XrGraphicsApiSupportedFlags apis, const std::vector<const char*>& e
 			hasHandTracking = true;
 		if (strcmp(ext, XR_EXT_HP_MIXED_REALITY_CONTROLLER_EXTENSION_NAME) == 0)
 			supportsG2Controller = true;
+		if (strcmp(ext, XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME) == 0)
+			supportsCompositionLayerCylinder = true;
+		if (strcmp(ext, XR_KHR_COMPOSITION_LAYER_CUBE_EXTENSION_NAME) == 0)
+			supportsCompositionLayerCube = true;
+		if (strcmp(ext, XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME) == 0)
+			supportsCompositionLayerDepth = true;
+		if (strcmp(ext, XR_FB_SPACE_WARP_EXTENSION_NAME) == 0)
+			supportsSpaceWarp = true;
+		if (strcmp(ext, XR_HTCX_VIVE_TRACKER_INTERACTION_EXTENSION_NAME) == 0)
+			supportsViveTrackers = true;
+#ifdef XR_KHR_locate_spaces
+		if (strcmp(ext, XR_KHR_LOCATE_SPACES_EXTENSION_NAME) == 0)
+			hasLocateSpaces = true;
+#endif
 	}
 
 #define XR_BIND(name, function) OOVR_FAILED_XR_ABORT(xrGetInstanceProcAddr(xr_instance, #name, (PFN_xrVoidFunction*)&this->function))
@@ -50,6 +65,15 @@ XrExt::XrExt(XrGraphicsApiSupportedFlags apis, const std::vector<const char*>& e
 		XR_BIND(xrLocateHandJointsEXT, pfnXrLocateHandJointsExt);
 	}
 
+	// The core and extension versions of xrLocateSpaces have identical signatures. If we asked for
+	// OpenXR 1.1 then the core version is available without enabling the extension.
+	if (hasLocateSpaces)
+		XR_BIND_OPT(xrLocateSpacesKHR, pfnXrLocateSpacesKHR);
+#ifdef XR_VERSION_1_1
+	if (!pfnXrLocateSpacesKHR && XR_CURRENT_API_VERSION >= XR_API_VERSION_1_1)
+		XR_BIND_OPT(xrLocateSpaces, pfnXrLocateSpacesKHR);
+#endif
+
 #if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
 	if (apis & XR_SUPPORTED_GRAPHICS_API_D3D11) {
 		XR_BIND(xrGetD3D11GraphicsRequirementsKHR, pfnXrGetD3D11GraphicsRequirementsKHR);
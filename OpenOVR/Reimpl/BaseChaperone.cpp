@@ -5,8 +5,9 @@
 #include "generated/static_bases.gen.h"
 
 #include "Drivers/Backend.h"
+#include "Misc/PlayAreaGeometry.h"
 
-#include <vector>
+#include <algorithm>
 
 using namespace vr;
 
@@ -62,7 +63,36 @@ void BaseChaperone::SetSceneColor(HmdColor_t color)
 }
 void BaseChaperone::GetBoundsColor(HmdColor_t* pOutputColorArray, int nNumOutputColors, float flCollisionBoundsFadeDistance, HmdColor_t* pOutputCameraColor)
 {
-	STUBBED();
+	// The runtime draws its own bounds, and doesn't tell us what colour they are, so use SteamVR's default cyan.
+	// Like SteamVR, they fade in as the headset gets within the fade distance of the edge of the play area, and
+	// are fully shown once it's on or past the edge.
+	float alpha = 0;
+
+	const PlayAreaGeometry* playArea = BackendManager::Instance().GetPlayAreaGeometry();
+	if (playArea && playArea->points.size() >= 2) {
+		// The play area is in stage space, which is the standing universe
+		TrackedDevicePose_t pose;
+		BackendManager::Instance().GetSinglePose(TrackingUniverseStanding, k_unTrackedDeviceIndex_Hmd, &pose, ETrackingStateType::TrackingStateType_Now);
+
+		if (pose.bPoseIsValid) {
+			const HmdMatrix34_t& mat = pose.mDeviceToAbsoluteTracking;
+			float distance = playArea->DistanceToBoundary(mat.m[0][3], mat.m[2][3]);
+
+			if (distance <= 0)
+				alpha = 1;
+			else if (flCollisionBoundsFadeDistance > 0)
+				alpha = std::max(0.0f, 1 - distance / flCollisionBoundsFadeDistance);
+		}
+	}
+
+	if (pOutputColorArray) {
+		for (int i = 0; i < nNumOutputColors; i++)
+			pOutputColorArray[i] = HmdColor_t{ 0, 1, 1, alpha };
+	}
+
+	// There's no passthrough camera view to fade in
+	if (pOutputCameraColor)
+		*pOutputCameraColor = HmdColor_t{ 0, 0, 0, 0 };
 }
 bool BaseChaperone::AreBoundsVisible()
 {
@@ -75,30 +105,16 @@ void BaseChaperone::ForceBoundsVisible(bool bForce)
 
 bool BaseChaperone::GetMinMaxPoints(vr::HmdVector3_t& minPoint, vr::HmdVector3_t& maxPoint)
 {
-	int count;
-	bool success = BackendManager::Instance().GetPlayAreaPoints(nullptr, &count);
+	const PlayAreaGeometry* playArea = BackendManager::Instance().GetPlayAreaGeometry();
 
-	if (!success)
+	if (!playArea)
 		return false; // the play area isn't set up, or is unsupported by the backend
 
-	std::vector<vr::HmdVector3_t> points(count);
-	success = BackendManager::Instance().GetPlayAreaPoints(points.data(), nullptr);
-
-	if (!success)
-		return false; // shouldn't happen - should be caught by first check
-
-	if (points.size() < 2)
+	if (playArea->points.size() < 2)
 		return false; // not enough points to find a min/max
 
-	minPoint = points[0];
-	maxPoint = points[0];
-
-	for (const auto& point : points) {
-		for (int i = 0; i < 3; i++) {
-			minPoint.v[i] = std::min(minPoint.v[i], point.v[i]);
-			maxPoint.v[i] = std::max(maxPoint.v[i], point.v[i]);
-		}
-	}
+	minPoint = playArea->minPoint;
+	maxPoint = playArea->maxPoint;
 
 	return true;
 }
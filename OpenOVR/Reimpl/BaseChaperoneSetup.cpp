@@ -3,6 +3,8 @@
 #define BASE_IMPL
 #include "BaseChaperoneSetup.h"
 
+#include "Drivers/Backend.h"
+#include "Misc/PlayAreaGeometry.h"
 #include "convert.h"
 
 #include <string>
@@ -31,31 +33,26 @@ bool BaseChaperoneSetup::GetWorkingCollisionBoundsInfo(VR_OUT_ARRAY_COUNT(punQua
 }
 bool BaseChaperoneSetup::GetLiveCollisionBoundsInfo(VR_OUT_ARRAY_COUNT(punQuadsCount) HmdQuad_t* pQuadsBuffer, uint32_t* punQuadsCount)
 {
-	using glm::vec3;
-
 	// TODO better find out what this method does
 
-	XrExtent2Df bounds;
-	XrResult result = xrGetReferenceSpaceBoundsRect(xr_session.get(), XR_REFERENCE_SPACE_TYPE_STAGE, &bounds);
+	const PlayAreaGeometry* playArea = BackendManager::Instance().GetPlayAreaGeometry();
 
-	if (result == XR_SPACE_BOUNDS_UNAVAILABLE) {
+	if (!playArea || playArea->points.size() < 2) {
 		return false; // TODO verify SteamVR returns this if Guardian isn't set up
 	}
 
-	OOVR_FAILED_XR_ABORT(result);
-
 	if (pQuadsBuffer) {
-		HmdVector3_t* corners = pQuadsBuffer->vCorners;
 		// TODO is this correct? Surely it's offset a bit? What happens when you recentre?
-		corners[0] = G2S_v3f(vec3(-bounds.width, 0, -bounds.height));
-		corners[1] = G2S_v3f(vec3(-bounds.width, 0, bounds.height));
-		corners[2] = G2S_v3f(vec3(bounds.width, 0, bounds.height));
-		corners[3] = G2S_v3f(vec3(bounds.width, 0, -bounds.height));
+		// This has always gone round the corners in this order, so keep it that way for apps that rely on it.
+		const HmdVector3_t& minPoint = playArea->minPoint;
+		const HmdVector3_t& maxPoint = playArea->maxPoint;
+		HmdVector3_t* corners = pQuadsBuffer->vCorners;
+		corners[0] = HmdVector3_t{ minPoint.v[0], 0, minPoint.v[2] };
+		corners[1] = HmdVector3_t{ minPoint.v[0], 0, maxPoint.v[2] };
+		corners[2] = HmdVector3_t{ maxPoint.v[0], 0, maxPoint.v[2] };
+		corners[3] = HmdVector3_t{ maxPoint.v[0], 0, minPoint.v[2] };
 	}
 
-	// string msg = to_string(status) + "," + to_string(pointsCount);
-	// OOVR_LOG(msg.c_str());
-
 	if (punQuadsCount)
 		*punQuadsCount = 1;
 
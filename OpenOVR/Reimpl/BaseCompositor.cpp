@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #define BASE_IMPL
 
+#include "Misc/CallProfiler.h"
 #include "Misc/Config.h"
 
 #include "convert.h"
@@ -70,6 +71,8 @@ ovr_enum_t BaseCompositor::WaitGetPoses(TrackedDevicePose_t* renderPoseArray, ui
 	leftEyeSubmitted = false;
 	rightEyeSubmitted = false;
 
+	CallProfiler::NewFrame();
+
 	BackendManager::Instance().WaitForTrackingData();
 
 	return GetLastPoses(renderPoseArray, renderPoseArrayCount, gamePoseArray, gamePoseArrayCount);
@@ -111,6 +114,9 @@ ovr_enum_t BaseCompositor::GetLastPoses(TrackedDevicePose_t* renderPoseArray, ui
 
 	ETrackingUniverseOrigin origin = GetTrackingSpace();
 
+	// Locate everything up-front, rather than once per device
+	BackendManager::Instance().PrepareDevicePoses(origin);
+
 	for (uint32_t i = 0; i < std::max(gamePoseArrayCount, renderPoseArrayCount); i++) {
 		TrackedDevicePose_t* renderPose = NULL;
 		TrackedDevicePose_t* gamePose = NULL;
@@ -165,10 +171,98 @@ ovr_enum_t BaseCompositor::GetLastPoseForTrackedDeviceIndex(TrackedDeviceIndex_t
 DX11Compositor* BaseCompositor::dxcomp;
 #endif
 
+// The app's graphics API, as found in the last texture passed to CreateCompositorAPI. SetOverlayRaw and
+// SetOverlayFromFile don't come with a texture, so this is what they use to create their compositors.
+static ETextureType rawUploadTextureType = TextureType_Invalid;
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+static ID3D11Device* rawUploadD3D11Device = nullptr;
+#endif
+#ifdef SUPPORT_VK
+static VRVulkanTextureData_t rawUploadVulkanData = {};
+#endif
+
+static void rememberRawUploadAPI(const vr::Texture_t* texture)
+{
+	rawUploadTextureType = texture->eType;
+
+	switch (texture->eType) {
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+	case TextureType_DirectX: {
+		if (oovr_global_configuration->DX10Mode()) {
+			rawUploadTextureType = TextureType_Invalid;
+			break;
+		}
+
+		ID3D11Device* device = nullptr;
+		((ID3D11Texture2D*)texture->handle)->GetDevice(&device);
+		if (rawUploadD3D11Device)
+			rawUploadD3D11Device->Release();
+		rawUploadD3D11Device = device;
+		break;
+	}
+#endif
+#ifdef SUPPORT_VK
+	case TextureType_Vulkan:
+		rawUploadVulkanData = *(const VRVulkanTextureData_t*)texture->handle;
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+bool BaseCompositor::SupportsRawUpload()
+{
+	// This must match the APIs CreateRawCompositorAPI handles
+	switch (rawUploadTextureType) {
+#if defined(SUPPORT_GL) || defined(SUPPORT_GLES)
+	case TextureType_OpenGL:
+		return true;
+#endif
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+	case TextureType_DirectX:
+		return true;
+#endif
+#ifdef SUPPORT_VK
+	case TextureType_Vulkan:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+Compositor* BaseCompositor::CreateRawCompositorAPI()
+{
+	switch (rawUploadTextureType) {
+#if defined(SUPPORT_GL)
+	case TextureType_OpenGL:
+		return new GLCompositor(0);
+#elif defined(SUPPORT_GLES)
+	case TextureType_OpenGL:
+		return new GLESCompositor();
+#endif
+#if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
+	case TextureType_DirectX:
+		return new DX11Compositor(rawUploadD3D11Device);
+#endif
+#ifdef SUPPORT_VK
+	case TextureType_Vulkan: {
+		Texture_t texture = { &rawUploadVulkanData, TextureType_Vulkan, ColorSpace_Auto };
+		return new VkCompositor(&texture);
+	}
+#endif
+	default:
+		return nullptr;
+	}
+}
+
 Compositor* BaseCompositor::CreateCompositorAPI(const vr::Texture_t* texture)
 {
 	Compositor* comp = nullptr;
 
+	rememberRawUploadAPI(texture);
+
 	switch (texture->eType) {
 #if defined(SUPPORT_GL)
 	case TextureType_OpenGL: {
@@ -185,7 +279,7 @@ Compositor* BaseCompositor::CreateCompositorAPI(const vr::Texture_t* texture)
 #endif
 #if defined(SUPPORT_DX) && defined(SUPPORT_DX11)
 	case TextureType_DirectX: {
-		if (!oovr_global_configuration.DX10Mode())
+		if (!oovr_global_configuration->DX10Mode())
 			comp = new DX11Compositor((ID3D11Texture2D*)texture->handle);
 
 #if defined(SUPPORT_DX10) && !defined(OC_XR_PORT)
@@ -476,22 +570,37 @@ void BaseCompositor::ReleaseMirrorTextureD3D11(void* pD3D11ShaderResourceView)
 
 ovr_enum_t BaseCompositor::GetMirrorTextureGL(EVREye eEye, glUInt_t* pglTextureId, glSharedTextureHandle_t* pglSharedTextureHandle)
 {
-	STUBBED();
+#if defined(SUPPORT_GL) || defined(SUPPORT_GLES)
+	uint64_t image = 0;
+	ovr_enum_t err = BackendManager::Instance().GetMirrorTexture(TextureType_OpenGL, eEye, &image);
+	if (err != VRCompositorError_None)
+		return err;
+
+	// The mirror is a texture in the app's own context, so there's nothing else to share
+	if (pglTextureId)
+		*pglTextureId = (glUInt_t)image;
+	if (pglSharedTextureHandle)
+		*pglSharedTextureHandle = (glSharedTextureHandle_t)(intptr_t)image;
+
+	return VRCompositorError_None;
+#else
+	OOVR_ABORT("Cannot get GL mirror texture - OpenGL support disabled");
+#endif
 }
 
 bool BaseCompositor::ReleaseSharedGLTexture(glUInt_t glTextureId, glSharedTextureHandle_t glSharedTextureHandle)
 {
-	STUBBED();
+	// The mirror texture belongs to the compositor, which deletes it itself
+	return true;
 }
 
 void BaseCompositor::LockGLSharedTextureForAccess(glSharedTextureHandle_t glSharedTextureHandle)
 {
-	STUBBED();
+	// Nothing to do - the mirror is only written by GL commands in the app's context, which are already ordered
 }
 
 void BaseCompositor::UnlockGLSharedTextureForAccess(glSharedTextureHandle_t glSharedTextureHandle)
 {
-	STUBBED();
 }
 
 uint32_t BaseCompositor::GetVulkanInstanceExtensionsRequired(char* pchValue, uint32_t unBufferSize)
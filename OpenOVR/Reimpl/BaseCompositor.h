@@ -131,6 +131,16 @@ public:
 	/** Creates API specific Compositor */
 	static Compositor* CreateCompositorAPI(const vr::Texture_t* texture);
 
+	/**
+	 * Creates a compositor for uploading images from system memory (see Compositor::InvokeRaw), for whichever
+	 * graphics API the app last passed a texture from. Returns nullptr if it hasn't passed one yet, or if
+	 * the API doesn't support this.
+	 */
+	static Compositor* CreateRawCompositorAPI();
+
+	// True if CreateRawCompositorAPI would succeed - that is, the app has passed a texture from an API that supports it
+	static bool SupportsRawUpload();
+
 #if defined(SUPPORT_DX) && defined(SUPPORT_DX11) && !defined(OC_XR_PORT)
 	// TODO clean this up, and make the keyboard work with OpenGL and Vulkan too
 	static DX11Compositor* dxcomp;
@@ -24,6 +24,7 @@
 #include <utility>
 
 #include "Misc/Config.h"
+#include "Misc/SkeletonCodec.h"
 #include "Misc/smooth_input.h"
 #include "Misc/xrmoreutils.h"
 
@@ -33,11 +34,12 @@
 using namespace vr;
 
 #include "../DrvOpenXR/XrBackend.h"
+#include "../DrvOpenXR/XrTracker.h"
 
 // On Android, the application must supply a function to load the contents of a file
 #include "Misc/android_api.h"
 
-SmoothInput BaseInput::smoothInput(oovr_global_configuration.InputWindowSize());
+SmoothInput BaseInput::smoothInput(oovr_global_configuration->InputWindowSize());
 
 /**
  * Macro for creating an Action object from a handle and verifying isn't invalid.
@@ -222,100 +224,132 @@ BaseInput::InputValueHandle::~InputValueHandle() = default;
 template <typename T>
 BaseInput::Registry<T>::~Registry() = default;
 template <typename T>
-BaseInput::Registry<T>::Registry(uint32_t _maxNameSize)
-    : maxNameSize(_maxNameSize) {}
+BaseInput::Registry<T>::Registry(uint32_t _maxNameSize, uint32_t _tag)
+    : tag(_tag), maxNameSize(_maxNameSize) {}
+
+static char foldCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+template <typename T>
+size_t BaseInput::Registry<T>::CaseFoldHash::operator()(const std::string& str) const
+{
+	// FNV-1a, which is plenty for a few thousand short strings
+	uint64_t hash = 0xcbf29ce484222325;
+	for (char c : str) {
+		hash ^= (uint8_t)foldCase(c);
+		hash *= 0x100000001b3;
+	}
+	return (size_t)hash;
+}
+
+template <typename T>
+bool BaseInput::Registry<T>::CaseFoldEqual::operator()(const std::string& a, const std::string& b) const
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (foldCase(a[i]) != foldCase(b[i]))
+			return false;
+	}
+	return true;
+}
+
+template <typename T>
+const typename BaseInput::Registry<T>::Slot* BaseInput::Registry<T>::GetSlot(RegHandle handle) const
+{
+	if ((uint32_t)(handle >> 32) != tag)
+		return nullptr;
+
+	uint32_t index = (uint32_t)handle - 1;
+	if (index >= slots.size())
+		return nullptr;
+
+	return &slots[index];
+}
+
+template <typename T>
+uint32_t BaseInput::Registry<T>::InternName(const std::string& name)
+{
+	auto iter = slotsByName.find(name);
+	if (iter != slotsByName.end())
+		return iter->second;
+
+	uint32_t index = (uint32_t)slots.size();
+	slots.emplace_back().name = name;
+	slotsByName[name] = index;
+	return index;
+}
 
 template <typename T>
 T* BaseInput::Registry<T>::LookupItem(const std::string& name) const
 {
-	auto iter = itemsByName.find(lowerStr(name));
-	if (iter == itemsByName.end())
+	auto iter = slotsByName.find(name);
+	if (iter == slotsByName.end())
 		return nullptr;
-	return iter->second;
+
+	const Slot& slot = slots[iter->second];
+	return slot.generation == generation ? slot.item : nullptr;
 }
 
 template <typename T>
 T* BaseInput::Registry<T>::LookupItem(RegHandle handle) const
 {
-	auto iter = itemsByHandle.find(handle);
-	if (iter == itemsByHandle.end())
+	const Slot* slot = GetSlot(handle);
+	if (!slot || slot->generation != generation)
 		return nullptr;
-	return iter->second;
+	return slot->item;
 }
 
 template <typename T>
 BaseInput::RegHandle BaseInput::Registry<T>::LookupHandle(const std::string& name)
 {
-	std::string lowerName = ShortenOrLookupName(name);
-	auto iter = handlesByName.find(lowerName);
-	if (iter != handlesByName.end())
-		return iter->second;
+	// Most names will have been seen before, in which case there's no need to lower or shorten them
+	auto iter = slotsByName.find(name);
+	uint32_t index = iter != slotsByName.end() ? iter->second : InternName(ShortenOrLookupName(name));
 
-	// Create a new dummy handle. It's only in the handlesByName map, so looking up the item
-	// for it will return nullptr.
-	RegHandle handle = 0xabcd0001 + handlesByName.size();
-	handlesByName[lowerName] = handle;
-	namesByHandle[handle] = name;
-	return handle;
+	// If there's no item for the name, this is a dummy handle - looking up the item for it will return nullptr.
+	return ((RegHandle)tag << 32) | (index + 1);
 }
 
 template <typename T>
 std::string BaseInput::Registry<T>::ShortenOrLookupName(const std::string& longName)
 {
 	std::string ret = lowerStr(longName);
-	if (ret.size() > maxNameSize - 1) {
-		auto iter = longNames.find(ret);
-		if (iter == longNames.end()) {
-			// new name - shorten and append "_ln" + unique number (ln for Long Name)
-			std::string fullName = ret;
-			std::string unique_id = "_ln" + std::to_string(longNames.size());
-			ret = ret.substr(0, maxNameSize - 1 - unique_id.size()) + unique_id;
-			longNames[fullName] = ret;
-			OOVR_LOGF("Shortened name %s to %s", fullName.c_str(), ret.c_str());
-		} else {
-			// name has already been shortened before - find the shortened version
-			auto iter2 = handlesByName.find(iter->second);
+	if (ret.size() <= maxNameSize - 1)
+		return ret;
 
-			// if it's in the longNames map, it has to be in the handlesByName map
-			// otherwise something probably went wrong
-			OOVR_FALSE_ABORT(iter2 != handlesByName.end());
+	// name has already been shortened before - find the shortened version
+	auto iter = longNames.find(ret);
+	if (iter != longNames.end())
+		return iter->second;
 
-			// return shortened name
-			return iter2->first;
-		}
-	}
-	return ret;
+	// new name - shorten and append "_ln" + unique number (ln for Long Name)
+	std::string unique_id = "_ln" + std::to_string(longNames.size());
+	std::string shortName = ret.substr(0, maxNameSize - 1 - unique_id.size()) + unique_id;
+	longNames[ret] = shortName;
+	OOVR_LOGF("Shortened name %s to %s", ret.c_str(), shortName.c_str());
+	return shortName;
 }
 
 template <typename T>
 T* BaseInput::Registry<T>::Initialise(const std::string& name, std::unique_ptr<T> value)
 {
-	std::string lowerName = lowerStr(name);
-	RegHandle handle = 0;
-
 	// apparently games CAN in fact grab handles before initialization - Kayak VR does this
-	// grab already created handle if it exists
-	if (handlesByName.count(lowerName) != 0) {
-		// since we only generate dummy handles before initialization, make sure we only have dummy handles
-		// dummy handles have no associated items
-		handle = handlesByName.find(lowerName)->second;
-		OOVR_FALSE_ABORT(itemsByHandle.find(handle) == itemsByHandle.end());
-	}
+	// in that case they get the handle they already have, and it now points to this item
+	Slot& slot = slots[InternName(lowerStr(name))];
+
+	// since we only generate dummy handles before initialization, make sure we only have dummy handles
+	// dummy handles have no associated items
+	OOVR_FALSE_ABORT(!slot.item || slot.generation != generation);
 
 	// Move the pointer into storage, so we'll own it
 	T* ptr = value.get();
 	storage.emplace_back(std::move(value));
 
-	// Use pointer as handle, for ease of debugging only
-	// Since our values live as long as the registry, it's guaranteed their addresses won't repeat
-	if (!handle) {
-		handle = (RegHandle)ptr;
-		handlesByName[lowerName] = handle;
-		namesByHandle[handle] = lowerName;
-	}
-
-	itemsByName[lowerName] = ptr;
-	itemsByHandle[handle] = ptr;
+	slot.item = ptr;
+	slot.generation = generation;
 
 	// Convenience return
 	return ptr;
@@ -324,19 +358,20 @@ T* BaseInput::Registry<T>::Initialise(const std::string& name, std::unique_ptr<T
 template <typename T>
 void BaseInput::Registry<T>::Reset()
 {
-	// We want to preserve handlesByName and namesByHandle, because handles are supposed to always be accessible
-	// from the same values regardless of if said handles are actually currently valid
+	// We want to preserve the slots, because handles are supposed to always be accessible from the same values
+	// regardless of if said handles are actually currently valid
 	// In the case of NomaiVR, it will set an action manifest, get all the action handles, and then set another (identical) manifest
-	// We can clear the actual item storage though, since these will no longer be valid
-	itemsByHandle.clear();
-	itemsByName.clear();
+	// We can clear the actual item storage though, since these will no longer be valid - the slots still point
+	// to them, but they're from an old generation so they'll never be used.
 	storage.clear();
+	generation++;
 }
 
 // ---
 
 BaseInput::BaseInput()
-    : actionSets(XR_MAX_ACTION_SET_NAME_SIZE), actions(XR_MAX_ACTION_NAME_SIZE)
+    : actionSets(XR_MAX_ACTION_SET_NAME_SIZE, 0xabcd0001), actions(XR_MAX_ACTION_NAME_SIZE, 0xabcd0002),
+      inputValueHandles(UINT32_MAX, 0xabcd0003)
 {
 	// Initialise the subaction path constants
 	for (const std::string& str : allSubactionPathNames) {
@@ -700,6 +735,9 @@ void BaseInput::BindInputsForSession()
 		action->actionSpaces.clear();
 	}
 
+	// And whatever the actions were bound to in the old session doesn't apply any more
+	bindingsSerial++;
+
 	// Same goes for the actionspaces of the legacy controller pose actions, this time create
 	// new ones for this session.
 	for (LegacyControllerActions& lca : legacyControllers) {
@@ -716,6 +754,19 @@ void BaseInput::BindInputsForSession()
 		OOVR_FAILED_XR_ABORT(xrCreateActionSpace(xr_session.get(), &info, &lca.aimPoseSpace));
 	}
 
+	// And again for the trackers
+	trackerSpaces.clear();
+	for (XrPath rolePath : trackerRolePaths) {
+		XrActionSpaceCreateInfo info = { XR_TYPE_ACTION_SPACE_CREATE_INFO };
+		info.poseInActionSpace = S2O_om34_pose(G2S_m34(glm::identity<glm::mat4>()));
+		info.action = trackerPoseAction;
+		info.subactionPath = rolePath;
+
+		XrSpace space = XR_NULL_HANDLE;
+		OOVR_FAILED_XR_ABORT(xrCreateActionSpace(xr_session.get(), &info, &space));
+		trackerSpaces.push_back(space);
+	}
+
 	// Note: even if actionSets is empty, we always still want to load the legacy set.
 
 	// Now attach the action sets to the OpenXR session, making them immutable (including attaching suggested bindings)
@@ -1070,6 +1121,40 @@ void BaseInput::CreateLegacyActions()
 		create(&ctrl.gripPoseAction, "grip-pose", "Grip Pose", XR_ACTION_TYPE_POSE_INPUT);
 		create(&ctrl.aimPoseAction, "aim-pose", "Aim Pose", XR_ACTION_TYPE_POSE_INPUT);
 	}
+
+	// Body trackers get a single pose action, with one subaction path per role
+	trackerPoseAction = XR_NULL_HANDLE;
+	trackerRolePaths.clear();
+	if (xr_ext->ViveTrackers_Available()) {
+		for (int role = 0; role < XrTracker::ROLE_COUNT; role++) {
+			XrPath path;
+			OOVR_FAILED_XR_ABORT(xrStringToPath(xr_instance, XrTracker::GetRolePath(role).c_str(), &path));
+			trackerRolePaths.push_back(path);
+		}
+
+		XrActionCreateInfo info = { XR_TYPE_ACTION_CREATE_INFO };
+		info.actionType = XR_ACTION_TYPE_POSE_INPUT;
+		strcpy_arr(info.actionName, "tracker-pose");
+		strcpy_arr(info.localizedActionName, "Tracker Pose");
+		info.countSubactionPaths = trackerRolePaths.size();
+		info.subactionPaths = trackerRolePaths.data();
+		OOVR_FAILED_XR_ABORT(xrCreateAction(legacyInputsSet, &info, &trackerPoseAction));
+
+		// Trackers have their own interaction profile, which the app's bindings won't ever mention
+		std::vector<XrActionSuggestedBinding> bindings;
+		for (int role = 0; role < XrTracker::ROLE_COUNT; role++) {
+			XrPath path;
+			std::string pathStr = XrTracker::GetRolePath(role) + "/input/grip/pose";
+			OOVR_FAILED_XR_ABORT(xrStringToPath(xr_instance, pathStr.c_str(), &path));
+			bindings.push_back({ trackerPoseAction, path });
+		}
+
+		XrInteractionProfileSuggestedBinding suggestedBindings{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
+		OOVR_FAILED_XR_ABORT(xrStringToPath(xr_instance, "/interaction_profiles/htc/vive_tracker_htcx", &suggestedBindings.interactionProfile));
+		suggestedBindings.suggestedBindings = bindings.data();
+		suggestedBindings.countSuggestedBindings = bindings.size();
+		OOVR_FAILED_XR_ABORT(xrSuggestInteractionProfileBindings(xr_instance, &suggestedBindings));
+	}
 }
 
 EVRInputError BaseInput::GetActionSetHandle(const char* pchActionSetName, VRActionSetHandle_t* pHandle)
@@ -1089,15 +1174,11 @@ EVRInputError BaseInput::GetInputSourceHandle(const char* pchInputSourcePath, VR
 	// Get the existing InputValueHandle if it already exists, or make a new one otherwise. Applications can
 	// get whatever handles they want, regardless of whether the runtime associates any special meaning with it.
 
-	const auto iter = inputHandleRegistry.find(pchInputSourcePath);
-	if (iter != inputHandleRegistry.end()) {
-		InputValueHandle* handle = iter->second.get();
-		*pHandle = (uint64_t)handle;
+	*pHandle = inputValueHandles.LookupHandle(pchInputSourcePath);
+	if (inputValueHandles.LookupItem(*pHandle))
 		return VRInputError_None;
-	}
 
 	std::unique_ptr<InputValueHandle> handle = std::make_unique<InputValueHandle>();
-	InputValueHandle* ptr = handle.get();
 	handle->path = pchInputSourcePath;
 
 	// Yes, this will let through something like/user/hand/leftblah but it's probably not an issue
@@ -1119,8 +1200,7 @@ EVRInputError BaseInput::GetInputSourceHandle(const char* pchInputSourcePath, VR
 		OOVR_FALSE_ABORT(std::count(allSubactionPaths.begin(), allSubactionPaths.end(), handle->devicePath));
 	}
 
-	inputHandleRegistry[pchInputSourcePath] = std::move(handle);
-	*(uint64_t*)pHandle = (uint64_t)ptr;
+	inputValueHandles.Initialise(pchInputSourcePath, std::move(handle));
 	return VRInputError_None;
 }
 
@@ -1294,6 +1374,10 @@ EVRInputError BaseInput::GetDigitalActionData(VRActionHandle_t action, InputDigi
 		if (!checkRestrictToDevice(ulRestrictToDevice, subactionPath))
 			continue;
 
+		// Like SteamVR does while the dashboard has the controllers, show the action as inactive
+		if (IsSubactionBlocked(subactionPath))
+			continue;
+
 		getInfo.subactionPath = subactionPath;
 		XrActionStateBoolean state = { XR_TYPE_ACTION_STATE_BOOLEAN };
 		OOVR_FAILED_XR_ABORT(getBooleanOrDpadData(*act, &getInfo, &state));
@@ -1336,6 +1420,8 @@ EVRInputError BaseInput::GetAnalogActionData(VRActionHandle_t action, InputAnalo
 		XrPath subactionPath = allSubactionPaths[i];
 		if (!checkRestrictToDevice(ulRestrictToDevice, subactionPath))
 			continue;
+		if (IsSubactionBlocked(subactionPath))
+			continue;
 
 		getInfo.subactionPath = subactionPath;
 
@@ -1349,7 +1435,7 @@ EVRInputError BaseInput::GetAnalogActionData(VRActionHandle_t action, InputAnalo
 				continue;
 			lengthSq = maxLengthSq;
 
-			bool inputSmoothingEnabled = oovr_global_configuration.EnableInputSmoothing();
+			bool inputSmoothingEnabled = oovr_global_configuration->EnableInputSmoothing();
 
 			if (inputSmoothingEnabled) {
 				smoothInput.updateTriggerValue(i, state.currentState);
@@ -1376,9 +1462,9 @@ EVRInputError BaseInput::GetAnalogActionData(VRActionHandle_t action, InputAnalo
 
 			float deadZoneSize = 0.0f;
 			if (i == 0) {
-				deadZoneSize = std::abs(oovr_global_configuration.LeftDeadZoneSize());
+				deadZoneSize = std::abs(oovr_global_configuration->LeftDeadZoneSize());
 			} else if (i == 1) {
-				deadZoneSize = std::abs(oovr_global_configuration.RightDeadZoneSize());
+				deadZoneSize = std::abs(oovr_global_configuration->RightDeadZoneSize());
 			}
 
 			if (std::abs(state.currentState.x) <= deadZoneSize) {
@@ -1454,8 +1540,11 @@ EVRInputError BaseInput::GetPoseActionData(VRActionHandle_t action, ETrackingUni
 		OOVR_ABORTF("Invalid action type %d for action %s", act->type, act->fullName.c_str());
 
 	const InputValueHandle* restrictToDevice = nullptr;
-	if (ulRestrictToDevice)
+	if (ulRestrictToDevice) {
 		restrictToDevice = cast_IVH(ulRestrictToDevice);
+		if (!restrictToDevice)
+			return vr::VRInputError_InvalidDevice;
+	}
 
 	for (int handNum = 0; handNum < 2; handNum++) {
 		// Check this hand is permitted
@@ -1633,8 +1722,22 @@ EVRInputError BaseInput::GetBoneName(VRActionHandle_t action, BoneIndex_t nBoneI
 }
 EVRInputError BaseInput::GetSkeletalReferenceTransforms(VRActionHandle_t action, EVRSkeletalTransformSpace eTransformSpace, EVRSkeletalReferencePose eReferencePose, VR_ARRAY_COUNT(unTransformArrayCount) VRBoneTransform_t* pTransformArray, uint32_t unTransformArrayCount)
 {
-	OOVR_SOFT_ABORT("Skeletal reference transforms not implemented");
-	return vr::VRInputError_InvalidSkeleton;
+	GET_ACTION_FROM_HANDLE(act, action);
+
+	OOVR_FALSE_ABORT(unTransformArrayCount == eBone_Count);
+
+	if (act->skeletalHand == ITrackedDevice::HAND_NONE) {
+		return vr::VRInputError_InvalidSkeleton;
+	}
+
+	// These are the same poses used to estimate the skeleton when hand-tracking isn't available
+	const VRBoneTransform_t* bones = GetReferenceBones(act->skeletalHand == ITrackedDevice::HAND_RIGHT, eReferencePose, eTransformSpace);
+	if (bones == nullptr) {
+		return vr::VRInputError_InvalidParam;
+	}
+
+	memcpy(pTransformArray, bones, sizeof(VRBoneTransform_t) * eBone_Count);
+	return vr::VRInputError_None;
 }
 EVRInputError BaseInput::GetSkeletalTrackingLevel(VRActionHandle_t action, EVRSkeletalTrackingLevel* pSkeletalTrackingLevel)
 {
@@ -1679,38 +1782,37 @@ EVRInputError BaseInput::GetSkeletalBoneData(VRActionHandle_t actionHandle, EVRS
 		return vr::VRInputError_None;
 	}
 
-	// If the runtime doesn't support hand-tracking, leave the data zeroed out. We should eventually
-	// make our own data in this case.
-	if (!xr_gbl->handTrackingProperties.supportsHandTracking) {
-		OOVR_SOFT_ABORT("Runtime does not support hand-tracking, skeletal data unavailable");
-		return vr::VRInputError_None;
+	if (action->skeletalHand == ITrackedDevice::HAND_NONE) {
+		return vr::VRInputError_InvalidSkeleton;
 	}
 
-	XrHandJointsLocateInfoEXT locateInfo = { XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT };
-	locateInfo.baseSpace = legacyControllers[(int)action->skeletalHand].aimPoseSpace;
-	locateInfo.time = xr_gbl->GetBestTime();
+	HandSkeleton& skeleton = handSkeletons[action->skeletalHand];
+	int range = eMotionRange == vr::VRSkeletalMotionRange_WithoutController ? 1 : 0;
+	bool isRight = (action->skeletalHand == ITrackedDevice::HAND_RIGHT);
 
-	XrHandJointLocationsEXT locations = { XR_TYPE_HAND_JOINT_LOCATIONS_EXT };
-	locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
-	std::vector<XrHandJointLocationEXT> jointLocations(locations.jointCount);
-	locations.jointLocations = jointLocations.data();
+	if (xr_gbl->handTrackingProperties.supportsHandTracking) {
+		LocateHandJoints(action->skeletalHand);
 
-	OOVR_FAILED_XR_ABORT(xr_ext->xrLocateHandJointsEXT(handTrackers[(int)action->skeletalHand], &locateInfo, &locations));
+		if (!skeleton.active) {
+			// Leave empty-handed, IDK if this is the right error or not
+			return vr::VRInputError_InvalidSkeleton;
+		}
 
-	if (!locations.isActive) {
-		// Leave empty-handed, IDK if this is the right error or not
-		return vr::VRInputError_InvalidSkeleton;
+		// TODO eMotionRange, if that's even possible - for now both ranges produce the same bones
+		if (skeleton.bonesSerial[range] != syncSerial) {
+			ConvertHandBones(skeleton, isRight, skeleton.bones[range][VRSkeletalTransformSpace_Model], skeleton.bones[range][VRSkeletalTransformSpace_Parent]);
+			skeleton.bonesSerial[range] = syncSerial;
+		}
+	} else if (skeleton.bonesSerial[range] != syncSerial) {
+		// Without hand-tracking, make up a skeleton from the controller's inputs
+		bool withController = range == 0;
+		EstimateHandBones(action->skeletalHand, withController, skeleton.bones[range][VRSkeletalTransformSpace_Model], skeleton.bones[range][VRSkeletalTransformSpace_Parent]);
+		skeleton.bonesSerial[range] = syncSerial;
 	}
 
-	bool isRight = (action->skeletalHand == ITrackedDevice::HAND_RIGHT);
+	int space = eTransformSpace == VRSkeletalTransformSpace_Model ? VRSkeletalTransformSpace_Model : VRSkeletalTransformSpace_Parent;
+	memcpy(pTransformArray, skeleton.bones[range][space], sizeof(VRBoneTransform_t) * eBone_Count);
 
-	if (eTransformSpace == VRSkeletalTransformSpace_Model) {
-		ConvertHandModelSpace(jointLocations, isRight, pTransformArray);
-	} else {
-		ConvertHandParentSpace(jointLocations, isRight, pTransformArray);
-	}
-
-	// For now, just return with non-active data
 	return vr::VRInputError_None;
 }
 EVRInputError BaseInput::GetSkeletalSummaryData(VRActionHandle_t actionHandle, EVRSummaryType eSummaryType, VRSkeletalSummaryData_t* pSkeletalSummaryData)
@@ -1728,22 +1830,15 @@ EVRInputError BaseInput::GetSkeletalSummaryData(VRActionHandle_t actionHandle, E
 
 EVRInputError BaseInput::getRealSkeletalSummary(ITrackedDevice::HandType hand, VRSkeletalSummaryData_t* pSkeletalSummaryData)
 {
-	XrHandJointsLocateInfoEXT locateInfo = { XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT };
-	locateInfo.baseSpace = legacyControllers[hand].aimPoseSpace;
-	locateInfo.time = xr_gbl->GetBestTime();
-
-	XrHandJointLocationsEXT locations = { XR_TYPE_HAND_JOINT_LOCATIONS_EXT };
-	locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
-	std::vector<XrHandJointLocationEXT> jointLocations(locations.jointCount);
-	locations.jointLocations = jointLocations.data();
-
-	OOVR_FAILED_XR_ABORT(xr_ext->xrLocateHandJointsEXT(handTrackers[hand], &locateInfo, &locations));
+	const HandSkeleton& skeleton = LocateHandJoints(hand);
 
-	if (!locations.isActive) {
+	if (!skeleton.active) {
 		// Leave empty-handed, IDK if this is the right error or not
 		return vr::VRInputError_InvalidSkeleton;
 	}
 
+	const XrHandJointLocationEXT* jointLocations = skeleton.joints;
+
 	for (int i = 0; i < 5; ++i) {
 		XrHandJointLocationEXT metacarpal, proximal, tip;
 
@@ -1853,24 +1948,84 @@ EVRInputError BaseInput::GetSkeletalBoneDataCompressed(VRActionHandle_t action,
     EVRSkeletalMotionRange eMotionRange, VR_OUT_BUFFER_COUNT(unCompressedSize) void* pvCompressedData, uint32_t unCompressedSize,
     uint32_t* punRequiredCompressedSize, VRInputValueHandle_t ulRestrictToDevice)
 {
-	STUBBED();
+	// Same as GetSkeletalBoneData, ignore the old device restriction
+	if (ulRestrictToDevice != vr::k_ulInvalidInputValueHandle) {
+		OOVR_SOFT_ABORT("Old skeletal input device restrictions not supported");
+	}
+
+	GET_ACTION_FROM_HANDLE(act, action);
+
+	// The bones are always compressed in parent space, which the codec relies on to get them small. The
+	// requested space is only stored so the old DecompressSkeletalBoneData can report it.
+	VRBoneTransform_t bones[skeleton_codec::BONE_COUNT];
+	EVRInputError err = GetSkeletalBoneData(action, VRSkeletalTransformSpace_Parent, eMotionRange, bones, skeleton_codec::BONE_COUNT);
+	if (err != vr::VRInputError_None)
+		return err;
+
+	bool isRight = act && act->skeletalHand == ITrackedDevice::HAND_RIGHT;
+	bool modelSpace = eTransformSpace == VRSkeletalTransformSpace_Model;
+
+	uint8_t encoded[skeleton_codec::MAX_ENCODED_SIZE];
+	uint32_t size = skeleton_codec::Encode(bones, isRight, modelSpace, encoded);
+
+	if (punRequiredCompressedSize)
+		*punRequiredCompressedSize = size;
+
+	if (pvCompressedData == nullptr || unCompressedSize < size)
+		return vr::VRInputError_BufferTooSmall;
+
+	memcpy(pvCompressedData, encoded, size);
+	return vr::VRInputError_None;
 }
 EVRInputError BaseInput::GetSkeletalBoneDataCompressed(VRActionHandle_t action, EVRSkeletalMotionRange eMotionRange,
     VR_OUT_BUFFER_COUNT(unCompressedSize) void* pvCompressedData, uint32_t unCompressedSize, uint32_t* punRequiredCompressedSize)
 {
-	STUBBED();
+	return GetSkeletalBoneDataCompressed(action, VRSkeletalTransformSpace_Parent, eMotionRange, pvCompressedData, unCompressedSize,
+	    punRequiredCompressedSize, vr::k_ulInvalidInputValueHandle);
+}
+static EVRInputError decompressSkeletalBones(const void* buffer, uint32_t bufferSize, EVRSkeletalTransformSpace* space,
+    VRBoneTransform_t* transforms, uint32_t transformCount)
+{
+	if (transformCount != skeleton_codec::BONE_COUNT)
+		return vr::VRInputError_InvalidBoneCount;
+
+	if (buffer == nullptr || transforms == nullptr)
+		return vr::VRInputError_InvalidParam;
+
+	VRBoneTransform_t parentSpace[skeleton_codec::BONE_COUNT];
+	bool modelSpace = false;
+	if (!skeleton_codec::Decode(buffer, bufferSize, parentSpace, &modelSpace))
+		return vr::VRInputError_InvalidCompressedData;
+
+	// If the caller didn't pick a space, use the one the data was originally requested in
+	if (*space == (EVRSkeletalTransformSpace)-1)
+		*space = modelSpace ? VRSkeletalTransformSpace_Model : VRSkeletalTransformSpace_Parent;
+
+	if (*space == VRSkeletalTransformSpace_Model) {
+		skeleton_codec::ParentToModelSpace(parentSpace, transforms);
+	} else {
+		memcpy(transforms, parentSpace, sizeof(parentSpace));
+	}
+
+	return vr::VRInputError_None;
 }
 EVRInputError BaseInput::DecompressSkeletalBoneData(void* pvCompressedBuffer, uint32_t unCompressedBufferSize,
     EVRSkeletalTransformSpace* peTransformSpace, VR_ARRAY_COUNT(unTransformArrayCount) VRBoneTransform_t* pTransformArray,
     uint32_t unTransformArrayCount)
 {
+	// The old version returns the space the data was requested in, rather than letting the caller choose
+	EVRSkeletalTransformSpace space = (EVRSkeletalTransformSpace)-1;
+	EVRInputError err = decompressSkeletalBones(pvCompressedBuffer, unCompressedBufferSize, &space, pTransformArray, unTransformArrayCount);
 
-	STUBBED();
+	if (err == vr::VRInputError_None && peTransformSpace)
+		*peTransformSpace = space;
+
+	return err;
 }
 EVRInputError BaseInput::DecompressSkeletalBoneData(const void* pvCompressedBuffer, uint32_t unCompressedBufferSize, EVRSkeletalTransformSpace eTransformSpace,
     VR_ARRAY_COUNT(unTransformArrayCount) VRBoneTransform_t* pTransformArray, uint32_t unTransformArrayCount)
 {
-	STUBBED();
+	return decompressSkeletalBones(pvCompressedBuffer, unCompressedBufferSize, &eTransformSpace, pTransformArray, unTransformArrayCount);
 }
 
 EVRInputError BaseInput::TriggerHapticVibrationAction(VRActionHandle_t action, float fStartSecondsFromNow, float fDurationSeconds,
@@ -1927,34 +2082,15 @@ EVRInputError BaseInput::GetActionOrigins(VRActionSetHandle_t actionSetHandle, V
 
 	ZeroMemory(originsOut, originOutCount * sizeof(*originsOut));
 
-	std::set<std::string> sources;
-	XrBoundSourcesForActionEnumerateInfo info = { XR_TYPE_BOUND_SOURCES_FOR_ACTION_ENUMERATE_INFO };
-	info.action = act->xr;
-
-	// 20 will be more than enough, saves a second call
-	XrPath tmp[20];
-	uint32_t count;
-	OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &info, std::size(tmp), &count, tmp));
-
-	// Now for each source find the /user/hand/abc substring that it starts with
-	char buff[XR_MAX_PATH_LENGTH + 1];
-	for (int i = 0; i < count; i++) {
-		uint32_t len;
-		OOVR_FAILED_XR_ABORT(xrPathToString(xr_instance, tmp[i], XR_MAX_PATH_LENGTH, &len, buff));
-
-		std::string path(buff, len);
-		int endOfHandPos = path.find('/', strlen("/user/hand/") + 1);
-		path.erase(endOfHandPos);
-		sources.insert(std::move(path));
-	}
+	// The origins are the devices (eg /user/hand/left) the action is bound to
+	updateBoundSources(act);
 
 	// Copy out the sources
-	int i = 0;
-	for (const std::string& path : sources) {
+	uint32_t i = 0;
+	for (VRInputValueHandle_t origin : act->deviceOrigins) {
 		if (i >= originOutCount)
 			return vr::VRInputError_MaxCapacityReached; // TODO check this is correct
-		OOVR_FALSE_ABORT(GetInputSourceHandle(path.c_str(), &originsOut[i]) == vr::VRInputError_None);
-		i++;
+		originsOut[i++] = origin;
 	}
 
 	return VRInputError_None;
@@ -2050,64 +2186,40 @@ EVRInputError BaseInput::GetActionBindingInfo(VRActionHandle_t actionHandle, OOV
 
 	OOVR_FALSE_ABORT(unBindingInfoSize == sizeof(OOVR_InputBindingInfo_t));
 
-	// FIXME support any number of sources
 	// TODO does this support passing in unBindingInfoSize=0 and reading the required size? Check with SteamVR.
 	GET_ACTION_FROM_HANDLE(action, actionHandle);
 
-	XrBoundSourcesForActionEnumerateInfo enumInfo = { XR_TYPE_BOUND_SOURCES_FOR_ACTION_ENUMERATE_INFO };
-	enumInfo.action = action->xr;
-	uint32_t sourcesCount;
-	OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &enumInfo, 0, &sourcesCount, nullptr));
-	std::vector<XrPath> boundActionPaths(sourcesCount);
-	OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &enumInfo, boundActionPaths.size(), &sourcesCount, boundActionPaths.data()));
+	updateBoundSources(action);
 
 	// TODO should we return an error if there are no sources bound?
 
-	int count = boundActionPaths.size();
-	if (count > unBindingInfoCount)
-		count = unBindingInfoCount;
+	uint32_t count = std::min((uint32_t)action->boundSources.size(), unBindingInfoCount);
 	if (punReturnedBindingInfoCount)
 		*punReturnedBindingInfoCount = count;
 
-	for (int i = 0; i < count; i++) {
+	for (uint32_t i = 0; i < count; i++) {
 		OOVR_InputBindingInfo_t& info = bindingInfo[i];
-		XrPath path = boundActionPaths.at(i);
-
-		uint32_t pathLen;
-		OOVR_FAILED_XR_ABORT(xrPathToString(xr_instance, path, 0, &pathLen, nullptr));
-		std::vector<char> chars(pathLen);
-		OOVR_FAILED_XR_ABORT(xrPathToString(xr_instance, path, chars.size(), &pathLen, chars.data()));
-		std::string pathStr(chars.data(), chars.size());
-
-		std::vector<std::string> parts;
-		stringSplit(pathStr, parts);
+		const BoundSource& source = action->boundSources[i];
 
-		// The last part of the string - which is something like '/user/hand/right/input/a/click' - is the mode
-		strcpy_arr(info.rchModeName, parts.back().c_str());
-
-		// Hardcode the first three parts of the string as being the device path, and the 4th and 5th ones as
-		// being the input path.
-		std::string devicePath = pathFromParts({ parts.at(0), parts.at(1), parts.at(2) });
-		std::string inputPath = pathFromParts({ parts.at(3), parts.at(4) });
-		strcpy_arr(info.rchDevicePathName, devicePath.c_str());
-		strcpy_arr(info.rchInputPathName, inputPath.c_str());
+		strcpy_arr(info.rchDevicePathName, source.devicePath.c_str());
+		strcpy_arr(info.rchInputPathName, source.inputPath.c_str());
 
 		// FIXME replace this initial hacky thing
 		switch (action->type) {
 		case ActionType::Boolean:
-			strcpy_arr(bindingInfo->rchModeName, "button");
-			strcpy_arr(bindingInfo->rchInputSourceType, "button");
+			strcpy_arr(info.rchModeName, "button");
+			strcpy_arr(info.rchInputSourceType, "button");
 			break;
 		case ActionType::Vector1:
-			strcpy_arr(bindingInfo->rchModeName, "trigger");
-			strcpy_arr(bindingInfo->rchInputSourceType, "trigger");
+			strcpy_arr(info.rchModeName, "trigger");
+			strcpy_arr(info.rchInputSourceType, "trigger");
 			break;
 		case ActionType::Vector2:
-			strcpy_arr(bindingInfo->rchModeName, "joystick");
-			strcpy_arr(bindingInfo->rchInputSourceType, "joystick");
+			strcpy_arr(info.rchModeName, "joystick");
+			strcpy_arr(info.rchInputSourceType, "joystick");
 			break;
 		default:
-			OOVR_ABORTF("Unimplemented action type %d for %s", action->type, pathStr.c_str());
+			OOVR_ABORTF("Unimplemented action type %d for %s", action->type, source.name.c_str());
 		}
 	}
 
@@ -2172,12 +2284,17 @@ BaseInput::InputValueHandle* BaseInput::cast_IVH(VRInputValueHandle_t handle)
 	if (handle == vr::k_ulInvalidInputValueHandle)
 		OOVR_ABORT("Called ivhToDev for invalid input value handle");
 
-	return (InputValueHandle*)handle;
+	InputValueHandle* ivh = inputValueHandles.LookupItem((RegHandle)handle);
+	if (!ivh)
+		OOVR_LOG_ONCEF("WARNING: Invalid input value handle %llx passed!", (unsigned long long)handle);
+	return ivh;
 }
 
 ITrackedDevice* BaseInput::ivhToDev(VRInputValueHandle_t handle)
 {
 	const InputValueHandle* ivh = cast_IVH(handle);
+	if (!ivh)
+		return nullptr;
 
 	ITrackedDevice::HandType hand = ITrackedDevice::HAND_NONE;
 	switch (ivh->type) {
@@ -2200,8 +2317,9 @@ bool BaseInput::checkRestrictToDevice(vr::VRInputValueHandle_t restrictToDevice,
 	if (restrictToDevice == vr::k_ulInvalidInputValueHandle)
 		return true;
 
+	// An unknown device doesn't match anything
 	const InputValueHandle* ivh = cast_IVH(restrictToDevice);
-	return subactionPath == ivh->devicePath;
+	return ivh && subactionPath == ivh->devicePath;
 }
 
 VRInputValueHandle_t BaseInput::activeOriginFromSubaction(Action* action, const char* subactionPath)
@@ -2210,37 +2328,13 @@ VRInputValueHandle_t BaseInput::activeOriginFromSubaction(Action* action, const
 	//  have to return a path listed in the input profile, they can be literally anything (not even a /user/hand/<side>
 	//  prefix is guaranteed). Thus we'll need some sophisticated lying to the application about this.
 
-	// If it's time for an update and this isn't a virtual input, update its sources
-	if (syncSerial >= action->nextSourcesUpdate && action->xr) {
-		// Get the attached sources
-		XrBoundSourcesForActionEnumerateInfo enumInfo = { XR_TYPE_BOUND_SOURCES_FOR_ACTION_ENUMERATE_INFO };
-		enumInfo.action = action->xr;
-		OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &enumInfo,
-		    std::size(action->sources), &action->sourcesCount, action->sources));
-
-		// Convert the source paths to strings
-		char buff[256];
-		for (int i = 0; i < (int)action->sourcesCount; i++) {
-			ZeroMemory(buff, sizeof(buff));
-			uint32_t length;
-			OOVR_FAILED_XR_ABORT(xrPathToString(xr_instance, action->sources[i], sizeof(buff) - 1, &length, buff));
-			action->sourceNames[i] = buff;
-		}
-
-		// Wait 200 updates. This obviously depends on the framerate but probably only changes if a device is
-		// disconnected or reconnected. It's unlikely it'll be an issue, but just in case randomise the timer
-		// to prevent a thundering herd problem.
-		action->nextSourcesUpdate = syncSerial + 200 + ((int)std::rand() % 100); // NOLINT(cert-msc50-cpp)
-	}
+	updateBoundSources(action);
 
 	// Go through the input sources and find the first one that starts with the subaction path
-	for (int i = 0; i < (int)action->sourcesCount; i++) {
-		const std::string& str = action->sourceNames[i];
-		if (strncmp(str.c_str(), subactionPath, strlen(subactionPath)) == 0) {
-			VRInputValueHandle_t handle;
-			OOVR_FALSE_ABORT(GetInputSourceHandle(str.c_str(), &handle) == vr::VRInputError_None);
-			return handle;
-		}
+	size_t subactionPathLen = strlen(subactionPath);
+	for (const BoundSource& source : action->boundSources) {
+		if (strncmp(source.name.c_str(), subactionPath, subactionPathLen) == 0)
+			return source.origin;
 	}
 
 	// Couldn't find one? Just use the subaction path as the device itself. Kinda ugly but it's unlikely to cause
@@ -2252,7 +2346,93 @@ VRInputValueHandle_t BaseInput::activeOriginFromSubaction(Action* action, const
 	return handle;
 }
 
+void BaseInput::updateBoundSources(Action* action)
+{
+	// Virtual inputs don't have any sources of their own
+	if (!action->xr)
+		return;
+
+	if (action->boundSourcesSerial == bindingsSerial) {
+		// Some runtimes don't bind anything until the controllers have been used, and don't reliably tell us when
+		// they do. So while there aren't any sources, check again now and then.
+		if (!action->boundSources.empty() || syncSerial < action->nextSourcesUpdate)
+			return;
+	}
+
+	action->boundSourcesSerial = bindingsSerial;
+	action->boundSources.clear();
+	action->deviceOrigins.clear();
+
+	// Wait 200 updates. This obviously depends on the framerate, but it's only a fallback. It's unlikely it'll be
+	// an issue, but just in case randomise the timer to prevent a thundering herd problem.
+	action->nextSourcesUpdate = syncSerial + 200 + ((int)std::rand() % 100); // NOLINT(cert-msc50-cpp)
+
+	XrBoundSourcesForActionEnumerateInfo enumInfo = { XR_TYPE_BOUND_SOURCES_FOR_ACTION_ENUMERATE_INFO };
+	enumInfo.action = action->xr;
+	uint32_t sourcesCount;
+	OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &enumInfo, 0, &sourcesCount, nullptr));
+	std::vector<XrPath> paths(sourcesCount);
+	OOVR_FAILED_XR_ABORT(xrEnumerateBoundSourcesForAction(xr_session.get(), &enumInfo, paths.size(), &sourcesCount, paths.data()));
+	paths.resize(sourcesCount);
+
+	std::vector<std::string> parts;
+	for (XrPath path : paths) {
+		BoundSource source;
+		source.path = path;
+
+		char buff[XR_MAX_PATH_LENGTH + 1];
+		uint32_t len;
+		OOVR_FAILED_XR_ABORT(xrPathToString(xr_instance, path, sizeof(buff), &len, buff));
+		source.name = buff;
+
+		// The first three parts of the string - which is something like '/user/hand/right/input/a/click' - are
+		// the device path, and the 4th and 5th ones are the input path.
+		// See the FIXME in activeOriginFromSubaction - nothing actually guarantees this layout.
+		stringSplit(source.name, parts);
+		if (parts.size() >= 3)
+			source.devicePath = pathFromParts({ parts.at(0), parts.at(1), parts.at(2) });
+		if (parts.size() >= 5)
+			source.inputPath = pathFromParts({ parts.at(3), parts.at(4) });
+
+		OOVR_FALSE_ABORT(GetInputSourceHandle(source.name.c_str(), &source.origin) == vr::VRInputError_None);
+		if (!source.devicePath.empty())
+			OOVR_FALSE_ABORT(GetInputSourceHandle(source.devicePath.c_str(), &source.deviceOrigin) == vr::VRInputError_None);
+
+		action->boundSources.push_back(std::move(source));
+	}
+
+	// Sort the devices by their path, so the origins come out in the same order every time
+	std::map<std::string, VRInputValueHandle_t> devices;
+	for (const BoundSource& source : action->boundSources) {
+		if (!source.devicePath.empty())
+			devices.emplace(source.devicePath, source.deviceOrigin);
+	}
+	for (const auto& device : devices)
+		action->deviceOrigins.push_back(device.second);
+}
+
+void BaseInput::OnInteractionProfileChanged()
+{
+	bindingsSerial++;
+}
+
 bool BaseInput::GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDeviceIndex, vr::VRControllerState_t* state)
+{
+	if (!GetRawLegacyControllerState(controllerDeviceIndex, state))
+		return false;
+
+	// Leave the packet number counting up, so the game doesn't think the controller has frozen
+	int hand = DeviceIndexToHandId(controllerDeviceIndex);
+	if (hand != -1 && blockedHands[hand]) {
+		uint32_t packetNum = state->unPacketNum;
+		*state = {};
+		state->unPacketNum = packetNum;
+	}
+
+	return true;
+}
+
+bool BaseInput::GetRawLegacyControllerState(vr::TrackedDeviceIndex_t controllerDeviceIndex, vr::VRControllerState_t* state)
 {
 	*state = {};
 
@@ -2346,8 +2526,8 @@ bool BaseInput::GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDevi
 		}
 	};
 
-	bool disableTriggerTouch = oovr_global_configuration.DisableTriggerTouch();
-	bool inputSmoothingEnabled = oovr_global_configuration.EnableInputSmoothing();
+	bool disableTriggerTouch = oovr_global_configuration->DisableTriggerTouch();
+	bool inputSmoothingEnabled = oovr_global_configuration->EnableInputSmoothing();
 
 	// Read the buttons
 
@@ -2362,7 +2542,7 @@ bool BaseInput::GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDevi
 	// this will make thumb curl when knuckles trackpad sensor detects a touch
 	bindButton(XR_NULL_HANDLE, ctrl.trackPadTouch, vr::k_EButton_SteamVR_Touchpad, hand, inputSmoothingEnabled);
 
-	bool enableVRIKKnucklesTrackPadSupport = oovr_global_configuration.EnableVRIKKnucklesTrackPadSupport();
+	bool enableVRIKKnucklesTrackPadSupport = oovr_global_configuration->EnableVRIKKnucklesTrackPadSupport();
 	if (enableVRIKKnucklesTrackPadSupport) {
 		// VRIK binds knuckles trackpad click to "A" button touch in SteamVR controllers settings, this code replicates that behavior
 		bindButton(ctrl.btnA, XR_NULL_HANDLE, vr::k_EButton_A, hand, inputSmoothingEnabled);
@@ -2402,7 +2582,7 @@ bool BaseInput::GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDevi
 	};
 
 	// this chunk needs to be disabled if we want to use knuckles trackpad click for VRIK gestures
-	if (!enableVRIKKnucklesTrackPadSupport && !oovr_global_configuration.DisableTrackPad() && ctrl.trackPadClick && ctrl.trackPadY) {
+	if (!enableVRIKKnucklesTrackPadSupport && !oovr_global_configuration->DisableTrackPad() && ctrl.trackPadClick && ctrl.trackPadY) {
 		XrActionStateGetInfo getInfo = { XR_TYPE_ACTION_STATE_GET_INFO };
 		XrActionStateBoolean xs = { XR_TYPE_ACTION_STATE_BOOLEAN };
 		getInfo.action = ctrl.trackPadClick;
@@ -2429,17 +2609,18 @@ bool BaseInput::GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDevi
 		thumbstick.y = readFloat(ctrl.stickY);
 	}
 
+	const Config& cfg = oovr_global_configuration.Get();
 	float deadZoneSize = 0.0f;
 	float deadZoneXSize = 0.0f;
 	float deadZoneYSize = 0.0f;
 	if (hand == 0) {
-		deadZoneSize = std::abs(oovr_global_configuration.LeftDeadZoneSize());
-		deadZoneXSize = std::abs(oovr_global_configuration.LeftDeadZoneXSize());
-		deadZoneYSize = std::abs(oovr_global_configuration.LeftDeadZoneYSize());
+		deadZoneSize = std::abs(cfg.LeftDeadZoneSize());
+		deadZoneXSize = std::abs(cfg.LeftDeadZoneXSize());
+		deadZoneYSize = std::abs(cfg.LeftDeadZoneYSize());
 	} else if (hand == 1) {
-		deadZoneSize = std::abs(oovr_global_configuration.RightDeadZoneSize());
-		deadZoneXSize = std::abs(oovr_global_configuration.RightDeadZoneXSize());
-		deadZoneYSize = std::abs(oovr_global_configuration.RightDeadZoneYSize());
+		deadZoneSize = std::abs(cfg.RightDeadZoneSize());
+		deadZoneXSize = std::abs(cfg.RightDeadZoneXSize());
+		deadZoneYSize = std::abs(cfg.RightDeadZoneYSize());
 	}
 
 	if (std::abs(thumbstick.x) <= deadZoneXSize || std::abs(thumbstick.x) <= deadZoneSize) {
@@ -2517,11 +2698,20 @@ void BaseInput::TriggerLegacyHapticPulse(vr::TrackedDeviceIndex_t controllerDevi
 	XrHapticVibration vibration = { XR_TYPE_HAPTIC_VIBRATION };
 	vibration.frequency = XR_FREQUENCY_UNSPECIFIED;
 	vibration.duration = durationNanos;
-	vibration.amplitude = oovr_global_configuration.HapticStrength();
+	vibration.amplitude = oovr_global_configuration->HapticStrength();
 
 	OOVR_FAILED_XR_ABORT(xrApplyHapticFeedback(xr_session.get(), &info, (XrHapticBaseHeader*)&vibration));
 }
 
+bool BaseInput::IsSubactionBlocked(XrPath subactionPath) const
+{
+	for (int hand = 0; hand < 2; hand++) {
+		if (blockedHands[hand] && legacyControllers[hand].handPathXr == subactionPath)
+			return true;
+	}
+	return false;
+}
+
 int BaseInput::DeviceIndexToHandId(vr::TrackedDeviceIndex_t idx)
 {
 	ITrackedDevice* dev = BackendManager::Instance().GetDevice(idx);
@@ -2558,11 +2748,25 @@ void BaseInput::GetHandSpace(vr::TrackedDeviceIndex_t index, XrSpace& space, boo
 
 void BaseInput::GetHandSpace(ITrackedDevice::HandType hand, XrSpace& space, bool aimPose)
 {
+	// Trackers and the HMD don't have a hand
+	if (hand != ITrackedDevice::HAND_LEFT && hand != ITrackedDevice::HAND_RIGHT) {
+		space = XR_NULL_HANDLE;
+		return;
+	}
+
 	LegacyControllerActions& ctrl = legacyControllers[hand];
 
 	space = aimPose ? ctrl.aimPoseSpace : ctrl.gripPoseSpace;
 }
 
+XrSpace BaseInput::GetTrackerSpace(int role)
+{
+	if (!hasLoadedActions || role < 0 || role >= (int)trackerSpaces.size())
+		return XR_NULL_HANDLE;
+
+	return trackerSpaces.at(role);
+}
+
 bool BaseInput::AreActionsLoaded()
 {
 	return hasLoadedActions;
@@ -360,6 +360,18 @@ public: // INTERNAL FUNCTIONS
 	 */
 	bool GetLegacyControllerState(vr::TrackedDeviceIndex_t controllerDeviceIndex, vr::VRControllerState_t* controllerState);
 
+	/**
+	 * The same as GetLegacyControllerState, but the controller's state is read even while it's hidden from the
+	 * game (see SetHandInputBlocked). This is for the keyboard, which needs to see the buttons it's hiding.
+	 */
+	bool GetRawLegacyControllerState(vr::TrackedDeviceIndex_t controllerDeviceIndex, vr::VRControllerState_t* controllerState);
+
+	/**
+	 * Hides a hand's buttons, triggers and sticks from the game, through both the legacy input and the digital
+	 * and analogue actions. BaseSystem sets this every frame, see BaseSystem::_BlockInputsUntilReleased.
+	 */
+	inline void SetHandInputBlocked(int hand, bool blocked) { blockedHands[hand] = blocked; }
+
 	void TriggerLegacyHapticPulse(vr::TrackedDeviceIndex_t controllerDeviceIndex, uint64_t durationNanos);
 
 	// aimPose defaults to false (grip), since OpenVR games are typically expecting a "raw"/natural controller pose, and
@@ -368,6 +380,12 @@ public: // INTERNAL FUNCTIONS
 
 	void GetHandSpace(ITrackedDevice::HandType hand, XrSpace& space, bool aimPose);
 
+	/**
+	 * Get the space for the body tracker with the given role (see XrTracker::roles). Returns XR_NULL_HANDLE
+	 * if the runtime doesn't support trackers, or the actions haven't been loaded yet.
+	 */
+	XrSpace GetTrackerSpace(int role);
+
 	bool AreActionsLoaded();
 
 	/**
@@ -376,6 +394,12 @@ public: // INTERNAL FUNCTIONS
 	 */
 	inline uint64_t GetSyncSerial() const { return syncSerial; }
 
+	/**
+	 * Called by the backend when the runtime says the interaction profile changed, which means the actions may
+	 * be bound to different inputs now.
+	 */
+	void OnInteractionProfileChanged();
+
 private:
 	enum class ActionRequirement {
 		Suggested = 0, // default
@@ -523,11 +547,23 @@ private:
 		ITrackedDevice::HandType hand = ITrackedDevice::HAND_LEFT;
 	};
 
-	struct Action {
-	private:
-		static constexpr size_t sources_size = 32;
+	/**
+	 * A physical control an action is bound to, split up into the parts OpenVR's origin and binding info
+	 * functions return. This is worked out once per interaction profile change, since games that draw button
+	 * prompts often ask about the same actions every frame.
+	 */
+	struct BoundSource {
+		XrPath path = XR_NULL_PATH;
+		std::string name; // eg /user/hand/right/input/a/click
+		std::string devicePath; // eg /user/hand/right
+		std::string inputPath; // eg /input/a
+
+		// The input value handles for the full path and the device path
+		VRInputValueHandle_t origin = vr::k_ulInvalidInputValueHandle;
+		VRInputValueHandle_t deviceOrigin = vr::k_ulInvalidInputValueHandle;
+	};
 
-	public:
+	struct Action {
 		~Action(); // Must be defined non-inline to avoid it ending up in stubs.gen.cpp
 
 		// Since the list of VirtualInputs cannot be copied (only moved) we might as well make the
@@ -550,11 +586,11 @@ private:
 		ITrackedDevice::HandType skeletalHand = ITrackedDevice::HAND_NONE;
 
 		// The action sources (paths like /user/hand/left/input/select/click, specifying an output of a physical
-		// control) this action is bound to. This is cached, and is updated by activeOriginFromSubaction.
-		XrPath sources[sources_size] = {};
-		std::string sourceNames[sources_size] = {};
-		uint32_t sourcesCount = 0; // Number of sources in the above that are defined
-		uint64_t nextSourcesUpdate = 0; // For caching, the next value of syncSerial this should update at
+		// control) this action is bound to. This is cached, and is updated by updateBoundSources.
+		std::vector<BoundSource> boundSources;
+		std::vector<VRInputValueHandle_t> deviceOrigins; // The unique device origins, sorted by their paths
+		uint64_t boundSourcesSerial = UINT64_MAX; // The value of bindingsSerial the sources were fetched at
+		uint64_t nextSourcesUpdate = 0; // While there aren't any sources, the next value of syncSerial to check at
 
 		// Only used in the case of Pose actions, this is the action space for each subaction path
 		// The indexes match up with allSubactionPaths
@@ -626,16 +662,17 @@ private:
 	//  handle and that handle must be both unique for that string, and constant across calls with the same
 	//  string supplied.
 	// Additionally, some magic strings that OpenComposite loads are associated with additional data.
-	// These provide an opaque handle for a given string. If that string has an object associated with it then
-	//  it's that pointer (to make debugging easier, since you just cast to inspect the contents) or a dummy
-	//  value of a constant plus some randomisation otherwise.
-	// Handle-to-object lookups are always done through an unsorted map (no pointer cases, just in case the
-	//  memory behind the dummy values are somehow allocated and the performance cost should be very
-	//  small), the handle being the pointer solely for debugging.
+	// These provide an opaque handle for a given string, which is a per-registry tag in the top half and the
+	//  index of the string's slot (plus one, since zero is the invalid handle) in the bottom half. The games
+	//  look up handles on every input call, so that's just a bounds check and an array index. The tag means
+	//  a handle from the wrong registry (or a made-up one) is rejected instead of indexing something random.
+	// Reset drops all the objects but keeps the slots, so names keep their handles across manifest reloads.
+	//  Each slot remembers which generation its object was added in, and Reset starts a new generation, so
+	//  looking up a handle whose object was reset finds nothing until it's initialised again.
 	template <typename T>
 	class Registry {
 	public:
-		Registry(uint32_t _maxNameSize);
+		Registry(uint32_t _maxNameSize, uint32_t _tag);
 		~Registry();
 
 		T* LookupItem(const std::string& name) const;
@@ -650,19 +687,37 @@ private:
 		void Reset();
 
 	private:
-		// A map of names to handles, used in the common case of not-the-first call
-		std::unordered_map<std::string, RegHandle> handlesByName;
+		struct Slot {
+			std::string name; // Lower-case, and shortened if it was too long - also useful for debugging
+			T* item = nullptr; // Only valid if generation matches the registry's
+			uint32_t generation = 0;
+		};
+
+		// Hashing and comparing names ignores case, so they don't have to be lowered before every lookup
+		struct CaseFoldHash {
+			size_t operator()(const std::string& str) const;
+		};
+		struct CaseFoldEqual {
+			bool operator()(const std::string& a, const std::string& b) const;
+		};
+
+		// Find the slot for a handle, or null if it's not a handle from this registry
+		const Slot* GetSlot(RegHandle handle) const;
+
+		// Find the index of the slot for a (lower-case) name, adding one if it's not already there
+		uint32_t InternName(const std::string& name);
 
-		// Reverse-lookup for debugging
-		std::unordered_map<RegHandle, std::string> namesByHandle;
+		// The slot for every name a handle has been made for, indexed by handle
+		std::vector<Slot> slots;
 
-		// Handles to their associated item, or nothing
-		std::unordered_map<RegHandle, T*> itemsByHandle;
+		// Names to the index of their slots
+		std::unordered_map<std::string, uint32_t, CaseFoldHash, CaseFoldEqual> slotsByName;
 
-		// Also for bonus performance, name to handle directly. Access time is more
-		// important than memory usage here, as there won't be many actual items (maybe
-		// single-digit thousands at most).
-		std::unordered_map<std::string, T*> itemsByName;
+		// Incremented by Reset, see Slot
+		uint32_t generation = 1;
+
+		// Put in the top half of every handle
+		const uint32_t tag;
 
 		// The storage for all the actual items
 		std::vector<std::unique_ptr<T>> storage;
@@ -679,6 +734,9 @@ private:
 	// See GetSyncSerial
 	uint64_t syncSerial = 0;
 
+	// Incremented when the actions' bound sources may have changed, see OnInteractionProfileChanged
+	uint64_t bindingsSerial = 0;
+
 	bool hasLoadedActions = false;
 	std::string loadedActionsPath;
 	bool usingLegacyInput = false;
@@ -691,8 +749,7 @@ private:
 
 	vr::ETrackedControllerRole dominantHand = vr::TrackedControllerRole_RightHand;
 
-	// TODO convert to Registry
-	std::unordered_map<std::string, std::unique_ptr<InputValueHandle>> inputHandleRegistry;
+	Registry<InputValueHandle> inputValueHandles;
 
 	XrActionSet legacyInputsSet = XR_NULL_HANDLE;
 
@@ -722,6 +779,18 @@ private:
 
 	LegacyControllerActions legacyControllers[2] = {};
 
+	// Indexed the same way as legacyControllers, see SetHandInputBlocked
+	bool blockedHands[2] = { false, false };
+
+	// Checks if an action's subaction path is for a hand whose input is hidden from the game
+	bool IsSubactionBlocked(XrPath subactionPath) const;
+
+	// The pose action for body trackers, in the legacy input set so it's synced along with the controllers. This is
+	// only created if the runtime supports XR_HTCX_vive_tracker_interaction. The paths and spaces are indexed by role.
+	XrAction trackerPoseAction = XR_NULL_HANDLE;
+	std::vector<XrPath> trackerRolePaths;
+	std::vector<XrSpace> trackerSpaces;
+
 	// From https://github.com/ValveSoftware/openvr/wiki/Hand-Skeleton
 	// Used as indexes into the skeleton output data
 	enum HandSkeletonBone {
@@ -759,17 +828,60 @@ private:
 		eBone_Count
 	};
 
-	void ConvertHandModelSpace(const std::vector<XrHandJointLocationEXT>& joints, bool isRight, VRBoneTransform_t* output);
-	void ConvertHandParentSpace(const std::vector<XrHandJointLocationEXT>& joints, bool isRight, VRBoneTransform_t* out_transforms);
+	// The skeletal data for one hand. Games like NeosVR ask for the same skeleton in several spaces and
+	// motion ranges every frame, so the joints are located at most once per xrSyncActions call and the
+	// converted (or estimated, without hand-tracking) bones are cached until the next one.
+	struct HandSkeleton {
+		// The value of syncSerial the joints were last located at
+		uint64_t locatedSerial = UINT64_MAX;
+		bool active = false;
+		XrHandJointLocationEXT joints[XR_HAND_JOINT_COUNT_EXT] = {};
+
+		// The bone transforms, indexed by motion range and then transform space. Both spaces are
+		// built at the same time, and bonesSerial is the value of syncSerial they were built at.
+		VRBoneTransform_t bones[2][2][eBone_Count] = {};
+		uint64_t bonesSerial[2] = { UINT64_MAX, UINT64_MAX };
+	};
+
+	/**
+	 * Locate the joints for the given hand, if they haven't already been located since the last xrSyncActions call.
+	 */
+	HandSkeleton& LocateHandJoints(ITrackedDevice::HandType hand);
+
+	/**
+	 * Convert the located joints into SteamVR bone transforms, in both model and parent space.
+	 */
+	static void ConvertHandBones(const HandSkeleton& skeleton, bool isRight, VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace);
+
+	/**
+	 * Fill in the aux bones from the distal bones of each finger.
+	 */
+	static void WriteAuxBones(VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace);
+
+	// One of the fixed hand poses used when the runtime doesn't support hand-tracking, see BaseInput_Hand.cpp
+	struct EstimatedPose;
+	static const EstimatedPose& GetEstimatedPose(int pose, bool isRight);
+
+	/**
+	 * Get one of the reference poses, or null if the pose isn't valid.
+	 */
+	static const VRBoneTransform_t* GetReferenceBones(bool isRight, EVRSkeletalReferencePose pose, EVRSkeletalTransformSpace space);
+
+	/**
+	 * Build the skeleton for a hand by blending between the estimated poses based on the controller's inputs,
+	 * for runtimes that don't support hand-tracking.
+	 */
+	void EstimateHandBones(ITrackedDevice::HandType hand, bool withController, VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace);
 
 	XrHandTrackerEXT handTrackers[2] = { XR_NULL_HANDLE, XR_NULL_HANDLE };
+	HandSkeleton handSkeletons[2];
 
 	// Utility functions
 	Action* cast_AH(VRActionHandle_t);
 	ActionSet* cast_ASH(VRActionSetHandle_t);
-	static InputValueHandle* cast_IVH(VRInputValueHandle_t);
-	static ITrackedDevice* ivhToDev(VRInputValueHandle_t handle);
-	static bool checkRestrictToDevice(vr::VRInputValueHandle_t restrict, XrPath subactionPath);
+	InputValueHandle* cast_IVH(VRInputValueHandle_t);
+	ITrackedDevice* ivhToDev(VRInputValueHandle_t handle);
+	bool checkRestrictToDevice(vr::VRInputValueHandle_t restrict, XrPath subactionPath);
 	static ITrackedDevice::HandType ParseAndRemoveHandPrefix(std::string& toModify);
 
 	/**
@@ -782,6 +894,12 @@ private:
 	 */
 	VRInputValueHandle_t activeOriginFromSubaction(Action* action, const char* subactionPath);
 
+	/**
+	 * Fetch the sources an action is bound to from the runtime, if that hasn't already been done since the
+	 * interaction profile last changed.
+	 */
+	void updateBoundSources(Action* action);
+
 	/**
 	 * Get the state for a digital action, which could be bound to a DPad action.
 	 */
@@ -4,11 +4,15 @@
 
 #include <convert.h>
 
+#include "Misc/SkeletonCodec.h"
+#include "Misc/xr_ext.h"
+
 #include <glm/ext.hpp>
 
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
 #include <optional>
 
 // Think of this file as just a part of BaseInput.cpp.
@@ -26,24 +30,16 @@ static void quaternionCopy(const T& src, U& dst)
 	dst.w = src.w;
 }
 
-static glm::mat4 readBoneTransform(const vr::VRBoneTransform_t& src)
-{
-	glm::quat srcQuat;
-	quaternionCopy(src.orientation, srcQuat);
-	glm::mat4 pose = glm::mat4_cast(srcQuat);
-	pose[3] = { src.position.v[0], src.position.v[1], src.position.v[2], 1.f };
-	return pose;
-}
+// The corrections applied to each joint's rotation, to get from OpenXR's per-bone coordinate systems to SteamVR's.
+// These are all pure rotations, so they're built once as quaternions rather than as matrices for every joint.
+struct BoneCorrections {
+	// Indexed by isRight
+	glm::quat wrist[2];
+	glm::quat finger[2];
+};
 
-// Games that use this:
-// * NeosVR
-// Any others? Please add them to the list!
-void BaseInput::ConvertHandModelSpace(const std::vector<XrHandJointLocationEXT>& joints, bool isRight, VRBoneTransform_t* output)
+static BoneCorrections BuildBoneCorrections()
 {
-	// The root bone should just be left at identity? TODO check SteamVR
-	output[eBone_Root].orientation = vr::HmdQuaternionf_t{ /* w */ 1, 0, 0, 0 };
-	output[eBone_Root].position = vr::HmdVector4_t{ 0, 0, 0, 1 };
-
 	// Note: go to https://gltf-viewer.donmccurdy.com/ and load up the hand glTF model from the test suite
 	// Turn the axes on and compare it to the OpenXR hand tracking extension diagram:
 	// https://registry.khronos.org/OpenXR/specs/1.0/html/xrspec.html#_conventions_of_hand_joints
@@ -73,125 +69,333 @@ void BaseInput::ConvertHandModelSpace(const std::vector<XrHandJointLocationEXT>&
 	// And the left hand gets it's own special transform
 	glm::mat4 leftHandTransform = glm::scale(glm::identity<glm::mat4>(), { -1, -1, 1 });
 
-	for (int XrId = XR_HAND_JOINT_WRIST_EXT; XrId <= XR_HAND_JOINT_LITTLE_TIP_EXT; XrId++) {
-		const XrHandJointLocationEXT& this_joint = joints[XrId];
-		glm::mat4 pose = X2G_om34_pose(this_joint.pose);
-
-		// Not a bug - xrIds match vrIds except for palm pose and aux bones.
-		vr::VRBoneTransform_t& out = output[XrId];
-
-		// Position is easy enough...
-		out.position = { pose[3][0], pose[3][1], pose[3][2], 1.f };
-
-		// But the transform to correct the bone's local coordinate system varies between bones, so add
-		// that in here. It's also different on the left and right hands.
-		if (XrId == XR_HAND_JOINT_WRIST_EXT) {
-			if (isRight) {
-				pose *= rightWristTransform;
-			} else {
-				pose *= leftWristTransform;
-			}
-		} else {
-			pose *= localTransform;
-
-			if (!isRight) {
-				pose *= leftHandTransform;
-			}
-		}
-
-		glm::quat out_rotation(pose);
-		quaternionCopy(out_rotation, out.orientation);
-	}
+	BoneCorrections corrections;
+	corrections.wrist[0] = glm::quat_cast(leftWristTransform);
+	corrections.wrist[1] = glm::quat_cast(rightWristTransform);
+	corrections.finger[0] = glm::quat_cast(localTransform * leftHandTransform);
+	corrections.finger[1] = glm::quat_cast(localTransform);
+	return corrections;
+}
 
-	OOVR_SOFT_ABORT("Aux bones not yet implemented!");
+static const BoneCorrections boneCorrections = BuildBoneCorrections();
+
+// The parent of each joint, or -1 for the wrist. This works for both the OpenXR joints and SteamVR bones,
+// as their indices match up (aside from the palm/root) until the tip of the little finger.
+// clang-format off
+static constexpr int jointParents[XR_HAND_JOINT_LITTLE_TIP_EXT + 1] = {
+	-1, // Palm (unused, this is the root bone in SteamVR)
+	-1, // Wrist
+	XR_HAND_JOINT_WRIST_EXT, 2, 3, 4, // Thumb
+	XR_HAND_JOINT_WRIST_EXT, 6, 7, 8, 9, // Index
+	XR_HAND_JOINT_WRIST_EXT, 11, 12, 13, 14, // Middle
+	XR_HAND_JOINT_WRIST_EXT, 16, 17, 18, 19, // Ring
+	XR_HAND_JOINT_WRIST_EXT, 21, 22, 23, 24, // Little
+};
+// clang-format on
+
+static void writeBone(vr::VRBoneTransform_t& out, const glm::vec3& position, const glm::quat& rotation)
+{
+	out.position = vr::HmdVector4_t{ position.x, position.y, position.z, 1.f }; // What's the fourth value for?
+	quaternionCopy(rotation, out.orientation);
 }
 
-// END MODEL POSE STUFF
+BaseInput::HandSkeleton& BaseInput::LocateHandJoints(ITrackedDevice::HandType hand)
+{
+	HandSkeleton& skeleton = handSkeletons[hand];
+	if (skeleton.locatedSerial == syncSerial)
+		return skeleton;
+
+	XrHandJointsLocateInfoEXT locateInfo = { XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT };
+	locateInfo.baseSpace = legacyControllers[hand].aimPoseSpace;
+	locateInfo.time = xr_gbl->GetBestTime();
+
+	XrHandJointLocationsEXT locations = { XR_TYPE_HAND_JOINT_LOCATIONS_EXT };
+	locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+	locations.jointLocations = skeleton.joints;
 
-// RELATIVE POSE STUFF
+	OOVR_FAILED_XR_ABORT(xr_ext->xrLocateHandJointsEXT(handTrackers[hand], &locateInfo, &locations));
 
-// This is just exactly what OC did before. It probably doesn't do the right thing.
-void BaseInput::ConvertHandParentSpace(const std::vector<XrHandJointLocationEXT>& joints, bool isRight, VRBoneTransform_t* out_transforms)
+	skeleton.locatedSerial = syncSerial;
+	skeleton.active = locations.isActive;
+	return skeleton;
+}
+
+// Games that use this:
+// * NeosVR
+// Any others? Please add them to the list!
+void BaseInput::ConvertHandBones(const HandSkeleton& skeleton, bool isRight, VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace)
 {
-	// First, get everything into the SteamVR coordinate system, to avoid duplicating the delicate space conversion system
-	VRBoneTransform_t modelRelative[31];
-	ConvertHandModelSpace(joints, isRight, modelRelative);
+	constexpr int firstJoint = XR_HAND_JOINT_WRIST_EXT;
+	constexpr int lastJoint = XR_HAND_JOINT_LITTLE_TIP_EXT;
+
+	// Unpack the joints into separate position and rotation arrays, and correct the bone's local
+	// coordinate system as we go. The correction varies between bones, and between the left and right hands.
+	glm::vec3 positions[lastJoint + 1];
+	glm::quat rotations[lastJoint + 1];
+	for (int i = firstJoint; i <= lastJoint; i++) {
+		positions[i] = X2G_v3f(skeleton.joints[i].pose.position);
+		rotations[i] = X2G_quat(skeleton.joints[i].pose.orientation);
+	}
+
+	rotations[firstJoint] = rotations[firstJoint] * boneCorrections.wrist[isRight];
+
+	const glm::quat& fingerCorrection = boneCorrections.finger[isRight];
+	for (int i = firstJoint + 1; i <= lastJoint; i++) {
+		rotations[i] = rotations[i] * fingerCorrection;
+	}
 
-	// Load the data into the output bones, with the correct mapping
-	std::optional<XrHandJointEXT> parentId;
-	auto mapBone = [&](XrHandJointEXT xrId, int vrId) {
-		OOVR_FALSE_ABORT(vrId < 31);
-		const vr::VRBoneTransform_t& src = modelRelative[xrId];
-		vr::VRBoneTransform_t& out = out_transforms[vrId];
+	// The root bone should just be left at identity? TODO check SteamVR
+	modelSpace[eBone_Root].orientation = vr::HmdQuaternionf_t{ /* w */ 1, 0, 0, 0 };
+	modelSpace[eBone_Root].position = vr::HmdVector4_t{ 0, 0, 0, 1 };
+	parentSpace[eBone_Root] = modelSpace[eBone_Root];
 
-		// Read the model-relative transform
-		glm::mat4 pose = readBoneTransform(src);
+	// Not a bug - xrIds match vrIds except for palm pose and aux bones.
+	for (int i = firstJoint; i <= lastJoint; i++) {
+		writeBone(modelSpace[i], positions[i], rotations[i]);
 
-		// All the OpenXR transforms are relative to the space we specified as baseSpace, in this case the grip pose. If the
+		// All the OpenXR transforms are relative to the space we specified as baseSpace, in this case the aim pose. If the
 		// application wants each bone's transform relative to it's parent, apply that now.
-		// If this bone is the root bone (parentId is not set), then it's the same in either space mode.
+		// If this bone is the wrist (which has no parent), then it's the same in either space mode.
 		// Get the required transform from:
 		// Tbone_in_model = Tparent_in_model * Tbone_in_parent
 		// inv(Tparent_in_model) * Tbone_in_model = Tbone_in_parent
-		if (parentId) {
-			const vr::VRBoneTransform_t& parent = modelRelative[parentId.value()];
-			glm::mat4 parentPose = readBoneTransform(parent);
+		int parent = jointParents[i];
+		if (parent == -1) {
+			parentSpace[i] = modelSpace[i];
+			continue;
+		}
+
+		glm::quat parentInverse = glm::conjugate(rotations[parent]);
+		writeBone(parentSpace[i], parentInverse * (positions[i] - positions[parent]), parentInverse * rotations[i]);
+	}
+
+	WriteAuxBones(modelSpace, parentSpace);
+}
+
+void BaseInput::WriteAuxBones(VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace)
+{
+	// The aux bones are equal to the distal bones, but always use VRSkeletalTransformSpace_Model mode
+	static constexpr int distalBones[] = { eBone_Thumb2, eBone_IndexFinger3, eBone_MiddleFinger3, eBone_RingFinger3, eBone_PinkyFinger3 };
+	for (int i = 0; i < 5; i++) {
+		modelSpace[eBone_Aux_Thumb + i] = modelSpace[distalBones[i]];
+		parentSpace[eBone_Aux_Thumb + i] = modelSpace[distalBones[i]];
+	}
+}
+
+// END MODEL POSE STUFF
+
+// ESTIMATED POSE STUFF
+// When the runtime doesn't support hand-tracking, we build the skeleton by blending between a few fixed hand
+// poses based on the controller's inputs - similar to what SteamVR does for controllers without finger tracking.
+
+// The poses in the table. The first four are the same as EVRSkeletalReferencePose.
+enum EstimatedPoseId {
+	ESTIMATED_POSE_BIND = VRSkeletalReferencePose_BindPose,
+	ESTIMATED_POSE_OPEN = VRSkeletalReferencePose_OpenHand,
+	ESTIMATED_POSE_FIST = VRSkeletalReferencePose_Fist,
+	ESTIMATED_POSE_GRIP_LIMIT = VRSkeletalReferencePose_GripLimit,
+	ESTIMATED_POSE_POINT,
+	ESTIMATED_POSE_COUNT,
+};
+
+// The shape of a hand, as the angle (in degrees) each joint is bent by. For the fingers these are the
+// metacarpal, proximal, intermediate and distal joints, for the thumb it's the metacarpal, proximal and distal joints.
+struct EstimatedHandShape {
+	float flex[5][4];
+	float splay; // Multiplier for how spread out the fingers are
+};
+
+// clang-format off
+static const EstimatedHandShape estimatedHandShapes[ESTIMATED_POSE_COUNT] = {
+	// Bind pose - relaxed, slightly curled hand
+	{ { { 10, 10, 10 }, { 0, 10, 10, 5 }, { 0, 10, 10, 5 }, { 0, 10, 10, 5 }, { 0, 10, 10, 5 } }, 1.0f },
+	// Open hand - fingers straight and spread out
+	{ { { 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } }, 1.3f },
+	// Fist
+	{ { { 35, 40, 40 }, { 0, 85, 100, 60 }, { 0, 85, 100, 60 }, { 5, 85, 100, 60 }, { 10, 85, 100, 60 } }, 0.5f },
+	// Grip limit - fingers wrapped around the controller's handle, thumb resting on the face buttons
+	{ { { 15, 15, 15 }, { 0, 55, 60, 30 }, { 0, 55, 60, 30 }, { 5, 55, 60, 30 }, { 10, 55, 60, 30 } }, 0.8f },
+	// Point - index finger straight, other fingers and the thumb lifted off the controller
+	{ { { 5, 5, 5 }, { 0, 0, 0, 0 }, { 0, 85, 100, 60 }, { 5, 85, 100, 60 }, { 10, 85, 100, 60 } }, 0.5f },
+};
+// clang-format on
+
+// The lengths of each bone of each finger, in metres. The thumb only has three bones.
+static const float estimatedBoneLengths[5][4] = {
+	{ 0.040f, 0.032f, 0.030f },
+	{ 0.065f, 0.040f, 0.025f, 0.022f },
+	{ 0.063f, 0.045f, 0.028f, 0.024f },
+	{ 0.058f, 0.042f, 0.027f, 0.023f },
+	{ 0.054f, 0.034f, 0.020f, 0.021f },
+};
+
+// The base of each metacarpal, relative to the wrist in the OpenXR wrist joint's space. The X axis is
+// flipped for the left hand, so positive values are towards the little finger.
+static const glm::vec3 estimatedMetacarpalOffsets[5] = {
+	{ -0.025f, -0.010f, -0.025f },
+	{ -0.020f, 0.000f, -0.010f },
+	{ -0.005f, 0.000f, -0.010f },
+	{ 0.009f, 0.000f, -0.008f },
+	{ 0.020f, -0.002f, -0.006f },
+};
+
+// How far each finger is rotated towards the thumb, in degrees, before the splay multiplier is applied.
+static const float estimatedFingerSplay[5] = { 40, 3, 0, -4, -9 };
+
+// The first OpenXR joint of each finger
+static constexpr int fingerFirstJoint[5] = {
+	XR_HAND_JOINT_THUMB_METACARPAL_EXT,
+	XR_HAND_JOINT_INDEX_METACARPAL_EXT,
+	XR_HAND_JOINT_MIDDLE_METACARPAL_EXT,
+	XR_HAND_JOINT_RING_METACARPAL_EXT,
+	XR_HAND_JOINT_LITTLE_METACARPAL_EXT,
+};
+
+struct BaseInput::EstimatedPose {
+	// Parent space, used for blending
+	glm::vec3 positions[eBone_Count];
+	glm::quat rotations[eBone_Count];
+
+	// Indexed by EVRSkeletalTransformSpace
+	VRBoneTransform_t bones[2][eBone_Count];
+
+	void Build(const EstimatedHandShape& shape, bool isRight);
+};
+
+void BaseInput::EstimatedPose::Build(const EstimatedHandShape& shape, bool isRight)
+{
+	// Build the joints as if they came from the hand-tracking extension, in the aim space of a
+	// controller being held in the normal way. That way they go through exactly the same conversion
+	// as real hand-tracking data.
+	HandSkeleton skeleton;
+	skeleton.active = true;
+
+	float side = isRight ? 1.f : -1.f;
+
+	// The back of the hand faces outwards, and the fingers point forwards
+	glm::mat3 wristAxes;
+	wristAxes[0] = glm::vec3(0, -side, 0);
+	wristAxes[1] = glm::vec3(side, 0, 0);
+	wristAxes[2] = glm::vec3(0, 0, 1);
+	glm::quat wristRotation = glm::quat_cast(wristAxes);
+	glm::vec3 wristPosition(0, -0.025f, 0.13f);
+
+	auto setJoint = [&](int joint, const glm::vec3& position, const glm::quat& rotation) {
+		XrPosef& pose = skeleton.joints[joint].pose;
+		pose.position = XrVector3f{ position.x, position.y, position.z };
+		pose.orientation = XrQuaternionf{ rotation.x, rotation.y, rotation.z, rotation.w };
+	};
+
+	setJoint(XR_HAND_JOINT_WRIST_EXT, wristPosition, wristRotation);
+	setJoint(XR_HAND_JOINT_PALM_EXT, wristPosition, wristRotation);
 
-			pose = glm::affineInverse(parentPose) * pose;
+	const glm::vec3 xAxis(1, 0, 0), yAxis(0, 1, 0), zAxis(0, 0, 1);
+
+	for (int finger = 0; finger < 5; finger++) {
+		int boneCount = finger == 0 ? 3 : 4;
+
+		glm::vec3 offset = estimatedMetacarpalOffsets[finger];
+		offset.x *= side;
+		glm::vec3 position = wristPosition + wristRotation * offset;
+
+		glm::quat rotation = wristRotation * glm::angleAxis(glm::radians(side * estimatedFingerSplay[finger] * shape.splay), yAxis);
+
+		// Roll the thumb so it curls across the palm
+		if (finger == 0)
+			rotation = rotation * glm::angleAxis(glm::radians(side * 50.f), zAxis);
+
+		// Each bone points down it's joint's -Z axis, and bending the finger towards the palm is a negative rotation about X
+		int joint = fingerFirstJoint[finger];
+		for (int bone = 0; bone < boneCount; bone++) {
+			rotation = rotation * glm::angleAxis(glm::radians(-shape.flex[finger][bone]), xAxis);
+			setJoint(joint + bone, position, rotation);
+			position += rotation * glm::vec3(0, 0, -estimatedBoneLengths[finger][bone]);
 		}
 
-		// TODO eMotionRange, if that's even possible
+		// The tip has the same rotation as the distal joint
+		setJoint(joint + boneCount, position, rotation);
+	}
 
-		glm::quat rotation(pose);
-		out.position = vr::HmdVector4_t{ pose[3][0], pose[3][1], pose[3][2], 1.f }; // What's the fourth value for?
-		quaternionCopy(rotation, out.orientation);
+	ConvertHandBones(skeleton, isRight, bones[VRSkeletalTransformSpace_Model], bones[VRSkeletalTransformSpace_Parent]);
 
-		// Update the parent to make it convenient to declare bones moving towards the finger tip
-		parentId = xrId;
+	for (int i = 0; i < eBone_Count; i++) {
+		const VRBoneTransform_t& bone = bones[VRSkeletalTransformSpace_Parent][i];
+		positions[i] = glm::vec3(bone.position.v[0], bone.position.v[1], bone.position.v[2]);
+		rotations[i] = glm::quat(bone.orientation.w, bone.orientation.x, bone.orientation.y, bone.orientation.z);
+	}
+}
+
+const BaseInput::EstimatedPose& BaseInput::GetEstimatedPose(int pose, bool isRight)
+{
+	// Built on first use, since the conversion uses static data from this file
+	static EstimatedPose poses[ESTIMATED_POSE_COUNT][2];
+	static bool built = [] {
+		for (int i = 0; i < ESTIMATED_POSE_COUNT; i++) {
+			poses[i][0].Build(estimatedHandShapes[i], false);
+			poses[i][1].Build(estimatedHandShapes[i], true);
+		}
+		return true;
+	}();
+	(void)built;
+	return poses[pose][isRight];
+}
+
+const VRBoneTransform_t* BaseInput::GetReferenceBones(bool isRight, EVRSkeletalReferencePose pose, EVRSkeletalTransformSpace space)
+{
+	if (pose < 0 || pose > VRSkeletalReferencePose_GripLimit)
+		return nullptr;
+
+	int spaceId = space == VRSkeletalTransformSpace_Model ? VRSkeletalTransformSpace_Model : VRSkeletalTransformSpace_Parent;
+	return GetEstimatedPose(pose, isRight).bones[spaceId];
+}
+
+void BaseInput::EstimateHandBones(ITrackedDevice::HandType hand, bool withController, VRBoneTransform_t* modelSpace, VRBoneTransform_t* parentSpace)
+{
+	bool isRight = hand == ITrackedDevice::HAND_RIGHT;
+	const EstimatedPose& rest = GetEstimatedPose(withController ? ESTIMATED_POSE_GRIP_LIMIT : ESTIMATED_POSE_OPEN, isRight);
+	const EstimatedPose& fist = GetEstimatedPose(ESTIMATED_POSE_FIST, isRight);
+	const EstimatedPose& point = GetEstimatedPose(ESTIMATED_POSE_POINT, isRight);
+
+	LegacyControllerActions& controller = legacyControllers[hand];
+
+	auto getBool = [](XrAction action) {
+		XrActionStateGetInfo info = { XR_TYPE_ACTION_STATE_GET_INFO };
+		info.action = action;
+		XrActionStateBoolean state = { XR_TYPE_ACTION_STATE_BOOLEAN };
+		OOVR_FAILED_XR_ABORT(xrGetActionStateBoolean(xr_session.get(), &info, &state));
+		return (bool)state.currentState;
+	};
+	auto getFloat = [](XrAction action) {
+		XrActionStateGetInfo info = { XR_TYPE_ACTION_STATE_GET_INFO };
+		info.action = action;
+		XrActionStateFloat state = { XR_TYPE_ACTION_STATE_FLOAT };
+		OOVR_FAILED_XR_ABORT(xrGetActionStateFloat(xr_session.get(), &info, &state));
+		return std::clamp(state.currentState, 0.f, 1.f);
+	};
+
+	float trigger = getFloat(controller.trigger);
+	float grip = std::max(getFloat(controller.grip), getBool(controller.gripClick) ? 1.f : 0.f);
+	bool triggerTouch = trigger > 0 || getBool(controller.triggerTouch);
+	bool thumbTouch = getBool(controller.btnATouch) || getBool(controller.menuTouch) || getBool(controller.stickBtnTouch)
+	    || getBool(controller.trackPadTouch);
+
+	// Blend each bone between two of the poses: the index finger curls with the trigger and is pointing when the
+	// trigger isn't touched, the other fingers curl with the grip, and the thumb drops down when it touches something.
+	auto blend = [&](int first, int last, const EstimatedPose& from, const EstimatedPose& to, float factor) {
+		for (int i = first; i <= last; i++) {
+			glm::vec3 position = glm::mix(from.positions[i], to.positions[i], factor);
+			glm::quat rotation = glm::slerp(from.rotations[i], to.rotations[i], factor);
+			writeBone(parentSpace[i], position, rotation);
+		}
 	};
 
-	// Set up the root bone
-	out_transforms[0].orientation = vr::HmdQuaternionf_t{ /* w */ 1, 0, 0, 0 };
-	out_transforms[0].position = vr::HmdVector4_t{ 0, 0, 0, 1 };
-
-	parentId = {};
-	mapBone(XR_HAND_JOINT_WRIST_EXT, eBone_Wrist);
-
-	// clang-format off
-	parentId = XR_HAND_JOINT_WRIST_EXT;
-	mapBone(XR_HAND_JOINT_THUMB_METACARPAL_EXT, eBone_Thumb0);
-	mapBone(XR_HAND_JOINT_THUMB_PROXIMAL_EXT,   eBone_Thumb1);
-	mapBone(XR_HAND_JOINT_THUMB_DISTAL_EXT,     eBone_Thumb2);
-	mapBone(XR_HAND_JOINT_THUMB_TIP_EXT,        eBone_Thumb3);
-
-	parentId = XR_HAND_JOINT_WRIST_EXT;
-	mapBone(XR_HAND_JOINT_INDEX_METACARPAL_EXT,   eBone_IndexFinger0);
-	mapBone(XR_HAND_JOINT_INDEX_PROXIMAL_EXT,     eBone_IndexFinger1);
-	mapBone(XR_HAND_JOINT_INDEX_INTERMEDIATE_EXT, eBone_IndexFinger2);
-	mapBone(XR_HAND_JOINT_INDEX_DISTAL_EXT,       eBone_IndexFinger3);
-	mapBone(XR_HAND_JOINT_INDEX_TIP_EXT,          eBone_IndexFinger4);
-
-	parentId = XR_HAND_JOINT_WRIST_EXT;
-	mapBone(XR_HAND_JOINT_MIDDLE_METACARPAL_EXT,   eBone_MiddleFinger0);
-	mapBone(XR_HAND_JOINT_MIDDLE_PROXIMAL_EXT,     eBone_MiddleFinger1);
-	mapBone(XR_HAND_JOINT_MIDDLE_INTERMEDIATE_EXT, eBone_MiddleFinger2);
-	mapBone(XR_HAND_JOINT_MIDDLE_DISTAL_EXT,       eBone_MiddleFinger3);
-	mapBone(XR_HAND_JOINT_MIDDLE_TIP_EXT,          eBone_MiddleFinger4);
-
-	parentId = XR_HAND_JOINT_WRIST_EXT;
-	mapBone(XR_HAND_JOINT_RING_METACARPAL_EXT,   eBone_RingFinger0);
-	mapBone(XR_HAND_JOINT_RING_PROXIMAL_EXT,     eBone_RingFinger1);
-	mapBone(XR_HAND_JOINT_RING_INTERMEDIATE_EXT, eBone_RingFinger2);
-	mapBone(XR_HAND_JOINT_RING_DISTAL_EXT,       eBone_RingFinger3);
-	mapBone(XR_HAND_JOINT_RING_TIP_EXT,          eBone_RingFinger4);
-
-	parentId = XR_HAND_JOINT_WRIST_EXT;
-	mapBone(XR_HAND_JOINT_LITTLE_METACARPAL_EXT,   eBone_PinkyFinger0);
-	mapBone(XR_HAND_JOINT_LITTLE_PROXIMAL_EXT,     eBone_PinkyFinger1);
-	mapBone(XR_HAND_JOINT_LITTLE_INTERMEDIATE_EXT, eBone_PinkyFinger2);
-	mapBone(XR_HAND_JOINT_LITTLE_DISTAL_EXT,       eBone_PinkyFinger3);
-	mapBone(XR_HAND_JOINT_LITTLE_TIP_EXT,          BaseInput::eBone_PinkyFinger4);
-	// clang-format on
-
-	// TODO aux bones - they're equal to the distal bones but always use VRSkeletalTransformSpace_Model mode
+	blend(eBone_Root, eBone_Wrist, rest, rest, 0);
+	blend(eBone_Thumb0, eBone_Thumb3, point, withController ? rest : fist, thumbTouch ? 1.f : 0.f);
+	blend(eBone_IndexFinger0, eBone_IndexFinger4, triggerTouch ? rest : point, fist, trigger);
+	blend(eBone_MiddleFinger0, eBone_PinkyFinger4, rest, fist, grip);
+
+	skeleton_codec::ParentToModelSpace(parentSpace, modelSpace);
+	WriteAuxBones(modelSpace, parentSpace);
 }
+
+// END ESTIMATED POSE STUFF
@@ -4,55 +4,139 @@
 
 #include "BaseMailbox.h"
 
+#include <string.h>
+
 typedef BaseMailbox::MboxErr MboxErr;
 
+BaseMailbox::Mailbox* BaseMailbox::FindMailbox(const std::string& name)
+{
+	// There's only ever a couple of mailboxes, so don't bother with another map
+	for (auto& pair : mailboxes) {
+		if (pair.second.name == name)
+			return &pair.second;
+	}
+	return nullptr;
+}
+
 MboxErr BaseMailbox::RegisterMailbox(const char* name, OOVR_mbox_handle* handle)
 {
-	*handle = 123;
+	std::lock_guard<std::mutex> guard(lock);
 
-	// Ignore it for now
-	OOVR_LOGF("Pretending to register mailbox '%s'", name);
+	*handle = nextHandle++;
+
+	Mailbox& mailbox = mailboxes[*handle];
+	mailbox.name = name;
+	mailbox.ring = MailboxRing::Open(name);
+
+	// Only one process can read from the shared memory. If someone else has registered this mailbox, we can still
+	// pass messages around inside this process, but can't take theirs.
+	if (mailbox.ring && !mailbox.ring->ClaimReader()) {
+		OOVR_LOGF("Mailbox '%s' is already registered by another reader, only local messages will be received", name);
+		mailbox.ring.reset();
+	}
+
+	// If we'd been sending to it through shared memory, use the local queue from now on
+	remoteRings.erase(name);
+
+	// HL:A waits for the SteamVR web UI to say it's ready, which it never will since we don't have one. Pretend
+	// it did, so the game carries on.
+	if (!sentReadyMessage) {
+		sentReadyMessage = true;
+		mailbox.local.push_back(R"({ "type": "ready", })");
+		OOVR_LOGF("Queued fake ready message for mailbox '%s'", name);
+	}
+
+	OOVR_LOGF("Registered mailbox '%s' as %d (shared memory %s)", name, (int)*handle, mailbox.ring ? "available" : "unavailable");
 
 	return VR_MBox_None;
 }
 
 MboxErr BaseMailbox::UnregisterMailbox(OOVR_mbox_handle mbox)
 {
-	OOVR_LOGF("Pretending to unregister mailbox ID %d", (int)mbox);
+	std::lock_guard<std::mutex> guard(lock);
+
+	auto iter = mailboxes.find(mbox);
+	if (iter == mailboxes.end()) {
+		OOVR_LOGF("Tried to unregister unknown mailbox ID %d", (int)mbox);
+		return VR_MBox_None;
+	}
+
+	if (iter->second.ring)
+		iter->second.ring->Unlink();
+
+	mailboxes.erase(iter);
 	return VR_MBox_None;
 }
 
 MboxErr BaseMailbox::SendMessage(OOVR_mbox_handle mbox, const char* type, const char* message)
 {
-	OOVR_LOGF("Pretending to send mailbox message, type '%s' contents '%s'", type, message);
+	std::lock_guard<std::mutex> guard(lock);
+
+	size_t length = strlen(message);
+	if (length > MailboxRing::MAX_MESSAGE_LENGTH) {
+		OOVR_LOGF("Mailbox message to '%s' is too long (%d bytes), dropping it", type, (int)length);
+		return VR_MBox_BufferTooShort;
+	}
+
+	if (Mailbox* local = FindMailbox(type)) {
+		local->local.emplace_back(message, length);
+		return VR_MBox_None;
+	}
+
+	std::unique_ptr<MailboxRing>& ring = remoteRings[type];
+	if (ring && ring->IsUnlinked())
+		ring.reset();
+	if (!ring)
+		ring = MailboxRing::Open(type);
+
+	if (!ring) {
+		OOVR_LOGF("No way to send mailbox message to '%s', dropping it", type);
+		remoteRings.erase(type);
+		return VR_MBox_None;
+	}
+
+	if (!ring->Push(message, (uint32_t)length)) {
+		OOVR_LOG_ONCEF("Mailbox '%s' is full, dropping message", type);
+		return VR_MBox_BufferTooShort;
+	}
+
 	return VR_MBox_None;
 }
 
 MboxErr BaseMailbox::ReadMessage(OOVR_mbox_handle mboxHandle, char* outBuf, uint32_t outBufLen, uint32_t* msgLen)
 {
-	// Read message function
-	// If we have a message available (IDK what the mailbox is even supposed to do), try to read a message.
-	// If the message fits within the output buffer, copy it in and return 0.
-	// Otherwise if it doesn't fit, return 2.
-	// In both cases, set msgLen
-	// If we don't have a message, return an unknown error code other than 0 and 2 (HL:A doesn't care).
-
-	static bool recvdReadyMsg = false;
-	if (!recvdReadyMsg) {
-		recvdReadyMsg = true;
-
-		const std::string msg = R"({ "type": "ready", })";
-		*msgLen = msg.size();
-
-		if (outBufLen < msg.size() + 1) {
-			return VR_MBox_BufferTooShort;
-		}
-		strcpy(outBuf, msg.c_str());
-
-		OOVR_LOGF("Sending fake ready message '%s'", msg.c_str());
-		return VR_MBox_None;
+	std::lock_guard<std::mutex> guard(lock);
+
+	auto iter = mailboxes.find(mboxHandle);
+	if (iter == mailboxes.end())
+		return VR_MBox_NoMessage;
+	Mailbox& mailbox = iter->second;
+
+	// Messages from this process are always read first, which is fine since there's no ordering between processes
+	const char* message;
+	uint32_t length;
+	bool fromRing = false;
+
+	if (!mailbox.local.empty()) {
+		message = mailbox.local.front().c_str();
+		length = (uint32_t)mailbox.local.front().size();
+	} else if (mailbox.ring && mailbox.ring->Peek(&message, &length)) {
+		fromRing = true;
+	} else {
+		return VR_MBox_NoMessage;
 	}
 
-	// For now, just say we don't have a message
-	return VR_MBox_NoMessage;
+	*msgLen = length;
+	if (outBufLen < length + 1)
+		return VR_MBox_BufferTooShort;
+
+	memcpy(outBuf, message, length);
+	outBuf[length] = 0;
+
+	if (fromRing)
+		mailbox.ring->Pop();
+	else
+		mailbox.local.pop_front();
+
+	return VR_MBox_None;
 }
@@ -1,8 +1,14 @@
 #pragma once
 
 #include "../BaseCommon.h"
+#include "Misc/MailboxRing.h"
 #include "custom_interfaces/IVRMailbox_001.h"
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
 typedef vr::IVRMailbox_001::mbox_handle OOVR_mbox_handle;
 
 class BaseMailbox {
@@ -13,15 +19,47 @@ public:
 		VR_MBox_BufferTooShort = 2,
 	};
 
-	// TODO build up names and comments for these and their types
+	// Mailboxes are named queues of (JSON) messages, which HL:A uses to talk to the SteamVR web UI. Any process can
+	// send a message to a mailbox by name, but only the one that registered it reads from it.
 
 	MboxErr RegisterMailbox(const char* name, OOVR_mbox_handle* handle);
 
 	MboxErr UnregisterMailbox(OOVR_mbox_handle mbox);
 
+	/**
+	 * Send a message to the mailbox named by type. If it's registered in this process, it's queued directly,
+	 * otherwise it goes through shared memory - which is created if it doesn't exist yet, so messages sent before
+	 * the mailbox is registered aren't lost.
+	 */
 	MboxErr SendMessage(OOVR_mbox_handle mbox, const char* type, const char* message);
 
+	/**
+	 * Read the oldest message, if there is one. If it doesn't fit in the buffer (including the null terminator),
+	 * msgLen is still set and the message is left there, so it can be read again with a bigger buffer.
+	 */
 	MboxErr ReadMessage(OOVR_mbox_handle mbox, char* outBuf, uint32_t outBufLen, uint32_t* msgLen);
+
+private:
+	struct Mailbox {
+		std::string name;
+
+		// Messages sent from this process skip the shared memory entirely
+		std::deque<std::string> local;
+
+		// Null if shared memory isn't available, in which case only this process can send messages
+		std::unique_ptr<MailboxRing> ring;
+	};
+
+	std::mutex lock;
+	std::map<OOVR_mbox_handle, Mailbox> mailboxes;
+	OOVR_mbox_handle nextHandle = 1;
+
+	// Rings for mailboxes registered by other processes, kept open between messages
+	std::map<std::string, std::unique_ptr<MailboxRing>> remoteRings;
+
+	bool sentReadyMessage = false;
+
+	Mailbox* FindMailbox(const std::string& name);
 };
 
 typedef BaseMailbox::MboxErr OOVR_vrmb_typeb;
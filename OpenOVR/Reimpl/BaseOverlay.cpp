@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #define BASE_IMPL
 #include "BaseCompositor.h"
+#include "BaseInput.h"
 #include "BaseOverlay.h"
 #include "BaseSystem.h"
 #include "Compositor/compositor.h"
@@ -9,6 +10,7 @@
 #include "Misc/ScopeGuard.h"
 #include "convert.h"
 #include "generated/static_bases.gen.h"
+#include <filesystem>
 #include <string>
 
 using glm::mat4;
@@ -20,11 +22,13 @@ using namespace vr;
 class BaseOverlay::OverlayData {
 public:
 	const string key;
+	const VROverlayHandle_t handle;
 	string name;
 	HmdColor_t colour;
 
 	float widthMeters = 1; // default 1 meter
 
+	float curvature = 0; // Fraction of a full circle the overlay's width wraps around
 	float autoCurveDistanceRangeMin, autoCurveDistanceRangeMax; // WTF does this do?
 	EColorSpace colourSpace = ColorSpace_Auto;
 	bool visible = false; // TODO check against SteamVR
@@ -34,13 +38,32 @@ public:
 	bool highQuality = false;
 	uint64_t flags = 0;
 	float texelAspect = 1;
+	uint32_t sortOrder = 0;
 	std::queue<VREvent_t> eventQueue;
 
 	// Rendering
 	Texture_t texture = {};
 	XrCompositionLayerQuad layerQuad = { XR_TYPE_COMPOSITION_LAYER_QUAD };
+	XrCompositionLayerCylinderKHR layerCylinder = { XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR };
 	std::unique_ptr<Compositor> compositor;
 
+	// The space absolute overlays are placed in, for the tracking origin in use when the texture was set
+	XrSpace referenceSpace = XR_NULL_HANDLE;
+
+	// Static overlay detection (see SetOverlayTexture). This is the texture and bounds that were last
+	// copied into the compositor, and whether anything has happened since then that could change the image.
+	Texture_t copiedTexture = {};
+	VRTextureBounds_t copiedBounds = {};
+	bool contentChanged = true;
+	uint32_t unchangedSubmits = 0;
+
+	// Images set from system memory by SetOverlayRaw and SetOverlayFromFile (see UpdateOverlayImage). These
+	// use their own type of compositor, which has to be replaced when switching back to a texture.
+	std::shared_ptr<const OverlayImage> image;
+	OverlayImageLoader::Result pendingImage;
+	bool imageUploaded = false;
+	bool compositorIsRaw = false;
+
 	// Transform
 	VROverlayTransformType transformType = VROverlayTransform_Absolute;
 	union {
@@ -57,33 +80,175 @@ public:
 		0.0f, 0.0f, 0.0f, 1.0f
 	};
 
-	OverlayData(string key, string name)
-	    : key(key), name(name)
+	OverlayData(string key, VROverlayHandle_t handle, string name)
+	    : key(key), handle(handle), name(name)
 	{
 	}
 };
 
-// TODO don't pass around handles, as it will cause
-// crashes when we should merely return VROverlayError_InvalidHandle
-#define OVL (*((OverlayData**)pOverlayHandle))
-#define USEH()                                                                        \
-	OverlayData* overlay = (OverlayData*)ulOverlayHandle;                             \
-	if (!overlay || !validOverlays.count(overlay) || !overlays.count(overlay->key)) { \
-		return VROverlayError_InvalidHandle;                                          \
+#define USEH()                                             \
+	OverlayData* overlay = LookupOverlay(ulOverlayHandle); \
+	if (!overlay) {                                        \
+		return VROverlayError_InvalidHandle;               \
 	}
 
-#define USEHB()                                           \
-	OverlayData* overlay = (OverlayData*)ulOverlayHandle; \
-	if (!overlay || !overlays.count(overlay->key)) {      \
-		return false;                                     \
+#define USEHB()                                            \
+	OverlayData* overlay = LookupOverlay(ulOverlayHandle); \
+	if (!overlay) {                                        \
+		return false;                                      \
 	}
 
+// Overlay handles are the slot index plus one in the low half (so zero is never a valid handle), and the
+// slot's generation in the high half.
+static VROverlayHandle_t makeOverlayHandle(uint32_t slot, uint32_t generation)
+{
+	return ((uint64_t)generation << 32) | (uint64_t)(slot + 1);
+}
+
 BaseOverlay::~BaseOverlay()
 {
-	for (const auto& kv : overlays) {
-		if (kv.second) {
-			delete kv.second;
+	for (OverlayData* overlay : overlays) {
+		delete overlay;
+	}
+}
+
+// Find the space a device-relative overlay is placed in. This is null if the device doesn't
+// have one (or doesn't have one yet, since the action spaces are created along with the actions).
+static XrSpace getDeviceSpace(TrackedDeviceIndex_t device)
+{
+	if (device == k_unTrackedDeviceIndex_Hmd)
+		return xr_gbl->viewSpace;
+
+	BaseInput* input = GetUnsafeBaseInput();
+	if (!input)
+		return XR_NULL_HANDLE;
+
+	XrSpace space;
+	input->GetHandSpace(device, space);
+	return space;
+}
+
+// Whether a device could have a space: it's connected, and the actions (which the spaces are created along with)
+// have been loaded. Overlays on devices without a space are only rebuilt when this changes.
+static bool isDeviceReady(TrackedDeviceIndex_t device)
+{
+	BaseInput* input = GetUnsafeBaseInput();
+	return input && input->AreActionsLoaded() && BackendManager::Instance().GetDevice(device);
+}
+
+BaseOverlay::OverlayData* BaseOverlay::LookupOverlay(VROverlayHandle_t handle)
+{
+	uint32_t slot = (uint32_t)(handle & 0xffffffff) - 1;
+	uint32_t generation = (uint32_t)(handle >> 32);
+
+	if (slot >= overlays.size() || overlayGenerations[slot] != generation)
+		return nullptr;
+
+	return overlays[slot];
+}
+
+void BaseOverlay::RebuildOverlayLayers()
+{
+	overlayLayersDirty = false;
+	overlayLayers.clear();
+	missingOverlayDevices.clear();
+
+	// Collect the overlays first, so they can be sorted before taking their layers
+	std::vector<std::pair<OverlayData*, XrCompositionLayerBaseHeader*>> visible;
+
+	for (OverlayData* overlay : overlays) {
+		if (!overlay)
+			continue;
+
+		// Skip hiddden overlays, and those without a valid texture (eg, after calling ClearOverlayTexture).
+		if (!overlay->visible || (overlay->texture.handle == nullptr && !overlay->imageUploaded))
+			continue;
+
+		// Quick hack to get around Boneworks creating overlays and setting them to an opacity of
+		// zero to hide them. Leave 1% of margin in case of weird float issues.
+		// if (overlay->colour.a < 0.01)
+		//	continue;
+
+		if ((uint64_t)overlay->layerQuad.subImage.swapchain == 0) {
+			continue;
+		}
+
+		const XrRect2Di& srcSize = overlay->layerQuad.subImage.imageRect;
+		if (srcSize.extent.height <= 8 && srcSize.extent.width <= 8) {
+			// Hack for F1 22 which creates a low res texture to fade between scenes
+			// but ends up just leaving a black square that takes up half the screen.
+			continue;
 		}
+
+		// Calculate the texture's aspect ratio
+		const float aspect = srcSize.extent.height > 0 ? (float)srcSize.extent.width / (float)srcSize.extent.height : 1.0f;
+		// ... and use that to set the size of the overlay, as it will appear to the user
+		// Note we shouldn't do this when setting the texture, as the user may change the width of
+		//  the overlay without changing the texture.
+		XrExtent2Df size;
+		XrPosef pose;
+		XrSpace space;
+
+		if (overlay->transformType == VROverlayTransform_TrackedDeviceRelative) {
+			// Let the runtime move the overlay with the device, so it doesn't lag behind
+			space = getDeviceSpace(overlay->transformData.deviceRelative.device);
+			if (!space) {
+				// Try again once the device connects (see _BuildLayers)
+				TrackedDeviceIndex_t device = overlay->transformData.deviceRelative.device;
+				missingOverlayDevices.emplace_back(device, isDeviceReady(device));
+				continue;
+			}
+
+			size.width = overlay->widthMeters;
+			size.height = overlay->widthMeters / aspect;
+			pose = S2O_om34_pose(overlay->transformData.deviceRelative.offset);
+		} else {
+			space = overlay->referenceSpace;
+			size.width = overlay->widthMeters * overlay->overlayTransform[0][0];
+			size.height = overlay->widthMeters * overlay->overlayTransform[1][1] / aspect;
+			pose = { { 0.f, 0.f, 0.f, 1.f },
+				{ overlay->overlayTransform[0][3], overlay->overlayTransform[1][3], overlay->overlayTransform[2][3] } };
+		}
+
+		if (overlay->curvature > 0 && xr_ext->CompositionLayerCylinder_Available()) {
+			XrCompositionLayerCylinderKHR& cylinder = overlay->layerCylinder;
+			cylinder.layerFlags = overlay->layerQuad.layerFlags;
+			cylinder.eyeVisibility = overlay->layerQuad.eyeVisibility;
+			cylinder.subImage = overlay->layerQuad.subImage;
+			cylinder.space = space;
+
+			// The curvature is the fraction of a circle the width of the overlay covers, and the overlay's
+			// transform is the middle of its surface. OpenXR wants the centre of the cylinder instead, which
+			// is one radius in front of that.
+			cylinder.centralAngle = 2 * math_pi * overlay->curvature;
+			cylinder.radius = size.width / cylinder.centralAngle;
+			cylinder.aspectRatio = size.width / size.height;
+
+			XrVector3f offset;
+			rotate_vector_by_quaternion({ 0, 0, cylinder.radius }, pose.orientation, offset);
+			cylinder.pose = pose;
+			cylinder.pose.position.x += offset.x;
+			cylinder.pose.position.y += offset.y;
+			cylinder.pose.position.z += offset.z;
+
+			visible.emplace_back(overlay, (XrCompositionLayerBaseHeader*)&cylinder);
+		} else {
+			overlay->layerQuad.space = space;
+			overlay->layerQuad.size = size;
+			overlay->layerQuad.pose = pose;
+
+			visible.emplace_back(overlay, (XrCompositionLayerBaseHeader*)&overlay->layerQuad);
+		}
+	}
+
+	// Overlays with a higher sort order are drawn on top, which means they have to come later in the
+	// list of layers. Ties keep the slot order, so they at least don't flicker between frames.
+	std::stable_sort(visible.begin(), visible.end(), [](const auto& a, const auto& b) {
+		return a.first->sortOrder < b.first->sortOrder;
+	});
+
+	for (const auto& entry : visible) {
+		overlayLayers.push_back(entry.second);
 	}
 }
 
@@ -100,84 +265,55 @@ int BaseOverlay::_BuildLayers(XrCompositionLayerBaseHeader* sceneLayer, XrCompos
 	//  when it's initially set to false, and when it's reset to true.
 	bool checkUsingInput = false;
 
+	// The keyboard goes on top of all the overlays
+	XrCompositionLayerBaseHeader* keyboardLayer = nullptr;
 	if (keyboard) {
-#ifndef OC_XR_PORT
-		layerHeaders.push_back(keyboard->Update());
-#endif
+		keyboardLayer = keyboard->Update();
 		checkUsingInput = true;
 
-		if (keyboard->IsClosed())
+		// This destroys the keyboard's layer, so it mustn't be submitted
+		if (keyboard->IsClosed()) {
 			HideKeyboard();
+			keyboardLayer = nullptr;
+		}
 	}
 
-	if (!oovr_global_configuration.EnableLayers()) {
+	if (!oovr_global_configuration->EnableLayers()) {
 		goto done;
 	}
 
-	for (const auto& kv : overlays) {
-		if (kv.second) {
-			OverlayData& overlay = *kv.second;
-
-			// Skip hiddden overlays, and those without a valid texture (eg, after calling ClearOverlayTexture).
-			if (!overlay.visible || overlay.texture.handle == nullptr)
-				continue;
-
-			// Quick hack to get around Boneworks creating overlays and setting them to an opacity of
-			// zero to hide them. Leave 1% of margin in case of weird float issues.
-			// if (overlay.colour.a < 0.01)
-			//	continue;
-
-			if ((uint64_t)overlay.layerQuad.subImage.swapchain == 0) {
-				continue;
-			}
-
-			const XrRect2Di& srcSize = overlay.layerQuad.subImage.imageRect;
-			if (srcSize.extent.height <= 8 && srcSize.extent.width <= 8) {
-				// Hack for F1 22 which creates a low res texture to fade between scenes
-				// but ends up just leaving a black square that takes up half the screen.
-				continue;
-			}
+	if (overlayImagesPending) {
+		overlayImagesPending = false;
+		for (OverlayData* overlay : overlays) {
+			if (overlay && UpdateOverlayImage(overlay))
+				overlayImagesPending = true;
+		}
+	}
 
-			// Calculate the texture's aspect ratio
-			const float aspect = srcSize.extent.height > 0 ? (float)srcSize.extent.width / (float)srcSize.extent.height : 1.0f;
-			// ... and use that to set the size of the overlay, as it will appear to the user
-			// Note we shouldn't do this when setting the texture, as the user may change the width of
-			//  the overlay without changing the texture.
-			overlay.layerQuad.size.width = overlay.widthMeters * overlay.overlayTransform[0][0];
-			overlay.layerQuad.size.height = overlay.widthMeters * overlay.overlayTransform[1][1] / aspect;
+	for (const auto& entry : missingOverlayDevices) {
+		if (isDeviceReady(entry.first) != entry.second)
+			overlayLayersDirty = true;
+	}
 
-			// Finally, add it to the list of layers to be sent to LibOVR
-			overlay.layerQuad.pose = { { 0.f, 0.f, 0.f, 1.f },
-				{ overlay.overlayTransform[0][3], overlay.overlayTransform[1][3], overlay.overlayTransform[2][3] } };
+	if (overlayLayersDirty)
+		RebuildOverlayLayers();
 
-			layerHeaders.push_back((XrCompositionLayerBaseHeader*)&overlay.layerQuad);
-		}
-	}
+	layerHeaders.insert(layerHeaders.end(), overlayLayers.begin(), overlayLayers.end());
 
 done:
+	if (keyboardLayer)
+		layerHeaders.push_back(keyboardLayer);
+
 	usingInput = checkUsingInput;
 	layers = layerHeaders.data();
 	return static_cast<int>(layerHeaders.size());
 }
 
-bool BaseOverlay::_HandleOverlayInput(EVREye side, TrackedDeviceIndex_t index, VRControllerState_t state)
-{
-	if (!usingInput)
-		return true;
-
-	if (!keyboard)
-		return true;
-
-#ifndef OC_XR_PORT
-	keyboard->HandleOverlayInput(side, state, (float)ovr_GetTimeInSeconds());
-#endif
-	return false;
-}
-
 EVROverlayError BaseOverlay::FindOverlay(const char* pchOverlayKey, VROverlayHandle_t* pOverlayHandle)
 {
-	if (overlays.count(pchOverlayKey)) {
-		OVL = overlays[pchOverlayKey];
+	auto iter = overlayKeys.find(pchOverlayKey);
+	if (iter != overlayKeys.end()) {
+		*pOverlayHandle = overlays[iter->second]->handle;
 		return VROverlayError_None;
 	}
 
@@ -186,20 +322,31 @@ EVROverlayError BaseOverlay::FindOverlay(const char* pchOverlayKey, VROverlayHan
 }
 EVROverlayError BaseOverlay::CreateOverlay(const char* pchOverlayKey, const char* pchOverlayName, VROverlayHandle_t* pOverlayHandle)
 {
-	if (overlays.count(pchOverlayKey)) {
+	if (overlayKeys.count(pchOverlayKey)) {
 		return VROverlayError_KeyInUse;
 	}
 
-	OverlayData* data = new OverlayData(pchOverlayKey, pchOverlayName);
-	OVL = data;
+	uint32_t slot;
+	if (!freeOverlaySlots.empty()) {
+		slot = freeOverlaySlots.back();
+		freeOverlaySlots.pop_back();
+	} else {
+		slot = (uint32_t)overlays.size();
+		overlays.push_back(nullptr);
+		overlayGenerations.push_back(0);
+	}
+
+	OverlayData* data = new OverlayData(pchOverlayKey, makeOverlayHandle(slot, overlayGenerations[slot]), pchOverlayName);
+	*pOverlayHandle = data->handle;
 
-	overlays[pchOverlayKey] = data;
-	validOverlays.insert(data);
+	overlays[slot] = data;
+	overlayKeys[pchOverlayKey] = slot;
 
 	data->layerQuad.type = XR_TYPE_COMPOSITION_LAYER_QUAD;
 	data->layerQuad.next = NULL;
 	data->layerQuad.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
-	data->layerQuad.space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
+	data->referenceSpace = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
+	data->layerQuad.space = data->referenceSpace;
 	data->layerQuad.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
 	data->layerQuad.pose = { { 0.f, 0.f, 0.f, 1.f },
 		{ 0.0f, 0.0f, -0.65f } };
@@ -213,8 +360,15 @@ EVROverlayError BaseOverlay::DestroyOverlay(VROverlayHandle_t ulOverlayHandle)
 	if (highQualityOverlay == ulOverlayHandle)
 		highQualityOverlay = vr::k_ulOverlayHandleInvalid;
 
-	overlays.erase(overlay->key);
-	validOverlays.erase(overlay);
+	uint32_t slot = overlayKeys[overlay->key];
+	overlayKeys.erase(overlay->key);
+	overlays[slot] = nullptr;
+	overlayGenerations[slot]++;
+	freeOverlaySlots.push_back(slot);
+
+	if (overlay->visible)
+		overlayLayersDirty = true;
+
 	delete overlay;
 
 	return VROverlayError_None;
@@ -236,12 +390,12 @@ VROverlayHandle_t BaseOverlay::GetHighQualityOverlay()
 }
 uint32_t BaseOverlay::GetOverlayKey(VROverlayHandle_t ulOverlayHandle, char* pchValue, uint32_t unBufferSize, EVROverlayError* pError)
 {
-	OverlayData* overlay = (OverlayData*)ulOverlayHandle;
-	if (!overlays.count(overlay->key)) {
+	OverlayData* overlay = LookupOverlay(ulOverlayHandle);
+	if (!overlay) {
 		if (pError)
 			*pError = VROverlayError_InvalidHandle;
 		if (unBufferSize != 0)
-			pchValue = 0;
+			pchValue[0] = 0;
 		return 0;
 	}
 
@@ -264,8 +418,8 @@ uint32_t BaseOverlay::GetOverlayName(VROverlayHandle_t ulOverlayHandle, VR_OUT_S
 	if (pError)
 		*pError = VROverlayError_None;
 
-	OverlayData* overlay = (OverlayData*)ulOverlayHandle;
-	if (!overlays.count(overlay->key)) {
+	OverlayData* overlay = LookupOverlay(ulOverlayHandle);
+	if (!overlay) {
 		if (pError)
 			*pError = VROverlayError_InvalidHandle;
 		if (unBufferSize != 0)
@@ -343,12 +497,17 @@ EVROverlayError BaseOverlay::SetOverlayFlag(VROverlayHandle_t ulOverlayHandle, V
 {
 	USEH();
 
+	uint64_t oldFlags = overlay->flags;
+
 	if (bEnabled) {
 		overlay->flags |= 1uLL << eOverlayFlag;
 	} else {
 		overlay->flags &= ~(1uLL << eOverlayFlag);
 	}
 
+	if (overlay->flags != oldFlags)
+		overlay->contentChanged = true;
+
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlayFlag(VROverlayHandle_t ulOverlayHandle, VROverlayFlags eOverlayFlag, bool* pbEnabled)
@@ -416,18 +575,29 @@ EVROverlayError BaseOverlay::GetOverlayTexelAspect(VROverlayHandle_t ulOverlayHa
 }
 EVROverlayError BaseOverlay::SetOverlaySortOrder(VROverlayHandle_t ulOverlayHandle, uint32_t unSortOrder)
 {
-	// TODO
+	USEH();
+
+	if (overlay->sortOrder != unSortOrder) {
+		overlay->sortOrder = unSortOrder;
+		overlayLayersDirty = true;
+	}
+
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlaySortOrder(VROverlayHandle_t ulOverlayHandle, uint32_t* punSortOrder)
 {
-	STUBBED();
+	USEH();
+
+	*punSortOrder = overlay->sortOrder;
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::SetOverlayWidthInMeters(VROverlayHandle_t ulOverlayHandle, float fWidthInMeters)
 {
 	USEH();
 
 	overlay->widthMeters = fWidthInMeters;
+	overlayLayersDirty = true;
 
 	return VROverlayError_None;
 }
@@ -441,11 +611,27 @@ EVROverlayError BaseOverlay::GetOverlayWidthInMeters(VROverlayHandle_t ulOverlay
 }
 EVROverlayError BaseOverlay::SetOverlayCurvature(VROverlayHandle_t ulOverlayHandle, float fCurvature)
 {
-	STUBBED();
+	USEH();
+
+	fCurvature = std::clamp(fCurvature, 0.0f, 1.0f);
+
+	if (overlay->curvature != fCurvature) {
+		overlay->curvature = fCurvature;
+		overlayLayersDirty = true;
+	}
+
+	if (fCurvature > 0 && !xr_ext->CompositionLayerCylinder_Available())
+		OOVR_LOG_ONCE("Curved overlay requested, but the runtime doesn't support cylinder layers - drawing it flat");
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlayCurvature(VROverlayHandle_t ulOverlayHandle, float* pfCurvature)
 {
-	STUBBED();
+	USEH();
+
+	*pfCurvature = overlay->curvature;
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::SetOverlayAutoCurveDistanceRangeInMeters(VROverlayHandle_t ulOverlayHandle, float fMinDistanceInMeters, float fMaxDistanceInMeters)
 {
@@ -469,6 +655,9 @@ EVROverlayError BaseOverlay::SetOverlayTextureColorSpace(VROverlayHandle_t ulOve
 {
 	USEH();
 
+	if (overlay->colourSpace != eTextureColorSpace)
+		overlay->contentChanged = true;
+
 	overlay->colourSpace = eTextureColorSpace;
 
 	return VROverlayError_None;
@@ -490,6 +679,8 @@ EVROverlayError BaseOverlay::SetOverlayTextureBounds(VROverlayHandle_t ulOverlay
 	else
 		overlay->textureBounds = { 0, 0, 1, 1 };
 
+	overlay->contentChanged = true;
+
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlayTextureBounds(VROverlayHandle_t ulOverlayHandle, VRTextureBounds_t* pOverlayTextureBounds)
@@ -529,6 +720,7 @@ EVROverlayError BaseOverlay::SetOverlayTransformAbsolute(VROverlayHandle_t ulOve
 
 	overlay->transformType = VROverlayTransform_Absolute;
 	S2O_om44(*pmatTrackingOriginToOverlayTransform, overlay->overlayTransform);
+	overlayLayersDirty = true;
 
 	return VROverlayError_None;
 }
@@ -547,15 +739,32 @@ EVROverlayError BaseOverlay::SetOverlayTransformTrackedDeviceRelative(VROverlayH
 {
 	USEH();
 
+	if (unTrackedDevice >= k_unMaxTrackedDeviceCount)
+		return VROverlayError_InvalidTrackedDevice;
+
+	if (!pmatTrackedDeviceToOverlayTransform)
+		return VROverlayError_InvalidParameter;
+
 	overlay->transformType = VROverlayTransform_TrackedDeviceRelative;
 	overlay->transformData.deviceRelative.device = unTrackedDevice;
 	overlay->transformData.deviceRelative.offset = *pmatTrackedDeviceToOverlayTransform;
+	overlayLayersDirty = true;
 
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlayTransformTrackedDeviceRelative(VROverlayHandle_t ulOverlayHandle, TrackedDeviceIndex_t* punTrackedDevice, HmdMatrix34_t* pmatTrackedDeviceToOverlayTransform)
 {
-	STUBBED();
+	USEH();
+
+	if (overlay->transformType != VROverlayTransform_TrackedDeviceRelative)
+		return VROverlayError_WrongTransformType;
+
+	if (punTrackedDevice)
+		*punTrackedDevice = overlay->transformData.deviceRelative.device;
+	if (pmatTrackedDeviceToOverlayTransform)
+		*pmatTrackedDeviceToOverlayTransform = overlay->transformData.deviceRelative.offset;
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::SetOverlayTransformTrackedDeviceComponent(VROverlayHandle_t ulOverlayHandle, TrackedDeviceIndex_t unDeviceIndex, const char* pchComponentName)
 {
@@ -591,12 +800,14 @@ EVROverlayError BaseOverlay::SetOverlayTransformProjection(VROverlayHandle_t ulO
 EVROverlayError BaseOverlay::ShowOverlay(VROverlayHandle_t ulOverlayHandle)
 {
 	USEH();
+	overlayLayersDirty |= !overlay->visible;
 	overlay->visible = true;
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::HideOverlay(VROverlayHandle_t ulOverlayHandle)
 {
 	USEH();
+	overlayLayersDirty |= overlay->visible;
 	overlay->visible = false;
 	return VROverlayError_None;
 }
@@ -721,26 +932,95 @@ EVROverlayError BaseOverlay::ClearOverlayCursorPositionOverride(VROverlayHandle_
 EVROverlayError BaseOverlay::SetOverlayTexture(VROverlayHandle_t ulOverlayHandle, const Texture_t* pTexture)
 {
 	USEH();
+
+	// Overlays without a texture are skipped when building the layers
+	if ((overlay->texture.handle == nullptr) != (pTexture->handle == nullptr))
+		overlayLayersDirty = true;
+
 	overlay->texture = *pTexture;
 
+	// Switching back from an image set by SetOverlayRaw or SetOverlayFromFile
+	if (overlay->compositorIsRaw || overlay->image || overlay->pendingImage.valid()) {
+		overlay->compositor.reset();
+		overlay->compositorIsRaw = false;
+		overlay->image.reset();
+		overlay->pendingImage = {};
+		overlay->imageUploaded = false;
+	}
+
 	BackendManager::Instance().OnOverlayTexture(pTexture);
 
-	if (!oovr_global_configuration.EnableLayers() || !BackendManager::Instance().IsGraphicsConfigured())
+	if (!oovr_global_configuration->EnableLayers() || !BackendManager::Instance().IsGraphicsConfigured())
 		return VROverlayError_None;
 
+	// If enabled, assume that setting the same texture again means its contents haven't changed. Apps signal
+	// a change by setting a different texture, or by changing something about how it's displayed first.
+	bool unchanged = oovr_global_configuration->StaticOverlays() && overlay->compositor && !overlay->contentChanged
+	    && overlay->copiedTexture.handle == pTexture->handle && overlay->copiedTexture.eType == pTexture->eType
+	    && overlay->copiedTexture.eColorSpace == pTexture->eColorSpace
+	    && memcmp(&overlay->copiedBounds, &overlay->textureBounds, sizeof(overlay->copiedBounds)) == 0;
+
+	if (unchanged) {
+		overlay->unchangedSubmits++;
+	} else {
+		overlay->unchangedSubmits = 0;
+	}
+
+	// Once an overlay has been left alone for a while, move it into a static swapchain so the runtime
+	// doesn't have to keep a set of images around for it. These can only be written once, so if it does
+	// change after that we have to go back to a normal swapchain.
+	static constexpr uint32_t STATIC_SWAPCHAIN_SUBMITS = 90;
+	bool wantStatic = overlay->unchangedSubmits >= STATIC_SWAPCHAIN_SUBMITS;
+
+	if (overlay->compositor && overlay->compositor->IsStaticImage() != wantStatic) {
+		overlay->compositor.reset();
+		unchanged = false;
+	}
+
 	if (!overlay->compositor) {
 		overlay->compositor.reset(GetUnsafeBaseCompositor()->CreateCompositorAPI(pTexture));
+		overlay->compositor->SetStaticImage(wantStatic);
 	}
 
-	overlay->compositor->LoadSubmitContext();
-	auto revertToCallerContext = MakeScopeGuard([&]() {
-		overlay->compositor->ResetSubmitContext();
-	});
+	if (unchanged) {
+		overlayCopiesSkipped++;
+	} else {
+		overlay->compositor->LoadSubmitContext();
+		auto revertToCallerContext = MakeScopeGuard([&]() {
+			overlay->compositor->ResetSubmitContext();
+		});
 
-	overlay->compositor->Invoke(&overlay->texture, nullptr);
+		overlay->compositor->Invoke(&overlay->texture, nullptr);
+
+		overlay->copiedTexture = *pTexture;
+		overlay->copiedBounds = overlay->textureBounds;
+		overlay->contentChanged = false;
+		overlayCopiesMade++;
+	}
+
+	if (oovr_global_configuration->StaticOverlays()) {
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::duration<float> elapsed = now - overlayCopyStatsStart;
+		if (elapsed.count() >= 10.0f) {
+			if (overlayCopiesSkipped != 0) {
+				OOVR_LOGF("Static overlays: skipped %.1f texture copies per second (%.1f copied)",
+				    overlayCopiesSkipped / elapsed.count(), overlayCopiesMade / elapsed.count());
+			}
+			overlayCopiesSkipped = 0;
+			overlayCopiesMade = 0;
+			overlayCopyStatsStart = now;
+		}
+	}
 
-	overlay->layerQuad.space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
-	overlay->layerQuad.subImage = {
+	UpdateOverlayLayerImage(overlay);
+
+	return VROverlayError_None;
+}
+void BaseOverlay::UpdateOverlayLayerImage(OverlayData* overlay)
+{
+	// Most apps set the same texture every frame, in which case the layer doesn't change
+	XrSpace space = xr_space_from_ref_space_type(GetUnsafeBaseSystem()->currentSpace);
+	XrSwapchainSubImage subImage = {
 		overlay->compositor->GetSwapChain(),
 		{ { 0, 0 },
 		    { (int32_t)overlay->compositor->GetSrcSize().width,
@@ -748,7 +1028,67 @@ EVROverlayError BaseOverlay::SetOverlayTexture(VROverlayHandle_t ulOverlayHandle
 		0
 	};
 
-	return VROverlayError_None;
+	const XrSwapchainSubImage& old = overlay->layerQuad.subImage;
+	if (overlay->referenceSpace != space || old.swapchain != subImage.swapchain || old.imageRect.extent.width != subImage.imageRect.extent.width
+	    || old.imageRect.extent.height != subImage.imageRect.extent.height) {
+		overlayLayersDirty = true;
+	}
+
+	overlay->referenceSpace = space;
+	overlay->layerQuad.subImage = subImage;
+}
+bool BaseOverlay::UpdateOverlayImage(OverlayData* overlay)
+{
+	if (overlay->pendingImage.valid()) {
+		if (overlay->pendingImage.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return true;
+
+		std::shared_ptr<const OverlayImage> loaded = overlay->pendingImage.get();
+		overlay->pendingImage = {};
+
+		// If the file couldn't be loaded (which is already logged), keep showing whatever was there before
+		if (loaded) {
+			overlay->image = std::move(loaded);
+			overlay->imageUploaded = false;
+		}
+	}
+
+	if (!overlay->image || overlay->imageUploaded || !oovr_global_configuration->EnableLayers())
+		return false;
+
+	// We need to know which graphics API the app is using before we can upload anything
+	if (!BackendManager::Instance().IsGraphicsConfigured())
+		return true;
+
+	if (!overlay->compositorIsRaw) {
+		overlay->texture = {};
+		overlay->compositor.reset(BaseCompositor::CreateRawCompositorAPI());
+		if (!overlay->compositor) {
+			OOVR_LOG_ONCE("Overlay images from system memory are not supported with this graphics API");
+			return false;
+		}
+		overlay->compositorIsRaw = true;
+
+		// These images are usually set once and left alone, so let the runtime skip buffering them. The
+		// compositor creates a new swapchain if the image does change.
+		overlay->compositor->SetStaticImage(true);
+	}
+
+	overlay->compositor->LoadSubmitContext();
+	auto revertToCallerContext = MakeScopeGuard([&]() {
+		overlay->compositor->ResetSubmitContext();
+	});
+
+	if (!overlay->compositor->InvokeRaw(overlay->image->pixels.data(), overlay->image->width, overlay->image->height)) {
+		OOVR_LOG_ONCE("Overlay images from system memory are not supported with this graphics API");
+		return false;
+	}
+
+	overlay->imageUploaded = true;
+	overlayLayersDirty = true;
+	UpdateOverlayLayerImage(overlay);
+
+	return false;
 }
 EVROverlayError BaseOverlay::ClearOverlayTexture(VROverlayHandle_t ulOverlayHandle)
 {
@@ -756,15 +1096,79 @@ EVROverlayError BaseOverlay::ClearOverlayTexture(VROverlayHandle_t ulOverlayHand
 	overlay->texture = {};
 
 	overlay->compositor.reset();
+	overlay->layerQuad.subImage = {};
+	overlay->copiedTexture = {};
+	overlay->contentChanged = true;
+	overlay->unchangedSubmits = 0;
+	overlay->compositorIsRaw = false;
+	overlay->image.reset();
+	overlay->pendingImage = {};
+	overlay->imageUploaded = false;
+	overlayLayersDirty = true;
 	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::SetOverlayRaw(VROverlayHandle_t ulOverlayHandle, void* pvBuffer, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth)
 {
-	STUBBED();
+	USEH();
+
+	// unDepth is the number of bytes per pixel: grey, grey and alpha, RGB or RGBA
+	if (!pvBuffer || unWidth == 0 || unHeight == 0 || unDepth < 1 || unDepth > 4)
+		return VROverlayError_InvalidParameter;
+
+	// Copy the image now, since the app is free to reuse its buffer as soon as we return
+	auto image = std::make_shared<OverlayImage>();
+	image->width = unWidth;
+	image->height = unHeight;
+	image->pixels.resize((size_t)unWidth * unHeight * 4);
+
+	const uint8_t* src = (const uint8_t*)pvBuffer;
+	uint8_t* dst = image->pixels.data();
+	size_t pixelCount = (size_t)unWidth * unHeight;
+
+	if (unDepth == 4) {
+		memcpy(dst, src, pixelCount * 4);
+	} else {
+		for (size_t i = 0; i < pixelCount; i++, src += unDepth, dst += 4) {
+			bool grey = unDepth <= 2;
+			dst[0] = src[0];
+			dst[1] = grey ? src[0] : src[1];
+			dst[2] = grey ? src[0] : src[2];
+			dst[3] = unDepth == 2 ? src[1] : 255;
+		}
+	}
+
+	overlay->pendingImage = {};
+	overlay->image = std::move(image);
+	overlay->imageUploaded = false;
+
+	if (UpdateOverlayImage(overlay))
+		overlayImagesPending = true;
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::SetOverlayFromFile(VROverlayHandle_t ulOverlayHandle, const char* pchFilePath)
 {
-	STUBBED();
+	USEH();
+
+	if (!pchFilePath)
+		return VROverlayError_InvalidParameter;
+
+	// Check the file exists here so we can report it to the app, the rest of the loading is done in
+	// the background.
+	std::error_code err;
+	if (!std::filesystem::is_regular_file(std::filesystem::u8path(pchFilePath), err))
+		return VROverlayError_UnableToLoadFile;
+
+	if (!imageLoader)
+		imageLoader = std::make_unique<OverlayImageLoader>();
+
+	overlay->pendingImage = imageLoader->Load(pchFilePath);
+
+	// Images from the cache are ready straight away
+	if (UpdateOverlayImage(overlay))
+		overlayImagesPending = true;
+
+	return VROverlayError_None;
 }
 EVROverlayError BaseOverlay::GetOverlayTexture(VROverlayHandle_t ulOverlayHandle, void** pNativeTextureHandle, void* pNativeTextureRef, uint32_t* pWidth, uint32_t* pHeight, uint32_t* pNativeFormat, ETextureType* pAPIType, EColorSpace* pColorSpace, VRTextureBounds_t* pTextureBounds)
 {
@@ -812,32 +1216,32 @@ EVROverlayError BaseOverlay::ShowKeyboardWithDispatch(EGamepadTextInputMode eInp
     const char* pchDescription, uint32_t unCharMax, const char* pchExistingText, bool bUseMinimalMode, uint64_t uUserValue,
     VRKeyboard::eventDispatch_t eventDispatch)
 {
-	// Submit a KeyboardDone event since the actual keyboard is not implemented yet.  This allows certain games to still proceed instead of crash.
-	SubmitPlaceholderKeyboardEvent(VREvent_KeyboardDone, eventDispatch, uUserValue);
-
-#ifndef OC_XR_PORT
-	if (!BaseCompositor::dxcomp)
-		OOVR_ABORT("Keyboard currently only available on DX11 and DX10 games");
+	// The keyboard can't be drawn before the app has submitted a frame, or with a graphics API that can't upload it
+	// from system memory. In that case, submit a KeyboardDone event with the configured text. This allows certain
+	// games to still proceed instead of crash.
+	if (!VRKeyboard::CanCreate()) {
+		keyboardCache = oovr_global_configuration->KeyboardText();
+		SubmitPlaceholderKeyboardEvent(VREvent_KeyboardDone, eventDispatch, uUserValue);
+		return VROverlayError_None;
+	}
 
 	if (eLineInputMode != k_EGamepadTextInputLineModeSingleLine)
-		OOVR_ABORTF("Only single-line keyboard entry mode is currently supported (as opposed to ID=%d)", eLineInputMode);
+		OOVR_LOGF("Only single-line keyboard entry mode is currently supported (as opposed to ID=%d)", eLineInputMode);
 
 	// TODO use description
-	keyboard = make_unique<VRKeyboard>(BaseCompositor::dxcomp->GetDevice(), uUserValue, unCharMax, bUseMinimalMode, eventDispatch,
-	    (VRKeyboard::EGamepadTextInputMode)eInputMode);
+	keyboard = make_unique<VRKeyboard>(uUserValue, unCharMax, bUseMinimalMode, eventDispatch, (VRKeyboard::EGamepadTextInputMode)eInputMode);
 
-	keyboard->contents(VRKeyboard::CHAR_CONV.from_bytes(pchExistingText));
+	keyboard->contents(VRKeyboard::CHAR_CONV.from_bytes(pchExistingText ? pchExistingText : ""));
 
 	BaseSystem* system = GetUnsafeBaseSystem();
 	if (system) {
 		system->_BlockInputsUntilReleased();
 	}
-#endif
 
 	return VROverlayError_None;
 }
 
-/** Placeholder method for submitting a KeyboardDone event when asked to show the keyboard since it is not implemented yet. **/
+/** Placeholder method for submitting a KeyboardDone event when asked to show the keyboard when it can't be drawn. **/
 void BaseOverlay::SubmitPlaceholderKeyboardEvent(vr::EVREventType ev, VRKeyboard::eventDispatch_t eventDispatch, uint64_t userValue)
 {
 	VREvent_Keyboard_t data = { 0 };
@@ -893,9 +1297,6 @@ uint32_t BaseOverlay::GetKeyboardText(char* pchText, uint32_t cchText)
 {
 	string str = keyboard ? VRKeyboard::CHAR_CONV.to_bytes(keyboard->contents()) : keyboardCache;
 
-	// Since keyboard is not functional yet, return this configurable default text
-	str = oovr_global_configuration.KeyboardText();
-
 	// FFS, strncpy is secure.
 	strncpy_s(pchText, cchText, str.c_str(), cchText);
 
@@ -925,16 +1326,12 @@ void BaseOverlay::SetKeyboardTransformAbsolute(ETrackingUniverseOrigin eTracking
 	if (!keyboard)
 		OOVR_ABORT("Cannot set keyboard position when the keyboard is closed!");
 
-#ifdef OC_XR_PORT
-	XR_STUBBED();
-#else
 	BaseCompositor* compositor = GetUnsafeBaseCompositor();
 	if (compositor && eTrackingOrigin != compositor->GetTrackingSpace()) {
 		OOVR_ABORTF("Origin mismatch - current %d, requested %d", compositor->GetTrackingSpace(), eTrackingOrigin);
 	}
 
 	keyboard->SetTransform(*pmatTrackingOriginToKeyboardTransform);
-#endif
 }
 void BaseOverlay::SetKeyboardPositionForOverlay(VROverlayHandle_t ulOverlayHandle, HmdRect2_t avoidRect)
 {
@@ -1,10 +1,13 @@
 #pragma once
 #include "../BaseCommon.h" // TODO don't import from OCOVR, and remove the "../"
 #include "../Misc/Keyboard/VRKeyboard.h" // TODO don't import from OCOVR, and remove the "../"
+#include "../Misc/OverlayImageLoader.h"
+#include <chrono>
 #include <map>
 #include <memory>
 #include <queue>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 enum OOVR_VROverlayInputMethod {
@@ -164,13 +167,19 @@ private:
 
 	class OverlayData;
 
-	// Name-to-overlay mapping
-	std::map<std::string, OverlayData*> overlays;
+	// All the overlays, indexed by the handle's slot (see LookupOverlay). Destroyed overlays leave a null
+	// entry, which is reused by the next overlay to be created.
+	std::vector<OverlayData*> overlays;
 
-	// Set of overlay pointers - use these to ensure the overlays are valid, and
-	// if games pass in some random value (*COUGH* Boneworks *COUGH) we can deal
-	// with it, rather than crashing everything.
-	std::set<OverlayData*> validOverlays;
+	// The generation of each slot, incremented every time it's reused. This is part of the handle, so
+	// handles to destroyed overlays are rejected even after their slot is reused.
+	std::vector<uint32_t> overlayGenerations;
+
+	// Slots of destroyed overlays, available for reuse
+	std::vector<uint32_t> freeOverlaySlots;
+
+	// Key-to-slot mapping
+	std::unordered_map<std::string, uint32_t> overlayKeys;
 
 	// This doesn't do a whole lot, since OOVR does this for every overlay
 	vr::VROverlayHandle_t highQualityOverlay;
@@ -178,6 +187,43 @@ private:
 	// List of layers, with the first being reserved for the main scene
 	std::vector<XrCompositionLayerBaseHeader*> layerHeaders;
 
+	// The layers of all the visible overlays in sort order. This is only rebuilt when something
+	// that affects it (visibility, texture, transform, size or sort order) changes.
+	std::vector<XrCompositionLayerBaseHeader*> overlayLayers;
+	bool overlayLayersDirty = true;
+
+	// The devices of any device-relative overlays that were left out of overlayLayers since the device had no
+	// space, along with whether the device was ready then. The layers are rebuilt when that changes.
+	std::vector<std::pair<vr::TrackedDeviceIndex_t, bool>> missingOverlayDevices;
+
+	// Statistics for the staticOverlays option, periodically written to the log
+	uint32_t overlayCopiesSkipped = 0;
+	uint32_t overlayCopiesMade = 0;
+	std::chrono::steady_clock::time_point overlayCopyStatsStart = std::chrono::steady_clock::now();
+
+	/**
+	 * Find the overlay for a handle. Games can pass in some random value (*COUGH* Boneworks *COUGH) so
+	 * this must handle anything, returning null if the handle isn't for a live overlay.
+	 */
+	OverlayData* LookupOverlay(vr::VROverlayHandle_t handle);
+
+	void RebuildOverlayLayers();
+
+	// Point an overlay's layer at its compositor's current swapchain
+	void UpdateOverlayLayerImage(OverlayData* overlay);
+
+	/**
+	 * Upload an overlay's image from SetOverlayRaw or SetOverlayFromFile, if it's ready and the app's graphics
+	 * API is known. Returns true if there's still something to do later on.
+	 */
+	bool UpdateOverlayImage(OverlayData* overlay);
+
+	// Decodes images for SetOverlayFromFile, created on first use
+	std::unique_ptr<OverlayImageLoader> imageLoader;
+
+	// Set if any overlay has an image UpdateOverlayImage hasn't finished with yet
+	bool overlayImagesPending = false;
+
 	// Virtual Keyboard
 	std::unique_ptr<VRKeyboard> keyboard;
 
@@ -185,7 +231,7 @@ private:
 	std::string keyboardCache;
 
 	// True if we're modifying the input in any way
-	bool usingInput;
+	bool usingInput = false;
 
 	virtual vr::EVROverlayError ShowKeyboardWithDispatch(
 	    EGamepadTextInputMode eInputMode, EGamepadTextInputLineMode eLineInputMode,
@@ -200,8 +246,9 @@ public:
 	// Builds the collection of layers to be submitted to LibOVR
 	int _BuildLayers(XrCompositionLayerBaseHeader* sceneLayer, XrCompositionLayerBaseHeader const* const*& result);
 
-	// If an overlay needs input, this grabs the input and returns whether the input should preceed to the application
-	bool _HandleOverlayInput(vr::EVREye role, vr::TrackedDeviceIndex_t controllerDeviceIndex, vr::VRControllerState_t state);
+	// Whether an overlay (currently only the keyboard) is taking the controllers' input, so BaseSystem can hide it from
+	// the application
+	bool _IsUsingInput() const { return usingInput; }
 
 	// ---------------------------------------------
 	// Overlay management methods
@@ -537,7 +584,7 @@ public:
 	/** Show the virtual keyboard to accept input **/
 	virtual vr::EVROverlayError ShowKeyboard(EGamepadTextInputMode eInputMode, EGamepadTextInputLineMode eLineInputMode, const char* pchDescription, uint32_t unCharMax, const char* pchExistingText, bool bUseMinimalMode, uint64_t uUserValue);
 
-	/** Placeholder method for submitting a KeyboardDone event when asked to show the keyboard since it is not implemented yet. **/
+	/** Placeholder method for submitting a KeyboardDone event when asked to show the keyboard when it can't be drawn. **/
 	virtual void SubmitPlaceholderKeyboardEvent(vr::EVREventType ev, VRKeyboard::eventDispatch_t eventDispatch, uint64_t userValue);
 
 	/**
@@ -2,6 +2,7 @@
 #define BASE_IMPL
 #include "BaseRenderModels.h"
 #include "Misc/Config.h"
+#include "Misc/xrmoreutils.h"
 #include "convert.h"
 #include "generated/static_bases.gen.h"
 #include "resources.h"
@@ -284,7 +285,7 @@ EVRRenderModelError BaseRenderModels::LoadTexture_Async(TextureID_t textureId, R
 	uint8_t* d = new uint8_t[tx.unWidth * tx.unHeight * 4];
 	tx.rubTextureMapData = d;
 
-	vr::HmdColor_t colour = oovr_global_configuration.HandColour();
+	vr::HmdColor_t colour = oovr_global_configuration->HandColour();
 	d[0] = (uint8_t)(colour.r * 255);
 	d[1] = (uint8_t)(colour.g * 255);
 	d[2] = (uint8_t)(colour.b * 255);
@@ -316,7 +317,7 @@ EVRRenderModelError BaseRenderModels::LoadIntoTextureD3D11_Async(TextureID_t tex
 	};
 
 	// Grab the desired colour
-	vr::HmdColor_t colour = oovr_global_configuration.HandColour();
+	vr::HmdColor_t colour = oovr_global_configuration->HandColour();
 
 	pix_t pixColour = { (uint8_t)(colour.r * 255), (uint8_t)(colour.g * 255), (uint8_t)(colour.b * 255), 255 };
 
@@ -402,7 +403,7 @@ uint32_t BaseRenderModels::GetRenderModelCount()
 uint32_t BaseRenderModels::GetComponentCount(const char* pchRenderModelName)
 {
 	// Left at zero for now until I can properly test it, and add textures
-	return oovr_global_configuration.RenderCustomHands() ? 1 : 0;
+	return oovr_global_configuration->RenderCustomHands() ? 1 : 0;
 
 	// This means there are no moving components (eg buttons thumbstick etc) which
 	//  can be animated via the Component functions, which thus shouldn't be called.
@@ -594,7 +595,7 @@ bool BaseRenderModels::TryGetComponentState(ITrackedDevice::HandType hand, const
 	}
 
 	XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
-	OOVR_FAILED_XR_ABORT(xrLocateSpace(componentSpace, gripSpace, xr_gbl->GetBestTime(), &location));
+	OOVR_FAILED_XR_ABORT(xr_utils::LocateSpace(componentSpace, gripSpace, &location));
 
 	if ((location.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) == 0) {
 		// If the location is invalid, there's not really a lot we can do. Just use the
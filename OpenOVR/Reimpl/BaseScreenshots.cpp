@@ -1,6 +1,11 @@
 #include "stdafx.h"
 #define BASE_IMPL
 #include "BaseScreenshots.h"
+
+#include "Drivers/Backend.h"
+#include "Misc/ScreenshotWriter.h"
+
+#include <string.h>
 #include <string>
 
 using namespace vr;
@@ -8,7 +13,14 @@ using EVRScreenshotError = BaseScreenshots::EVRScreenshotError;
 
 EVRScreenshotError BaseScreenshots::RequestScreenshot(ScreenshotHandle_t* pOutScreenshotHandle, EVRScreenshotType type, const char* pchPreviewFilename, const char* pchVRFilename)
 {
-	STUBBED();
+	// We only ever capture the submitted eye textures, which is exactly what a stereo screenshot is. The other
+	// types need the app's help, and we never send it a VREvent_RequestScreenshot.
+	if (type != VRScreenshotType_Stereo) {
+		OOVR_LOGF("Unsupported screenshot type %d requested", type);
+		return VRScreenshotError_RequestFailed;
+	}
+
+	return TakeStereoScreenshot(pOutScreenshotHandle, pchPreviewFilename, pchVRFilename);
 }
 EVRScreenshotError BaseScreenshots::HookScreenshot(VR_ARRAY_COUNT(numTypes) const EVRScreenshotType* pSupportedTypes, int numTypes)
 {
@@ -17,27 +29,85 @@ EVRScreenshotError BaseScreenshots::HookScreenshot(VR_ARRAY_COUNT(numTypes) cons
 }
 EVRScreenshotType BaseScreenshots::GetScreenshotPropertyType(ScreenshotHandle_t screenshotHandle, EVRScreenshotError* pError)
 {
+	auto iter = screenshots.find(screenshotHandle);
+	if (iter == screenshots.end()) {
+		if (pError)
+			*pError = VRScreenshotError_NotFound;
+		return VRScreenshotType_None;
+	}
+
 	if (pError)
 		*pError = VRScreenshotError_None;
 
-	STUBBED();
+	return iter->second.type;
 }
 uint32_t BaseScreenshots::GetScreenshotPropertyFilename(ScreenshotHandle_t screenshotHandle, EVRScreenshotPropertyFilenames filenameType, VR_OUT_STRING() char* pchFilename, uint32_t cchFilename, EVRScreenshotError* pError)
 {
+	auto iter = screenshots.find(screenshotHandle);
+	if (iter == screenshots.end()) {
+		if (pError)
+			*pError = VRScreenshotError_NotFound;
+		return 0;
+	}
+
+	const std::string& path = filenameType == VRScreenshotPropertyFilenames_Preview ? iter->second.previewPath : iter->second.vrPath;
+	uint32_t size = (uint32_t)path.size() + 1;
+
+	if (pchFilename && cchFilename < size) {
+		if (pError)
+			*pError = VRScreenshotError_BufferTooSmall;
+		return size;
+	}
+
+	if (pchFilename)
+		strcpy_s(pchFilename, cchFilename, path.c_str());
+
 	if (pError)
 		*pError = VRScreenshotError_None;
 
-	STUBBED();
+	return size;
 }
 EVRScreenshotError BaseScreenshots::UpdateScreenshotProgress(ScreenshotHandle_t screenshotHandle, float flProgress)
 {
-	STUBBED();
+	// We don't have a progress overlay to show, and the app doesn't need to know that
+	return VRScreenshotError_None;
 }
 EVRScreenshotError BaseScreenshots::TakeStereoScreenshot(ScreenshotHandle_t* pOutScreenshotHandle, const char* pchPreviewFilename, const char* pchVRFilename)
 {
-	STUBBED();
+	if (!pchPreviewFilename || !pchVRFilename)
+		return VRScreenshotError_RequestFailed;
+
+	// The filenames come without an extension, and we always save PNGs
+	Screenshot screenshot;
+	screenshot.type = VRScreenshotType_Stereo;
+	screenshot.previewPath = std::string(pchPreviewFilename) + ".png";
+	screenshot.vrPath = std::string(pchVRFilename) + ".png";
+
+	if (!writer)
+		writer = std::make_shared<ScreenshotWriter>();
+
+	// The frame is read back over the next few frames, then encoded on the writer's thread
+	std::shared_ptr<ScreenshotWriter> captureWriter = writer;
+	std::string previewPath = screenshot.previewPath;
+	std::string vrPath = screenshot.vrPath;
+	bool started = BackendManager::Instance().CaptureScreenshot([captureWriter, previewPath, vrPath](CompositorReadback* eyes) {
+		captureWriter->Write(eyes, previewPath, vrPath);
+	});
+
+	if (!started)
+		return VRScreenshotError_RequestFailed;
+
+	ScreenshotHandle_t handle = nextHandle++;
+	screenshots[handle] = std::move(screenshot);
+
+	if (pOutScreenshotHandle)
+		*pOutScreenshotHandle = handle;
+
+	return VRScreenshotError_None;
 }
 EVRScreenshotError BaseScreenshots::SubmitScreenshot(ScreenshotHandle_t screenshotHandle, EVRScreenshotType type, const char* pchSourcePreviewFilename, const char* pchSourceVRFilename)
 {
-	STUBBED();
+	// There's no Steam screenshot library to add this to, so the files are left where the app put them
+	OOVR_LOGF("Screenshot submitted: '%s'", pchSourceVRFilename ? pchSourceVRFilename : "(null)");
+	return VRScreenshotError_None;
 }
@@ -1,6 +1,12 @@
 #pragma once
 #include "BaseCommon.h"
 
+#include <map>
+#include <memory>
+#include <string>
+
+class ScreenshotWriter;
+
 enum OOVR_EVRScreenshotError {
 	VRScreenshotError_None = 0,
 	VRScreenshotError_RequestFailed = 1,
@@ -94,4 +100,17 @@ public:
 	 *  was a new shot taking by the app to be saved and not
 	 *  initiated by a user (achievement earned or something) */
 	virtual EVRScreenshotError SubmitScreenshot(vr::ScreenshotHandle_t screenshotHandle, vr::EVRScreenshotType type, const char* pchSourcePreviewFilename, const char* pchSourceVRFilename);
+
+private:
+	struct Screenshot {
+		vr::EVRScreenshotType type;
+		std::string previewPath;
+		std::string vrPath;
+	};
+
+	// Shared with the capture callbacks, so a screenshot that's still being read back can be saved after we're gone
+	std::shared_ptr<ScreenshotWriter> writer;
+
+	std::map<vr::ScreenshotHandle_t, Screenshot> screenshots;
+	vr::ScreenshotHandle_t nextHandle = 1; // Zero is k_unScreenshotHandleInvalid
 };
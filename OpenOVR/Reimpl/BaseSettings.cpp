@@ -225,7 +225,7 @@ float BaseSettings::GetFloat(const char* pchSection, const char* pchSettingsKey,
 
 	if (section == kk::k_pch_SteamVR_Section) {
 		if (key == kk::k_pch_SteamVR_SupersampleScale_Float || key == kk1::k_pch_SteamVR_RenderTargetMultiplier_Float) {
-			return oovr_global_configuration.SupersampleRatio();
+			return oovr_global_configuration->SupersampleRatio();
 		} else if (key == kk::k_pch_SteamVR_IPD_Float) {
 			return BaseSystem::SGetIpd();
 		} else if (key == kk::k_pch_SteamVR_IpdOffset_Float) {
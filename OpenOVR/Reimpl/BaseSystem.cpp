@@ -10,6 +10,7 @@
 #include "convert.h"
 #include "generated/static_bases.gen.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <string>
 
@@ -41,14 +42,14 @@ public:
 	PropertyPrinter(vr::ETrackedDeviceProperty prop, vr::TrackedDeviceIndex_t idx, const char* type_name)
 	    : prop(prop), idx(idx)
 	{
-		if (oovr_global_configuration.LogGetTrackedProperty())
+		if (oovr_global_configuration->LogGetTrackedProperty())
 			OOVR_LOGF("Requested %s property %u for device %u", type_name, prop, idx);
 	}
 
 #define DEF_PRINT_RESULT(type, specifier, expr)                                    \
 	void print_result(type result)                                                 \
 	{                                                                              \
-		if (oovr_global_configuration.LogGetTrackedProperty())                     \
+		if (oovr_global_configuration->LogGetTrackedProperty())                     \
 			OOVR_LOGF("dev: %u | prop: %u | result: " specifier, idx, prop, expr); \
 	}
 
@@ -60,7 +61,7 @@ public:
 
 	void print_result(HmdMatrix34_t result)
 	{
-		if (!oovr_global_configuration.LogGetTrackedProperty())
+		if (!oovr_global_configuration->LogGetTrackedProperty())
 			return;
 		std::string matrix = "[";
 		for (size_t i = 0; i < 3; i++) {
@@ -251,20 +252,28 @@ uint32_t BaseSystem::GetSortedTrackedDeviceIndicesOfClass(ETrackedDeviceClass ta
     vr::TrackedDeviceIndex_t unRelativeToTrackedDeviceIndex)
 {
 
-	uint32_t outCount = 0;
+	if (targetClass < 0 || targetClass >= TrackedDeviceClass_Max)
+		return 0;
 
-	for (vr::TrackedDeviceIndex_t dev = 0; dev < vr::k_unMaxTrackedDeviceCount; dev++) {
-		vr::ETrackedDeviceClass cls = GetTrackedDeviceClass(dev);
+	std::lock_guard<std::mutex> guard(devicesByClassLock);
 
-		if (cls != targetClass)
-			continue;
+	uint32_t generation = BackendManager::Instance().GetDeviceGeneration();
+	if (generation != devicesByClassGeneration) {
+		for (std::vector<vr::TrackedDeviceIndex_t>& indices : devicesByClass)
+			indices.clear();
 
-		if (outCount < indexCount)
-			indexArray[outCount] = dev;
+		for (vr::TrackedDeviceIndex_t dev = 0; dev < vr::k_unMaxTrackedDeviceCount; dev++) {
+			devicesByClass[GetTrackedDeviceClass(dev)].push_back(dev);
+		}
 
-		outCount++;
+		devicesByClassGeneration = generation;
 	}
 
+	const std::vector<vr::TrackedDeviceIndex_t>& indices = devicesByClass[targetClass];
+	uint32_t outCount = (uint32_t)indices.size();
+	if (indexArray)
+		std::copy_n(indices.begin(), std::min(outCount, indexCount), indexArray);
+
 	// TODO sort the devices
 	// I'm allowing this to do in despite not sorting it, since I can't see any usecase
 	// for relying on the sort results, possibly except for determining the left and right controller.
@@ -326,7 +335,13 @@ ETrackedDeviceClass BaseSystem::GetTrackedDeviceClass(vr::TrackedDeviceIndex_t d
 	if (deviceIndex == thirdTouchIndex)
 		return TrackedDeviceClass_GenericTracker;
 
-	return TrackedDeviceClass_Invalid;
+	// Anything else (such as body trackers) knows its own class. Only look the device up once, since it could be
+	// disconnected since it was checked above.
+	ITrackedDevice* device = BackendManager::Instance().GetDevice(deviceIndex);
+	if (!device)
+		return TrackedDeviceClass_Invalid;
+
+	return device->GetTrackedDeviceClass();
 }
 
 bool BaseSystem::IsTrackedDeviceConnected(vr::TrackedDeviceIndex_t deviceIndex)
@@ -426,7 +441,7 @@ uint32_t BaseSystem::GetArrayTrackedDeviceProperty(vr::TrackedDeviceIndex_t unDe
 	}
 
 	uint32_t ret = dev->GetArrayTrackedDeviceProperty(prop, propType, pBuffer, unBufferSize, pError);
-	if (oovr_global_configuration.LogGetTrackedProperty()) {
+	if (oovr_global_configuration->LogGetTrackedProperty()) {
 #define ARRAY_CASE(tag_type, actual_type)                         \
 	case k_un##tag_type##PropertyTag: {                           \
 		actual_type* buffer = static_cast<actual_type*>(pBuffer); \
@@ -540,6 +555,28 @@ void BaseSystem::_OnPostFrame()
 
 	if (inputSystem) {
 		inputSystem->InternalUpdate();
+		UpdateBlockedInputs();
+	}
+}
+
+void BaseSystem::UpdateBlockedInputs()
+{
+	// While the keyboard is open it takes the controllers' input, so the game doesn't see the keys being typed.
+	// After it opens or closes, the buttons stay hidden until they're let go, so the press that opened or closed
+	// it doesn't reach the game either.
+	BaseOverlay* overlay = GetUnsafeBaseOverlay();
+	bool overlayHasInput = overlay && overlay->_IsUsingInput();
+
+	static const ETrackedControllerRole roles[2] = { TrackedControllerRole_LeftHand, TrackedControllerRole_RightHand };
+	for (int hand = 0; hand < 2; hand++) {
+		if (blockingInputsUntilRelease[hand] && !overlayHasInput) {
+			TrackedDeviceIndex_t index = GetTrackedDeviceIndexForControllerRole(roles[hand]);
+			VRControllerState_t state;
+			if (index == k_unTrackedDeviceIndexInvalid || !inputSystem->GetRawLegacyControllerState(index, &state) || state.ulButtonPressed == 0)
+				blockingInputsUntilRelease[hand] = false;
+		}
+
+		inputSystem->SetHandInputBlocked(hand, overlayHasInput || blockingInputsUntilRelease[hand]);
 	}
 }
 
@@ -695,7 +732,7 @@ bool BaseSystem::GetControllerStateWithPose(ETrackingUniverseOrigin eOrigin, vr:
 
 void BaseSystem::TriggerHapticPulse(vr::TrackedDeviceIndex_t unControllerDeviceIndex, uint32_t unAxisId, unsigned short usDurationMicroSec)
 {
-	if (!oovr_global_configuration.Haptics())
+	if (!oovr_global_configuration->Haptics())
 		return;
 
 	if (unControllerDeviceIndex == leftHandIndex || unControllerDeviceIndex == rightHandIndex) {
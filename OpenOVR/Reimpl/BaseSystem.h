@@ -3,7 +3,9 @@
 #include "custom_types.h"
 #include "generated/interfaces/IVRSystem_017.h"
 #include "openxr/openxr.h"
+#include <mutex>
 #include <queue>
+#include <vector>
 
 class BaseSystem {
 	// Copied from IVRSystem, because MSVC made me.
@@ -25,6 +27,7 @@ private:
 	vr::VRControllerState_t lastLeftHandState = { 0 };
 	vr::VRControllerState_t lastRightHandState = { 0 };
 
+	// Set for each hand (left then right) when the keyboard opens or closes, and cleared once its buttons are let go
 	bool blockingInputsUntilRelease[2] = { false, false };
 
 	// The input subsystem. This is used for the old-style inputs and haptics.
@@ -32,6 +35,12 @@ private:
 
 	uint64_t frameNumber = 0;
 
+	// The indices of the connected devices of each class, for GetSortedTrackedDeviceIndicesOfClass. Some apps call
+	// that every frame, so this is only rebuilt when the backend's device generation changes.
+	std::mutex devicesByClassLock;
+	uint32_t devicesByClassGeneration = UINT32_MAX;
+	std::vector<vr::TrackedDeviceIndex_t> devicesByClass[vr::TrackedDeviceClass_Max];
+
 public:
 	// To be called by other base classes
 	void _OnPostFrame();
@@ -43,6 +52,7 @@ public:
 
 private:
 	void CheckControllerEvents(vr::TrackedDeviceIndex_t hand, vr::VRControllerState_t& last);
+	void UpdateBlockedInputs();
 
 public:
 	static const vr::TrackedDeviceIndex_t leftHandIndex = 1;
@@ -0,0 +1,15 @@
+#pragma once
+
+// These are generated by the stub generator into interface_hash.gen.cpp, which doesn't depend on anything else so
+// it can be built into the tests.
+
+// Find the index of an interface, from zero to GetInterfaceCount(). This uses a perfect hash generated by
+// the stub generator, so it's cheap enough to call every time an app looks an interface up.
+// name - The name of the interface, which may be prefixed with "FnTable:"
+// fnTable - If supplied, set to whether the name was for the FnTable version of the interface
+// Returns -1 for unknown interfaces
+int GetInterfaceIndexByName(const char* name, bool* fnTable = nullptr);
+int GetInterfaceCount();
+
+// Get the name of an interface (without the "FnTable:" prefix) from its index
+const char* GetInterfaceNameByIndex(int index);
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseCommon.h"
+#include "InterfaceHash.h"
 
 // Note we return void* not CVRCommon* - that's due to vtable magic.
 // Since our interfaces don't use CVRCommon as their first ancestor, this
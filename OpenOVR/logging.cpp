@@ -238,7 +238,7 @@ void oovr_soft_abort_raw(const char* file, long line, const char* func, int* cou
 
 	// Otherwise, if we're in debug mode do a hard abort. Otherwise log and continue.
 	// TODO fix this
-	if (oovr_global_configuration.StopOnSoftAbort()) {
+	if (oovr_global_configuration->StopOnSoftAbort()) {
 		oovr_abort_raw_va(file, line, func, msg, "OpenComposite Debug Error", args);
 	}
 
@@ -12,6 +12,7 @@
 
 // Fonts
 #define RES_O_FNT_UBUNTU 3
+#define RES_O_FNT_UBUNTU_TEXTURE 5
 
 // Keyboard layouts
 #define RES_O_KB_EN_GB 4
@@ -22,4 +23,5 @@
 	f(RES_O_HAND_LEFT) \
 	f(RES_O_HAND_RIGHT) \
 	f(RES_O_FNT_UBUNTU) \
+	f(RES_O_FNT_UBUNTU_TEXTURE) \
 	f(RES_O_KB_EN_GB) // clang-format on
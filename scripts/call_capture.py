@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+
+# Reads the OpenVR call captures written when the captureOpenVRCalls option is set.
+#
+# By default this prints a summary of each frame (the time between WaitGetPoses calls), and lists the calls
+# from any frame that took noticeably longer than usual - that's generally what's wanted when tracking down
+# a stutter. With --calls, every call is printed along with its arguments, return value and whatever it wrote to
+# its out-parameters.
+#
+# See OpenOVR/Misc/CallProfiler.cpp for the file format.
+
+import argparse
+import struct
+import sys
+from dataclasses import dataclass, field
+from typing import BinaryIO, Dict, List, Optional
+
+CAPTURE_MAGIC = b"OCCAPT03"
+
+CAPTURE_FUNCTION = 1
+CAPTURE_CALL = 2
+CAPTURE_FRAME = 3
+
+# The struct formats for argument types which are passed by value. Enums (vr::E...) are always 32-bit.
+SCALAR_FORMATS = {
+    "bool": "?",
+    "char": "b",
+    "float": "f",
+    "double": "d",
+    "int": "i",
+    "int32_t": "i",
+    "uint32_t": "I",
+    "uint64_t": "Q",
+    "vr::TrackedDeviceIndex_t": "I",
+    "vr::SharedTextureHandle_t": "Q",
+    "vr::VRActionHandle_t": "Q",
+    "vr::VRActionSetHandle_t": "Q",
+    "vr::VRInputValueHandle_t": "Q",
+    "vr::VROverlayHandle_t": "Q",
+    "vr::PropertyContainerHandle_t": "Q",
+    "vr::PropertyTypeTag_t": "I",
+    "vr::VRNotificationId": "I",
+    "vr::ScreenshotHandle_t": "I",
+    "vr::TextureID_t": "i",
+    "vr::VRComponentProperties": "I",
+    "vr::PathHandle_t": "Q",
+}
+
+
+# Structs that are nothing but floats, such as the overlay transforms a game passes in, are shown as their values
+FLOAT_STRUCTS = {"vr::HmdMatrix34_t", "vr::HmdMatrix44_t", "vr::HmdVector2_t", "vr::HmdVector3_t", "vr::HmdColor_t",
+                 "vr::HmdQuad_t"}
+
+
+@dataclass
+class Function:
+    name: str
+    arg_types: List[str]
+    return_type: str
+    outputs: List[int]  # The indices of the arguments whose contents are recorded after the call
+
+
+@dataclass
+class Call:
+    function: Function
+    thread: int
+    start: int
+    duration: int
+    payload: bytes
+
+
+@dataclass
+class Frame:
+    start: int
+    calls: List[Call] = field(default_factory=list)
+
+
+class Reader:
+    def __init__(self, data: bytes):
+        self.data = data
+        self.pos = 0
+
+    def done(self) -> bool:
+        return self.pos >= len(self.data)
+
+    def read(self, fmt: str):
+        size = struct.calcsize("<" + fmt)
+        if self.pos + size > len(self.data):
+            raise EOFError()
+        values = struct.unpack_from("<" + fmt, self.data, self.pos)
+        self.pos += size
+        return values[0] if len(values) == 1 else values
+
+    def read_bytes(self, size: int) -> bytes:
+        if self.pos + size > len(self.data):
+            raise EOFError()
+        value = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def read_string(self) -> Optional[str]:
+        length = self.read("H")
+        if length == 0xffff:
+            return None
+        return self.read_bytes(length).decode("utf-8", "replace")
+
+
+def decode_value(reader: Reader, type_name: str) -> str:
+    type_name = type_name.strip()
+
+    if type_name == "const char*":
+        value = reader.read_string()
+        return "null" if value is None else repr(value)
+
+    if type_name == "const vr::Texture_t*":
+        handle, tex_type, colour_space, width, height, tex_format = reader.read("QiiIII")
+        if tex_type == -1:
+            return "null"
+        return (f"Texture(handle={handle:#x}, type={tex_type}, colourSpace={colour_space}, "
+                f"size={width}x{height}, format={tex_format})")
+
+    if type_name == "const vr::VRTextureBounds_t*":
+        bounds = reader.read("ffff")
+        if bounds == (-1, -1, -1, -1):
+            return "null"
+        return "Bounds(%g, %g, %g, %g)" % bounds
+
+    # Structs passed in through const pointers have their contents after their address, see Scope::WriteInput
+    if type_name.startswith("const ") and type_name.endswith("*") and type_name != "const void*":
+        address = reader.read("Q")
+        contents = decode_output(reader, type_name[len("const "):])
+        return contents if contents == "null" else f"{address:#x}->{contents}"
+
+    if type_name.endswith("*"):
+        return f"{reader.read('Q'):#x}"
+
+    fmt = SCALAR_FORMATS.get(type_name.replace("const ", ""))
+    if fmt is None and (type_name.startswith("vr::E") or "::E" in type_name):
+        fmt = "i"
+    if fmt is None:
+        raise ValueError(type_name)
+
+    return str(reader.read(fmt))
+
+
+def decode_output(reader: Reader, type_name: str) -> str:
+    """Decode the contents of an out-parameter (see Scope::Output), or of a struct that was passed in"""
+    length = reader.read("I")
+    if length == 0xffffffff:
+        return "null"
+    data = reader.read_bytes(length)
+
+    pointee = type_name.strip()[:-1].strip()
+    if pointee == "char":
+        return repr(data.decode("utf-8", "replace"))
+
+    # Show arrays of scalars (including single values) as their values, and structs as hex
+    fmt = SCALAR_FORMATS.get(pointee)
+    if fmt is None and (pointee.startswith("vr::E") or "::E" in pointee):
+        fmt = "i"
+    if pointee in FLOAT_STRUCTS:
+        fmt = "f"
+    if fmt is not None and length % struct.calcsize(fmt) == 0:
+        values = [str(v[0]) for v in struct.iter_unpack("<" + fmt, data)]
+        return values[0] if len(values) == 1 else "[" + ", ".join(values) + "]"
+
+    # Pose arrays and the like are big, and are rarely interesting byte-by-byte
+    if length > 64:
+        return f"<{data[:64].hex()}... {length} bytes>"
+    return "<" + data.hex() + ">"
+
+
+def describe_call(call: Call) -> str:
+    func = call.function
+    reader = Reader(call.payload)
+
+    # Structs passed by value aren't listed above, so stop decoding if one turns up and show the rest as hex
+    parts = []
+    outputs = []
+    try:
+        for arg in func.arg_types:
+            parts.append(decode_value(reader, arg))
+        result = "" if func.return_type == "void" else " -> " + decode_value(reader, func.return_type)
+        for index in func.outputs:
+            outputs.append(f"arg{index}={decode_output(reader, func.arg_types[index])}")
+    except (ValueError, EOFError):
+        parts.append("<" + call.payload[reader.pos:].hex() + ">")
+        result = ""
+
+    outputs_str = " [" + ", ".join(outputs) + "]" if outputs else ""
+    return f"{func.name}({', '.join(parts)}){result}{outputs_str}"
+
+
+def read_capture(fi: BinaryIO) -> List[Frame]:
+    reader = Reader(fi.read())
+    if reader.read_bytes(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+        raise RuntimeError("Not an OpenVR call capture, or from an incompatible version of OpenComposite")
+
+    functions: Dict[int, Function] = dict()
+    frame_starts = [0]
+
+    # Each thread's calls are written out in batches, so a call can come before its function's record, and calls
+    # aren't in time order. Collect everything first, then sort the calls into their frames.
+    raw_calls = []
+
+    # The game might have crashed halfway through a record, so stop quietly if the file is cut short
+    try:
+        while not reader.done():
+            record = reader.read("B")
+            if record == CAPTURE_FUNCTION:
+                func_id = reader.read("H")
+                name = reader.read_string()
+                args, return_type = reader.read_string().rsplit(" -> ", 1)
+                arg_types = [a for a in args.split(", ") if a]
+                outputs = [int(i) for i in reader.read_string().split(",") if i]
+                functions[func_id] = Function(name, arg_types, return_type, outputs)
+            elif record == CAPTURE_CALL:
+                func_id, thread, start, duration, length = reader.read("HIQII")
+                raw_calls.append((func_id, thread, start, duration, reader.read_bytes(length)))
+            elif record == CAPTURE_FRAME:
+                frame_starts.append(reader.read("Q"))
+            else:
+                raise RuntimeError(f"Unknown record type {record} at offset {reader.pos - 1}")
+    except EOFError:
+        print("Warning: capture is truncated", file=sys.stderr)
+
+    frame_starts.sort()
+    frames = [Frame(start) for start in frame_starts]
+
+    # If the capture was cut off, the last batch of calls might be missing their function's record
+    raw_calls = [c for c in raw_calls if c[0] in functions]
+    raw_calls.sort(key=lambda c: c[2])
+
+    frame = 0
+    for func_id, thread, start, duration, payload in raw_calls:
+        while frame + 1 < len(frames) and frames[frame + 1].start <= start:
+            frame += 1
+        frames[frame].calls.append(Call(functions[func_id], thread, start, duration, payload))
+
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Read an OpenVR call capture from OpenComposite")
+    parser.add_argument("capture", type=argparse.FileType("rb"))
+    parser.add_argument("--calls", action="store_true", help="print every call, not just those in slow frames")
+    parser.add_argument("--slow", type=float, default=1.5,
+                        help="how many times longer than the median a frame must be to count as slow")
+    args = parser.parse_args()
+
+    frames = read_capture(args.capture)
+
+    # The last frame is still in progress, so it doesn't have a length
+    lengths = [b.start - a.start for a, b in zip(frames, frames[1:])]
+    median = sorted(lengths)[len(lengths) // 2] if lengths else 0
+
+    for i, frame in enumerate(frames):
+        length = lengths[i] if i < len(lengths) else None
+        slow = length is not None and i > 0 and length > median * args.slow
+        length_str = f"{length / 1e6:.2f}ms" if length is not None else "unfinished"
+        call_time = sum(c.duration for c in frame.calls)
+
+        print(f"Frame {i}: {length_str}, {len(frame.calls)} calls taking {call_time / 1e6:.3f}ms"
+              + (" - SLOW" if slow else ""))
+
+        if args.calls or slow:
+            for call in frame.calls:
+                offset = (call.start - frame.start) / 1e6
+                print(f"  +{offset:8.3f}ms {call.duration / 1e3:9.1f}us thread {call.thread}: {describe_call(call)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -90,6 +90,7 @@ with open(output_dir / "stubs.gen.cpp", "w", newline='\n') as impl:
     impl.write('#include "Reimpl/Interfaces.h"\n')
     impl.write(f'#include "{bases_header_fn.name}"\n')
     impl.write('#include "Misc/Config.h"\n')
+    impl.write('#include "Misc/CallProfiler.h"\n')
 
     for iface in interfaces:
         codegen.write_stubs(impl, iface)
@@ -97,6 +98,10 @@ with open(output_dir / "stubs.gen.cpp", "w", newline='\n') as impl:
     # Write the CreateInterfaceByName code
     codegen.write_stub_footer(impl, interfaces)
 
+# Write the perfect hash used to look interfaces up by name
+with open(output_dir / "interface_hash.gen.cpp", "w", newline='\n') as hash_impl:
+    codegen.write_interface_hash(hash_impl, interfaces)
+
 # Generate the bases header file
 # This contains getter declarations so various bits of code can get access to the base classes
 with open(bases_header_fn, "w", newline='\n') as bases_header:
@@ -1,11 +1,15 @@
 import re
-from typing import List
+from typing import List, Optional
 
-from stubs.interface import InterfaceDef
+from stubs.interface import Function, InterfaceDef
 from stubs.interface_spec import InterfaceSpec
 
 cflag_spec = re.compile(r"\[(?P<name>\w+)\]\s*=\s*(?P<value>.*)")
 
+# The names OpenVR gives an argument that says how big the struct before it is, such as uncbVREvent,
+# unSizeOfVRSelectedActionSet_t, unControllerStateSize and nStatsSizeInBytes
+struct_size_name = re.compile(r"^u?n?(cb|SizeOf)|Size(InBytes)?$")
+
 
 def write_header(filename, iface):
     header = open(filename, "w", newline='\n')
@@ -104,10 +108,47 @@ std::shared_ptr<{cls}> GetCreate{getter_name}() {{
             if namespace in f.return_type:
                 return_str += f" ({f.return_type})"
 
+            call_str = f"base->{f.name}({nargs})"
+
+            # The argument types are written into call captures, so the arguments can be decoded
+            arg_types = ", ".join(a.type for a in f.args)
+
+            # Find the out-parameters, which are recorded after the call
+            outputs = [(i, _profiler_output(f, i)) for i in range(len(f.args))]
+            outputs = [(i, o) for i, o in outputs if o]
+            output_indices = ",".join(str(i) for i, _ in outputs)
+
+            # The profiler's flag is checked before anything else, so the static Function isn't even initialised
+            # unless it's in use.
             fi.write(f"{f.return_type} {cname}::{f.name}({f.args_str()}) {{\n"
-                     "\tif (oovr_global_configuration.LogAllOpenVRCalls())\n"
+                     "\tif (oovr_global_configuration->LogAllOpenVRCalls())\n"
                      f"\t\tOOVR_LOG(\"Entered function (from interface {ver.namespace()})\");\n"
-                     f"\t{return_str} base->{f.name}({nargs});\n}}\n")
+                     "\tif (CallProfiler::IsActive()) {\n"
+                     f"\t\tstatic CallProfiler::Function profile_function(\"{ver.namespace()}::{f.name}\", "
+                     f"\"{arg_types} -> {f.return_type}\", \"{output_indices}\");\n"
+                     "\t\tCallProfiler::Scope profile_scope(profile_function);\n")
+            if f.args:
+                profiler_args = ", ".join(_profiler_input(f, i) for i in range(len(f.args)))
+                fi.write(f"\t\tprofile_scope.Arguments({profiler_args});\n")
+
+            if not outputs:
+                # Pass the return value through the profiler, so it can be captured
+                profiled_call_str = call_str
+                if f.return_type != "void":
+                    profiled_call_str = f"profile_scope.Returned({call_str})"
+                fi.write(f"\t\t{return_str} {profiled_call_str};\n")
+            else:
+                # The out-parameters come after the return value, so it has to be kept around
+                if f.return_type != "void":
+                    fi.write(f"\t\tauto result = {call_str};\n\t\tprofile_scope.Returned(result);\n")
+                else:
+                    fi.write(f"\t\t{call_str};\n")
+                for _, output in outputs:
+                    fi.write(f"\t\t{output};\n")
+                fi.write(f"\t\t{return_str} result;\n" if f.return_type != "void" else "\t\treturn;\n")
+
+            fi.write("\t}\n")
+            fi.write(f"\t{return_str} {call_str};\n}}\n")
 
         # Generate the fntable
         _build_fntable(fi, ver)
@@ -116,6 +157,109 @@ std::shared_ptr<{cls}> GetCreate{getter_name}() {{
         fi.write(f"void {cname}::Delete() {{ delete this; }}\n")
 
 
+def _profiler_output(f: Function, index: int) -> Optional[str]:
+    """
+    Find how to record the contents of an out-parameter in a call capture, or None if this argument isn't one.
+
+    Any non-const pointer is treated as an out-parameter, and its size comes from the OpenVR headers' annotations.
+    Where they're missing, strings are assumed to be followed by their buffer size (as they are everywhere in
+    OpenVR). Structs may have been built against an older, smaller version of the headers, so if the next argument
+    looks like the struct's size, no more than that is read from each element.
+    """
+    arg = f.args[index]
+    arg_type = arg.type.strip()
+    if not arg_type.endswith("*") or arg_type.startswith("const "):
+        return None
+    pointee = arg_type[:-1].strip()
+
+    next_arg = f.args[index + 1] if index + 1 < len(f.args) else None
+    next_is_size = next_arg is not None and next_arg.type.strip() == "uint32_t"
+    next_is_struct_size = next_is_size and struct_size_name.search(next_arg.name) is not None
+
+    def count_of(annotation: str) -> Optional[str]:
+        return _annotated_count(f, index, annotation)
+
+    if pointee == "char":
+        return f"profile_scope.OutputString({arg.name}, {next_arg.name})" if next_is_size else None
+
+    buffer_count = count_of("VR_OUT_BUFFER_COUNT")
+    if buffer_count:
+        return f"profile_scope.OutputBuffer({arg.name}, {buffer_count})"
+
+    # Other untyped buffers are usually image data, which isn't worth capturing. Graphics API objects (such as
+    # VkInstance_T) are opaque, and are only ever passed in.
+    if pointee == "void" or pointee.startswith(("Vk", "ID3D")):
+        return None
+
+    array_count = count_of("VR_(?:OUT_)?ARRAY_COUNT")
+    if array_count and next_is_struct_size:
+        return f"profile_scope.Output({arg.name}, {array_count}, {next_arg.name})"
+    if array_count:
+        return f"profile_scope.Output({arg.name}, {array_count})"
+
+    if next_is_struct_size:
+        return f"profile_scope.Output({arg.name}, 1, {next_arg.name})"
+
+    return f"profile_scope.Output({arg.name})"
+
+
+def _profiler_input(f: Function, index: int) -> str:
+    """
+    Find what to pass to Scope::Arguments for an argument. Structs passed in through const pointers are recorded
+    in full by Scope::Write, so arrays of them (and of enums) are wrapped in an InputArray to say how many there
+    are. As with out-parameters, a struct's size is taken from the next argument if it looks like one.
+    """
+    arg = f.args[index]
+    arg_type = arg.type.strip()
+    if not arg_type.startswith("const ") or not arg_type.endswith("*"):
+        return arg.name
+    pointee = arg_type[len("const "):-1].strip()
+
+    # Strings and textures have their own formats, and untyped buffers are only recorded by their address
+    if pointee in ("char", "void", "vr::Texture_t", "vr::VRTextureBounds_t"):
+        return arg.name
+
+    # VREvent_t has changed size between SDK versions, and PostOverlayEvent isn't told which one the game has, so
+    # reading a whole one could run off the end of the game's
+    if pointee == "vr::VREvent_t":
+        return f"CallProfiler::InputArray({arg.name}, 0)"
+
+    next_arg = f.args[index + 1] if index + 1 < len(f.args) else None
+    struct_size = None
+    if next_arg is not None and next_arg.type.strip() == "uint32_t" and struct_size_name.search(next_arg.name):
+        struct_size = next_arg.name
+
+    # Where the count isn't annotated, it sometimes comes straight after the struct size (GetComponentStateForBinding)
+    count = _annotated_count(f, index, "VR_ARRAY_COUNT")
+    after_size = f.args[index + 2] if struct_size and index + 2 < len(f.args) else None
+    if not count and after_size is not None and after_size.type.strip() == "uint32_t" and after_size.name.endswith("Count"):
+        count = after_size.name
+
+    if count and struct_size:
+        return f"CallProfiler::InputArray({arg.name}, {count}, {struct_size})"
+    if count:
+        return f"CallProfiler::InputArray({arg.name}, {count})"
+    if struct_size:
+        return f"CallProfiler::InputArray({arg.name}, 1, {struct_size})"
+    return arg.name
+
+
+def _annotated_count(f: Function, index: int, annotation: str) -> Optional[str]:
+    """Find the argument that the OpenVR headers say holds the length of an array, if there is one"""
+    arg = f.args[index]
+    arg_names = [a.name for a in f.args]
+    match = re.search(annotation + r"\s*\(\s*(\w+)\s*\)", arg.str)
+    if not match or match.group(1) not in arg_names:
+        return None
+    count = match.group(1)
+
+    # Some functions say how many items they wrote through a pointer, see GetLiveCollisionBoundsInfo
+    count_arg = f.args[arg_names.index(count)]
+    if count_arg.type.strip().endswith("*"):
+        return f"{count} ? *{count} : 0"
+    return count
+
+
 def _build_fntable(fi, ver: InterfaceDef):
     cname = ver.proxy_class_name()
     prefix = f"fntable_{ver.varname()}_{ver.version}"
@@ -197,3 +341,125 @@ def write_stub_footer(fi, interfaces: List[InterfaceSpec]):
     fi.write("\tif(success) *success = false;\n")
     fi.write("\treturn 0;\n")
     fi.write("}\n")
+
+
+# The FNV-1a hash, which the generated code also uses. The seed replaces the usual offset basis, to get
+# different hashes for the displacement step.
+_FNV_OFFSET_BASIS = 0x811c9dc5
+_FNV_PRIME = 0x01000193
+
+
+def _fnv1a(seed: int, text: str) -> int:
+    value = seed
+    for c in text.encode("ascii"):
+        value = ((value ^ c) * _FNV_PRIME) & 0xffffffff
+    return value
+
+
+def _next_pow2(value: int) -> int:
+    result = 1
+    while result < value:
+        result *= 2
+    return result
+
+
+def _build_perfect_hash(names: List[str]):
+    """
+    Build a perfect hash over the names with the hash-and-displace method: each name is first put into a bucket,
+    then each bucket gets a seed which hashes all its names into unused slots. Finding a name is then always
+    two hashes and a single string comparison, no matter how many names there are.
+
+    Returns the list of seeds (one per bucket) and the list of slots (with the index into names, or None).
+    """
+    bucket_count = _next_pow2(max(len(names) // 2, 1))
+    slot_count = _next_pow2(len(names) * 2)
+
+    buckets = [[] for _ in range(bucket_count)]
+    for i, name in enumerate(names):
+        buckets[_fnv1a(_FNV_OFFSET_BASIS, name) & (bucket_count - 1)].append(i)
+
+    seeds = [0] * bucket_count
+    slots = [None] * slot_count
+
+    # Place the biggest buckets first, while there's the most space left
+    for bucket_id in sorted(range(bucket_count), key=lambda b: len(buckets[b]), reverse=True):
+        bucket = buckets[bucket_id]
+        if not bucket:
+            break
+
+        seed = 1
+        while True:
+            wanted = [_fnv1a(seed, names[i]) & (slot_count - 1) for i in bucket]
+            if len(set(wanted)) == len(wanted) and all(slots[slot] is None for slot in wanted):
+                break
+            seed += 1
+
+        seeds[bucket_id] = seed
+        for i, slot in zip(bucket, wanted):
+            slots[slot] = i
+
+    return seeds, slots
+
+
+def write_interface_hash(fi, interfaces: List[InterfaceSpec]):
+    # Some apps look their interfaces up every frame (or even every call, with FnTable interfaces), so generate
+    # a perfect hash to find them quickly rather than going through all the names one by one.
+    # This goes in its own file, with no dependencies on the rest of OpenComposite, so the tests can use it.
+    versions = [ver for spec in interfaces for ver in spec.versions]
+
+    fi.write("#include \"Reimpl/InterfaceHash.h\"\n")
+    fi.write("#include <stdint.h>\n")
+    fi.write("#include <string.h>\n\n")
+
+    fi.write("static const char *const interfaceNames[] = {\n")
+    for ver in versions:
+        fi.write(f"\t\"{ver.version_string}\",\n")
+    fi.write("};\n")
+
+    names = []
+    for index, ver in enumerate(versions):
+        names.append((ver.version_string, index, False))
+        names.append(("FnTable:" + ver.version_string, index, True))
+
+    seeds, slots = _build_perfect_hash([name for name, _, _ in names])
+
+    fi.write("// Get interface index by name\n")
+    fi.write("struct InterfaceHashSlot {\n\tconst char *name;\n\tint index;\n\tbool fnTable;\n};\n")
+
+    fi.write("static const uint32_t interfaceHashSeeds[] = {\n")
+    for seed in seeds:
+        fi.write(f"\t{seed}u,\n")
+    fi.write("};\n")
+
+    fi.write("static const InterfaceHashSlot interfaceHashSlots[] = {\n")
+    for slot in slots:
+        if slot is None:
+            fi.write("\t{ NULL, -1, false },\n")
+        else:
+            name, index, fn_table = names[slot]
+            fi.write(f"\t{{ \"{name}\", {index}, {'true' if fn_table else 'false'} }},\n")
+    fi.write("};\n")
+
+    fi.write(f"""
+static uint32_t InterfaceNameHash(uint32_t seed, const char *name) {{
+    uint32_t hash = seed;
+    for (const char *c = name; *c; c++)
+        hash = (hash ^ (uint8_t) *c) * {_FNV_PRIME:#010x}u;
+    return hash;
+}}
+int GetInterfaceIndexByName(const char *name, bool *fnTable) {{
+    uint32_t seed = interfaceHashSeeds[InterfaceNameHash({_FNV_OFFSET_BASIS:#010x}u, name) & {len(seeds) - 1}];
+    const InterfaceHashSlot &slot = interfaceHashSlots[InterfaceNameHash(seed, name) & {len(slots) - 1}];
+    if (!slot.name || strcmp(slot.name, name) != 0)
+        return -1;
+    if (fnTable)
+        *fnTable = slot.fnTable;
+    return slot.index;
+}}
+int GetInterfaceCount() {{ return {len(versions)}; }}
+const char *GetInterfaceNameByIndex(int index) {{
+    if (index < 0 || index >= {len(versions)})
+        return NULL;
+    return interfaceNames[index];
+}}
+""".replace("    ", "\t").lstrip())
@@ -1,4 +1,5 @@
 from dataclasses import dataclass
+import re
 import typing
 from typing import List
 
@@ -15,6 +16,7 @@ class InterfaceDef:
     """
     name: str
     version: str
+    version_string: str
     flags: List[str]
     spec: 'InterfaceSpec'
     functions: List['Function']
@@ -34,6 +36,7 @@ class InterfaceDef:
         self.flags = flags
         self.spec = spec
         self.functions = _read_headers(self)
+        self.version_string = _read_version_string(self)
         print(version, name, flags)
         super().__init__()
         pass
@@ -175,6 +178,23 @@ def _read_headers(interface: InterfaceDef) -> List[Function]:
     return funcs
 
 
+def _read_version_string(interface: InterfaceDef) -> str:
+    """
+    Find the string apps pass to VR_GetGenericInterface for this interface, such as IVRSystem_022. This is
+    needed to build the perfect hash used to look interfaces up by name.
+    """
+    filename = interface.header_prefix() / interface.header_filename()
+    pattern = re.compile(r"\b%s_Version\s*=\s*\"(?P<version>[^\"]+)\"" % interface.interface())
+
+    with open(filename) as f:
+        for line in f:
+            match = pattern.search(line)
+            if match:
+                return match.group("version")
+
+    raise RuntimeError(f"Could not find the version string for {interface.namespace()} in {filename}")
+
+
 # The global context - that's all the types from vrtypes.h and similar files
 _global_ctx = None
 
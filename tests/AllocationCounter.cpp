@@ -0,0 +1,35 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// Everything is built with hidden visibility, so these have to be exported explicitly to replace the standard
+// operator new and delete for the shared libraries too
+#define ALLOC_EXPORT __attribute__((visibility("default")))
+
+static std::atomic<uint64_t> allocations{ 0 };
+
+ALLOC_EXPORT void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+ALLOC_EXPORT void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+ALLOC_EXPORT void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+uint64_t GetAllocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+// Counts every allocation made through operator new in the process, including those made by vrclient.so and the
+// mock runtime. Link AllocationCounter.cpp into the executable, and set ENABLE_EXPORTS on it so the shared
+// libraries pick up its operator new rather than the standard one.
+uint64_t GetAllocationCount();
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Misc/SkeletonCodec.h"
+
+#include <math.h>
+#include <random>
+
+// Generates hand poses for the skeleton codec tests and benchmark, starting from the codec's reference pose
+namespace hand_poses {
+
+using skeleton_codec::BONE_COUNT;
+
+inline vr::HmdQuaternionf_t Multiply(const vr::HmdQuaternionf_t& a, const vr::HmdQuaternionf_t& b)
+{
+	vr::HmdQuaternionf_t out;
+	out.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+	out.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+	out.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+	out.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+	return out;
+}
+
+inline vr::HmdQuaternionf_t AxisAngle(float x, float y, float z, float angle)
+{
+	float length = sqrtf(x * x + y * y + z * z);
+	float s = sinf(angle / 2) / length;
+	return vr::HmdQuaternionf_t{ cosf(angle / 2), x * s, y * s, z * s };
+}
+
+// The angle between two rotations, in degrees
+inline float AngleBetween(const vr::HmdQuaternionf_t& a, const vr::HmdQuaternionf_t& b)
+{
+	double dot = (double)a.w * b.w + (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+	double lengths = sqrt(((double)a.w * a.w + (double)a.x * a.x + (double)a.y * a.y + (double)a.z * a.z)
+	    * ((double)b.w * b.w + (double)b.x * b.x + (double)b.y * b.y + (double)b.z * b.z));
+	double cosHalf = fmin(fabs(dot) / lengths, 1.0);
+	return (float)(2 * acos(cosHalf) * 180 / M_PI);
+}
+
+inline float DistanceBetween(const vr::HmdVector4_t& a, const vr::HmdVector4_t& b)
+{
+	float x = a.v[0] - b.v[0], y = a.v[1] - b.v[1], z = a.v[2] - b.v[2];
+	return sqrtf(x * x + y * y + z * z);
+}
+
+inline vr::HmdQuaternionf_t RandomRotation(std::mt19937& rng, float maxAngle)
+{
+	std::normal_distribution<float> axis;
+	std::uniform_real_distribution<float> angle(0, maxAngle);
+	return AxisAngle(axis(rng), axis(rng), axis(rng), angle(rng));
+}
+
+// Sets the aux bones as BaseInput does, to the distal bones in model space
+inline void WriteAuxBones(vr::VRBoneTransform_t* bones)
+{
+	static const int sources[] = { 4, 9, 14, 19, 24 };
+
+	vr::VRBoneTransform_t modelSpace[BONE_COUNT];
+	skeleton_codec::ParentToModelSpace(bones, modelSpace);
+	for (int i = 0; i < 5; i++)
+		bones[26 + i] = modelSpace[sources[i]];
+}
+
+/**
+ * Makes a hand pose with the fingers curled by the given amount (zero is the reference pose, one is a fist) and
+ * scaled to a different hand size. Tracking noise is then added to each finger bone, and the wrist is moved
+ * around if wristNoise is set.
+ */
+inline void MakePose(std::mt19937& rng, bool isRight, float curl, float scale, float rotationNoise, float positionNoise, bool wristNoise,
+    vr::VRBoneTransform_t* bones)
+{
+	skeleton_codec::GetReferencePose(isRight, bones);
+
+	std::uniform_real_distribution<float> offset(-positionNoise, positionNoise);
+
+	for (int i = 2; i < 26; i++) {
+		vr::VRBoneTransform_t& bone = bones[i];
+
+		// Don't curl the metacarpals or the tips
+		bool metacarpal = i == 2 || i == 6 || i == 11 || i == 16 || i == 21;
+		bool tip = i == 5 || i == 10 || i == 15 || i == 20 || i == 25;
+		if (!metacarpal && !tip)
+			bone.orientation = Multiply(bone.orientation, AxisAngle(0, 0, 1, curl * 1.4f));
+
+		bone.orientation = Multiply(bone.orientation, RandomRotation(rng, rotationNoise));
+
+		for (int axis = 0; axis < 3; axis++)
+			bone.position.v[axis] = bone.position.v[axis] * scale + offset(rng);
+	}
+
+	if (wristNoise) {
+		std::uniform_real_distribution<float> wristOffset(-0.2f, 0.2f);
+		bones[1].orientation = Multiply(bones[1].orientation, RandomRotation(rng, (float)M_PI));
+		for (int axis = 0; axis < 3; axis++)
+			bones[1].position.v[axis] += wristOffset(rng);
+	}
+
+	WriteAuxBones(bones);
+}
+
+} // namespace hand_poses
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+#include "Reimpl/InterfaceHash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// Compares looking interfaces up with the generated perfect hash against the std::map and strcmp chain that
+// VR_GetGenericInterface and CreateInterfaceByName used before it
+
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+static std::vector<std::string> interfaceNames;
+static std::map<std::string, int> interfaceMap;
+
+// The same as the generated CreateInterfaceByName, which checks every name in turn
+static NOINLINE int FindByStrcmp(const char* name)
+{
+	const char* prefix = "FnTable:";
+	if (strncmp(name, prefix, strlen(prefix)) == 0)
+		name += strlen(prefix);
+
+	for (size_t i = 0; i < interfaceNames.size(); i++) {
+		if (strcmp(interfaceNames[i].c_str(), name) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+static NOINLINE int FindByMap(const char* name)
+{
+	auto iter = interfaceMap.find(name);
+	return iter == interfaceMap.end() ? -1 : iter->second;
+}
+
+template <typename F>
+static double Time(const std::vector<std::string>& lookups, int iterations, F find)
+{
+	int total = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		for (const std::string& name : lookups)
+			total += find(name.c_str());
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	// Stop the lookups being optimised out
+	if (total == 12345)
+		printf("\n");
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / ((double)iterations * lookups.size());
+}
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+
+	for (int i = 0; i < GetInterfaceCount(); i++) {
+		interfaceNames.push_back(GetInterfaceNameByIndex(i));
+		interfaceMap[interfaceNames.back()] = i;
+		interfaceMap["FnTable:" + interfaceNames.back()] = i;
+	}
+
+	// Games mostly ask for the latest versions, which are at the end of the chain, so test every name equally
+	std::vector<std::string> known, fnTables, unknown;
+	for (const std::string& name : interfaceNames) {
+		known.push_back(name);
+		fnTables.push_back("FnTable:" + name);
+		unknown.push_back(name.substr(0, name.size() - 1) + "9");
+	}
+
+	std::mt19937 rng(1234);
+	for (auto* names : { &known, &fnTables, &unknown })
+		std::shuffle(names->begin(), names->end(), rng);
+
+	printf("%d interfaces\n", GetInterfaceCount());
+	printf("%-12s %12s %12s %12s\n", "names", "hash ns", "map ns", "strcmp ns");
+
+	struct Set {
+		const char* name;
+		const std::vector<std::string>* lookups;
+	};
+	for (const Set& set : { Set{ "interfaces", &known }, Set{ "FnTables", &fnTables }, Set{ "unknown", &unknown } }) {
+		double hash = Time(*set.lookups, iterations, [](const char* name) { return GetInterfaceIndexByName(name); });
+		double map = Time(*set.lookups, iterations, FindByMap);
+		double chain = Time(*set.lookups, iterations, FindByStrcmp);
+		printf("%-12s %12.1f %12.1f %12.1f\n", set.name, hash, map, chain);
+	}
+
+	return 0;
+}
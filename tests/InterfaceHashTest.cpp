@@ -0,0 +1,49 @@
+#include "stdafx.h"
+
+#include "Reimpl/InterfaceHash.h"
+#include "TestUtil.h"
+
+#include <set>
+#include <string.h>
+#include <string>
+
+// Checks the generated perfect hash finds every interface, with and without the FnTable: prefix, and nothing else
+
+int main()
+{
+	int count = GetInterfaceCount();
+	CHECK(count > 0);
+
+	std::set<std::string> seen;
+	for (int i = 0; i < count; i++) {
+		const char* name = GetInterfaceNameByIndex(i);
+		CHECKF(name != nullptr, "interface %d", i);
+		if (!name)
+			continue;
+
+		CHECKF(seen.insert(name).second, "%s is listed twice", name);
+
+		bool fnTable = true;
+		CHECKF(GetInterfaceIndexByName(name, &fnTable) == i, "%s", name);
+		CHECKF(!fnTable, "%s", name);
+
+		std::string fnTableName = std::string("FnTable:") + name;
+		fnTable = false;
+		CHECKF(GetInterfaceIndexByName(fnTableName.c_str(), &fnTable) == i, "%s", fnTableName.c_str());
+		CHECKF(fnTable, "%s", fnTableName.c_str());
+
+		// Near misses must not match, even if they hash to the same slot
+		std::string truncated(name, strlen(name) - 1);
+		CHECKF(GetInterfaceIndexByName(truncated.c_str()) == -1, "%s", truncated.c_str());
+		CHECKF(GetInterfaceIndexByName((std::string(name) + "0").c_str()) == -1, "%s0", name);
+		CHECKF(GetInterfaceIndexByName(("FnTable" + std::string(name)).c_str()) == -1, "FnTable%s", name);
+	}
+
+	CHECK(GetInterfaceNameByIndex(-1) == nullptr);
+	CHECK(GetInterfaceNameByIndex(count) == nullptr);
+
+	for (const char* unknown : { "", "FnTable:", "IVRSystem_000", "IVRFoo_001", "ivrsystem_019" })
+		CHECKF(GetInterfaceIndexByName(unknown) == -1, "'%s'", unknown);
+
+	return testResult();
+}
@@ -0,0 +1,228 @@
+#include "stdafx.h"
+
+#include "Misc/MailboxRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Measures how fast messages get through a mailbox ring, with the sender on another thread in the same process
+// and in a second process. Throughput is how many messages a sender can push through while the reader keeps up.
+// Latency is the round trip of a message that's bounced back through a second ring, with both readers either
+// polling (as a game calling ReadMessage every frame does) or sleeping in Wait until they're woken.
+//
+// The peer - the thread or process on the other end - takes its orders through the rings too, so the same code
+// runs both ways. Every message is checked on the way, so this doubles as a test of the ring.
+
+static const uint32_t MESSAGE_SIZES[] = { 64, 1024, MailboxRing::MAX_MESSAGE_LENGTH };
+
+// Read one message, either polling for it or sleeping until it arrives, and copy it out as ReadMessage would
+static uint32_t Receive(MailboxRing& ring, bool sleep, char* buffer)
+{
+	const char* message;
+	uint32_t length;
+	while (!ring.Peek(&message, &length)) {
+		if (sleep)
+			ring.Wait(std::chrono::milliseconds(100));
+		else
+			std::this_thread::yield();
+	}
+
+	memcpy(buffer, message, length);
+	buffer[length] = 0;
+	ring.Pop();
+	return length;
+}
+
+static void Send(MailboxRing& ring, const char* message, uint32_t length)
+{
+	// The ring only fills up when the reader falls behind, so give it a chance to catch up
+	while (!ring.Push(message, length))
+		std::this_thread::yield();
+}
+
+// The other end: runs the orders sent to it until it's told to quit. Returns false if anything arrived damaged.
+static bool RunPeer(const std::string& toPeerName, const std::string& fromPeerName)
+{
+	std::unique_ptr<MailboxRing> in = MailboxRing::Open(toPeerName);
+	std::unique_ptr<MailboxRing> out = MailboxRing::Open(fromPeerName);
+	if (!in || !out || !in->ClaimReader()) {
+		fprintf(stderr, "The peer couldn't open its rings\n");
+		return false;
+	}
+
+	std::vector<char> message(MailboxRing::MAX_MESSAGE_LENGTH + 1);
+	std::vector<char> buffer(MailboxRing::MAX_MESSAGE_LENGTH + 1);
+	bool ok = true;
+
+	while (true) {
+		Receive(*in, true, buffer.data());
+
+		unsigned int size, count, sleep;
+		if (sscanf(buffer.data(), "send %u %u", &size, &count) == 2) {
+			memset(message.data(), 'm', size);
+			for (uint32_t i = 0; i < count; i++)
+				Send(*out, message.data(), size);
+		} else if (sscanf(buffer.data(), "echo %u %u", &count, &sleep) == 2) {
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t length = Receive(*in, sleep != 0, buffer.data());
+				Send(*out, buffer.data(), length);
+			}
+		} else if (strcmp(buffer.data(), "quit") == 0) {
+			break;
+		} else {
+			fprintf(stderr, "The peer got an unknown order '%s'\n", buffer.data());
+			ok = false;
+			break;
+		}
+	}
+
+	in->ReleaseReader();
+	return ok;
+}
+
+struct Results {
+	std::vector<std::string> throughput;
+	std::vector<std::string> latency;
+};
+
+static void SendOrder(MailboxRing& toPeer, const char* format, unsigned int a, unsigned int b)
+{
+	char order[64];
+	snprintf(order, sizeof(order), format, a, b);
+	Send(toPeer, order, (uint32_t)strlen(order));
+}
+
+static bool RunAgainstPeer(const char* where, MailboxRing& toPeer, MailboxRing& fromPeer, uint32_t count, Results* results)
+{
+	std::vector<char> buffer(MailboxRing::MAX_MESSAGE_LENGTH + 1);
+	char line[128];
+
+	for (uint32_t size : MESSAGE_SIZES) {
+		auto start = std::chrono::steady_clock::now();
+		SendOrder(toPeer, "send %u %u", size, count);
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t length = Receive(fromPeer, true, buffer.data());
+			if (length != size || buffer[0] != 'm' || buffer[length - 1] != 'm') {
+				fprintf(stderr, "Message %u from the %s is %u bytes, expected %u\n", i, where, length, size);
+				return false;
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		snprintf(line, sizeof(line), "%-8s %8u %14.0f %10.1f", where, size, count / seconds, count * (double)size / seconds / 1e6);
+		results->throughput.push_back(line);
+	}
+
+	for (bool sleep : { false, true }) {
+		SendOrder(toPeer, "echo %u %u", count, sleep);
+
+		std::vector<double> roundTrips(count);
+		for (uint32_t i = 0; i < count; i++) {
+			char ping[32];
+			int length = snprintf(ping, sizeof(ping), "ping %u", i);
+
+			auto start = std::chrono::steady_clock::now();
+			Send(toPeer, ping, (uint32_t)length);
+			Receive(fromPeer, sleep, buffer.data());
+			roundTrips[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			if (strcmp(buffer.data(), ping) != 0) {
+				fprintf(stderr, "Sent '%s' to the %s, got back '%s'\n", ping, where, buffer.data());
+				return false;
+			}
+		}
+
+		double total = 0;
+		for (double ns : roundTrips)
+			total += ns;
+		std::sort(roundTrips.begin(), roundTrips.end());
+
+		snprintf(line, sizeof(line), "%-8s %-8s %12.0f %12.0f %12.0f", where, sleep ? "wait" : "poll", total / count, roundTrips[count / 2],
+		    roundTrips[std::min(count - 1, count * 99 / 100)]);
+		results->latency.push_back(line);
+	}
+
+	Send(toPeer, "quit", 4);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = argc > 1 ? (uint32_t)atoi(argv[1]) : 20000;
+	if (count == 0) {
+		fprintf(stderr, "Usage: %s [messages per run]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Use names nothing else will, so a real mailbox can't get in the way
+	std::string prefix = "oc-benchmark-" + std::to_string(getpid());
+	std::string toPeerName = prefix + "-to-peer";
+	std::string fromPeerName = prefix + "-from-peer";
+
+	std::unique_ptr<MailboxRing> toPeer = MailboxRing::Open(toPeerName);
+	std::unique_ptr<MailboxRing> fromPeer = MailboxRing::Open(fromPeerName);
+	if (!toPeer || !fromPeer || !fromPeer->ClaimReader()) {
+		fprintf(stderr, "Couldn't set up the mailbox rings\n");
+		return EXIT_FAILURE;
+	}
+
+	Results results;
+	bool ok = true;
+
+	// One process, with the peer on a thread
+	{
+		bool peerOk = false;
+		std::thread peer([&]() { peerOk = RunPeer(toPeerName, fromPeerName); });
+		ok = RunAgainstPeer("thread", *toPeer, *fromPeer, count, &results);
+		if (!ok)
+			Send(*toPeer, "quit", 4);
+		peer.join();
+		ok = ok && peerOk;
+	}
+
+	// Two processes. The child opens the rings again by name, as another process sending to a mailbox would.
+	if (ok) {
+		pid_t child = fork();
+		if (child == 0)
+			_exit(RunPeer(toPeerName, fromPeerName) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+		if (child == -1) {
+			perror("fork");
+			ok = false;
+		} else {
+			ok = RunAgainstPeer("process", *toPeer, *fromPeer, count, &results);
+			if (!ok)
+				Send(*toPeer, "quit", 4);
+
+			int status = 0;
+			waitpid(child, &status, 0);
+			ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+		}
+	}
+
+	toPeer->Unlink();
+	fromPeer->Unlink();
+
+	if (!ok)
+		return EXIT_FAILURE;
+
+	printf("Throughput, %u messages per run\n", count);
+	printf("%-8s %8s %14s %10s\n", "peer", "bytes", "messages/s", "MB/s");
+	for (const std::string& line : results.throughput)
+		printf("%s\n", line.c_str());
+
+	printf("\nRound trip, %u messages per run\n", count);
+	printf("%-8s %-8s %12s %12s %12s\n", "peer", "reader", "mean ns", "median ns", "99% ns");
+	for (const std::string& line : results.latency)
+		printf("%s\n", line.c_str());
+
+	return EXIT_SUCCESS;
+}
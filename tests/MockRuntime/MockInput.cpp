@@ -0,0 +1,915 @@
+#include "MockRuntimePrivate.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+// Paths, actions and the scripted controller inputs.
+//
+// Every input source (eg /user/hand/left/input/trigger/value) has its own pattern, picked by hashing its path, and
+// its value is a function of the time of the last xrSyncActions. Buttons are pressed and released every so often,
+// and the triggers and sticks move back and forth smoothly.
+
+namespace mock {
+
+static const char* const INDEX_PROFILE = "/interaction_profiles/valve/index_controller";
+
+// The interaction profiles from the core spec. Profiles from extensions are rejected, as none are supported.
+static const char* const coreProfiles[] = {
+	"/interaction_profiles/khr/simple_controller",
+	"/interaction_profiles/google/daydream_controller",
+	"/interaction_profiles/htc/vive_controller",
+	"/interaction_profiles/htc/vive_pro",
+	"/interaction_profiles/microsoft/motion_controller",
+	"/interaction_profiles/microsoft/xbox_controller",
+	"/interaction_profiles/oculus/go_controller",
+	"/interaction_profiles/oculus/touch_controller",
+	"/interaction_profiles/valve/index_controller",
+};
+
+// The Index controller's inputs, which are checked exactly since it's the profile normally used
+static const char* const indexInputs[] = {
+	"/input/system/click",
+	"/input/system/touch",
+	"/input/a/click",
+	"/input/a/touch",
+	"/input/b/click",
+	"/input/b/touch",
+	"/input/squeeze/value",
+	"/input/squeeze/force",
+	"/input/trigger/click",
+	"/input/trigger/value",
+	"/input/trigger/touch",
+	"/input/thumbstick",
+	"/input/thumbstick/x",
+	"/input/thumbstick/y",
+	"/input/thumbstick/click",
+	"/input/thumbstick/touch",
+	"/input/trackpad",
+	"/input/trackpad/x",
+	"/input/trackpad/y",
+	"/input/trackpad/force",
+	"/input/trackpad/touch",
+	"/input/grip/pose",
+	"/input/aim/pose",
+	"/output/haptic",
+};
+
+static const char* const handPaths[] = { "/user/hand/left", "/user/hand/right" };
+
+static bool StartsWith(const std::string& str, const std::string& prefix)
+{
+	return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+static bool EndsWith(const std::string& str, const std::string& suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Names of actions and action sets are limited to the same characters as paths, without the strokes
+static bool IsValidName(const char* name, size_t maxSize)
+{
+	size_t length = strnlen(name, maxSize);
+	if (length == 0 || length == maxSize)
+		return false;
+
+	for (size_t i = 0; i < length; i++) {
+		char c = name[i];
+		if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.'))
+			return false;
+	}
+	return true;
+}
+
+bool IsValidPath(const std::string& path)
+{
+	if (path.empty() || path.size() >= XR_MAX_PATH_LENGTH || path.front() != '/' || path.back() == '/')
+		return false;
+
+	for (size_t i = 0; i < path.size(); i++) {
+		char c = path[i];
+		if (c == '/') {
+			// Empty components aren't allowed, and nor are components made of only periods
+			size_t end = path.find('/', i + 1);
+			std::string component = path.substr(i + 1, end == std::string::npos ? std::string::npos : end - i - 1);
+			if (component.empty() || component.find_first_not_of('.') == std::string::npos)
+				return false;
+			continue;
+		}
+
+		if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.'))
+			return false;
+	}
+	return true;
+}
+
+const std::string& PathString(Instance* instance, XrPath path)
+{
+	static const std::string empty;
+	if (path == XR_NULL_PATH || path > instance->paths.size())
+		return empty;
+	return instance->paths.at(path - 1);
+}
+
+static XrPath GetPath(Instance* instance, const std::string& str)
+{
+	auto iter = instance->pathIds.find(str);
+	if (iter != instance->pathIds.end())
+		return iter->second;
+
+	instance->paths.push_back(str);
+	XrPath path = instance->paths.size();
+	instance->pathIds[str] = path;
+	return path;
+}
+
+// Finds which hand a binding or subaction path is for, returning -1 if it's not a hand
+static int GetHand(const std::string& path)
+{
+	for (int i = 0; i < 2; i++) {
+		if (path == handPaths[i] || StartsWith(path, std::string(handPaths[i]) + "/"))
+			return i;
+	}
+	return -1;
+}
+
+static bool IsBindingValid(const std::string& profile, const std::string& binding)
+{
+	if (!StartsWith(binding, "/user/"))
+		return false;
+
+	// Without a list of every profile's inputs, make sure the others are at least for a hand
+	int hand = GetHand(binding);
+	if (profile != INDEX_PROFILE)
+		return hand != -1;
+	if (hand == -1)
+		return false;
+
+	std::string input = binding.substr(strlen(handPaths[hand]));
+	return std::any_of(std::begin(indexInputs), std::end(indexInputs), [&input](const char* valid) {
+		// An identifier can be bound without its component, and the runtime picks one
+		return input == valid || StartsWith(valid, input + "/");
+	});
+}
+
+XrResult XRAPI_CALL xrStringToPath(XrInstance instanceHandle, const char* pathString, XrPath* path)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+	if (!pathString || !path)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (!IsValidPath(pathString))
+		return XR_ERROR_PATH_FORMAT_INVALID;
+
+	*path = GetPath(instance, pathString);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrPathToString(XrInstance instanceHandle, XrPath path, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (path == XR_NULL_PATH || path > instance->paths.size())
+		return XR_ERROR_PATH_INVALID;
+
+	return FillString(bufferCapacityInput, bufferCountOutput, buffer, PathString(instance, path));
+}
+
+// Action sets and actions
+
+XrResult XRAPI_CALL xrCreateActionSet(XrInstance instanceHandle, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSetHandle)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_ACTION_SET_CREATE_INFO);
+	if (!actionSetHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (!IsValidName(createInfo->actionSetName, XR_MAX_ACTION_SET_NAME_SIZE))
+		return XR_ERROR_PATH_FORMAT_INVALID;
+	if (strnlen(createInfo->localizedActionSetName, XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE) == 0)
+		return XR_ERROR_LOCALIZED_NAME_INVALID;
+
+	for (ActionSet* other : instance->actionSets) {
+		if (other->name == createInfo->actionSetName)
+			return XR_ERROR_NAME_DUPLICATED;
+	}
+
+	ActionSet* set = new ActionSet();
+	set->instance = instance;
+	set->name = createInfo->actionSetName;
+	set->localizedName = createInfo->localizedActionSetName;
+	set->priority = createInfo->priority;
+
+	instance->actionSets.insert(set);
+	actionSets.insert(set);
+	*actionSetHandle = ToHandle<XrActionSet>(set);
+	return XR_SUCCESS;
+}
+
+// Removes every reference to an action, since a new one could be created at the same address
+static void DestroyAction(Action* action)
+{
+	Instance* instance = action->set->instance;
+
+	auto forget = [action](std::vector<XrActionSuggestedBinding>& bindings) {
+		bindings.erase(std::remove_if(bindings.begin(), bindings.end(), [action](const XrActionSuggestedBinding& binding) {
+			return FromHandle<Action>(binding.action) == action;
+		}),
+		    bindings.end());
+	};
+
+	for (auto& [profile, bindings] : instance->suggestedBindings)
+		forget(bindings);
+
+	for (Session* session : instance->sessions) {
+		for (auto& [profile, bindings] : session->bindings)
+			forget(bindings);
+
+		for (Space* space : session->spaces) {
+			if (space->action == action) {
+				space->action = nullptr;
+				space->actionDestroyed = true;
+			}
+		}
+	}
+
+	actions.erase(action);
+	delete action;
+}
+
+XrResult XRAPI_CALL xrDestroyActionSet(XrActionSet actionSetHandle)
+{
+	MOCK_ENTRY();
+
+	ActionSet* set = GetActionSet(actionSetHandle);
+	if (!set)
+		return XR_ERROR_HANDLE_INVALID;
+
+	for (Action* action : set->actions)
+		DestroyAction(action);
+
+	for (Session* session : set->instance->sessions) {
+		std::vector<ActionSet*>& attached = session->attachedSets;
+		attached.erase(std::remove(attached.begin(), attached.end(), set), attached.end());
+
+		std::vector<XrActiveActionSet>& active = session->activeSets;
+		active.erase(std::remove_if(active.begin(), active.end(), [actionSetHandle](const XrActiveActionSet& a) { return a.actionSet == actionSetHandle; }),
+		    active.end());
+	}
+
+	set->instance->actionSets.erase(set);
+	actionSets.erase(set);
+	delete set;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrCreateAction(XrActionSet actionSetHandle, const XrActionCreateInfo* createInfo, XrAction* actionHandle)
+{
+	MOCK_ENTRY();
+
+	ActionSet* set = GetActionSet(actionSetHandle);
+	if (!set)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_ACTION_CREATE_INFO);
+	if (!actionHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (set->attached)
+		return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+
+	if (!IsValidName(createInfo->actionName, XR_MAX_ACTION_NAME_SIZE))
+		return XR_ERROR_PATH_FORMAT_INVALID;
+	if (strnlen(createInfo->localizedActionName, XR_MAX_LOCALIZED_ACTION_NAME_SIZE) == 0)
+		return XR_ERROR_LOCALIZED_NAME_INVALID;
+
+	for (Action* other : set->actions) {
+		if (other->name == createInfo->actionName)
+			return XR_ERROR_NAME_DUPLICATED;
+	}
+
+	switch (createInfo->actionType) {
+	case XR_ACTION_TYPE_BOOLEAN_INPUT:
+	case XR_ACTION_TYPE_FLOAT_INPUT:
+	case XR_ACTION_TYPE_VECTOR2F_INPUT:
+	case XR_ACTION_TYPE_POSE_INPUT:
+	case XR_ACTION_TYPE_VIBRATION_OUTPUT:
+		break;
+	default:
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	if (createInfo->countSubactionPaths != 0 && !createInfo->subactionPaths)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	std::vector<XrPath> subactionPaths;
+	for (uint32_t i = 0; i < createInfo->countSubactionPaths; i++) {
+		XrPath path = createInfo->subactionPaths[i];
+		const std::string& str = PathString(set->instance, path);
+		if (str.empty())
+			return XR_ERROR_PATH_INVALID;
+		if (str != "/user/head" && str != "/user/gamepad" && GetHand(str) == -1)
+			return XR_ERROR_PATH_UNSUPPORTED;
+		if (std::find(subactionPaths.begin(), subactionPaths.end(), path) != subactionPaths.end())
+			return XR_ERROR_PATH_UNSUPPORTED;
+		subactionPaths.push_back(path);
+	}
+
+	Action* action = new Action();
+	action->set = set;
+	action->name = createInfo->actionName;
+	action->localizedName = createInfo->localizedActionName;
+	action->type = createInfo->actionType;
+	action->subactionPaths = std::move(subactionPaths);
+
+	set->actions.insert(action);
+	actions.insert(action);
+	*actionHandle = ToHandle<XrAction>(action);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroyAction(XrAction actionHandle)
+{
+	MOCK_ENTRY();
+
+	Action* action = GetAction(actionHandle);
+	if (!action)
+		return XR_ERROR_HANDLE_INVALID;
+
+	action->set->actions.erase(action);
+	DestroyAction(action);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrSuggestInteractionProfileBindings(XrInstance instanceHandle, const XrInteractionProfileSuggestedBinding* suggestedBindings)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(suggestedBindings, XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING);
+
+	const std::string& profile = PathString(instance, suggestedBindings->interactionProfile);
+	if (profile.empty())
+		return XR_ERROR_PATH_INVALID;
+	if (std::find(std::begin(coreProfiles), std::end(coreProfiles), profile) == std::end(coreProfiles))
+		return XR_ERROR_PATH_UNSUPPORTED;
+
+	if (suggestedBindings->countSuggestedBindings == 0 || !suggestedBindings->suggestedBindings)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	std::vector<XrActionSuggestedBinding> bindings;
+	for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; i++) {
+		const XrActionSuggestedBinding& binding = suggestedBindings->suggestedBindings[i];
+
+		Action* action = GetAction(binding.action);
+		if (!action || action->set->instance != instance)
+			return XR_ERROR_HANDLE_INVALID;
+		if (action->set->attached)
+			return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+
+		const std::string& path = PathString(instance, binding.binding);
+		if (path.empty())
+			return XR_ERROR_PATH_INVALID;
+		if (!IsBindingValid(profile, path))
+			return XR_ERROR_PATH_UNSUPPORTED;
+
+		bindings.push_back(binding);
+	}
+
+	// Suggesting bindings again for the same profile replaces the old ones
+	instance->suggestedBindings[suggestedBindings->interactionProfile] = std::move(bindings);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrAttachSessionActionSets(XrSession sessionHandle, const XrSessionActionSetsAttachInfo* attachInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(attachInfo, XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO);
+	if (attachInfo->countActionSets == 0 || !attachInfo->actionSets)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (session->actionSetsAttached)
+		return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+
+	std::vector<ActionSet*> sets;
+	for (uint32_t i = 0; i < attachInfo->countActionSets; i++) {
+		ActionSet* set = GetActionSet(attachInfo->actionSets[i]);
+		if (!set || set->instance != session->instance)
+			return XR_ERROR_HANDLE_INVALID;
+		sets.push_back(set);
+	}
+
+	for (ActionSet* set : sets)
+		set->attached = true;
+
+	session->actionSetsAttached = true;
+	session->attachedSets = sets;
+
+	// Only the bindings for the attached actions are kept, and they can't change from now on
+	for (const auto& [profile, bindings] : session->instance->suggestedBindings) {
+		std::vector<XrActionSuggestedBinding>& kept = session->bindings[profile];
+		for (const XrActionSuggestedBinding& binding : bindings) {
+			if (std::find(sets.begin(), sets.end(), FromHandle<Action>(binding.action)->set) != sets.end())
+				kept.push_back(binding);
+		}
+	}
+
+	// The Index controller is used if the app supports it, since that's what most OpenVR games are built around
+	const char* requested = getenv("OC_MOCK_XR_PROFILE");
+	if (requested && *requested) {
+		session->profile = IsValidPath(requested) ? GetPath(session->instance, requested) : XR_NULL_PATH;
+	} else {
+		auto index = session->instance->pathIds.find(INDEX_PROFILE);
+		if (index != session->instance->pathIds.end() && !session->bindings[index->second].empty()) {
+			session->profile = index->second;
+		} else {
+			for (const auto& [profile, bindings] : session->bindings) {
+				if (!bindings.empty()) {
+					session->profile = profile;
+					break;
+				}
+			}
+		}
+	}
+
+	return XR_SUCCESS;
+}
+
+void DestroySessionInput(Session* session)
+{
+	session->bindings.clear();
+	session->attachedSets.clear();
+	session->activeSets.clear();
+}
+
+XrResult XRAPI_CALL xrGetCurrentInteractionProfile(XrSession sessionHandle, XrPath topLevelUserPath, XrInteractionProfileState* interactionProfile)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(interactionProfile, XR_TYPE_INTERACTION_PROFILE_STATE);
+
+	if (!session->actionSetsAttached)
+		return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+
+	const std::string& path = PathString(session->instance, topLevelUserPath);
+	if (path.empty())
+		return XR_ERROR_PATH_INVALID;
+	if (path != "/user/head" && path != "/user/gamepad" && path != handPaths[0] && path != handPaths[1])
+		return XR_ERROR_PATH_UNSUPPORTED;
+
+	// Only the hands have controllers
+	bool hand = GetHand(path) != -1;
+	interactionProfile->interactionProfile = hand && session->profileCurrent ? session->profile : XR_NULL_PATH;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrSyncActions(XrSession sessionHandle, const XrActionsSyncInfo* syncInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(syncInfo, XR_TYPE_ACTIONS_SYNC_INFO);
+	if (syncInfo->countActiveActionSets != 0 && !syncInfo->activeActionSets)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	std::vector<XrActiveActionSet> active;
+	for (uint32_t i = 0; i < syncInfo->countActiveActionSets; i++) {
+		const XrActiveActionSet& entry = syncInfo->activeActionSets[i];
+		ActionSet* set = GetActionSet(entry.actionSet);
+		if (!set)
+			return XR_ERROR_HANDLE_INVALID;
+		if (std::find(session->attachedSets.begin(), session->attachedSets.end(), set) == session->attachedSets.end())
+			return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+
+		if (entry.subactionPath != XR_NULL_PATH) {
+			const std::string& path = PathString(session->instance, entry.subactionPath);
+			if (path.empty())
+				return XR_ERROR_PATH_INVALID;
+			if (path != "/user/head" && path != "/user/gamepad" && GetHand(path) == -1)
+				return XR_ERROR_PATH_UNSUPPORTED;
+		}
+
+		active.push_back(entry);
+	}
+
+	session->syncCount++;
+	session->previousSyncTime = session->syncTime;
+	session->syncTime = session->lastDisplayTime;
+
+	// Input only goes to the app that has focus
+	if (session->state != XR_SESSION_STATE_FOCUSED) {
+		session->activeSets.clear();
+		return XR_SESSION_NOT_FOCUSED;
+	}
+
+	session->activeSets = std::move(active);
+
+	if (!session->profileCurrent && session->profile != XR_NULL_PATH) {
+		session->profileCurrent = true;
+
+		XrEventDataInteractionProfileChanged event = { XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED };
+		event.session = sessionHandle;
+		PushEvent(session->instance, &event, sizeof(event));
+	}
+
+	return XR_SUCCESS;
+}
+
+// Input values
+
+enum class SourceKind {
+	Boolean, // click and touch
+	Scalar, // value and force
+	Axis, // x and y
+	Vector, // thumbsticks and trackpads without a component
+	Other, // poses and haptics
+};
+
+static SourceKind GetSourceKind(const std::string& path)
+{
+	if (EndsWith(path, "/click") || EndsWith(path, "/touch"))
+		return SourceKind::Boolean;
+	if (EndsWith(path, "/value") || EndsWith(path, "/force"))
+		return SourceKind::Scalar;
+	if (EndsWith(path, "/x") || EndsWith(path, "/y"))
+		return SourceKind::Axis;
+	if (EndsWith(path, "/thumbstick") || EndsWith(path, "/trackpad") || EndsWith(path, "/joystick"))
+		return SourceKind::Vector;
+
+	// Any other identifier without a component (like /input/trigger) is its value, or its click if it has no value
+	if (EndsWith(path, "/trigger") || EndsWith(path, "/squeeze"))
+		return SourceKind::Scalar;
+	if (path.find("/input/") != std::string::npos && !EndsWith(path, "/pose"))
+		return SourceKind::Boolean;
+
+	return SourceKind::Other;
+}
+
+static uint32_t HashPath(const std::string& path)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (char c : path) {
+		hash ^= (uint8_t)c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+struct SourceValue {
+	XrVector2f value; // Only x is used for everything but Vector sources
+	bool pressed;
+};
+
+// The scripted value of an input source at a given time
+static SourceValue GetSourceValue(const std::string& path, XrTime time)
+{
+	uint32_t hash = HashPath(path);
+	double t = (double)(time - TIME_BASE) / 1e9;
+	double speed = 0.5 + (hash % 8) / 8.0;
+	double phase = (hash >> 8) % 628 / 100.0;
+
+	SourceValue result = {};
+	switch (GetSourceKind(path)) {
+	case SourceKind::Boolean: {
+		// Held down for one period and let go for the next, with each period between a third and a whole second long
+		uint64_t frame = (time - TIME_BASE) / FRAME_PERIOD;
+		uint64_t period = 30 + (hash >> 16) % 61;
+		result.pressed = ((frame + (hash >> 4) % period) / period) % 2 == 1;
+		result.value.x = result.pressed ? 1 : 0;
+		break;
+	}
+	case SourceKind::Scalar:
+		result.value.x = (float)(0.5 + 0.5 * sin(speed * t + phase));
+		result.pressed = result.value.x > 0.5f;
+		break;
+	case SourceKind::Axis:
+		result.value.x = (float)sin(speed * t + phase);
+		result.pressed = result.value.x > 0.5f;
+		break;
+	case SourceKind::Vector:
+		result.value.x = (float)(0.9 * sin(speed * t + phase));
+		result.value.y = (float)(0.9 * cos(speed * t + phase));
+		result.pressed = result.value.x * result.value.x + result.value.y * result.value.y > 0.25f;
+		break;
+	case SourceKind::Other:
+		break;
+	}
+	return result;
+}
+
+// Checks if an action set is active for a hand (-1 meaning any hand) in the last sync
+static bool IsSetActive(Session* session, ActionSet* set, int hand)
+{
+	for (const XrActiveActionSet& active : session->activeSets) {
+		if (FromHandle<ActionSet>(active.actionSet) != set)
+			continue;
+
+		if (active.subactionPath == XR_NULL_PATH || hand == -1)
+			return true;
+		if (GetHand(PathString(session->instance, active.subactionPath)) == hand)
+			return true;
+	}
+	return false;
+}
+
+// Lists the input sources an action is bound to in the current profile, optionally limited to one subaction path
+static void GetBoundSources(Session* session, Action* action, XrPath subactionPath, std::vector<const std::string*>& sources)
+{
+	sources.clear();
+	if (!session->profileCurrent)
+		return;
+
+	auto iter = session->bindings.find(session->profile);
+	if (iter == session->bindings.end())
+		return;
+
+	const std::string* prefix = subactionPath == XR_NULL_PATH ? nullptr : &PathString(session->instance, subactionPath);
+
+	for (const XrActionSuggestedBinding& binding : iter->second) {
+		if (FromHandle<Action>(binding.action) != action)
+			continue;
+
+		const std::string& path = PathString(session->instance, binding.binding);
+		if (prefix && !StartsWith(path, *prefix + "/"))
+			continue;
+
+		// Sources only count if their hand's action set is active
+		if (!IsSetActive(session, action->set, GetHand(path)))
+			continue;
+
+		sources.push_back(&path);
+	}
+}
+
+bool FindPoseSource(Session* session, Action* action, XrPath subactionPath, int* hand, bool* aim)
+{
+	std::vector<const std::string*> sources;
+	GetBoundSources(session, action, subactionPath, sources);
+
+	for (const std::string* source : sources) {
+		int sourceHand = GetHand(*source);
+		if (sourceHand == -1 || !EndsWith(*source, "/pose"))
+			continue;
+
+		*hand = sourceHand;
+		*aim = EndsWith(*source, "/aim/pose");
+		return true;
+	}
+	return false;
+}
+
+// Checks the arguments of the xrGetActionState* functions, and finds the sources for the action
+static XrResult GetActionSources(Session* session, const XrActionStateGetInfo* getInfo, XrActionType type, std::vector<const std::string*>& sources)
+{
+	MOCK_CHECK_TYPE(getInfo, XR_TYPE_ACTION_STATE_GET_INFO);
+
+	Action* action = GetAction(getInfo->action);
+	if (!action)
+		return XR_ERROR_HANDLE_INVALID;
+	if (action->type != type)
+		return XR_ERROR_ACTION_TYPE_MISMATCH;
+
+	if (std::find(session->attachedSets.begin(), session->attachedSets.end(), action->set) == session->attachedSets.end())
+		return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+
+	if (getInfo->subactionPath != XR_NULL_PATH) {
+		const std::vector<XrPath>& paths = action->subactionPaths;
+		if (std::find(paths.begin(), paths.end(), getInfo->subactionPath) == paths.end())
+			return XR_ERROR_PATH_UNSUPPORTED;
+	}
+
+	GetBoundSources(session, action, getInfo->subactionPath, sources);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetActionStateBoolean(XrSession sessionHandle, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(state, XR_TYPE_ACTION_STATE_BOOLEAN);
+
+	std::vector<const std::string*> sources;
+	if (XrResult result = GetActionSources(session, getInfo, XR_ACTION_TYPE_BOOLEAN_INPUT, sources); XR_FAILED(result))
+		return result;
+
+	// Combined across every source, a boolean action is pressed if any of them are
+	bool current = false, previous = false;
+	for (const std::string* source : sources) {
+		current |= GetSourceValue(*source, session->syncTime).pressed;
+		previous |= GetSourceValue(*source, session->previousSyncTime).pressed;
+	}
+
+	state->isActive = !sources.empty();
+	state->currentState = current;
+	state->changedSinceLastSync = state->isActive && session->syncCount > 1 && current != previous;
+	state->lastChangeTime = state->changedSinceLastSync ? session->syncTime : session->previousSyncTime;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetActionStateFloat(XrSession sessionHandle, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(state, XR_TYPE_ACTION_STATE_FLOAT);
+
+	std::vector<const std::string*> sources;
+	if (XrResult result = GetActionSources(session, getInfo, XR_ACTION_TYPE_FLOAT_INPUT, sources); XR_FAILED(result))
+		return result;
+
+	// And a float action takes whichever value is furthest from zero
+	float current = 0, previous = 0;
+	for (const std::string* source : sources) {
+		float value = GetSourceValue(*source, session->syncTime).value.x;
+		if (fabsf(value) > fabsf(current))
+			current = value;
+
+		value = GetSourceValue(*source, session->previousSyncTime).value.x;
+		if (fabsf(value) > fabsf(previous))
+			previous = value;
+	}
+
+	state->isActive = !sources.empty();
+	state->currentState = current;
+	state->changedSinceLastSync = state->isActive && session->syncCount > 1 && current != previous;
+	state->lastChangeTime = state->changedSinceLastSync ? session->syncTime : session->previousSyncTime;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetActionStateVector2f(XrSession sessionHandle, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* state)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(state, XR_TYPE_ACTION_STATE_VECTOR2F);
+
+	std::vector<const std::string*> sources;
+	if (XrResult result = GetActionSources(session, getInfo, XR_ACTION_TYPE_VECTOR2F_INPUT, sources); XR_FAILED(result))
+		return result;
+
+	// And a vector action takes the longest one
+	auto lengthSq = [](const XrVector2f& v) { return v.x * v.x + v.y * v.y; };
+	XrVector2f current = {}, previous = {};
+	for (const std::string* source : sources) {
+		// Only the sources that are actually two-dimensional can be bound to a vector
+		if (GetSourceKind(*source) != SourceKind::Vector)
+			continue;
+
+		XrVector2f value = GetSourceValue(*source, session->syncTime).value;
+		if (lengthSq(value) > lengthSq(current))
+			current = value;
+
+		value = GetSourceValue(*source, session->previousSyncTime).value;
+		if (lengthSq(value) > lengthSq(previous))
+			previous = value;
+	}
+
+	state->isActive = !sources.empty();
+	state->currentState = current;
+	state->changedSinceLastSync = state->isActive && session->syncCount > 1 && (current.x != previous.x || current.y != previous.y);
+	state->lastChangeTime = state->changedSinceLastSync ? session->syncTime : session->previousSyncTime;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetActionStatePose(XrSession sessionHandle, const XrActionStateGetInfo* getInfo, XrActionStatePose* state)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(state, XR_TYPE_ACTION_STATE_POSE);
+
+	std::vector<const std::string*> sources;
+	if (XrResult result = GetActionSources(session, getInfo, XR_ACTION_TYPE_POSE_INPUT, sources); XR_FAILED(result))
+		return result;
+
+	state->isActive = !sources.empty();
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateBoundSourcesForAction(XrSession sessionHandle, const XrBoundSourcesForActionEnumerateInfo* enumerateInfo,
+    uint32_t sourceCapacityInput, uint32_t* sourceCountOutput, XrPath* sourcePaths)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(enumerateInfo, XR_TYPE_BOUND_SOURCES_FOR_ACTION_ENUMERATE_INFO);
+
+	Action* action = GetAction(enumerateInfo->action);
+	if (!action)
+		return XR_ERROR_HANDLE_INVALID;
+	if (std::find(session->attachedSets.begin(), session->attachedSets.end(), action->set) == session->attachedSets.end())
+		return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+
+	std::vector<const std::string*> sources;
+	GetBoundSources(session, action, XR_NULL_PATH, sources);
+
+	return FillArray(sourceCapacityInput, sourceCountOutput, sourcePaths, (uint32_t)sources.size(), [&](XrPath& path, uint32_t i) {
+		path = session->instance->pathIds.at(*sources[i]);
+	});
+}
+
+XrResult XRAPI_CALL xrGetInputSourceLocalizedName(XrSession sessionHandle, const XrInputSourceLocalizedNameGetInfo* getInfo,
+    uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(getInfo, XR_TYPE_INPUT_SOURCE_LOCALIZED_NAME_GET_INFO);
+
+	if (!session->actionSetsAttached)
+		return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+	if (getInfo->whichComponents == 0)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	const std::string& path = PathString(session->instance, getInfo->sourcePath);
+	if (path.empty())
+		return XR_ERROR_PATH_INVALID;
+
+	// There's nothing to translate into, so the path itself will do
+	return FillString(bufferCapacityInput, bufferCountOutput, buffer, path);
+}
+
+static XrResult CheckHapticAction(Session* session, const XrHapticActionInfo* hapticActionInfo)
+{
+	MOCK_CHECK_TYPE(hapticActionInfo, XR_TYPE_HAPTIC_ACTION_INFO);
+
+	Action* action = GetAction(hapticActionInfo->action);
+	if (!action)
+		return XR_ERROR_HANDLE_INVALID;
+	if (action->type != XR_ACTION_TYPE_VIBRATION_OUTPUT)
+		return XR_ERROR_ACTION_TYPE_MISMATCH;
+	if (std::find(session->attachedSets.begin(), session->attachedSets.end(), action->set) == session->attachedSets.end())
+		return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+
+	if (hapticActionInfo->subactionPath != XR_NULL_PATH) {
+		const std::vector<XrPath>& paths = action->subactionPaths;
+		if (std::find(paths.begin(), paths.end(), hapticActionInfo->subactionPath) == paths.end())
+			return XR_ERROR_PATH_UNSUPPORTED;
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrApplyHapticFeedback(XrSession sessionHandle, const XrHapticActionInfo* hapticActionInfo, const XrHapticBaseHeader* hapticFeedback)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	if (XrResult result = CheckHapticAction(session, hapticActionInfo); XR_FAILED(result))
+		return result;
+	MOCK_CHECK_TYPE(hapticFeedback, XR_TYPE_HAPTIC_VIBRATION);
+
+	// There's nothing to vibrate
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrStopHapticFeedback(XrSession sessionHandle, const XrHapticActionInfo* hapticActionInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	return CheckHapticAction(session, hapticActionInfo);
+}
+
+} // namespace mock
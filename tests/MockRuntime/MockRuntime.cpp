@@ -0,0 +1,1099 @@
+#include "MockRuntimePrivate.h"
+
+#include <openxr/openxr_reflection.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+// The instance, system, session and frame loop parts of the mock runtime, along with the loader interface and the
+// functions the tests call. Spaces, input and swapchains are in the other files.
+
+namespace mock {
+
+std::mutex runtimeLock;
+
+std::set<Instance*> instances;
+std::set<Session*> sessions;
+std::set<Swapchain*> swapchains;
+std::set<Space*> spaces;
+std::set<ActionSet*> actionSets;
+std::set<Action*> actions;
+
+// The functions the tests call don't go through MOCK_ENTRY, so they aren't counted
+static std::atomic<uint64_t> totalCalls = 0;
+static std::atomic<CallCounter*> counters = nullptr;
+
+// The last frame submitted by any session
+static std::atomic<uint64_t> framesEnded = 0;
+static std::vector<OCMockXrLayer> lastFrameLayers;
+
+CallCounter::CallCounter(const char* name)
+    : name(name)
+{
+	// Function statics are only constructed once, but that might be on several threads at once
+	next = counters.load(std::memory_order_relaxed);
+	while (!counters.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {
+	}
+}
+
+void CallCounter::Count()
+{
+	calls.fetch_add(1, std::memory_order_relaxed);
+	totalCalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The extensions the mock supports, which are the ones OpenComposite can run without
+static const XrExtensionProperties supportedExtensions[] = {
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME, XR_KHR_vulkan_enable_SPEC_VERSION },
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_OPENGL_ENABLE_EXTENSION_NAME, XR_KHR_opengl_enable_SPEC_VERSION },
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME, XR_KHR_composition_layer_cylinder_SPEC_VERSION },
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_COMPOSITION_LAYER_CUBE_EXTENSION_NAME, XR_KHR_composition_layer_cube_SPEC_VERSION },
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME, XR_KHR_composition_layer_depth_SPEC_VERSION },
+#ifdef XR_KHR_locate_spaces
+	{ XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_KHR_LOCATE_SPACES_EXTENSION_NAME, XR_KHR_locate_spaces_SPEC_VERSION },
+#endif
+};
+
+struct FunctionEntry {
+	const char* name;
+	PFN_xrVoidFunction function;
+	const char* extension; // Only available if this is enabled, or for every instance if null
+};
+
+#define MOCK_FUNCTION(name) { #name, (PFN_xrVoidFunction)name, nullptr }
+#define MOCK_EXT_FUNCTION(name, extension) { #name, (PFN_xrVoidFunction)name, extension }
+
+static const FunctionEntry functionTable[] = {
+	MOCK_FUNCTION(xrGetInstanceProcAddr),
+	MOCK_FUNCTION(xrEnumerateApiLayerProperties),
+	MOCK_FUNCTION(xrEnumerateInstanceExtensionProperties),
+	MOCK_FUNCTION(xrCreateInstance),
+	MOCK_FUNCTION(xrDestroyInstance),
+	MOCK_FUNCTION(xrGetInstanceProperties),
+	MOCK_FUNCTION(xrPollEvent),
+	MOCK_FUNCTION(xrResultToString),
+	MOCK_FUNCTION(xrStructureTypeToString),
+	MOCK_FUNCTION(xrGetSystem),
+	MOCK_FUNCTION(xrGetSystemProperties),
+	MOCK_FUNCTION(xrEnumerateEnvironmentBlendModes),
+	MOCK_FUNCTION(xrCreateSession),
+	MOCK_FUNCTION(xrDestroySession),
+	MOCK_FUNCTION(xrEnumerateReferenceSpaces),
+	MOCK_FUNCTION(xrCreateReferenceSpace),
+	MOCK_FUNCTION(xrGetReferenceSpaceBoundsRect),
+	MOCK_FUNCTION(xrCreateActionSpace),
+	MOCK_FUNCTION(xrLocateSpace),
+	MOCK_FUNCTION(xrDestroySpace),
+	MOCK_FUNCTION(xrEnumerateViewConfigurations),
+	MOCK_FUNCTION(xrGetViewConfigurationProperties),
+	MOCK_FUNCTION(xrEnumerateViewConfigurationViews),
+	MOCK_FUNCTION(xrEnumerateSwapchainFormats),
+	MOCK_FUNCTION(xrCreateSwapchain),
+	MOCK_FUNCTION(xrDestroySwapchain),
+	MOCK_FUNCTION(xrEnumerateSwapchainImages),
+	MOCK_FUNCTION(xrAcquireSwapchainImage),
+	MOCK_FUNCTION(xrWaitSwapchainImage),
+	MOCK_FUNCTION(xrReleaseSwapchainImage),
+	MOCK_FUNCTION(xrBeginSession),
+	MOCK_FUNCTION(xrEndSession),
+	MOCK_FUNCTION(xrRequestExitSession),
+	MOCK_FUNCTION(xrWaitFrame),
+	MOCK_FUNCTION(xrBeginFrame),
+	MOCK_FUNCTION(xrEndFrame),
+	MOCK_FUNCTION(xrLocateViews),
+	MOCK_FUNCTION(xrStringToPath),
+	MOCK_FUNCTION(xrPathToString),
+	MOCK_FUNCTION(xrCreateActionSet),
+	MOCK_FUNCTION(xrDestroyActionSet),
+	MOCK_FUNCTION(xrCreateAction),
+	MOCK_FUNCTION(xrDestroyAction),
+	MOCK_FUNCTION(xrSuggestInteractionProfileBindings),
+	MOCK_FUNCTION(xrAttachSessionActionSets),
+	MOCK_FUNCTION(xrGetCurrentInteractionProfile),
+	MOCK_FUNCTION(xrGetActionStateBoolean),
+	MOCK_FUNCTION(xrGetActionStateFloat),
+	MOCK_FUNCTION(xrGetActionStateVector2f),
+	MOCK_FUNCTION(xrGetActionStatePose),
+	MOCK_FUNCTION(xrSyncActions),
+	MOCK_FUNCTION(xrEnumerateBoundSourcesForAction),
+	MOCK_FUNCTION(xrGetInputSourceLocalizedName),
+	MOCK_FUNCTION(xrApplyHapticFeedback),
+	MOCK_FUNCTION(xrStopHapticFeedback),
+
+	MOCK_EXT_FUNCTION(xrGetVulkanInstanceExtensionsKHR, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME),
+	MOCK_EXT_FUNCTION(xrGetVulkanDeviceExtensionsKHR, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME),
+	MOCK_EXT_FUNCTION(xrGetVulkanGraphicsDeviceKHR, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME),
+	MOCK_EXT_FUNCTION(xrGetVulkanGraphicsRequirementsKHR, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME),
+	MOCK_EXT_FUNCTION(xrGetOpenGLGraphicsRequirementsKHR, XR_KHR_OPENGL_ENABLE_EXTENSION_NAME),
+
+#ifdef XR_KHR_locate_spaces
+	MOCK_EXT_FUNCTION(xrLocateSpacesKHR, XR_KHR_LOCATE_SPACES_EXTENSION_NAME),
+#endif
+#if defined(XR_VERSION_1_1) && defined(XR_KHR_locate_spaces)
+	// The core version has exactly the same signature
+	{ "xrLocateSpaces", (PFN_xrVoidFunction)xrLocateSpacesKHR, nullptr },
+#endif
+};
+
+// The functions that can be looked up before there's an instance
+static const char* const globalFunctions[] = {
+	"xrEnumerateApiLayerProperties",
+	"xrEnumerateInstanceExtensionProperties",
+	"xrCreateInstance",
+};
+
+static bool IsPaced()
+{
+	static bool paced = getenv("OC_MOCK_XR_PACED") != nullptr;
+	return paced;
+}
+
+Instance* GetInstance(XrInstance handle)
+{
+	Instance* instance = FromHandle<Instance>(handle);
+	return instances.count(instance) ? instance : nullptr;
+}
+
+Session* GetSession(XrSession handle)
+{
+	Session* session = FromHandle<Session>(handle);
+	return sessions.count(session) ? session : nullptr;
+}
+
+Space* GetSpace(XrSpace handle)
+{
+	Space* space = FromHandle<Space>(handle);
+	return spaces.count(space) ? space : nullptr;
+}
+
+Swapchain* GetSwapchain(XrSwapchain handle)
+{
+	Swapchain* swapchain = FromHandle<Swapchain>(handle);
+	return swapchains.count(swapchain) ? swapchain : nullptr;
+}
+
+ActionSet* GetActionSet(XrActionSet handle)
+{
+	ActionSet* set = FromHandle<ActionSet>(handle);
+	return actionSets.count(set) ? set : nullptr;
+}
+
+Action* GetAction(XrAction handle)
+{
+	Action* action = FromHandle<Action>(handle);
+	return actions.count(action) ? action : nullptr;
+}
+
+XrResult FillString(uint32_t capacity, uint32_t* countOutput, char* buffer, const std::string& value)
+{
+	return FillArray(capacity, countOutput, buffer, (uint32_t)value.size() + 1, [&](char& c, uint32_t i) {
+		c = i < value.size() ? value[i] : 0;
+	});
+}
+
+void PushEvent(Instance* instance, const void* event, size_t size)
+{
+	XrEventDataBuffer buffer = {};
+	memcpy(&buffer, event, size);
+	instance->events.push_back(buffer);
+}
+
+// Destroys a session and everything made from it
+static void DestroySession(Session* session)
+{
+	for (Swapchain* swapchain : session->swapchains) {
+		DestroySwapchainImages(swapchain);
+		swapchains.erase(swapchain);
+		delete swapchain;
+	}
+
+	for (Space* space : session->spaces) {
+		spaces.erase(space);
+		delete space;
+	}
+
+	DestroySessionInput(session);
+
+	if (session->commandPool)
+		vkDestroyCommandPool(session->device, session->commandPool, nullptr);
+
+	session->instance->sessions.erase(session);
+	sessions.erase(session);
+	delete session;
+}
+
+static void SetSessionState(Session* session, XrSessionState state)
+{
+	session->state = state;
+
+	XrEventDataSessionStateChanged event = { XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED };
+	event.session = ToHandle<XrSession>(session);
+	event.state = state;
+	event.time = session->lastDisplayTime;
+	PushEvent(session->instance, &event, sizeof(event));
+}
+
+// Instances
+
+XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instanceHandle, const char* name, PFN_xrVoidFunction* function)
+{
+	MOCK_ENTRY();
+
+	if (!name || !function)
+		return XR_ERROR_VALIDATION_FAILURE;
+	*function = nullptr;
+
+	Instance* instance = nullptr;
+	if (instanceHandle == XR_NULL_HANDLE) {
+		bool global = std::any_of(std::begin(globalFunctions), std::end(globalFunctions), [name](const char* f) { return strcmp(f, name) == 0; });
+		if (!global)
+			return XR_ERROR_HANDLE_INVALID;
+	} else {
+		instance = GetInstance(instanceHandle);
+		if (!instance)
+			return XR_ERROR_HANDLE_INVALID;
+	}
+
+	for (const FunctionEntry& entry : functionTable) {
+		if (strcmp(entry.name, name) != 0)
+			continue;
+
+		// Extension functions can't be used without enabling their extension
+		if (entry.extension && !(instance && instance->extensions.count(entry.extension)))
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+
+		*function = entry.function;
+		return XR_SUCCESS;
+	}
+
+	return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+XrResult XRAPI_CALL xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput, uint32_t* propertyCountOutput, XrApiLayerProperties* properties)
+{
+	MOCK_ENTRY();
+
+	// API layers are the loader's business
+	return FillArray(propertyCapacityInput, propertyCountOutput, properties, 0, [](XrApiLayerProperties&, uint32_t) {});
+}
+
+XrResult XRAPI_CALL xrEnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput, uint32_t* propertyCountOutput, XrExtensionProperties* properties)
+{
+	MOCK_ENTRY();
+
+	if (layerName)
+		return XR_ERROR_API_LAYER_NOT_PRESENT;
+
+	uint32_t count = sizeof(supportedExtensions) / sizeof(supportedExtensions[0]);
+	return FillArray(propertyCapacityInput, propertyCountOutput, properties, count, [](XrExtensionProperties& out, uint32_t i) {
+		strcpy(out.extensionName, supportedExtensions[i].extensionName);
+		out.extensionVersion = supportedExtensions[i].extensionVersion;
+	});
+}
+
+XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instanceHandle)
+{
+	MOCK_ENTRY();
+
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_INSTANCE_CREATE_INFO);
+	if (!instanceHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	XrVersion apiVersion = createInfo->applicationInfo.apiVersion;
+	if (XR_VERSION_MAJOR(apiVersion) != 1 || apiVersion > XR_CURRENT_API_VERSION)
+		return XR_ERROR_API_VERSION_UNSUPPORTED;
+
+	if (createInfo->enabledApiLayerCount != 0)
+		return XR_ERROR_API_LAYER_NOT_PRESENT;
+
+	std::unique_ptr<Instance> instance = std::make_unique<Instance>();
+	instance->apiVersion = apiVersion;
+
+	for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++) {
+		const char* name = createInfo->enabledExtensionNames[i];
+		bool supported = std::any_of(std::begin(supportedExtensions), std::end(supportedExtensions), [name](const XrExtensionProperties& ext) {
+			return strcmp(ext.extensionName, name) == 0;
+		});
+		if (!supported)
+			return XR_ERROR_EXTENSION_NOT_PRESENT;
+
+		instance->extensions.insert(name);
+	}
+
+	*instanceHandle = ToHandle<XrInstance>(instance.get());
+	instances.insert(instance.release());
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroyInstance(XrInstance instanceHandle)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	// Destroying the instance destroys everything made from it
+	for (Session* session : std::set<Session*>(instance->sessions))
+		DestroySession(session);
+
+	for (ActionSet* set : instance->actionSets) {
+		for (Action* action : set->actions) {
+			actions.erase(action);
+			delete action;
+		}
+		actionSets.erase(set);
+		delete set;
+	}
+
+	instances.erase(instance);
+	delete instance;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetInstanceProperties(XrInstance instanceHandle, XrInstanceProperties* instanceProperties)
+{
+	MOCK_ENTRY();
+
+	if (!GetInstance(instanceHandle))
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(instanceProperties, XR_TYPE_INSTANCE_PROPERTIES);
+
+	instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+	strcpy(instanceProperties->runtimeName, "OpenComposite mock runtime");
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrPollEvent(XrInstance instanceHandle, XrEventDataBuffer* eventData)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(eventData, XR_TYPE_EVENT_DATA_BUFFER);
+
+	if (instance->events.empty())
+		return XR_EVENT_UNAVAILABLE;
+
+	*eventData = instance->events.front();
+	instance->events.pop_front();
+	return XR_SUCCESS;
+}
+
+struct EnumName {
+	int64_t value;
+	const char* name;
+};
+
+#define MOCK_ENUM_NAME(name, value) { value, #name },
+
+static const EnumName resultNames[] = { XR_LIST_ENUM_XrResult(MOCK_ENUM_NAME) };
+static const EnumName structureTypeNames[] = { XR_LIST_ENUM_XrStructureType(MOCK_ENUM_NAME) };
+
+template <size_t N>
+static void WriteEnumName(const EnumName (&names)[N], int64_t value, const char* unknownPrefix, char* buffer, size_t size)
+{
+	for (const EnumName& name : names) {
+		if (name.value == value) {
+			snprintf(buffer, size, "%s", name.name);
+			return;
+		}
+	}
+	snprintf(buffer, size, "%s_%lld", unknownPrefix, (long long)value);
+}
+
+XrResult XRAPI_CALL xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE])
+{
+	MOCK_ENTRY();
+
+	if (!GetInstance(instance))
+		return XR_ERROR_HANDLE_INVALID;
+
+	WriteEnumName(resultNames, value, value < 0 ? "XR_UNKNOWN_FAILURE" : "XR_UNKNOWN_SUCCESS", buffer, XR_MAX_RESULT_STRING_SIZE);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrStructureTypeToString(XrInstance instance, XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE])
+{
+	MOCK_ENTRY();
+
+	if (!GetInstance(instance))
+		return XR_ERROR_HANDLE_INVALID;
+
+	WriteEnumName(structureTypeNames, value, "XR_UNKNOWN_STRUCTURE_TYPE", buffer, XR_MAX_STRUCTURE_NAME_SIZE);
+	return XR_SUCCESS;
+}
+
+// Systems
+
+static XrResult CheckSystem(XrInstance instanceHandle, XrSystemId systemId)
+{
+	if (!GetInstance(instanceHandle))
+		return XR_ERROR_HANDLE_INVALID;
+	if (systemId != SYSTEM_ID)
+		return XR_ERROR_SYSTEM_INVALID;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetSystem(XrInstance instanceHandle, const XrSystemGetInfo* getInfo, XrSystemId* systemId)
+{
+	MOCK_ENTRY();
+
+	if (!GetInstance(instanceHandle))
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(getInfo, XR_TYPE_SYSTEM_GET_INFO);
+	if (!systemId)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY)
+		return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+
+	*systemId = SYSTEM_ID;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetSystemProperties(XrInstance instanceHandle, XrSystemId systemId, XrSystemProperties* properties)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	MOCK_CHECK_TYPE(properties, XR_TYPE_SYSTEM_PROPERTIES);
+
+	// Anything chained on is for an extension the mock doesn't support, and is left as it is
+	properties->systemId = SYSTEM_ID;
+	properties->vendorId = 0;
+	strcpy(properties->systemName, "OpenComposite mock runtime");
+	properties->graphicsProperties.maxSwapchainImageWidth = 4096;
+	properties->graphicsProperties.maxSwapchainImageHeight = 4096;
+	properties->graphicsProperties.maxLayerCount = MAX_LAYER_COUNT;
+	properties->trackingProperties.orientationTracking = XR_TRUE;
+	properties->trackingProperties.positionTracking = XR_TRUE;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateEnvironmentBlendModes(XrInstance instanceHandle, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+    uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+
+	return FillArray(environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes, 1,
+	    [](XrEnvironmentBlendMode& mode, uint32_t) { mode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE; });
+}
+
+XrResult XRAPI_CALL xrEnumerateViewConfigurations(XrInstance instanceHandle, XrSystemId systemId, uint32_t viewConfigurationTypeCapacityInput,
+    uint32_t* viewConfigurationTypeCountOutput, XrViewConfigurationType* viewConfigurationTypes)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+
+	return FillArray(viewConfigurationTypeCapacityInput, viewConfigurationTypeCountOutput, viewConfigurationTypes, 1,
+	    [](XrViewConfigurationType& type, uint32_t) { type = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO; });
+}
+
+XrResult XRAPI_CALL xrGetViewConfigurationProperties(XrInstance instanceHandle, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+    XrViewConfigurationProperties* configurationProperties)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	MOCK_CHECK_TYPE(configurationProperties, XR_TYPE_VIEW_CONFIGURATION_PROPERTIES);
+
+	configurationProperties->viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	configurationProperties->fovMutable = XR_TRUE;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateViewConfigurationViews(XrInstance instanceHandle, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+    uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+
+	// Multisampled swapchains aren't supported, so OpenComposite has to resolve multisampled images itself
+	return FillArray(viewCapacityInput, viewCountOutput, views, 2, [](XrViewConfigurationView& view, uint32_t) {
+		view.recommendedImageRectWidth = VIEW_SIZE;
+		view.maxImageRectWidth = 4096;
+		view.recommendedImageRectHeight = VIEW_SIZE;
+		view.maxImageRectHeight = 4096;
+		view.recommendedSwapchainSampleCount = 1;
+		view.maxSwapchainSampleCount = 1;
+	});
+}
+
+// Sessions
+
+XrResult XRAPI_CALL xrCreateSession(XrInstance instanceHandle, const XrSessionCreateInfo* createInfo, XrSession* sessionHandle)
+{
+	MOCK_ENTRY();
+
+	Instance* instance = GetInstance(instanceHandle);
+	if (!instance)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_SESSION_CREATE_INFO);
+	if (!sessionHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+	if (createInfo->systemId != SYSTEM_ID)
+		return XR_ERROR_SYSTEM_INVALID;
+
+	const XrBaseInStructure* binding = (const XrBaseInStructure*)createInfo->next;
+	if (!binding)
+		return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+
+	std::unique_ptr<Session> session = std::make_unique<Session>();
+	session->instance = instance;
+
+	// The spec requires the graphics requirements are queried first, to make sure the app checked its version
+	// of the API is supported
+	if (binding->type == XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR && instance->extensions.count(XR_KHR_VULKAN_ENABLE_EXTENSION_NAME)) {
+		const XrGraphicsBindingVulkanKHR* vkBinding = (const XrGraphicsBindingVulkanKHR*)binding;
+		if (!instance->vulkanRequirementsQueried)
+			return XR_ERROR_GRAPHICS_REQUIREMENTS_CALL_MISSING;
+		if (!vkBinding->instance || !vkBinding->physicalDevice || !vkBinding->device)
+			return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+
+		session->vkInstance = vkBinding->instance;
+		session->physicalDevice = vkBinding->physicalDevice;
+		session->device = vkBinding->device;
+		session->queueFamilyIndex = vkBinding->queueFamilyIndex;
+		vkGetDeviceQueue(vkBinding->device, vkBinding->queueFamilyIndex, vkBinding->queueIndex, &session->queue);
+	} else if (binding->type == XR_TYPE_GRAPHICS_BINDING_OPENGL_XLIB_KHR && instance->extensions.count(XR_KHR_OPENGL_ENABLE_EXTENSION_NAME)) {
+		if (!instance->openGLRequirementsQueried)
+			return XR_ERROR_GRAPHICS_REQUIREMENTS_CALL_MISSING;
+
+		// The swapchains are made in the current context, so there has to be one
+		if (!glGetString(GL_VERSION))
+			return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+
+		session->openGL = true;
+	} else {
+		return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+	}
+
+	// Carry the time on from the previous session, so it never goes backwards
+	for (Session* other : instance->sessions)
+		session->lastDisplayTime = std::max(session->lastDisplayTime, other->lastDisplayTime);
+
+	Session* created = session.release();
+	sessions.insert(created);
+	instance->sessions.insert(created);
+	*sessionHandle = ToHandle<XrSession>(created);
+
+	// There's no headset to put on, so the session is ready straight away
+	SetSessionState(created, XR_SESSION_STATE_IDLE);
+	SetSessionState(created, XR_SESSION_STATE_READY);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySession(XrSession sessionHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	// The session's events aren't delivered once it's gone
+	std::deque<XrEventDataBuffer>& events = session->instance->events;
+	events.erase(std::remove_if(events.begin(), events.end(), [sessionHandle](const XrEventDataBuffer& event) {
+		if (event.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)
+			return ((const XrEventDataSessionStateChanged&)event).session == sessionHandle;
+		if (event.type == XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED)
+			return ((const XrEventDataInteractionProfileChanged&)event).session == sessionHandle;
+		return false;
+	}),
+	    events.end());
+
+	DestroySession(session);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrBeginSession(XrSession sessionHandle, const XrSessionBeginInfo* beginInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(beginInfo, XR_TYPE_SESSION_BEGIN_INFO);
+
+	if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	if (session->running)
+		return XR_ERROR_SESSION_RUNNING;
+	if (session->state != XR_SESSION_STATE_READY)
+		return XR_ERROR_SESSION_NOT_READY;
+
+	session->running = true;
+	SetSessionState(session, XR_SESSION_STATE_SYNCHRONIZED);
+	SetSessionState(session, XR_SESSION_STATE_VISIBLE);
+	SetSessionState(session, XR_SESSION_STATE_FOCUSED);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEndSession(XrSession sessionHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (!session->running)
+		return XR_ERROR_SESSION_NOT_RUNNING;
+	if (session->state != XR_SESSION_STATE_STOPPING)
+		return XR_ERROR_SESSION_NOT_STOPPING;
+
+	session->running = false;
+	session->framesWaiting = 0;
+	session->frameBegun = false;
+
+	SetSessionState(session, XR_SESSION_STATE_IDLE);
+	SetSessionState(session, session->exitRequested ? XR_SESSION_STATE_EXITING : XR_SESSION_STATE_READY);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrRequestExitSession(XrSession sessionHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (!session->running)
+		return XR_ERROR_SESSION_NOT_RUNNING;
+
+	session->exitRequested = true;
+	if (session->state == XR_SESSION_STATE_FOCUSED)
+		SetSessionState(session, XR_SESSION_STATE_VISIBLE);
+	if (session->state == XR_SESSION_STATE_VISIBLE)
+		SetSessionState(session, XR_SESSION_STATE_SYNCHRONIZED);
+	SetSessionState(session, XR_SESSION_STATE_STOPPING);
+	return XR_SUCCESS;
+}
+
+// Frames
+
+XrResult XRAPI_CALL xrWaitFrame(XrSession sessionHandle, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	if (frameWaitInfo && frameWaitInfo->type != XR_TYPE_FRAME_WAIT_INFO)
+		return XR_ERROR_VALIDATION_FAILURE;
+	MOCK_CHECK_TYPE(frameState, XR_TYPE_FRAME_STATE);
+
+	if (!session->running)
+		return XR_ERROR_SESSION_NOT_RUNNING;
+
+	session->framesWaited++;
+	session->framesWaiting++;
+	session->lastDisplayTime += FRAME_PERIOD;
+
+	// Only wait if asked to, so the benchmarks measure OpenComposite rather than the display
+	if (IsPaced()) {
+		static const auto start = std::chrono::steady_clock::now();
+		static uint64_t pacedFrames = 0;
+		std::this_thread::sleep_until(start + std::chrono::nanoseconds(FRAME_PERIOD * ++pacedFrames));
+	}
+
+	frameState->predictedDisplayTime = session->lastDisplayTime;
+	frameState->predictedDisplayPeriod = FRAME_PERIOD;
+	frameState->shouldRender = session->state == XR_SESSION_STATE_VISIBLE || session->state == XR_SESSION_STATE_FOCUSED;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrBeginFrame(XrSession sessionHandle, const XrFrameBeginInfo* frameBeginInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	if (frameBeginInfo && frameBeginInfo->type != XR_TYPE_FRAME_BEGIN_INFO)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (!session->running)
+		return XR_ERROR_SESSION_NOT_RUNNING;
+	if (session->framesWaiting == 0)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	session->framesWaiting--;
+
+	// Beginning a frame without ending the last one throws the last one away
+	if (session->frameBegun)
+		return XR_FRAME_DISCARDED;
+
+	session->frameBegun = true;
+	return XR_SUCCESS;
+}
+
+static XrResult CheckSubImage(Session* session, const XrSwapchainSubImage& subImage, uint32_t& image)
+{
+	Swapchain* swapchain = GetSwapchain(subImage.swapchain);
+	if (!swapchain || swapchain->session != session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	// The image shown is the one last released, so there has to be one
+	if (swapchain->lastReleased < 0)
+		return XR_ERROR_LAYER_INVALID;
+	image = (uint32_t)swapchain->lastReleased;
+
+	const XrRect2Di& rect = subImage.imageRect;
+	if (rect.offset.x < 0 || rect.offset.y < 0 || rect.extent.width <= 0 || rect.extent.height <= 0
+	    || (uint32_t)(rect.offset.x + rect.extent.width) > swapchain->info.width
+	    || (uint32_t)(rect.offset.y + rect.extent.height) > swapchain->info.height)
+		return XR_ERROR_SWAPCHAIN_RECT_INVALID;
+
+	if (subImage.imageArrayIndex >= swapchain->info.arraySize)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	return XR_SUCCESS;
+}
+
+static void StoreSubImage(OCMockXrLayer& out, int view, const XrSwapchainSubImage& subImage, uint32_t image)
+{
+	out.swapchains[view] = (uint64_t)(uintptr_t)subImage.swapchain;
+	out.images[view] = image;
+	out.arrayIndices[view] = subImage.imageArrayIndex;
+	out.rects[view][0] = subImage.imageRect.offset.x;
+	out.rects[view][1] = subImage.imageRect.offset.y;
+	out.rects[view][2] = subImage.imageRect.extent.width;
+	out.rects[view][3] = subImage.imageRect.extent.height;
+}
+
+static void StorePose(OCMockXrLayer& out, const XrPosef& pose)
+{
+	out.position[0] = pose.position.x;
+	out.position[1] = pose.position.y;
+	out.position[2] = pose.position.z;
+	out.orientation[0] = pose.orientation.x;
+	out.orientation[1] = pose.orientation.y;
+	out.orientation[2] = pose.orientation.z;
+	out.orientation[3] = pose.orientation.w;
+}
+
+// Checks a layer in the same way a runtime would have to before showing it, and records what was in it
+static XrResult CheckLayer(Session* session, const XrCompositionLayerBaseHeader* header, OCMockXrLayer& out)
+{
+	out = {};
+	out.type = header->type;
+	out.viewCount = 1;
+
+	Space* space = GetSpace(header->space);
+	if (!space || space->session != session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	uint32_t image;
+	XrResult result;
+
+	switch (header->type) {
+	case XR_TYPE_COMPOSITION_LAYER_PROJECTION: {
+		const XrCompositionLayerProjection* layer = (const XrCompositionLayerProjection*)header;
+		if (layer->viewCount != 2 || !layer->views)
+			return XR_ERROR_VALIDATION_FAILURE;
+
+		out.viewCount = 2;
+		for (int i = 0; i < 2; i++) {
+			const XrCompositionLayerProjectionView& view = layer->views[i];
+			if (view.type != XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW)
+				return XR_ERROR_VALIDATION_FAILURE;
+			if (!IsPoseValid(view.pose))
+				return XR_ERROR_POSE_INVALID;
+			if (XR_FAILED(result = CheckSubImage(session, view.subImage, image)))
+				return result;
+			StoreSubImage(out, i, view.subImage, image);
+
+			const XrCompositionLayerDepthInfoKHR* depth = (const XrCompositionLayerDepthInfoKHR*)view.next;
+			if (depth && depth->type == XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR) {
+				if (!session->instance->extensions.count(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME))
+					return XR_ERROR_VALIDATION_FAILURE;
+				if (depth->minDepth < 0 || depth->maxDepth > 1 || depth->minDepth > depth->maxDepth)
+					return XR_ERROR_VALIDATION_FAILURE;
+				if (XR_FAILED(result = CheckSubImage(session, depth->subImage, image)))
+					return result;
+				out.hasDepth = 1;
+			}
+		}
+		return XR_SUCCESS;
+	}
+	case XR_TYPE_COMPOSITION_LAYER_QUAD: {
+		const XrCompositionLayerQuad* layer = (const XrCompositionLayerQuad*)header;
+		if (!IsPoseValid(layer->pose))
+			return XR_ERROR_POSE_INVALID;
+		if (XR_FAILED(result = CheckSubImage(session, layer->subImage, image)))
+			return result;
+
+		StoreSubImage(out, 0, layer->subImage, image);
+		StorePose(out, layer->pose);
+		out.size[0] = layer->size.width;
+		out.size[1] = layer->size.height;
+		return XR_SUCCESS;
+	}
+	case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR: {
+		if (!session->instance->extensions.count(XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME))
+			return XR_ERROR_LAYER_INVALID;
+
+		const XrCompositionLayerCylinderKHR* layer = (const XrCompositionLayerCylinderKHR*)header;
+		if (!IsPoseValid(layer->pose))
+			return XR_ERROR_POSE_INVALID;
+		if (!(layer->radius >= 0) || !(layer->centralAngle >= 0 && layer->centralAngle <= 2 * M_PI) || !(layer->aspectRatio > 0))
+			return XR_ERROR_VALIDATION_FAILURE;
+		if (XR_FAILED(result = CheckSubImage(session, layer->subImage, image)))
+			return result;
+
+		StoreSubImage(out, 0, layer->subImage, image);
+		StorePose(out, layer->pose);
+		out.size[0] = layer->radius;
+		out.size[1] = layer->aspectRatio;
+		return XR_SUCCESS;
+	}
+	case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR: {
+		if (!session->instance->extensions.count(XR_KHR_COMPOSITION_LAYER_CUBE_EXTENSION_NAME))
+			return XR_ERROR_LAYER_INVALID;
+
+		const XrCompositionLayerCubeKHR* layer = (const XrCompositionLayerCubeKHR*)header;
+		Swapchain* swapchain = GetSwapchain(layer->swapchain);
+		if (!swapchain || swapchain->session != session)
+			return XR_ERROR_HANDLE_INVALID;
+		if (swapchain->info.faceCount != 6 || swapchain->lastReleased < 0)
+			return XR_ERROR_LAYER_INVALID;
+
+		out.swapchains[0] = (uint64_t)(uintptr_t)layer->swapchain;
+		out.images[0] = (uint32_t)swapchain->lastReleased;
+		out.arrayIndices[0] = layer->imageArrayIndex;
+		StorePose(out, { layer->orientation, { 0, 0, 0 } });
+		return XR_SUCCESS;
+	}
+	default:
+		return XR_ERROR_LAYER_INVALID;
+	}
+}
+
+XrResult XRAPI_CALL xrEndFrame(XrSession sessionHandle, const XrFrameEndInfo* frameEndInfo)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(frameEndInfo, XR_TYPE_FRAME_END_INFO);
+
+	if (!session->running)
+		return XR_ERROR_SESSION_NOT_RUNNING;
+	if (!session->frameBegun)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	if (frameEndInfo->displayTime <= 0)
+		return XR_ERROR_TIME_INVALID;
+	if (frameEndInfo->environmentBlendMode != XR_ENVIRONMENT_BLEND_MODE_OPAQUE)
+		return XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED;
+	if (frameEndInfo->layerCount > MAX_LAYER_COUNT)
+		return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+	if (frameEndInfo->layerCount != 0 && !frameEndInfo->layers)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	std::vector<OCMockXrLayer> layers(frameEndInfo->layerCount);
+	for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
+		const XrCompositionLayerBaseHeader* header = frameEndInfo->layers[i];
+		if (!header)
+			return XR_ERROR_LAYER_INVALID;
+
+		XrResult result = CheckLayer(session, header, layers[i]);
+		if (XR_FAILED(result))
+			return result;
+	}
+
+	session->frameBegun = false;
+	lastFrameLayers = std::move(layers);
+	framesEnded++;
+	return XR_SUCCESS;
+}
+
+// XR_KHR_vulkan_enable
+
+XrResult XRAPI_CALL xrGetVulkanInstanceExtensionsKHR(XrInstance instanceHandle, XrSystemId systemId, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+
+	// Nothing's shared outside the process, so no extensions are needed
+	return FillString(bufferCapacityInput, bufferCountOutput, buffer, "");
+}
+
+XrResult XRAPI_CALL xrGetVulkanDeviceExtensionsKHR(XrInstance instanceHandle, XrSystemId systemId, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+
+	return FillString(bufferCapacityInput, bufferCountOutput, buffer, "");
+}
+
+XrResult XRAPI_CALL xrGetVulkanGraphicsDeviceKHR(XrInstance instanceHandle, XrSystemId systemId, VkInstance vkInstance, VkPhysicalDevice* vkPhysicalDevice)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	if (!vkInstance || !vkPhysicalDevice)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	uint32_t count = 0;
+	if (vkEnumeratePhysicalDevices(vkInstance, &count, nullptr) != VK_SUCCESS || count == 0)
+		return XR_ERROR_RUNTIME_FAILURE;
+	std::vector<VkPhysicalDevice> devices(count);
+	if (vkEnumeratePhysicalDevices(vkInstance, &count, devices.data()) != VK_SUCCESS)
+		return XR_ERROR_RUNTIME_FAILURE;
+	devices.resize(count);
+
+	// Use a software renderer if there is one, so the results are the same on every machine
+	*vkPhysicalDevice = devices.at(0);
+	for (VkPhysicalDevice device : devices) {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device, &properties);
+		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+			*vkPhysicalDevice = device;
+			break;
+		}
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetVulkanGraphicsRequirementsKHR(XrInstance instanceHandle, XrSystemId systemId, XrGraphicsRequirementsVulkanKHR* graphicsRequirements)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	MOCK_CHECK_TYPE(graphicsRequirements, XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN_KHR);
+
+	graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(1, 0, 0);
+	graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(1, 3, 0);
+
+	GetInstance(instanceHandle)->vulkanRequirementsQueried = true;
+	return XR_SUCCESS;
+}
+
+// XR_KHR_opengl_enable
+
+XrResult XRAPI_CALL xrGetOpenGLGraphicsRequirementsKHR(XrInstance instanceHandle, XrSystemId systemId, XrGraphicsRequirementsOpenGLKHR* graphicsRequirements)
+{
+	MOCK_ENTRY();
+
+	if (XrResult result = CheckSystem(instanceHandle, systemId); XR_FAILED(result))
+		return result;
+	MOCK_CHECK_TYPE(graphicsRequirements, XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_KHR);
+
+	// The swapchains are immutable textures, made with glTexStorage2D
+	graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(4, 2, 0);
+	graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(4, 6, 0);
+
+	GetInstance(instanceHandle)->openGLRequirementsQueried = true;
+	return XR_SUCCESS;
+}
+
+} // namespace mock
+
+using namespace mock;
+
+// The loader's entry point. This is the only symbol the runtime needs to export for the loader.
+
+extern "C" __attribute__((visibility("default"))) XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(
+    const XrNegotiateLoaderInfo* loaderInfo, XrNegotiateRuntimeRequest* runtimeRequest)
+{
+	if (!loaderInfo || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO
+	    || loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION || loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo))
+		return XR_ERROR_INITIALIZATION_FAILED;
+
+	if (!runtimeRequest || runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST
+	    || runtimeRequest->structVersion != XR_RUNTIME_INFO_STRUCT_VERSION || runtimeRequest->structSize != sizeof(XrNegotiateRuntimeRequest))
+		return XR_ERROR_INITIALIZATION_FAILED;
+
+	if (loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION || loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION)
+		return XR_ERROR_INITIALIZATION_FAILED;
+
+	if (loaderInfo->minApiVersion > XR_CURRENT_API_VERSION || XR_VERSION_MAJOR(loaderInfo->maxApiVersion) < 1)
+		return XR_ERROR_INITIALIZATION_FAILED;
+
+	runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+	runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+	runtimeRequest->getInstanceProcAddr = mock::xrGetInstanceProcAddr;
+	return XR_SUCCESS;
+}
+
+// The functions for the tests, see MockRuntime.h
+
+OC_MOCK_XR_EXPORT uint64_t OCMockXr_GetTotalCalls(void)
+{
+	return totalCalls.load(std::memory_order_relaxed);
+}
+
+OC_MOCK_XR_EXPORT uint32_t OCMockXr_GetCallCounts(OCMockXrCallCount* counts, uint32_t capacity)
+{
+	uint32_t count = 0;
+	for (CallCounter* counter = counters.load(std::memory_order_acquire); counter; counter = counter->next) {
+		if (count < capacity)
+			counts[count] = { counter->name, counter->calls.load(std::memory_order_relaxed) };
+		count++;
+	}
+	return count;
+}
+
+OC_MOCK_XR_EXPORT uint64_t OCMockXr_GetFrameCount(void)
+{
+	return framesEnded.load(std::memory_order_relaxed);
+}
+
+OC_MOCK_XR_EXPORT uint32_t OCMockXr_GetLastFrameLayers(OCMockXrLayer* layers, uint32_t capacity)
+{
+	std::lock_guard<std::mutex> guard(runtimeLock);
+
+	uint32_t count = (uint32_t)lastFrameLayers.size();
+	for (uint32_t i = 0; i < count && i < capacity; i++)
+		layers[i] = lastFrameLayers[i];
+	return count;
+}
+
+OC_MOCK_XR_EXPORT int OCMockXr_GetSwapchainInfo(uint64_t swapchainHandle, OCMockXrSwapchainInfo* info)
+{
+	std::lock_guard<std::mutex> guard(runtimeLock);
+
+	Swapchain* swapchain = GetSwapchain((XrSwapchain)swapchainHandle);
+	if (!swapchain)
+		return 0;
+
+	info->format = swapchain->info.format;
+	info->width = swapchain->info.width;
+	info->height = swapchain->info.height;
+	info->arraySize = swapchain->info.arraySize;
+	info->faceCount = swapchain->info.faceCount;
+	info->imageCount = swapchain->imageCount;
+	return 1;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * A headless OpenXR runtime for the tests and benchmarks, so OpenComposite can be run end-to-end without a headset.
+ * It's selected by pointing XR_RUNTIME_JSON at the mock_runtime.json manifest that's generated next to the tests.
+ *
+ * Everything it reports is a function of the frame being rendered, rather than the time it's rendered at: the
+ * frames are 1/90th of a second apart, the head and hands move along fixed paths, and the inputs go up and down in
+ * fixed patterns. Running the same thing twice gives exactly the same results. xrWaitFrame doesn't wait either,
+ * unless OC_MOCK_XR_PACED is set, so frames are only as slow as OpenComposite makes them.
+ *
+ * Swapchains are real Vulkan images, created on whatever device the session was created with. The mock prefers
+ * a CPU device (lavapipe), so it works on machines without a GPU and the images come out the same everywhere.
+ * OpenGL sessions are supported too (through XR_KHR_opengl_enable's Xlib binding), with the swapchains made as
+ * textures in whichever context is current when the runtime is called. That can be an EGL context, since the
+ * GLX handles in the binding aren't used, so the tests can run on llvmpipe without an X server.
+ *
+ * It implements the parts of OpenXR that OpenComposite uses, and checks they're called correctly (in the right
+ * order, with valid handles, layers and paths) the same way a strict runtime would. The interaction profile for
+ * the hands is the Index controller if bindings were suggested for it, or can be picked with OC_MOCK_XR_PROFILE.
+ *
+ * The tests link to the mock directly, which gets them the same copy the OpenXR loader loads, to look at what
+ * OpenComposite did with it through the functions below. They're safe to call from any thread.
+ */
+
+#ifdef __cplusplus
+#define OC_MOCK_XR_EXPORT extern "C" __attribute__((visibility("default")))
+#else
+#define OC_MOCK_XR_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct OCMockXrCallCount {
+	const char* name;
+	uint64_t calls;
+} OCMockXrCallCount;
+
+// One composition layer from the last frame that was submitted
+typedef struct OCMockXrLayer {
+	uint32_t type; // The layer's XrStructureType
+	uint32_t viewCount; // Two for projection layers, one for everything else
+	uint64_t swapchains[2];
+	uint32_t images[2]; // The index of the swapchain image that was shown
+	uint32_t arrayIndices[2];
+	int32_t rects[2][4]; // x, y, width and height
+	float position[3]; // For quad, cylinder and cube layers
+	float orientation[4]; // x, y, z, w
+	float size[2]; // The quad's size, or the cylinder's radius and aspect ratio
+	uint32_t hasDepth; // Set if a projection layer had depth info attached
+} OCMockXrLayer;
+
+typedef struct OCMockXrSwapchainInfo {
+	int64_t format; // The VkFormat, or the OpenGL internal format
+	uint32_t width;
+	uint32_t height;
+	uint32_t arraySize;
+	uint32_t faceCount;
+	uint32_t imageCount;
+} OCMockXrSwapchainInfo;
+
+// The number of OpenXR calls made into the runtime so far, including those made by the loader
+OC_MOCK_XR_EXPORT uint64_t OCMockXr_GetTotalCalls(void);
+
+// Lists how many times each function has been called. Returns the number of functions, which may be more than capacity.
+OC_MOCK_XR_EXPORT uint32_t OCMockXr_GetCallCounts(OCMockXrCallCount* counts, uint32_t capacity);
+
+// The number of frames that have been ended with xrEndFrame
+OC_MOCK_XR_EXPORT uint64_t OCMockXr_GetFrameCount(void);
+
+// Lists the layers of the last frame. Returns the number of layers, which may be more than capacity.
+OC_MOCK_XR_EXPORT uint32_t OCMockXr_GetLastFrameLayers(OCMockXrLayer* layers, uint32_t capacity);
+
+// Returns zero if the swapchain doesn't exist (any more)
+OC_MOCK_XR_EXPORT int OCMockXr_GetSwapchainInfo(uint64_t swapchain, OCMockXrSwapchainInfo* info);
+
+/**
+ * Copies one of a colour swapchain's images back to the CPU, in the tightly-packed layout of its format. Only
+ * formats with four bytes per pixel can be read. This uses the session's queue, and waits for it to finish, so
+ * nothing else may use the queue at the same time. Returns zero if the image couldn't be read.
+ *
+ * OpenGL swapchains are read in the current context, so this must be called on the thread the app's context is
+ * current on. Their rows come back bottom-up, as OpenGL stores them.
+ */
+OC_MOCK_XR_EXPORT int OCMockXr_ReadSwapchainImage(uint64_t swapchain, uint32_t image, uint32_t arrayIndex, void* pixels, uint64_t size);
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "MockRuntime.h"
+
+// OpenGL swapchains are made with glTexStorage2D, which gl.h only declares along with the extensions
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <vulkan/vulkan.h>
+
+// The entry points are only reached through xrGetInstanceProcAddr, so they're declared in the mock namespace below
+#define XR_NO_PROTOTYPES
+#define XR_USE_GRAPHICS_API_VULKAN
+#define XR_USE_GRAPHICS_API_OPENGL
+#define XR_USE_PLATFORM_XLIB
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
+#include <openxr/openxr_platform.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace mock {
+
+// Counts the calls to one function, see MOCK_ENTRY. These are static, and live forever.
+struct CallCounter {
+	explicit CallCounter(const char* name);
+
+	const char* name;
+	std::atomic<uint64_t> calls = 0;
+	CallCounter* next = nullptr;
+
+	void Count();
+};
+
+// Held by every entry point, so the runtime's state never has to be thought about across threads
+extern std::mutex runtimeLock;
+
+// Put at the start of every entry point, to count the call and lock the runtime for the rest of it
+#define MOCK_ENTRY()                                     \
+	static mock::CallCounter callCounter(__func__);      \
+	callCounter.Count();                                 \
+	std::lock_guard<std::mutex> entryGuard(mock::runtimeLock)
+
+#define MOCK_CHECK_TYPE(value, structType)                      \
+	do {                                                        \
+		if (!(value) || (value)->type != (structType))          \
+			return XR_ERROR_VALIDATION_FAILURE;                 \
+	} while (0)
+
+// Frames are a 90Hz display's worth apart, starting a second after the epoch so no valid time is zero
+static const XrTime TIME_BASE = 1000000000;
+static const XrDuration FRAME_PERIOD = 1000000000 / 90;
+
+static const XrSystemId SYSTEM_ID = 1;
+static const uint32_t VIEW_SIZE = 1024;
+static const uint32_t MAX_LAYER_COUNT = 256;
+static const uint32_t SWAPCHAIN_LENGTH = 3;
+
+struct Session;
+struct ActionSet;
+struct Action;
+
+struct Instance {
+	std::set<std::string> extensions;
+	XrVersion apiVersion = 0;
+	bool vulkanRequirementsQueried = false;
+	bool openGLRequirementsQueried = false;
+
+	std::deque<XrEventDataBuffer> events;
+
+	// XrPaths are the index into this plus one, so XR_NULL_PATH is never used
+	std::vector<std::string> paths;
+	std::unordered_map<std::string, XrPath> pathIds;
+
+	// The latest bindings suggested for each interaction profile
+	std::map<XrPath, std::vector<XrActionSuggestedBinding>> suggestedBindings;
+
+	std::set<Session*> sessions;
+	std::set<ActionSet*> actionSets;
+};
+
+struct ActionSet {
+	Instance* instance;
+	std::string name;
+	std::string localizedName;
+	uint32_t priority;
+
+	// Once attached to a session, the set and its actions can't be changed and bindings can't be suggested for them
+	bool attached = false;
+
+	std::set<Action*> actions;
+};
+
+struct Action {
+	ActionSet* set;
+	std::string name;
+	std::string localizedName;
+	XrActionType type;
+	std::vector<XrPath> subactionPaths;
+};
+
+struct Space {
+	Session* session;
+
+	// Either a reference space, or an action space if action is set
+	XrReferenceSpaceType referenceType;
+	Action* action = nullptr;
+	XrPath subactionPath = XR_NULL_PATH;
+	bool actionDestroyed = false; // The space stays valid, but is never tracked again
+
+	XrPosef offset;
+};
+
+struct Swapchain {
+	Session* session;
+	XrSwapchainCreateInfo info;
+
+	// Vulkan images and their memory, or OpenGL textures, depending on the session
+	uint32_t imageCount = 0;
+	std::vector<VkImage> images;
+	std::vector<VkDeviceMemory> memory;
+	std::vector<GLuint> textures;
+
+	// Images are handed out in turn. Only the oldest acquired image can be waited on, and then released.
+	uint32_t nextImage = 0;
+	std::deque<uint32_t> acquired;
+	bool frontWaited = false;
+	int32_t lastReleased = -1;
+	bool staticImageUsed = false;
+
+	// Images that have been released at least once, and so are in the colour attachment layout
+	std::vector<bool> released;
+};
+
+struct Session {
+	Instance* instance;
+	XrSessionState state = XR_SESSION_STATE_UNKNOWN;
+	bool running = false;
+	bool exitRequested = false;
+
+	// OpenGL sessions use whichever context is current when they're called, as there's nothing useful in the
+	// binding: OpenComposite only passes the GLX handles, and they're null when the app is using EGL.
+	bool openGL = false;
+
+	// The Vulkan objects from the graphics binding
+	VkInstance vkInstance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	uint32_t queueFamilyIndex = 0;
+	VkQueue queue = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE; // Created the first time an image is read back
+
+	// The number of frames waited for but not yet begun, and whether one has been begun but not ended
+	uint32_t framesWaiting = 0;
+	bool frameBegun = false;
+	uint64_t framesWaited = 0;
+	XrTime lastDisplayTime = TIME_BASE;
+
+	// Input, which only starts working once action sets are attached
+	bool actionSetsAttached = false;
+	std::vector<ActionSet*> attachedSets;
+	std::map<XrPath, std::vector<XrActionSuggestedBinding>> bindings; // The instance's suggestions when attached
+	XrPath profile = XR_NULL_PATH; // Picked when attached, and made current by the first xrSyncActions
+	bool profileCurrent = false;
+	std::vector<XrActiveActionSet> activeSets; // From the last xrSyncActions, and empty if that wasn't focused
+	uint64_t syncCount = 0;
+	XrTime syncTime = 0;
+	XrTime previousSyncTime = 0;
+
+	std::set<Space*> spaces;
+	std::set<Swapchain*> swapchains;
+};
+
+// Handles are just pointers to these objects
+template <typename T, typename H>
+inline T* FromHandle(H handle)
+{
+	return (T*)(uintptr_t)handle;
+}
+
+template <typename H, typename T>
+inline H ToHandle(T* object)
+{
+	return (H)(uintptr_t)object;
+}
+
+// These check the handle is one the runtime made, and hasn't been destroyed
+Instance* GetInstance(XrInstance handle);
+Session* GetSession(XrSession handle);
+Space* GetSpace(XrSpace handle);
+Swapchain* GetSwapchain(XrSwapchain handle);
+ActionSet* GetActionSet(XrActionSet handle);
+Action* GetAction(XrAction handle);
+
+// The runtime's objects, so handles can be checked and the mock's exported functions can find them
+extern std::set<Instance*> instances;
+extern std::set<Session*> sessions;
+extern std::set<Swapchain*> swapchains;
+extern std::set<Space*> spaces;
+extern std::set<ActionSet*> actionSets;
+extern std::set<Action*> actions;
+
+// Fills in an array using OpenXR's two-call idiom, with fill(element, index) setting each element
+template <typename T, typename F>
+XrResult FillArray(uint32_t capacity, uint32_t* countOutput, T* output, uint32_t count, F fill)
+{
+	if (!countOutput)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	*countOutput = count;
+	if (capacity == 0)
+		return XR_SUCCESS;
+	if (capacity < count)
+		return XR_ERROR_SIZE_INSUFFICIENT;
+	if (!output)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	for (uint32_t i = 0; i < count; i++)
+		fill(output[i], i);
+	return XR_SUCCESS;
+}
+
+// The same for strings, where the count includes the null terminator
+XrResult FillString(uint32_t capacity, uint32_t* countOutput, char* buffer, const std::string& value);
+
+// Queue an event for xrPollEvent
+void PushEvent(Instance* instance, const void* event, size_t size);
+
+// Checks paths in the same way as xrStringToPath, which requires them to be lowercase
+bool IsValidPath(const std::string& path);
+const std::string& PathString(Instance* instance, XrPath path);
+
+// Releases everything that belongs to a session, when it's destroyed
+void DestroySessionInput(Session* session);
+void DestroySwapchainImages(Swapchain* swapchain);
+
+// MockSpaces.cpp
+bool IsPoseValid(const XrPosef& pose);
+
+// MockInput.cpp
+// Finds the hand (0 is left) and pose (grip or aim) a pose action is bound to. Returns false if it's not tracked.
+bool FindPoseSource(Session* session, Action* action, XrPath subactionPath, int* hand, bool* aim);
+
+// The entry points, in the order of the OpenXR spec
+XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
+XrResult XRAPI_CALL xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput, uint32_t* propertyCountOutput, XrApiLayerProperties* properties);
+XrResult XRAPI_CALL xrEnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput, uint32_t* propertyCountOutput, XrExtensionProperties* properties);
+XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance);
+XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance);
+XrResult XRAPI_CALL xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties);
+XrResult XRAPI_CALL xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData);
+XrResult XRAPI_CALL xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE]);
+XrResult XRAPI_CALL xrStructureTypeToString(XrInstance instance, XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE]);
+XrResult XRAPI_CALL xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId);
+XrResult XRAPI_CALL xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties);
+XrResult XRAPI_CALL xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes);
+XrResult XRAPI_CALL xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session);
+XrResult XRAPI_CALL xrDestroySession(XrSession session);
+XrResult XRAPI_CALL xrEnumerateReferenceSpaces(XrSession session, uint32_t spaceCapacityInput, uint32_t* spaceCountOutput, XrReferenceSpaceType* spaces);
+XrResult XRAPI_CALL xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space);
+XrResult XRAPI_CALL xrGetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType referenceSpaceType, XrExtent2Df* bounds);
+XrResult XRAPI_CALL xrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space);
+XrResult XRAPI_CALL xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location);
+XrResult XRAPI_CALL xrDestroySpace(XrSpace space);
+XrResult XRAPI_CALL xrEnumerateViewConfigurations(XrInstance instance, XrSystemId systemId, uint32_t viewConfigurationTypeCapacityInput, uint32_t* viewConfigurationTypeCountOutput, XrViewConfigurationType* viewConfigurationTypes);
+XrResult XRAPI_CALL xrGetViewConfigurationProperties(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, XrViewConfigurationProperties* configurationProperties);
+XrResult XRAPI_CALL xrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views);
+XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats);
+XrResult XRAPI_CALL xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain);
+XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain swapchain);
+XrResult XRAPI_CALL xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images);
+XrResult XRAPI_CALL xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index);
+XrResult XRAPI_CALL xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo);
+XrResult XRAPI_CALL xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo);
+XrResult XRAPI_CALL xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo);
+XrResult XRAPI_CALL xrEndSession(XrSession session);
+XrResult XRAPI_CALL xrRequestExitSession(XrSession session);
+XrResult XRAPI_CALL xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState);
+XrResult XRAPI_CALL xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo);
+XrResult XRAPI_CALL xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo);
+XrResult XRAPI_CALL xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views);
+XrResult XRAPI_CALL xrStringToPath(XrInstance instance, const char* pathString, XrPath* path);
+XrResult XRAPI_CALL xrPathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer);
+XrResult XRAPI_CALL xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet);
+XrResult XRAPI_CALL xrDestroyActionSet(XrActionSet actionSet);
+XrResult XRAPI_CALL xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action);
+XrResult XRAPI_CALL xrDestroyAction(XrAction action);
+XrResult XRAPI_CALL xrSuggestInteractionProfileBindings(XrInstance instance, const XrInteractionProfileSuggestedBinding* suggestedBindings);
+XrResult XRAPI_CALL xrAttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo* attachInfo);
+XrResult XRAPI_CALL xrGetCurrentInteractionProfile(XrSession session, XrPath topLevelUserPath, XrInteractionProfileState* interactionProfile);
+XrResult XRAPI_CALL xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state);
+XrResult XRAPI_CALL xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state);
+XrResult XRAPI_CALL xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* state);
+XrResult XRAPI_CALL xrGetActionStatePose(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStatePose* state);
+XrResult XRAPI_CALL xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo);
+XrResult XRAPI_CALL xrEnumerateBoundSourcesForAction(XrSession session, const XrBoundSourcesForActionEnumerateInfo* enumerateInfo, uint32_t sourceCapacityInput, uint32_t* sourceCountOutput, XrPath* sources);
+XrResult XRAPI_CALL xrGetInputSourceLocalizedName(XrSession session, const XrInputSourceLocalizedNameGetInfo* getInfo, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer);
+XrResult XRAPI_CALL xrApplyHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo, const XrHapticBaseHeader* hapticFeedback);
+XrResult XRAPI_CALL xrStopHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo);
+
+// XR_KHR_vulkan_enable
+XrResult XRAPI_CALL xrGetVulkanInstanceExtensionsKHR(XrInstance instance, XrSystemId systemId, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer);
+XrResult XRAPI_CALL xrGetVulkanDeviceExtensionsKHR(XrInstance instance, XrSystemId systemId, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer);
+XrResult XRAPI_CALL xrGetVulkanGraphicsDeviceKHR(XrInstance instance, XrSystemId systemId, VkInstance vkInstance, VkPhysicalDevice* vkPhysicalDevice);
+XrResult XRAPI_CALL xrGetVulkanGraphicsRequirementsKHR(XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsVulkanKHR* graphicsRequirements);
+
+// XR_KHR_opengl_enable
+XrResult XRAPI_CALL xrGetOpenGLGraphicsRequirementsKHR(XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsOpenGLKHR* graphicsRequirements);
+
+#ifdef XR_KHR_locate_spaces
+// XR_KHR_locate_spaces, and xrLocateSpaces in OpenXR 1.1
+XrResult XRAPI_CALL xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR* locateInfo, XrSpaceLocationsKHR* spaceLocations);
+#endif
+
+} // namespace mock
@@ -0,0 +1,428 @@
+#include "MockRuntimePrivate.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Reference and action spaces, and the scripted paths the head and hands follow. Everything is worked out in the
+// stage space first, then moved into whatever space it was located in.
+
+namespace mock {
+
+static const float EYE_OFFSET = 0.032f; // Half the IPD
+static const float EYE_FOV = 0.8f; // Each way from the centre, in radians
+
+static const XrPosef IDENTITY_POSE = { { 0, 0, 0, 1 }, { 0, 0, 0 } };
+
+static XrQuaternionf Multiply(const XrQuaternionf& a, const XrQuaternionf& b)
+{
+	return {
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+	};
+}
+
+static XrVector3f Rotate(const XrQuaternionf& q, const XrVector3f& v)
+{
+	XrQuaternionf p = Multiply(Multiply(q, { v.x, v.y, v.z, 0 }), { -q.x, -q.y, -q.z, q.w });
+	return { p.x, p.y, p.z };
+}
+
+// Applies b in a's space
+static XrPosef Compose(const XrPosef& a, const XrPosef& b)
+{
+	XrVector3f offset = Rotate(a.orientation, b.position);
+	return {
+		Multiply(a.orientation, b.orientation),
+		{ a.position.x + offset.x, a.position.y + offset.y, a.position.z + offset.z },
+	};
+}
+
+static XrPosef Invert(const XrPosef& pose)
+{
+	XrQuaternionf inverse = { -pose.orientation.x, -pose.orientation.y, -pose.orientation.z, pose.orientation.w };
+	XrVector3f position = Rotate(inverse, pose.position);
+	return { inverse, { -position.x, -position.y, -position.z } };
+}
+
+// Yaw is about the up axis, then pitch about the (yawed) left-right axis
+static XrQuaternionf FromYawPitch(float yaw, float pitch)
+{
+	XrQuaternionf yawQuat = { 0, sinf(yaw / 2), 0, cosf(yaw / 2) };
+	XrQuaternionf pitchQuat = { sinf(pitch / 2), 0, 0, cosf(pitch / 2) };
+	return Multiply(yawQuat, pitchQuat);
+}
+
+bool IsPoseValid(const XrPosef& pose)
+{
+	const XrQuaternionf& q = pose.orientation;
+	float length = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+	if (!(fabsf(length - 1) < 0.01f))
+		return false;
+
+	return isfinite(pose.position.x) && isfinite(pose.position.y) && isfinite(pose.position.z);
+}
+
+static double Seconds(XrTime time)
+{
+	return (double)(time - TIME_BASE) / 1e9;
+}
+
+// The head sways and looks around a little, standing roughly where a 1.7m-tall person's eyes would be
+static XrPosef HeadPose(XrTime time)
+{
+	double t = Seconds(time);
+	XrPosef pose;
+	pose.position = { (float)(0.1 * sin(0.5 * t)), (float)(1.7 + 0.02 * sin(1.3 * t)), (float)(0.1 * cos(0.4 * t)) };
+	pose.orientation = FromYawPitch((float)(0.3 * sin(0.7 * t)), (float)(0.1 * sin(0.9 * t)));
+	return pose;
+}
+
+// The hands circle in front of the body, out of step with each other
+static XrPosef HandPose(int hand, XrTime time, bool aim)
+{
+	double t = Seconds(time);
+	double side = hand == 0 ? -1 : 1;
+	double phase = hand == 0 ? 0 : 1.5;
+
+	XrPosef pose;
+	pose.position = {
+		(float)(side * 0.2 + 0.05 * sin(1.1 * t + phase)),
+		(float)(1.2 + 0.05 * cos(1.1 * t + phase)),
+		(float)(-0.3 + 0.03 * sin(0.6 * t)),
+	};
+	pose.orientation = FromYawPitch((float)(side * -0.2 + 0.1 * sin(0.8 * t + phase)), (float)(0.2 * sin(0.5 * t)));
+
+	// The aim pose points along the controller, forwards and down from the grip
+	if (aim)
+		pose = Compose(pose, { FromYawPitch(0, -0.7f), { 0, 0, -0.05f } });
+
+	return pose;
+}
+
+// Finds a space's pose in the stage space, returning false if it isn't being tracked
+static bool GetStagePose(Space* space, XrTime time, XrPosef* pose)
+{
+	XrPosef origin;
+
+	if (space->actionDestroyed)
+		return false;
+
+	if (space->action) {
+		int hand;
+		bool aim;
+		if (!FindPoseSource(space->session, space->action, space->subactionPath, &hand, &aim))
+			return false;
+		origin = HandPose(hand, time, aim);
+	} else {
+		switch (space->referenceType) {
+		case XR_REFERENCE_SPACE_TYPE_VIEW:
+			origin = HeadPose(time);
+			break;
+		case XR_REFERENCE_SPACE_TYPE_LOCAL:
+			origin = { { 0, 0, 0, 1 }, { 0, 1.7f, 0 } };
+			break;
+		default:
+			origin = IDENTITY_POSE;
+			break;
+		}
+	}
+
+	*pose = Compose(origin, space->offset);
+	return true;
+}
+
+static bool GetRelativePose(Space* space, Space* base, XrTime time, XrPosef* pose)
+{
+	XrPosef spacePose, basePose;
+	if (!GetStagePose(space, time, &spacePose) || !GetStagePose(base, time, &basePose))
+		return false;
+
+	*pose = Compose(Invert(basePose), spacePose);
+	return true;
+}
+
+static void Locate(Space* space, Space* base, XrTime time, XrSpaceLocationFlags* flags, XrPosef* pose,
+    XrSpaceVelocityFlags* velocityFlags, XrVector3f* linearVelocity, XrVector3f* angularVelocity)
+{
+	*flags = 0;
+	*pose = IDENTITY_POSE;
+	if (velocityFlags) {
+		*velocityFlags = 0;
+		*linearVelocity = {};
+		*angularVelocity = {};
+	}
+
+	if (!GetRelativePose(space, base, time, pose))
+		return;
+
+	*flags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT
+	    | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+
+	if (!velocityFlags)
+		return;
+
+	// Work the velocity out from a millisecond earlier. Angular velocity isn't reported, since nothing checks it.
+	const XrDuration step = 1000000;
+	XrPosef earlier;
+	if (!GetRelativePose(space, base, time - step, &earlier))
+		return;
+
+	*velocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT;
+	linearVelocity->x = (pose->position.x - earlier.position.x) * (1e9f / step);
+	linearVelocity->y = (pose->position.y - earlier.position.y) * (1e9f / step);
+	linearVelocity->z = (pose->position.z - earlier.position.z) * (1e9f / step);
+}
+
+XrResult XRAPI_CALL xrEnumerateReferenceSpaces(XrSession sessionHandle, uint32_t spaceCapacityInput, uint32_t* spaceCountOutput, XrReferenceSpaceType* spaceTypes)
+{
+	MOCK_ENTRY();
+
+	if (!GetSession(sessionHandle))
+		return XR_ERROR_HANDLE_INVALID;
+
+	static const XrReferenceSpaceType supported[] = { XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL, XR_REFERENCE_SPACE_TYPE_STAGE };
+	return FillArray(spaceCapacityInput, spaceCountOutput, spaceTypes, 3, [](XrReferenceSpaceType& type, uint32_t i) { type = supported[i]; });
+}
+
+static Space* AddSpace(Session* session, XrSpace* spaceHandle)
+{
+	Space* space = new Space();
+	space->session = session;
+	session->spaces.insert(space);
+	spaces.insert(space);
+	*spaceHandle = ToHandle<XrSpace>(space);
+	return space;
+}
+
+XrResult XRAPI_CALL xrCreateReferenceSpace(XrSession sessionHandle, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* spaceHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_REFERENCE_SPACE_CREATE_INFO);
+	if (!spaceHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	switch (createInfo->referenceSpaceType) {
+	case XR_REFERENCE_SPACE_TYPE_VIEW:
+	case XR_REFERENCE_SPACE_TYPE_LOCAL:
+	case XR_REFERENCE_SPACE_TYPE_STAGE:
+		break;
+	default:
+		return XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+	}
+
+	if (!IsPoseValid(createInfo->poseInReferenceSpace))
+		return XR_ERROR_POSE_INVALID;
+
+	Space* space = AddSpace(session, spaceHandle);
+	space->referenceType = createInfo->referenceSpaceType;
+	space->offset = createInfo->poseInReferenceSpace;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetReferenceSpaceBoundsRect(XrSession sessionHandle, XrReferenceSpaceType referenceSpaceType, XrExtent2Df* bounds)
+{
+	MOCK_ENTRY();
+
+	if (!GetSession(sessionHandle))
+		return XR_ERROR_HANDLE_INVALID;
+	if (!bounds)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	// Only the stage has any bounds
+	if (referenceSpaceType != XR_REFERENCE_SPACE_TYPE_STAGE) {
+		*bounds = { 0, 0 };
+		return XR_SPACE_BOUNDS_UNAVAILABLE;
+	}
+
+	*bounds = { 4, 3 };
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrCreateActionSpace(XrSession sessionHandle, const XrActionSpaceCreateInfo* createInfo, XrSpace* spaceHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_ACTION_SPACE_CREATE_INFO);
+	if (!spaceHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	Action* action = GetAction(createInfo->action);
+	if (!action)
+		return XR_ERROR_HANDLE_INVALID;
+	if (action->type != XR_ACTION_TYPE_POSE_INPUT)
+		return XR_ERROR_ACTION_TYPE_MISMATCH;
+
+	if (createInfo->subactionPath != XR_NULL_PATH) {
+		const std::vector<XrPath>& paths = action->subactionPaths;
+		if (std::find(paths.begin(), paths.end(), createInfo->subactionPath) == paths.end())
+			return XR_ERROR_PATH_UNSUPPORTED;
+	}
+
+	if (!IsPoseValid(createInfo->poseInActionSpace))
+		return XR_ERROR_POSE_INVALID;
+
+	Space* space = AddSpace(session, spaceHandle);
+	space->referenceType = XR_REFERENCE_SPACE_TYPE_STAGE;
+	space->action = action;
+	space->subactionPath = createInfo->subactionPath;
+	space->offset = createInfo->poseInActionSpace;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySpace(XrSpace spaceHandle)
+{
+	MOCK_ENTRY();
+
+	Space* space = GetSpace(spaceHandle);
+	if (!space)
+		return XR_ERROR_HANDLE_INVALID;
+
+	space->session->spaces.erase(space);
+	spaces.erase(space);
+	delete space;
+	return XR_SUCCESS;
+}
+
+// Checks both spaces are valid, and from the same session
+static XrResult GetSpacePair(XrSpace spaceHandle, XrSpace baseSpaceHandle, Space** space, Space** base)
+{
+	*space = GetSpace(spaceHandle);
+	*base = GetSpace(baseSpaceHandle);
+	if (!*space || !*base)
+		return XR_ERROR_HANDLE_INVALID;
+	if ((*space)->session != (*base)->session)
+		return XR_ERROR_VALIDATION_FAILURE;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrLocateSpace(XrSpace spaceHandle, XrSpace baseSpaceHandle, XrTime time, XrSpaceLocation* location)
+{
+	MOCK_ENTRY();
+
+	Space *space, *base;
+	if (XrResult result = GetSpacePair(spaceHandle, baseSpaceHandle, &space, &base); XR_FAILED(result))
+		return result;
+	MOCK_CHECK_TYPE(location, XR_TYPE_SPACE_LOCATION);
+	if (time <= 0)
+		return XR_ERROR_TIME_INVALID;
+
+	XrSpaceVelocity* velocity = (XrSpaceVelocity*)location->next;
+	if (velocity && velocity->type != XR_TYPE_SPACE_VELOCITY)
+		velocity = nullptr;
+
+	if (velocity) {
+		Locate(space, base, time, &location->locationFlags, &location->pose,
+		    &velocity->velocityFlags, &velocity->linearVelocity, &velocity->angularVelocity);
+	} else {
+		Locate(space, base, time, &location->locationFlags, &location->pose, nullptr, nullptr, nullptr);
+	}
+	return XR_SUCCESS;
+}
+
+#ifdef XR_KHR_locate_spaces
+XrResult XRAPI_CALL xrLocateSpacesKHR(XrSession sessionHandle, const XrSpacesLocateInfoKHR* locateInfo, XrSpaceLocationsKHR* spaceLocations)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(locateInfo, XR_TYPE_SPACES_LOCATE_INFO_KHR);
+	MOCK_CHECK_TYPE(spaceLocations, XR_TYPE_SPACE_LOCATIONS_KHR);
+	if (locateInfo->time <= 0)
+		return XR_ERROR_TIME_INVALID;
+
+	uint32_t count = locateInfo->spaceCount;
+	if (count == 0 || !locateInfo->spaces || spaceLocations->locationCount != count || !spaceLocations->locations)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	XrSpaceVelocitiesKHR* velocities = (XrSpaceVelocitiesKHR*)spaceLocations->next;
+	if (velocities && velocities->type != XR_TYPE_SPACE_VELOCITIES_KHR)
+		velocities = nullptr;
+	if (velocities && (velocities->velocityCount != count || !velocities->velocities))
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	Space* base = GetSpace(locateInfo->baseSpace);
+	if (!base || base->session != session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	for (uint32_t i = 0; i < count; i++) {
+		Space* space = GetSpace(locateInfo->spaces[i]);
+		if (!space || space->session != session)
+			return XR_ERROR_HANDLE_INVALID;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		Space* space = GetSpace(locateInfo->spaces[i]);
+		XrSpaceLocationDataKHR& location = spaceLocations->locations[i];
+
+		if (velocities) {
+			XrSpaceVelocityDataKHR& velocity = velocities->velocities[i];
+			Locate(space, base, locateInfo->time, &location.locationFlags, &location.pose,
+			    &velocity.velocityFlags, &velocity.linearVelocity, &velocity.angularVelocity);
+		} else {
+			Locate(space, base, locateInfo->time, &location.locationFlags, &location.pose, nullptr, nullptr, nullptr);
+		}
+	}
+
+	return XR_SUCCESS;
+}
+#endif
+
+XrResult XRAPI_CALL xrLocateViews(XrSession sessionHandle, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState,
+    uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(viewLocateInfo, XR_TYPE_VIEW_LOCATE_INFO);
+	MOCK_CHECK_TYPE(viewState, XR_TYPE_VIEW_STATE);
+
+	if (viewLocateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	if (viewLocateInfo->displayTime <= 0)
+		return XR_ERROR_TIME_INVALID;
+
+	Space* base = GetSpace(viewLocateInfo->space);
+	if (!base || base->session != session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (views) {
+		for (uint32_t i = 0; i < viewCapacityInput && i < 2; i++) {
+			if (views[i].type != XR_TYPE_VIEW)
+				return XR_ERROR_VALIDATION_FAILURE;
+		}
+	}
+
+	XrPosef basePose;
+	Space head = {};
+	head.session = session;
+	head.referenceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+	head.offset = IDENTITY_POSE;
+	if (!GetRelativePose(&head, base, viewLocateInfo->displayTime, &basePose)) {
+		viewState->viewStateFlags = 0;
+		basePose = IDENTITY_POSE;
+	} else {
+		viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT
+		    | XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+	}
+
+	return FillArray(viewCapacityInput, viewCountOutput, views, 2, [&basePose](XrView& view, uint32_t i) {
+		float side = i == 0 ? -1 : 1;
+		view.pose = Compose(basePose, { { 0, 0, 0, 1 }, { side * EYE_OFFSET, 0, 0 } });
+		view.fov = { -EYE_FOV, EYE_FOV, EYE_FOV, -EYE_FOV };
+	});
+}
+
+} // namespace mock
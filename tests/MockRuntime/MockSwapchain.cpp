@@ -0,0 +1,587 @@
+#include "MockRuntimePrivate.h"
+
+#include <algorithm>
+#include <memory>
+
+// Swapchains, made of ordinary Vulkan images on the app's device or textures in its OpenGL context, and reading them
+// back for the tests.
+
+namespace mock {
+
+// In order of preference, as a runtime should list them. Only the ones the device can use are offered.
+static const VkFormat colourFormats[] = {
+	VK_FORMAT_R8G8B8A8_SRGB,
+	VK_FORMAT_B8G8R8A8_SRGB,
+	VK_FORMAT_R8G8B8A8_UNORM,
+	VK_FORMAT_B8G8R8A8_UNORM,
+	VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+	VK_FORMAT_R16G16B16A16_SFLOAT,
+	VK_FORMAT_R16G16_SFLOAT,
+};
+
+static const VkFormat depthFormats[] = {
+	VK_FORMAT_D32_SFLOAT,
+	VK_FORMAT_D24_UNORM_S8_UINT,
+	VK_FORMAT_D16_UNORM,
+	VK_FORMAT_D32_SFLOAT_S8_UINT,
+};
+
+// The same for OpenGL. Every implementation that can run OpenComposite supports all of these, so they're always
+// offered - apart from GL_RGBA8 with sRGB data, which has no format of its own, that means an image in an
+// unusual format such as GL_SRGB8 has to be converted.
+static const GLenum glColourFormats[] = {
+	GL_SRGB8_ALPHA8,
+	GL_RGBA8,
+	GL_RGB10_A2,
+	GL_RGBA16F,
+	GL_RG16F,
+};
+
+static const GLenum glDepthFormats[] = {
+	GL_DEPTH_COMPONENT32F,
+	GL_DEPTH24_STENCIL8,
+	GL_DEPTH_COMPONENT16,
+	GL_DEPTH32F_STENCIL8,
+};
+
+static bool IsDepthFormat(Session* session, int64_t format)
+{
+	if (session->openGL)
+		return std::find(std::begin(glDepthFormats), std::end(glDepthFormats), (GLenum)format) != std::end(glDepthFormats);
+	return std::find(std::begin(depthFormats), std::end(depthFormats), (VkFormat)format) != std::end(depthFormats);
+}
+
+// The formats that can be read back by OCMockXr_ReadSwapchainImage
+static bool IsFourByteFormat(Session* session, int64_t format)
+{
+	if (session->openGL)
+		return format == GL_SRGB8_ALPHA8 || format == GL_RGBA8 || format == GL_RGB10_A2 || format == GL_RG16F;
+
+	switch (format) {
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+	case VK_FORMAT_R16G16_SFLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static std::vector<int64_t> GetSupportedFormats(Session* session)
+{
+	std::vector<int64_t> formats;
+
+	if (session->openGL) {
+		formats.insert(formats.end(), std::begin(glColourFormats), std::end(glColourFormats));
+		formats.insert(formats.end(), std::begin(glDepthFormats), std::end(glDepthFormats));
+		return formats;
+	}
+
+	auto check = [&](VkFormat format, VkFormatFeatureFlags required) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(session->physicalDevice, format, &properties);
+		if ((properties.optimalTilingFeatures & required) == required)
+			formats.push_back(format);
+	};
+
+	for (VkFormat format : colourFormats)
+		check(format, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+	for (VkFormat format : depthFormats)
+		check(format, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+
+	return formats;
+}
+
+// Picks a memory type allowed by typeBits, preferring one with the given properties
+static int FindMemoryType(Session* session, uint32_t typeBits, VkMemoryPropertyFlags wanted, VkMemoryPropertyFlags required)
+{
+	VkPhysicalDeviceMemoryProperties properties;
+	vkGetPhysicalDeviceMemoryProperties(session->physicalDevice, &properties);
+
+	int fallback = -1;
+	for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+		if (!(typeBits & (1u << i)))
+			continue;
+
+		VkMemoryPropertyFlags flags = properties.memoryTypes[i].propertyFlags;
+		if ((flags & required) != required)
+			continue;
+		if ((flags & wanted) == wanted)
+			return (int)i;
+		if (fallback == -1)
+			fallback = (int)i;
+	}
+	return fallback;
+}
+
+XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession sessionHandle, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+
+	std::vector<int64_t> supported = GetSupportedFormats(session);
+	return FillArray(formatCapacityInput, formatCountOutput, formats, (uint32_t)supported.size(), [&supported](int64_t& format, uint32_t i) {
+		format = supported[i];
+	});
+}
+
+void DestroySwapchainImages(Swapchain* swapchain)
+{
+	if (swapchain->session->openGL) {
+		if (!swapchain->textures.empty())
+			glDeleteTextures((GLsizei)swapchain->textures.size(), swapchain->textures.data());
+		swapchain->textures.clear();
+		return;
+	}
+
+	VkDevice device = swapchain->session->device;
+
+	// The app may have only just submitted its last copy into one of the images
+	vkQueueWaitIdle(swapchain->session->queue);
+
+	for (VkImage image : swapchain->images)
+		vkDestroyImage(device, image, nullptr);
+	for (VkDeviceMemory memory : swapchain->memory)
+		vkFreeMemory(device, memory, nullptr);
+
+	swapchain->images.clear();
+	swapchain->memory.clear();
+}
+
+// Makes the swapchain's textures in the current context: immutable ones, the same as a real runtime would share
+// with the app
+static XrResult CreateTextures(Swapchain* swapchain)
+{
+	const XrSwapchainCreateInfo& info = swapchain->info;
+
+	// Any errors are the app's until we've made the textures, so they're cleared first
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	GLint oldTexture;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+
+	swapchain->textures.resize(swapchain->imageCount);
+	glGenTextures((GLsizei)swapchain->imageCount, swapchain->textures.data());
+	for (GLuint texture : swapchain->textures) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexStorage2D(GL_TEXTURE_2D, (GLsizei)info.mipCount, (GLenum)info.format, (GLsizei)info.width, (GLsizei)info.height);
+	}
+	glBindTexture(GL_TEXTURE_2D, (GLuint)oldTexture);
+
+	return glGetError() == GL_NO_ERROR ? XR_SUCCESS : XR_ERROR_RUNTIME_FAILURE;
+}
+
+static XrResult CreateImages(Swapchain* swapchain, bool depth)
+{
+	Session* session = swapchain->session;
+	const XrSwapchainCreateInfo* createInfo = &swapchain->info;
+
+	// The images can always be copied to and from, so they can be read back. They can also always be attachments,
+	// since that's the layout the app has to leave them in.
+	VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = (VkFormat)createInfo->format;
+	imageInfo.extent = { createInfo->width, createInfo->height, 1 };
+	imageInfo.mipLevels = createInfo->mipCount;
+	imageInfo.arrayLayers = createInfo->arraySize * createInfo->faceCount;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.usage |= depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT)
+		imageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT)
+		imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_MUTABLE_FORMAT_BIT)
+		imageInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+	if (createInfo->faceCount == 6)
+		imageInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+
+	for (uint32_t i = 0; i < swapchain->imageCount; i++) {
+		VkImage image;
+		if (vkCreateImage(session->device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+			return XR_ERROR_RUNTIME_FAILURE;
+		swapchain->images.push_back(image);
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(session->device, image, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocInfo.allocationSize = requirements.size;
+		int memoryType = FindMemoryType(session, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+		VkDeviceMemory memory;
+		if (memoryType == -1 || (allocInfo.memoryTypeIndex = memoryType, vkAllocateMemory(session->device, &allocInfo, nullptr, &memory)) != VK_SUCCESS)
+			return XR_ERROR_RUNTIME_FAILURE;
+		swapchain->memory.push_back(memory);
+
+		if (vkBindImageMemory(session->device, image, memory, 0) != VK_SUCCESS)
+			return XR_ERROR_RUNTIME_FAILURE;
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrCreateSwapchain(XrSession sessionHandle, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchainHandle)
+{
+	MOCK_ENTRY();
+
+	Session* session = GetSession(sessionHandle);
+	if (!session)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(createInfo, XR_TYPE_SWAPCHAIN_CREATE_INFO);
+	if (!swapchainHandle)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	std::vector<int64_t> supported = GetSupportedFormats(session);
+	if (std::find(supported.begin(), supported.end(), createInfo->format) == supported.end())
+		return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+
+	// Multisampled swapchains aren't offered, see xrEnumerateViewConfigurationViews
+	if (createInfo->sampleCount != 1)
+		return XR_ERROR_FEATURE_UNSUPPORTED;
+
+	if (createInfo->faceCount != 1 && createInfo->faceCount != 6)
+		return XR_ERROR_VALIDATION_FAILURE;
+	if (createInfo->faceCount == 6 && createInfo->width != createInfo->height)
+		return XR_ERROR_VALIDATION_FAILURE;
+	if (createInfo->width == 0 || createInfo->height == 0 || createInfo->width > 4096 || createInfo->height > 4096)
+		return XR_ERROR_VALIDATION_FAILURE;
+	if (createInfo->arraySize == 0 || createInfo->mipCount == 0)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	// OpenComposite only ever makes plain 2D swapchains for OpenGL, so array and cube textures are left out
+	if (session->openGL && (createInfo->arraySize != 1 || createInfo->faceCount != 1))
+		return XR_ERROR_FEATURE_UNSUPPORTED;
+
+	bool depth = IsDepthFormat(session, createInfo->format);
+	if (depth && (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT))
+		return XR_ERROR_FEATURE_UNSUPPORTED;
+
+	std::unique_ptr<Swapchain> swapchain = std::make_unique<Swapchain>();
+	swapchain->session = session;
+	swapchain->info = *createInfo;
+	swapchain->info.next = nullptr;
+
+	// Static images only ever have their one image, everything else is triple-buffered
+	swapchain->imageCount = (createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) ? 1 : SWAPCHAIN_LENGTH;
+	swapchain->released.resize(swapchain->imageCount, false);
+
+	XrResult result = session->openGL ? CreateTextures(swapchain.get()) : CreateImages(swapchain.get(), depth);
+	if (XR_FAILED(result)) {
+		DestroySwapchainImages(swapchain.get());
+		return result;
+	}
+
+	Swapchain* created = swapchain.release();
+	session->swapchains.insert(created);
+	swapchains.insert(created);
+	*swapchainHandle = ToHandle<XrSwapchain>(created);
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain swapchainHandle)
+{
+	MOCK_ENTRY();
+
+	Swapchain* swapchain = GetSwapchain(swapchainHandle);
+	if (!swapchain)
+		return XR_ERROR_HANDLE_INVALID;
+
+	DestroySwapchainImages(swapchain);
+	swapchain->session->swapchains.erase(swapchain);
+	swapchains.erase(swapchain);
+	delete swapchain;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateSwapchainImages(XrSwapchain swapchainHandle, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images)
+{
+	MOCK_ENTRY();
+
+	Swapchain* swapchain = GetSwapchain(swapchainHandle);
+	if (!swapchain)
+		return XR_ERROR_HANDLE_INVALID;
+
+	// The images are an array of the session's API's image structs
+	uint32_t count = swapchain->imageCount;
+	if (swapchain->session->openGL) {
+		XrSwapchainImageOpenGLKHR* glImages = (XrSwapchainImageOpenGLKHR*)images;
+		if (glImages && imageCapacityInput >= count) {
+			for (uint32_t i = 0; i < count; i++) {
+				if (glImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR)
+					return XR_ERROR_VALIDATION_FAILURE;
+			}
+		}
+
+		return FillArray(imageCapacityInput, imageCountOutput, glImages, count, [swapchain](XrSwapchainImageOpenGLKHR& image, uint32_t i) {
+			image.image = swapchain->textures[i];
+		});
+	}
+
+	XrSwapchainImageVulkanKHR* vkImages = (XrSwapchainImageVulkanKHR*)images;
+	if (vkImages && imageCapacityInput >= count) {
+		for (uint32_t i = 0; i < count; i++) {
+			if (vkImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR)
+				return XR_ERROR_VALIDATION_FAILURE;
+		}
+	}
+
+	return FillArray(imageCapacityInput, imageCountOutput, vkImages, count, [swapchain](XrSwapchainImageVulkanKHR& image, uint32_t i) {
+		image.image = swapchain->images[i];
+	});
+}
+
+XrResult XRAPI_CALL xrAcquireSwapchainImage(XrSwapchain swapchainHandle, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)
+{
+	MOCK_ENTRY();
+
+	Swapchain* swapchain = GetSwapchain(swapchainHandle);
+	if (!swapchain)
+		return XR_ERROR_HANDLE_INVALID;
+	if (acquireInfo && acquireInfo->type != XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO)
+		return XR_ERROR_VALIDATION_FAILURE;
+	if (!index)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	// A static image can only ever be acquired once
+	bool isStatic = swapchain->info.createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT;
+	if (isStatic && swapchain->staticImageUsed)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	if (swapchain->acquired.size() >= swapchain->imageCount)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	*index = swapchain->nextImage;
+	swapchain->acquired.push_back(swapchain->nextImage);
+	swapchain->nextImage = (swapchain->nextImage + 1) % swapchain->imageCount;
+	swapchain->staticImageUsed = true;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrWaitSwapchainImage(XrSwapchain swapchainHandle, const XrSwapchainImageWaitInfo* waitInfo)
+{
+	MOCK_ENTRY();
+
+	Swapchain* swapchain = GetSwapchain(swapchainHandle);
+	if (!swapchain)
+		return XR_ERROR_HANDLE_INVALID;
+	MOCK_CHECK_TYPE(waitInfo, XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO);
+
+	// Nothing ever reads the images, so they're ready as soon as they're acquired
+	if (swapchain->acquired.empty() || swapchain->frontWaited)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	swapchain->frontWaited = true;
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrReleaseSwapchainImage(XrSwapchain swapchainHandle, const XrSwapchainImageReleaseInfo* releaseInfo)
+{
+	MOCK_ENTRY();
+
+	Swapchain* swapchain = GetSwapchain(swapchainHandle);
+	if (!swapchain)
+		return XR_ERROR_HANDLE_INVALID;
+	if (releaseInfo && releaseInfo->type != XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO)
+		return XR_ERROR_VALIDATION_FAILURE;
+
+	if (swapchain->acquired.empty() || !swapchain->frontWaited)
+		return XR_ERROR_CALL_ORDER_INVALID;
+
+	uint32_t image = swapchain->acquired.front();
+	swapchain->acquired.pop_front();
+	swapchain->frontWaited = false;
+	swapchain->lastReleased = (int32_t)image;
+	swapchain->released[image] = true;
+	return XR_SUCCESS;
+}
+
+// Reads a released texture with glGetTexImage, which gives the rows bottom-up, as OpenGL stores them. Everything
+// this changes is put back, since it's in the app's context.
+static bool ReadTexture(Swapchain* swapchain, uint32_t imageIndex, void* pixels)
+{
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	if (swapchain->info.format == GL_RGB10_A2) {
+		type = GL_UNSIGNED_INT_2_10_10_10_REV;
+	} else if (swapchain->info.format == GL_RG16F) {
+		format = GL_RG;
+		type = GL_HALF_FLOAT;
+	}
+
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	GLint oldTexture, oldPackBuffer, oldAlignment, oldRowLength;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &oldPackBuffer);
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlignment);
+	glGetIntegerv(GL_PACK_ROW_LENGTH, &oldRowLength);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	glBindTexture(GL_TEXTURE_2D, swapchain->textures[imageIndex]);
+	glGetTexImage(GL_TEXTURE_2D, 0, format, type, pixels);
+
+	glBindTexture(GL_TEXTURE_2D, (GLuint)oldTexture);
+	glPixelStorei(GL_PACK_ROW_LENGTH, oldRowLength);
+	glPixelStorei(GL_PACK_ALIGNMENT, oldAlignment);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)oldPackBuffer);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+// Copies a released image into a host-visible buffer, leaving it in the layout the app left it in
+static bool ReadImage(Swapchain* swapchain, uint32_t imageIndex, uint32_t arrayIndex, void* pixels, uint64_t size)
+{
+	Session* session = swapchain->session;
+	VkDevice device = session->device;
+
+	if (!session->commandPool) {
+		VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = session->queueFamilyIndex;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &session->commandPool) != VK_SUCCESS)
+			return false;
+	}
+
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	bool success = false;
+
+	VkMemoryRequirements requirements;
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	VkCommandBufferAllocateInfo commandInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	VkBufferImageCopy region = {};
+	void* mapped = nullptr;
+	int memoryType;
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		goto cleanup;
+
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+	memoryType = FindMemoryType(session, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	if (memoryType == -1)
+		goto cleanup;
+
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		goto cleanup;
+	if (vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS)
+		goto cleanup;
+
+	commandInfo.commandPool = session->commandPool;
+	commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &commandInfo, &commandBuffer) != VK_SUCCESS)
+		goto cleanup;
+
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = swapchain->images[imageIndex];
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, arrayIndex, 1 };
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, arrayIndex, 1 };
+	region.imageExtent = { swapchain->info.width, swapchain->info.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, swapchain->images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+	// Put the image back how it was, for the next time the app acquires it
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+	    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		goto cleanup;
+
+	if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		goto cleanup;
+
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	if (vkQueueSubmit(session->queue, 1, &submitInfo, fence) != VK_SUCCESS)
+		goto cleanup;
+	if (vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+		goto cleanup;
+
+	if (vkMapMemory(device, memory, 0, size, 0, &mapped) != VK_SUCCESS)
+		goto cleanup;
+	memcpy(pixels, mapped, size);
+	vkUnmapMemory(device, memory);
+	success = true;
+
+cleanup:
+	if (fence)
+		vkDestroyFence(device, fence, nullptr);
+	if (commandBuffer)
+		vkFreeCommandBuffers(device, session->commandPool, 1, &commandBuffer);
+	if (buffer)
+		vkDestroyBuffer(device, buffer, nullptr);
+	if (memory)
+		vkFreeMemory(device, memory, nullptr);
+	return success;
+}
+
+} // namespace mock
+
+using namespace mock;
+
+OC_MOCK_XR_EXPORT int OCMockXr_ReadSwapchainImage(uint64_t swapchainHandle, uint32_t image, uint32_t arrayIndex, void* pixels, uint64_t size)
+{
+	std::lock_guard<std::mutex> guard(runtimeLock);
+
+	Swapchain* swapchain = GetSwapchain((XrSwapchain)swapchainHandle);
+	if (!swapchain || !pixels)
+		return 0;
+
+	const XrSwapchainCreateInfo& info = swapchain->info;
+	if (!IsFourByteFormat(swapchain->session, info.format) || info.faceCount != 1)
+		return 0;
+	if (image >= swapchain->imageCount || arrayIndex >= info.arraySize)
+		return 0;
+	if (size != (uint64_t)info.width * info.height * 4)
+		return 0;
+
+	// Until it's been released, the image isn't in a known layout (and probably doesn't have anything in it)
+	if (!swapchain->released[image])
+		return 0;
+
+	if (swapchain->session->openGL)
+		return ReadTexture(swapchain, image, pixels) ? 1 : 0;
+	return ReadImage(swapchain, image, arrayIndex, pixels, size) ? 1 : 0;
+}
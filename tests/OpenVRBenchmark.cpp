@@ -0,0 +1,238 @@
+#include "OpenVRHarness.h"
+
+#include "AllocationCounter.h"
+#include "MockRuntime/MockRuntime.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runs frames through OpenComposite the way a Vulkan game does, and times each part of the frame: getting the
+// poses, updating and reading the input, the overlay calls and submitting the eyes. For each it reports how long
+// it took, how many allocations it made (including any made by the OpenXR runtime), and how many OpenXR calls it
+// made. The last is only known when running against the mock runtime.
+
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+using namespace openvr_harness;
+
+struct Section {
+	const char* name;
+	double ns = 0;
+	uint64_t allocations = 0;
+	uint64_t calls = 0;
+};
+
+template <typename F>
+static void Measure(bool usingMock, Section& section, F func)
+{
+	uint64_t startAllocations = GetAllocationCount();
+	uint64_t startCalls = usingMock ? OCMockXr_GetTotalCalls() : 0;
+	auto start = std::chrono::steady_clock::now();
+
+	func();
+
+	auto end = std::chrono::steady_clock::now();
+	section.ns += std::chrono::duration<double, std::nano>(end - start).count();
+	section.allocations += GetAllocationCount() - startAllocations;
+	if (usingMock)
+		section.calls += OCMockXr_GetTotalCalls() - startCalls;
+}
+
+struct Actions {
+	vr::VRActionSetHandle_t set = 0;
+	vr::VRActionHandle_t fire = 0;
+	vr::VRActionHandle_t squeeze = 0;
+	vr::VRActionHandle_t move = 0;
+	vr::VRActionHandle_t handLeft = 0;
+	vr::VRActionHandle_t handRight = 0;
+};
+
+static NOINLINE void ReadActions(OpenVRHarness& harness, const Actions& actions, float* checksum)
+{
+	vr::IVRInput_010::InputDigitalActionData_t digital;
+	harness.input->GetDigitalActionData(actions.fire, &digital, sizeof(digital), vr::k_ulInvalidInputValueHandle);
+
+	vr::IVRInput_010::InputAnalogActionData_t analog;
+	harness.input->GetAnalogActionData(actions.squeeze, &analog, sizeof(analog), vr::k_ulInvalidInputValueHandle);
+	*checksum += analog.x;
+	harness.input->GetAnalogActionData(actions.move, &analog, sizeof(analog), vr::k_ulInvalidInputValueHandle);
+	*checksum += analog.x + analog.y;
+
+	vr::IVRInput_010::InputPoseActionData_t pose;
+	for (vr::VRActionHandle_t hand : { actions.handLeft, actions.handRight }) {
+		harness.input->GetPoseActionDataForNextFrame(hand, vr::TrackingUniverseStanding, &pose, sizeof(pose), vr::k_ulInvalidInputValueHandle);
+		*checksum += pose.pose.mDeviceToAbsoluteTracking.m[1][3];
+	}
+
+	*checksum += digital.bState;
+}
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv))
+		return EXIT_FAILURE;
+
+	int frames = 1000;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--runtime mock|system] [--frames count]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	harness.compositor->SetTrackingSpace(vr::TrackingUniverseStanding);
+
+	std::string manifest = harness.WriteActionManifest();
+	if (manifest.empty() || harness.input->SetActionManifestPath(manifest.c_str()) != vr::VRInputError_None) {
+		fprintf(stderr, "Failed to load the action manifest\n");
+		return EXIT_FAILURE;
+	}
+
+	Actions actions;
+	vr::IVRInput_010::IVRInput* input = harness.input;
+	bool handlesOk = input->GetActionSetHandle("/actions/main", &actions.set) == vr::VRInputError_None
+	    && input->GetActionHandle("/actions/main/in/fire", &actions.fire) == vr::VRInputError_None
+	    && input->GetActionHandle("/actions/main/in/squeeze", &actions.squeeze) == vr::VRInputError_None
+	    && input->GetActionHandle("/actions/main/in/move", &actions.move) == vr::VRInputError_None
+	    && input->GetActionHandle("/actions/main/in/hand_left", &actions.handLeft) == vr::VRInputError_None
+	    && input->GetActionHandle("/actions/main/in/hand_right", &actions.handRight) == vr::VRInputError_None;
+	if (!handlesOk) {
+		fprintf(stderr, "Failed to get the action handles\n");
+		return EXIT_FAILURE;
+	}
+
+	TestImage* eyes[2] = {
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff402010),
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff102040),
+	};
+	TestImage* overlayImage = harness.CreateImage(256, 256, nullptr, 0xc0ffffff);
+	if (!eyes[0] || !eyes[1] || !overlayImage)
+		return EXIT_FAILURE;
+
+	vr::VROverlayHandle_t overlayHandle = 0;
+	if (harness.overlay->CreateOverlay("oc.benchmark", "Benchmark", &overlayHandle) != vr::VROverlayError_None) {
+		fprintf(stderr, "Failed to create the overlay\n");
+		return EXIT_FAILURE;
+	}
+	harness.overlay->SetOverlayWidthInMeters(overlayHandle, 0.5f);
+	harness.overlay->ShowOverlay(overlayHandle);
+
+	vr::IVRInput_010::VRActiveActionSet_t activeSet = {};
+	activeSet.ulActionSet = actions.set;
+
+	vr::TrackedDeviceIndex_t controllers[2] = {
+		harness.system->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_LeftHand),
+		harness.system->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_RightHand),
+	};
+
+	Section waitGetPoses{ "WaitGetPoses" };
+	Section updateActionState{ "UpdateActionState" };
+	Section actionData{ "Get*ActionData" };
+	Section controllerState{ "GetControllerState" };
+	Section overlayCalls{ "overlay" };
+	Section submit{ "Submit" };
+	Section total{ "frame" };
+	Section* sections[] = { &waitGetPoses, &updateActionState, &actionData, &controllerState, &overlayCalls, &submit };
+
+	// The first frames create the session and swapchains, and the inputs get bound a few frames later
+	const int warmupFrames = 20;
+	float checksum = 0;
+	bool submitFailed = false;
+
+	for (int frame = -warmupFrames; frame < frames; frame++) {
+		if (frame == 0) {
+			for (Section* section : sections)
+				*section = Section{ section->name };
+			total = Section{ total.name };
+		}
+
+		uint64_t startAllocations = GetAllocationCount();
+		uint64_t startCalls = harness.usingMock ? OCMockXr_GetTotalCalls() : 0;
+		auto start = std::chrono::steady_clock::now();
+
+		vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+		Measure(harness.usingMock, waitGetPoses, [&]() {
+			harness.compositor->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
+		});
+
+		Measure(harness.usingMock, updateActionState, [&]() {
+			input->UpdateActionState(&activeSet, sizeof(activeSet), 1);
+		});
+
+		Measure(harness.usingMock, actionData, [&]() { ReadActions(harness, actions, &checksum); });
+
+		Measure(harness.usingMock, controllerState, [&]() {
+			for (vr::TrackedDeviceIndex_t controller : controllers) {
+				vr::VRControllerState_t state;
+				harness.system->GetControllerState(controller, &state, sizeof(state));
+				checksum += state.rAxis[0].x;
+			}
+		});
+
+		Measure(harness.usingMock, overlayCalls, [&]() {
+			// Move the overlay in front of the head, as a HUD would
+			vr::HmdMatrix34_t transform = poses[vr::k_unTrackedDeviceIndex_Hmd].mDeviceToAbsoluteTracking;
+			transform.m[2][3] -= 1;
+			harness.overlay->SetOverlayTransformAbsolute(overlayHandle, vr::TrackingUniverseStanding, &transform);
+			harness.overlay->SetOverlayTexture(overlayHandle, &overlayImage->texture);
+		});
+
+		Measure(harness.usingMock, submit, [&]() {
+			submitFailed |= harness.compositor->Submit(vr::Eye_Left, &eyes[0]->texture) != vr::IVRCompositor_027::VRCompositorError_None;
+			submitFailed |= harness.compositor->Submit(vr::Eye_Right, &eyes[1]->texture) != vr::IVRCompositor_027::VRCompositorError_None;
+		});
+
+		auto end = std::chrono::steady_clock::now();
+		total.ns += std::chrono::duration<double, std::nano>(end - start).count();
+		total.allocations += GetAllocationCount() - startAllocations;
+		if (harness.usingMock)
+			total.calls += OCMockXr_GetTotalCalls() - startCalls;
+	}
+
+	if (submitFailed) {
+		fprintf(stderr, "Submit failed\n");
+		return EXIT_FAILURE;
+	}
+
+	// Make sure the frames actually got to the runtime
+	if (harness.usingMock && OCMockXr_GetFrameCount() < (uint64_t)frames) {
+		fprintf(stderr, "Only %llu frames reached the runtime, out of %d\n", (unsigned long long)OCMockXr_GetFrameCount(),
+		    frames + warmupFrames);
+		return EXIT_FAILURE;
+	}
+
+	// Stop the input reads being optimised out
+	if (checksum == 12345)
+		printf("\n");
+
+	printf("%d frames, %ux%u per eye, %s runtime\n", frames, harness.eyeWidth, harness.eyeHeight, harness.usingMock ? "mock" : "system");
+	printf("%-20s %12s %14s %14s\n", "section", "ns/frame", "allocs/frame", "xr calls/frame");
+
+	auto print = [&](const Section& section) {
+		double count = frames > 0 ? frames : 1;
+		if (harness.usingMock) {
+			printf("%-20s %12.0f %14.2f %14.2f\n", section.name, section.ns / count, section.allocations / count, section.calls / count);
+		} else {
+			printf("%-20s %12.0f %14.2f %14s\n", section.name, section.ns / count, section.allocations / count, "-");
+		}
+	};
+	for (Section* section : sections)
+		print(*section);
+	print(total);
+
+	harness.overlay->DestroyOverlay(overlayHandle);
+	return EXIT_SUCCESS;
+}
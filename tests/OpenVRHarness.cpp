@@ -0,0 +1,638 @@
+#include "OpenVRHarness.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace openvr_harness;
+
+// Both of these are set by CMake, and point to the build output
+#ifndef VRCLIENT_PATH
+#error "VRCLIENT_PATH must be set to the path of OpenComposite's vrclient.so"
+#endif
+#ifndef MOCK_RUNTIME_JSON
+#error "MOCK_RUNTIME_JSON must be set to the path of the mock runtime's manifest"
+#endif
+
+typedef void* (*VRClientCoreFactoryFn)(const char* pInterfaceName, int* pReturnCode);
+
+// The actions the manifest from WriteActionManifest has, one of each type that games use every frame
+static const char* actionManifest = R"({
+	"actions": [
+		{ "name": "/actions/main/in/fire", "type": "boolean" },
+		{ "name": "/actions/main/in/squeeze", "type": "vector1" },
+		{ "name": "/actions/main/in/move", "type": "vector2" },
+		{ "name": "/actions/main/in/hand_left", "type": "pose" },
+		{ "name": "/actions/main/in/hand_right", "type": "pose" },
+		{ "name": "/actions/main/out/haptic", "type": "vibration" }
+	],
+	"action_sets": [
+		{ "name": "/actions/main", "usage": "leftright" }
+	],
+	"default_bindings": [
+		{ "controller_type": "knuckles", "binding_url": "bindings_knuckles.json" }
+	]
+}
+)";
+
+static const char* knucklesBindings = R"({
+	"bindings": {
+		"/actions/main": {
+			"sources": [
+				{ "path": "/user/hand/right/input/a", "mode": "button", "inputs": { "click": { "output": "/actions/main/in/fire" } } },
+				{ "path": "/user/hand/left/input/trigger", "mode": "trigger", "inputs": { "pull": { "output": "/actions/main/in/squeeze" } } },
+				{ "path": "/user/hand/left/input/thumbstick", "mode": "joystick", "inputs": { "position": { "output": "/actions/main/in/move" } } }
+			],
+			"poses": [
+				{ "path": "/user/hand/left/pose/raw", "output": "/actions/main/in/hand_left" },
+				{ "path": "/user/hand/right/pose/raw", "output": "/actions/main/in/hand_right" }
+			],
+			"haptics": [
+				{ "path": "/user/hand/right/output/haptic", "output": "/actions/main/out/haptic" }
+			]
+		}
+	}
+}
+)";
+
+// Splits the space-separated extension lists OpenVR uses
+static std::vector<std::string> SplitExtensions(const char* list)
+{
+	std::vector<std::string> result;
+	std::string current;
+	for (const char* c = list; *c; c++) {
+		if (*c != ' ') {
+			current += *c;
+		} else if (!current.empty()) {
+			result.push_back(current);
+			current.clear();
+		}
+	}
+	if (!current.empty())
+		result.push_back(current);
+	return result;
+}
+
+// Checks there's a Vulkan device, before OpenComposite gets the chance to abort for lack of one
+static bool HasVulkanDevice()
+{
+	VkInstanceCreateInfo createInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+	VkInstance instance;
+	if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+		return false;
+
+	uint32_t count = 0;
+	vkEnumeratePhysicalDevices(instance, &count, nullptr);
+	vkDestroyInstance(instance, nullptr);
+	return count != 0;
+}
+
+static bool WriteFile(const std::string& path, const char* contents)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool ok = fwrite(contents, 1, strlen(contents), file) == strlen(contents);
+	return fclose(file) == 0 && ok;
+}
+
+OpenVRHarness::~OpenVRHarness()
+{
+	// OpenVR has to be shut down before destroying anything that was submitted to it
+	if (clientCore)
+		clientCore->Cleanup();
+
+	// vrclient.so is left loaded, as OpenComposite isn't written to be unloaded and started again
+
+	if (eglDisplay) {
+		for (const std::unique_ptr<TestImage>& image : images)
+			glDeleteTextures(1, &image->glTexture);
+
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (eglContext)
+			eglDestroyContext(eglDisplay, eglContext);
+		if (eglSurface)
+			eglDestroySurface(eglDisplay, eglSurface);
+		eglTerminate(eglDisplay);
+	}
+
+	if (device) {
+		vkDeviceWaitIdle(device);
+
+		for (const std::unique_ptr<TestImage>& image : images) {
+			vkDestroyImage(device, image->image, nullptr);
+			vkFreeMemory(device, image->memory, nullptr);
+		}
+
+		if (commandPool)
+			vkDestroyCommandPool(device, commandPool, nullptr);
+		vkDestroyDevice(device, nullptr);
+	}
+
+	if (instance)
+		vkDestroyInstance(instance, nullptr);
+
+	for (const std::string& file : tempFiles)
+		unlink(file.c_str());
+	if (!tempDir.empty())
+		rmdir(tempDir.c_str());
+}
+
+bool OpenVRHarness::ParseArgs(int& argc, char** argv)
+{
+	int out = 1;
+	for (int i = 1; i < argc; i++) {
+		bool isRuntime = strcmp(argv[i], "--runtime") == 0;
+		bool isApi = strcmp(argv[i], "--api") == 0;
+		if (!isRuntime && !isApi) {
+			argv[out++] = argv[i];
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		const char* value = argv[++i];
+		if (isRuntime) {
+			if (strcmp(value, "mock") == 0) {
+				usingMock = true;
+			} else if (strcmp(value, "system") == 0) {
+				usingMock = false;
+			} else {
+				fprintf(stderr, "Invalid runtime '%s', should be 'mock' or 'system'\n", value);
+				return false;
+			}
+		} else {
+			if (strcmp(value, "vulkan") == 0) {
+				api = GraphicsApi::Vulkan;
+			} else if (strcmp(value, "gl") == 0) {
+				api = GraphicsApi::OpenGL;
+			} else {
+				fprintf(stderr, "Invalid API '%s', should be 'vulkan' or 'gl'\n", value);
+				return false;
+			}
+		}
+	}
+
+	argc = out;
+	argv[argc] = nullptr;
+	return true;
+}
+
+bool OpenVRHarness::Init(int* exitCode)
+{
+	*exitCode = EXIT_FAILURE;
+
+	// OpenComposite starts up with a temporary Vulkan session even for OpenGL games, so this is needed either way
+	if (!HasVulkanDevice()) {
+		printf("No Vulkan device found, skipping\n");
+		*exitCode = SKIP_EXIT_CODE;
+		return false;
+	}
+
+	// An OpenGL game would have its context before starting OpenVR
+	if (api == GraphicsApi::OpenGL && !InitGL(exitCode))
+		return false;
+
+	// This has to be set before OpenComposite creates its OpenXR instance
+	if (usingMock)
+		setenv("XR_RUNTIME_JSON", MOCK_RUNTIME_JSON, 1);
+
+	void* library = dlopen(VRCLIENT_PATH, RTLD_NOW | RTLD_LOCAL);
+	if (!library) {
+		fprintf(stderr, "Failed to load %s: %s\n", VRCLIENT_PATH, dlerror());
+		return false;
+	}
+
+	VRClientCoreFactoryFn factory = (VRClientCoreFactoryFn)dlsym(library, "VRClientCoreFactory");
+	if (!factory) {
+		fprintf(stderr, "Missing VRClientCoreFactory in %s\n", VRCLIENT_PATH);
+		return false;
+	}
+
+	int factoryError = 0;
+	clientCore = (vr::IVRClientCore_003::IVRClientCore*)factory(vr::IVRClientCore_003::IVRClientCore_Version, &factoryError);
+	if (!clientCore) {
+		fprintf(stderr, "Failed to get %s: %d\n", vr::IVRClientCore_003::IVRClientCore_Version, factoryError);
+		return false;
+	}
+
+	vr::EVRInitError initError = clientCore->Init(vr::VRApplication_Scene, "");
+	if (initError != vr::VRInitError_None) {
+		fprintf(stderr, "Failed to start OpenComposite: %s\n", clientCore->GetIDForVRInitError(initError));
+		clientCore = nullptr;
+		return false;
+	}
+
+	system = (vr::IVRSystem_022::IVRSystem*)GetInterface(vr::IVRSystem_022::IVRSystem_Version);
+	compositor = (vr::IVRCompositor_027::IVRCompositor*)GetInterface(vr::IVRCompositor_027::IVRCompositor_Version);
+	input = (vr::IVRInput_010::IVRInput*)GetInterface(vr::IVRInput_010::IVRInput_Version);
+	overlay = (vr::IVROverlay_026::IVROverlay*)GetInterface(vr::IVROverlay_026::IVROverlay_Version);
+	screenshots = (vr::IVRScreenshots_001::IVRScreenshots*)GetInterface(vr::IVRScreenshots_001::IVRScreenshots_Version);
+	if (!system || !compositor || !input || !overlay || !screenshots)
+		return false;
+
+	system->GetRecommendedRenderTargetSize(&eyeWidth, &eyeHeight);
+
+	if (api == GraphicsApi::Vulkan && !InitVulkan())
+		return false;
+
+	*exitCode = EXIT_SUCCESS;
+	return true;
+}
+
+void* OpenVRHarness::GetInterface(const char* version)
+{
+	vr::EVRInitError error = vr::VRInitError_None;
+	void* result = clientCore->GetGenericInterface(version, &error);
+	if (!result || error != vr::VRInitError_None) {
+		fprintf(stderr, "Failed to get %s: %s\n", version, clientCore->GetIDForVRInitError(error));
+		return nullptr;
+	}
+	return result;
+}
+
+bool OpenVRHarness::InitVulkan()
+{
+	// Use the extensions OpenComposite asks for, as a game would
+	std::vector<char> extensionList(compositor->GetVulkanInstanceExtensionsRequired(nullptr, 0) + 1);
+	compositor->GetVulkanInstanceExtensionsRequired(extensionList.data(), extensionList.size());
+	std::vector<std::string> instanceExtensions = SplitExtensions(extensionList.data());
+
+	std::vector<const char*> names;
+	for (const std::string& name : instanceExtensions)
+		names.push_back(name.c_str());
+
+	// OpenComposite matches the device up using vkGetPhysicalDeviceProperties2, which needs Vulkan 1.1
+	VkApplicationInfo appInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+	appInfo.pApplicationName = "OpenComposite tests";
+	appInfo.apiVersion = VK_API_VERSION_1_1;
+
+	VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+	instanceInfo.pApplicationInfo = &appInfo;
+	instanceInfo.enabledExtensionCount = names.size();
+	instanceInfo.ppEnabledExtensionNames = names.data();
+
+	VkResult result = vkCreateInstance(&instanceInfo, nullptr, &instance);
+	if (result != VK_SUCCESS) {
+		fprintf(stderr, "Failed to create the Vulkan instance: %d\n", result);
+		return false;
+	}
+
+	uint64_t outputDevice = 0;
+	system->GetOutputDevice(&outputDevice, vr::TextureType_Vulkan, instance);
+	physicalDevice = (VkPhysicalDevice)outputDevice;
+	if (!physicalDevice) {
+		fprintf(stderr, "OpenComposite didn't return an output device\n");
+		return false;
+	}
+
+	extensionList.resize(compositor->GetVulkanDeviceExtensionsRequired(physicalDevice, nullptr, 0) + 1);
+	compositor->GetVulkanDeviceExtensionsRequired(physicalDevice, extensionList.data(), extensionList.size());
+	std::vector<std::string> deviceExtensions = SplitExtensions(extensionList.data());
+
+	names.clear();
+	for (const std::string& name : deviceExtensions)
+		names.push_back(name.c_str());
+
+	// Use the first queue family, the same as OpenComposite does for its own temporary device
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+	if (families.empty() || !(families[0].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+		fprintf(stderr, "The first queue family doesn't support graphics\n");
+		return false;
+	}
+	queueFamily = 0;
+
+	float priority = 1;
+	VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &priority;
+
+	VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.enabledExtensionCount = names.size();
+	deviceInfo.ppEnabledExtensionNames = names.data();
+
+	result = vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device);
+	if (result != VK_SUCCESS) {
+		fprintf(stderr, "Failed to create the Vulkan device: %d\n", result);
+		return false;
+	}
+
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+	result = vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool);
+	if (result != VK_SUCCESS) {
+		fprintf(stderr, "Failed to create the command pool: %d\n", result);
+		return false;
+	}
+
+	return true;
+}
+
+bool OpenVRHarness::InitGL(int* exitCode)
+{
+	// Use Mesa's surfaceless platform if it's there, so this works without a window system. Nothing's ever drawn to
+	// the surface, it's just a tiny pbuffer to make the context current with.
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+		printf("No EGL display found, skipping\n");
+		*exitCode = SKIP_EXIT_CODE;
+		return false;
+	}
+	eglDisplay = display;
+
+	EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+		printf("No OpenGL support in EGL, skipping\n");
+		*exitCode = SKIP_EXIT_CODE;
+		return false;
+	}
+
+	EGLint surfaceAttribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+	eglSurface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+	eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+	if (!eglSurface || !eglContext || !eglMakeCurrent(display, eglSurface, eglSurface, eglContext)) {
+		fprintf(stderr, "Failed to create the OpenGL context: %#x\n", eglGetError());
+		return false;
+	}
+
+	return true;
+}
+
+bool OpenVRHarness::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t* index)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			*index = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+TestImage* OpenVRHarness::CreateGLImage(uint32_t width, uint32_t height, const uint32_t* pixels, int64_t format)
+{
+	std::unique_ptr<TestImage> image = std::make_unique<TestImage>();
+
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	glGenTextures(1, &image->glTexture);
+	glBindTexture(GL_TEXTURE_2D, image->glTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format ? (GLenum)format : GL_SRGB8_ALPHA8, (GLsizei)width, (GLsizei)height);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)width, (GLsizei)height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	TestImage* result = image.get();
+	images.push_back(std::move(image));
+
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) {
+		fprintf(stderr, "Failed to create a %ux%u texture: %#x\n", width, height, error);
+		return nullptr;
+	}
+
+	result->texture.handle = (void*)(uintptr_t)result->glTexture;
+	result->texture.eType = vr::TextureType_OpenGL;
+	result->texture.eColorSpace = vr::ColorSpace_Auto;
+
+	return result;
+}
+
+TestImage* OpenVRHarness::CreateImage(uint32_t width, uint32_t height, const uint32_t* pixels, uint32_t colour, int64_t format)
+{
+	if (api == GraphicsApi::OpenGL) {
+		std::vector<uint32_t> solid;
+		if (!pixels) {
+			solid.resize((size_t)width * height, colour);
+			pixels = solid.data();
+		}
+		return CreateGLImage(width, height, pixels, format);
+	}
+
+	std::unique_ptr<TestImage> image = std::make_unique<TestImage>();
+
+	VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = format ? (VkFormat)format : VK_FORMAT_R8G8B8A8_SRGB;
+	imageInfo.extent = { width, height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(device, &imageInfo, nullptr, &image->image) != VK_SUCCESS) {
+		fprintf(stderr, "Failed to create a %ux%u image\n", width, height);
+		return nullptr;
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image->image, &requirements);
+
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = requirements.size;
+	if (!FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocInfo.memoryTypeIndex)
+	    && !FindMemoryType(requirements.memoryTypeBits, 0, &allocInfo.memoryTypeIndex)) {
+		fprintf(stderr, "No memory type for a %ux%u image\n", width, height);
+		vkDestroyImage(device, image->image, nullptr);
+		return nullptr;
+	}
+
+	// From here the image is cleaned up in the destructor, even if it fails
+	TestImage* result = image.get();
+	images.push_back(std::move(image));
+
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &result->memory) != VK_SUCCESS
+	    || vkBindImageMemory(device, result->image, result->memory, 0) != VK_SUCCESS) {
+		fprintf(stderr, "Failed to allocate memory for a %ux%u image\n", width, height);
+		return nullptr;
+	}
+
+	// Upload the pixels through a staging buffer
+	VkDeviceSize size = (VkDeviceSize)width * height * 4;
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory bufferMemory = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	bool ok = false;
+
+	VkMemoryRequirements bufferRequirements;
+	VkMemoryAllocateInfo bufferAllocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	void* mapped = nullptr;
+
+	VkCommandBufferAllocateInfo commandInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	VkBufferImageCopy region = {};
+	VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		goto cleanup;
+
+	vkGetBufferMemoryRequirements(device, buffer, &bufferRequirements);
+	bufferAllocInfo.allocationSize = bufferRequirements.size;
+	if (!FindMemoryType(bufferRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	        &bufferAllocInfo.memoryTypeIndex))
+		goto cleanup;
+
+	if (vkAllocateMemory(device, &bufferAllocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+		goto cleanup;
+	if (vkBindBufferMemory(device, buffer, bufferMemory, 0) != VK_SUCCESS)
+		goto cleanup;
+	if (vkMapMemory(device, bufferMemory, 0, size, 0, &mapped) != VK_SUCCESS)
+		goto cleanup;
+
+	if (pixels) {
+		memcpy(mapped, pixels, size);
+	} else {
+		for (VkDeviceSize i = 0; i < (VkDeviceSize)width * height; i++)
+			((uint32_t*)mapped)[i] = colour;
+	}
+	vkUnmapMemory(device, bufferMemory);
+
+	commandInfo.commandPool = commandPool;
+	commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &commandInfo, &commandBuffer) != VK_SUCCESS)
+		goto cleanup;
+
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = result->image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+	    0, nullptr, 0, nullptr, 1, &barrier);
+
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyBufferToImage(commandBuffer, buffer, result->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+	    0, nullptr, 0, nullptr, 1, &barrier);
+
+	vkEndCommandBuffer(commandBuffer);
+
+	if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		goto cleanup;
+
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+		goto cleanup;
+
+	ok = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS;
+
+cleanup:
+	if (fence)
+		vkDestroyFence(device, fence, nullptr);
+	if (commandBuffer)
+		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+	if (buffer)
+		vkDestroyBuffer(device, buffer, nullptr);
+	if (bufferMemory)
+		vkFreeMemory(device, bufferMemory, nullptr);
+
+	if (!ok) {
+		fprintf(stderr, "Failed to upload a %ux%u image\n", width, height);
+		return nullptr;
+	}
+
+	vr::VRVulkanTextureData_t& data = result->vulkanData;
+	data.m_nImage = (uint64_t)result->image;
+	data.m_pDevice = device;
+	data.m_pPhysicalDevice = physicalDevice;
+	data.m_pInstance = instance;
+	data.m_pQueue = queue;
+	data.m_nQueueFamilyIndex = queueFamily;
+	data.m_nWidth = width;
+	data.m_nHeight = height;
+	data.m_nFormat = imageInfo.format;
+	data.m_nSampleCount = 1;
+
+	result->texture.handle = &result->vulkanData;
+	result->texture.eType = vr::TextureType_Vulkan;
+	result->texture.eColorSpace = vr::ColorSpace_Auto;
+
+	return result;
+}
+
+std::string OpenVRHarness::TempPath(const std::string& name)
+{
+	if (tempDir.empty()) {
+		char dir[] = "/tmp/oc-tests-XXXXXX";
+		if (!mkdtemp(dir)) {
+			fprintf(stderr, "Failed to create a temporary directory\n");
+			return "";
+		}
+		tempDir = dir;
+	}
+
+	std::string path = tempDir + "/" + name;
+	tempFiles.push_back(path);
+	return path;
+}
+
+std::string OpenVRHarness::WriteActionManifest()
+{
+	std::string manifestPath = TempPath("actions.json");
+	std::string bindingsPath = TempPath("bindings_knuckles.json");
+	if (manifestPath.empty() || bindingsPath.empty())
+		return "";
+
+	if (!WriteFile(manifestPath, actionManifest) || !WriteFile(bindingsPath, knucklesBindings)) {
+		fprintf(stderr, "Failed to write the action manifest to %s\n", tempDir.c_str());
+		return "";
+	}
+
+	return manifestPath;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <vulkan/vulkan.h>
+
+#include "custom_interfaces/IVRClientCore_003.h"
+#include "generated/interfaces/IVRCompositor_027.h"
+#include "generated/interfaces/IVRInput_010.h"
+#include "generated/interfaces/IVROverlay_026.h"
+#include "generated/interfaces/IVRScreenshots_001.h"
+#include "generated/interfaces/IVRSystem_022.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Loads the OpenComposite we just built and runs it like a Vulkan game would, for the tests and benchmarks that need
+// the whole thing. By default it runs against the mock OpenXR runtime in tests/MockRuntime, so it works without a
+// headset, but passing '--runtime system' uses whatever OpenXR runtime is installed instead. Passing '--api gl'
+// runs it like an OpenGL game instead, with an EGL context so it doesn't need an X server.
+
+namespace openvr_harness {
+
+// The exit code that tells CTest a test was skipped, used when there's no Vulkan device to run on
+static const int SKIP_EXIT_CODE = 77;
+
+enum class GraphicsApi {
+	Vulkan,
+	OpenGL,
+};
+
+// An image the harness made, which can be submitted to the compositor or an overlay. Vulkan images are left in the
+// TRANSFER_SRC_OPTIMAL layout, which is what OpenComposite expects submitted images to be in. The harness owns
+// these, and destroys them after shutting OpenComposite down.
+struct TestImage {
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	vr::VRVulkanTextureData_t vulkanData = {};
+	uint32_t glTexture = 0; // The texture name, when running with '--api gl'
+	vr::Texture_t texture = {};
+};
+
+class OpenVRHarness {
+public:
+	~OpenVRHarness();
+
+	// Removes the harness' own options (--runtime mock|system and --api vulkan|gl) from the command line, and returns
+	// false if they're invalid
+	bool ParseArgs(int& argc, char** argv);
+
+	// Loads OpenComposite, starts it and gets the interfaces below. If this fails, it prints why and returns the
+	// exit code the program should use.
+	bool Init(int* exitCode);
+
+	// Makes an image filled with the given pixels, or a solid colour if pixels is null. Both are packed RGBA
+	// with the red channel in the lowest byte. Like OpenXR's swapchain formats, the format is a VkFormat or an
+	// OpenGL internal format depending on the API, or zero for sRGB RGBA8. Vulkan formats must have four bytes
+	// per pixel stored in that order, while OpenGL converts them to whatever the format is. OpenGL images have
+	// their first row at the bottom, as OpenGL stores them. Returns null if it fails.
+	TestImage* CreateImage(uint32_t width, uint32_t height, const uint32_t* pixels, uint32_t colour, int64_t format = 0);
+
+	// Writes an action manifest with Index controller bindings, and returns its path
+	std::string WriteActionManifest();
+
+	// Returns a path in a temporary directory, which is deleted (along with the file) when the harness is
+	std::string TempPath(const std::string& name);
+
+	// Set if we're using the mock runtime, and so the OCMockXr_ functions are meaningful
+	bool usingMock = true;
+
+	GraphicsApi api = GraphicsApi::Vulkan;
+
+	vr::IVRSystem_022::IVRSystem* system = nullptr;
+	vr::IVRCompositor_027::IVRCompositor* compositor = nullptr;
+	vr::IVRInput_010::IVRInput* input = nullptr;
+	vr::IVROverlay_026::IVROverlay* overlay = nullptr;
+	vr::IVRScreenshots_001::IVRScreenshots* screenshots = nullptr;
+
+	// Only made when running with Vulkan. With OpenGL, the context stays current on the thread that called Init.
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamily = 0;
+
+	uint32_t eyeWidth = 0;
+	uint32_t eyeHeight = 0;
+
+private:
+	bool InitVulkan();
+	bool InitGL(int* exitCode);
+	TestImage* CreateGLImage(uint32_t width, uint32_t height, const uint32_t* pixels, int64_t format);
+	void* GetInterface(const char* version);
+	bool FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t* index);
+
+	vr::IVRClientCore_003::IVRClientCore* clientCore = nullptr;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+
+	// The EGLDisplay, EGLSurface and EGLContext, which are kept out of this header along with the rest of EGL
+	void* eglDisplay = nullptr;
+	void* eglSurface = nullptr;
+	void* eglContext = nullptr;
+	std::vector<std::unique_ptr<TestImage>> images;
+	std::vector<std::string> tempFiles;
+	std::string tempDir;
+};
+
+} // namespace openvr_harness
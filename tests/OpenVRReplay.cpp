@@ -0,0 +1,1048 @@
+#include "OpenVRHarness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+// Replays an OpenVR call capture (see the captureOpenVRCalls option, and OpenOVR/Misc/CallProfiler.cpp for the
+// format) through OpenComposite, either at the speed the game made the calls or as fast as possible. That lets a
+// capture taken from a game on someone else's machine be re-run here, against the mock runtime or a real one, to
+// see how a change to OpenComposite affects it.
+//
+// Only the calls that make up a game's frames (poses, submitting, input, controller state, events and overlays)
+// are replayed, and the rest are skipped and listed at the end. The calls are all made from this thread in the
+// order they started, whichever thread the game made them from.
+//
+// The game's textures are replaced with Vulkan images of the same size, and its handles with the ones
+// OpenComposite returns when the calls that created them are replayed. Structs the game passed in (such as overlay
+// transforms) are in the capture, so those are passed back in as they were.
+
+using namespace openvr_harness;
+
+static const uint8_t CAPTURE_FUNCTION = 1;
+static const uint8_t CAPTURE_CALL = 2;
+static const uint8_t CAPTURE_FRAME = 3;
+
+static const char CAPTURE_MAGIC[8] = { 'O', 'C', 'C', 'A', 'P', 'T', '0', '3' };
+
+struct CapturedFunction {
+	std::string name; // Including the interface, eg vr::IVRCompositor_027::Submit
+	std::string method; // eg IVRCompositor::Submit, without the version
+	std::vector<std::string> argTypes;
+	std::string returnType;
+	std::vector<int> outputs;
+};
+
+struct CapturedCall {
+	uint16_t functionId;
+	uint64_t start;
+	uint32_t duration;
+	std::vector<uint8_t> payload;
+};
+
+struct Capture {
+	std::map<uint16_t, CapturedFunction> functions;
+	std::vector<CapturedCall> calls;
+	uint64_t frames = 0;
+};
+
+// A call's arguments, return value and out-parameters, split up using the function's types
+struct DecodedCall {
+	struct Value {
+		std::vector<uint8_t> bytes;
+		bool null = false;
+
+		// For structs passed in through const pointers, which are recorded as their address and contents
+		uint64_t address = 0;
+	};
+
+	std::vector<Value> args;
+	Value result;
+	std::map<int, Value> outputs;
+
+	template <typename T>
+	T Get(int index) const
+	{
+		T value = {};
+		memcpy(&value, args.at(index).bytes.data(), std::min(sizeof(T), args.at(index).bytes.size()));
+		return value;
+	}
+
+	std::string String(int index) const { return std::string(args.at(index).bytes.begin(), args.at(index).bytes.end()); }
+
+	// Reads an out-parameter that holds a single value, returning false if it wasn't recorded
+	template <typename T>
+	bool GetOutput(int index, T* value) const
+	{
+		auto iter = outputs.find(index);
+		if (iter == outputs.end())
+			return false;
+		return GetContents(iter->second, value);
+	}
+
+	// Reads a struct passed in through a const pointer, returning false if the game passed null
+	template <typename T>
+	bool GetInput(int index, T* value) const
+	{
+		return GetContents(args.at(index), value);
+	}
+
+private:
+	template <typename T>
+	static bool GetContents(const Value& contents, T* value)
+	{
+		if (contents.null || contents.bytes.size() < sizeof(T))
+			return false;
+		memcpy(value, contents.bytes.data(), sizeof(T));
+		return true;
+	}
+};
+
+class PayloadReader {
+public:
+	explicit PayloadReader(const std::vector<uint8_t>& data) : data(data) {}
+
+	bool Read(void* out, size_t size)
+	{
+		if (pos + size > data.size())
+			return false;
+		memcpy(out, data.data() + pos, size);
+		pos += size;
+		return true;
+	}
+
+	bool ReadBytes(std::vector<uint8_t>& out, size_t size)
+	{
+		if (pos + size > data.size())
+			return false;
+		out.assign(data.begin() + (ptrdiff_t)pos, data.begin() + (ptrdiff_t)(pos + size));
+		pos += size;
+		return true;
+	}
+
+private:
+	const std::vector<uint8_t>& data;
+	size_t pos = 0;
+};
+
+// How many bytes Scope::Write records for a value of the given type, or zero if we don't know. This matches
+// SCALAR_FORMATS in scripts/call_capture.py.
+static size_t ValueSize(std::string type)
+{
+	if (type.rfind("const ", 0) == 0)
+		type = type.substr(6);
+
+	if (type == "vr::Texture_t*")
+		return 28; // The handle, type, colour space, width, height and format
+	if (type == "vr::VRTextureBounds_t*")
+		return 16;
+	if (!type.empty() && type.back() == '*')
+		return 8;
+
+	static const std::unordered_map<std::string, size_t> sizes = {
+		{ "bool", 1 },
+		{ "char", 1 },
+		{ "float", 4 },
+		{ "double", 8 },
+		{ "int", 4 },
+		{ "int32_t", 4 },
+		{ "uint32_t", 4 },
+		{ "uint64_t", 8 },
+		{ "vr::TrackedDeviceIndex_t", 4 },
+		{ "vr::SharedTextureHandle_t", 8 },
+		{ "vr::VRActionHandle_t", 8 },
+		{ "vr::VRActionSetHandle_t", 8 },
+		{ "vr::VRInputValueHandle_t", 8 },
+		{ "vr::VROverlayHandle_t", 8 },
+		{ "vr::PropertyContainerHandle_t", 8 },
+		{ "vr::PropertyTypeTag_t", 4 },
+		{ "vr::VRNotificationId", 4 },
+		{ "vr::ScreenshotHandle_t", 4 },
+		{ "vr::TextureID_t", 4 },
+		{ "vr::VRComponentProperties", 4 },
+		{ "vr::PathHandle_t", 8 },
+	};
+	auto iter = sizes.find(type);
+	if (iter != sizes.end())
+		return iter->second;
+
+	// Enums are always 32-bit
+	if (type.rfind("vr::E", 0) == 0 || type.find("::E") != std::string::npos)
+		return 4;
+
+	return 0;
+}
+
+// Reads what's written by Scope::WriteOutput, once its length has been read
+static bool DecodeContents(PayloadReader& reader, uint32_t length, DecodedCall::Value* value)
+{
+	if (length == UINT32_MAX) {
+		value->null = true;
+		return true;
+	}
+	return reader.ReadBytes(value->bytes, length);
+}
+
+static bool DecodeValue(PayloadReader& reader, const std::string& type, DecodedCall::Value* value)
+{
+	if (type == "const char*") {
+		uint16_t length;
+		if (!reader.Read(&length, sizeof(length)))
+			return false;
+		if (length == UINT16_MAX) {
+			value->null = true;
+			return true;
+		}
+		return reader.ReadBytes(value->bytes, length);
+	}
+
+	// Structs passed in through const pointers are written by Scope::WriteInput, with their address then their
+	// contents as an out-parameter's would be. Textures and bounds have their own formats, see ValueSize.
+	bool hasOwnFormat = type == "const void*" || type == "const vr::Texture_t*" || type == "const vr::VRTextureBounds_t*";
+	if (type.rfind("const ", 0) == 0 && type.back() == '*' && !hasOwnFormat) {
+		uint32_t length;
+		if (!reader.Read(&value->address, sizeof(value->address)) || !reader.Read(&length, sizeof(length)))
+			return false;
+		return DecodeContents(reader, length, value);
+	}
+
+	size_t size = ValueSize(type);
+	if (size == 0)
+		return false;
+	return reader.ReadBytes(value->bytes, size);
+}
+
+// Splits up a call's payload. This stops at the first value of a type it doesn't know (such as a struct passed
+// by value), and returns false - any call we replay only uses types we know.
+static bool DecodeCall(const CapturedFunction& function, const CapturedCall& call, DecodedCall* decoded)
+{
+	PayloadReader reader(call.payload);
+
+	decoded->args.resize(function.argTypes.size());
+	for (size_t i = 0; i < function.argTypes.size(); i++) {
+		if (!DecodeValue(reader, function.argTypes[i], &decoded->args[i]))
+			return false;
+	}
+
+	if (function.returnType != "void" && !DecodeValue(reader, function.returnType, &decoded->result))
+		return false;
+
+	for (int index : function.outputs) {
+		uint32_t length;
+		if (!reader.Read(&length, sizeof(length)))
+			return false;
+
+		if (!DecodeContents(reader, length, &decoded->outputs[index]))
+			return false;
+	}
+
+	return true;
+}
+
+static bool ReadString(std::istream& in, std::string* str)
+{
+	uint16_t length;
+	if (!in.read((char*)&length, sizeof(length)))
+		return false;
+	str->resize(length);
+	return (bool)in.read(str->data(), length);
+}
+
+static std::vector<std::string> Split(const std::string& str, const std::string& separator)
+{
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start < str.size()) {
+		size_t end = str.find(separator, start);
+		if (end == std::string::npos)
+			end = str.size();
+		parts.push_back(str.substr(start, end - start));
+		start = end + separator.size();
+	}
+	return parts;
+}
+
+static bool ReadCapture(const char* path, Capture* capture)
+{
+	std::ifstream in(path, std::ios::binary);
+	char magic[sizeof(CAPTURE_MAGIC)];
+	if (!in.read(magic, sizeof(magic)) || memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0) {
+		fprintf(stderr, "'%s' isn't an OpenVR call capture, or is from an incompatible version of OpenComposite\n", path);
+		return false;
+	}
+
+	// The game might have crashed halfway through a record, so stop quietly if the file is cut short
+	uint8_t record;
+	bool truncated = false;
+	while (in.read((char*)&record, sizeof(record))) {
+		if (record == CAPTURE_FUNCTION) {
+			uint16_t id;
+			std::string name, types, outputs;
+			if (!in.read((char*)&id, sizeof(id)) || !ReadString(in, &name) || !ReadString(in, &types) || !ReadString(in, &outputs)) {
+				truncated = true;
+				break;
+			}
+
+			CapturedFunction function;
+			function.name = name;
+
+			// Drop the namespace and the interface version, so the same method matches across versions
+			std::vector<std::string> nameParts = Split(name, "::");
+			if (nameParts.size() >= 2) {
+				std::string iface = nameParts[nameParts.size() - 2];
+				iface = iface.substr(0, iface.rfind('_'));
+				function.method = iface + "::" + nameParts.back();
+			}
+
+			size_t arrow = types.rfind(" -> ");
+			function.returnType = arrow == std::string::npos ? "void" : types.substr(arrow + 4);
+			function.argTypes = Split(types.substr(0, arrow), ", ");
+			for (const std::string& index : Split(outputs, ","))
+				function.outputs.push_back(atoi(index.c_str()));
+
+			capture->functions[id] = std::move(function);
+		} else if (record == CAPTURE_CALL) {
+			CapturedCall call;
+			uint32_t thread, length;
+			if (!in.read((char*)&call.functionId, sizeof(call.functionId)) || !in.read((char*)&thread, sizeof(thread))
+			    || !in.read((char*)&call.start, sizeof(call.start)) || !in.read((char*)&call.duration, sizeof(call.duration))
+			    || !in.read((char*)&length, sizeof(length))) {
+				truncated = true;
+				break;
+			}
+			call.payload.resize(length);
+			if (!in.read((char*)call.payload.data(), length)) {
+				truncated = true;
+				break;
+			}
+			capture->calls.push_back(std::move(call));
+		} else if (record == CAPTURE_FRAME) {
+			uint64_t time;
+			if (!in.read((char*)&time, sizeof(time))) {
+				truncated = true;
+				break;
+			}
+			capture->frames++;
+		} else {
+			fprintf(stderr, "Unknown record type %d in the capture\n", record);
+			return false;
+		}
+	}
+
+	if (truncated)
+		fprintf(stderr, "Warning: capture is truncated\n");
+
+	// Each thread's calls are written out in batches, so they need sorting. If the capture was cut off, the last
+	// batch of calls might be missing their function's record.
+	std::erase_if(capture->calls, [&](const CapturedCall& call) { return !capture->functions.count(call.functionId); });
+	std::stable_sort(capture->calls.begin(), capture->calls.end(),
+	    [](const CapturedCall& a, const CapturedCall& b) { return a.start < b.start; });
+
+	return true;
+}
+
+struct FunctionStats {
+	uint64_t calls = 0;
+	uint64_t capturedNs = 0;
+	uint64_t replayedNs = 0;
+};
+
+class Replayer {
+public:
+	explicit Replayer(OpenVRHarness& harness) : harness(harness) {}
+
+	// Returns false if the call isn't one we replay, or it uses a handle we don't have
+	bool Replay(const CapturedFunction& function, const DecodedCall& call);
+
+	// Overrides the action manifest the game loaded
+	std::string manifestOverride;
+
+private:
+	using Handler = bool (Replayer::*)(const DecodedCall& call);
+	static const std::unordered_map<std::string, Handler> handlers;
+
+	bool WaitGetPoses(const DecodedCall& call);
+	bool GetLastPoses(const DecodedCall& call);
+	bool Submit(const DecodedCall& call);
+	bool SetTrackingSpace(const DecodedCall& call);
+	bool ClearLastSubmittedFrame(const DecodedCall& call);
+	bool PostPresentHandoff(const DecodedCall& call);
+
+	bool GetControllerState(const DecodedCall& call);
+	bool GetTrackedDeviceIndexForControllerRole(const DecodedCall& call);
+	bool GetDeviceToAbsoluteTrackingPose(const DecodedCall& call);
+	bool IsTrackedDeviceConnected(const DecodedCall& call);
+	bool GetTrackedDeviceClass(const DecodedCall& call);
+	bool PollNextEvent(const DecodedCall& call);
+	bool GetBoolTrackedDeviceProperty(const DecodedCall& call);
+	bool GetFloatTrackedDeviceProperty(const DecodedCall& call);
+	bool GetInt32TrackedDeviceProperty(const DecodedCall& call);
+	bool GetUint64TrackedDeviceProperty(const DecodedCall& call);
+	bool GetStringTrackedDeviceProperty(const DecodedCall& call);
+
+	bool SetActionManifestPath(const DecodedCall& call);
+	bool GetActionSetHandle(const DecodedCall& call);
+	bool GetActionHandle(const DecodedCall& call);
+	bool GetInputSourceHandle(const DecodedCall& call);
+	bool UpdateActionState(const DecodedCall& call);
+	bool GetDigitalActionData(const DecodedCall& call);
+	bool GetAnalogActionData(const DecodedCall& call);
+	bool GetPoseActionDataForNextFrame(const DecodedCall& call);
+	bool GetPoseActionDataRelativeToNow(const DecodedCall& call);
+	bool TriggerHapticVibrationAction(const DecodedCall& call);
+
+	bool CreateOverlay(const DecodedCall& call);
+	bool FindOverlay(const DecodedCall& call);
+	bool DestroyOverlay(const DecodedCall& call);
+	bool ShowOverlay(const DecodedCall& call);
+	bool HideOverlay(const DecodedCall& call);
+	bool IsOverlayVisible(const DecodedCall& call);
+	bool SetOverlayWidthInMeters(const DecodedCall& call);
+	bool SetOverlayAlpha(const DecodedCall& call);
+	bool SetOverlayColor(const DecodedCall& call);
+	bool SetOverlaySortOrder(const DecodedCall& call);
+	bool SetOverlayTexture(const DecodedCall& call);
+	bool SetOverlayTextureBounds(const DecodedCall& call);
+	bool SetOverlayTransformAbsolute(const DecodedCall& call);
+	bool SetOverlayTransformTrackedDeviceRelative(const DecodedCall& call);
+
+	// Maps a handle from the capture to ours. Zero (the invalid handle) maps to itself.
+	static bool MapHandle(const std::unordered_map<uint64_t, uint64_t>& handles, uint64_t captured, uint64_t* ours);
+
+	// Finds (or makes) an image to stand in for one of the game's textures
+	vr::Texture_t* GetTexture(const std::vector<uint8_t>& captured, uint32_t defaultWidth, uint32_t defaultHeight);
+
+	// Reads a VRTextureBounds_t argument, returning null if the game passed null
+	static const vr::VRTextureBounds_t* GetBounds(const DecodedCall& call, int index, vr::VRTextureBounds_t* bounds);
+
+	OpenVRHarness& harness;
+
+	std::unordered_map<uint64_t, uint64_t> actionHandles; // Both actions and action sets
+	std::unordered_map<uint64_t, uint64_t> inputSourceHandles;
+	std::unordered_map<uint64_t, uint64_t> overlayHandles;
+	std::map<std::tuple<uint64_t, uint32_t, uint32_t>, TestImage*> textures;
+
+	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+	vr::TrackedDevicePose_t gamePoses[vr::k_unMaxTrackedDeviceCount];
+};
+
+const std::unordered_map<std::string, Replayer::Handler> Replayer::handlers = {
+	{ "IVRCompositor::WaitGetPoses", &Replayer::WaitGetPoses },
+	{ "IVRCompositor::GetLastPoses", &Replayer::GetLastPoses },
+	{ "IVRCompositor::Submit", &Replayer::Submit },
+	{ "IVRCompositor::SetTrackingSpace", &Replayer::SetTrackingSpace },
+	{ "IVRCompositor::ClearLastSubmittedFrame", &Replayer::ClearLastSubmittedFrame },
+	{ "IVRCompositor::PostPresentHandoff", &Replayer::PostPresentHandoff },
+
+	{ "IVRSystem::GetControllerState", &Replayer::GetControllerState },
+	{ "IVRSystem::GetTrackedDeviceIndexForControllerRole", &Replayer::GetTrackedDeviceIndexForControllerRole },
+	{ "IVRSystem::GetDeviceToAbsoluteTrackingPose", &Replayer::GetDeviceToAbsoluteTrackingPose },
+	{ "IVRSystem::IsTrackedDeviceConnected", &Replayer::IsTrackedDeviceConnected },
+	{ "IVRSystem::GetTrackedDeviceClass", &Replayer::GetTrackedDeviceClass },
+	{ "IVRSystem::PollNextEvent", &Replayer::PollNextEvent },
+	{ "IVRSystem::GetBoolTrackedDeviceProperty", &Replayer::GetBoolTrackedDeviceProperty },
+	{ "IVRSystem::GetFloatTrackedDeviceProperty", &Replayer::GetFloatTrackedDeviceProperty },
+	{ "IVRSystem::GetInt32TrackedDeviceProperty", &Replayer::GetInt32TrackedDeviceProperty },
+	{ "IVRSystem::GetUint64TrackedDeviceProperty", &Replayer::GetUint64TrackedDeviceProperty },
+	{ "IVRSystem::GetStringTrackedDeviceProperty", &Replayer::GetStringTrackedDeviceProperty },
+
+	{ "IVRInput::SetActionManifestPath", &Replayer::SetActionManifestPath },
+	{ "IVRInput::GetActionSetHandle", &Replayer::GetActionSetHandle },
+	{ "IVRInput::GetActionHandle", &Replayer::GetActionHandle },
+	{ "IVRInput::GetInputSourceHandle", &Replayer::GetInputSourceHandle },
+	{ "IVRInput::UpdateActionState", &Replayer::UpdateActionState },
+	{ "IVRInput::GetDigitalActionData", &Replayer::GetDigitalActionData },
+	{ "IVRInput::GetAnalogActionData", &Replayer::GetAnalogActionData },
+	{ "IVRInput::GetPoseActionDataForNextFrame", &Replayer::GetPoseActionDataForNextFrame },
+	{ "IVRInput::GetPoseActionDataRelativeToNow", &Replayer::GetPoseActionDataRelativeToNow },
+	{ "IVRInput::TriggerHapticVibrationAction", &Replayer::TriggerHapticVibrationAction },
+
+	{ "IVROverlay::CreateOverlay", &Replayer::CreateOverlay },
+	{ "IVROverlay::FindOverlay", &Replayer::FindOverlay },
+	{ "IVROverlay::DestroyOverlay", &Replayer::DestroyOverlay },
+	{ "IVROverlay::ShowOverlay", &Replayer::ShowOverlay },
+	{ "IVROverlay::HideOverlay", &Replayer::HideOverlay },
+	{ "IVROverlay::IsOverlayVisible", &Replayer::IsOverlayVisible },
+	{ "IVROverlay::SetOverlayWidthInMeters", &Replayer::SetOverlayWidthInMeters },
+	{ "IVROverlay::SetOverlayAlpha", &Replayer::SetOverlayAlpha },
+	{ "IVROverlay::SetOverlayColor", &Replayer::SetOverlayColor },
+	{ "IVROverlay::SetOverlaySortOrder", &Replayer::SetOverlaySortOrder },
+	{ "IVROverlay::SetOverlayTexture", &Replayer::SetOverlayTexture },
+	{ "IVROverlay::SetOverlayTextureBounds", &Replayer::SetOverlayTextureBounds },
+	{ "IVROverlay::SetOverlayTransformAbsolute", &Replayer::SetOverlayTransformAbsolute },
+	{ "IVROverlay::SetOverlayTransformTrackedDeviceRelative", &Replayer::SetOverlayTransformTrackedDeviceRelative },
+};
+
+bool Replayer::Replay(const CapturedFunction& function, const DecodedCall& call)
+{
+	auto iter = handlers.find(function.method);
+	if (iter == handlers.end())
+		return false;
+	return (this->*iter->second)(call);
+}
+
+bool Replayer::MapHandle(const std::unordered_map<uint64_t, uint64_t>& handles, uint64_t captured, uint64_t* ours)
+{
+	if (captured == 0) {
+		*ours = 0;
+		return true;
+	}
+
+	auto iter = handles.find(captured);
+	if (iter == handles.end())
+		return false;
+	*ours = iter->second;
+	return true;
+}
+
+vr::Texture_t* Replayer::GetTexture(const std::vector<uint8_t>& captured, uint32_t defaultWidth, uint32_t defaultHeight)
+{
+	// See Scope::WriteTexture
+	uint64_t handle;
+	int32_t type;
+	uint32_t width, height;
+	memcpy(&handle, captured.data(), sizeof(handle));
+	memcpy(&type, captured.data() + 8, sizeof(type));
+	memcpy(&width, captured.data() + 16, sizeof(width));
+	memcpy(&height, captured.data() + 20, sizeof(height));
+	if (type == -1)
+		return nullptr;
+
+	// The size couldn't always be found when capturing
+	if (width == 0 || height == 0) {
+		width = defaultWidth;
+		height = defaultHeight;
+	}
+
+	auto key = std::make_tuple(handle, width, height);
+	TestImage*& image = textures[key];
+	if (!image) {
+		// Give each texture its own colour, so they can be told apart
+		uint32_t colour = 0xff000000 | (uint32_t)(handle * 2654435761u >> 8);
+		image = harness.CreateImage(width, height, nullptr, colour);
+		if (!image)
+			return nullptr;
+	}
+	return &image->texture;
+}
+
+const vr::VRTextureBounds_t* Replayer::GetBounds(const DecodedCall& call, int index, vr::VRTextureBounds_t* bounds)
+{
+	*bounds = call.Get<vr::VRTextureBounds_t>(index);
+	if (bounds->uMin == -1 && bounds->vMin == -1 && bounds->uMax == -1 && bounds->vMax == -1)
+		return nullptr;
+	return bounds;
+}
+
+bool Replayer::WaitGetPoses(const DecodedCall& call)
+{
+	uint32_t renderCount = std::min(call.Get<uint32_t>(1), vr::k_unMaxTrackedDeviceCount);
+	uint32_t gameCount = std::min(call.Get<uint32_t>(3), vr::k_unMaxTrackedDeviceCount);
+	harness.compositor->WaitGetPoses(call.Get<uint64_t>(0) ? poses : nullptr, renderCount, call.Get<uint64_t>(2) ? gamePoses : nullptr, gameCount);
+	return true;
+}
+
+bool Replayer::GetLastPoses(const DecodedCall& call)
+{
+	uint32_t renderCount = std::min(call.Get<uint32_t>(1), vr::k_unMaxTrackedDeviceCount);
+	uint32_t gameCount = std::min(call.Get<uint32_t>(3), vr::k_unMaxTrackedDeviceCount);
+	harness.compositor->GetLastPoses(call.Get<uint64_t>(0) ? poses : nullptr, renderCount, call.Get<uint64_t>(2) ? gamePoses : nullptr, gameCount);
+	return true;
+}
+
+bool Replayer::Submit(const DecodedCall& call)
+{
+	vr::Texture_t* texture = GetTexture(call.args.at(1).bytes, harness.eyeWidth, harness.eyeHeight);
+	if (!texture)
+		return false;
+
+	// The flags are dropped, since some of them (Submit_TextureWithPose, for example) mean the texture is part of
+	// a bigger struct that wasn't captured
+	vr::VRTextureBounds_t bounds;
+	harness.compositor->Submit(call.Get<vr::EVREye>(0), texture, GetBounds(call, 2, &bounds), vr::Submit_Default);
+	return true;
+}
+
+bool Replayer::SetTrackingSpace(const DecodedCall& call)
+{
+	harness.compositor->SetTrackingSpace(call.Get<vr::ETrackingUniverseOrigin>(0));
+	return true;
+}
+
+bool Replayer::ClearLastSubmittedFrame(const DecodedCall&)
+{
+	harness.compositor->ClearLastSubmittedFrame();
+	return true;
+}
+
+bool Replayer::PostPresentHandoff(const DecodedCall&)
+{
+	harness.compositor->PostPresentHandoff();
+	return true;
+}
+
+bool Replayer::GetControllerState(const DecodedCall& call)
+{
+	vr::VRControllerState_t state;
+	harness.system->GetControllerState(call.Get<vr::TrackedDeviceIndex_t>(0), &state, sizeof(state));
+	return true;
+}
+
+bool Replayer::GetTrackedDeviceIndexForControllerRole(const DecodedCall& call)
+{
+	harness.system->GetTrackedDeviceIndexForControllerRole(call.Get<vr::ETrackedControllerRole>(0));
+	return true;
+}
+
+bool Replayer::GetDeviceToAbsoluteTrackingPose(const DecodedCall& call)
+{
+	uint32_t count = std::min(call.Get<uint32_t>(3), vr::k_unMaxTrackedDeviceCount);
+	harness.system->GetDeviceToAbsoluteTrackingPose(call.Get<vr::ETrackingUniverseOrigin>(0), call.Get<float>(1), poses, count);
+	return true;
+}
+
+bool Replayer::IsTrackedDeviceConnected(const DecodedCall& call)
+{
+	harness.system->IsTrackedDeviceConnected(call.Get<vr::TrackedDeviceIndex_t>(0));
+	return true;
+}
+
+bool Replayer::GetTrackedDeviceClass(const DecodedCall& call)
+{
+	harness.system->GetTrackedDeviceClass(call.Get<vr::TrackedDeviceIndex_t>(0));
+	return true;
+}
+
+bool Replayer::PollNextEvent(const DecodedCall&)
+{
+	// Drain every event, like a game would, so they don't pile up
+	vr::VREvent_t event;
+	while (harness.system->PollNextEvent(&event, sizeof(event))) {
+	}
+	return true;
+}
+
+bool Replayer::GetBoolTrackedDeviceProperty(const DecodedCall& call)
+{
+	vr::ETrackedPropertyError error;
+	harness.system->GetBoolTrackedDeviceProperty(call.Get<vr::TrackedDeviceIndex_t>(0), call.Get<vr::ETrackedDeviceProperty>(1), &error);
+	return true;
+}
+
+bool Replayer::GetFloatTrackedDeviceProperty(const DecodedCall& call)
+{
+	vr::ETrackedPropertyError error;
+	harness.system->GetFloatTrackedDeviceProperty(call.Get<vr::TrackedDeviceIndex_t>(0), call.Get<vr::ETrackedDeviceProperty>(1), &error);
+	return true;
+}
+
+bool Replayer::GetInt32TrackedDeviceProperty(const DecodedCall& call)
+{
+	vr::ETrackedPropertyError error;
+	harness.system->GetInt32TrackedDeviceProperty(call.Get<vr::TrackedDeviceIndex_t>(0), call.Get<vr::ETrackedDeviceProperty>(1), &error);
+	return true;
+}
+
+bool Replayer::GetUint64TrackedDeviceProperty(const DecodedCall& call)
+{
+	vr::ETrackedPropertyError error;
+	harness.system->GetUint64TrackedDeviceProperty(call.Get<vr::TrackedDeviceIndex_t>(0), call.Get<vr::ETrackedDeviceProperty>(1), &error);
+	return true;
+}
+
+bool Replayer::GetStringTrackedDeviceProperty(const DecodedCall& call)
+{
+	char buffer[vr::k_unMaxPropertyStringSize];
+	uint32_t size = std::min<uint32_t>(call.Get<uint32_t>(3), sizeof(buffer));
+	vr::ETrackedPropertyError error;
+	harness.system->GetStringTrackedDeviceProperty(call.Get<vr::TrackedDeviceIndex_t>(0), call.Get<vr::ETrackedDeviceProperty>(1),
+	    call.Get<uint64_t>(2) ? buffer : nullptr, size, &error);
+	return true;
+}
+
+bool Replayer::SetActionManifestPath(const DecodedCall& call)
+{
+	// The game's manifest is usually only there on the machine it was captured on
+	std::string path = manifestOverride.empty() ? call.String(0) : manifestOverride;
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) {
+		fprintf(stderr, "The game's action manifest '%s' isn't here, using the test manifest instead. Pass --manifest "
+		                "to use a copy of the game's.\n",
+		    path.c_str());
+		path = harness.WriteActionManifest();
+	}
+
+	harness.input->SetActionManifestPath(path.c_str());
+	return true;
+}
+
+bool Replayer::GetActionSetHandle(const DecodedCall& call)
+{
+	vr::VRActionSetHandle_t handle = vr::k_ulInvalidActionSetHandle;
+	harness.input->GetActionSetHandle(call.String(0).c_str(), &handle);
+
+	uint64_t captured;
+	if (call.GetOutput(1, &captured) && handle != vr::k_ulInvalidActionSetHandle)
+		actionHandles[captured] = handle;
+	return true;
+}
+
+bool Replayer::GetActionHandle(const DecodedCall& call)
+{
+	vr::VRActionHandle_t handle = vr::k_ulInvalidActionHandle;
+	harness.input->GetActionHandle(call.String(0).c_str(), &handle);
+
+	uint64_t captured;
+	if (call.GetOutput(1, &captured) && handle != vr::k_ulInvalidActionHandle)
+		actionHandles[captured] = handle;
+	return true;
+}
+
+bool Replayer::GetInputSourceHandle(const DecodedCall& call)
+{
+	vr::VRInputValueHandle_t handle = vr::k_ulInvalidInputValueHandle;
+	harness.input->GetInputSourceHandle(call.String(0).c_str(), &handle);
+
+	uint64_t captured;
+	if (call.GetOutput(1, &captured) && handle != vr::k_ulInvalidInputValueHandle)
+		inputSourceHandles[captured] = handle;
+	return true;
+}
+
+bool Replayer::UpdateActionState(const DecodedCall& call)
+{
+	// The active sets are recorded as an out-parameter, since they're passed through a non-const pointer. Older
+	// games have a smaller VRActiveActionSet_t, so go by the size they passed in.
+	uint32_t elementSize = call.Get<uint32_t>(1);
+	uint32_t count = call.Get<uint32_t>(2);
+	auto iter = call.outputs.find(0);
+	if (iter == call.outputs.end() || elementSize < 16 || iter->second.bytes.size() < (size_t)elementSize * count)
+		return false;
+
+	std::vector<vr::IVRInput_010::VRActiveActionSet_t> sets(count);
+	for (uint32_t i = 0; i < count; i++) {
+		const uint8_t* captured = iter->second.bytes.data() + (size_t)i * elementSize;
+		memcpy(&sets[i], captured, std::min<size_t>(elementSize, sizeof(sets[i])));
+		if (!MapHandle(actionHandles, sets[i].ulActionSet, &sets[i].ulActionSet)
+		    || !MapHandle(inputSourceHandles, sets[i].ulRestrictedToDevice, &sets[i].ulRestrictedToDevice))
+			return false;
+		if (elementSize >= 24 && !MapHandle(actionHandles, sets[i].ulSecondaryActionSet, &sets[i].ulSecondaryActionSet))
+			return false;
+	}
+
+	harness.input->UpdateActionState(sets.data(), sizeof(sets[0]), count);
+	return true;
+}
+
+bool Replayer::GetDigitalActionData(const DecodedCall& call)
+{
+	uint64_t action, restrictTo;
+	if (!MapHandle(actionHandles, call.Get<uint64_t>(0), &action) || !MapHandle(inputSourceHandles, call.Get<uint64_t>(3), &restrictTo))
+		return false;
+
+	vr::IVRInput_010::InputDigitalActionData_t data;
+	harness.input->GetDigitalActionData(action, &data, sizeof(data), restrictTo);
+	return true;
+}
+
+bool Replayer::GetAnalogActionData(const DecodedCall& call)
+{
+	uint64_t action, restrictTo;
+	if (!MapHandle(actionHandles, call.Get<uint64_t>(0), &action) || !MapHandle(inputSourceHandles, call.Get<uint64_t>(3), &restrictTo))
+		return false;
+
+	vr::IVRInput_010::InputAnalogActionData_t data;
+	harness.input->GetAnalogActionData(action, &data, sizeof(data), restrictTo);
+	return true;
+}
+
+bool Replayer::GetPoseActionDataForNextFrame(const DecodedCall& call)
+{
+	uint64_t action, restrictTo;
+	if (!MapHandle(actionHandles, call.Get<uint64_t>(0), &action) || !MapHandle(inputSourceHandles, call.Get<uint64_t>(4), &restrictTo))
+		return false;
+
+	vr::IVRInput_010::InputPoseActionData_t data;
+	harness.input->GetPoseActionDataForNextFrame(action, call.Get<vr::ETrackingUniverseOrigin>(1), &data, sizeof(data), restrictTo);
+	return true;
+}
+
+bool Replayer::GetPoseActionDataRelativeToNow(const DecodedCall& call)
+{
+	uint64_t action, restrictTo;
+	if (!MapHandle(actionHandles, call.Get<uint64_t>(0), &action) || !MapHandle(inputSourceHandles, call.Get<uint64_t>(5), &restrictTo))
+		return false;
+
+	vr::IVRInput_010::InputPoseActionData_t data;
+	harness.input->GetPoseActionDataRelativeToNow(action, call.Get<vr::ETrackingUniverseOrigin>(1), call.Get<float>(2), &data, sizeof(data), restrictTo);
+	return true;
+}
+
+bool Replayer::TriggerHapticVibrationAction(const DecodedCall& call)
+{
+	uint64_t action, restrictTo;
+	if (!MapHandle(actionHandles, call.Get<uint64_t>(0), &action) || !MapHandle(inputSourceHandles, call.Get<uint64_t>(5), &restrictTo))
+		return false;
+
+	harness.input->TriggerHapticVibrationAction(action, call.Get<float>(1), call.Get<float>(2), call.Get<float>(3), call.Get<float>(4), restrictTo);
+	return true;
+}
+
+bool Replayer::CreateOverlay(const DecodedCall& call)
+{
+	vr::VROverlayHandle_t handle = vr::k_ulOverlayHandleInvalid;
+	harness.overlay->CreateOverlay(call.String(0).c_str(), call.String(1).c_str(), &handle);
+
+	uint64_t captured;
+	if (call.GetOutput(2, &captured) && handle != vr::k_ulOverlayHandleInvalid)
+		overlayHandles[captured] = handle;
+	return true;
+}
+
+bool Replayer::FindOverlay(const DecodedCall& call)
+{
+	vr::VROverlayHandle_t handle = vr::k_ulOverlayHandleInvalid;
+	harness.overlay->FindOverlay(call.String(0).c_str(), &handle);
+
+	uint64_t captured;
+	if (call.GetOutput(1, &captured) && handle != vr::k_ulOverlayHandleInvalid)
+		overlayHandles[captured] = handle;
+	return true;
+}
+
+bool Replayer::DestroyOverlay(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->DestroyOverlay(overlay);
+	overlayHandles.erase(call.Get<uint64_t>(0));
+	return true;
+}
+
+bool Replayer::ShowOverlay(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->ShowOverlay(overlay);
+	return true;
+}
+
+bool Replayer::HideOverlay(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->HideOverlay(overlay);
+	return true;
+}
+
+bool Replayer::IsOverlayVisible(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->IsOverlayVisible(overlay);
+	return true;
+}
+
+bool Replayer::SetOverlayWidthInMeters(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->SetOverlayWidthInMeters(overlay, call.Get<float>(1));
+	return true;
+}
+
+bool Replayer::SetOverlayAlpha(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->SetOverlayAlpha(overlay, call.Get<float>(1));
+	return true;
+}
+
+bool Replayer::SetOverlayColor(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->SetOverlayColor(overlay, call.Get<float>(1), call.Get<float>(2), call.Get<float>(3));
+	return true;
+}
+
+bool Replayer::SetOverlaySortOrder(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	harness.overlay->SetOverlaySortOrder(overlay, call.Get<uint32_t>(1));
+	return true;
+}
+
+bool Replayer::SetOverlayTexture(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	vr::Texture_t* texture = GetTexture(call.args.at(1).bytes, 256, 256);
+	if (!texture)
+		return false;
+
+	harness.overlay->SetOverlayTexture(overlay, texture);
+	return true;
+}
+
+bool Replayer::SetOverlayTextureBounds(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	vr::VRTextureBounds_t bounds;
+	harness.overlay->SetOverlayTextureBounds(overlay, GetBounds(call, 1, &bounds));
+	return true;
+}
+
+bool Replayer::SetOverlayTransformAbsolute(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	vr::HmdMatrix34_t transform;
+	if (!call.GetInput(2, &transform))
+		return false;
+
+	harness.overlay->SetOverlayTransformAbsolute(overlay, call.Get<vr::ETrackingUniverseOrigin>(1), &transform);
+	return true;
+}
+
+bool Replayer::SetOverlayTransformTrackedDeviceRelative(const DecodedCall& call)
+{
+	uint64_t overlay;
+	if (!MapHandle(overlayHandles, call.Get<uint64_t>(0), &overlay))
+		return false;
+
+	vr::HmdMatrix34_t transform;
+	if (!call.GetInput(2, &transform))
+		return false;
+
+	harness.overlay->SetOverlayTransformTrackedDeviceRelative(overlay, call.Get<vr::TrackedDeviceIndex_t>(1), &transform);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv))
+		return EXIT_FAILURE;
+
+	const char* capturePath = nullptr;
+	const char* manifest = nullptr;
+	bool maxSpeed = false;
+	bool argsOk = true;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+			const char* speed = argv[++i];
+			maxSpeed = strcmp(speed, "max") == 0;
+			argsOk &= maxSpeed || strcmp(speed, "original") == 0;
+		} else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+			manifest = argv[++i];
+		} else if (argv[i][0] != '-' && !capturePath) {
+			capturePath = argv[i];
+		} else {
+			argsOk = false;
+		}
+	}
+	if (!argsOk || !capturePath) {
+		fprintf(stderr, "Usage: %s [--runtime mock|system] [--speed original|max] [--manifest actions.json] capture\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Capture capture;
+	if (!ReadCapture(capturePath, &capture))
+		return EXIT_FAILURE;
+	if (capture.calls.empty()) {
+		fprintf(stderr, "The capture doesn't have any calls in it\n");
+		return EXIT_FAILURE;
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	Replayer replayer(harness);
+	if (manifest)
+		replayer.manifestOverride = manifest;
+
+	// Indexed by function ID
+	std::map<uint16_t, FunctionStats> replayed;
+	std::map<uint16_t, FunctionStats> skipped;
+
+	uint64_t firstStart = capture.calls.front().start;
+	auto replayStart = std::chrono::steady_clock::now();
+
+	for (const CapturedCall& call : capture.calls) {
+		const CapturedFunction& function = capture.functions.at(call.functionId);
+
+		// Make the call at the same point after the start as the game did. If we've fallen behind (because a call
+		// took longer here), carry on straight away rather than trying to catch up.
+		if (!maxSpeed)
+			std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(call.start - firstStart));
+
+		DecodedCall decoded;
+		bool ok = DecodeCall(function, call, &decoded);
+
+		auto start = std::chrono::steady_clock::now();
+		ok = ok && replayer.Replay(function, decoded);
+		auto end = std::chrono::steady_clock::now();
+
+		FunctionStats& stats = ok ? replayed[call.functionId] : skipped[call.functionId];
+		stats.calls++;
+		stats.capturedNs += call.duration;
+		if (ok)
+			stats.replayedNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+
+	double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+	double captureSeconds = (double)(capture.calls.back().start - firstStart) / 1e9;
+
+	printf("Replayed %s: %llu frames, %.2fs in the capture, %.2fs replaying at %s speed on the %s runtime\n", capturePath,
+	    (unsigned long long)capture.frames, captureSeconds, replaySeconds, maxSpeed ? "max" : "original",
+	    harness.usingMock ? "mock" : "system");
+
+	printf("%-60s %10s %14s %14s\n", "function", "calls", "captured us", "replayed us");
+	for (const auto& [id, stats] : replayed) {
+		printf("%-60s %10llu %14.2f %14.2f\n", capture.functions.at(id).name.c_str(), (unsigned long long)stats.calls,
+		    stats.capturedNs / 1e3 / stats.calls, stats.replayedNs / 1e3 / stats.calls);
+	}
+
+	if (!skipped.empty()) {
+		printf("\nSkipped, either not supported or using a handle we don't have:\n");
+		for (const auto& [id, stats] : skipped)
+			printf("%-60s %10llu\n", capture.functions.at(id).name.c_str(), (unsigned long long)stats.calls);
+	}
+
+	return EXIT_SUCCESS;
+}
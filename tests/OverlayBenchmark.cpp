@@ -0,0 +1,186 @@
+#include "OpenVRHarness.h"
+
+#include "AllocationCounter.h"
+#include "MockRuntime/MockRuntime.h"
+
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Measures what a frame costs with 1, 16 and 128 overlays showing. Each is run two ways: 'static', where the game
+// sets every overlay's texture each frame but nothing else changes, so OpenComposite can reuse the layer list it
+// built last frame; and 'moving', where one overlay is moved each frame, so the list has to be rebuilt.
+//
+// Against the mock runtime this also checks every overlay reaches the runtime as a layer, in sort order.
+
+using namespace openvr_harness;
+
+static const int OVERLAY_COUNTS[] = { 1, 16, 128 };
+
+struct Result {
+	double ns = 0;
+	uint64_t allocations = 0;
+	uint64_t calls = 0;
+};
+
+static vr::HmdMatrix34_t OverlayTransform(int index, float height)
+{
+	// Spread them out along a line in front of the player, so their layers can be told apart by position
+	vr::HmdMatrix34_t transform = { {
+	    { 1, 0, 0, index * 0.01f },
+	    { 0, 1, 0, height },
+	    { 0, 0, 1, -2 },
+	} };
+	return transform;
+}
+
+static bool RunFrames(OpenVRHarness& harness, TestImage* const* eyes, TestImage* overlayImage, const std::vector<vr::VROverlayHandle_t>& overlays,
+    int frames, bool moving, Result* result)
+{
+	for (int frame = 0; frame < frames; frame++) {
+		uint64_t startAllocations = GetAllocationCount();
+		uint64_t startCalls = harness.usingMock ? OCMockXr_GetTotalCalls() : 0;
+		auto start = std::chrono::steady_clock::now();
+
+		vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+		harness.compositor->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
+
+		for (vr::VROverlayHandle_t overlay : overlays)
+			harness.overlay->SetOverlayTexture(overlay, &overlayImage->texture);
+
+		if (moving) {
+			int index = frame % (int)overlays.size();
+			vr::HmdMatrix34_t transform = OverlayTransform(index, 1.5f + (frame % 10) * 0.01f);
+			harness.overlay->SetOverlayTransformAbsolute(overlays[index], vr::TrackingUniverseStanding, &transform);
+		}
+
+		for (int eye = 0; eye < 2; eye++) {
+			if (harness.compositor->Submit((vr::EVREye)eye, &eyes[eye]->texture) != vr::IVRCompositor_027::VRCompositorError_None) {
+				fprintf(stderr, "Submit failed\n");
+				return false;
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+		result->ns += std::chrono::duration<double, std::nano>(end - start).count();
+		result->allocations += GetAllocationCount() - startAllocations;
+		if (harness.usingMock)
+			result->calls += OCMockXr_GetTotalCalls() - startCalls;
+	}
+
+	return true;
+}
+
+// Checks the last frame had the projection layer and then a quad for each overlay, with the highest sort order last
+static bool CheckLayers(int overlayCount)
+{
+	std::vector<OCMockXrLayer> layers(overlayCount + 2);
+	uint32_t layerCount = OCMockXr_GetLastFrameLayers(layers.data(), (uint32_t)layers.size());
+	if (layerCount != (uint32_t)overlayCount + 1) {
+		fprintf(stderr, "Expected %d layers, got %u\n", overlayCount + 1, layerCount);
+		return false;
+	}
+
+	if (layers[0].type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+		fprintf(stderr, "The first layer isn't the projection layer\n");
+		return false;
+	}
+
+	// The overlays' sort order is the reverse of their index (see main), and their index is their X position
+	for (int i = 1; i <= overlayCount; i++) {
+		int expectedIndex = overlayCount - i;
+		float expectedX = expectedIndex * 0.01f;
+		if (layers[i].type != XR_TYPE_COMPOSITION_LAYER_QUAD || fabsf(layers[i].position[0] - expectedX) > 0.001f) {
+			fprintf(stderr, "Layer %d should be overlay %d, but it's at x=%f\n", i, expectedIndex, layers[i].position[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv))
+		return EXIT_FAILURE;
+
+	int frames = 1000;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--runtime mock|system] [--frames count]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	harness.compositor->SetTrackingSpace(vr::TrackingUniverseStanding);
+
+	TestImage* eyes[2] = {
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff402010),
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff102040),
+	};
+	TestImage* overlayImage = harness.CreateImage(64, 64, nullptr, 0xc0ffffff);
+	if (!eyes[0] || !eyes[1] || !overlayImage)
+		return EXIT_FAILURE;
+
+	// Lets the session start, and the overlays' swapchains get created, before anything is timed
+	const int warmupFrames = 20;
+
+	printf("%d frames, %s runtime\n", frames, harness.usingMock ? "mock" : "system");
+	printf("%-10s %-8s %12s %14s %14s\n", "overlays", "case", "ns/frame", "allocs/frame", "xr calls/frame");
+
+	for (int overlayCount : OVERLAY_COUNTS) {
+		std::vector<vr::VROverlayHandle_t> overlays;
+		for (int i = 0; i < overlayCount; i++) {
+			char key[64];
+			snprintf(key, sizeof(key), "oc.benchmark.overlay%d", i);
+
+			vr::VROverlayHandle_t overlay;
+			if (harness.overlay->CreateOverlay(key, key, &overlay) != vr::VROverlayError_None) {
+				fprintf(stderr, "Failed to create overlay %d\n", i);
+				return EXIT_FAILURE;
+			}
+			overlays.push_back(overlay);
+
+			vr::HmdMatrix34_t transform = OverlayTransform(i, 1.5f);
+			harness.overlay->SetOverlayTransformAbsolute(overlay, vr::TrackingUniverseStanding, &transform);
+			harness.overlay->SetOverlayWidthInMeters(overlay, 0.2f);
+			harness.overlay->SetOverlaySortOrder(overlay, overlayCount - i);
+			harness.overlay->ShowOverlay(overlay);
+		}
+
+		for (bool moving : { false, true }) {
+			Result warmup, result;
+			if (!RunFrames(harness, eyes, overlayImage, overlays, warmupFrames, moving, &warmup))
+				return EXIT_FAILURE;
+			if (!RunFrames(harness, eyes, overlayImage, overlays, frames, moving, &result))
+				return EXIT_FAILURE;
+
+			if (harness.usingMock && !CheckLayers(overlayCount))
+				return EXIT_FAILURE;
+
+			double count = frames > 0 ? frames : 1;
+			const char* name = moving ? "moving" : "static";
+			if (harness.usingMock) {
+				printf("%-10d %-8s %12.0f %14.2f %14.2f\n", overlayCount, name, result.ns / count, result.allocations / count, result.calls / count);
+			} else {
+				printf("%-10d %-8s %12.0f %14.2f %14s\n", overlayCount, name, result.ns / count, result.allocations / count, "-");
+			}
+		}
+
+		for (vr::VROverlayHandle_t overlay : overlays)
+			harness.overlay->DestroyOverlay(overlay);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "stdafx.h"
+
+#include "Misc/PlayAreaGeometry.h"
+#include "TestUtil.h"
+
+#include <math.h>
+
+// Checks PlayAreaGeometry's bounding box and DistanceToBoundary against play areas whose distances are easy to
+// work out by hand, including a concave one and one that goes round the other way.
+
+static std::vector<vr::HmdVector3_t> Polygon(std::initializer_list<std::pair<float, float>> corners)
+{
+	std::vector<vr::HmdVector3_t> points;
+	for (const auto& [x, z] : corners)
+		points.push_back(vr::HmdVector3_t{ x, 0, z });
+	return points;
+}
+
+static void CheckDistance(const PlayAreaGeometry& playArea, const char* name, float x, float z, float expected)
+{
+	float distance = playArea.DistanceToBoundary(x, z);
+	CHECKF(fabsf(distance - expected) < 1e-5f, "%s at %g,%g: got %g, expected %g", name, x, z, distance, expected);
+}
+
+int main()
+{
+	// A 3x2 rectangle around the origin, as XrBackend builds from the stage bounds
+	PlayAreaGeometry rect(Polygon({ { -1.5f, -1 }, { 1.5f, -1 }, { 1.5f, 1 }, { -1.5f, 1 } }));
+	CHECK(rect.edges.size() == 4);
+	CHECK(rect.minPoint.v[0] == -1.5f && rect.minPoint.v[2] == -1);
+	CHECK(rect.maxPoint.v[0] == 1.5f && rect.maxPoint.v[2] == 1);
+
+	CheckDistance(rect, "rect", 0, 0, 1);
+	CheckDistance(rect, "rect", 1, 0, 0.5f);
+	CheckDistance(rect, "rect", 0, 0.75f, 0.25f);
+	CheckDistance(rect, "rect", 1.5f, 0, 0);
+	CheckDistance(rect, "rect", 2.5f, 0, -1);
+	CheckDistance(rect, "rect", 2.5f, 2, -sqrtf(2)); // Closest to a corner
+
+	// The same rectangle the other way round
+	PlayAreaGeometry reversed(Polygon({ { -1.5f, 1 }, { 1.5f, 1 }, { 1.5f, -1 }, { -1.5f, -1 } }));
+	CheckDistance(reversed, "reversed", 1, 0, 0.5f);
+	CheckDistance(reversed, "reversed", 2.5f, 2, -sqrtf(2));
+
+	// An L shape, with the top-right quarter of a 2x2 square cut out
+	PlayAreaGeometry ell(Polygon({ { 0, 0 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 1, 2 }, { 0, 2 } }));
+	CHECK(ell.maxPoint.v[0] == 2 && ell.maxPoint.v[2] == 2);
+	CheckDistance(ell, "ell", 0.5f, 0.5f, 0.5f);
+	CheckDistance(ell, "ell", 0.9f, 0.9f, sqrtf(0.02f)); // Nearest the inside corner
+	CheckDistance(ell, "ell", 1.5f, 1.5f, -0.5f); // In the cut-out, so outside
+	CheckDistance(ell, "ell", 1.5f, 1.2f, -0.2f);
+
+	// A repeated point makes a zero-length edge, which mustn't break anything
+	PlayAreaGeometry repeated(Polygon({ { -1, -1 }, { 1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } }));
+	CheckDistance(repeated, "repeated", 0, 0, 1);
+	CheckDistance(repeated, "repeated", 1.5f, -1.5f, -sqrtf(0.5f));
+
+	// No play area at all
+	PlayAreaGeometry empty({});
+	CHECK(empty.edges.empty());
+	CheckDistance(empty, "empty", 0, 0, 0);
+
+	return testResult();
+}
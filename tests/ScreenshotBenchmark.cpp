@@ -0,0 +1,127 @@
+#include "OpenVRHarness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Checks that taking screenshots doesn't hold up the game's frames. It takes a stereo screenshot every so often
+// while submitting frames, and compares the frames around each screenshot (where the eyes are copied back and
+// handed to the PNG encoder) with the rest. Ideally they take the same time, since the render thread should only
+// be recording a copy and checking a fence.
+
+using namespace openvr_harness;
+
+struct FrameTimes {
+	const char* name;
+	double totalNs = 0;
+	double maxNs = 0;
+	int frames = 0;
+
+	void Add(double ns)
+	{
+		totalNs += ns;
+		maxNs = std::max(maxNs, ns);
+		frames++;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv))
+		return EXIT_FAILURE;
+
+	int frames = 1000;
+	int interval = 50;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+			interval = std::max(atoi(argv[++i]), 1);
+		} else {
+			fprintf(stderr, "Usage: %s [--runtime mock|system] [--frames count] [--interval frames-between-screenshots]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	TestImage* eyes[2] = {
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff402010),
+		harness.CreateImage(harness.eyeWidth, harness.eyeHeight, nullptr, 0xff102040),
+	};
+	if (!eyes[0] || !eyes[1])
+		return EXIT_FAILURE;
+
+	// Each screenshot overwrites the last
+	std::string previewBase = harness.TempPath("preview");
+	std::string vrBase = harness.TempPath("vr");
+	harness.TempPath("preview.png");
+	harness.TempPath("vr.png");
+
+	// The readback is recorded into the frame after the request, and collected a frame or two after that
+	const int framesPerScreenshot = 3;
+
+	FrameTimes normal{ "normal" };
+	FrameTimes screenshot{ "screenshot" };
+	FrameTimes request{ "request call" };
+	int accepted = 0, requested = 0;
+	int screenshotFramesLeft = 0;
+
+	// The first frames create the session and the compositors, which screenshots need
+	const int warmupFrames = 20;
+
+	for (int frame = -warmupFrames; frame < frames; frame++) {
+		auto start = std::chrono::steady_clock::now();
+
+		vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+		harness.compositor->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
+
+		bool inScreenshot = screenshotFramesLeft > 0;
+		if (frame >= 0 && frame % interval == 0) {
+			auto requestStart = std::chrono::steady_clock::now();
+			vr::ScreenshotHandle_t handle;
+			vr::IVRScreenshots_001::EVRScreenshotError error = harness.screenshots->TakeStereoScreenshot(&handle, previewBase.c_str(), vrBase.c_str());
+			request.Add(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - requestStart).count());
+
+			requested++;
+			if (error == vr::IVRScreenshots_001::VRScreenshotError_None) {
+				accepted++;
+				inScreenshot = true;
+				screenshotFramesLeft = framesPerScreenshot + 1;
+			}
+		}
+
+		for (int eye = 0; eye < 2; eye++) {
+			if (harness.compositor->Submit((vr::EVREye)eye, &eyes[eye]->texture) != vr::IVRCompositor_027::VRCompositorError_None) {
+				fprintf(stderr, "Submit failed\n");
+				return EXIT_FAILURE;
+			}
+		}
+
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		if (frame >= 0)
+			(inScreenshot ? screenshot : normal).Add(ns);
+		if (screenshotFramesLeft > 0)
+			screenshotFramesLeft--;
+	}
+
+	if (accepted == 0) {
+		fprintf(stderr, "No screenshots were taken\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%d frames, %ux%u per eye, %d of %d screenshots taken, %s runtime\n", frames, harness.eyeWidth, harness.eyeHeight, accepted,
+	    requested, harness.usingMock ? "mock" : "system");
+	printf("%-14s %8s %14s %14s\n", "frames", "count", "mean ns", "max ns");
+	for (const FrameTimes* times : { &normal, &screenshot, &request }) {
+		double count = times->frames > 0 ? times->frames : 1;
+		printf("%-14s %8d %14.0f %14.0f\n", times->name, times->frames, times->totalNs / count, times->maxNs);
+	}
+
+	return EXIT_SUCCESS;
+}
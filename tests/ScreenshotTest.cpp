@@ -0,0 +1,176 @@
+#include "OpenVRHarness.h"
+
+#include "Misc/lodepng.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string.h>
+#include <thread>
+
+// Takes a stereo screenshot of a pair of patterned eye images through IVRScreenshots, and checks the preview and
+// side-by-side PNGs that come out match what was submitted. Also checks the screenshot properties and the errors
+// for requests that can't be done.
+
+using namespace openvr_harness;
+
+static const uint32_t EYE_BLUE[2] = { 0x40, 0xc0 };
+
+// A gradient, with each eye told apart by its blue channel
+static uint32_t PatternPixel(int eye, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	uint32_t red = x * 255 / (width - 1);
+	uint32_t green = y * 255 / (height - 1);
+	return 0xff000000 | EYE_BLUE[eye] << 16 | green << 8 | red;
+}
+
+static bool SubmitFrame(OpenVRHarness& harness, TestImage* const* eyes)
+{
+	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+	harness.compositor->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
+
+	for (int eye = 0; eye < 2; eye++) {
+		if (harness.compositor->Submit((vr::EVREye)eye, &eyes[eye]->texture) != vr::IVRCompositor_027::VRCompositorError_None)
+			return false;
+	}
+	return true;
+}
+
+// Returns false if the file isn't there, or is only partly written
+static bool LoadPng(const std::string& path, std::vector<uint8_t>* pixels, uint32_t* width, uint32_t* height)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+	std::vector<uint8_t> png((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	unsigned int w, h;
+	if (lodepng::decode(*pixels, w, h, png, LCT_RGB, 8) != 0)
+		return false;
+	*width = w;
+	*height = h;
+	return true;
+}
+
+// Checks a few points of one eye's pattern in a decoded RGB image, with its left edge at xOffset
+static void CheckEye(const std::vector<uint8_t>& pixels, uint32_t imageWidth, uint32_t xOffset, int eye, uint32_t width, uint32_t height)
+{
+	const uint32_t points[][2] = {
+		{ 0, 0 },
+		{ width - 1, 0 },
+		{ 0, height - 1 },
+		{ width - 1, height - 1 },
+		{ width / 2, height / 3 },
+	};
+
+	for (const auto& point : points) {
+		uint32_t x = point[0], y = point[1];
+		uint32_t expected = PatternPixel(eye, x, y, width, height);
+		const uint8_t* actual = pixels.data() + ((size_t)y * imageWidth + xOffset + x) * 3;
+
+		for (int channel = 0; channel < 3; channel++) {
+			int expectedValue = (int)(expected >> (channel * 8) & 0xff);
+			CHECKF(abs(actual[channel] - expectedValue) <= 2, "eye %d at %u,%u channel %d: expected %d, got %d", eye, x, y, channel,
+			    expectedValue, actual[channel]);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv) || argc != 1) {
+		fprintf(stderr, "Usage: %s [--runtime mock|system]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	uint32_t width = harness.eyeWidth;
+	uint32_t height = harness.eyeHeight;
+
+	TestImage* eyes[2];
+	for (int eye = 0; eye < 2; eye++) {
+		std::vector<uint32_t> pixels((size_t)width * height);
+		for (uint32_t y = 0; y < height; y++) {
+			for (uint32_t x = 0; x < width; x++)
+				pixels[(size_t)y * width + x] = PatternPixel(eye, x, y, width, height);
+		}
+
+		eyes[eye] = harness.CreateImage(width, height, pixels.data(), 0);
+		if (!eyes[eye])
+			return EXIT_FAILURE;
+	}
+
+	// The eye images are only captured once the compositors exist, which is after the first submit
+	for (int i = 0; i < 5; i++)
+		CHECK(SubmitFrame(harness, eyes));
+
+	// Only stereo screenshots can be taken without the app's help
+	vr::ScreenshotHandle_t handle = vr::k_unScreenshotHandleInvalid;
+	std::string previewBase = harness.TempPath("preview");
+	std::string vrBase = harness.TempPath("vr");
+	CHECK(harness.screenshots->RequestScreenshot(&handle, vr::VRScreenshotType_Mono, previewBase.c_str(), vrBase.c_str())
+	    == vr::IVRScreenshots_001::VRScreenshotError_RequestFailed);
+
+	// The PNGs get an extension added, so they need cleaning up too
+	std::string previewPath = harness.TempPath("preview.png");
+	std::string vrPath = harness.TempPath("vr.png");
+
+	CHECK(harness.screenshots->TakeStereoScreenshot(&handle, previewBase.c_str(), vrBase.c_str()) == vr::IVRScreenshots_001::VRScreenshotError_None);
+	CHECK(handle != vr::k_unScreenshotHandleInvalid);
+
+	// A second screenshot can't be started until the first has been read back
+	vr::ScreenshotHandle_t second;
+	CHECK(harness.screenshots->TakeStereoScreenshot(&second, previewBase.c_str(), vrBase.c_str()) == vr::IVRScreenshots_001::VRScreenshotError_RequestFailed);
+
+	vr::IVRScreenshots_001::EVRScreenshotError error;
+	CHECK(harness.screenshots->GetScreenshotPropertyType(handle, &error) == vr::VRScreenshotType_Stereo);
+	CHECK(error == vr::IVRScreenshots_001::VRScreenshotError_None);
+	CHECK(harness.screenshots->GetScreenshotPropertyType(handle + 100, &error) == vr::VRScreenshotType_None);
+	CHECK(error == vr::IVRScreenshots_001::VRScreenshotError_NotFound);
+
+	char filename[4096];
+	uint32_t size = harness.screenshots->GetScreenshotPropertyFilename(handle, vr::VRScreenshotPropertyFilenames_VR, filename, sizeof(filename), &error);
+	CHECK(error == vr::IVRScreenshots_001::VRScreenshotError_None);
+	CHECKF(size == vrPath.size() + 1 && vrPath == filename, "got '%s'", filename);
+	harness.screenshots->GetScreenshotPropertyFilename(handle, vr::VRScreenshotPropertyFilenames_Preview, filename, 4, &error);
+	CHECK(error == vr::IVRScreenshots_001::VRScreenshotError_BufferTooSmall);
+
+	// Keep submitting frames while the images are read back and saved, as a game would
+	std::vector<uint8_t> preview, vrImage;
+	uint32_t previewWidth = 0, previewHeight = 0, vrWidth = 0, vrHeight = 0;
+	bool saved = false;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while (!saved && std::chrono::steady_clock::now() < deadline) {
+		CHECK(SubmitFrame(harness, eyes));
+
+		// The preview is written first
+		saved = LoadPng(vrPath, &vrImage, &vrWidth, &vrHeight) && LoadPng(previewPath, &preview, &previewWidth, &previewHeight);
+		if (!saved)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	CHECK(saved);
+	if (saved) {
+		CHECKF(previewWidth == width && previewHeight == height, "preview is %ux%u", previewWidth, previewHeight);
+		CHECKF(vrWidth == width * 2 && vrHeight == height, "VR image is %ux%u", vrWidth, vrHeight);
+
+		if (previewWidth == width && previewHeight == height)
+			CheckEye(preview, width, 0, 0, width, height);
+
+		if (vrWidth == width * 2 && vrHeight == height) {
+			CheckEye(vrImage, vrWidth, 0, 0, width, height);
+			CheckEye(vrImage, vrWidth, width, 1, width, height);
+		}
+	}
+
+	// With the first one finished, another can be taken
+	CHECK(harness.screenshots->TakeStereoScreenshot(&second, previewBase.c_str(), vrBase.c_str()) == vr::IVRScreenshots_001::VRScreenshotError_None);
+	CHECK(second != handle);
+
+	return testResult();
+}
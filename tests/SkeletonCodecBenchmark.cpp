@@ -0,0 +1,79 @@
+#include "stdafx.h"
+
+#include "HandPoses.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+// Times encoding and decoding a hand, for a few different kinds of pose
+
+using namespace hand_poses;
+
+struct PoseKind {
+	const char* name;
+	float curl;
+	float rotationNoise;
+	float positionNoise;
+};
+
+static const PoseKind poseKinds[] = {
+	{ "open hand", 0, 0, 0 },
+	{ "fist", 1, 0, 0 },
+	{ "controller", 0.5f, 0.01f, 0 },
+	{ "hand tracking", 0.5f, 0.05f, 0.002f },
+};
+
+int main(int argc, char** argv)
+{
+	const int poseCount = 256;
+	const int iterations = argc > 1 ? atoi(argv[1]) : 200;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> scale(0.85f, 1.15f);
+
+	printf("%-16s %8s %12s %12s\n", "pose", "bytes", "encode ns", "decode ns");
+
+	for (const PoseKind& kind : poseKinds) {
+		std::vector<vr::VRBoneTransform_t> poses(poseCount * BONE_COUNT);
+		for (int i = 0; i < poseCount; i++)
+			MakePose(rng, i & 1, kind.curl, scale(rng), kind.rotationNoise, kind.positionNoise, true, &poses[i * BONE_COUNT]);
+
+		std::vector<uint8_t> encoded(poseCount * skeleton_codec::MAX_ENCODED_SIZE);
+		std::vector<uint32_t> sizes(poseCount);
+		uint64_t totalSize = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (int iteration = 0; iteration < iterations; iteration++) {
+			for (int i = 0; i < poseCount; i++)
+				sizes[i] = skeleton_codec::Encode(&poses[i * BONE_COUNT], i & 1, false, &encoded[i * skeleton_codec::MAX_ENCODED_SIZE]);
+		}
+		auto encodeEnd = std::chrono::steady_clock::now();
+
+		vr::VRBoneTransform_t decoded[BONE_COUNT];
+		uint32_t checksum = 0;
+		for (int iteration = 0; iteration < iterations; iteration++) {
+			for (int i = 0; i < poseCount; i++) {
+				skeleton_codec::Decode(&encoded[i * skeleton_codec::MAX_ENCODED_SIZE], sizes[i], decoded, nullptr);
+				uint32_t bits;
+				memcpy(&bits, &decoded[i % BONE_COUNT].position.v[0], sizeof(bits));
+				checksum += bits;
+			}
+		}
+		auto decodeEnd = std::chrono::steady_clock::now();
+
+		for (uint32_t size : sizes)
+			totalSize += size;
+
+		double calls = (double)iterations * poseCount;
+		double encodeNs = std::chrono::duration<double, std::nano>(encodeEnd - start).count() / calls;
+		double decodeNs = std::chrono::duration<double, std::nano>(decodeEnd - encodeEnd).count() / calls;
+		printf("%-16s %8.1f %12.1f %12.1f\n", kind.name, (double)totalSize / poseCount, encodeNs, decodeNs);
+
+		// Stop the decoding being optimised out
+		if (checksum == 0x12345678)
+			printf("\n");
+	}
+
+	return 0;
+}
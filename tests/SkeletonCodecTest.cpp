@@ -0,0 +1,281 @@
+#include "stdafx.h"
+
+#include "HandPoses.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Checks the skeleton codec decodes every bone to within the error its quantisation allows, and that its output
+// stays compact and within MAX_ENCODED_SIZE.
+
+using namespace hand_poses;
+using skeleton_codec::MAX_ENCODED_SIZE;
+
+// The worst-case errors, from each kind of bone's quantisation step (see SkeletonCodec.cpp)
+static const float FINGER_ROTATION_ERROR = 0.5f; // Degrees
+static const float FINGER_POSITION_ERROR = 0.001f; // Metres
+static const float WIDE_ROTATION_ERROR = 0.2f;
+static const float WIDE_POSITION_ERROR = 0.0001f;
+
+// The aux bones are rebuilt from all the bones above them, so they pick up all of their errors
+static const float DERIVED_ROTATION_ERROR = 2.5f;
+static const float DERIVED_POSITION_ERROR = 0.005f;
+
+static bool isFingerBone(int bone)
+{
+	return bone >= 2 && bone < 26;
+}
+
+static uint32_t roundTrip(const vr::VRBoneTransform_t* bones, bool isRight, vr::VRBoneTransform_t* decoded)
+{
+	uint8_t buffer[MAX_ENCODED_SIZE];
+	uint32_t size = skeleton_codec::Encode(bones, isRight, false, buffer);
+	CHECKF(size <= MAX_ENCODED_SIZE, "%d bytes", (int)size);
+
+	bool modelSpace = true;
+	CHECK(skeleton_codec::Decode(buffer, size, decoded, &modelSpace));
+	CHECK(!modelSpace);
+	return size;
+}
+
+static void checkErrors(const vr::VRBoneTransform_t* bones, const vr::VRBoneTransform_t* decoded, bool auxDerived)
+{
+	for (int i = 0; i < 26; i++) {
+		float rotationError = AngleBetween(bones[i].orientation, decoded[i].orientation);
+		float positionError = DistanceBetween(bones[i].position, decoded[i].position);
+		float maxRotation = isFingerBone(i) ? FINGER_ROTATION_ERROR : WIDE_ROTATION_ERROR;
+		float maxPosition = isFingerBone(i) ? FINGER_POSITION_ERROR : WIDE_POSITION_ERROR;
+		CHECKF(rotationError <= maxRotation, "bone %d is %f degrees out", i, rotationError);
+		CHECKF(positionError <= maxPosition, "bone %d is %fmm out", i, positionError * 1000);
+	}
+
+	for (int i = 26; i < (int)BONE_COUNT; i++) {
+		float rotationError = AngleBetween(bones[i].orientation, decoded[i].orientation);
+		float positionError = DistanceBetween(bones[i].position, decoded[i].position);
+		float maxRotation = auxDerived ? DERIVED_ROTATION_ERROR : WIDE_ROTATION_ERROR;
+		float maxPosition = auxDerived ? DERIVED_POSITION_ERROR : WIDE_POSITION_ERROR;
+		CHECKF(rotationError <= maxRotation, "aux bone %d is %f degrees out", i, rotationError);
+		CHECKF(positionError <= maxPosition, "aux bone %d is %fmm out", i, positionError * 1000);
+	}
+}
+
+static void testReferencePose()
+{
+	for (bool isRight : { false, true }) {
+		vr::VRBoneTransform_t bones[BONE_COUNT], decoded[BONE_COUNT];
+		skeleton_codec::GetReferencePose(isRight, bones);
+
+		// Just the header, and a couple of bits per bone
+		uint32_t size = roundTrip(bones, isRight, decoded);
+		CHECKF(size <= 16, "%d bytes", (int)size);
+		checkErrors(bones, decoded, true);
+	}
+}
+
+// Each of these is a kind of pose that apps send, and how big it may encode to on average
+struct PoseKind {
+	const char* name;
+	float curl;
+	float rotationNoise; // Radians
+	float positionNoise; // Metres
+	bool wristNoise;
+	float maxAverageSize;
+};
+
+static const PoseKind poseKinds[] = {
+	{ "open hand", 0, 0, 0, true, 48 },
+	{ "fist", 1, 0, 0, true, 64 },
+	{ "controller", 0.5f, 0.01f, 0, true, 64 },
+	{ "hand tracking", 0.5f, 0.05f, 0.002f, true, 110 },
+};
+
+static void testPoses()
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> scale(0.85f, 1.15f);
+	std::uniform_real_distribution<float> curl(-0.2f, 0.2f);
+
+	for (const PoseKind& kind : poseKinds) {
+		uint64_t totalSize = 0;
+		const int count = 1000;
+
+		for (int i = 0; i < count; i++) {
+			bool isRight = (i & 1) != 0;
+			vr::VRBoneTransform_t bones[BONE_COUNT], decoded[BONE_COUNT];
+			MakePose(rng, isRight, kind.curl + curl(rng), scale(rng), kind.rotationNoise, kind.positionNoise, kind.wristNoise, bones);
+
+			totalSize += roundTrip(bones, isRight, decoded);
+			checkErrors(bones, decoded, true);
+		}
+
+		float averageSize = (float)totalSize / count;
+		printf("%s: %.1f bytes\n", kind.name, averageSize);
+		CHECKF(averageSize <= kind.maxAverageSize, "%s poses average %.1f bytes", kind.name, averageSize);
+	}
+}
+
+// When the aux bones don't match the distal bones, they have to be sent in full
+static void testIndependentAuxBones()
+{
+	std::mt19937 rng(5678);
+	std::uniform_real_distribution<float> position(-0.3f, 0.3f);
+
+	for (int i = 0; i < 100; i++) {
+		vr::VRBoneTransform_t bones[BONE_COUNT], decoded[BONE_COUNT];
+		MakePose(rng, false, 0.5f, 1, 0.05f, 0.002f, true, bones);
+		for (int bone = 26; bone < (int)BONE_COUNT; bone++) {
+			bones[bone].orientation = RandomRotation(rng, (float)M_PI);
+			bones[bone].position = vr::HmdVector4_t{ position(rng), position(rng), position(rng), 1 };
+		}
+
+		roundTrip(bones, false, decoded);
+		checkErrors(bones, decoded, false);
+	}
+}
+
+// Bones that are zeroed out are missing, and must come back zeroed out
+static void testMissingBones()
+{
+	std::mt19937 rng(42);
+	const uint32_t masks[] = { 0, 1u << 1, 0x03ffffff, 0x7c000000, 0x55555555, 0x2aaaaaaa };
+
+	for (uint32_t missing : masks) {
+		vr::VRBoneTransform_t bones[BONE_COUNT], decoded[BONE_COUNT];
+		MakePose(rng, true, 0.3f, 1.05f, 0.02f, 0.001f, true, bones);
+		for (uint32_t i = 0; i < BONE_COUNT; i++) {
+			if (missing & (1u << i))
+				memset(&bones[i], 0, sizeof(bones[i]));
+		}
+
+		roundTrip(bones, true, decoded);
+
+		// With every bone present, the aux bones are rebuilt from the others
+		if (missing == 0) {
+			checkErrors(bones, decoded, true);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < BONE_COUNT; i++) {
+			const vr::VRBoneTransform_t& bone = decoded[i];
+			bool zero = bone.orientation.w == 0 && bone.orientation.x == 0 && bone.orientation.y == 0 && bone.orientation.z == 0;
+			CHECKF(zero == ((missing & (1u << i)) != 0), "bone %d with mask %x", (int)i, missing);
+			if (zero)
+				continue;
+
+			bool finger = isFingerBone((int)i);
+			CHECKF(AngleBetween(bones[i].orientation, bone.orientation) <= (finger ? FINGER_ROTATION_ERROR : WIDE_ROTATION_ERROR),
+			    "bone %d with mask %x", (int)i, missing);
+			CHECKF(DistanceBetween(bones[i].position, bone.position) <= (finger ? FINGER_POSITION_ERROR : WIDE_POSITION_ERROR),
+			    "bone %d with mask %x", (int)i, missing);
+		}
+	}
+}
+
+// Poses that are as far as possible from the reference must still fit in MAX_ENCODED_SIZE
+static void testWorstCase()
+{
+	std::mt19937 rng(999);
+	std::uniform_real_distribution<float> position(-10, 10);
+	std::uniform_int_distribution<int> sign(0, 1);
+
+	uint32_t largest = 0;
+	for (int i = 0; i < 10000; i++) {
+		vr::VRBoneTransform_t bones[BONE_COUNT];
+		for (uint32_t bone = 0; bone < BONE_COUNT; bone++) {
+			bones[bone].orientation = RandomRotation(rng, (float)M_PI);
+
+			// Alternate which bones are huge, so the hand scale can't fit them
+			for (int axis = 0; axis < 3; axis++)
+				bones[bone].position.v[axis] = (i & 1) && sign(rng) ? (sign(rng) ? 1000.f : -1000.f) : position(rng);
+			bones[bone].position.v[3] = 1;
+		}
+
+		// Leave a single bone out now and then, so the mask is included
+		if (i % 3 == 0)
+			memset(&bones[i % BONE_COUNT], 0, sizeof(bones[0]));
+
+		uint8_t buffer[MAX_ENCODED_SIZE + 64];
+		memset(buffer, 0xcd, sizeof(buffer));
+		uint32_t size = skeleton_codec::Encode(bones, false, true, buffer);
+		largest = std::max(largest, size);
+		CHECKF(size <= MAX_ENCODED_SIZE, "%d bytes", (int)size);
+		CHECK(buffer[MAX_ENCODED_SIZE] == 0xcd);
+
+		vr::VRBoneTransform_t decoded[BONE_COUNT];
+		CHECK(skeleton_codec::Decode(buffer, size, decoded, nullptr));
+	}
+
+	printf("Largest encoding: %d bytes\n", (int)largest);
+}
+
+// Decoding a cut-off or corrupt buffer must fail cleanly
+static void testInvalidData()
+{
+	std::mt19937 rng(7);
+	vr::VRBoneTransform_t bones[BONE_COUNT], decoded[BONE_COUNT];
+	MakePose(rng, false, 0.5f, 1, 0.05f, 0.002f, true, bones);
+
+	uint8_t buffer[MAX_ENCODED_SIZE];
+	uint32_t size = skeleton_codec::Encode(bones, false, false, buffer);
+	for (uint32_t length = 0; length < size; length++)
+		CHECKF(!skeleton_codec::Decode(buffer, length, decoded, nullptr), "%d of %d bytes", (int)length, (int)size);
+
+	buffer[0] = 1; // An older version
+	CHECK(!skeleton_codec::Decode(buffer, size, decoded, nullptr));
+
+	// Random data mostly fails, but it mustn't crash
+	std::uniform_int_distribution<int> byte(0, 255);
+	for (int i = 0; i < 10000; i++) {
+		uint8_t noise[MAX_ENCODED_SIZE];
+		for (uint8_t& value : noise)
+			value = (uint8_t)byte(rng);
+		noise[0] = 2;
+		skeleton_codec::Decode(noise, 1 + i % MAX_ENCODED_SIZE, decoded, nullptr);
+	}
+}
+
+// Every player must decode exactly the same hand, so this checks the decoded bits against those from a reference
+// build. If this fails on a new platform or compiler, look for fused multiply-adds or a different sqrt.
+// clang-format off
+static const uint8_t goldenEncoding[] = {
+	0x02, 0x0d, 0x14, 0x33, 0xda, 0x1a, 0x79, 0x37, 0xc7, 0x10, 0xc2, 0x5f, 0x33, 0x41, 0x38, 0x93,
+	0x30, 0x19, 0x70, 0xca, 0xc9, 0x80, 0x51, 0x84, 0x31, 0x51, 0x8e, 0xc8, 0x34, 0x27, 0x62, 0x42,
+	0x01, 0x8f, 0x64, 0x27, 0x80, 0x59, 0x5e, 0x01, 0xa7, 0xdc, 0x18, 0x4a, 0x31, 0x4f, 0x08, 0x13,
+	0x61, 0x0c, 0x38, 0x45, 0xc4, 0x72, 0xc0, 0x27, 0x36, 0x02, 0x01, 0xf8, 0xc4, 0x18, 0x43, 0x10,
+	0x8a, 0xc9, 0xc6, 0x70, 0x32, 0x31, 0x01, 0x4c, 0x92, 0x17, 0x60, 0x15, 0x71, 0x0b, 0x70, 0x8a,
+	0x98, 0x98, 0x10, 0x4c, 0xa6, 0xac, 0x12, 0xa1, 0x80, 0x4b, 0xcc, 0x04, 0x43, 0x00, 0x9b, 0xc4,
+	0x44, 0x18, 0xe0, 0x95, 0x47, 0x11, 0x86, 0x15,
+};
+// clang-format on
+static const uint64_t GOLDEN_HASH = 0x76aab2f7af02d00c;
+
+static uint64_t hashBones(const vr::VRBoneTransform_t* bones)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325;
+	const uint8_t* data = (const uint8_t*)bones;
+	for (size_t i = 0; i < sizeof(vr::VRBoneTransform_t) * BONE_COUNT; i++)
+		hash = (hash ^ data[i]) * 0x100000001b3;
+	return hash;
+}
+
+static void testBitExact()
+{
+	vr::VRBoneTransform_t decoded[BONE_COUNT];
+	CHECK(skeleton_codec::Decode(goldenEncoding, sizeof(goldenEncoding), decoded, nullptr));
+	uint64_t hash = hashBones(decoded);
+	CHECKF(hash == GOLDEN_HASH, "got %016llx", (unsigned long long)hash);
+}
+
+int main()
+{
+	testReferencePose();
+	testPoses();
+	testIndependentAuxBones();
+	testMissingBones();
+	testWorstCase();
+	testInvalidData();
+	testBitExact();
+	return testResult();
+}
@@ -0,0 +1,223 @@
+#include "OpenVRHarness.h"
+
+#include "MockRuntime/MockRuntime.h"
+#include "TestUtil.h"
+
+#include <GL/gl.h>
+#include <openxr/openxr.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string.h>
+
+// Submits patterned Vulkan eye images through each of the ways VkCompositor can get them into a swapchain - a
+// plain copy, a reinterpreting copy, a flipping blit, a flip through the scratch image and a converting blit -
+// and reads what reached the mock runtime back, to check it against the image the test expects pixel for pixel.
+// The test images are 8-bit and every path copies them one-to-one, so nothing should be off even by one.
+//
+// With '--api gl' it does the same with OpenGL textures, through GLCompositor's copy and its flipping and
+// converting blits.
+
+using namespace openvr_harness;
+
+static const uint32_t WIDTH = 256;
+static const uint32_t HEIGHT = 192;
+static const uint32_t EYE_BLUE[2] = { 0x40, 0xc0 };
+
+// Every pixel in an eye's image is different, so a flip or an offset can't go unnoticed
+static uint32_t PatternPixel(int eye, uint32_t x, uint32_t y)
+{
+	return 0xff000000 | EYE_BLUE[eye] << 16 | y << 8 | x;
+}
+
+struct GoldenCase {
+	const char* name;
+	int64_t format; // A VkFormat or an OpenGL internal format
+	vr::EColorSpace colourSpace;
+	bool hasBounds;
+	vr::VRTextureBounds_t bounds;
+};
+
+static const GoldenCase VULKAN_CASES[] = {
+	{ "copy", VK_FORMAT_R8G8B8A8_SRGB, vr::ColorSpace_Auto, false, {} },
+	{ "crop", VK_FORMAT_R8G8B8A8_SRGB, vr::ColorSpace_Auto, true, { 0.25f, 0.25f, 0.75f, 0.75f } },
+	{ "flip", VK_FORMAT_R8G8B8A8_SRGB, vr::ColorSpace_Auto, true, { 0, 1, 1, 0 } },
+	{ "flip and crop", VK_FORMAT_R8G8B8A8_SRGB, vr::ColorSpace_Auto, true, { 0.25f, 0.75f, 0.5f, 0.25f } },
+
+	// Gamma-encoded data in a UNORM image goes into an sRGB swapchain, so it's copied as the swapchain's format
+	{ "reinterpret", VK_FORMAT_R8G8B8A8_UNORM, vr::ColorSpace_Gamma, false, {} },
+	{ "reinterpret and flip", VK_FORMAT_R8G8B8A8_UNORM, vr::ColorSpace_Gamma, true, { 0, 1, 1, 0 } },
+
+	// The mock runtime doesn't offer this format, so it's blitted into an R8G8B8A8_SRGB or B8G8R8A8_SRGB swapchain
+	{ "convert", VK_FORMAT_A8B8G8R8_SRGB_PACK32, vr::ColorSpace_Auto, false, {} },
+	{ "convert and flip", VK_FORMAT_A8B8G8R8_SRGB_PACK32, vr::ColorSpace_Auto, true, { 0, 1, 1, 0 } },
+};
+
+static const GoldenCase GL_CASES[] = {
+	{ "copy", GL_SRGB8_ALPHA8, vr::ColorSpace_Auto, false, {} },
+	{ "crop", GL_SRGB8_ALPHA8, vr::ColorSpace_Auto, true, { 0.25f, 0.25f, 0.75f, 0.75f } },
+	{ "flip", GL_SRGB8_ALPHA8, vr::ColorSpace_Auto, true, { 0, 1, 1, 0 } },
+	{ "flip and crop", GL_SRGB8_ALPHA8, vr::ColorSpace_Auto, true, { 0.25f, 0.75f, 0.5f, 0.25f } },
+
+	// Gamma-encoded data in an RGBA8 texture goes into an sRGB swapchain, so it's copied, or blitted without being
+	// encoded again
+	{ "reinterpret", GL_RGBA8, vr::ColorSpace_Gamma, false, {} },
+	{ "reinterpret and flip", GL_RGBA8, vr::ColorSpace_Gamma, true, { 0, 1, 1, 0 } },
+
+	// The mock runtime doesn't offer this format, so it's blitted into a GL_SRGB8_ALPHA8 swapchain
+	{ "convert", GL_SRGB8, vr::ColorSpace_Auto, false, {} },
+	{ "convert and flip", GL_SRGB8, vr::ColorSpace_Auto, true, { 0, 1, 1, 0 } },
+};
+
+static bool SubmitFrame(OpenVRHarness& harness, TestImage* const* eyes, const GoldenCase& test)
+{
+	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+	harness.compositor->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
+
+	for (int eye = 0; eye < 2; eye++) {
+		const vr::VRTextureBounds_t* bounds = test.hasBounds ? &test.bounds : nullptr;
+		if (harness.compositor->Submit((vr::EVREye)eye, &eyes[eye]->texture, bounds) != vr::IVRCompositor_027::VRCompositorError_None)
+			return false;
+	}
+	return true;
+}
+
+// Checks one eye of the last frame the mock runtime got. For Vulkan, its viewport should be the bounds (mirrored
+// if they were flipped, since the image is flipped back in the swapchain), and the whole swapchain image should be
+// the submitted image, flipped back if need be. OpenGL swapchains are cropped to the bounds instead, so the
+// viewport should be the whole swapchain, and the image just the part inside the bounds.
+static void CheckEye(const GoldenCase& test, bool gl, const OCMockXrLayer& layer, int eye)
+{
+	const vr::VRTextureBounds_t& bounds = test.bounds;
+	bool flipped = test.hasBounds && bounds.vMin > bounds.vMax;
+
+	// The part of the submitted image that ends up in the swapchain
+	int32_t source[4] = { 0, 0, (int32_t)WIDTH, (int32_t)HEIGHT };
+	int32_t expectedRect[4] = { 0, 0, (int32_t)WIDTH, (int32_t)HEIGHT };
+	if (test.hasBounds && gl) {
+		float vMin = std::min(bounds.vMin, bounds.vMax);
+		float vMax = std::max(bounds.vMin, bounds.vMax);
+		source[0] = (int32_t)(bounds.uMin * WIDTH);
+		source[1] = (int32_t)(vMin * HEIGHT);
+		source[2] = (int32_t)((bounds.uMax - bounds.uMin) * WIDTH);
+		source[3] = (int32_t)((vMax - vMin) * HEIGHT);
+		expectedRect[2] = source[2];
+		expectedRect[3] = source[3];
+	} else if (test.hasBounds) {
+		float vMin = flipped ? 1 - bounds.vMin : bounds.vMin;
+		float vMax = flipped ? 1 - bounds.vMax : bounds.vMax;
+		expectedRect[0] = (int32_t)(bounds.uMin * WIDTH);
+		expectedRect[1] = (int32_t)(vMin * HEIGHT);
+		expectedRect[2] = (int32_t)((bounds.uMax - bounds.uMin) * WIDTH);
+		expectedRect[3] = (int32_t)((vMax - vMin) * HEIGHT);
+	}
+	const int32_t* rect = layer.rects[eye];
+	CHECKF(memcmp(rect, expectedRect, sizeof(expectedRect)) == 0, "%s: eye %d's rect is %d,%d %dx%d, expected %d,%d %dx%d", test.name, eye,
+	    rect[0], rect[1], rect[2], rect[3], expectedRect[0], expectedRect[1], expectedRect[2], expectedRect[3]);
+
+	OCMockXrSwapchainInfo info;
+	if (!OCMockXr_GetSwapchainInfo(layer.swapchains[eye], &info)) {
+		CHECKF(false, "%s: eye %d's swapchain isn't known to the mock runtime", test.name, eye);
+		return;
+	}
+	uint32_t width = (uint32_t)source[2];
+	uint32_t height = (uint32_t)source[3];
+	CHECKF(info.width == width && info.height == height, "%s: eye %d's swapchain is %ux%u, expected %ux%u", test.name, eye, info.width,
+	    info.height, width, height);
+
+	// Only the sRGB swapchains are expected, as the test images are all sRGB (or meant to be read as sRGB)
+	bool bgra = !gl && info.format == VK_FORMAT_B8G8R8A8_SRGB;
+	bool srgb = gl ? info.format == GL_SRGB8_ALPHA8 : info.format == VK_FORMAT_R8G8B8A8_SRGB || bgra;
+	if (!srgb) {
+		CHECKF(false, "%s: eye %d's swapchain has format %d", test.name, eye, (int)info.format);
+		return;
+	}
+
+	std::vector<uint32_t> pixels((size_t)width * height);
+	if (info.width != width || info.height != height
+	    || !OCMockXr_ReadSwapchainImage(layer.swapchains[eye], layer.images[eye], layer.arrayIndices[eye], pixels.data(), pixels.size() * 4)) {
+		CHECKF(false, "%s: couldn't read eye %d's swapchain image", test.name, eye);
+		return;
+	}
+
+	int wrong = 0;
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			uint32_t sourceY = source[1] + (flipped ? height - 1 - y : y);
+			uint32_t expected = PatternPixel(eye, source[0] + x, sourceY);
+			if (bgra)
+				expected = (expected & 0xff00ff00) | (expected >> 16 & 0xff) | (expected & 0xff) << 16;
+
+			// Only the first wrong pixel is printed, the rest are just counted
+			uint32_t actual = pixels[(size_t)y * width + x];
+			if (actual != expected && wrong++ == 0)
+				fprintf(stderr, "%s: eye %d at %u,%u is %08x, expected %08x\n", test.name, eye, x, y, actual, expected);
+		}
+	}
+	CHECKF(wrong == 0, "%s: %d of eye %d's pixels are wrong", test.name, wrong, eye);
+}
+
+int main(int argc, char** argv)
+{
+	OpenVRHarness harness;
+	if (!harness.ParseArgs(argc, argv) || argc != 1) {
+		fprintf(stderr, "Usage: %s [--runtime mock] [--api vulkan|gl]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// The swapchains can only be read back through the mock runtime
+	if (!harness.usingMock) {
+		fprintf(stderr, "This test only runs against the mock runtime\n");
+		return EXIT_FAILURE;
+	}
+
+	int exitCode;
+	if (!harness.Init(&exitCode))
+		return exitCode;
+
+	bool gl = harness.api == GraphicsApi::OpenGL;
+	const GoldenCase* begin = gl ? std::begin(GL_CASES) : std::begin(VULKAN_CASES);
+	const GoldenCase* end = gl ? std::end(GL_CASES) : std::end(VULKAN_CASES);
+
+	std::vector<uint32_t> pattern((size_t)WIDTH * HEIGHT);
+
+	for (const GoldenCase* it = begin; it != end; it++) {
+		const GoldenCase& test = *it;
+		TestImage* eyes[2];
+		for (int eye = 0; eye < 2; eye++) {
+			for (uint32_t y = 0; y < HEIGHT; y++) {
+				for (uint32_t x = 0; x < WIDTH; x++)
+					pattern[(size_t)y * WIDTH + x] = PatternPixel(eye, x, y);
+			}
+
+			eyes[eye] = harness.CreateImage(WIDTH, HEIGHT, pattern.data(), 0, test.format);
+			if (!eyes[eye])
+				return EXIT_FAILURE;
+			eyes[eye]->texture.eColorSpace = test.colourSpace;
+		}
+
+		// The first frames start the session, and changing format means the swapchains get recreated, so give
+		// it a few frames before looking at what came out
+		uint64_t startFrames = OCMockXr_GetFrameCount();
+		bool submitted = true;
+		for (int i = 0; i < 5 && submitted; i++)
+			submitted = SubmitFrame(harness, eyes, test);
+		CHECKF(submitted, "%s: submit failed", test.name);
+		if (!submitted || OCMockXr_GetFrameCount() == startFrames) {
+			CHECKF(false, "%s: no frames reached the runtime", test.name);
+			continue;
+		}
+
+		OCMockXrLayer layers[2];
+		uint32_t layerCount = OCMockXr_GetLastFrameLayers(layers, 2);
+		if (layerCount != 1 || layers[0].type != XR_TYPE_COMPOSITION_LAYER_PROJECTION || layers[0].viewCount != 2) {
+			CHECKF(false, "%s: expected just the projection layer, got %u layers", test.name, layerCount);
+			continue;
+		}
+
+		for (int eye = 0; eye < 2; eye++)
+			CheckEye(test, gl, layers[0], eye);
+	}
+
+	return testResult();
+}
@@ -0,0 +1,21 @@
+#include "stdafx.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// The tests don't have OpenComposite's log file, so whatever the code under test logs goes to stderr
+
+void oovr_log_raw(const char* file, long line, const char* func, const char* msg)
+{
+	fprintf(stderr, "%s:%ld (%s): %s\n", file, line, func, msg);
+}
+
+void oovr_log_raw_format(const char* file, long line, const char* func, const char* msg, ...)
+{
+	va_list args;
+	va_start(args, msg);
+	fprintf(stderr, "%s:%ld (%s): ", file, line, func);
+	vfprintf(stderr, msg, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
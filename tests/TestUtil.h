@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal checks for the test executables, which only need to report what failed and exit non-zero
+
+static int testFailures = 0;
+
+#define CHECK(condition)                                                                   \
+	do {                                                                                   \
+		if (!(condition)) {                                                                \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			testFailures++;                                                                \
+		}                                                                                  \
+	} while (0)
+
+#define CHECKF(condition, fmt, ...)                                                                            \
+	do {                                                                                                       \
+		if (!(condition)) {                                                                                    \
+			fprintf(stderr, "%s:%d: check failed: %s (" fmt ")\n", __FILE__, __LINE__, #condition, __VA_ARGS__); \
+			testFailures++;                                                                                    \
+		}                                                                                                      \
+	} while (0)
+
+static int testResult()
+{
+	if (testFailures)
+		fprintf(stderr, "%d checks failed\n", testFailures);
+	else
+		printf("All checks passed\n");
+	return testFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Stands in for OpenOVR/stdafx.h in the tests. They only build the parts of OpenComposite that don't depend on
+// OpenXR or the rest of the runtime, so this just pulls in the OpenVR types and the logging macros. Tests that
+// build code which logs link tests/TestLogging.cpp, which prints to stderr.
+
+#include "custom_types.h"
+#include "logging.h"
+#include "generated/interfaces/vrannotation.h"
+#include "generated/interfaces/vrtypes.h"
+
+#ifdef _WIN32
+#define _USE_MATH_DEFINES
+#endif
+
+#include <string>
+#include <vector>